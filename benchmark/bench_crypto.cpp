@@ -48,6 +48,29 @@ class SHA1Bench : public td::Benchmark {
   }
 };
 
+class SHA256Bench : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[DATA_SIZE];
+
+  std::string get_description() const override {
+    return PSTRING() << "SHA256 OpenSSL [" << (DATA_SIZE >> 10) << "kB]";
+  }
+
+  void start_up() override {
+    for (int i = 0; i < DATA_SIZE; i++) {
+      data[i] = 123;
+      data[i] = 0;
+    }
+  }
+
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      unsigned char md[32];
+      SHA256(data, DATA_SIZE, md);
+    }
+  }
+};
+
 class AESBench : public td::Benchmark {
  public:
   alignas(64) unsigned char data[DATA_SIZE];
@@ -74,6 +97,34 @@ class AESBench : public td::Benchmark {
   }
 };
 
+class AESCtrBench : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[DATA_SIZE];
+  td::UInt256 key;
+  td::UInt128 iv;
+
+  std::string get_description() const override {
+    return PSTRING() << "AES-CTR OpenSSL [" << (DATA_SIZE >> 10) << "kB]";
+  }
+
+  void start_up() override {
+    for (int i = 0; i < DATA_SIZE; i++) {
+      data[i] = 123;
+    }
+    td::Random::secure_bytes(key.raw, sizeof(key));
+    td::Random::secure_bytes(iv.raw, sizeof(iv));
+  }
+
+  void run(int n) override {
+    td::AesCtrState state;
+    state.init(key, iv);
+    td::MutableSlice data_slice(data, DATA_SIZE);
+    for (int i = 0; i < n; i++) {
+      state.encrypt(data_slice, data_slice);
+    }
+  }
+};
+
 BENCH(Rand, "std_rand") {
   int res = 0;
   for (int i = 0; i < n; i++) {
@@ -206,7 +257,9 @@ int main() {
 #endif
   td::bench(SslRandBufBench());
   td::bench(SHA1Bench());
+  td::bench(SHA256Bench());
   td::bench(AESBench());
+  td::bench(AESCtrBench());
   td::bench(Crc32Bench());
   td::bench(Crc64Bench());
   return 0;
@@ -13,9 +13,11 @@
 // TODO: check system calls
 // TODO: all return values must be checked
 
+#include <array>
 #include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <vector>
 
 #include <pthread.h>
@@ -899,8 +901,226 @@ class RingBenchmark : public td::Benchmark {
   }
 };
 
+static td::uint64 now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<td::uint64>(ts.tv_sec) * 1000000000 + static_cast<td::uint64>(ts.tv_nsec);
+}
+
+// HDR-style histogram: 16 linear sub-buckets per power of two give ~6% relative
+// precision, so percentiles can be extracted without storing every sample
+class LatencyHistogram {
+ public:
+  void record(td::uint64 ns) {
+    buckets_[bucket_index(ns)]++;
+    count_++;
+    if (ns > max_) {
+      max_ = ns;
+    }
+  }
+
+  td::uint64 quantile(double q) const {
+    auto target = static_cast<td::uint64>(q * static_cast<double>(count_));
+    td::uint64 sum = 0;
+    for (std::size_t i = 0; i < buckets_.size(); i++) {
+      sum += buckets_[i];
+      if (sum > target) {
+        return bucket_value(i);
+      }
+    }
+    return max_;
+  }
+
+  td::uint64 count() const {
+    return count_;
+  }
+  td::uint64 max() const {
+    return max_;
+  }
+
+ private:
+  static constexpr std::size_t SUB_BUCKET_BITS = 5;
+  static constexpr std::size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+  static constexpr std::size_t HALF = SUB_BUCKET_COUNT / 2;
+  static constexpr std::size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * HALF;
+
+  std::array<td::uint64, BUCKET_COUNT> buckets_{};
+  td::uint64 count_ = 0;
+  td::uint64 max_ = 0;
+
+  static std::size_t bucket_index(td::uint64 ns) {
+    if (ns < SUB_BUCKET_COUNT) {
+      return static_cast<std::size_t>(ns);
+    }
+    auto top = static_cast<std::size_t>(63 - __builtin_clzll(ns));
+    auto group = top - (SUB_BUCKET_BITS - 1);
+    return group * HALF + static_cast<std::size_t>(ns >> group);
+  }
+
+  static td::uint64 bucket_value(std::size_t i) {
+    if (i < SUB_BUCKET_COUNT) {
+      return i;
+    }
+    auto group = i / HALF - 1;
+    auto sub = i - group * HALF;
+    // the middle of the bucket
+    return (static_cast<td::uint64>(sub) << group) + (static_cast<td::uint64>(1) << (group - 1));
+  }
+};
+
+static void set_thread_affinity(pthread_t thread, int cpu_id) {
+#if TD_LINUX
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu_id, &cpuset);
+  pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
+#else
+  (void)thread;
+  (void)cpu_id;
+#endif
+}
+
+// Measures put-to-get latency of a queue under contention: producers_n pinned
+// producer threads push timestamped values into one queue drained by a single
+// pinned consumer, with a bounded number of in-flight values per producer.
+// The consumer records every latency in a histogram and reports percentiles
+// in a machine-readable form, so runs can be diffed across commits.
+template <class ServerQueueT>
+class QueueContentionBenchmark {
+  static constexpr int MAX_IN_FLIGHT = 16;
+  static constexpr td::uint64 TIMESTAMP_MASK = (static_cast<td::uint64>(1) << 56) - 1;
+
+  struct Producer {
+    QueueContentionBenchmark *bench;
+    int id;
+    pthread_t thread;
+    td::PollQueue<td::uint64> replies;
+    char pad[64];
+  };
+
+  const char *queue_name_;
+  int producers_n_;
+  int queries_per_producer_;
+  ServerQueueT server_;
+  std::vector<Producer> producers_;
+  LatencyHistogram histogram_;
+  td::uint64 base_ns_ = 0;
+
+  void producer_run(Producer *producer) {
+    int in_flight = 0;
+    for (int i = 0; i < queries_per_producer_; i++) {
+      if (in_flight == MAX_IN_FLIGHT) {
+        int cnt = producer->replies.reader_wait();
+        while (cnt-- > 0) {
+          producer->replies.reader_get_unsafe();
+          producer->replies.reader_flush();
+          in_flight--;
+        }
+      }
+      auto value = (static_cast<td::uint64>(producer->id) << 56) | ((now_ns() - base_ns_) & TIMESTAMP_MASK);
+      server_.writer_put(value);
+      server_.writer_flush();
+      in_flight++;
+    }
+  }
+
+  void consumer_run() {
+    auto left = static_cast<td::int64>(producers_n_) * queries_per_producer_;
+    while (left > 0) {
+      int cnt = server_.reader_wait();
+      while (cnt-- > 0) {
+        auto value = server_.reader_get_unsafe();
+        server_.reader_flush();
+        histogram_.record(((now_ns() - base_ns_) & TIMESTAMP_MASK) - (value & TIMESTAMP_MASK));
+        auto &producer = producers_[static_cast<std::size_t>(value >> 56)];
+        producer.replies.writer_put(0);
+        producer.replies.writer_flush();
+        left--;
+      }
+      server_.reader_flush();
+    }
+  }
+
+  static void *producer_run_gateway(void *arg) {
+    auto *producer = static_cast<Producer *>(arg);
+    producer->bench->producer_run(producer);
+    return nullptr;
+  }
+
+  static void *consumer_run_gateway(void *arg) {
+    static_cast<QueueContentionBenchmark *>(arg)->consumer_run();
+    return nullptr;
+  }
+
+ public:
+  QueueContentionBenchmark(const char *queue_name, int producers_n, int queries_n)
+      : queue_name_(queue_name)
+      , producers_n_(producers_n)
+      , queries_per_producer_((queries_n + producers_n - 1) / producers_n)
+      , producers_(producers_n) {
+  }
+
+  void run_and_report() {
+    server_.init();
+    for (int i = 0; i < producers_n_; i++) {
+      producers_[i].bench = this;
+      producers_[i].id = i;
+      producers_[i].replies.init();
+    }
+    auto cpu_n = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    base_ns_ = now_ns();
+
+    auto start = now_ns();
+    pthread_t consumer_thread;
+    pthread_create(&consumer_thread, nullptr, consumer_run_gateway, this);
+    set_thread_affinity(consumer_thread, 0);
+    for (int i = 0; i < producers_n_; i++) {
+      pthread_create(&producers_[i].thread, nullptr, producer_run_gateway, &producers_[i]);
+      if (cpu_n > 1) {
+        // keep producers away from the consumer's core
+        set_thread_affinity(producers_[i].thread, 1 + i % (cpu_n - 1));
+      }
+    }
+    for (int i = 0; i < producers_n_; i++) {
+      pthread_join(producers_[i].thread, nullptr);
+    }
+    pthread_join(consumer_thread, nullptr);
+    auto elapsed = now_ns() - start;
+
+    for (int i = 0; i < producers_n_; i++) {
+      producers_[i].replies.destroy();
+    }
+    server_.destroy();
+
+    auto ops = histogram_.count();
+    std::printf("queue=%s producers=%d consumers=1 ops=%llu ops_per_sec=%.0f p50_ns=%llu p99_ns=%llu p999_ns=%llu "
+                "max_ns=%llu\n",
+                queue_name_, producers_n_, static_cast<unsigned long long>(ops),
+                static_cast<double>(ops) * 1e9 / static_cast<double>(elapsed),
+                static_cast<unsigned long long>(histogram_.quantile(0.5)),
+                static_cast<unsigned long long>(histogram_.quantile(0.99)),
+                static_cast<unsigned long long>(histogram_.quantile(0.999)),
+                static_cast<unsigned long long>(histogram_.max()));
+    std::fflush(stdout);
+  }
+};
+
+static void run_contention_sweep(int queries_n) {
+  auto cpu_n = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+  auto max_producers = cpu_n > 1 ? cpu_n - 1 : 1;
+  std::fprintf(stderr, "Contention sweep over %d cpus\n", cpu_n);
+  // single-producer baseline over the SPSC queue
+  QueueContentionBenchmark<td::PollQueue<td::uint64>>("PollQueue", 1, queries_n).run_and_report();
+  for (int producers_n = 1; producers_n <= max_producers; producers_n *= 2) {
+    QueueContentionBenchmark<td::MpscPollableQueue<td::uint64>>("MpscPollableQueue", producers_n, queries_n)
+        .run_and_report();
+  }
+}
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(DEBUG));
+
+  run_contention_sweep(1 << 18);
 #define BENCH_Q2(Q, N)                      \
   std::fprintf(stderr, "!%s %d:\t", #Q, N); \
   td::bench(QueueBenchmark2<Q>(N));
@@ -0,0 +1,251 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// End-to-end message pipeline benchmark: drives a headless Td through the real
+// request path (TL parse -> MessagesManager -> serialized NetQuery) against a
+// fake network that echoes canned responses, and measures sendMessage round
+// trips per second and, when memprof is enabled, allocations per message.
+
+#include "memprof/memprof.h"
+
+#include "td/telegram/Global.h"
+#include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/Td.h"
+#include "td/telegram/TdCallback.h"
+
+#include "td/telegram/td_api.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/mtproto/utils.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
+
+#include <cstdio>
+
+namespace td {
+
+// Completes every query on the spot with a canned answer instead of sending it
+// to a Session, so the whole pipeline runs offline. State (pts, message ids)
+// is kept consistent, so UpdatesManager accepts the generated updates.
+class EchoNetQueryDispatcher : public NetQueryDispatcher {
+ public:
+  void dispatch(NetQueryPtr net_query) override {
+    switch (net_query->tl_constructor()) {
+      case telegram_api::auth_sendCode::ID:
+        return answer(std::move(net_query),
+                      telegram_api::auth_sentCode(1 /* phone_registered */, true,
+                                                  make_tl_object<telegram_api::auth_sentCodeTypeSms>(5), "bench_hash",
+                                                  nullptr, 0, nullptr));
+      case telegram_api::auth_signIn::ID:
+        return answer(std::move(net_query), telegram_api::auth_authorization(0, 0, make_self_user()));
+      case telegram_api::updates_getState::ID:
+        return answer(std::move(net_query), telegram_api::updates_state(pts_, 0, date_, 1, 0));
+      case telegram_api::updates_getDifference::ID:
+        return answer(std::move(net_query),
+                      telegram_api::updates_difference({}, {}, {}, {}, {},
+                                                       make_tl_object<telegram_api::updates_state>(pts_, 0, date_, 1, 0)));
+      case telegram_api::messages_getDialogs::ID:
+        return answer(std::move(net_query), telegram_api::messages_dialogs({}, {}, {}, {}));
+      case telegram_api::contacts_getContacts::ID:
+        return answer(std::move(net_query), telegram_api::contacts_contacts({}, 0, {}));
+      case telegram_api::messages_sendMessage::ID:
+        pts_++;
+        message_id_++;
+        date_++;
+        return answer(std::move(net_query), telegram_api::updateShortSentMessage(1 << 1 /* out */, true, message_id_,
+                                                                                 pts_, 1, date_, nullptr, {}));
+      default:
+        // everything else is inessential for the benchmark; the sender sees an
+        // ordinary error and handles it the usual way
+        net_query->set_error(
+            Status::Error(400, PSLICE() << "Unsupported by bench_td: " << format::as_hex(net_query->tl_constructor())));
+        return complete_net_query(std::move(net_query));
+    }
+  }
+
+  static constexpr int32 USER_ID = 736000;
+
+ private:
+  int32 pts_ = 1;
+  int32 message_id_ = 1;
+  int32 date_ = 1500000000;
+
+  static tl_object_ptr<telegram_api::user> make_self_user() {
+    int32 flags = (1 << 10) /* self */ | (1 << 0) /* access_hash */ | (1 << 1) /* first_name */ | (1 << 4) /* phone */;
+    return make_tl_object<telegram_api::user>(flags, true /* self */, false, false, false, false, false, false, false,
+                                              false, false, false, USER_ID, 123456789, "Bench", string(), string(),
+                                              "9996610000", nullptr, nullptr, 0, string(), string(), string());
+  }
+
+  template <class T>
+  static void answer(NetQueryPtr net_query, const T &result) {
+    TLObjectStorer<T> storer(result);
+    BufferSlice answer(storer.size());
+    auto real_size = storer.store(answer.as_slice().ubegin());
+    CHECK(real_size == answer.size());
+    net_query->set_ok(std::move(answer));
+    complete_net_query(std::move(net_query));
+  }
+};
+
+class BenchTdClient : public Actor {
+ public:
+  explicit BenchTdClient(int32 messages_n) : messages_n_(messages_n) {
+  }
+
+ private:
+  int32 messages_n_;
+  int32 sent_messages_n_ = 0;
+  ActorOwn<Td> td_;
+  uint64 request_id_ = 0;
+  uint64 create_chat_request_id_ = 0;
+  int64 chat_id_ = 0;
+  double start_time_ = 0;
+  uint64 start_alloc_count_ = 0;
+
+  void start_up() override {
+    class TdCallbackImpl : public TdCallback {
+     public:
+      explicit TdCallbackImpl(ActorId<BenchTdClient> client) : client_(client) {
+      }
+      void on_result(uint64 id, tl_object_ptr<td_api::Object> result) override {
+        send_closure(client_, &BenchTdClient::on_result, id, std::move(result));
+      }
+      void on_error(uint64 id, tl_object_ptr<td_api::error> error) override {
+        LOG(FATAL) << "Request " << id << " failed: " << to_string(*error);
+      }
+
+     private:
+      ActorId<BenchTdClient> client_;
+    };
+    td_ = create_actor<Td>("Td", make_unique<TdCallbackImpl>(actor_id(this)));
+  }
+
+  uint64 send(tl_object_ptr<td_api::Function> function) {
+    request_id_++;
+    send_closure(td_, &Td::request, request_id_, std::move(function));
+    return request_id_;
+  }
+
+  void on_result(uint64 id, tl_object_ptr<td_api::Object> result) {
+    switch (result->get_id()) {
+      case td_api::updateAuthorizationState::ID:
+        return on_authorization_state(
+            std::move(static_cast<td_api::updateAuthorizationState &>(*result).authorization_state_));
+      case td_api::updateMessageSendSucceeded::ID:
+        return on_message_sent();
+      case td_api::chat::ID:
+        if (id == create_chat_request_id_) {
+          chat_id_ = static_cast<td_api::chat &>(*result).id_;
+          start_sending();
+        }
+        return;
+      default:
+        // other responses and updates are irrelevant here
+        return;
+    }
+  }
+
+  void on_authorization_state(tl_object_ptr<td_api::AuthorizationState> authorization_state) {
+    switch (authorization_state->get_id()) {
+      case td_api::authorizationStateWaitTdlibParameters::ID: {
+        // the fake network must be installed before setTdlibParameters
+        // creates the real NetQueryDispatcher
+        G()->set_net_query_dispatcher(td::make_unique<EchoNetQueryDispatcher>());
+
+        auto parameters = td_api::make_object<td_api::tdlibParameters>();
+        parameters->use_test_dc_ = true;
+        parameters->database_directory_ = "bench_td_dir";
+        parameters->api_id_ = 94575;
+        parameters->api_hash_ = "a3406de8d171bb422bb6ddf3bbd800e2";
+        parameters->system_language_code_ = "en";
+        parameters->device_model_ = "Bench";
+        parameters->system_version_ = "1.0";
+        parameters->application_version_ = "1.0";
+        send(td_api::make_object<td_api::setTdlibParameters>(std::move(parameters)));
+        return;
+      }
+      case td_api::authorizationStateWaitEncryptionKey::ID:
+        send(td_api::make_object<td_api::checkDatabaseEncryptionKey>(string()));
+        return;
+      case td_api::authorizationStateWaitPhoneNumber::ID:
+        send(td_api::make_object<td_api::setAuthenticationPhoneNumber>("9996610000", false, false));
+        return;
+      case td_api::authorizationStateWaitCode::ID:
+        send(td_api::make_object<td_api::checkAuthenticationCode>("22222", "Bench", string()));
+        return;
+      case td_api::authorizationStateReady::ID:
+        create_chat_request_id_ =
+            send(td_api::make_object<td_api::createPrivateChat>(EchoNetQueryDispatcher::USER_ID, true));
+        return;
+      case td_api::authorizationStateClosed::ID:
+        Scheduler::instance()->finish();
+        stop();
+        return;
+      default:
+        return;
+    }
+  }
+
+  void start_sending() {
+    start_time_ = Time::now();
+    start_alloc_count_ = get_alloc_count();
+    send_next_message();
+  }
+
+  void send_next_message() {
+    send(td_api::make_object<td_api::sendMessage>(
+        chat_id_, 0, false, false, nullptr,
+        td_api::make_object<td_api::inputMessageText>(
+            td_api::make_object<td_api::formattedText>("hello", td::vector<tl_object_ptr<td_api::textEntity>>()), true,
+            false)));
+  }
+
+  void on_message_sent() {
+    sent_messages_n_++;
+    if (sent_messages_n_ < messages_n_) {
+      return send_next_message();
+    }
+
+    auto elapsed = Time::now() - start_time_;
+    std::printf("messages=%d round_trips_per_sec=%.0f\n", messages_n_,
+                static_cast<double>(messages_n_) / elapsed);
+    if (is_memprof_on()) {
+      std::printf("allocs_per_message=%.1f\n",
+                  static_cast<double>(get_alloc_count() - start_alloc_count_) / messages_n_);
+    }
+    std::fflush(stdout);
+    send(td_api::make_object<td_api::close>());
+  }
+};
+
+}  // namespace td
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  td::rmrf("bench_td_dir").ignore();
+
+  td::ConcurrentScheduler sched;
+  sched.init(0);
+  sched.create_actor_unsafe<td::BenchTdClient>(0, "BenchTdClient", 10000).release();
+  sched.start();
+  while (sched.run_main(10)) {
+  }
+  sched.finish();
+
+  td::rmrf("bench_td_dir").ignore();
+  return 0;
+}
@@ -6,6 +6,8 @@
 //
 #include "memprof/memprof.h"
 
+#include "td/utils/AllocationWatcher.h"
+#include "td/utils/MemoryTag.h"
 #include "td/utils/port/platform.h"
 
 #if (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF)
@@ -17,6 +19,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <new>
 #include <utility>
 #include <vector>
@@ -117,12 +120,14 @@ static Backtrace get_backtrace() {
   return res;
 }
 
-static constexpr std::size_t reserved = 16;
+static constexpr std::size_t reserved = 32;
 static constexpr std::int32_t malloc_info_magic = 0x27138373;
 struct malloc_info {
   std::int32_t magic;
   std::int32_t size;
-  std::int32_t ht_pos;
+  std::int32_t ht_pos;  // -1 if the allocation is not accounted in the profile
+  std::int32_t weight;  // bytes attributed to ht_pos; equals size unless sampling
+  std::int32_t tag;     // memory tag the allocation is charged to; exact, never sampled
 };
 
 static std::uint64_t get_hash(const Backtrace &bt) {
@@ -147,6 +152,12 @@ std::size_t get_ht_size() {
   return ht_size.load();
 }
 
+static std::atomic<std::size_t> alloc_cnt;
+
+std::size_t get_alloc_count() {
+  return alloc_cnt.load(std::memory_order_relaxed);
+}
+
 std::int32_t get_ht_pos(const Backtrace &bt, bool force = false) {
   auto hash = get_hash(bt);
   std::int32_t pos = static_cast<std::int32_t>(hash % ht.size());
@@ -196,16 +207,84 @@ void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
 }
 
 void register_xalloc(malloc_info *info, std::int32_t diff) {
+  if (info->ht_pos < 0) {
+    return;
+  }
   if (diff > 0) {
-    ht[info->ht_pos].size += info->size;
+    ht[info->ht_pos].size += info->weight;
   } else {
-    ht[info->ht_pos].size -= info->size;
+    ht[info->ht_pos].size -= info->weight;
+  }
+}
+
+#if USE_MEMPROF_SAMPLE
+// Size-weighted sampling: on average one sample point is placed every
+// sample_rate allocated bytes, and a sampled allocation is accounted with
+// sample_rate bytes per covered point. Large allocations are always recorded
+// with approximately their real size, small ones with probability
+// proportional to their size, so the expected profile matches the exact one
+// at a small fraction of the bookkeeping cost.
+static std::atomic<std::size_t> sample_rate{1 << 19};
+
+bool is_memprof_sampling() {
+  return true;
+}
+std::size_t get_memprof_sample_rate() {
+  return sample_rate.load(std::memory_order_relaxed);
+}
+void set_memprof_sample_rate(std::size_t rate) {
+  sample_rate.store(std::max(static_cast<std::size_t>(1), rate), std::memory_order_relaxed);
+}
+
+static std::size_t next_sample_gap(std::size_t rate) {
+  // a cheap thread-local LCG; a gap uniform in [1, 2 * rate] keeps the
+  // expected distance between sample points equal to the rate without the
+  // aliasing a fixed stride would have
+  static __thread std::uint64_t rand_state;  // static zero-initialized
+  if (rand_state == 0) {
+    rand_state = reinterpret_cast<std::uintptr_t>(&rand_state) | 1;
   }
+  rand_state = rand_state * 6364136223846793005ull + 1442695040888963407ull;
+  return 1 + static_cast<std::size_t>(rand_state >> 33) % (2 * rate);
 }
 
+// returns the number of bytes the allocation accounts for in the profile, or
+// 0 if it is skipped; the state is thread-local, so there is no contention
+static std::size_t alloc_weight(std::size_t size) {
+  static __thread std::size_t bytes_until_sample;  // static zero-initialized
+  if (size < bytes_until_sample) {
+    bytes_until_sample -= size;
+    return 0;
+  }
+  auto rate = sample_rate.load(std::memory_order_relaxed);
+  std::size_t points = 0;
+  std::size_t left = size;
+  while (left >= bytes_until_sample) {
+    left -= bytes_until_sample;
+    bytes_until_sample = next_sample_gap(rate);
+    points++;
+  }
+  bytes_until_sample -= left;
+  return points * rate;
+}
+#else
+bool is_memprof_sampling() {
+  return false;
+}
+std::size_t get_memprof_sample_rate() {
+  return 1;
+}
+void set_memprof_sample_rate(std::size_t) {
+}
+
+static std::size_t alloc_weight(std::size_t size) {
+  return size;
+}
+#endif
+
 extern "C" {
 
-static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
+static void *malloc_with_frame(std::size_t size, const Backtrace &frame, std::size_t weight) {
   static_assert(reserved % alignof(std::max_align_t) == 0, "fail");
   static_assert(reserved >= sizeof(malloc_info), "fail");
 #if TD_DARWIN
@@ -220,9 +299,19 @@ static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
 
   info->magic = malloc_info_magic;
   info->size = static_cast<std::int32_t>(size);
-  info->ht_pos = get_ht_pos(frame);
-
-  register_xalloc(info, +1);
+  if (weight == 0) {
+    info->ht_pos = -1;
+    info->weight = 0;
+  } else {
+    info->ht_pos = get_ht_pos(frame);
+    info->weight = static_cast<std::int32_t>(
+        std::min(weight, static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())));
+    register_xalloc(info, +1);
+  }
+  info->tag = td::get_thread_memory_tag();
+  td::on_memory_tag_alloc(info->tag, static_cast<td::int64>(size));
+  alloc_cnt.fetch_add(1, std::memory_order_relaxed);
+  td::on_thread_alloc();
 
   void *data = buf + reserved;
 
@@ -239,7 +328,10 @@ static malloc_info *get_info(void *data_void) {
 }
 
 void *malloc(std::size_t size) {
-  return malloc_with_frame(size, get_backtrace());
+  // the sampling decision is made before the backtrace is taken, so skipped
+  // allocations pay only for the thread-local counter update
+  auto weight = alloc_weight(size);
+  return malloc_with_frame(size, weight == 0 ? Backtrace{{nullptr}} : get_backtrace(), weight);
 }
 
 void free(void *data_void) {
@@ -248,6 +340,7 @@ void free(void *data_void) {
   }
   auto *info = get_info(data_void);
   register_xalloc(info, -1);
+  td::on_memory_tag_alloc(info->tag, -static_cast<td::int64>(info->size));
 
 #if TD_DARWIN
   static void *free_void = dlsym(RTLD_NEXT, "free");
@@ -260,16 +353,18 @@ void free(void *data_void) {
 }
 void *calloc(std::size_t size_a, std::size_t size_b) {
   auto size = size_a * size_b;
-  void *res = malloc_with_frame(size, get_backtrace());
+  auto weight = alloc_weight(size);
+  void *res = malloc_with_frame(size, weight == 0 ? Backtrace{{nullptr}} : get_backtrace(), weight);
   std::memset(res, 0, size);
   return res;
 }
 void *realloc(void *ptr, std::size_t size) {
+  auto weight = alloc_weight(size);
   if (ptr == nullptr) {
-    return malloc_with_frame(size, get_backtrace());
+    return malloc_with_frame(size, weight == 0 ? Backtrace{{nullptr}} : get_backtrace(), weight);
   }
   auto *info = get_info(ptr);
-  auto *new_ptr = malloc_with_frame(size, get_backtrace());
+  auto *new_ptr = malloc_with_frame(size, weight == 0 ? Backtrace{{nullptr}} : get_backtrace(), weight);
   auto to_copy = std::min(static_cast<std::int32_t>(size), info->size);
   std::memcpy(new_ptr, ptr, to_copy);
   free(ptr);
@@ -283,7 +378,8 @@ void *memalign(std::size_t aligment, std::size_t size) {
 
 // c++14 guarantees that it is enough to override these two operators.
 void *operator new(std::size_t count) {
-  return malloc_with_frame(count, get_backtrace());
+  auto weight = alloc_weight(count);
+  return malloc_with_frame(count, weight == 0 ? Backtrace{{nullptr}} : get_backtrace(), weight);
 }
 void operator delete(void *ptr) noexcept(true) {
   free(ptr);
@@ -301,6 +397,14 @@ void operator delete(void *ptr, std::size_t) noexcept(true) {
 bool is_memprof_on() {
   return false;
 }
+bool is_memprof_sampling() {
+  return false;
+}
+std::size_t get_memprof_sample_rate() {
+  return 1;
+}
+void set_memprof_sample_rate(std::size_t) {
+}
 void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
 }
 double get_fast_backtrace_success_rate() {
@@ -309,6 +413,9 @@ double get_fast_backtrace_success_rate() {
 std::size_t get_ht_size() {
   return 0;
 }
+std::size_t get_alloc_count() {
+  return 0;
+}
 #endif
 
 std::size_t get_used_memory_size() {
@@ -21,7 +21,11 @@ struct AllocInfo {
 };
 
 bool is_memprof_on();
+bool is_memprof_sampling();
+std::size_t get_memprof_sample_rate();
+void set_memprof_sample_rate(std::size_t rate);
 std::size_t get_ht_size();
+std::size_t get_alloc_count();
 double get_fast_backtrace_success_rate();
 void dump_alloc(const std::function<void(const AllocInfo &)> &func);
 std::size_t get_used_memory_size();
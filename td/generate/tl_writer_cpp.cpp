@@ -202,9 +202,74 @@ std::string TD_TL_writer_cpp::gen_type_fetch(const std::string &field_name, cons
   return gen_full_fetch_class_name(tree_type) + "::parse(p)";
 }
 
+std::size_t TD_TL_writer_cpp::get_fixed_field_size(const tl::arg &a) {
+  if (a.exist_var_num != -1 || (a.flags & tl::FLAG_EXCL) != 0 || a.type->get_type() != tl::NODE_TYPE_TYPE) {
+    return 0;
+  }
+  const std::string &name = static_cast<const tl::tl_tree_type *>(a.type)->type->name;
+  if (name == "#" || name == "Int" || name == "Int32" || name == "Bool") {
+    return 4;
+  }
+  if (name == "Int53" || name == "Int64" || name == "Long" || name == "Double") {
+    return 8;
+  }
+  if (name == "Int128") {
+    return 16;
+  }
+  if (name == "Int256") {
+    return 32;
+  }
+  return 0;
+}
+
+std::string TD_TL_writer_cpp::gen_fetch_fields_begin(const tl::tl_combinator *t, int parser_type) const {
+  fetch_field_plan_.assign(t->args.size(), -1);
+  fetch_field_pos_ = 0;
+  if (parser_type < 0) {
+    return "";
+  }
+
+  // group consecutive unconditional fixed-size fields into runs whose length is
+  // checked once, so the fields themselves can be read unchecked; a run may not
+  // exceed the zero buffer the parser redirects reads to after an error
+  const std::size_t MAX_RUN_SIZE = 32;  // sizeof(UInt256)
+  std::size_t i = 0;
+  while (i < t->args.size()) {
+    if (get_fixed_field_size(t->args[i]) == 0) {
+      i++;
+      continue;
+    }
+    std::size_t run_end = i;
+    while (run_end < t->args.size() && get_fixed_field_size(t->args[run_end]) != 0) {
+      run_end++;
+    }
+    while (i < run_end) {
+      std::size_t chunk_size = 0;
+      std::size_t chunk_end = i;
+      while (chunk_end < run_end && chunk_size + get_fixed_field_size(t->args[chunk_end]) <= MAX_RUN_SIZE) {
+        chunk_size += get_fixed_field_size(t->args[chunk_end]);
+        chunk_end++;
+      }
+      if (chunk_end - i >= 2) {
+        fetch_field_plan_[i] = static_cast<int>(chunk_size);
+        for (std::size_t j = i + 1; j < chunk_end; j++) {
+          fetch_field_plan_[j] = 0;
+        }
+      }
+      i = chunk_end;
+    }
+  }
+  return "";
+}
+
 std::string TD_TL_writer_cpp::gen_field_fetch(int field_num, const tl::arg &a, std::vector<tl::var_description> &vars,
                                               bool flat, int parser_type) const {
   assert(parser_type >= 0);
+  int field_plan = -1;
+  if (fetch_field_pos_ < fetch_field_plan_.size()) {
+    field_plan = fetch_field_plan_[fetch_field_pos_];
+  }
+  fetch_field_pos_++;
   std::string field_name = (parser_type == 0 ? (field_num == 0 ? ": " : ", ") : "res->") + gen_field_name(a.name);
 
   if (a.type->get_type() == tl::NODE_TYPE_VAR_TYPE) {
@@ -259,7 +324,13 @@ std::string TD_TL_writer_cpp::gen_field_fetch(int field_num, const tl::arg &a, s
 
   assert(a.type->get_type() == tl::NODE_TYPE_TYPE);
   const tl::tl_tree_type *tree_type = static_cast<tl::tl_tree_type *>(a.type);
-  res += gen_type_fetch(field_name, tree_type, vars, parser_type);
+  if (field_plan > 0) {
+    res += "TlFetchChecked<" + int_to_string(field_plan) + ", " + gen_full_fetch_class_name(tree_type) + ">::parse(p)";
+  } else if (field_plan == 0) {
+    res += gen_full_fetch_class_name(tree_type) + "::parse_unsafe(p)";
+  } else {
+    res += gen_type_fetch(field_name, tree_type, vars, parser_type);
+  }
   if (store_to_var_num) {
     res += ") < 0) { FAIL(\"Variable of type # can't be negative\"); }";
   } else {
@@ -624,21 +695,52 @@ std::string TD_TL_writer_cpp::gen_store_function_end(const std::vector<tl::var_d
 
 std::string TD_TL_writer_cpp::gen_fetch_switch_begin() const {
   return "  int constructor = p.fetch_int();\n"
-         "  switch (constructor) {\n";
+         "  using result_type = decltype(fetch(p));\n"
+         "  using fetch_function_type = result_type (*)(decltype(p));\n"
+         "  struct FetchEntry {\n"
+         "    uint32 id{0};\n"
+         "    fetch_function_type fetch_function{nullptr};\n"
+         "  };\n"
+         "  // constructor identifiers are looked up in an open-addressing hash table with\n"
+         "  // linear probing instead of a switch over sparse values; the table is built\n"
+         "  // once on first use\n"
+         "  static const vector<FetchEntry> fetch_table = [] {\n"
+         "    vector<FetchEntry> entries{\n";
 }
 
 std::string TD_TL_writer_cpp::gen_fetch_switch_case(const tl::tl_combinator *t, int arity) const {
   assert(arity == 0);
-  return "    case " + gen_class_name(t->name) +
-         "::ID:\n"
-         "      return " +
-         gen_class_name(t->name) + "::fetch(p);\n";
+  return "        {static_cast<uint32>(" + gen_class_name(t->name) +
+         "::ID),\n"
+         "         [](decltype(p) p) -> result_type { return " +
+         gen_class_name(t->name) + "::fetch(p); }},\n";
 }
 
 std::string TD_TL_writer_cpp::gen_fetch_switch_end() const {
-  return "    default:\n"
-         "      FAIL(PSTRING() << \"Unknown constructor found \" << format::as_hex(constructor));\n"
-         "  }\n";
+  return "    };\n"
+         "    size_t table_size = 4;\n"
+         "    while (table_size < entries.size() * 2) {\n"
+         "      table_size *= 2;\n"
+         "    }\n"
+         "    vector<FetchEntry> table(table_size);\n"
+         "    for (const auto &entry : entries) {\n"
+         "      auto pos = static_cast<size_t>(entry.id * 2654435761u) & (table_size - 1);\n"
+         "      while (table[pos].fetch_function != nullptr) {\n"
+         "        pos = (pos + 1) & (table_size - 1);\n"
+         "      }\n"
+         "      table[pos] = entry;\n"
+         "    }\n"
+         "    return table;\n"
+         "  }();\n"
+         "  auto wanted_id = static_cast<uint32>(constructor);\n"
+         "  auto pos = static_cast<size_t>(wanted_id * 2654435761u) & (fetch_table.size() - 1);\n"
+         "  while (fetch_table[pos].fetch_function != nullptr && fetch_table[pos].id != wanted_id) {\n"
+         "    pos = (pos + 1) & (fetch_table.size() - 1);\n"
+         "  }\n"
+         "  if (fetch_table[pos].fetch_function == nullptr) {\n"
+         "    FAIL(PSTRING() << \"Unknown constructor found \" << format::as_hex(constructor));\n"
+         "  }\n"
+         "  return fetch_table[pos].fetch_function(p);\n";
 }
 
 std::string TD_TL_writer_cpp::gen_constructor_begin(int fields_num, const std::string &class_name,
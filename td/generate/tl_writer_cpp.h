@@ -8,6 +8,7 @@
 
 #include "tl_writer_td.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -27,6 +28,14 @@ class TD_TL_writer_cpp : public TD_TL_writer {
 
   std::vector<std::string> ext_include;
 
+  static std::size_t get_fixed_field_size(const tl::arg &a);
+
+  // per-argument plan for the fetch function being generated, filled by
+  // gen_fetch_fields_begin and consumed by gen_field_fetch: -1 checked parse,
+  // 0 unchecked parse, > 0 unchecked parse after a length check of that many bytes
+  mutable std::vector<int> fetch_field_plan_;
+  mutable std::size_t fetch_field_pos_ = 0;
+
  protected:
   std::string gen_vector_store(const std::string &field_name, const tl::tl_tree_type *t,
                                const std::vector<tl::var_description> &vars, int storer_type) const;
@@ -62,6 +71,7 @@ class TD_TL_writer_cpp : public TD_TL_writer {
                       bool check_negative) const override;
   std::string gen_constructor_id_store(std::int32_t id, int storer_type) const override;
 
+  std::string gen_fetch_fields_begin(const tl::tl_combinator *t, int parser_type) const override;
   std::string gen_field_fetch(int field_num, const tl::arg &a, std::vector<tl::var_description> &vars, bool flat,
                               int parser_type) const override;
   std::string gen_field_store(const tl::arg &a, std::vector<tl::var_description> &vars, bool flat,
@@ -85,6 +85,10 @@ std::vector<std::string> TD_TL_writer::get_parsers() const {
     parsers.push_back("TlBufferParser");
   } else if (tl_name == "mtproto_api" || tl_name == "secret_api") {
     parsers.push_back("TlParser");
+  } else if (tl_name == "td_api") {
+#ifndef TD_ENABLE_JNI  // binary parsing of requests for the binary client interface
+    parsers.push_back("TlParser");
+#endif
   }
   return parsers;
 }
@@ -94,6 +98,13 @@ std::vector<std::string> TD_TL_writer::get_storers() const {
   if (tl_name == "telegram_api" || tl_name == "mtproto_api" || tl_name == "secret_api") {
     storers.push_back("TlStorerCalcLength");
     storers.push_back("TlStorerUnsafe");
+    storers.push_back("TlStorerToChainBuffer");
+  }
+  if (tl_name == "td_api") {
+#ifndef TD_ENABLE_JNI  // binary serialization of responses for the binary client interface
+    storers.push_back("TlStorerCalcLength");
+    storers.push_back("TlStorerUnsafe");
+#endif
   }
   storers.push_back("TlStorerToString");
   return storers;
@@ -12,6 +12,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <memory>
 #include <set>
 
 namespace td {
@@ -97,6 +98,14 @@ class AuthData {
     }
     return false;
   }
+  // when need_tmp_auth_key begins to ask for a new key; used to renew the key
+  // in the background instead of stalling the first query after it is needed
+  double get_tmp_auth_key_renew_at() const {
+    if (!use_pfs() || tmp_auth_key_.empty()) {
+      return 0;
+    }
+    return tmp_auth_key_.expires_at() - 60 * 60 * 2;
+  }
   void drop_main_auth_key() {
     main_auth_key_ = AuthKey();
   }
@@ -148,13 +157,16 @@ class AuthData {
   }
 
   Slice get_header() const {
+    if (header_ == nullptr) {
+      return Slice();
+    }
     if (use_pfs()) {
-      return tmp_auth_key_.need_header() ? Slice(header_) : Slice();
+      return tmp_auth_key_.need_header() ? Slice(*header_) : Slice();
     } else {
-      return main_auth_key_.need_header() ? Slice(header_) : Slice();
+      return main_auth_key_.need_header() ? Slice(*header_) : Slice();
     }
   }
-  void set_header(std::string header) {
+  void set_header(std::shared_ptr<const std::string> header) {
     header_ = std::move(header);
   }
   void on_api_response() {
@@ -218,7 +230,9 @@ class AuthData {
 
   bool need_future_salts(double now) {
     update_salt(now);
-    return future_salts_.empty() || !is_server_salt_valid(now);
+    // ask for new salts while the current one is still valid; the request is
+    // piggybacked on an outgoing packet and is flood-controlled by the caller
+    return future_salts_.size() < 2 || !is_server_salt_valid(now);
   }
 
   void set_future_salts(const std::vector<ServerSalt> &salts, double now);
@@ -266,7 +280,8 @@ class AuthData {
   ServerSalt server_salt_;
   int64 last_message_id_ = 0;
   int32 seq_no_ = 0;
-  std::string header_;
+  // the header is an immutable blob shared with all sessions using it
+  std::shared_ptr<const std::string> header_;
   uint64 session_id_ = 0;
 
   std::vector<ServerSalt> future_salts_;
@@ -136,7 +136,8 @@ void DhHandshake::set_config(int32 g_int, Slice prime_str) {
   g_int_ = g_int;
   g_.set_value(g_int_);
 
-  BigNum::mod_exp(g_b_, g_, b_, prime_, ctx_);
+  prime_mod_ctx_ = BigNumModContext::create(prime_, ctx_);
+  BigNum::mod_exp(g_b_, g_, b_, prime_, ctx_, prime_mod_ctx_);
 }
 
 Status DhHandshake::check_config(int32 g_int, Slice prime_str, DhCallback *callback) {
@@ -209,7 +210,11 @@ BigNum DhHandshake::get_b() const {
 BigNum DhHandshake::get_g_ab() {
   CHECK(has_g_a_ && has_config_);
   BigNum g_ab;
-  BigNum::mod_exp(g_ab, g_a_, b_, prime_, ctx_);
+  if (prime_mod_ctx_.is_inited()) {
+    BigNum::mod_exp(g_ab, g_a_, b_, prime_, ctx_, prime_mod_ctx_);
+  } else {
+    BigNum::mod_exp(g_ab, g_a_, b_, prime_, ctx_);
+  }
   return g_ab;
 }
 
@@ -102,6 +102,8 @@ class DhHandshake {
       g_.set_value(g_int_);
 
       g_b_ = BigNum::from_binary(parser.template fetch_string<string>());
+
+      prime_mod_ctx_ = BigNumModContext::create(prime_, ctx_);
     }
     if (has_g_a_) {
       g_a_ = BigNum::from_binary(parser.template fetch_string<string>());
@@ -130,6 +132,8 @@ class DhHandshake {
   bool has_g_a_ = false;
 
   BigNumContext ctx_;
+  // Montgomery setup for prime_, shared by the g^b and g_a^b exponentiations
+  BigNumModContext prime_mod_ctx_;
 };
 
 }  // namespace td
@@ -12,14 +12,117 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/MpmcQueue.h"
+#include "td/utils/MpmcWaiter.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 #include "td/utils/StorerBase.h"
 
+#include <atomic>
 #include <utility>
 
 namespace td {
 namespace mtproto {
 
+namespace {
+
+// Packets at least this big are worth a trip to the crypto worker pool;
+// smaller control packets are decrypted inline on the network thread.
+constexpr size_t CRYPTO_OFFLOAD_THRESHOLD = 16 * 1024;
+
+// Process-wide pool of worker threads decrypting large packets, so one
+// saturated download connection doesn't monopolize its scheduler thread.
+// It is created on first use and is never destroyed.
+class PacketCryptoPool {
+ public:
+  struct Task {
+    MutableSlice packet;
+    const AuthKey *auth_key = nullptr;
+    PacketInfo *info = nullptr;
+    Result<Transport::ReadResult> *result = nullptr;
+    std::atomic<size_t> *pending_count = nullptr;
+  };
+
+  static PacketCryptoPool &instance() {
+    static auto *pool = new PacketCryptoPool();  // never freed
+    return *pool;
+  }
+
+  // Decrypts all tasks, using the worker threads. Blocks until the whole batch
+  // is finished, so results are consumed strictly in submission order. Returns
+  // false if the pool can't serve the calling thread; the caller must decrypt
+  // inline then.
+  bool run_tasks(MutableSpan<Task> tasks) {
+    auto thread_id = get_thread_id();
+    if (thread_id < 0) {
+      return false;
+    }
+    std::atomic<size_t> pending_count{tasks.size()};
+    for (auto &task : tasks) {
+      task.pending_count = &pending_count;
+      queue_.push(&task, thread_id);
+      waiter_.notify();
+    }
+    // help the workers instead of just waiting for them
+    Task *task = nullptr;
+    while (queue_.try_pop(task, thread_id)) {
+      do_task(*task);
+    }
+    while (pending_count.load(std::memory_order_acquire) != 0) {
+      td::this_thread::yield();
+    }
+    return true;
+  }
+
+ private:
+  static constexpr size_t MAX_THREAD_COUNT = 64;
+
+  size_t workers_n_ = clamp(static_cast<size_t>(thread::hardware_concurrency() / 2), static_cast<size_t>(1),
+                            static_cast<size_t>(4));
+  MpmcQueue<Task *> queue_{MAX_THREAD_COUNT};
+  MpmcWaiter waiter_;
+  std::atomic<int> next_thread_id_{static_cast<int>(workers_n_)};
+  std::vector<thread> threads_;
+
+  PacketCryptoPool() {
+    for (size_t i = 0; i < workers_n_; i++) {
+      threads_.push_back(thread([this, i] { run_worker(i); }));
+    }
+  }
+
+  void run_worker(size_t worker_id) {
+    int yields = 0;
+    while (true) {
+      Task *task = nullptr;
+      if (queue_.try_pop(task, worker_id)) {
+        yields = waiter_.stop_wait(yields, narrow_cast<uint32>(worker_id));
+        do_task(*task);
+      } else {
+        yields = waiter_.wait(yields, narrow_cast<uint32>(worker_id));
+      }
+    }
+  }
+
+  static void do_task(Task &task) {
+    *task.result = Transport::read(task.packet, *task.auth_key, task.info);
+    task.pending_count->fetch_sub(1, std::memory_order_release);
+  }
+
+  // worker threads own ids [0, workers_n_); other threads get the rest
+  int get_thread_id() {
+    static TD_THREAD_LOCAL int thread_id;  // 0 is "not assigned yet"
+    if (thread_id == 0) {
+      auto id = next_thread_id_++;
+      thread_id = static_cast<size_t>(id) < MAX_THREAD_COUNT ? id : -1;
+    }
+    return thread_id;
+  }
+};
+
+}  // namespace
+
 void RawConnection::send_crypto(const Storer &storer, int64 session_id, int64 salt, const AuthKey &auth_key,
                                 uint64 quick_ack_token) {
   PacketInfo info;
@@ -65,6 +168,15 @@ Status RawConnection::flush_read(const AuthKey &auth_key, Callback &callback) {
     }
     callback.on_read(r.ok());
   }
+  struct PendingPacket {
+    BufferSlice packet;
+    uint32 quick_ack = 0;
+    PacketInfo info;
+    Result<Transport::ReadResult> read_result;
+    bool is_decrypted = false;
+  };
+  std::vector<PendingPacket> packets;
+  size_t read_alloc_hint = 0;
   while (transport_->can_read()) {
     BufferSlice packet;
     uint32 quick_ack = 0;
@@ -81,18 +193,50 @@ Status RawConnection::flush_read(const AuthKey &auth_key, Callback &callback) {
       if (wait_size > MAX_PACKET_SIZE) {
         return Status::Error(PSLICE() << "Expected packet size is too big: " << wait_size);
       }
+      // ask for the rest of the packet to be received into one contiguous
+      // buffer node, so that the transport can cut the packet out of the
+      // stream without gluing dozens of small nodes together
+      read_alloc_hint = wait_size;
       break;
     }
 
-    if (quick_ack != 0) {
-      TRY_STATUS(on_quick_ack(quick_ack, callback));
-      continue;
+    PendingPacket pending;
+    pending.packet = std::move(packet);
+    pending.quick_ack = quick_ack;
+    pending.info.version = 2;
+    packets.push_back(std::move(pending));
+  }
+  socket_fd_.set_read_alloc_hint(read_alloc_hint);
+
+  // decrypt large packets in parallel; there is nothing to win on a single one
+  std::vector<PacketCryptoPool::Task> tasks;
+  std::vector<PendingPacket *> offloaded_packets;
+  if (!auth_key.empty()) {
+    for (auto &pending : packets) {
+      if (pending.quick_ack == 0 && pending.packet.size() >= CRYPTO_OFFLOAD_THRESHOLD) {
+        tasks.push_back({pending.packet.as_slice(), &auth_key, &pending.info, &pending.read_result, nullptr});
+        offloaded_packets.push_back(&pending);
+      }
+    }
+  }
+  if (tasks.size() > 1 && PacketCryptoPool::instance().run_tasks(tasks)) {
+    for (auto *pending : offloaded_packets) {
+      pending->is_decrypted = true;
     }
+  }
 
-    PacketInfo info;
-    info.version = 2;
+  for (auto &pending : packets) {
+    if (pending.quick_ack != 0) {
+      TRY_STATUS(on_quick_ack(pending.quick_ack, callback));
+      continue;
+    }
 
-    TRY_RESULT(read_result, Transport::read(packet.as_slice(), auth_key, &info));
+    auto &packet = pending.packet;
+    auto &info = pending.info;
+    if (!pending.is_decrypted) {
+      pending.read_result = Transport::read(packet.as_slice(), auth_key, &info);
+    }
+    TRY_RESULT(read_result, std::move(pending.read_result));
     switch (read_result.type()) {
       case Transport::ReadResult::Quickack: {
         TRY_STATUS(on_quick_ack(read_result.quick_ack(), callback));
@@ -255,6 +255,11 @@ Status SessionConnection::on_packet_rpc_result(const MsgInfo &info, Slice packet
       return Status::Error(PSLICE() << "Failed to parse mtproto_api::gzip_packed: " << parser.get_error());
     }
     // yep, gzip in rpc_result
+    if (gzip.packed_data_.size() >= GZIP_LAZY_INFLATE_SIZE) {
+      // inflating a big answer here would block acks and pings of the whole session;
+      // let the receiver of the answer inflate it on its own thread instead
+      return callback_->on_message_result_gzip_ok(req_msg_id, as_buffer_slice(gzip.packed_data_), info.size);
+    }
     BufferSlice object = gzdecode(gzip.packed_data_);
     // send header no more optimization
     return callback_->on_message_result_ok(req_msg_id, std::move(object), info.size);
@@ -338,6 +343,7 @@ Status SessionConnection::on_packet(const MsgInfo &info,
       LOG(ERROR) << bad_info << ": MessageId is too high. Session will be closed";
       // All this queries will be re-sent by parent
       to_send_.clear();
+      to_send_size_ = 0;
       callback_->on_session_failed(Status::Error("MessageId is too high"));
       return Status::Error("MessageId is too high");
     }
@@ -750,10 +756,19 @@ Result<uint64> SessionConnection::send_query(BufferSlice buffer, bool gzip_flag,
     message_id = auth_data_->next_message_id(Time::now_cached());
   }
   auto seq_no = auth_data_->next_seq_no(true);
+  auto now = Time::now_cached();
   if (to_send_.empty()) {
-    send_before(Time::now_cached() + QUERY_DELAY);
+    // wait for up to QUERY_DELAY only in the middle of a burst, so its queries
+    // are packed into few containers; a lone query is flushed immediately
+    send_before(now + (now < last_query_at_ + QUERY_DELAY ? QUERY_DELAY : 0));
   }
+  last_query_at_ = now;
   to_send_.push_back(MtprotoQuery{message_id, seq_no, std::move(buffer), gzip_flag, invoke_after_id, use_quick_ack});
+  to_send_size_ += to_send_.back().packet.size();
+  if (to_send_.size() >= MAX_CONTAINER_QUERY_COUNT || to_send_size_ >= MAX_CONTAINER_QUERY_SIZE) {
+    // a full container needn't wait for the packing window to end
+    send_before(now);
+  }
   VLOG(mtproto) << "Invoke query " << message_id << " of size " << to_send_.back().packet.size() << " with seq_no "
                 << seq_no << " after " << invoke_after_id << (use_quick_ack ? " with quick ack" : "");
 
@@ -819,6 +834,12 @@ void SessionConnection::send_ack(uint64 message_id) {
   // an easiest way to eliminate duplicated acks for gzipped packets
   if (to_ack_.empty() || to_ack_.back() != ack) {
     to_ack_.push_back(ack);
+    if (to_ack_.size() >= MAX_UNACKED_COUNT) {
+      // during a one-sided flood of server messages there may be no outgoing
+      // packet to piggyback on for the whole ACK_DELAY; flush the acks before
+      // the server starts resending the unacknowledged messages
+      send_before(Time::now_cached());
+    }
   }
 }
 
@@ -868,10 +889,10 @@ void SessionConnection::flush_packet() {
   }
 
   size_t send_till = 0, send_size = 0;
-  // send at most 1020 queries, of total size 2^15
   // don't send anything if have no salt
   if (has_salt) {
-    while (send_till < to_send_.size() && send_till < 1020 && send_size < (1 << 15)) {
+    while (send_till < to_send_.size() && send_till < MAX_CONTAINER_QUERY_COUNT &&
+           send_size < MAX_CONTAINER_QUERY_SIZE) {
       send_size += to_send_[send_till].packet.size();
       send_till++;
     }
@@ -879,11 +900,13 @@ void SessionConnection::flush_packet() {
   std::vector<MtprotoQuery> queries;
   if (send_till == to_send_.size()) {
     queries = std::move(to_send_);
+    to_send_.clear();
   } else if (send_till != 0) {
     queries.reserve(send_till);
     std::move(to_send_.begin(), to_send_.begin() + send_till, std::back_inserter(queries));
     to_send_.erase(to_send_.begin(), to_send_.begin() + send_till);
   }
+  to_send_size_ -= send_size;
 
   bool destroy_auth_key = need_destroy_auth_key_ && !sent_destroy_auth_key_;
 
@@ -106,6 +106,9 @@ class SessionConnection
 
     virtual void on_message_ack(uint64 id) = 0;
     virtual Status on_message_result_ok(uint64 id, BufferSlice packet, size_t original_size) = 0;
+    // the packet is still gzip-packed: answers above GZIP_LAZY_INFLATE_SIZE are not
+    // inflated on the connection thread and must be inflated by the receiver
+    virtual Status on_message_result_gzip_ok(uint64 id, BufferSlice packet, size_t original_size) = 0;
     virtual void on_message_result_error(uint64 id, int code, BufferSlice descr) = 0;
     virtual void on_message_failed(uint64 id, Status status) = 0;
     virtual void on_message_info(uint64 id, int32 state, uint64 answer_id, int32 answer_size) = 0;
@@ -120,9 +123,15 @@ class SessionConnection
 
  private:
   static constexpr int ACK_DELAY = 30;                  // 30s
+  // pending acks are flushed once there are this many of them, even if
+  // ACK_DELAY hasn't expired and there is no outgoing packet to piggyback on
+  static constexpr size_t MAX_UNACKED_COUNT = 100;
   static constexpr double QUERY_DELAY = 0.001;          // 0.001s
   static constexpr double RESEND_ANSWER_DELAY = 0.001;  // 0.001s
 
+  static constexpr size_t MAX_CONTAINER_QUERY_COUNT = 1020;
+  static constexpr size_t MAX_CONTAINER_QUERY_SIZE = 1 << 15;
+
   bool online_flag_ = false;
   bool is_main_ = false;
 
@@ -154,6 +163,8 @@ class SessionConnection
   static constexpr int TEMP_KEY_TIMEOUT = 60 * 60 * 24;  // one day
 
   vector<MtprotoQuery> to_send_;
+  size_t to_send_size_ = 0;
+  double last_query_at_ = 0;
   vector<int64> to_ack_;
   double force_send_at_ = 0;
 
@@ -205,6 +216,10 @@ class SessionConnection
     return ScopeExit() + [&to = current_buffer_slice_, from = old_buffer_slice] { to = from; };
   }
 
+  // answers in rpc_result whose gzip-packed size is at least this big are handed to the
+  // callback still packed, so inflating them doesn't delay acks and pings
+  static constexpr size_t GZIP_LAZY_INFLATE_SIZE = 16 << 10;
+
   Status parse_message(TlParser &parser, MsgInfo *info, Slice *packet, bool crypto_flag = true) TD_WARN_UNUSED_RESULT;
   Status parse_packet(TlParser &parser) TD_WARN_UNUSED_RESULT;
   Status on_packet_container(const MsgInfo &info, Slice packet) TD_WARN_UNUSED_RESULT;
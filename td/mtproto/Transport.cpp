@@ -9,6 +9,7 @@
 #include "td/mtproto/AuthKey.h"
 #include "td/mtproto/crypto.h"
 
+#include "td/utils/AllocationWatcher.h"
 #include "td/utils/as.h"
 #include "td/utils/crypto.h"
 #include "td/utils/format.h"
@@ -443,6 +444,10 @@ Result<Transport::ReadResult> Transport::read(MutableSlice message, const AuthKe
 }
 
 size_t Transport::write(const Storer &storer, const AuthKey &auth_key, PacketInfo *info, MutableSlice dest) {
+  // the packet is serialized and encrypted in place inside dest; only the cipher
+  // setup may allocate, so a growing count here means the payload is being copied
+  TD_ASSERT_MAX_ALLOCATIONS(8);
+
   if (info->type == PacketInfo::EndToEnd) {
     return write_e2e_crypto(storer, auth_key, info, dest);
   }
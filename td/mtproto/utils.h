@@ -81,6 +81,11 @@ class TLObjectStorer : public Storer {
     object_.store(storer);
     return static_cast<size_t>(storer.get_buf() - ptr);
   }
+  void store_chain(ChainBufferWriter &writer) const override {
+    TlStorerToChainBuffer storer(writer);
+    storer.store_binary(object_.get_id());
+    object_.store(storer);
+  }
 };
 
 namespace mtproto_api {
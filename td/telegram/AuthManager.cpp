@@ -364,6 +364,7 @@ void AuthManager::start_net_query(NetQueryType net_query_type, NetQueryPtr net_q
   // TODO: cancel old net_query?
   net_query_type_ = net_query_type;
   net_query_id_ = net_query->id();
+  net_query->set_high_priority();
   G()->net_query_dispatcher().dispatch_with_callback(std::move(net_query), actor_shared(this));
 }
 
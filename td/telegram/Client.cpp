@@ -26,6 +26,21 @@
 
 namespace td {
 
+// scheduler pool configuration; may be overridden once with Client::set_scheduler_pool
+// before the first client is created
+static std::atomic<int32> pool_scheduler_count{0};
+static std::atomic<int32> pool_thread_count{-1};
+static std::atomic<bool> pool_is_created{false};
+
+void Client::set_scheduler_pool(std::int32_t scheduler_count, std::int32_t thread_count) {
+  if (pool_is_created.load()) {
+    LOG(ERROR) << "Ignore scheduler pool configuration: a Client has already been created";
+    return;
+  }
+  pool_scheduler_count.store(scheduler_count);
+  pool_thread_count.store(thread_count);
+}
+
 #if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
 
 class Client::Impl final {
@@ -86,6 +101,18 @@ class Client::Impl final {
     return {0, nullptr};
   }
 
+  std::size_t receive_batch(double timeout, std::size_t max_count, std::vector<Response> &responses) {
+    responses.clear();
+    while (responses.size() < max_count) {
+      auto response = receive(responses.empty() ? timeout : 0);
+      if (response.object == nullptr && response.id == 0) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    return responses.size();
+  }
+
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
   Impl(Impl &&) = delete;
@@ -152,7 +179,13 @@ class MultiImpl {
     static std::vector<std::weak_ptr<MultiImpl> > impls;
     std::unique_lock<std::mutex> lock(mutex);
     if (impls.size() == 0) {
-      impls.resize(clamp(thread::hardware_concurrency(), 8u, 1000u) * 5 / 4);
+      pool_is_created.store(true);
+      auto scheduler_count = pool_scheduler_count.load();
+      if (scheduler_count > 0) {
+        impls.resize(static_cast<size_t>(scheduler_count));
+      } else {
+        impls.resize(clamp(thread::hardware_concurrency(), 8u, 1000u) * 5 / 4);
+      }
     }
     auto &impl = *std::min_element(impls.begin(), impls.end(),
                                    [](auto &a, auto &b) { return a.lock().use_count() < b.lock().use_count(); });
@@ -166,7 +199,8 @@ class MultiImpl {
 
   MultiImpl() {
     concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>();
-    concurrent_scheduler_->init(3);
+    auto thread_count = pool_thread_count.load();
+    concurrent_scheduler_->init(thread_count >= 0 ? thread_count : 3);
     concurrent_scheduler_->start();
 
     {
@@ -274,6 +308,28 @@ class Client::Impl final {
     return response;
   }
 
+  std::size_t receive_batch(double timeout, std::size_t max_count, std::vector<Client::Response> &responses) {
+    responses.clear();
+    if (max_count == 0) {
+      return 0;
+    }
+    VLOG(td_requests) << "Begin to wait for a batch of updates with timeout " << timeout;
+    auto is_locked = receive_lock_.exchange(true);
+    CHECK(!is_locked);
+    // the queue is locked and drained once for the whole batch
+    while (responses.size() < max_count) {
+      auto response = receive_unlocked(responses.empty() ? timeout : 0);
+      if (response.object == nullptr && response.id == 0) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    is_locked = receive_lock_.exchange(false);
+    CHECK(is_locked);
+    VLOG(td_requests) << "End to wait for a batch of updates, returning " << responses.size() << " objects";
+    return responses.size();
+  }
+
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
   Impl(Impl &&) = delete;
@@ -328,6 +384,10 @@ Client::Response Client::receive(double timeout) {
   return impl_->receive(timeout);
 }
 
+std::size_t Client::receive_batch(double timeout, std::size_t max_count, std::vector<Response> &responses) {
+  return impl_->receive_batch(timeout, max_count, responses);
+}
+
 Client::Response Client::execute(Request &&request) {
   Response response;
   response.id = request.id;
@@ -11,8 +11,10 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace td {
 
@@ -53,9 +55,21 @@ class Client final {
  public:
   /**
    * Creates a new TDLib client.
+   *
+   * All clients of a process share a fixed pool of scheduler threads, so the number of threads
+   * scales with the number of processor cores and not with the number of clients.
    */
   Client();
 
+  /**
+   * Configures the process-wide pool of schedulers shared by all Client instances.
+   * Must be called before the first Client is created; later calls are ignored.
+   * \param[in] scheduler_count Number of shared schedulers between which clients are distributed,
+   *                            or 0 to choose the default based on the number of processor cores.
+   * \param[in] thread_count Number of additional worker threads of each scheduler, or -1 for the default.
+   */
+  static void set_scheduler_pool(std::int32_t scheduler_count, std::int32_t thread_count);
+
   /**
    * A request to the TDLib.
    */
@@ -103,6 +117,17 @@ class Client final {
    */
   Response receive(double timeout);
 
+  /**
+   * Receives up to max_count queued updates and request responses from TDLib in one call.
+   * Has the same threading requirements as Client::receive. The passed vector is cleared and
+   * refilled, so its capacity is reused between calls.
+   * \param[in] timeout Maximum number of seconds allowed for this function to wait for the first response.
+   * \param[in] max_count Maximum number of responses to return.
+   * \param[out] responses Vector to be filled with the received responses.
+   * \return Number of received responses.
+   */
+  std::size_t receive_batch(double timeout, std::size_t max_count, std::vector<Response> &responses);
+
   /**
    * Synchronously executes TDLib requests. Only a few requests can be executed synchronously.
    * May be called from any thread.
@@ -0,0 +1,103 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/ClientBinary.h"
+
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Status.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+#include <utility>
+
+namespace td {
+
+static Result<std::pair<td_api::object_ptr<td_api::Function>, int64>> to_request(Slice request) {
+  TlParser parser(request);
+  auto extra = parser.fetch_long();
+  auto function = td_api::Function::fetch(parser);
+  parser.fetch_end();
+  if (parser.get_error() != nullptr) {
+    return Status::Error(PSLICE() << "Failed to parse request: " << parser.get_error());
+  }
+  return std::make_pair(std::move(function), extra);
+}
+
+static TD_THREAD_LOCAL string *current_output;
+
+static Slice store_response(const td_api::Object &object, int64 extra) {
+  init_thread_local<string>(current_output);
+  // serialize into the thread-local string, whose capacity is reused between calls
+  auto &str = *current_output;
+
+  TlStorerCalcLength calc_length;
+  calc_length.store_long(extra);
+  calc_length.store_int(object.get_id());
+  object.store(calc_length);
+
+  str.resize(calc_length.get_length());
+  MutableSlice slice(str);
+  TlStorerUnsafe storer(slice.ubegin());
+  storer.store_long(extra);
+  storer.store_int(object.get_id());
+  object.store(storer);
+  CHECK(storer.get_buf() == slice.uend());
+  return slice;
+}
+
+void ClientBinary::send(Slice request) {
+  auto r_request = to_request(request);
+  if (r_request.is_error()) {
+    LOG(ERROR) << "Failed to parse " << tag("request", format::escaped(request)) << " " << r_request.error();
+    return;
+  }
+
+  std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
+  if (r_request.ok_ref().second != 0) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    extra_[extra_id] = r_request.ok_ref().second;
+  }
+  client_.send(Client::Request{extra_id, std::move(r_request.ok_ref().first)});
+}
+
+Slice ClientBinary::receive(double timeout) {
+  auto response = client_.receive(timeout);
+  if (!response.object) {
+    return {};
+  }
+
+  int64 extra = 0;
+  if (response.id != 0) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = extra_.find(response.id);
+    if (it != extra_.end()) {
+      extra = it->second;
+      extra_.erase(it);
+    }
+  }
+  return store_response(*response.object, extra);
+}
+
+Slice ClientBinary::execute(Slice request) {
+  auto r_request = to_request(request);
+  if (r_request.is_error()) {
+    LOG(ERROR) << "Failed to parse " << tag("request", format::escaped(request)) << " " << r_request.error();
+    return {};
+  }
+
+  auto response = Client::execute(Client::Request{0, std::move(r_request.ok_ref().first)});
+  if (!response.object) {
+    return {};
+  }
+  return store_response(*response.object, r_request.ok_ref().second);
+}
+
+}  // namespace td
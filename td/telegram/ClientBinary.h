@@ -0,0 +1,44 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/Client.h"
+
+#include "td/utils/Slice.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace td {
+
+// Binary sibling of ClientJson: requests and responses are TL-serialized
+// td_api objects instead of JSON text, so two native programs don't pay for
+// JSON encoding and parsing in between.
+//
+// A request is a client-chosen 8-byte extra followed by a boxed TL-serialized
+// td_api function; a response or an update is an 8-byte extra (the one from
+// the corresponding request, or 0 for updates) followed by a boxed
+// TL-serialized td_api object. All integers are little-endian, as everywhere
+// in TL.
+class ClientBinary final {
+ public:
+  void send(Slice request);
+
+  Slice receive(double timeout);
+
+  static Slice execute(Slice request);
+
+ private:
+  Client client_;
+  std::mutex mutex_;  // for extra_
+  std::unordered_map<std::uint64_t, std::int64_t> extra_;
+  std::atomic<std::uint64_t> extra_id_{1};
+};
+
+}  // namespace td
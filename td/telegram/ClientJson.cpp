@@ -40,8 +40,13 @@ static Result<std::pair<td_api::object_ptr<td_api::Function>, string>> to_reques
   return std::make_pair(std::move(func), extra);
 }
 
-static std::string from_response(const td_api::Object &object, const string &extra) {
-  auto str = json_encode<string>(ToJson(object));
+static TD_THREAD_LOCAL std::string *current_output;
+
+static CSlice store_response(const td_api::Object &object, const string &extra) {
+  init_thread_local<std::string>(current_output);
+  // encode into the thread-local string, whose capacity is reused between calls
+  auto &str = *current_output;
+  json_encode_to(str, ToJson(object));
   CHECK(!str.empty() && str.back() == '}');
   if (!extra.empty()) {
     str.pop_back();
@@ -53,14 +58,6 @@ static std::string from_response(const td_api::Object &object, const string &ext
   return str;
 }
 
-static TD_THREAD_LOCAL std::string *current_output;
-
-static CSlice store_string(std::string str) {
-  init_thread_local<std::string>(current_output);
-  *current_output = std::move(str);
-  return *current_output;
-}
-
 void ClientJson::send(Slice request) {
   auto r_request = to_request(request);
   if (r_request.is_error()) {
@@ -91,7 +88,44 @@ CSlice ClientJson::receive(double timeout) {
       extra_.erase(it);
     }
   }
-  return store_string(from_response(*response.object, extra));
+  return store_response(*response.object, extra);
+}
+
+static TD_THREAD_LOCAL std::string *current_batch_output;
+
+CSlice ClientJson::receive_batch(double timeout, std::size_t max_count) {
+  client_.receive_batch(timeout, max_count, responses_);
+  if (responses_.empty()) {
+    return {};
+  }
+
+  init_thread_local<std::string>(current_batch_output);
+  // the array is assembled in its own thread-local string, since store_response
+  // reuses current_output for each element
+  auto &str = *current_batch_output;
+  str.clear();
+  str += '[';
+  bool is_first = true;
+  for (auto &response : responses_) {
+    std::string extra;
+    if (response.id != 0) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto it = extra_.find(response.id);
+      if (it != extra_.end()) {
+        extra = std::move(it->second);
+        extra_.erase(it);
+      }
+    }
+    auto encoded = store_response(*response.object, extra);
+    if (!is_first) {
+      str += ',';
+    }
+    str.append(encoded.data(), encoded.size());
+    is_first = false;
+  }
+  str += ']';
+  responses_.clear();
+  return str;
 }
 
 CSlice ClientJson::execute(Slice request) {
@@ -101,8 +135,8 @@ CSlice ClientJson::execute(Slice request) {
     return {};
   }
 
-  return store_string(from_response(*Client::execute(Client::Request{0, std::move(r_request.ok_ref().first)}).object,
-                                    r_request.ok().second));
+  return store_response(*Client::execute(Client::Request{0, std::move(r_request.ok_ref().first)}).object,
+                        r_request.ok().second);
 }
 
 }  // namespace td
@@ -11,10 +11,12 @@
 #include "td/utils/Slice.h"
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace td {
 
@@ -24,6 +26,9 @@ class ClientJson final {
 
   CSlice receive(double timeout);
 
+  // receives up to max_count responses as one JSON array; empty if there are none
+  CSlice receive_batch(double timeout, std::size_t max_count);
+
   static CSlice execute(Slice request);
 
  private:
@@ -31,6 +36,7 @@ class ClientJson final {
   std::mutex mutex_;  // for extra_
   std::unordered_map<std::int64_t, std::string> extra_;
   std::atomic<std::uint64_t> extra_id_{1};
+  std::vector<Client::Response> responses_;  // buffer reused between receive_batch calls
 };
 
 }  // namespace td
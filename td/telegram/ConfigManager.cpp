@@ -768,7 +768,7 @@ Timestamp ConfigManager::load_config_expire_time() {
 
 void ConfigManager::save_config_expire(Timestamp timestamp) {
   G()->td_db()->get_binlog_pmc()->set("config_expire",
-                                      to_string(static_cast<int>(Clocks::system() + expire_time_.in())));
+                                      to_string(static_cast<int>(Clocks::system() + timestamp.in())));
 }
 
 void ConfigManager::process_config(tl_object_ptr<telegram_api::config> config) {
@@ -67,8 +67,7 @@ std::unordered_map<string, string> ConfigShared::get_options() const {
   return config_pmc_->get_all();
 }
 
-bool ConfigShared::get_option_boolean(Slice name, bool default_value) const {
-  auto value = get_option(name);
+static bool parse_boolean_option(Slice value, bool default_value) {
   if (value.empty()) {
     return default_value;
   }
@@ -82,16 +81,23 @@ bool ConfigShared::get_option_boolean(Slice name, bool default_value) const {
   return default_value;
 }
 
-int32 ConfigShared::get_option_integer(Slice name, int32 default_value) const {
-  auto str_value = get_option(name);
-  if (str_value.empty()) {
+static int32 parse_integer_option(Slice value, int32 default_value) {
+  if (value.empty()) {
     return default_value;
   }
-  if (str_value[0] != 'I') {
-    LOG(ERROR) << "Found \"" << str_value << "\" instead of integer option";
+  if (value[0] != 'I') {
+    LOG(ERROR) << "Found \"" << value << "\" instead of integer option";
     return default_value;
   }
-  return to_integer<int32>(str_value.substr(1));
+  return to_integer<int32>(value.substr(1));
+}
+
+bool ConfigShared::get_option_boolean(Slice name, bool default_value) const {
+  return parse_boolean_option(get_option(name), default_value);
+}
+
+int32 ConfigShared::get_option_integer(Slice name, int32 default_value) const {
+  return parse_integer_option(get_option(name), default_value);
 }
 
 string ConfigShared::get_option_string(Slice name, string default_value) const {
@@ -106,16 +112,59 @@ string ConfigShared::get_option_string(Slice name, string default_value) const {
   return str_value.substr(1);
 }
 
+bool ConfigShared::get_cached_option_boolean(CachedOption option, bool default_value) const {
+  return parse_boolean_option(get_cached_option_value(option), default_value);
+}
+
+int32 ConfigShared::get_cached_option_integer(CachedOption option, int32 default_value) const {
+  return parse_integer_option(get_cached_option_value(option), default_value);
+}
+
+Slice ConfigShared::get_cached_option_name(CachedOption option) {
+  switch (option) {
+    case CachedOption::IncludeSponsoredChatToUnreadCount:
+      return Slice("include_sponsored_chat_to_unread_count");
+    case CachedOption::MaxLoadedMessageCount:
+      return Slice("max_loaded_message_count");
+    case CachedOption::MaxLoadedUserCount:
+      return Slice("max_loaded_user_count");
+    case CachedOption::RevokePmInbox:
+      return Slice("revoke_pm_inbox");
+    case CachedOption::UseQuickAck:
+      return Slice("use_quick_ack");
+    default:
+      UNREACHABLE();
+      return Slice();
+  }
+}
+
+const string &ConfigShared::get_cached_option_value(CachedOption option) const {
+  auto &cache = cached_options_.get();
+  auto version = option_version_.load(std::memory_order_acquire);
+  if (cache.version != version) {
+    for (size_t i = 0; i < CACHED_OPTION_COUNT; i++) {
+      cache.values[i] = get_option(get_cached_option_name(static_cast<CachedOption>(i)));
+    }
+    cache.version = version;
+  }
+  return cache.values[static_cast<size_t>(option)];
+}
+
 tl_object_ptr<td_api::OptionValue> ConfigShared::get_option_value(Slice name) const {
   return get_option_value_object(get_option(name));
 }
 
 bool ConfigShared::set_option(Slice name, Slice value) {
+  bool is_changed;
   if (value.empty()) {
-    return config_pmc_->erase(name.str()) != 0;
+    is_changed = config_pmc_->erase(name.str()) != 0;
   } else {
-    return config_pmc_->set(name.str(), value.str()) != 0;
+    is_changed = config_pmc_->set(name.str(), value.str()) != 0;
+  }
+  if (is_changed) {
+    option_version_.fetch_add(1, std::memory_order_release);
   }
+  return is_changed;
 }
 
 tl_object_ptr<td_api::OptionValue> ConfigShared::get_option_value_object(Slice value) {
@@ -8,11 +8,15 @@
 
 #include "td/telegram/td_api.h"
 
+#include "td/actor/SchedulerLocalStorage.h"
+
 #include "td/db/KeyValueSyncInterface.h"
 
 #include "td/utils/common.h"
 #include "td/utils/Slice.h"
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -49,14 +53,42 @@ class ConfigShared {
   int32 get_option_integer(Slice name, int32 default_value = 0) const;
   string get_option_string(Slice name, string default_value = "") const;
 
+  // frequently read options, which can be accessed through a per-scheduler cache invalidated
+  // by a version counter instead of a synchronized string-keyed map lookup
+  enum class CachedOption : int32 {
+    IncludeSponsoredChatToUnreadCount,
+    MaxLoadedMessageCount,
+    MaxLoadedUserCount,
+    RevokePmInbox,
+    UseQuickAck,
+    Count
+  };
+
+  bool get_cached_option_boolean(CachedOption option, bool default_value = false) const;
+  int32 get_cached_option_integer(CachedOption option, int32 default_value = 0) const;
+
   tl_object_ptr<td_api::OptionValue> get_option_value(Slice name) const;
 
   static tl_object_ptr<td_api::OptionValue> get_option_value_object(Slice value);
 
  private:
+  static constexpr size_t CACHED_OPTION_COUNT = static_cast<size_t>(CachedOption::Count);
+
+  struct CachedOptions {
+    uint64 version = 0;
+    std::array<string, CACHED_OPTION_COUNT> values;
+  };
+
   std::shared_ptr<KeyValueSyncInterface> config_pmc_;
   unique_ptr<Callback> callback_;
 
+  mutable SchedulerLocalStorage<CachedOptions> cached_options_;
+  std::atomic<uint64> option_version_{1};
+
+  static Slice get_cached_option_name(CachedOption option);
+
+  const string &get_cached_option_value(CachedOption option) const;
+
   bool set_option(Slice name, Slice value);
 
   void on_option_updated(Slice name) const;
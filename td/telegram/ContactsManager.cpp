@@ -2412,9 +2412,11 @@ void ContactsManager::on_user_online_timeout_callback(void *contacts_manager_ptr
   CHECK(u != nullptr);
 
   LOG(INFO) << "Update " << user_id << " online status to offline";
-  send_closure_later(
-      G()->td(), &Td::send_update,
-      make_tl_object<td_api::updateUserStatus>(user_id.get(), contacts_manager->get_user_status_object(user_id, u)));
+  if (!contacts_manager->td_->is_update_suppressed(td_api::updateUserStatus::ID)) {
+    send_closure_later(
+        G()->td(), &Td::send_update,
+        make_tl_object<td_api::updateUserStatus>(user_id.get(), contacts_manager->get_user_status_object(user_id, u)));
+  }
 
   contacts_manager->update_user_online_member_count(u);
 }
@@ -3844,7 +3846,7 @@ void ContactsManager::on_update_contacts_reset() {
   UserId my_id = get_my_id();
   for (auto &p : users_) {
     UserId user_id = p.first;
-    User &u = p.second;
+    User &u = *p.second;
     bool is_contact = u.outbound == LinkState::Contact;
     if (is_contact) {
       LOG(INFO) << "Drop contact with " << user_id;
@@ -4863,7 +4865,7 @@ void ContactsManager::on_get_contacts(tl_object_ptr<telegram_api::contacts_Conta
   UserId my_id = get_my_id();
   for (auto &p : users_) {
     UserId user_id = p.first;
-    User &u = p.second;
+    User &u = *p.second;
     bool is_contact = u.outbound == LinkState::Contact;
     bool should_be_contact = contact_user_ids.count(user_id) == 1;
     if (is_contact != should_be_contact) {
@@ -5427,6 +5429,170 @@ void ContactsManager::on_load_user_from_database(UserId user_id, string value) {
   }
 }
 
+int64 ContactsManager::get_max_loaded_user_count() const {
+  constexpr int32 DEFAULT_MAX_LOADED_USER_COUNT = 1 << 18;
+  return G()->shared_config().get_cached_option_integer(ConfigShared::CachedOption::MaxLoadedUserCount,
+                                                        DEFAULT_MAX_LOADED_USER_COUNT);
+}
+
+bool ContactsManager::can_evict_user(UserId user_id, const User *u) const {
+  // only users that are fully saved to the database can be evicted; they will be transparently
+  // reloaded by get_user_force when they are needed again. Contacts and the current user are
+  // kept loaded, as well as users with not yet flushed online member counts
+  return u->is_saved && u->is_status_saved && !u->is_being_saved && u->logevent_id == 0 && !u->is_changed &&
+         !u->need_send_update && u->outbound != LinkState::Contact && u->inbound != LinkState::Contact &&
+         u->online_member_dialogs.empty() && !user_online_timeout_.has_timeout(user_id.get()) &&
+         user_id != get_my_id() && load_user_from_database_queries_.count(user_id) == 0;
+}
+
+void ContactsManager::on_evict_users_timeout(void *contacts_manager_void) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  CHECK(contacts_manager_void != nullptr);
+  auto contacts_manager = static_cast<ContactsManager *>(contacts_manager_void);
+  contacts_manager->evict_users_over_budget();
+}
+
+void ContactsManager::evict_users_over_budget() {
+  auto max_loaded_user_count = get_max_loaded_user_count();
+  if (max_loaded_user_count <= 0 || static_cast<int64>(users_.size()) <= max_loaded_user_count ||
+      !G()->parameters().use_chat_info_db) {
+    return;
+  }
+
+  // evict down to 90% of the budget, least recently accessed users first
+  auto target_user_count = max_loaded_user_count * 9 / 10;
+  vector<std::pair<int32, UserId>> candidates;
+  for (auto &it : users_) {
+    if (can_evict_user(it.first, it.second.get())) {
+      candidates.emplace_back(it.second->last_access_date, it.first);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<int32, UserId> &lhs, const std::pair<int32, UserId> &rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  size_t evicted_user_count = 0;
+  for (auto &candidate : candidates) {
+    if (static_cast<int64>(users_.size()) <= target_user_count) {
+      break;
+    }
+
+    auto user_id = candidate.second;
+    users_.erase(user_id);
+    loaded_from_database_users_.erase(user_id);
+    evicted_users_.insert(user_id);
+    evicted_user_count++;
+  }
+  LOG(INFO) << "Evicted " << evicted_user_count << " users, " << users_.size() << " user(s) are left loaded";
+}
+
+void ContactsManager::preload_users_from_database(const std::unordered_set<UserId, UserIdHash> &user_ids) {
+  if (!G()->parameters().use_chat_info_db) {
+    return;
+  }
+
+  vector<UserId> to_load;
+  vector<string> keys;
+  for (auto user_id : user_ids) {
+    if (user_id.is_valid() && get_user(user_id) == nullptr && loaded_from_database_users_.count(user_id) == 0) {
+      to_load.push_back(user_id);
+      keys.push_back(get_user_database_key(user_id));
+    }
+  }
+  if (to_load.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Preload " << to_load.size() << " users from database";
+  auto values = G()->td_db()->get_sqlite_sync_pmc()->get_many(
+      transform(keys, [](const string &key) { return Slice(key); }));
+  for (size_t i = 0; i < to_load.size(); i++) {
+    on_load_user_from_database(to_load[i], std::move(values[i]));
+  }
+}
+
+void ContactsManager::preload_chats_from_database(const std::unordered_set<ChatId, ChatIdHash> &chat_ids) {
+  if (!G()->parameters().use_chat_info_db) {
+    return;
+  }
+
+  vector<ChatId> to_load;
+  vector<string> keys;
+  for (auto chat_id : chat_ids) {
+    if (chat_id.is_valid() && get_chat(chat_id) == nullptr && loaded_from_database_chats_.count(chat_id) == 0) {
+      to_load.push_back(chat_id);
+      keys.push_back(get_chat_database_key(chat_id));
+    }
+  }
+  if (to_load.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Preload " << to_load.size() << " basic groups from database";
+  auto values = G()->td_db()->get_sqlite_sync_pmc()->get_many(
+      transform(keys, [](const string &key) { return Slice(key); }));
+  for (size_t i = 0; i < to_load.size(); i++) {
+    on_load_chat_from_database(to_load[i], std::move(values[i]));
+  }
+}
+
+void ContactsManager::preload_channels_from_database(const std::unordered_set<ChannelId, ChannelIdHash> &channel_ids) {
+  if (!G()->parameters().use_chat_info_db) {
+    return;
+  }
+
+  vector<ChannelId> to_load;
+  vector<string> keys;
+  for (auto channel_id : channel_ids) {
+    if (channel_id.is_valid() && get_channel(channel_id) == nullptr &&
+        loaded_from_database_channels_.count(channel_id) == 0) {
+      to_load.push_back(channel_id);
+      keys.push_back(get_channel_database_key(channel_id));
+    }
+  }
+  if (to_load.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Preload " << to_load.size() << " supergroups from database";
+  auto values = G()->td_db()->get_sqlite_sync_pmc()->get_many(
+      transform(keys, [](const string &key) { return Slice(key); }));
+  for (size_t i = 0; i < to_load.size(); i++) {
+    on_load_channel_from_database(to_load[i], std::move(values[i]));
+  }
+}
+
+void ContactsManager::preload_secret_chats_from_database(
+    const std::unordered_set<SecretChatId, SecretChatIdHash> &secret_chat_ids) {
+  if (!G()->parameters().use_chat_info_db) {
+    return;
+  }
+
+  vector<SecretChatId> to_load;
+  vector<string> keys;
+  for (auto secret_chat_id : secret_chat_ids) {
+    if (secret_chat_id.is_valid() && get_secret_chat(secret_chat_id) == nullptr &&
+        loaded_from_database_secret_chats_.count(secret_chat_id) == 0) {
+      to_load.push_back(secret_chat_id);
+      keys.push_back(get_secret_chat_database_key(secret_chat_id));
+    }
+  }
+  if (to_load.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Preload " << to_load.size() << " secret chats from database";
+  auto values = G()->td_db()->get_sqlite_sync_pmc()->get_many(
+      transform(keys, [](const string &key) { return Slice(key); }));
+  for (size_t i = 0; i < to_load.size(); i++) {
+    on_load_secret_chat_from_database(to_load[i], std::move(values[i]));
+  }
+}
+
 bool ContactsManager::have_user_force(UserId user_id) {
   return get_user_force(user_id) != nullptr;
 }
@@ -6238,8 +6404,10 @@ void ContactsManager::update_user(User *u, UserId user_id, bool from_binlog, boo
     if (!from_database) {
       u->is_status_saved = false;
     }
-    send_closure(G()->td(), &Td::send_update,
-                 make_tl_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u)));
+    if (!td_->is_update_suppressed(td_api::updateUserStatus::ID)) {
+      send_closure(G()->td(), &Td::send_update,
+                   make_tl_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u)));
+    }
     u->is_status_changed = false;
   }
   if (u->is_online_status_changed) {
@@ -6433,7 +6601,8 @@ void ContactsManager::update_chat_full(ChatFull *chat_full, ChatId chat_id) {
   if (chat_full->is_changed) {
     vector<UserId> administrator_user_ids;
     vector<UserId> bot_user_ids;
-    for (const auto &participant : chat_full->participants) {
+    for (const auto &node : chat_full->participants) {
+      const auto &participant = node.second;
       auto user_id = participant.user_id;
       if (participant.status.is_administrator()) {
         administrator_user_ids.push_back(user_id);
@@ -7228,19 +7397,16 @@ void ContactsManager::invalidate_user_full(UserId user_id) {
     return;
   }
 
+  // mark the cached data as expired, but keep serving it until the refetch arrives;
+  // on_get_user_full compares each field group and will re-store and notify the client
+  // only about the groups which have really changed
   user_full->expires_at = 0.0;
 
-  user_full->photos.clear();
-  user_full->photo_count = -1;
-  user_full->photos_offset = -1;
-  user_full->is_inited = true;
-  user_full->is_blocked = false;
-  user_full->can_be_called = false;
-  user_full->has_private_calls = false;
-  user_full->about = string();
-  user_full->common_chat_count = 0;
-  user_full->bot_info = nullptr;
-  user_full->is_changed = true;
+  if (user_full->bot_info != nullptr) {
+    // bot info isn't refreshed for deleted users, so it must be dropped right away
+    user_full->bot_info = nullptr;
+    user_full->is_changed = true;
+  }
 
   update_user_full(user_full, user_id);
 }
@@ -7304,7 +7470,7 @@ void ContactsManager::update_channel_online_member_count(ChannelId channel_id, b
   update_dialog_online_member_count(it->second, DialogId(channel_id), is_from_server);
 }
 
-void ContactsManager::update_dialog_online_member_count(const vector<DialogParticipant> &participants,
+void ContactsManager::update_dialog_online_member_count(const DialogParticipantMap &participants,
                                                         DialogId dialog_id, bool is_from_server) {
   if (td_->auth_manager_->is_bot()) {
     return;
@@ -7312,7 +7478,8 @@ void ContactsManager::update_dialog_online_member_count(const vector<DialogParti
 
   int32 online_member_count = 0;
   int32 time = G()->unix_time();
-  for (const auto &participant : participants) {
+  for (const auto &node : participants) {
+    const auto &participant = node.second;
     auto u = get_user(participant.user_id);
     if (u != nullptr && !u->is_deleted && !u->is_bot) {
       if (get_user_was_online(u, participant.user_id) > time) {
@@ -7438,12 +7605,11 @@ const DialogParticipant *ContactsManager::get_chat_participant(ChatId chat_id, U
 }
 
 const DialogParticipant *ContactsManager::get_chat_participant(const ChatFull *chat_full, UserId user_id) {
-  for (const auto &dialog_participant : chat_full->participants) {
-    if (dialog_participant.user_id == user_id) {
-      return &dialog_participant;
-    }
+  auto it = chat_full->participants.find(user_id);
+  if (it == chat_full->participants.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return &it->second;
 }
 
 DialogParticipant ContactsManager::get_dialog_participant(
@@ -7603,7 +7769,11 @@ void ContactsManager::on_get_channel_participants_success(
         administrator_count = narrow_cast<int32>(administrator_user_ids.size());
 
         if (get_channel_type(channel_id) == ChannelType::Megagroup && !td_->auth_manager_->is_bot()) {
-          cached_channel_participants_[channel_id] = result;
+          auto &cached_participants = cached_channel_participants_[channel_id];
+          cached_participants.clear();
+          for (const auto &participant : result) {
+            cached_participants.emplace(participant.user_id, participant);
+          }
           update_channel_online_member_count(channel_id, true);
         }
       } else if (filter.is_administrators()) {
@@ -7684,16 +7854,10 @@ void ContactsManager::speculative_add_channel_participants(ChannelId channel_id,
 
     if (it != cached_channel_participants_.end()) {
       auto &participants = it->second;
-      bool is_found = false;
-      for (auto &participant : participants) {
-        if (participant.user_id == user_id) {
-          is_found = true;
-          break;
-        }
-      }
-      if (!is_found) {
+      if (participants.count(user_id) == 0) {
         is_participants_cache_changed = true;
-        participants.emplace_back(user_id, inviter_user_id, date, DialogParticipantStatus::Member());
+        participants.emplace(user_id,
+                             DialogParticipant{user_id, inviter_user_id, date, DialogParticipantStatus::Member()});
       }
     }
   }
@@ -7714,13 +7878,8 @@ void ContactsManager::speculative_delete_channel_participant(ChannelId channel_i
 
   auto it = cached_channel_participants_.find(channel_id);
   if (it != cached_channel_participants_.end()) {
-    auto &participants = it->second;
-    for (size_t i = 0; i < participants.size(); i++) {
-      if (participants[i].user_id == deleted_user_id) {
-        participants.erase(participants.begin() + i);
-        update_channel_online_member_count(channel_id, false);
-        break;
-      }
+    if (it->second.erase(deleted_user_id) != 0) {
+      update_channel_online_member_count(channel_id, false);
     }
   }
 
@@ -7783,21 +7942,16 @@ void ContactsManager::speculative_add_channel_user(ChannelId channel_id, UserId
   auto it = cached_channel_participants_.find(channel_id);
   if (it != cached_channel_participants_.end()) {
     auto &participants = it->second;
-    bool is_found = false;
-    for (size_t i = 0; i < participants.size(); i++) {
-      if (participants[i].user_id == user_id) {
-        if (!new_status.is_member()) {
-          participants.erase(participants.begin() + i);
-          update_channel_online_member_count(channel_id, false);
-        } else {
-          participants[i].status = new_status;
-        }
-        is_found = true;
-        break;
+    auto participant_it = participants.find(user_id);
+    if (participant_it != participants.end()) {
+      if (!new_status.is_member()) {
+        participants.erase(participant_it);
+        update_channel_online_member_count(channel_id, false);
+      } else {
+        participant_it->second.status = new_status;
       }
-    }
-    if (!is_found && new_status.is_member()) {
-      participants.emplace_back(user_id, get_my_id(), G()->unix_time(), new_status);
+    } else if (new_status.is_member()) {
+      participants.emplace(user_id, DialogParticipant{user_id, get_my_id(), G()->unix_time(), new_status});
       update_channel_online_member_count(channel_id, false);
     }
   }
@@ -8063,25 +8217,25 @@ void ContactsManager::on_update_chat_add_user(ChatId chat_id, UserId inviter_use
     return;
   }
   if (on_update_chat_full_participants_short(chat_full, chat_id, version)) {
-    for (auto &participant : chat_full->participants) {
-      if (participant.user_id == user_id) {
-        if (participant.inviter_user_id != inviter_user_id) {
-          LOG(ERROR) << user_id << " was readded to " << chat_id << " by " << inviter_user_id
-                     << ", previously invited by " << participant.inviter_user_id;
-          participant.inviter_user_id = inviter_user_id;
-          participant.joined_date = date;
-          repair_chat_participants(chat_id);
-        } else {
-          // Possible if update comes twice
-          LOG(INFO) << user_id << " was readded to " << chat_id;
-        }
-        return;
+    auto participant_it = chat_full->participants.find(user_id);
+    if (participant_it != chat_full->participants.end()) {
+      auto &participant = participant_it->second;
+      if (participant.inviter_user_id != inviter_user_id) {
+        LOG(ERROR) << user_id << " was readded to " << chat_id << " by " << inviter_user_id
+                   << ", previously invited by " << participant.inviter_user_id;
+        participant.inviter_user_id = inviter_user_id;
+        participant.joined_date = date;
+        repair_chat_participants(chat_id);
+      } else {
+        // Possible if update comes twice
+        LOG(INFO) << user_id << " was readded to " << chat_id;
       }
+      return;
     }
-    chat_full->participants.push_back(DialogParticipant{user_id, inviter_user_id, date,
-                                                        user_id == chat_full->creator_user_id
-                                                            ? DialogParticipantStatus::Creator(true)
-                                                            : DialogParticipantStatus::Member()});
+    chat_full->participants.emplace(user_id, DialogParticipant{user_id, inviter_user_id, date,
+                                                               user_id == chat_full->creator_user_id
+                                                                   ? DialogParticipantStatus::Creator(true)
+                                                                   : DialogParticipantStatus::Member()});
     update_chat_online_member_count(chat_full, chat_id, false);
     chat_full->is_changed = true;
     update_chat_full(chat_full, chat_id);
@@ -8148,14 +8302,13 @@ void ContactsManager::on_update_chat_edit_administrator(ChatId chat_id, UserId u
   ChatFull *chat_full = get_chat_full(chat_id);
   if (chat_full != nullptr) {
     if (chat_full->version + 1 == version) {
-      for (auto &participant : chat_full->participants) {
-        if (participant.user_id == user_id) {
-          participant.status = is_administrator ? DialogParticipantStatus::GroupAdministrator(c->is_creator)
-                                                : DialogParticipantStatus::Member();
-          chat_full->is_changed = true;
-          update_chat_full(chat_full, chat_id);
-          return;
-        }
+      auto participant_it = chat_full->participants.find(user_id);
+      if (participant_it != chat_full->participants.end()) {
+        participant_it->second.status = is_administrator ? DialogParticipantStatus::GroupAdministrator(c->is_creator)
+                                                         : DialogParticipantStatus::Member();
+        chat_full->is_changed = true;
+        update_chat_full(chat_full, chat_id);
+        return;
       }
     }
 
@@ -8200,19 +8353,15 @@ void ContactsManager::on_update_chat_delete_user(ChatId chat_id, UserId user_id,
     return;
   }
   if (on_update_chat_full_participants_short(chat_full, chat_id, version)) {
-    for (size_t i = 0; i < chat_full->participants.size(); i++) {
-      if (chat_full->participants[i].user_id == user_id) {
-        chat_full->participants[i] = chat_full->participants.back();
-        chat_full->participants.resize(chat_full->participants.size() - 1);
-        chat_full->is_changed = true;
-        update_chat_online_member_count(chat_full, chat_id, false);
-        update_chat_full(chat_full, chat_id);
+    if (chat_full->participants.erase(user_id) != 0) {
+      chat_full->is_changed = true;
+      update_chat_online_member_count(chat_full, chat_id, false);
+      update_chat_full(chat_full, chat_id);
 
-        if (static_cast<int>(chat_full->participants.size()) != c->participant_count) {
-          repair_chat_participants(chat_id);
-        }
-        return;
+      if (static_cast<int>(chat_full->participants.size()) != c->participant_count) {
+        repair_chat_participants(chat_id);
       }
+      return;
     }
     LOG(ERROR) << "Can't find group member " << user_id << " in " << chat_id << " to delete him";
     repair_chat_participants(chat_id);
@@ -8416,9 +8565,18 @@ void ContactsManager::on_update_chat_full_participants(ChatFull *chat_full, Chat
     LOG(INFO) << "Members of " << chat_id << " has changed";
     // this is possible in very rare situations
     repair_chat_participants(chat_id);
+  } else if (version == chat_full->version) {
+    // the member list is versioned by the server; the same version with a matching
+    // member count means that nothing has changed, so there is no need to re-store
+    // the list and notify the client
+    return;
   }
 
-  chat_full->participants = std::move(participants);
+  chat_full->participants.clear();
+  for (auto &participant : participants) {
+    auto user_id = participant.user_id;
+    chat_full->participants.emplace(user_id, std::move(participant));
+  }
   chat_full->version = version;
   chat_full->is_changed = true;
   update_chat_online_member_count(chat_full, chat_id, true);
@@ -8618,7 +8776,7 @@ Result<BotData> ContactsManager::get_bot_data(UserId user_id) const {
     return Status::Error(5, "Bot not found");
   }
 
-  auto bot = &p->second;
+  auto bot = p->second.get();
   if (!bot->is_bot) {
     return Status::Error(5, "User is not a bot");
   }
@@ -8648,7 +8806,8 @@ const ContactsManager::User *ContactsManager::get_user(UserId user_id) const {
   if (p == users_.end()) {
     return nullptr;
   } else {
-    return &p->second;
+    p->second->last_access_date = G()->unix_time_cached();
+    return p->second.get();
   }
 }
 
@@ -8657,7 +8816,8 @@ ContactsManager::User *ContactsManager::get_user(UserId user_id) {
   if (p == users_.end()) {
     return nullptr;
   } else {
-    return &p->second;
+    p->second->last_access_date = G()->unix_time_cached();
+    return p->second.get();
   }
 }
 
@@ -8714,10 +8874,23 @@ bool ContactsManager::get_user(UserId user_id, int left_tries, Promise<Unit> &&p
 
 ContactsManager::User *ContactsManager::add_user(UserId user_id, const char *source) {
   CHECK(user_id.is_valid());
-  User *u = &users_[user_id];
+  evicted_users_.erase(user_id);
+  auto &user = users_[user_id];
+  if (user == nullptr) {
+    // the User is stored by pointer, so references to it stay valid when users_ grows
+    user = make_unique<User>();
+  }
+  User *u = user.get();
   if (u->debug_source == nullptr) {
     u->debug_source = source;
   }
+  auto max_loaded_user_count = get_max_loaded_user_count();
+  if (max_loaded_user_count > 0 && static_cast<int64>(users_.size()) > max_loaded_user_count &&
+      !evict_users_timeout_.has_timeout()) {
+    evict_users_timeout_.set_callback(on_evict_users_timeout);
+    evict_users_timeout_.set_callback_data(static_cast<void *>(this));
+    evict_users_timeout_.set_timeout_in(1.0);
+  }
   return u;
 }
 
@@ -8984,7 +9157,8 @@ bool ContactsManager::is_chat_full_outdated(const ChatFull *chat_full, const Cha
     return true;
   }
 
-  for (const auto &participant : chat_full->participants) {
+  for (const auto &node : chat_full->participants) {
+    const auto &participant = node.second;
     auto user = get_user(participant.user_id);
     if (user != nullptr && user->bot_info_version != -1) {
       auto user_full = get_user_full(participant.user_id);
@@ -9480,9 +9654,9 @@ std::pair<int32, vector<DialogParticipant>> ContactsManager::search_chat_partici
   };
 
   vector<UserId> user_ids;
-  for (const auto &participant : chat_full->participants) {
-    if (is_dialog_participant_suitable(participant, filter)) {
-      user_ids.push_back(participant.user_id);
+  for (const auto &node : chat_full->participants) {
+    if (is_dialog_participant_suitable(node.second, filter)) {
+      user_ids.push_back(node.first);
     }
   }
 
@@ -10146,7 +10320,8 @@ tl_object_ptr<td_api::UserStatus> ContactsManager::get_user_status_object(UserId
 }
 
 int32 ContactsManager::get_user_id_object(UserId user_id, const char *source) const {
-  if (user_id.is_valid() && get_user(user_id) == nullptr && unknown_users_.count(user_id) == 0) {
+  if (user_id.is_valid() && get_user(user_id) == nullptr && unknown_users_.count(user_id) == 0 &&
+      evicted_users_.count(user_id) == 0) {
     LOG(ERROR) << "Have no info about " << user_id << " from " << source;
     unknown_users_.insert(user_id);
     send_closure(G()->td(), &Td::send_update,
@@ -10254,7 +10429,7 @@ tl_object_ptr<td_api::basicGroupFullInfo> ContactsManager::get_basic_group_full_
   return make_tl_object<td_api::basicGroupFullInfo>(
       get_user_id_object(chat_full->creator_user_id, "basicGroupFullInfo"),
       transform(chat_full->participants,
-                [this](const DialogParticipant &chat_participant) { return get_chat_member_object(chat_participant); }),
+                [this](const DialogParticipantMap::value_type &node) { return get_chat_member_object(node.second); }),
       chat_full->invite_link);
 }
 
@@ -10478,7 +10653,7 @@ void ContactsManager::after_get_difference() {
 
 void ContactsManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const {
   for (auto &it : users_) {
-    updates.push_back(td_api::make_object<td_api::updateUser>(get_user_object(it.first, &it.second)));
+    updates.push_back(td_api::make_object<td_api::updateUser>(get_user_object(it.first, it.second.get())));
   }
   for (auto &it : channels_) {
     updates.push_back(td_api::make_object<td_api::updateSupergroup>(get_supergroup_object(it.first, &it.second)));
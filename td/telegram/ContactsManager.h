@@ -29,10 +29,12 @@
 #include "td/actor/Timeout.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Hints.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/VectorMap.h"
 
 #include <functional>
 #include <memory>
@@ -376,6 +378,13 @@ class ContactsManager : public Actor {
   bool get_secret_chat(SecretChatId secret_chat_id, bool force, Promise<Unit> &&promise);
   bool get_secret_chat_full(SecretChatId secret_chat_id, Promise<Unit> &&promise);
 
+  // loads all not yet loaded users/chats with one database multi-get, so subsequent
+  // have_*_force calls don't need to do a database read per identifier
+  void preload_users_from_database(const std::unordered_set<UserId, UserIdHash> &user_ids);
+  void preload_chats_from_database(const std::unordered_set<ChatId, ChatIdHash> &chat_ids);
+  void preload_channels_from_database(const std::unordered_set<ChannelId, ChannelIdHash> &channel_ids);
+  void preload_secret_chats_from_database(const std::unordered_set<SecretChatId, SecretChatIdHash> &secret_chat_ids);
+
   ChannelType get_channel_type(ChannelId channel_id) const;
   int32 get_channel_date(ChannelId channel_id) const;
   DialogParticipantStatus get_channel_status(ChannelId channel_id) const;
@@ -511,6 +520,8 @@ class ContactsManager : public Actor {
 
     uint64 logevent_id = 0;
 
+    mutable int32 last_access_date = 0;  // not persisted, used to choose users for eviction
+
     const char *debug_source = nullptr;
 
     template <class StorerT>
@@ -593,10 +604,14 @@ class ContactsManager : public Actor {
     void parse(ParserT &parser);
   };
 
+  // almost all chats are tiny and member lookups vastly outnumber member changes,
+  // so participant lists are kept sorted by user identifier and searched in place
+  using DialogParticipantMap = VectorMap<UserId, DialogParticipant>;
+
   struct ChatFull {
     int32 version = -1;
     UserId creator_user_id;
-    vector<DialogParticipant> participants;
+    DialogParticipantMap participants;
 
     string invite_link;
 
@@ -918,7 +933,7 @@ class ContactsManager : public Actor {
   void update_user_online_member_count(User *u);
   void update_chat_online_member_count(const ChatFull *chat_full, ChatId chat_id, bool is_from_server);
   void update_channel_online_member_count(ChannelId channel_id, bool is_from_server);
-  void update_dialog_online_member_count(const vector<DialogParticipant> &participants, DialogId dialog_id,
+  void update_dialog_online_member_count(const DialogParticipantMap &participants, DialogId dialog_id,
                                          bool is_from_server);
 
   void on_chat_update(telegram_api::chatEmpty &chat, const char *source);
@@ -937,6 +952,14 @@ class ContactsManager : public Actor {
   void load_user_from_database_impl(UserId user_id, Promise<Unit> promise);
   void on_load_user_from_database(UserId user_id, string value);
 
+  int64 get_max_loaded_user_count() const;
+
+  bool can_evict_user(UserId user_id, const User *u) const;
+
+  void evict_users_over_budget();
+
+  static void on_evict_users_timeout(void *contacts_manager_void);
+
   void save_chat(Chat *c, ChatId chat_id, bool from_binlog);
   static string get_chat_database_key(ChatId chat_id);
   static string get_chat_database_value(const Chat *c);
@@ -1079,7 +1102,7 @@ class ContactsManager : public Actor {
   UserId support_user_id_;
   int32 my_was_online_local_ = 0;
 
-  std::unordered_map<UserId, User, UserIdHash> users_;
+  FlatHashMap<UserId, unique_ptr<User>, UserIdHash> users_;
   std::unordered_map<UserId, UserFull, UserIdHash> users_full_;
   mutable std::unordered_set<UserId, UserIdHash> unknown_users_;
   std::unordered_map<UserId, tl_object_ptr<telegram_api::UserProfilePhoto>, UserIdHash> pending_user_photos_;
@@ -1115,6 +1138,7 @@ class ContactsManager : public Actor {
 
   std::unordered_map<UserId, vector<Promise<Unit>>, UserIdHash> load_user_from_database_queries_;
   std::unordered_set<UserId, UserIdHash> loaded_from_database_users_;
+  std::unordered_set<UserId, UserIdHash> evicted_users_;  // users unloaded from memory, but saved in the database
 
   std::unordered_map<ChatId, vector<Promise<Unit>>, ChatIdHash> load_chat_from_database_queries_;
   std::unordered_set<ChatId, ChatIdHash> loaded_from_database_chats_;
@@ -1125,9 +1149,9 @@ class ContactsManager : public Actor {
   std::unordered_map<SecretChatId, vector<Promise<Unit>>, SecretChatIdHash> load_secret_chat_from_database_queries_;
   std::unordered_set<SecretChatId, SecretChatIdHash> loaded_from_database_secret_chats_;
 
-  QueryCombiner get_user_full_queries_{"GetUserFullCombiner", 2.0};
-  QueryCombiner get_chat_full_queries_{"GetChatFullCombiner", 2.0};
-  QueryCombiner get_channel_full_queries_{"GetChannelFullCombiner", 2.0};
+  QueryCombiner get_user_full_queries_{"GetUserFullCombiner", 2.0, 5.0};
+  QueryCombiner get_chat_full_queries_{"GetChatFullCombiner", 2.0, 5.0};
+  QueryCombiner get_channel_full_queries_{"GetChannelFullCombiner", 2.0, 5.0};
 
   std::unordered_map<DialogId, vector<UserId>, DialogIdHash> dialog_administrators_;
 
@@ -1141,7 +1165,7 @@ class ContactsManager : public Actor {
   std::unordered_map<int64, DialogParticipant> received_channel_participant_;
   std::unordered_map<int64, std::pair<int32, vector<DialogParticipant>>> received_channel_participants_;
 
-  std::unordered_map<ChannelId, vector<DialogParticipant>, ChannelIdHash> cached_channel_participants_;
+  std::unordered_map<ChannelId, DialogParticipantMap, ChannelIdHash> cached_channel_participants_;
 
   std::unordered_map<int64, std::pair<int32, vector<UserId>>>
       found_blocked_users_;  // random_id -> [total_count, [user_id]...]
@@ -1172,6 +1196,8 @@ class ContactsManager : public Actor {
 
   MultiTimeout user_online_timeout_{"UserOnlineTimeout"};
   MultiTimeout channel_unban_timeout_{"ChannelUnbanTimeout"};
+
+  Timeout evict_users_timeout_;
 };
 
 }  // namespace td
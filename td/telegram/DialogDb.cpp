@@ -98,6 +98,10 @@ class DialogDbImpl : public DialogDbSyncInterface {
     TRY_RESULT(get_dialogs_stmt, db_.get_statement("SELECT data, dialog_id, dialog_order FROM dialogs WHERE "
                                                    "dialog_order < ?1 OR (dialog_order = ?1 AND dialog_id < ?2) ORDER "
                                                    "BY dialog_order DESC, dialog_id DESC LIMIT ?3"));
+    // covered by the dialog_by_dialog_order index, so data blobs aren't touched
+    TRY_RESULT(get_dialog_order_index_stmt,
+               db_.get_statement(
+                   "SELECT dialog_id, dialog_order FROM dialogs ORDER BY dialog_order DESC, dialog_id DESC"));
     TRY_RESULT(
         get_notification_groups_by_last_notification_date_stmt,
         db_.get_statement("SELECT notification_group_id, dialog_id, last_notification_date FROM notification_groups "
@@ -116,6 +120,7 @@ class DialogDbImpl : public DialogDbSyncInterface {
     delete_notification_group_stmt_ = std::move(delete_notification_group_stmt);
     get_dialog_stmt_ = std::move(get_dialog_stmt);
     get_dialogs_stmt_ = std::move(get_dialogs_stmt);
+    get_dialog_order_index_stmt_ = std::move(get_dialog_order_index_stmt);
     get_notification_groups_by_last_notification_date_stmt_ =
         std::move(get_notification_groups_by_last_notification_date_stmt);
     get_notification_group_stmt_ = std::move(get_notification_group_stmt);
@@ -212,6 +217,25 @@ class DialogDbImpl : public DialogDbSyncInterface {
 
     return std::move(dialogs);
   }
+
+  Result<vector<DialogOrderInfo>> get_dialog_order_index() override {
+    SCOPE_EXIT {
+      get_dialog_order_index_stmt_.reset();
+    };
+
+    vector<DialogOrderInfo> dialog_orders;
+    TRY_STATUS(get_dialog_order_index_stmt_.step());
+    while (get_dialog_order_index_stmt_.has_row()) {
+      DialogOrderInfo dialog_order;
+      dialog_order.dialog_id = DialogId(get_dialog_order_index_stmt_.view_int64(0));
+      dialog_order.order = get_dialog_order_index_stmt_.view_int64(1);
+      dialog_orders.push_back(dialog_order);
+      TRY_STATUS(get_dialog_order_index_stmt_.step());
+    }
+
+    return std::move(dialog_orders);
+  }
+
   Result<vector<NotificationGroupKey>> get_notification_groups_by_last_notification_date(
       NotificationGroupKey notification_group_key, int32 limit) override {
     auto &stmt = get_notification_groups_by_last_notification_date_stmt_;
@@ -249,6 +273,7 @@ class DialogDbImpl : public DialogDbSyncInterface {
   SqliteStatement delete_notification_group_stmt_;
   SqliteStatement get_dialog_stmt_;
   SqliteStatement get_dialogs_stmt_;
+  SqliteStatement get_dialog_order_index_stmt_;
   SqliteStatement get_notification_groups_by_last_notification_date_stmt_;
   SqliteStatement get_notification_group_stmt_;
 
@@ -308,6 +333,9 @@ class DialogDbAsync : public DialogDbAsyncInterface {
   void get_dialogs(int64 order, DialogId dialog_id, int32 limit, Promise<vector<BufferSlice>> promise) override {
     send_closure_later(impl_, &Impl::get_dialogs, order, dialog_id, limit, std::move(promise));
   }
+  void get_dialog_order_index(Promise<vector<DialogOrderInfo>> promise) override {
+    send_closure_later(impl_, &Impl::get_dialog_order_index, std::move(promise));
+  }
   void close(Promise<> promise) override {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -343,6 +371,10 @@ class DialogDbAsync : public DialogDbAsyncInterface {
       add_read_query();
       promise.set_result(sync_db_->get_dialogs(order, dialog_id, limit));
     }
+    void get_dialog_order_index(Promise<vector<DialogOrderInfo>> promise) {
+      add_read_query();
+      promise.set_result(sync_db_->get_dialog_order_index());
+    }
     void close(Promise<> promise) {
       do_flush();
       sync_db_safe_.reset();
@@ -24,6 +24,11 @@ namespace td {
 class SqliteConnectionSafe;
 class SqliteDb;
 
+struct DialogOrderInfo {
+  DialogId dialog_id;
+  int64 order = 0;
+};
+
 class DialogDbSyncInterface {
  public:
   DialogDbSyncInterface() = default;
@@ -38,6 +43,8 @@ class DialogDbSyncInterface {
 
   virtual Result<vector<BufferSlice>> get_dialogs(int64 order, DialogId dialog_id, int32 limit) = 0;
 
+  virtual Result<vector<DialogOrderInfo>> get_dialog_order_index() = 0;
+
   virtual Result<vector<NotificationGroupKey>> get_notification_groups_by_last_notification_date(
       NotificationGroupKey notification_group_key, int32 limit) = 0;
 
@@ -71,6 +78,8 @@ class DialogDbAsyncInterface {
 
   virtual void get_dialogs(int64 order, DialogId dialog_id, int32 limit, Promise<vector<BufferSlice>> promise) = 0;
 
+  virtual void get_dialog_order_index(Promise<vector<DialogOrderInfo>> promise) = 0;
+
   virtual void get_notification_groups_by_last_notification_date(NotificationGroupKey notification_group_key,
                                                                  int32 limit,
                                                                  Promise<vector<NotificationGroupKey>> promise) = 0;
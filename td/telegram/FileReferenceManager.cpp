@@ -19,6 +19,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/overloaded.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
@@ -188,20 +189,28 @@ void FileReferenceManager::run_node(NodeId node_id) {
     node.query = {};
     return;
   }
-  if (!node.file_source_ids.has_next()) {
-    VLOG(file_references) << "Have no more file sources to repair file reference for file " << node_id;
-    for (auto &p : node.query->promises) {
-      if (node.file_source_ids.empty()) {
-        p.set_error(Status::Error(400, "File source is not found"));
-      } else {
-        p.set_error(Status::Error(429, "Too Many Requests: retry after 1"));
+  while (node.file_source_ids.has_next()) {
+    auto file_source_id = node.file_source_ids.next();
+    auto cached_failure_it = source_failure_expires_at_.find(file_source_id.get());
+    if (cached_failure_it != source_failure_expires_at_.end()) {
+      if (cached_failure_it->second > Time::now()) {
+        VLOG(file_references) << "Skip recently failed " << file_source_id << " for file " << node_id;
+        continue;
       }
+      source_failure_expires_at_.erase(cached_failure_it);
     }
-    node.query = {};
+    send_query({node_id, node.query->generation}, file_source_id);
     return;
   }
-  auto file_source_id = node.file_source_ids.next();
-  send_query({node_id, node.query->generation}, file_source_id);
+  VLOG(file_references) << "Have no more file sources to repair file reference for file " << node_id;
+  for (auto &p : node.query->promises) {
+    if (node.file_source_ids.empty()) {
+      p.set_error(Status::Error(400, "File source is not found"));
+    } else {
+      p.set_error(Status::Error(429, "Too Many Requests: retry after 1"));
+    }
+  }
+  node.query = {};
 }
 
 void FileReferenceManager::send_query(Destination dest, FileSourceId file_source_id) {
@@ -210,43 +219,30 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
   auto &node = nodes_[dest.node_id];
   node.query->active_queries++;
 
-  auto promise = PromiseCreator::lambda([dest, file_source_id, file_reference_manager = G()->file_reference_manager(),
-                                         file_manager = G()->file_manager()](Result<Unit> result) mutable {
-    if (G()->close_flag()) {
-      VLOG(file_references) << "Ignore file reference repair from " << file_source_id << " during closing";
-      return;
-    }
+  auto &waiting_destinations = source_destinations_[file_source_id.get()];
+  waiting_destinations.push_back(dest);
+  if (waiting_destinations.size() > 1) {
+    // an identical source fetch is already in flight; its result will be fanned out
+    // to all files repaired from the source
+    VLOG(file_references) << "Merge repair query for file " << dest.node_id << " into a pending query from "
+                          << file_source_id;
+    return;
+  }
 
-    auto new_promise =
-        PromiseCreator::lambda([dest, file_source_id, file_reference_manager](Result<Unit> result) mutable {
-          if (G()->close_flag()) {
-            VLOG(file_references) << "Ignore file reference repair from " << file_source_id << " during closing";
-            return;
-          }
-
-          Status status;
-          if (result.is_error()) {
-            status = result.move_as_error();
-          }
-          send_closure(file_reference_manager, &FileReferenceManager::on_query_result, dest, file_source_id,
-                       std::move(status), 0);
-        });
-
-    send_lambda(file_manager, [file_manager, dest, result = std::move(result), file_source_id,
-                               new_promise = std::move(new_promise)]() mutable {
-      auto view = file_manager.get_actor_unsafe()->get_file_view(dest.node_id);
-      CHECK(!view.empty());
-      if (result.is_ok() &&
-          (!view.has_active_upload_remote_location() || !view.has_active_download_remote_location())) {
-        result = Status::Error("No active remote location");
-      }
-      if (result.is_error() && result.error().code() != 429 && result.error().code() < 500) {
-        VLOG(file_references) << "Invalid " << file_source_id << " " << result.error();
-        file_manager.get_actor_unsafe()->remove_file_source(dest.node_id, file_source_id);
-      }
-      new_promise.set_result(std::move(result));
-    });
-  });
+  auto promise = PromiseCreator::lambda(
+      [file_source_id, file_reference_manager = G()->file_reference_manager()](Result<Unit> result) {
+        if (G()->close_flag()) {
+          VLOG(file_references) << "Ignore file reference repair from " << file_source_id << " during closing";
+          return;
+        }
+
+        Status status;
+        if (result.is_error()) {
+          status = result.move_as_error();
+        }
+        send_closure(file_reference_manager, &FileReferenceManager::on_source_query_result, file_source_id,
+                     std::move(status));
+      });
   auto index = static_cast<size_t>(file_source_id.get()) - 1;
   CHECK(index < file_sources_.size());
   file_sources_[index].visit(overloaded(
@@ -284,6 +280,62 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
       }));
 }
 
+void FileReferenceManager::on_source_query_result(FileSourceId file_source_id, Status status) {
+  auto it = source_destinations_.find(file_source_id.get());
+  CHECK(it != source_destinations_.end());
+  auto destinations = std::move(it->second);
+  source_destinations_.erase(it);
+
+  if (status.is_error() && status.code() != 429 && status.code() < 500) {
+    // the source itself is gone; remember the failure, so subsequent repairs of other
+    // files from the source can be failed locally while the entry is fresh
+    source_failure_expires_at_[file_source_id.get()] = Time::now() + SOURCE_FAILURE_CACHE_TTL;
+  } else if (status.is_ok()) {
+    source_failure_expires_at_.erase(file_source_id.get());
+  }
+
+  for (auto &dest : destinations) {
+    check_file_and_finish_query(dest, file_source_id, status.clone());
+  }
+}
+
+void FileReferenceManager::check_file_and_finish_query(Destination dest, FileSourceId file_source_id, Status status) {
+  auto new_promise =
+      PromiseCreator::lambda([dest, file_source_id, file_reference_manager = G()->file_reference_manager()](
+                                 Result<Unit> result) mutable {
+        if (G()->close_flag()) {
+          VLOG(file_references) << "Ignore file reference repair from " << file_source_id << " during closing";
+          return;
+        }
+
+        Status status;
+        if (result.is_error()) {
+          status = result.move_as_error();
+        }
+        send_closure(file_reference_manager, &FileReferenceManager::on_query_result, dest, file_source_id,
+                     std::move(status), 0);
+      });
+
+  auto file_manager = G()->file_manager();
+  send_lambda(file_manager, [file_manager, dest, file_source_id, status = std::move(status),
+                             new_promise = std::move(new_promise)]() mutable {
+    Result<Unit> result = Unit();
+    if (status.is_error()) {
+      result = std::move(status);
+    }
+    auto view = file_manager.get_actor_unsafe()->get_file_view(dest.node_id);
+    CHECK(!view.empty());
+    if (result.is_ok() && (!view.has_active_upload_remote_location() || !view.has_active_download_remote_location())) {
+      result = Status::Error("No active remote location");
+    }
+    if (result.is_error() && result.error().code() != 429 && result.error().code() < 500) {
+      VLOG(file_references) << "Invalid " << file_source_id << " " << result.error();
+      file_manager.get_actor_unsafe()->remove_file_source(dest.node_id, file_source_id);
+    }
+    new_promise.set_result(std::move(result));
+  });
+}
+
 FileReferenceManager::Destination FileReferenceManager::on_query_result(Destination dest, FileSourceId file_source_id,
                                                                         Status status, int32 sub) {
   VLOG(file_references) << "Receive result of file references repair query for file " << dest.node_id
@@ -121,8 +121,19 @@ class FileReferenceManager : public Actor {
 
   std::unordered_map<NodeId, Node, FileIdHash> nodes_;
 
+  // sources which recently failed to provide a valid file reference; repairs from them
+  // are short-circuited locally until the entry expires
+  static constexpr double SOURCE_FAILURE_CACHE_TTL = 300;
+  std::unordered_map<int32, double> source_failure_expires_at_;
+
+  // files waiting for an already in-flight repair of the same source; the result of
+  // the single source fetch is fanned out to all of them
+  std::unordered_map<int32, vector<Destination>> source_destinations_;
+
   void run_node(NodeId node);
   void send_query(Destination dest, FileSourceId file_source_id);
+  void on_source_query_result(FileSourceId file_source_id, Status status);
+  void check_file_and_finish_query(Destination dest, FileSourceId file_source_id, Status status);
   Destination on_query_result(Destination dest, FileSourceId file_source_id, Status status, int32 sub = 0);
 
   template <class T>
@@ -54,13 +54,6 @@ void Global::set_temp_auth_key_watchdog(ActorOwn<TempAuthKeyWatchdog> actor) {
   temp_auth_key_watchdog_ = std::move(actor);
 }
 
-MtprotoHeader &Global::mtproto_header() {
-  return *mtproto_header_;
-}
-void Global::set_mtproto_header(unique_ptr<MtprotoHeader> mtproto_header) {
-  mtproto_header_ = std::move(mtproto_header);
-}
-
 Status Global::init(const TdParameters &parameters, ActorId<Td> td, unique_ptr<TdDb> td_db_ptr) {
   parameters_ = parameters;
 
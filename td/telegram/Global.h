@@ -273,10 +273,27 @@ class Global : public ActorContext {
   ActorId<TempAuthKeyWatchdog> temp_auth_key_watchdog() const;
   void set_temp_auth_key_watchdog(ActorOwn<TempAuthKeyWatchdog> actor);
 
-  MtprotoHeader &mtproto_header();
-  void set_mtproto_header(unique_ptr<MtprotoHeader> mtproto_header);
-  bool have_mtproto_header() const {
-    return mtproto_header_ != nullptr;
+  // the header is published as an immutable snapshot, which can be read from any scheduler
+  // with one atomic load; writers install a new header instead of mutating the current one
+  std::shared_ptr<const MtprotoHeader> mtproto_header() {
+#if !TD_HAVE_ATOMIC_SHARED_PTR
+    std::lock_guard<std::mutex> guard(mtproto_header_mutex_);
+    auto res = mtproto_header_;
+    return res;
+#else
+    return atomic_load(&mtproto_header_);
+#endif
+  }
+  void set_mtproto_header(std::shared_ptr<const MtprotoHeader> mtproto_header) {
+#if !TD_HAVE_ATOMIC_SHARED_PTR
+    std::lock_guard<std::mutex> guard(mtproto_header_mutex_);
+    mtproto_header_ = std::move(mtproto_header);
+#else
+    atomic_store(&mtproto_header_, std::move(mtproto_header));
+#endif
+  }
+  bool have_mtproto_header() {
+    return mtproto_header() != nullptr;
   }
 
   const TdParameters &parameters() const {
@@ -302,6 +319,7 @@ class Global : public ActorContext {
 
 #if !TD_HAVE_ATOMIC_SHARED_PTR
   std::mutex dh_config_mutex_;
+  std::mutex mtproto_header_mutex_;
 #endif
 
   std::shared_ptr<DhConfig> get_dh_config() {
@@ -375,7 +393,7 @@ class Global : public ActorContext {
   ActorOwn<ConnectionCreator> connection_creator_;
   ActorOwn<TempAuthKeyWatchdog> temp_auth_key_watchdog_;
 
-  unique_ptr<MtprotoHeader> mtproto_header_;
+  std::shared_ptr<const MtprotoHeader> mtproto_header_;
 
   TdParameters parameters_;
   int32 gc_scheduler_id_;
@@ -638,22 +638,32 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
     return true;
   }
 
-  bool have_all = true;
+  vector<Slice> database_keys;
   for (auto &key : keys) {
     if (!language_has_string_unsafe(language, key)) {
-      auto value = language->kv_.get(key);
-      if (value.empty()) {
-        if (language->version_ == -1) {
-          LOG(DEBUG) << "Have no string with key " << key << " in the database";
-          have_all = false;
-          continue;
-        }
+      database_keys.push_back(key);
+    }
+  }
+  if (database_keys.empty()) {
+    return true;
+  }
 
-        // have full language in the database, so this string is just deleted
+  bool have_all = true;
+  auto values = language->kv_.get_many(database_keys);
+  for (size_t i = 0; i < database_keys.size(); i++) {
+    auto key = database_keys[i].str();
+    auto &value = values[i];
+    if (value.empty()) {
+      if (language->version_ == -1) {
+        LOG(DEBUG) << "Have no string with key " << key << " in the database";
+        have_all = false;
+        continue;
       }
-      LOG(DEBUG) << "Load string with key " << key << " from database";
-      load_language_string_unsafe(language, key, value);
+
+      // have full language in the database, so this string is just deleted
     }
+    LOG(DEBUG) << "Load string with key " << key << " from database";
+    load_language_string_unsafe(language, key, value);
   }
   return have_all;
 }
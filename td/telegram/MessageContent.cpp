@@ -71,17 +71,22 @@
 #include "td/utils/tl_helpers.h"
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 
 namespace td {
 
 class MessageText : public MessageContent {
  public:
-  FormattedText text;
+  // the text is never modified after creation: edits replace the whole content.
+  // It is shared between copies of the message created for forwards and resends,
+  // so a fan-out of one message to N dialogs costs one allocation instead of N
+  std::shared_ptr<const FormattedText> text;
   WebPageId web_page_id;
 
   MessageText() = default;
-  MessageText(FormattedText text, WebPageId web_page_id) : text(std::move(text)), web_page_id(web_page_id) {
+  MessageText(FormattedText text, WebPageId web_page_id)
+      : text(std::make_shared<const FormattedText>(std::move(text))), web_page_id(web_page_id) {
   }
 
   MessageContentType get_type() const override {
@@ -805,7 +810,7 @@ static void store(const MessageContent *content, StorerT &storer) {
     }
     case MessageContentType::Text: {
       auto m = static_cast<const MessageText *>(content);
-      store(m->text, storer);
+      store(*m->text, storer);
       store(m->web_page_id, storer);
       break;
     }
@@ -1097,7 +1102,9 @@ static void parse(unique_ptr<MessageContent> &content, ParserT &parser) {
     }
     case MessageContentType::Text: {
       auto m = make_unique<MessageText>();
-      parse(m->text, parser);
+      FormattedText text;
+      parse(text, parser);
+      m->text = std::make_shared<const FormattedText>(std::move(text));
       parse(m->web_page_id, parser);
       content = std::move(m);
       break;
@@ -2339,7 +2346,7 @@ bool can_forward_message_content(const MessageContent *content) {
   auto content_type = content->get_type();
   if (content_type == MessageContentType::Text) {
     auto *text = static_cast<const MessageText *>(content);
-    return !is_empty_string(text->text.text);  // text can't be empty in the new message
+    return !is_empty_string(text->text->text);  // text can't be empty in the new message
   }
   if (content_type == MessageContentType::Poll) {
     auto *poll = static_cast<const MessagePoll *>(content);
@@ -2545,7 +2552,7 @@ int32 get_message_content_index_mask(const MessageContent *content, const Td *td
       return search_messages_filter_index_mask(SearchMessagesFilter::Photo) |
              search_messages_filter_index_mask(SearchMessagesFilter::PhotoAndVideo);
     case MessageContentType::Text:
-      for (auto &entity : static_cast<const MessageText *>(content)->text.entities) {
+      for (auto &entity : static_cast<const MessageText *>(content)->text->entities) {
         if (entity.type == MessageEntity::Type::Url || entity.type == MessageEntity::Type::EmailAddress ||
             entity.type == MessageEntity::Type::TextUrl) {
           return search_messages_filter_index_mask(SearchMessagesFilter::Url);
@@ -2708,19 +2715,20 @@ static void merge_location_access_hash(const Location &first, const Location &se
 }
 
 static bool need_message_text_changed_warning(const MessageText *old_content, const MessageText *new_content) {
-  if (new_content->text.text == "Unsupported characters" ||
-      new_content->text.text == "This channel is blocked because it was used to spread pornographic content.") {
+  if (new_content->text->text == "Unsupported characters" ||
+      new_content->text->text == "This channel is blocked because it was used to spread pornographic content.") {
     // message contained unsupported characters, text is replaced
     return false;
   }
-  if (/* old_message->message_id.is_yet_unsent() && */ !old_content->text.entities.empty() &&
-      old_content->text.entities[0].offset == 0 &&
-      (new_content->text.entities.empty() || new_content->text.entities[0].offset != 0) &&
-      old_content->text.text != new_content->text.text && ends_with(old_content->text.text, new_content->text.text)) {
+  if (/* old_message->message_id.is_yet_unsent() && */ !old_content->text->entities.empty() &&
+      old_content->text->entities[0].offset == 0 &&
+      (new_content->text->entities.empty() || new_content->text->entities[0].offset != 0) &&
+      old_content->text->text != new_content->text->text &&
+      ends_with(old_content->text->text, new_content->text->text)) {
     // server has deleted first entity and ltrim the message
     return false;
   }
-  for (auto &entity : new_content->text.entities) {
+  for (auto &entity : new_content->text->entities) {
     if (entity.type == MessageEntity::Type::PhoneNumber) {
       // TODO remove after find_phone_numbers is implemented
       return false;
@@ -2739,7 +2747,7 @@ void merge_message_contents(Td *td, const MessageContent *old_content, MessageCo
     case MessageContentType::Text: {
       auto old_ = static_cast<const MessageText *>(old_content);
       auto new_ = static_cast<const MessageText *>(new_content);
-      if (old_->text.text != new_->text.text) {
+      if (old_->text->text != new_->text->text) {
         if (need_message_changed_warning && need_message_text_changed_warning(old_, new_)) {
           LOG(ERROR) << "Message text has changed from "
                      << to_string(get_message_content_object(old_content, td, -1, false)) << ". New content is "
@@ -2747,10 +2755,10 @@ void merge_message_contents(Td *td, const MessageContent *old_content, MessageCo
         }
         need_update = true;
       }
-      if (old_->text.entities != new_->text.entities) {
+      if (old_->text->entities != new_->text->entities) {
         const int32 MAX_CUSTOM_ENTITIES_COUNT = 100;  // server-side limit
         if (need_message_changed_warning && need_message_text_changed_warning(old_, new_) &&
-            old_->text.entities.size() <= MAX_CUSTOM_ENTITIES_COUNT) {
+            old_->text->entities.size() <= MAX_CUSTOM_ENTITIES_COUNT) {
           LOG(WARNING) << "Entities has changed from "
                        << to_string(get_message_content_object(old_content, td, -1, false)) << ". New content is "
                        << to_string(get_message_content_object(new_content, td, -1, false));
@@ -4086,6 +4094,24 @@ unique_ptr<MessageContent> dup_message_content(Td *td, DialogId dialog_id, const
   return nullptr;
 }
 
+unique_ptr<MessageContent> dup_message_content(Td *td, DialogId dialog_id, unique_ptr<MessageContent> &&content,
+                                               bool for_forward) {
+  CHECK(content != nullptr);
+  switch (content->get_type()) {
+    case MessageContentType::Contact:
+    case MessageContentType::Game:
+    case MessageContentType::Invoice:
+    case MessageContentType::Location:
+    case MessageContentType::Poll:
+    case MessageContentType::Text:
+    case MessageContentType::Venue:
+      // there are no file identifiers to fix, so dup_message_content would create an exact copy
+      return std::move(content);
+    default:
+      return dup_message_content(td, dialog_id, content.get(), for_forward);
+  }
+}
+
 unique_ptr<MessageContent> get_action_message_content(Td *td, tl_object_ptr<telegram_api::MessageAction> &&action,
                                                       DialogId owner_dialog_id, MessageId reply_to_message_id) {
   CHECK(action != nullptr);
@@ -4326,7 +4352,7 @@ tl_object_ptr<td_api::MessageContent> get_message_content_object(const MessageCo
     }
     case MessageContentType::Text: {
       const MessageText *m = static_cast<const MessageText *>(content);
-      return make_tl_object<td_api::messageText>(get_formatted_text_object(m->text),
+      return make_tl_object<td_api::messageText>(get_formatted_text_object(*m->text),
                                                  td->web_pages_manager_->get_web_page_object(m->web_page_id));
     }
     case MessageContentType::Unsupported:
@@ -4461,7 +4487,7 @@ tl_object_ptr<td_api::MessageContent> get_message_content_object(const MessageCo
 const FormattedText *get_message_content_text(const MessageContent *content) {
   switch (content->get_type()) {
     case MessageContentType::Text:
-      return &static_cast<const MessageText *>(content)->text;
+      return static_cast<const MessageText *>(content)->text.get();
     case MessageContentType::Game:
       return &static_cast<const MessageGame *>(content)->game.get_text();
     default:
@@ -4667,9 +4693,10 @@ string get_message_content_search_text(const Td *td, const MessageContent *conte
     case MessageContentType::Text: {
       auto *text = static_cast<const MessageText *>(content);
       if (!text->web_page_id.is_valid()) {
-        return text->text.text;
+        return text->text->text;
       }
-      return PSTRING() << text->text.text << " " << td->web_pages_manager_->get_web_page_search_text(text->web_page_id);
+      return PSTRING() << text->text->text << " "
+                       << td->web_pages_manager_->get_web_page_search_text(text->web_page_id);
     }
     case MessageContentType::Animation: {
       auto animation = static_cast<const MessageAnimation *>(content);
@@ -213,6 +213,11 @@ unique_ptr<MessageContent> get_message_content(Td *td, FormattedText message_tex
 unique_ptr<MessageContent> dup_message_content(Td *td, DialogId dialog_id, const MessageContent *content,
                                                bool for_forward);
 
+// can be used instead of dup_message_content when the old content isn't needed anymore;
+// avoids copying the text and entities of contents without files
+unique_ptr<MessageContent> dup_message_content(Td *td, DialogId dialog_id, unique_ptr<MessageContent> &&content,
+                                               bool for_forward);
+
 unique_ptr<MessageContent> get_action_message_content(Td *td, tl_object_ptr<telegram_api::MessageAction> &&action,
                                                       DialogId owner_dialog_id, MessageId reply_to_message_id);
 
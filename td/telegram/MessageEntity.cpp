@@ -1046,17 +1046,47 @@ static void fix_entities(vector<MessageEntity> &entities) {
   entities.erase(entities.begin() + left_entities, entities.end());
 }
 
+// finds in one pass all characters, which can begin an entity; each match_* function starts its
+// candidates from one such character, so it can be skipped if the character isn't in the text at all.
+// The loop body is branchless, so compilers can vectorize it
+struct EntityPrefixes {
+  bool has_at = false;      // '@', mentions
+  bool has_slash = false;   // '/', bot commands
+  bool has_hash = false;    // '#', hashtags
+  bool has_dollar = false;  // '$', cashtags
+  bool has_dot = false;     // '.', URLs and email addresses
+};
+
+static EntityPrefixes scan_entity_prefixes(Slice str) {
+  EntityPrefixes result;
+  const unsigned char *ptr = str.ubegin();
+  const unsigned char *end = str.uend();
+  for (; ptr != end; ptr++) {
+    auto c = *ptr;
+    result.has_at |= c == '@';
+    result.has_slash |= c == '/';
+    result.has_hash |= c == '#';
+    result.has_dollar |= c == '$';
+    result.has_dot |= c == '.';
+  }
+  return result;
+}
+
 vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool only_urls) {
   vector<MessageEntity> entities;
 
+  auto prefixes = scan_entity_prefixes(text);
+
   if (!only_urls) {
-    auto mentions = find_mentions(text);
-    for (auto &mention : mentions) {
-      entities.emplace_back(MessageEntity::Type::Mention, narrow_cast<int32>(mention.begin() - text.begin()),
-                            narrow_cast<int32>(mention.size()));
+    if (prefixes.has_at) {
+      auto mentions = find_mentions(text);
+      for (auto &mention : mentions) {
+        entities.emplace_back(MessageEntity::Type::Mention, narrow_cast<int32>(mention.begin() - text.begin()),
+                              narrow_cast<int32>(mention.size()));
+      }
     }
 
-    if (!skip_bot_commands) {
+    if (!skip_bot_commands && prefixes.has_slash) {
       auto bot_commands = find_bot_commands(text);
       for (auto &bot_command : bot_commands) {
         entities.emplace_back(MessageEntity::Type::BotCommand, narrow_cast<int32>(bot_command.begin() - text.begin()),
@@ -1064,22 +1094,26 @@ vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool onl
       }
     }
 
-    auto hashtags = find_hashtags(text);
-    for (auto &hashtag : hashtags) {
-      entities.emplace_back(MessageEntity::Type::Hashtag, narrow_cast<int32>(hashtag.begin() - text.begin()),
-                            narrow_cast<int32>(hashtag.size()));
+    if (prefixes.has_hash) {
+      auto hashtags = find_hashtags(text);
+      for (auto &hashtag : hashtags) {
+        entities.emplace_back(MessageEntity::Type::Hashtag, narrow_cast<int32>(hashtag.begin() - text.begin()),
+                              narrow_cast<int32>(hashtag.size()));
+      }
     }
 
-    auto cashtags = find_cashtags(text);
-    for (auto &cashtag : cashtags) {
-      entities.emplace_back(MessageEntity::Type::Cashtag, narrow_cast<int32>(cashtag.begin() - text.begin()),
-                            narrow_cast<int32>(cashtag.size()));
+    if (prefixes.has_dollar) {
+      auto cashtags = find_cashtags(text);
+      for (auto &cashtag : cashtags) {
+        entities.emplace_back(MessageEntity::Type::Cashtag, narrow_cast<int32>(cashtag.begin() - text.begin()),
+                              narrow_cast<int32>(cashtag.size()));
+      }
     }
 
     // TODO find_phone_numbers
   }
 
-  auto urls = find_urls(text);
+  auto urls = prefixes.has_dot ? find_urls(text) : vector<std::pair<Slice, bool>>();
   for (auto &url : urls) {
     // TODO better find messageEntityUrl
     auto type = url.second ? MessageEntity::Type::EmailAddress : MessageEntity::Type::Url;
@@ -1098,37 +1132,23 @@ vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool onl
   fix_entities(entities);
 
   // fix offsets to utf16 offsets
-  const unsigned char *begin = text.ubegin();
-  const unsigned char *ptr = begin;
+  // entities are sorted and non-intersecting after fix_entities, so each gap between
+  // boundaries is counted exactly once
+  const unsigned char *ptr = text.ubegin();
   const unsigned char *end = text.uend();
 
   int32 utf16_pos = 0;
   for (auto &entity : entities) {
-    int cnt = 2;
-    auto entity_begin = entity.offset;
-    auto entity_end = entity.offset + entity.length;
-
-    int32 pos = static_cast<int32>(ptr - begin);
-    if (entity_begin == pos) {
-      cnt--;
-      entity.offset = utf16_pos;
-    }
-
-    while (ptr != end && cnt > 0) {
-      unsigned char c = ptr[0];
-      utf16_pos += 1 + (c >= 0xf0);
-      ptr = next_utf8_unsafe(ptr, nullptr, "match_urls 8");
-
-      pos = static_cast<int32>(ptr - begin);
-      if (entity_begin == pos) {
-        cnt--;
-        entity.offset = utf16_pos;
-      } else if (entity_end == pos) {
-        cnt--;
-        entity.length = utf16_pos - entity.offset;
-      }
-    }
-    CHECK(cnt == 0);
+    auto entity_begin = text.ubegin() + entity.offset;
+    auto entity_end = entity_begin + entity.length;
+    CHECK(entity_begin == end || is_utf8_character_first_code_unit(*entity_begin));
+    CHECK(entity_end == end || is_utf8_character_first_code_unit(*entity_end));
+
+    utf16_pos += narrow_cast<int32>(utf8_utf16_length(Slice(ptr, entity_begin)));
+    entity.offset = utf16_pos;
+    utf16_pos += narrow_cast<int32>(utf8_utf16_length(Slice(entity_begin, entity_end)));
+    entity.length = utf16_pos - entity.offset;
+    ptr = entity_end;
   }
 
   return entities;
@@ -33,6 +33,7 @@
 #include <iterator>
 #include <limits>
 #include <tuple>
+#include <unordered_map>
 
 namespace td {
 
@@ -202,6 +203,10 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
         db_.get_statement("SELECT dialog_id, data, search_id FROM messages WHERE search_id IN (SELECT rowid FROM "
                           "messages_fts WHERE messages_fts MATCH ?1 AND rowid < ?2 ORDER BY rowid DESC LIMIT "
                           "?3) ORDER BY search_id DESC"));
+    TRY_RESULT(get_messages_fts_ranked_stmt,
+               db_.get_statement("SELECT messages.dialog_id, messages.data, messages.search_id FROM messages_fts "
+                                 "JOIN messages ON messages.search_id = messages_fts.rowid WHERE messages_fts "
+                                 "MATCH ?1 ORDER BY rank LIMIT ?2"));
 
     for (int32 i = 0; i < MESSAGES_DB_INDEX_COUNT; i++) {
       TRY_RESULT(get_messages_from_index_desc_stmt,
@@ -246,6 +251,7 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
     get_messages_from_notification_id_stmt_ = std::move(get_messages_from_notification_id_stmt);
 
     get_messages_fts_stmt_ = std::move(get_messages_fts_stmt);
+    get_messages_fts_ranked_stmt_ = std::move(get_messages_fts_ranked_stmt);
 
     // LOG(ERROR) << get_message_stmt_.explain().ok();
     // LOG(ERROR) << get_messages_from_notification_id_stmt.explain().ok();
@@ -557,6 +563,18 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
     return std::move(result);
   }
 
+  Result<unique_ptr<MessagesDbHistoryCursor>> get_history_cursor(DialogId dialog_id, MessageId from_message_id,
+                                                                 bool is_descending) override {
+    LOG_CHECK(dialog_id.is_valid()) << dialog_id;
+    TRY_RESULT(stmt, db_.get_statement(is_descending ? CSlice("SELECT data FROM messages WHERE dialog_id = ?1 AND "
+                                                              "message_id < ?2 ORDER BY message_id DESC")
+                                                     : CSlice("SELECT data FROM messages WHERE dialog_id = ?1 AND "
+                                                              "message_id > ?2 ORDER BY message_id")));
+    stmt.bind_int64(1, dialog_id.get()).ensure();
+    stmt.bind_int64(2, from_message_id.get()).ensure();
+    return unique_ptr<MessagesDbHistoryCursor>(make_unique<HistoryCursor>(std::move(stmt)));
+  }
+
   static string prepare_query(Slice query) {
     auto is_word_character = [](uint32 a) {
       switch (get_unicode_simple_category(a)) {
@@ -605,12 +623,14 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
   }
 
   Result<MessagesDbFtsResult> get_messages_fts(MessagesDbFtsQuery query) override {
+    auto &stmt = query.is_ranked ? get_messages_fts_ranked_stmt_ : get_messages_fts_stmt_;
     SCOPE_EXIT {
-      get_messages_fts_stmt_.reset();
+      stmt.reset();
     };
 
     LOG(INFO) << tag("query", query.query) << query.dialog_id << tag("index_mask", query.index_mask)
-              << tag("from_search_id", query.from_search_id) << tag("limit", query.limit);
+              << tag("from_search_id", query.from_search_id) << tag("limit", query.limit)
+              << tag("is_ranked", query.is_ranked);
     string words = prepare_query(query.query);
     LOG(INFO) << tag("from", query.query) << tag("to", words);
 
@@ -634,13 +654,16 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
       words += PSTRING() << " \"\a\a" << index_i << "\"";
     }
 
-    auto &stmt = get_messages_fts_stmt_;
     stmt.bind_string(1, words).ensure();
-    if (query.from_search_id == 0) {
-      query.from_search_id = std::numeric_limits<int64>::max();
+    if (query.is_ranked) {
+      stmt.bind_int32(2, query.limit).ensure();
+    } else {
+      if (query.from_search_id == 0) {
+        query.from_search_id = std::numeric_limits<int64>::max();
+      }
+      stmt.bind_int64(2, query.from_search_id).ensure();
+      stmt.bind_int32(3, query.limit).ensure();
     }
-    stmt.bind_int64(2, query.from_search_id).ensure();
-    stmt.bind_int32(3, query.limit).ensure();
     MessagesDbFtsResult result;
     auto status = stmt.step();
     if (status.is_error()) {
@@ -651,7 +674,9 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
       auto dialog_id = stmt.view_int64(0);
       auto data_slice = stmt.view_blob(1);
       auto search_id = stmt.view_int64(2);
-      result.next_search_id = search_id;
+      if (!query.is_ranked) {
+        result.next_search_id = search_id;
+      }
       result.messages.push_back(MessagesDbMessage{DialogId(dialog_id), BufferSlice(data_slice)});
       stmt.step().ensure();
     }
@@ -726,6 +751,33 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
   }
 
  private:
+  class HistoryCursor : public MessagesDbHistoryCursor {
+   public:
+    explicit HistoryCursor(SqliteStatement stmt) : stmt_(std::move(stmt)) {
+    }
+    Result<std::vector<BufferSlice>> next_batch(size_t max_count) override {
+      std::vector<BufferSlice> result;
+      if (is_finished_) {
+        return std::move(result);
+      }
+      result.reserve(max_count);
+      while (result.size() < max_count) {
+        TRY_STATUS(stmt_.step());
+        if (!stmt_.has_row()) {
+          is_finished_ = true;
+          stmt_.reset();
+          break;
+        }
+        result.emplace_back(stmt_.view_blob(0));
+      }
+      return std::move(result);
+    }
+
+   private:
+    SqliteStatement stmt_;
+    bool is_finished_ = false;
+  };
+
   SqliteDb db_;
 
   SqliteStatement add_message_stmt_;
@@ -751,6 +803,7 @@ class MessagesDbImpl : public MessagesDbSyncInterface {
   std::array<SqliteStatement, 2> get_calls_stmts_;
 
   SqliteStatement get_messages_fts_stmt_;
+  SqliteStatement get_messages_fts_ranked_stmt_;
 
   Result<std::vector<BufferSlice>> get_messages_impl(GetMessagesStmt &stmt, DialogId dialog_id,
                                                      MessageId from_message_id, int32 offset, int32 limit) {
@@ -918,6 +971,17 @@ class MessagesDbAsync : public MessagesDbAsyncInterface {
     send_closure_later(impl_, &Impl::get_messages_from_notification_id, dialog_id, from_notification_id, limit,
                        std::move(promise));
   }
+  void get_history_cursor(DialogId dialog_id, MessageId from_message_id, bool is_descending, size_t batch_size,
+                          Promise<int64> promise) override {
+    send_closure_later(impl_, &Impl::get_history_cursor, dialog_id, from_message_id, is_descending, batch_size,
+                       std::move(promise));
+  }
+  void get_history_cursor_next_batch(int64 cursor_id, Promise<std::vector<BufferSlice>> promise) override {
+    send_closure_later(impl_, &Impl::get_history_cursor_next_batch, cursor_id, std::move(promise));
+  }
+  void close_history_cursor(int64 cursor_id) override {
+    send_closure_later(impl_, &Impl::close_history_cursor, cursor_id);
+  }
   void get_calls(MessagesDbCallsQuery query, Promise<MessagesDbCallsResult> promise) override {
     send_closure_later(impl_, &Impl::get_calls, std::move(query), std::move(promise));
   }
@@ -995,6 +1059,45 @@ class MessagesDbAsync : public MessagesDbAsyncInterface {
       add_read_query();
       promise.set_result(sync_db_->get_messages_from_notification_id(dialog_id, from_notification_id, limit));
     }
+    void get_history_cursor(DialogId dialog_id, MessageId from_message_id, bool is_descending, size_t batch_size,
+                            Promise<int64> promise) {
+      add_read_query();
+      auto r_cursor = sync_db_->get_history_cursor(dialog_id, from_message_id, is_descending);
+      if (r_cursor.is_error()) {
+        return promise.set_error(r_cursor.move_as_error());
+      }
+      auto cursor_id = ++history_cursor_id_;
+      auto &cursor = history_cursors_[cursor_id];
+      cursor.cursor_ = r_cursor.move_as_ok();
+      cursor.batch_size_ = max(batch_size, static_cast<size_t>(1));
+      promise.set_value(std::move(cursor_id));
+      prefetch_history_batch(cursor);
+    }
+    void get_history_cursor_next_batch(int64 cursor_id, Promise<std::vector<BufferSlice>> promise) {
+      auto it = history_cursors_.find(cursor_id);
+      if (it == history_cursors_.end()) {
+        return promise.set_error(Status::Error("Unknown history cursor"));
+      }
+      auto &cursor = it->second;
+      if (cursor.status_.is_error()) {
+        promise.set_error(std::move(cursor.status_));
+        history_cursors_.erase(it);
+        return;
+      }
+      auto batch = std::move(cursor.prefetched_batch_);
+      cursor.prefetched_batch_.clear();
+      bool is_finished = batch.empty();
+      // answer first, so the consumer processes this batch while the next one is read
+      promise.set_value(std::move(batch));
+      if (is_finished) {
+        history_cursors_.erase(it);
+      } else {
+        prefetch_history_batch(cursor);
+      }
+    }
+    void close_history_cursor(int64 cursor_id) {
+      history_cursors_.erase(cursor_id);
+    }
     void get_calls(MessagesDbCallsQuery query, Promise<MessagesDbCallsResult> promise) {
       add_read_query();
       promise.set_result(sync_db_->get_calls(std::move(query)));
@@ -1011,6 +1114,7 @@ class MessagesDbAsync : public MessagesDbAsyncInterface {
 
     void close(Promise<> promise) {
       do_flush();
+      history_cursors_.clear();
       sync_db_safe_.reset();
       sync_db_ = nullptr;
       promise.set_value(Unit());
@@ -1029,6 +1133,25 @@ class MessagesDbAsync : public MessagesDbAsyncInterface {
     static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
     static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
     std::vector<Promise<>> pending_writes_;
+
+    struct HistoryCursorState {
+      unique_ptr<MessagesDbHistoryCursor> cursor_;
+      size_t batch_size_ = 0;
+      std::vector<BufferSlice> prefetched_batch_;
+      Status status_;
+    };
+    int64 history_cursor_id_ = 0;
+    std::unordered_map<int64, HistoryCursorState> history_cursors_;
+
+    void prefetch_history_batch(HistoryCursorState &cursor) {
+      auto r_batch = cursor.cursor_->next_batch(cursor.batch_size_);
+      if (r_batch.is_error()) {
+        cursor.status_ = r_batch.move_as_error();
+      } else {
+        cursor.prefetched_batch_ = r_batch.move_as_ok();
+      }
+    }
+
     double wakeup_at_ = 0;
     template <class F>
     void add_write_query(F &&f) {
@@ -64,12 +64,28 @@ struct MessagesDbFtsQuery {
   int32 index_mask{0};
   int64 from_search_id{0};
   int32 limit{100};
+  // if set, the best bm25 matches are returned instead of the most recent ones;
+  // ranked results can't be continued by from_search_id
+  bool is_ranked{false};
 };
 struct MessagesDbFtsResult {
   std::vector<MessagesDbMessage> messages;
   int64 next_search_id{1};
 };
 
+// yields the history of a dialog in batches from one open statement, so a long
+// export doesn't re-seek the message index for every batch
+class MessagesDbHistoryCursor {
+ public:
+  MessagesDbHistoryCursor() = default;
+  MessagesDbHistoryCursor(const MessagesDbHistoryCursor &) = delete;
+  MessagesDbHistoryCursor &operator=(const MessagesDbHistoryCursor &) = delete;
+  virtual ~MessagesDbHistoryCursor() = default;
+
+  // returns up to max_count next messages; an empty result means the end of the history
+  virtual Result<std::vector<BufferSlice>> next_batch(size_t max_count) = 0;
+};
+
 struct MessagesDbCallsQuery {
   int32 index_mask{0};
   int32 from_unique_message_id{0};
@@ -105,6 +121,8 @@ class MessagesDbSyncInterface {
   virtual Result<vector<BufferSlice>> get_messages_from_notification_id(DialogId dialog_id,
                                                                         NotificationId from_notification_id,
                                                                         int32 limit) = 0;
+  virtual Result<unique_ptr<MessagesDbHistoryCursor>> get_history_cursor(DialogId dialog_id, MessageId from_message_id,
+                                                                         bool is_descending) = 0;
 
   virtual Result<std::pair<std::vector<std::pair<DialogId, BufferSlice>>, int32>> get_expiring_messages(
       int32 expires_from, int32 expires_till, int32 limit) = 0;
@@ -151,6 +169,13 @@ class MessagesDbAsyncInterface {
   virtual void get_messages_from_notification_id(DialogId dialog_id, NotificationId from_notification_id, int32 limit,
                                                  Promise<vector<BufferSlice>> promise) = 0;
 
+  // the cursor prefetches the next batch while the consumer processes the current one;
+  // a cursor which has returned an empty batch or an error is closed automatically
+  virtual void get_history_cursor(DialogId dialog_id, MessageId from_message_id, bool is_descending, size_t batch_size,
+                                  Promise<int64> promise) = 0;
+  virtual void get_history_cursor_next_batch(int64 cursor_id, Promise<std::vector<BufferSlice>> promise) = 0;
+  virtual void close_history_cursor(int64 cursor_id) = 0;
+
   virtual void get_calls(MessagesDbCallsQuery, Promise<MessagesDbCallsResult> promise) = 0;
   virtual void get_messages_fts(MessagesDbFtsQuery query, Promise<MessagesDbFtsResult> promise) = 0;
 
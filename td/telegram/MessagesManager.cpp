@@ -1780,7 +1780,8 @@ class SendMessageActor : public NetActorOnce {
         flags, false /*ignored*/, false /*ignored*/, false /*ignored*/, false /*ignored*/, std::move(input_peer),
         reply_to_message_id.get_server_message_id().get(), message, random_id, std::move(reply_markup),
         std::move(entities))));
-    if (G()->shared_config().get_option_boolean("use_quick_ack")) {
+    query->set_high_priority();
+    if (G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda(
           [random_id](Unit) {
             send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -1849,7 +1850,7 @@ class StartBotQuery : public Td::ResultHandler {
 
     auto query = G()->net_query_creator().create(create_storer(
         telegram_api::messages_startBot(std::move(bot_input_user), std::move(input_peer), random_id, parameter)));
-    if (G()->shared_config().get_option_boolean("use_quick_ack")) {
+    if (G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda(
           [random_id](Unit) {
             send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -1901,6 +1902,7 @@ class SendInlineBotResultQuery : public Td::ResultHandler {
     auto query = G()->net_query_creator().create(create_storer(telegram_api::messages_sendInlineBotResult(
         flags, false /*ignored*/, false /*ignored*/, false /*ignored*/, false /*ignored*/, std::move(input_peer),
         reply_to_message_id.get_server_message_id().get(), random_id, query_id, result_id)));
+    query->set_high_priority();
     auto send_query_ref = query.get_weak();
     send_query(std::move(query));
     return send_query_ref;
@@ -1957,7 +1959,8 @@ class SendMultiMediaActor : public NetActorOnce {
     auto query = G()->net_query_creator().create(create_storer(telegram_api::messages_sendMultiMedia(
         flags, false /*ignored*/, false /*ignored*/, false /*ignored*/, std::move(input_peer),
         reply_to_message_id.get_server_message_id().get(), std::move(input_single_media))));
-    if (G()->shared_config().get_option_boolean("use_quick_ack")) {
+    query->set_high_priority();
+    if (G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda(
           [random_ids = random_ids_](Unit) {
             for (auto random_id : random_ids) {
@@ -2081,7 +2084,8 @@ class SendMediaActor : public NetActorOnce {
                                              std::move(entities));
     LOG(INFO) << "Send media: " << to_string(request);
     auto query = G()->net_query_creator().create(create_storer(request));
-    if (G()->shared_config().get_option_boolean("use_quick_ack")) {
+    query->set_high_priority();
+    if (G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda(
           [random_id](Unit) {
             send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -2576,7 +2580,7 @@ class ForwardMessagesActor : public NetActorOnce {
     auto query = G()->net_query_creator().create(create_storer(telegram_api::messages_forwardMessages(
         flags, false /*ignored*/, false /*ignored*/, false /*ignored*/, false /*ignored*/, std::move(from_input_peer),
         MessagesManager::get_server_message_ids(message_ids), std::move(random_ids), std::move(to_input_peer))));
-    if (G()->shared_config().get_option_boolean("use_quick_ack")) {
+    if (G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda(
           [random_ids = random_ids_](Unit) {
             for (auto random_id : random_ids) {
@@ -5255,7 +5259,7 @@ void MessagesManager::on_update_include_sponsored_dialog_to_unread_count() {
     return;
   }
 
-  bool include_sponsored_dialog = G()->shared_config().get_option_boolean("include_sponsored_chat_to_unread_count");
+  bool include_sponsored_dialog = G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::IncludeSponsoredChatToUnreadCount);
   if (include_sponsored_dialog_to_unread_count_ == include_sponsored_dialog) {
     return;
   }
@@ -5555,7 +5559,7 @@ void MessagesManager::add_pending_channel_update(DialogId dialog_id, tl_object_p
 
   if (d == nullptr || pts_count > 0) {
     process_channel_update(std::move(update));
-    LOG_CHECK(!running_get_channel_difference(dialog_id)) << '"' << active_get_channel_differencies_[dialog_id] << '"';
+    LOG_CHECK(!running_get_channel_difference(dialog_id)) << '"' << get_channel_difference_source(dialog_id) << '"';
   } else {
     LOG_IF(INFO, update->get_id() != dummyUpdate::ID)
         << "Skip useless channel update from " << source << ": " << to_string(update);
@@ -5805,6 +5809,38 @@ bool MessagesManager::update_dialog_notification_settings(DialogId dialog_id,
   return need_update_server;
 }
 
+template <class F>
+void MessagesManager::for_each_dialog_in_notification_scope(NotificationSettingsScope scope, F &&callback) {
+  for (auto &dialog : dialogs_) {
+    auto dialog_id = dialog.first;
+    // the scope is determined by the type of the dialog identifier, so dialogs
+    // from other scopes are skipped without touching the Dialog itself
+    switch (dialog_id.get_type()) {
+      case DialogType::User:
+      case DialogType::SecretChat:
+        if (scope != NotificationSettingsScope::Private) {
+          continue;
+        }
+        break;
+      case DialogType::Chat:
+        if (scope != NotificationSettingsScope::Group) {
+          continue;
+        }
+        break;
+      case DialogType::Channel:
+        if (scope == NotificationSettingsScope::Private ||
+            get_dialog_notification_setting_scope(dialog_id) != scope) {
+          continue;
+        }
+        break;
+      case DialogType::None:
+      default:
+        continue;
+    }
+    callback(dialog.second.get());
+  }
+}
+
 bool MessagesManager::update_scope_notification_settings(NotificationSettingsScope scope,
                                                          ScopeNotificationSettings *current_settings,
                                                          const ScopeNotificationSettings &new_settings) {
@@ -5825,30 +5861,27 @@ bool MessagesManager::update_scope_notification_settings(NotificationSettingsSco
 
     update_scope_unmute_timeout(scope, current_settings->mute_until, new_settings.mute_until);
 
-    if (!current_settings->disable_pinned_message_notifications && new_settings.disable_pinned_message_notifications) {
-      VLOG(notifications) << "Remove pinned message notifications in " << scope;
-      for (auto &dialog : dialogs_) {
-        Dialog *d = dialog.second.get();
-        if (d->notification_settings.use_default_disable_pinned_message_notifications &&
-            d->mention_notification_group.group_id.is_valid() && d->pinned_message_notification_message_id.is_valid() &&
-            get_dialog_notification_setting_scope(d->dialog_id) == scope) {
+    bool need_remove_pinned_message_notifications =
+        !current_settings->disable_pinned_message_notifications && new_settings.disable_pinned_message_notifications;
+    bool need_update_mention_notifications =
+        current_settings->disable_mention_notifications != new_settings.disable_mention_notifications;
+    if (need_remove_pinned_message_notifications || need_update_mention_notifications) {
+      VLOG(notifications) << "Update message notifications in " << scope;
+      for_each_dialog_in_notification_scope(scope, [&](Dialog *d) {
+        if (need_remove_pinned_message_notifications &&
+            d->notification_settings.use_default_disable_pinned_message_notifications &&
+            d->mention_notification_group.group_id.is_valid() && d->pinned_message_notification_message_id.is_valid()) {
           remove_dialog_pinned_message_notification(d);
         }
-      }
-    }
-    if (current_settings->disable_mention_notifications != new_settings.disable_mention_notifications) {
-      VLOG(notifications) << "Remove mention notifications in " << scope;
-      for (auto &dialog : dialogs_) {
-        Dialog *d = dialog.second.get();
-        if (d->notification_settings.use_default_disable_mention_notifications &&
-            get_dialog_notification_setting_scope(d->dialog_id) == scope) {
+        if (need_update_mention_notifications &&
+            d->notification_settings.use_default_disable_mention_notifications) {
           if (current_settings->disable_mention_notifications) {
             update_dialog_mention_notification_count(d);
           } else {
             remove_dialog_mention_notifications(d);
           }
         }
-      }
+      });
     }
 
     VLOG(notifications) << "Update notification settings in " << scope << " from " << *current_settings << " to "
@@ -5932,10 +5965,8 @@ void MessagesManager::update_scope_unmute_timeout(NotificationSettingsScope scop
       int32 delta = 0;
       int32 total_count = 0;
       int32 marked_count = 0;
-      for (auto &dialog : dialogs_) {
-        Dialog *d = dialog.second.get();
-        if (need_unread_counter(d->order) && d->notification_settings.use_default_mute_until &&
-            get_dialog_notification_setting_scope(d->dialog_id) == scope) {
+      for_each_dialog_in_notification_scope(scope, [&](Dialog *d) {
+        if (need_unread_counter(d->order) && d->notification_settings.use_default_mute_until) {
           int32 unread_count = d->server_unread_count + d->local_unread_count;
           if (unread_count != 0) {
             delta += unread_count;
@@ -5945,7 +5976,7 @@ void MessagesManager::update_scope_unmute_timeout(NotificationSettingsScope scop
             marked_count++;
           }
         }
-      }
+      });
       if (delta != 0 && is_message_unread_count_inited_) {
         if (was_muted) {
           unread_message_muted_count_ -= delta;
@@ -6659,6 +6690,15 @@ void MessagesManager::after_get_difference() {
       send_update_chat_read_inbox(get_dialog(dialog_id), false, "after_get_difference");
     }
   }
+  if (!postponed_chat_last_message_updates_.empty()) {
+    LOG(INFO) << "Send postponed last message updates";
+    auto dialog_ids = std::move(postponed_chat_last_message_updates_);
+    for (auto dialog_id : dialog_ids) {
+      Dialog *d = get_dialog(dialog_id);
+      CHECK(d != nullptr);
+      send_update_chat_last_message(d, "after_get_difference");
+    }
+  }
   if (have_postponed_unread_message_count_update_) {
     LOG(INFO) << "Send postponed unread message count update";
     send_update_unread_message_count(DialogId(), false, "after_get_difference");
@@ -7435,7 +7475,7 @@ bool MessagesManager::can_revoke_message(DialogId dialog_id, const Message *m) c
   auto content_type = m->content->get_type();
   switch (dialog_id.get_type()) {
     case DialogType::User: {
-      bool can_revoke_incoming = G()->shared_config().get_option_boolean("revoke_pm_inbox", true);
+      bool can_revoke_incoming = G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::RevokePmInbox, true);
       int32 revoke_time_limit =
           G()->shared_config().get_option_integer("revoke_pm_time_limit", DEFAULT_REVOKE_TIME_LIMIT);
 
@@ -7816,6 +7856,22 @@ void MessagesManager::find_unloadable_messages(const Dialog *d, int32 unload_bef
   find_unloadable_messages(d, unload_before_date, m->right, message_ids, left_to_unload);
 }
 
+void MessagesManager::find_budget_unloadable_messages(const Dialog *d, const unique_ptr<Message> &m,
+                                                      vector<std::pair<int32, MessageId>> &messages) const {
+  if (m == nullptr) {
+    return;
+  }
+
+  find_budget_unloadable_messages(d, m->left, messages);
+
+  // keep messages with unread mentions loaded, they anchor the dialog unread mention count
+  if (can_unload_message(d, m.get()) && !m->contains_unread_mention) {
+    messages.emplace_back(m->last_access_date, m->message_id);
+  }
+
+  find_budget_unloadable_messages(d, m->right, messages);
+}
+
 void MessagesManager::delete_dialog_messages_from_user(DialogId dialog_id, UserId user_id, Promise<Unit> &&promise) {
   bool is_bot = td_->auth_manager_->is_bot();
   if (is_bot) {
@@ -7969,6 +8025,83 @@ void MessagesManager::unload_dialog(DialogId dialog_id) {
   }
 }
 
+int64 MessagesManager::get_max_loaded_message_count() const {
+  constexpr int32 DEFAULT_MAX_LOADED_MESSAGE_COUNT = 1 << 19;
+  return G()->shared_config().get_cached_option_integer(ConfigShared::CachedOption::MaxLoadedMessageCount,
+                                                        DEFAULT_MAX_LOADED_MESSAGE_COUNT);
+}
+
+void MessagesManager::on_enforce_message_budget_timeout(void *messages_manager_void) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  CHECK(messages_manager_void != nullptr);
+  auto messages_manager = static_cast<MessagesManager *>(messages_manager_void);
+  messages_manager->enforce_message_memory_budget();
+}
+
+void MessagesManager::enforce_message_memory_budget() {
+  auto max_loaded_message_count = get_max_loaded_message_count();
+  if (max_loaded_message_count <= 0 || loaded_message_count_ <= max_loaded_message_count ||
+      !is_message_unload_enabled()) {
+    return;
+  }
+
+  // unload down to 90% of the budget, otherwise almost every new message will trigger a new pass
+  auto target_message_count = max_loaded_message_count * 9 / 10;
+  LOG(INFO) << "Have " << loaded_message_count_ << " loaded messages with budget " << max_loaded_message_count
+            << ", unload messages down to " << target_message_count;
+
+  vector<std::pair<int32, FullMessageId>> messages;
+  for (auto &dialog : dialogs_) {
+    const Dialog *d = dialog.second.get();
+    if (d->is_opened) {
+      continue;
+    }
+
+    vector<std::pair<int32, MessageId>> dialog_messages;
+    find_budget_unloadable_messages(d, d->messages, dialog_messages);
+    for (auto &message : dialog_messages) {
+      messages.emplace_back(message.first, FullMessageId(d->dialog_id, message.second));
+    }
+  }
+  std::sort(messages.begin(), messages.end(),
+            [](const std::pair<int32, FullMessageId> &lhs, const std::pair<int32, FullMessageId> &rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  std::unordered_map<DialogId, vector<int64>, DialogIdHash> unloaded_message_ids;
+  for (auto &message : messages) {
+    if (loaded_message_count_ <= target_message_count) {
+      break;
+    }
+
+    auto full_message_id = message.second;
+    Dialog *d = get_dialog(full_message_id.get_dialog_id());
+    CHECK(d != nullptr);
+    unload_message(d, full_message_id.get_message_id());
+    unloaded_message_ids[full_message_id.get_dialog_id()].push_back(full_message_id.get_message_id().get());
+  }
+
+  for (auto &it : unloaded_message_ids) {
+    if (!G()->parameters().use_message_db) {
+      Dialog *d = get_dialog(it.first);
+      CHECK(d != nullptr);
+      d->have_full_history = false;
+    }
+
+    send_closure_later(G()->td(), &Td::send_update,
+                       make_tl_object<td_api::updateDeleteMessages>(it.first.get(), std::move(it.second), false, true));
+  }
+
+  if (loaded_message_count_ > target_message_count) {
+    // all remaining messages are pinned or are in opened dialogs, retry after they can be unloaded
+    LOG(INFO) << "Left " << loaded_message_count_ << " loaded messages after budget enforcement";
+    enforce_message_budget_timeout_.set_timeout_in(get_unload_dialog_delay());
+  }
+}
+
 void MessagesManager::delete_all_dialog_messages(Dialog *d, bool remove_from_dialog_list, bool is_permanent) {
   CHECK(d != nullptr);
   LOG(INFO) << "Delete all messages in " << d->dialog_id
@@ -8995,7 +9128,7 @@ void MessagesManager::init() {
   start_time_ = Time::now();
 
   include_sponsored_dialog_to_unread_count_ =
-      G()->shared_config().get_option_boolean("include_sponsored_chat_to_unread_count");
+      G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::IncludeSponsoredChatToUnreadCount);
 
   if (G()->parameters().use_message_db) {
     auto last_database_server_dialog_date_string = G()->td_db()->get_binlog_pmc()->get("last_server_dialog_date");
@@ -9014,6 +9147,8 @@ void MessagesManager::init() {
     }
     LOG(INFO) << "Load last_database_server_dialog_date_ = " << last_database_server_dialog_date_;
 
+    load_dialog_order_index();
+
     auto sponsored_dialog_id_string = G()->td_db()->get_binlog_pmc()->get("sponsored_dialog_id");
     if (sponsored_dialog_id_string.empty()) {
       sponsored_dialog_id_string = G()->td_db()->get_binlog_pmc()->get("promoted_dialog_id");
@@ -9830,7 +9965,7 @@ std::pair<DialogId, unique_ptr<MessagesManager::Message>> MessagesManager::creat
     is_outgoing = !is_outgoing;
 
     if (dialog_type == DialogType::Channel && !running_get_difference_ && !running_get_channel_difference(dialog_id) &&
-        get_channel_difference_to_logevent_id_.count(dialog_id) == 0) {
+        get_channel_difference_logevent_id(dialog_id) == 0) {
       // it is safer to completely ignore the message and re-get it through getChannelsDifference
       Dialog *d = get_dialog(dialog_id);
       if (d != nullptr) {
@@ -11238,6 +11373,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::do_delete_message(Dialog *
   unique_ptr<Message> result = std::move(*v);
   unique_ptr<Message> left = std::move(result->left);
   unique_ptr<Message> right = std::move(result->right);
+  loaded_message_count_--;
 
   LOG_CHECK(result->message_id == message_id) << result->message_id << " " << message_id << " " << source;
 
@@ -11363,6 +11499,7 @@ void MessagesManager::do_delete_all_dialog_messages(Dialog *d, unique_ptr<Messag
 
   on_message_deleted(d, m.get());
 
+  loaded_message_count_--;
   m = nullptr;
 }
 
@@ -11479,6 +11616,37 @@ vector<DialogId> MessagesManager::get_dialogs(DialogDate offset, int32 limit, bo
     return result;
   }
 
+  if (is_dialog_order_index_loaded_ && offset < last_database_server_dialog_date_) {
+    // the compact order index is gap-free up to last_database_server_dialog_date_,
+    // so the rest of the window can be served from it by hydrating exactly the
+    // requested chats instead of loading the whole list prefix from the database
+    DialogDate from = offset;
+    if (!result.empty()) {
+      const Dialog *d = get_dialog(result.back());
+      CHECK(d != nullptr);
+      from = DialogDate(d->order, d->dialog_id);
+    }
+    auto index_it = std::upper_bound(dialog_order_index_.begin(), dialog_order_index_.end(), from);
+    while (index_it != dialog_order_index_.end() && *index_it <= last_database_server_dialog_date_ && limit > 0) {
+      auto dialog_id = index_it->get_dialog_id();
+      ++index_it;
+      // the index is a snapshot, so the chat could have been moved or deleted since it was loaded
+      if (std::find(result.begin(), result.end(), dialog_id) != result.end()) {
+        continue;
+      }
+      if (get_dialog_force(dialog_id) == nullptr) {
+        continue;
+      }
+      result.push_back(dialog_id);
+      limit--;
+    }
+    if (limit <= 0) {
+      LOG(INFO) << "Serve " << result.size() << " chats from the chat order index";
+      promise.set_value(Unit());
+      return result;
+    }
+  }
+
   load_dialog_list(limit, std::move(promise));
   return result;
 }
@@ -11532,6 +11700,27 @@ void MessagesManager::load_dialog_list_from_database(int32 limit, Promise<Unit>
           }));
 }
 
+void MessagesManager::load_dialog_order_index() {
+  CHECK(G()->parameters().use_message_db);
+  G()->td_db()->get_dialog_db_async()->get_dialog_order_index(
+      PromiseCreator::lambda([actor_id = actor_id(this)](Result<vector<DialogOrderInfo>> result) {
+        if (result.is_error()) {
+          LOG(ERROR) << "Failed to load chat order index: " << result.error();
+          return;
+        }
+        send_closure(actor_id, &MessagesManager::on_get_dialog_order_index, result.move_as_ok());
+      }));
+}
+
+void MessagesManager::on_get_dialog_order_index(vector<DialogOrderInfo> dialog_orders) {
+  LOG(INFO) << "Receive chat order index with " << dialog_orders.size() << " chats";
+  dialog_order_index_ = transform(dialog_orders, [](const DialogOrderInfo &dialog_order) {
+    return DialogDate(dialog_order.order, dialog_order.dialog_id);
+  });
+  std::sort(dialog_order_index_.begin(), dialog_order_index_.end());
+  is_dialog_order_index_loaded_ = true;
+}
+
 void MessagesManager::on_get_dialogs_from_database(int32 limit, vector<BufferSlice> &&dialogs,
                                                    Promise<Unit> &&promise) {
   LOG(INFO) << "Receive " << dialogs.size() << " from expected " << limit
@@ -11543,6 +11732,21 @@ void MessagesManager::on_get_dialogs_from_database(int32 limit, vector<BufferSli
   }
   load_dialog_list_limit_max_ = 0;
 
+  // preload dependencies of the whole page in a few multi-gets, so each dialog's
+  // parse doesn't read its peer from the database individually
+  Dependencies dependencies;
+  for (auto &dialog : dialogs) {
+    LogEventParser dialog_id_parser(dialog.as_slice());
+    int32 flags;
+    DialogId dialog_id;
+    parse(flags, dialog_id_parser);
+    parse(dialog_id, dialog_id_parser);
+    if (dialog_id.is_valid()) {
+      add_dialog_dependencies(dependencies, dialog_id);
+    }
+  }
+  resolve_dependencies_force(dependencies);
+
   DialogDate max_dialog_date = MIN_DIALOG_DATE;
   for (auto &dialog : dialogs) {
     Dialog *d = on_load_dialog_from_database(DialogId(), std::move(dialog));
@@ -12544,11 +12748,55 @@ void MessagesManager::toggle_dialog_is_pinned_on_server(DialogId dialog_id, bool
     return;
   }
 
-  if (logevent_id == 0 && G()->parameters().use_message_db) {
-    logevent_id = save_toggle_dialog_is_pinned_on_server_logevent(dialog_id, is_pinned);
+  Dialog *d = get_dialog(dialog_id);
+  CHECK(d != nullptr);
+  if (G()->parameters().use_message_db) {
+    if (logevent_id != 0) {
+      // loaded from binlog; old binlogs can contain several events for the same
+      // dialog, in which case the last one supersedes its predecessors
+      if (d->toggle_is_pinned_logevent_id != 0) {
+        binlog_erase(G()->td_db()->get_binlog(), d->toggle_is_pinned_logevent_id);
+      }
+      d->toggle_is_pinned_logevent_id = logevent_id;
+    } else if (d->toggle_is_pinned_logevent_id == 0) {
+      d->toggle_is_pinned_logevent_id = save_toggle_dialog_is_pinned_on_server_logevent(dialog_id, is_pinned);
+      LOG(INFO) << "Add toggle is_pinned logevent " << d->toggle_is_pinned_logevent_id;
+    } else {
+      // the new toggle supersedes the pending one, so the logevent is rewritten
+      // in place instead of leaving a dead predecessor in the binlog
+      ToggleDialogIsPinnedOnServerLogEvent logevent{dialog_id, is_pinned};
+      auto storer = LogEventStorerImpl<ToggleDialogIsPinnedOnServerLogEvent>(logevent);
+      auto new_logevent_id = binlog_rewrite(G()->td_db()->get_binlog(), d->toggle_is_pinned_logevent_id,
+                                            LogEvent::HandlerType::ToggleDialogIsPinnedOnServer, storer);
+      LOG(INFO) << "Rewrite toggle is_pinned logevent " << d->toggle_is_pinned_logevent_id << " with "
+                << new_logevent_id;
+    }
+    d->toggle_is_pinned_logevent_id_generation++;
   }
 
-  td_->create_handler<ToggleDialogPinQuery>(get_erase_logevent_promise(logevent_id))->send(dialog_id, is_pinned);
+  Promise<> promise;
+  if (d->toggle_is_pinned_logevent_id != 0) {
+    promise = PromiseCreator::lambda(
+        [actor_id = actor_id(this), dialog_id,
+         generation = d->toggle_is_pinned_logevent_id_generation](Result<Unit> result) mutable {
+          if (!G()->close_flag()) {
+            send_closure(actor_id, &MessagesManager::on_toggled_dialog_is_pinned_on_server, dialog_id, generation);
+          }
+        });
+  }
+
+  td_->create_handler<ToggleDialogPinQuery>(std::move(promise))->send(dialog_id, is_pinned);
+}
+
+void MessagesManager::on_toggled_dialog_is_pinned_on_server(DialogId dialog_id, uint64 generation) {
+  auto d = get_dialog(dialog_id);
+  CHECK(d != nullptr);
+  if (d->toggle_is_pinned_logevent_id_generation == generation) {
+    CHECK(d->toggle_is_pinned_logevent_id != 0);
+    LOG(INFO) << "Delete toggle is_pinned logevent " << d->toggle_is_pinned_logevent_id;
+    binlog_erase(G()->td_db()->get_binlog(), d->toggle_is_pinned_logevent_id);
+    d->toggle_is_pinned_logevent_id = 0;
+  }
 }
 
 Status MessagesManager::set_pinned_dialogs(vector<DialogId> dialog_ids) {
@@ -12707,12 +12955,57 @@ void MessagesManager::toggle_dialog_is_marked_as_unread_on_server(DialogId dialo
     return;
   }
 
-  if (logevent_id == 0 && G()->parameters().use_message_db) {
-    logevent_id = save_toggle_dialog_is_marked_as_unread_on_server_logevent(dialog_id, is_marked_as_unread);
+  Dialog *d = get_dialog(dialog_id);
+  CHECK(d != nullptr);
+  if (G()->parameters().use_message_db) {
+    if (logevent_id != 0) {
+      // loaded from binlog; old binlogs can contain several events for the same
+      // dialog, in which case the last one supersedes its predecessors
+      if (d->toggle_is_marked_as_unread_logevent_id != 0) {
+        binlog_erase(G()->td_db()->get_binlog(), d->toggle_is_marked_as_unread_logevent_id);
+      }
+      d->toggle_is_marked_as_unread_logevent_id = logevent_id;
+    } else if (d->toggle_is_marked_as_unread_logevent_id == 0) {
+      d->toggle_is_marked_as_unread_logevent_id =
+          save_toggle_dialog_is_marked_as_unread_on_server_logevent(dialog_id, is_marked_as_unread);
+      LOG(INFO) << "Add toggle is_marked_as_unread logevent " << d->toggle_is_marked_as_unread_logevent_id;
+    } else {
+      // the new toggle supersedes the pending one, so the logevent is rewritten
+      // in place instead of leaving a dead predecessor in the binlog
+      ToggleDialogIsMarkedAsUnreadOnServerLogEvent logevent{dialog_id, is_marked_as_unread};
+      auto storer = LogEventStorerImpl<ToggleDialogIsMarkedAsUnreadOnServerLogEvent>(logevent);
+      auto new_logevent_id = binlog_rewrite(G()->td_db()->get_binlog(), d->toggle_is_marked_as_unread_logevent_id,
+                                            LogEvent::HandlerType::ToggleDialogIsMarkedAsUnreadOnServer, storer);
+      LOG(INFO) << "Rewrite toggle is_marked_as_unread logevent " << d->toggle_is_marked_as_unread_logevent_id
+                << " with " << new_logevent_id;
+    }
+    d->toggle_is_marked_as_unread_logevent_id_generation++;
+  }
+
+  Promise<> promise;
+  if (d->toggle_is_marked_as_unread_logevent_id != 0) {
+    promise = PromiseCreator::lambda(
+        [actor_id = actor_id(this), dialog_id,
+         generation = d->toggle_is_marked_as_unread_logevent_id_generation](Result<Unit> result) mutable {
+          if (!G()->close_flag()) {
+            send_closure(actor_id, &MessagesManager::on_toggled_dialog_is_marked_as_unread_on_server, dialog_id,
+                         generation);
+          }
+        });
   }
 
-  td_->create_handler<ToggleDialogUnreadMarkQuery>(get_erase_logevent_promise(logevent_id))
-      ->send(dialog_id, is_marked_as_unread);
+  td_->create_handler<ToggleDialogUnreadMarkQuery>(std::move(promise))->send(dialog_id, is_marked_as_unread);
+}
+
+void MessagesManager::on_toggled_dialog_is_marked_as_unread_on_server(DialogId dialog_id, uint64 generation) {
+  auto d = get_dialog(dialog_id);
+  CHECK(d != nullptr);
+  if (d->toggle_is_marked_as_unread_logevent_id_generation == generation) {
+    CHECK(d->toggle_is_marked_as_unread_logevent_id != 0);
+    LOG(INFO) << "Delete toggle is_marked_as_unread logevent " << d->toggle_is_marked_as_unread_logevent_id;
+    binlog_erase(G()->td_db()->get_binlog(), d->toggle_is_marked_as_unread_logevent_id);
+    d->toggle_is_marked_as_unread_logevent_id = 0;
+  }
 }
 
 Status MessagesManager::toggle_dialog_silent_send_message(DialogId dialog_id, bool silent_send_message) {
@@ -13363,7 +13656,7 @@ tl_object_ptr<td_api::chat> MessagesManager::get_chat_object(const Dialog *d) co
     switch (d->dialog_id.get_type()) {
       case DialogType::User:
         can_delete_for_self = true;
-        can_delete_for_all_users = G()->shared_config().get_option_boolean("revoke_pm_inbox", true);
+        can_delete_for_all_users = G()->shared_config().get_cached_option_boolean(ConfigShared::CachedOption::RevokePmInbox, true);
         if (d->dialog_id == get_my_dialog_id() || td_->contacts_manager_->is_user_deleted(d->dialog_id.get_user_id()) ||
             td_->contacts_manager_->is_user_bot(d->dialog_id.get_user_id())) {
           can_delete_for_all_users = false;
@@ -15776,6 +16069,14 @@ void MessagesManager::add_dialog_dependencies(Dependencies &dependencies, Dialog
 }
 
 void MessagesManager::resolve_dependencies_force(const Dependencies &dependencies) {
+  // fetch all missing dependencies from the database in a few multi-gets,
+  // so the have_*_force calls below don't do a database read per identifier
+  td_->contacts_manager_->preload_users_from_database(dependencies.user_ids);
+  td_->contacts_manager_->preload_chats_from_database(dependencies.chat_ids);
+  td_->contacts_manager_->preload_channels_from_database(dependencies.channel_ids);
+  td_->contacts_manager_->preload_secret_chats_from_database(dependencies.secret_chat_ids);
+  td_->web_pages_manager_->preload_web_pages_from_database(dependencies.web_page_ids);
+
   for (auto user_id : dependencies.user_ids) {
     if (user_id.is_valid() && !td_->contacts_manager_->have_user_force(user_id)) {
       LOG(ERROR) << "Can't find " << user_id;
@@ -15865,7 +16166,7 @@ Result<MessageId> MessagesManager::send_message(DialogId dialog_id, MessageId re
   bool need_update_dialog_pos = false;
   Message *m = get_message_to_send(
       d, get_reply_to_message_id(d, reply_to_message_id), disable_notification, from_background,
-      dup_message_content(td_, dialog_id, message_content.content.get(), false), &need_update_dialog_pos);
+      dup_message_content(td_, dialog_id, std::move(message_content.content), false), &need_update_dialog_pos);
   m->reply_markup = std::move(message_reply_markup);
   m->via_bot_user_id = message_content.via_bot_user_id;
   m->disable_web_page_preview = message_content.disable_web_page_preview;
@@ -15954,7 +16255,7 @@ Result<vector<MessageId>> MessagesManager::send_message_group(
   bool need_update_dialog_pos = false;
   for (auto &message_content : message_contents) {
     Message *m = get_message_to_send(d, reply_to_message_id, disable_notification, from_background,
-                                     dup_message_content(td_, dialog_id, message_content.first.get(), false),
+                                     dup_message_content(td_, dialog_id, std::move(message_content.first), false),
                                      &need_update_dialog_pos);
     result.push_back(m->message_id);
     auto ttl = message_content.second;
@@ -17186,7 +17487,7 @@ void MessagesManager::edit_message_media(FullMessageId full_message_id,
 
   cancel_edit_message_media(dialog_id, m, "Cancelled by new editMessageMedia request");
 
-  m->edited_content = dup_message_content(td_, dialog_id, content.content.get(), false);
+  m->edited_content = dup_message_content(td_, dialog_id, std::move(content.content), false);
   m->edited_reply_markup = r_new_reply_markup.move_as_ok();
   m->edit_generation = ++current_message_edit_generation_;
   m->edit_promise = std::move(promise);
@@ -18474,7 +18775,7 @@ NotificationGroupId MessagesManager::get_dialog_notification_group_id(DialogId d
 
     notification_group_id_to_dialog_id_.emplace(next_notification_group_id, dialog_id);
 
-    if (running_get_channel_difference(dialog_id) || get_channel_difference_to_logevent_id_.count(dialog_id) != 0) {
+    if (running_get_channel_difference(dialog_id) || get_channel_difference_logevent_id(dialog_id) != 0) {
       send_closure_later(G()->notification_manager(), &NotificationManager::before_get_chat_difference,
                          next_notification_group_id);
     }
@@ -19660,6 +19961,14 @@ void MessagesManager::send_update_chat_draft_message(const Dialog *d) {
 
 void MessagesManager::send_update_chat_last_message(Dialog *d, const char *source) {
   update_dialog_pos(d, false, source, false);
+  if (running_get_difference_) {
+    // during getDifference the last message of a chat can change on every applied message;
+    // coalesce to one updateChatLastMessage per chat sent after the difference is applied
+    LOG(INFO) << "Postpone updateChatLastMessage in " << d->dialog_id << " from " << source;
+    postponed_chat_last_message_updates_.insert(d->dialog_id);
+    return;
+  }
+  postponed_chat_last_message_updates_.erase(d->dialog_id);
   send_update_chat_last_message_impl(d, source);
 }
 
@@ -19762,7 +20071,7 @@ void MessagesManager::send_update_chat_read_inbox(const Dialog *d, bool force, c
                                         << source;
   on_dialog_updated(d->dialog_id, source);
   if (!force && (running_get_difference_ || running_get_channel_difference(d->dialog_id) ||
-                 get_channel_difference_to_logevent_id_.count(d->dialog_id) != 0)) {
+                 get_channel_difference_logevent_id(d->dialog_id) != 0)) {
     LOG(INFO) << "Postpone updateChatReadInbox in " << d->dialog_id << "(" << get_dialog_title(d->dialog_id) << ") to "
               << d->server_unread_count << " + " << d->local_unread_count << " from " << source;
     postponed_chat_read_inbox_updates_.insert(d->dialog_id);
@@ -22134,9 +22443,20 @@ MessagesManager::Message *MessagesManager::get_message_force(Dialog *d, MessageI
     return nullptr;
   }
 
-  LOG(INFO) << "Trying to load " << FullMessageId{d->dialog_id, message_id} << " from database from " << source;
-  auto r_value = G()->td_db()->get_messages_db_sync()->get_message({d->dialog_id, message_id});
-  if (r_value.is_error()) {
+  auto full_message_id = FullMessageId{d->dialog_id, message_id};
+  if (failed_to_load_message_ids_.count(full_message_id)) {
+    // the message is known to be neither in memory nor in the database;
+    // repeating the synchronous database query is pointless
+    return nullptr;
+  }
+
+  LOG(INFO) << "Trying to load " << full_message_id << " from database from " << source;
+  auto r_value = G()->td_db()->get_messages_db_sync()->get_message(full_message_id);
+  if (r_value.is_error() || r_value.ok().empty()) {
+    if (failed_to_load_message_ids_.size() >= MAX_FAILED_TO_LOAD_MESSAGE_IDS) {
+      failed_to_load_message_ids_.clear();
+    }
+    failed_to_load_message_ids_.insert(full_message_id);
     return nullptr;
   }
   return on_get_message_from_database(d->dialog_id, d, r_value.ok(), source);
@@ -22252,6 +22572,8 @@ MessagesManager::Message *MessagesManager::add_message_to_dialog(Dialog *d, uniq
   DialogId dialog_id = d->dialog_id;
   MessageId message_id = message->message_id;
 
+  failed_to_load_message_ids_.erase(FullMessageId{dialog_id, message_id});
+
   if (d->deleted_message_ids.count(message_id)) {
     LOG(INFO) << "Skip adding deleted " << message_id << " to " << dialog_id << " from " << source;
     debug_add_message_to_dialog_fail_reason_ = "adding deleted message";
@@ -22934,6 +23256,15 @@ MessagesManager::Message *MessagesManager::add_message_to_dialog(Dialog *d, uniq
   CHECK(result_message != nullptr);
   CHECK(d->messages != nullptr);
 
+  loaded_message_count_++;
+  auto max_loaded_message_count = get_max_loaded_message_count();
+  if (max_loaded_message_count > 0 && loaded_message_count_ > max_loaded_message_count &&
+      is_message_unload_enabled() && !enforce_message_budget_timeout_.has_timeout()) {
+    enforce_message_budget_timeout_.set_callback(on_enforce_message_budget_timeout);
+    enforce_message_budget_timeout_.set_callback_data(static_cast<void *>(this));
+    enforce_message_budget_timeout_.set_timeout_in(1.0);
+  }
+
   if (!is_attached) {
     if (m->have_next) {
       LOG_CHECK(!m->have_previous) << auto_attach << " " << dialog_id << " " << message_id << " " << from_update << " "
@@ -23921,6 +24252,7 @@ MessagesManager::Dialog *MessagesManager::add_new_dialog(unique_ptr<Dialog> &&d,
   }
 
   auto dialog_it = dialogs_.emplace(dialog_id, std::move(d)).first;
+  add_dialog_handle(dialog_id);
 
   loaded_dialogs_.erase(dialog_id);
 
@@ -24719,7 +25051,42 @@ void MessagesManager::set_channel_pts(Dialog *d, int32 new_pts, const char *sour
 }
 
 bool MessagesManager::running_get_channel_difference(DialogId dialog_id) const {
-  return active_get_channel_differencies_.count(dialog_id) > 0;
+  auto handle = get_dialog_handle(dialog_id);
+  return handle >= 0 && !active_get_channel_difference_sources_[handle].empty();
+}
+
+int32 MessagesManager::add_dialog_handle(DialogId dialog_id) {
+  auto next_handle = narrow_cast<int32>(dialog_handles_.size());
+  auto handle = dialog_handles_.emplace(dialog_id, next_handle).first->second;
+  if (static_cast<size_t>(handle) >= active_get_channel_difference_sources_.size()) {
+    active_get_channel_difference_sources_.resize(handle + 1);
+    get_channel_difference_logevent_ids_.resize(handle + 1);
+  }
+  return handle;
+}
+
+int32 MessagesManager::get_dialog_handle(DialogId dialog_id) const {
+  auto it = dialog_handles_.find(dialog_id);
+  if (it == dialog_handles_.end()) {
+    return -1;
+  }
+  return it->second;
+}
+
+Slice MessagesManager::get_channel_difference_source(DialogId dialog_id) const {
+  auto handle = get_dialog_handle(dialog_id);
+  if (handle < 0) {
+    return Slice();
+  }
+  return active_get_channel_difference_sources_[handle];
+}
+
+uint64 MessagesManager::get_channel_difference_logevent_id(DialogId dialog_id) const {
+  auto handle = get_dialog_handle(dialog_id);
+  if (handle < 0) {
+    return 0;
+  }
+  return get_channel_difference_logevent_ids_[handle];
 }
 
 class MessagesManager::GetChannelDifferenceLogEvent {
@@ -24762,7 +25129,7 @@ void MessagesManager::get_channel_difference(DialogId dialog_id, int32 pts, bool
     return;
   }
 
-  if (force && get_channel_difference_to_logevent_id_.count(dialog_id) == 0) {
+  if (force && get_channel_difference_logevent_id(dialog_id) == 0) {
     auto channel_id = dialog_id.get_channel_id();
     CHECK(input_channel->get_id() == telegram_api::inputChannel::ID);
     auto access_hash = static_cast<const telegram_api::inputChannel &>(*input_channel).access_hash_;
@@ -24770,7 +25137,7 @@ void MessagesManager::get_channel_difference(DialogId dialog_id, int32 pts, bool
     auto storer = LogEventStorerImpl<GetChannelDifferenceLogEvent>(logevent);
     auto logevent_id = binlog_add(G()->td_db()->get_binlog(), LogEvent::HandlerType::GetChannelDifference, storer);
 
-    get_channel_difference_to_logevent_id_.emplace(dialog_id, logevent_id);
+    get_channel_difference_logevent_ids_[add_dialog_handle(dialog_id)] = logevent_id;
   }
 
   return do_get_channel_difference(dialog_id, pts, force, std::move(input_channel), source);
@@ -24779,12 +25146,13 @@ void MessagesManager::get_channel_difference(DialogId dialog_id, int32 pts, bool
 void MessagesManager::do_get_channel_difference(DialogId dialog_id, int32 pts, bool force,
                                                 tl_object_ptr<telegram_api::InputChannel> &&input_channel,
                                                 const char *source) {
-  auto inserted = active_get_channel_differencies_.emplace(dialog_id, source);
-  if (!inserted.second) {
+  auto &active_source = active_get_channel_difference_sources_[add_dialog_handle(dialog_id)];
+  if (!active_source.empty()) {
     LOG(INFO) << "Skip running channels.getDifference for " << dialog_id << " from " << source
               << " because it has already been run";
     return;
   }
+  active_source = source;
 
   const Dialog *d = get_dialog(dialog_id);
   if (d != nullptr) {
@@ -24804,12 +25172,42 @@ void MessagesManager::do_get_channel_difference(DialogId dialog_id, int32 pts, b
     limit = MIN_CHANNEL_DIFFERENCE;
   }
 
+  if (sent_channel_difference_query_count_ >= MAX_CONCURRENT_CHANNEL_DIFFERENCES) {
+    LOG(INFO) << "Postpone getChannelDifference for " << dialog_id << " from " << source << ", because there are "
+              << sent_channel_difference_query_count_ << " active queries";
+    pending_channel_difference_queries_.push(
+        PendingChannelDifference{dialog_id, pts, limit, force, std::move(input_channel)});
+    return;
+  }
+  sent_channel_difference_query_count_++;
+
   LOG(INFO) << "-----BEGIN GET CHANNEL DIFFERENCE----- for " << dialog_id << " with pts " << pts << " and limit "
             << limit << " from " << source;
 
   td_->create_handler<GetChannelDifferenceQuery>()->send(dialog_id, std::move(input_channel), pts, limit, force);
 }
 
+void MessagesManager::on_sent_channel_difference_query_finished() {
+  CHECK(sent_channel_difference_query_count_ > 0);
+  sent_channel_difference_query_count_--;
+  if (G()->close_flag()) {
+    return;
+  }
+  while (sent_channel_difference_query_count_ < MAX_CONCURRENT_CHANNEL_DIFFERENCES &&
+         !pending_channel_difference_queries_.empty()) {
+    auto query = std::move(pending_channel_difference_queries_.front());
+    pending_channel_difference_queries_.pop();
+    CHECK(running_get_channel_difference(query.dialog_id));
+    sent_channel_difference_query_count_++;
+
+    LOG(INFO) << "-----BEGIN GET CHANNEL DIFFERENCE----- for " << query.dialog_id << " with pts " << query.pts
+              << " and limit " << query.limit << " after another query has finished";
+
+    td_->create_handler<GetChannelDifferenceQuery>()->send(query.dialog_id, std::move(query.input_channel), query.pts,
+                                                           query.limit, query.force);
+  }
+}
+
 void MessagesManager::process_get_channel_difference_updates(
     DialogId dialog_id, vector<tl_object_ptr<telegram_api::Message>> &&new_messages,
     vector<tl_object_ptr<telegram_api::Update>> &&other_updates) {
@@ -24849,7 +25247,7 @@ void MessagesManager::process_get_channel_difference_updates(
       }
     }
   }
-  LOG_CHECK(!running_get_channel_difference(dialog_id)) << '"' << active_get_channel_differencies_[dialog_id] << '"';
+  LOG_CHECK(!running_get_channel_difference(dialog_id)) << '"' << get_channel_difference_source(dialog_id) << '"';
 
   if (need_repair_unread_count) {
     repair_channel_server_unread_count(get_dialog(dialog_id));
@@ -24967,8 +25365,10 @@ void MessagesManager::on_get_channel_difference(
     DialogId dialog_id, int32 request_pts, int32 request_limit,
     tl_object_ptr<telegram_api::updates_ChannelDifference> &&difference_ptr) {
   LOG(INFO) << "----- END  GET CHANNEL DIFFERENCE----- for " << dialog_id;
-  CHECK(active_get_channel_differencies_.count(dialog_id) == 1);
-  active_get_channel_differencies_.erase(dialog_id);
+  auto handle = get_dialog_handle(dialog_id);
+  CHECK(handle >= 0 && !active_get_channel_difference_sources_[handle].empty());
+  active_get_channel_difference_sources_[handle].clear();
+  on_sent_channel_difference_query_finished();
   auto d = get_dialog_force(dialog_id);
 
   if (difference_ptr == nullptr) {
@@ -25104,14 +25504,14 @@ void MessagesManager::on_get_channel_difference(
 
 void MessagesManager::after_get_channel_difference(DialogId dialog_id, bool success) {
   LOG(INFO) << "After " << (success ? "" : "un") << "successful get channel difference in " << dialog_id;
-  LOG_CHECK(!running_get_channel_difference(dialog_id)) << '"' << active_get_channel_differencies_[dialog_id] << '"';
+  LOG_CHECK(!running_get_channel_difference(dialog_id)) << '"' << get_channel_difference_source(dialog_id) << '"';
 
-  auto logevent_it = get_channel_difference_to_logevent_id_.find(dialog_id);
-  if (logevent_it != get_channel_difference_to_logevent_id_.end()) {
+  auto logevent_id = get_channel_difference_logevent_id(dialog_id);
+  if (logevent_id != 0) {
     if (!G()->close_flag()) {
-      binlog_erase(G()->td_db()->get_binlog(), logevent_it->second);
+      binlog_erase(G()->td_db()->get_binlog(), logevent_id);
     }
-    get_channel_difference_to_logevent_id_.erase(logevent_it);
+    get_channel_difference_logevent_ids_[get_dialog_handle(dialog_id)] = 0;
   }
 
   auto d = get_dialog(dialog_id);
@@ -25282,6 +25682,17 @@ MessagesManager::Message *MessagesManager::continue_send_message(DialogId dialog
 }
 
 void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
+  // a crashed instance can leave thousands of pending events, mostly unsent messages;
+  // replaying them all in one mailbox event would keep the actor unresponsive until the
+  // end, so only a bounded batch is processed per invocation and the rest is rescheduled,
+  // letting requests received in the meantime interleave. Relative event order is kept
+  constexpr size_t MAX_BINLOG_EVENTS_PER_BATCH = 100;
+  if (events.size() > MAX_BINLOG_EVENTS_PER_BATCH) {
+    vector<BinlogEvent> remaining_events(std::make_move_iterator(events.begin() + MAX_BINLOG_EVENTS_PER_BATCH),
+                                         std::make_move_iterator(events.end()));
+    events.resize(MAX_BINLOG_EVENTS_PER_BATCH);
+    send_closure_later(actor_id(this), &MessagesManager::on_binlog_events, std::move(remaining_events));
+  }
   for (auto &event : events) {
     switch (event.type_) {
       case LogEvent::HandlerType::SendMessage: {
@@ -25308,7 +25719,7 @@ void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
         add_message_dependencies(dependencies, dialog_id, m.get());
         resolve_dependencies_force(dependencies);
 
-        m->content = dup_message_content(td_, dialog_id, m->content.get(), false);
+        m->content = dup_message_content(td_, dialog_id, std::move(m->content), false);
 
         auto result_message = continue_send_message(dialog_id, std::move(m), event.id_);
         if (result_message != nullptr) {
@@ -25373,7 +25784,7 @@ void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
         add_message_dependencies(dependencies, dialog_id, m.get());
         resolve_dependencies_force(dependencies);
 
-        m->content = dup_message_content(td_, dialog_id, m->content.get(), false);
+        m->content = dup_message_content(td_, dialog_id, std::move(m->content), false);
 
         auto result_message = continue_send_message(dialog_id, std::move(m), event.id_);
         if (result_message != nullptr) {
@@ -25445,7 +25856,7 @@ void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
           m->message_id = get_next_yet_unsent_message_id(to_dialog);
           m->random_y = get_random_y(m->message_id);
           m->date = now;
-          m->content = dup_message_content(td_, to_dialog_id, m->content.get(), true);
+          m->content = dup_message_content(td_, to_dialog_id, std::move(m->content), true);
           m->have_previous = true;
           m->have_next = true;
         }
@@ -25819,7 +26230,7 @@ void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
 
         DialogId dialog_id(log_event.channel_id);
         LOG(INFO) << "Continue to run getChannelDifference in " << dialog_id;
-        get_channel_difference_to_logevent_id_.emplace(dialog_id, event.id_);
+        get_channel_difference_logevent_ids_[add_dialog_handle(dialog_id)] = event.id_;
         do_get_channel_difference(
             dialog_id, load_channel_pts(dialog_id), true,
             telegram_api::make_object<telegram_api::inputChannel>(log_event.channel_id.get(), log_event.access_hash),
@@ -14,6 +14,7 @@
 #include "td/telegram/ChannelId.h"
 #include "td/telegram/Dependencies.h"
 #include "td/telegram/DialogDate.h"
+#include "td/telegram/DialogDb.h"
 #include "td/telegram/DialogId.h"
 #include "td/telegram/DialogParticipant.h"
 #include "td/telegram/files/FileId.h"
@@ -44,6 +45,7 @@
 #include "td/utils/buffer.h"
 #include "td/utils/ChangesProcessor.h"
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Heap.h"
 #include "td/utils/Hints.h"
 #include "td/utils/logging.h"
@@ -56,6 +58,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <queue>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -923,11 +926,23 @@ class MessagesManager : public Actor {
   };
 
   struct Dialog {
+    // fields used by dialog list iteration and total unread count
+    // recalculation are grouped at the front of the struct, so a pass over
+    // all known dialogs reads the beginning of each Dialog instead of
+    // fields scattered across the whole struct
     DialogId dialog_id;
+    int64 order = DEFAULT_ORDER;
+    int64 pinned_order = DEFAULT_ORDER;
+    MessageId last_message_id;  // identifier of the message after which currently there is no any message, i.e. a
+                                // message without a gap after it, memory only
+    int32 server_unread_count = 0;
+    int32 local_unread_count = 0;
+    int32 unread_mention_count = 0;
+    bool is_marked_as_unread = false;
+    DialogNotificationSettings notification_settings;  // mute_until is the first field of the settings
+
     MessageId last_new_message_id;  // identifier of the last known server message received from update, there should be
                                     // no server messages after it
-    MessageId last_message_id;      // identifier of the message after which currently there is no any message, i.e. a
-                                    // message without a gap after it, memory only
     MessageId first_database_message_id;  // identifier of the first message in the database, needed
                                           // until there is no gaps in the database
     MessageId last_database_message_id;   // identifier of the last local or server message, if last_database_message_id
@@ -938,15 +953,11 @@ class MessagesManager : public Actor {
     // use struct Count?
     std::array<int32, search_messages_filter_size()> message_count_by_index;
 
-    int32 server_unread_count = 0;
-    int32 local_unread_count = 0;
-    int32 unread_mention_count = 0;
     MessageId last_read_inbox_message_id;
     int32 last_read_inbox_message_date = 0;  // secret chats only
     MessageId last_read_outbox_message_id;
     MessageId pinned_message_id;
     MessageId reply_markup_message_id;
-    DialogNotificationSettings notification_settings;
     unique_ptr<DraftMessage> draft_message;
     uint64 save_draft_message_logevent_id = 0;
     uint64 save_draft_message_logevent_id_generation = 0;
@@ -954,6 +965,10 @@ class MessagesManager : public Actor {
     uint64 save_notification_settings_logevent_id_generation = 0;
     uint64 read_history_logevent_id = 0;
     uint64 read_history_logevent_id_generation = 0;
+    uint64 toggle_is_pinned_logevent_id = 0;
+    uint64 toggle_is_pinned_logevent_id_generation = 0;
+    uint64 toggle_is_marked_as_unread_logevent_id = 0;
+    uint64 toggle_is_marked_as_unread_logevent_id_generation = 0;
 
     MessageId
         last_read_all_mentions_message_id;  // all mentions with a message id not greater than it are implicitly read
@@ -962,8 +977,6 @@ class MessagesManager : public Actor {
 
     int32 last_clear_history_date = 0;
     MessageId last_clear_history_message_id;
-    int64 order = DEFAULT_ORDER;
-    int64 pinned_order = DEFAULT_ORDER;
     int32 delete_last_message_date = 0;
     MessageId deleted_last_message_id;
     int32 pending_last_message_date = 0;
@@ -1004,7 +1017,6 @@ class MessagesManager : public Actor {
     bool is_last_read_outbox_message_id_inited = false;
     bool is_pinned_message_id_inited = false;
     bool need_repair_server_unread_count = false;
-    bool is_marked_as_unread = false;
 
     bool increment_view_counter = false;
 
@@ -1253,6 +1265,7 @@ class MessagesManager : public Actor {
   static constexpr int32 MIN_CHANNEL_DIFFERENCE = 10;
   static constexpr int32 MAX_CHANNEL_DIFFERENCE = 100;
   static constexpr int32 MAX_BOT_CHANNEL_DIFFERENCE = 100000;  // server side limit
+  static constexpr int32 MAX_CONCURRENT_CHANNEL_DIFFERENCES = 10;
   static constexpr int32 MAX_RECENT_FOUND_DIALOGS = 20;        // some reasonable value
   static constexpr size_t MAX_TITLE_LENGTH = 128;              // server side limit for chat title
   static constexpr size_t MAX_DESCRIPTION_LENGTH = 255;        // server side limit for chat description
@@ -1433,6 +1446,12 @@ class MessagesManager : public Actor {
 
   void unload_dialog(DialogId dialog_id);
 
+  int64 get_max_loaded_message_count() const;
+
+  void enforce_message_memory_budget();
+
+  static void on_enforce_message_budget_timeout(void *messages_manager_void);
+
   void delete_all_dialog_messages(Dialog *d, bool remove_from_dialog_list, bool is_permanent);
 
   void do_delete_all_dialog_messages(Dialog *d, unique_ptr<Message> &m, vector<int64> &deleted_message_ids);
@@ -1459,6 +1478,9 @@ class MessagesManager : public Actor {
   void find_unloadable_messages(const Dialog *d, int32 unload_before_date, const unique_ptr<Message> &m,
                                 vector<MessageId> &message_ids, int32 &left_to_unload) const;
 
+  void find_budget_unloadable_messages(const Dialog *d, const unique_ptr<Message> &m,
+                                       vector<std::pair<int32, MessageId>> &messages) const;
+
   bool update_message_views(DialogId dialog_id, Message *m, int32 views);
 
   bool update_message_contains_unread_mention(Dialog *d, Message *m, bool contains_unread_mention, const char *source);
@@ -1542,6 +1564,10 @@ class MessagesManager : public Actor {
 
   void load_dialog_list_from_database(int32 limit, Promise<Unit> &&promise);
 
+  void load_dialog_order_index();
+
+  void on_get_dialog_order_index(vector<DialogOrderInfo> dialog_orders);
+
   static void preload_dialog_list(void *messages_manager_void);
 
   void update_message_count_by_index(Dialog *d, int diff, const Message *m);
@@ -1766,6 +1792,9 @@ class MessagesManager : public Actor {
   bool update_scope_notification_settings(NotificationSettingsScope scope, ScopeNotificationSettings *current_settings,
                                           const ScopeNotificationSettings &new_settings);
 
+  template <class F>
+  void for_each_dialog_in_notification_scope(NotificationSettingsScope scope, F &&callback);
+
   void update_dialog_unmute_timeout(Dialog *d, bool old_use_default, int32 old_mute_until, bool new_use_default,
                                     int32 new_mute_until);
 
@@ -1962,6 +1991,10 @@ class MessagesManager : public Actor {
 
   void on_updated_dialog_notification_settings(DialogId dialog_id, uint64 generation);
 
+  void on_toggled_dialog_is_pinned_on_server(DialogId dialog_id, uint64 generation);
+
+  void on_toggled_dialog_is_marked_as_unread_on_server(DialogId dialog_id, uint64 generation);
+
   void update_scope_notification_settings_on_server(NotificationSettingsScope scope, uint64 logevent_id);
 
   void reset_all_notification_settings_on_server(uint64 logevent_id);
@@ -1998,11 +2031,26 @@ class MessagesManager : public Actor {
 
   bool running_get_channel_difference(DialogId dialog_id) const;
 
+  // assigns a dense handle to the dialog on first sight; per-dialog auxiliary
+  // state is kept in contiguous vectors indexed by handle instead of hash maps
+  int32 add_dialog_handle(DialogId dialog_id);
+
+  // returns -1 if the dialog was never seen
+  int32 get_dialog_handle(DialogId dialog_id) const;
+
+  // returns an empty Slice if getChannelDifference isn't running in the dialog
+  Slice get_channel_difference_source(DialogId dialog_id) const;
+
+  // returns 0 if there is no saved GetChannelDifference log event for the dialog
+  uint64 get_channel_difference_logevent_id(DialogId dialog_id) const;
+
   void get_channel_difference(DialogId dialog_id, int32 pts, bool force, const char *source);
 
   void do_get_channel_difference(DialogId dialog_id, int32 pts, bool force,
                                  tl_object_ptr<telegram_api::InputChannel> &&input_channel, const char *source);
 
+  void on_sent_channel_difference_query_finished();
+
   void process_get_channel_difference_updates(DialogId dialog_id,
                                               vector<tl_object_ptr<telegram_api::Message>> &&new_messages,
                                               vector<tl_object_ptr<telegram_api::Update>> &&other_updates);
@@ -2210,6 +2258,11 @@ class MessagesManager : public Actor {
       update_message_ids_;                                         // full_message_id -> temporary_id
   std::unordered_map<int64, DialogId> debug_being_sent_messages_;  // message_random_id -> dialog_id
 
+  static constexpr size_t MAX_FAILED_TO_LOAD_MESSAGE_IDS = 1000;
+  // messages recently confirmed to be neither in memory nor in the message
+  // database; repeated getMessage calls for them skip the database query
+  std::unordered_set<FullMessageId, FullMessageIdHash> failed_to_load_message_ids_;
+
   const char *debug_add_message_to_dialog_fail_reason_ = "";
 
   struct UploadedDialogPhotoInfo {
@@ -2235,7 +2288,7 @@ class MessagesManager : public Actor {
 
   bool running_get_difference_ = false;  // true after before_get_difference and false after after_get_difference
 
-  std::unordered_map<DialogId, unique_ptr<Dialog>, DialogIdHash> dialogs_;
+  FlatHashMap<DialogId, unique_ptr<Dialog>, DialogIdHash> dialogs_;
   std::multimap<int32, PendingPtsUpdate> pending_updates_;
   std::multimap<int32, PendingPtsUpdate> postponed_pts_updates_;
 
@@ -2243,6 +2296,7 @@ class MessagesManager : public Actor {
       loaded_dialogs_;  // dialogs loaded from database, but not added to dialogs_
 
   std::unordered_set<DialogId, DialogIdHash> postponed_chat_read_inbox_updates_;
+  std::unordered_set<DialogId, DialogIdHash> postponed_chat_last_message_updates_;
 
   struct PendingGetMessageRequest {
     MessageId message_id;
@@ -2334,6 +2388,11 @@ class MessagesManager : public Actor {
   uint64 current_message_edit_generation_ = 0;
 
   std::set<DialogDate> ordered_dialogs_;
+
+  // compact (order, dialog_id) snapshot of the whole dialog list, loaded from the database in one read;
+  // used only as a hint for which dialogs to hydrate, so it is allowed to become stale
+  vector<DialogDate> dialog_order_index_;
+  bool is_dialog_order_index_loaded_ = false;
   std::set<DialogDate> ordered_server_dialogs_;
 
   // date of last dialog in the dialog list
@@ -2350,8 +2409,24 @@ class MessagesManager : public Actor {
   int32 load_dialog_list_limit_max_ = 0;
   Timeout preload_dialog_list_timeout_;
 
-  std::unordered_map<DialogId, string, DialogIdHash> active_get_channel_differencies_;
-  std::unordered_map<DialogId, uint64, DialogIdHash> get_channel_difference_to_logevent_id_;
+  FlatHashMap<DialogId, int32, DialogIdHash> dialog_handles_;
+
+  // indexed by dialog handle; an empty source means that getChannelDifference isn't running
+  vector<string> active_get_channel_difference_sources_;
+  // indexed by dialog handle; zero means that there is no saved log event
+  vector<uint64> get_channel_difference_logevent_ids_;
+
+  struct PendingChannelDifference {
+    DialogId dialog_id;
+    int32 pts = 0;
+    int32 limit = 0;
+    bool force = false;
+    tl_object_ptr<telegram_api::InputChannel> input_channel;
+  };
+  // channels, which are already treated as running by running_get_channel_difference, but for which
+  // the query isn't sent yet to limit the number of concurrent getChannelDifference queries
+  std::queue<PendingChannelDifference> pending_channel_difference_queries_;
+  int32 sent_channel_difference_query_count_ = 0;
 
   MultiTimeout channel_get_difference_timeout_{"ChannelGetDifferenceTimeout"};
   MultiTimeout channel_get_difference_retry_timeout_{"ChannelGetDifferenceRetryTimeout"};
@@ -2365,6 +2440,9 @@ class MessagesManager : public Actor {
   MultiTimeout active_dialog_action_timeout_{"ActiveDialogActionTimeout"};
   MultiTimeout update_dialog_online_member_count_timeout_{"UpdateDialogOnlineMemberCountTimeout"};
 
+  Timeout enforce_message_budget_timeout_;
+  int64 loaded_message_count_ = 0;  // number of messages loaded in memory in all dialogs
+
   Hints dialogs_hints_;  // search dialogs by title and username
 
   std::unordered_set<FullMessageId, FullMessageIdHash> active_live_location_full_message_ids_;
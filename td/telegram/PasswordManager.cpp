@@ -105,8 +105,9 @@ tl_object_ptr<telegram_api::InputCheckPasswordSRP> PasswordManager::get_input_ch
   auto a_bn = BigNum::from_binary(a.as_slice());
 
   BigNumContext ctx;
+  auto p_mod_ctx = BigNumModContext::create(p_bn, ctx);
   BigNum A_bn;
-  BigNum::mod_exp(A_bn, g_bn, a_bn, p_bn, ctx);
+  BigNum::mod_exp(A_bn, g_bn, a_bn, p_bn, ctx, p_mod_ctx);
   string A = A_bn.to_binary(256);
 
   string u = sha256(PSLICE() << A << B);
@@ -115,7 +116,7 @@ tl_object_ptr<telegram_api::InputCheckPasswordSRP> PasswordManager::get_input_ch
   auto k_bn = BigNum::from_binary(k);
 
   BigNum v_bn;
-  BigNum::mod_exp(v_bn, g_bn, x_bn, p_bn, ctx);
+  BigNum::mod_exp(v_bn, g_bn, x_bn, p_bn, ctx, p_mod_ctx);
   BigNum kv_bn;
   BigNum::mod_mul(kv_bn, k_bn, v_bn, p_bn, ctx);
   BigNum t_bn;
@@ -128,7 +129,7 @@ tl_object_ptr<telegram_api::InputCheckPasswordSRP> PasswordManager::get_input_ch
   BigNum::add(exp_bn, exp_bn, a_bn);
 
   BigNum S_bn;
-  BigNum::mod_exp(S_bn, t_bn, exp_bn, p_bn, ctx);
+  BigNum::mod_exp(S_bn, t_bn, exp_bn, p_bn, ctx, p_mod_ctx);
   string S = S_bn.to_binary(256);
   auto K = sha256(S);
 
@@ -13,8 +13,27 @@
 
 namespace td {
 
+bool QueryCombiner::fail_if_negatively_cached(int64 query_id, Promise<Unit> &promise) {
+  if (negative_result_cache_time_ <= 0) {
+    return false;
+  }
+  auto it = negative_results_.find(query_id);
+  if (it == negative_results_.end()) {
+    return false;
+  }
+  if (Time::now() >= it->second.expires_at) {
+    negative_results_.erase(it);
+    return false;
+  }
+  promise.set_error(it->second.error.clone());
+  return true;
+}
+
 void QueryCombiner::add_query(int64 query_id, Promise<Promise<Unit>> &&send_query, Promise<Unit> &&promise) {
   LOG(INFO) << "Add query " << query_id;
+  if (queries_.count(query_id) == 0 && fail_if_negatively_cached(query_id, promise)) {
+    return;
+  }
   auto &query = queries_[query_id];
   if (promise) {
     query.promises.push_back(std::move(promise));
@@ -63,6 +82,19 @@ void QueryCombiner::on_get_query_result(int64 query_id, Result<Unit> &&result) {
   auto promises = std::move(it->second.promises);
   queries_.erase(it);
 
+  if (result.is_error() && negative_result_cache_time_ > 0 && result.error().code() >= 400 &&
+      result.error().code() < 500) {
+    auto now = Time::now();
+    for (auto cached_it = negative_results_.begin(); cached_it != negative_results_.end();) {
+      if (now >= cached_it->second.expires_at) {
+        cached_it = negative_results_.erase(cached_it);
+      } else {
+        ++cached_it;
+      }
+    }
+    negative_results_[query_id] = NegativeResult{now + negative_result_cache_time_, result.error().clone()};
+  }
+
   for (auto &promise : promises) {
     if (result.is_ok()) {
       promise.set_value(Unit());
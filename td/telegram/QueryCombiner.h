@@ -21,7 +21,8 @@ namespace td {
 // combines identical queries into one request
 class QueryCombiner : public Actor {
  public:
-  explicit QueryCombiner(Slice name, double min_delay = 0) : min_delay_(min_delay) {
+  explicit QueryCombiner(Slice name, double min_delay = 0, double negative_result_cache_time = 0)
+      : min_delay_(min_delay), negative_result_cache_time_(negative_result_cache_time) {
     register_actor(name, this).release();
   }
 
@@ -34,15 +35,27 @@ class QueryCombiner : public Actor {
     Promise<Promise<Unit>> send_query;
   };
 
+  struct NegativeResult {
+    double expires_at = 0.0;
+    Status error;
+  };
+
   int32 query_count_ = 0;
 
   double next_query_time_ = 0.0;
   double min_delay_;
+  double negative_result_cache_time_;
 
   std::queue<int64> delayed_queries_;
 
   std::unordered_map<int64, QueryInfo> queries_;
 
+  // errors of recently failed queries; while an error isn't expired, identical queries
+  // are failed immediately instead of being sent to the server again
+  std::unordered_map<int64, NegativeResult> negative_results_;
+
+  bool fail_if_negatively_cached(int64 query_id, Promise<Unit> &promise);
+
   void do_send_query(int64 query_id, QueryInfo &query);
 
   void on_get_query_result(int64 query_id, Result<Unit> &&result);
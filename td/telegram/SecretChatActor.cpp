@@ -61,11 +61,29 @@ class SecretImpl {
   const Storer &data;
 };
 
+// decrypts payloads of inbound messages outside of the main scheduler; messages of one
+// chat are processed by one worker in order of arrival, so results are completed in order
+class SecretChatActor::CryptoWorker : public Actor {
+ public:
+  void decrypt(DecryptionContext decryption_context, BufferSlice encrypted_message,
+               Promise<std::tuple<uint64, BufferSlice, int32>> promise) {
+    promise.set_result(SecretChatActor::decrypt(decryption_context, encrypted_message));
+  }
+};
+
 SecretChatActor::SecretChatActor(int32 id, unique_ptr<Context> context, bool can_be_empty)
     : context_(std::move(context)), can_be_empty_(can_be_empty) {
   auth_state_.id = id;
 }
 
+ActorId<SecretChatActor::CryptoWorker> SecretChatActor::get_crypto_worker() {
+  if (crypto_worker_.empty()) {
+    crypto_worker_ = create_actor_on_scheduler<CryptoWorker>(PSLICE() << "SecretChatCryptoWorker " << auth_state_.id,
+                                                             context_->get_crypto_scheduler_id());
+  }
+  return crypto_worker_.get();
+}
+
 void SecretChatActor::update_chat(telegram_api::object_ptr<telegram_api::EncryptedChat> chat) {
   if (close_flag_) {
     return;
@@ -813,15 +831,16 @@ void SecretChatActor::tear_down() {
   // TODO notify send update that we are dead
 }
 
-Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSlice &encrypted_message) {
+Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(const DecryptionContext &decryption_context,
+                                                                        BufferSlice &encrypted_message) {
   MutableSlice data = encrypted_message.as_slice();
   CHECK(is_aligned_pointer<4>(data.data()));
   TRY_RESULT(auth_key_id, mtproto::Transport::read_auth_key_id(data));
-  mtproto::AuthKey *auth_key = nullptr;
-  if (auth_key_id == pfs_state_.auth_key.id()) {
-    auth_key = &pfs_state_.auth_key;
-  } else if (auth_key_id == pfs_state_.other_auth_key.id()) {
-    auth_key = &pfs_state_.other_auth_key;
+  const mtproto::AuthKey *auth_key = nullptr;
+  if (auth_key_id == decryption_context.auth_key.id()) {
+    auth_key = &decryption_context.auth_key;
+  } else if (auth_key_id == decryption_context.other_auth_key.id()) {
+    auth_key = &decryption_context.other_auth_key;
   } else {
     return Status::Error(1, PSLICE() << "Unknown " << tag("auth_key_id", format::as_hex(auth_key_id))
                                      << tag("crc", crc64(encrypted_message.as_slice())));
@@ -829,7 +848,7 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
 
   // expect that message is encrypted with mtproto 2.0 if his layer is at least MTPROTO_2_LAYER
   std::array<int, 2> versions{{1, 2}};
-  if (config_state_.his_layer >= MTPROTO_2_LAYER) {
+  if (decryption_context.his_layer >= MTPROTO_2_LAYER) {
     std::swap(versions[0], versions[1]);
   }
 
@@ -846,7 +865,7 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
     info.type = mtproto::PacketInfo::EndToEnd;
     mtproto_version = versions[i];
     info.version = mtproto_version;
-    info.is_creator = auth_state_.x == 0;
+    info.is_creator = decryption_context.x == 0;
     r_read_result = mtproto::Transport::read(data, *auth_key, &info);
     if (!is_last && r_read_result.is_error()) {
       LOG(WARNING) << tag("mtproto", mtproto_version) << " decryption failed " << r_read_result.error();
@@ -879,67 +898,94 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
 }
 
 Status SecretChatActor::do_inbound_message_encrypted(unique_ptr<logevent::InboundSecretMessage> message) {
-  SCOPE_EXIT {
-    if (message) {
-      message->qts_ack.set_value(Unit());
-    }
-  };
-  TRY_RESULT(decrypted, decrypt(message->encrypted_message));
-  auto auth_key_id = std::get<0>(decrypted);
-  auto data_buffer = std::move(std::get<1>(decrypted));
-  auto mtproto_version = std::get<2>(decrypted);
-  message->auth_key_id = auth_key_id;
-
-  TlBufferParser parser(&data_buffer);
-  auto id = parser.fetch_int();
-  Status status;
-  if (id == secret_api::decryptedMessageLayer::ID) {
-    auto message_with_layer = secret_api::decryptedMessageLayer::fetch(parser);
-    if (!parser.get_error()) {
-      auto layer = message_with_layer->layer_;
-      if (layer < DEFAULT_LAYER && false /*TODO: fix android app bug? */) {
-        LOG(ERROR) << "All or nothing, " << tag("layer", layer) << " is not supported, drop message "
-                   << to_string(message_with_layer);
-        return Status::OK();
-      }
-      if (config_state_.his_layer < layer) {
-        config_state_.his_layer = layer;
-        context_->secret_chat_db()->set_value(config_state_);
-        send_update_secret_chat();
-      }
-      if (layer >= MTPROTO_2_LAYER && mtproto_version < 2) {
-        return Status::Error(PSLICE() << "Mtproto 1.0 encryption is forbidden for this layer");
+  DecryptionContext decryption_context;
+  decryption_context.auth_key = pfs_state_.auth_key;
+  decryption_context.other_auth_key = pfs_state_.other_auth_key;
+  decryption_context.his_layer = config_state_.his_layer;
+  decryption_context.x = auth_state_.x;
+
+  auto encrypted_message = std::move(message->encrypted_message);
+  auto promise = PromiseCreator::lambda(
+      [actor_id = actor_id(this), message = std::move(message)](Result<std::tuple<uint64, BufferSlice, int32>>
+                                                                    r_decrypted) mutable {
+        send_closure(actor_id, &SecretChatActor::on_inbound_message_decrypted, std::move(message),
+                     std::move(r_decrypted));
+      });
+  send_closure(get_crypto_worker(), &CryptoWorker::decrypt, std::move(decryption_context), std::move(encrypted_message),
+               std::move(promise));
+  return Status::OK();
+}
+
+void SecretChatActor::on_inbound_message_decrypted(unique_ptr<logevent::InboundSecretMessage> message,
+                                                   Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted) {
+  if (close_flag_) {
+    message->qts_ack.set_value(Unit());
+    return;
+  }
+  check_status([&]() -> Status {
+    SCOPE_EXIT {
+      if (message) {
+        message->qts_ack.set_value(Unit());
       }
-      if (message_with_layer->in_seq_no_ < 0) {
-        return Status::Error(PSLICE() << "Invalid seq_no: " << to_string(message_with_layer));
+    };
+    TRY_RESULT(decrypted, std::move(r_decrypted));
+    auto auth_key_id = std::get<0>(decrypted);
+    auto data_buffer = std::move(std::get<1>(decrypted));
+    auto mtproto_version = std::get<2>(decrypted);
+    message->auth_key_id = auth_key_id;
+
+    TlBufferParser parser(&data_buffer);
+    auto id = parser.fetch_int();
+    Status status;
+    if (id == secret_api::decryptedMessageLayer::ID) {
+      auto message_with_layer = secret_api::decryptedMessageLayer::fetch(parser);
+      if (!parser.get_error()) {
+        auto layer = message_with_layer->layer_;
+        if (layer < DEFAULT_LAYER && false /*TODO: fix android app bug? */) {
+          LOG(ERROR) << "All or nothing, " << tag("layer", layer) << " is not supported, drop message "
+                     << to_string(message_with_layer);
+          return Status::OK();
+        }
+        if (config_state_.his_layer < layer) {
+          config_state_.his_layer = layer;
+          context_->secret_chat_db()->set_value(config_state_);
+          send_update_secret_chat();
+        }
+        if (layer >= MTPROTO_2_LAYER && mtproto_version < 2) {
+          return Status::Error(PSLICE() << "Mtproto 1.0 encryption is forbidden for this layer");
+        }
+        if (message_with_layer->in_seq_no_ < 0) {
+          return Status::Error(PSLICE() << "Invalid seq_no: " << to_string(message_with_layer));
+        }
+        message->decrypted_message_layer = std::move(message_with_layer);
+        return do_inbound_message_decrypted_unchecked(std::move(message));
+      } else {
+        status = Status::Error(PSLICE() << parser.get_error() << format::as_hex_dump<4>(data_buffer.as_slice()));
       }
-      message->decrypted_message_layer = std::move(message_with_layer);
-      return do_inbound_message_decrypted_unchecked(std::move(message));
     } else {
-      status = Status::Error(PSLICE() << parser.get_error() << format::as_hex_dump<4>(data_buffer.as_slice()));
+      status = Status::Error(PSLICE() << "Unknown constructor " << tag("ID", format::as_hex(id)));
     }
-  } else {
-    status = Status::Error(PSLICE() << "Unknown constructor " << tag("ID", format::as_hex(id)));
-  }
-
-  // support for older layer
-  LOG(WARNING) << "Failed to Fetch update: " << status;
-  send_action(secret_api::make_object<secret_api::decryptedMessageActionNotifyLayer>(MY_LAYER), SendFlag::None,
-              Promise<>());
 
-  if (config_state_.his_layer == 8) {
-    TlBufferParser new_parser(&data_buffer);
-    auto message_without_layer = secret_api::DecryptedMessage::fetch(new_parser);
-    if (!new_parser.get_error()) {
-      message->decrypted_message_layer = secret_api::make_object<secret_api::decryptedMessageLayer>(
-          BufferSlice(), config_state_.his_layer, -1, -1, std::move(message_without_layer));
-      return do_inbound_message_decrypted_unchecked(std::move(message));
+    // support for older layer
+    LOG(WARNING) << "Failed to Fetch update: " << status;
+    send_action(secret_api::make_object<secret_api::decryptedMessageActionNotifyLayer>(MY_LAYER), SendFlag::None,
+                Promise<>());
+
+    if (config_state_.his_layer == 8) {
+      TlBufferParser new_parser(&data_buffer);
+      auto message_without_layer = secret_api::DecryptedMessage::fetch(new_parser);
+      if (!new_parser.get_error()) {
+        message->decrypted_message_layer = secret_api::make_object<secret_api::decryptedMessageLayer>(
+            BufferSlice(), config_state_.his_layer, -1, -1, std::move(message_without_layer));
+        return do_inbound_message_decrypted_unchecked(std::move(message));
+      }
+      LOG(ERROR) << "Failed to fetch update (DecryptedMessage): " << new_parser.get_error()
+                 << format::as_hex_dump<4>(data_buffer.as_slice());
     }
-    LOG(ERROR) << "Failed to fetch update (DecryptedMessage): " << new_parser.get_error()
-               << format::as_hex_dump<4>(data_buffer.as_slice());
-  }
 
-  return status;
+    return status;
+  }());
+  loop();
 }
 
 Status SecretChatActor::check_seq_no(int in_seq_no, int out_seq_no, int32 his_layer) {
@@ -1398,18 +1444,37 @@ void SecretChatActor::on_save_changes_start(ChangesProcessor<StateChange>::Id sa
   if (close_flag_) {
     return;
   }
+  // don't save immediately; collect all changes which become ready in the same mailbox run
+  // (notably a binlog replay burst) and write only the newest state once
+  ready_save_changes_tokens_.push_back(save_changes_token);
+  if (!save_changes_scheduled_) {
+    save_changes_scheduled_ = true;
+    send_closure_later(actor_id(this), &SecretChatActor::do_save_changes);
+  }
+}
+
+void SecretChatActor::do_save_changes() {
+  if (close_flag_) {
+    return;
+  }
+  save_changes_scheduled_ = false;
+  auto tokens = std::move(ready_save_changes_tokens_);
+  ready_save_changes_tokens_.clear();
+
   SeqNoStateChange seq_no_state_change;
   PfsStateChange pfs_state_change;
   std::vector<Promise<Unit>> save_changes_finish_promises;
-  changes_processor_.finish(save_changes_token, [&](StateChange &&change) {
-    save_changes_finish_promises.emplace_back(std::move(change.save_changes_finish));
-    if (change.seq_no_state_change) {
-      seq_no_state_change = std::move(change.seq_no_state_change);
-    }
-    if (change.pfs_state_change) {
-      pfs_state_change = std::move(change.pfs_state_change);
-    }
-  });
+  for (auto token : tokens) {
+    changes_processor_.finish(token, [&](StateChange &&change) {
+      save_changes_finish_promises.emplace_back(std::move(change.save_changes_finish));
+      if (change.seq_no_state_change) {
+        seq_no_state_change = std::move(change.seq_no_state_change);
+      }
+      if (change.pfs_state_change) {
+        pfs_state_change = std::move(change.pfs_state_change);
+      }
+    });
+  }
   if (seq_no_state_change) {
     LOG(INFO) << "SAVE SeqNoState " << seq_no_state_change;
     context_->secret_chat_db()->set_value(seq_no_state_change);
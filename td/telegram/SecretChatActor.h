@@ -70,6 +70,12 @@ class SecretChatActor : public NetQueryCallback {
 
     virtual bool close_flag() = 0;
 
+    // scheduler, on which payload decryption is offloaded, so a burst of inbound secret chat
+    // messages doesn't block actors colocated with the SecretChatActor
+    virtual int32 get_crypto_scheduler_id() {
+      return Scheduler::instance()->sched_id();
+    }
+
     // We don't want to expose the whole NetQueryDispatcher, MessagesManager and ContactsManager.
     // So it is more clear which parts of MessagesManager are really used. And it is much easier to create tests.
     virtual void send_net_query(NetQueryPtr query, ActorShared<NetQueryCallback> callback, bool ordered) = 0;
@@ -517,6 +523,10 @@ class SecretChatActor : public NetQueryCallback {
   };
 
   ChangesProcessor<StateChange> changes_processor_;
+  // tokens whose changes are ready to be saved; they are flushed together, so a burst of
+  // changes (e.g. binlog replay) writes only its final state to the database
+  std::vector<ChangesProcessor<StateChange>::Id> ready_save_changes_tokens_;
+  bool save_changes_scheduled_ = false;
   int32 saved_pfs_state_message_id_;
 
   SeqNoState seq_no_state_;
@@ -533,6 +543,7 @@ class SecretChatActor : public NetQueryCallback {
   Promise<> add_changes(Promise<> save_changes_finish = Promise<>());
   // called only via Promise
   void on_save_changes_start(ChangesProcessor<StateChange>::Id save_changes_token);
+  void do_save_changes();
 
   // InboundMessage
   struct InboundMessageState {
@@ -545,9 +556,26 @@ class SecretChatActor : public NetQueryCallback {
 
   std::map<int32, unique_ptr<logevent::InboundSecretMessage>> pending_inbound_messages_;
 
-  Result<std::tuple<uint64, BufferSlice, int32>> decrypt(BufferSlice &encrypted_message);
+  // all state needed to decrypt a message payload, copied, so the decryption itself
+  // can be done without access to the actor
+  struct DecryptionContext {
+    mtproto::AuthKey auth_key;
+    mtproto::AuthKey other_auth_key;
+    int32 his_layer = 0;
+    int32 x = -1;
+  };
+  class CryptoWorker;
+
+  ActorOwn<CryptoWorker> crypto_worker_;
+
+  ActorId<CryptoWorker> get_crypto_worker();
+
+  static Result<std::tuple<uint64, BufferSlice, int32>> decrypt(const DecryptionContext &decryption_context,
+                                                                BufferSlice &encrypted_message);
 
   Status do_inbound_message_encrypted(unique_ptr<logevent::InboundSecretMessage> message);
+  void on_inbound_message_decrypted(unique_ptr<logevent::InboundSecretMessage> message,
+                                    Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted);
   Status do_inbound_message_decrypted_unchecked(unique_ptr<logevent::InboundSecretMessage> message);
   Status do_inbound_message_decrypted(unique_ptr<logevent::InboundSecretMessage> message);
   void do_inbound_message_decrypted_pending(unique_ptr<logevent::InboundSecretMessage> message);
@@ -430,6 +430,10 @@ unique_ptr<SecretChatActor::Context> SecretChatsManager::make_secret_chat_contex
       return G()->close_flag();
     }
 
+    int32 get_crypto_scheduler_id() override {
+      return G()->get_gc_scheduler_id();
+    }
+
     void on_update_secret_chat(int64 access_hash, UserId user_id, SecretChatState state, bool is_outbound, int32 ttl,
                                int32 date, string key_hash, int32 layer) override {
       send_closure(G()->contacts_manager(), &ContactsManager::on_update_secret_chat, secret_chat_id_, access_hash,
@@ -42,7 +42,9 @@ void SequenceDispatcher::send_with_callback(NetQueryPtr query, ActorShared<NetQu
   query->debug("Waiting at SequenceDispatcher");
   auto query_weak_ref = query.get_weak();
   data_.push_back(Data{State::Start, std::move(query_weak_ref), std::move(query), std::move(callback), 0, 0.0, 0.0});
-  loop();
+  // wait for other queries already waiting in the mailbox, so a burst of queries is
+  // dispatched in one loop() call and can be packed in one MTProto container
+  yield();
 }
 
 void SequenceDispatcher::check_timeout(Data &data) {
@@ -156,8 +158,7 @@ void SequenceDispatcher::loop() {
   if (next_i_ < finish_i_) {
     next_i_ = finish_i_;
   }
-  for (; next_i_ < data_.size() && data_[next_i_].state_ != State::Wait && wait_cnt_ < MAX_SIMULTANEOUS_WAIT;
-       next_i_++) {
+  for (; next_i_ < data_.size() && data_[next_i_].state_ != State::Wait; next_i_++) {
     if (data_[next_i_].state_ == State::Finish) {
       continue;
     }
@@ -165,6 +166,13 @@ void SequenceDispatcher::loop() {
     if (last_sent_i_ != std::numeric_limits<size_t>::max() && data_[last_sent_i_].state_ == State::Wait) {
       invoke_after = data_[last_sent_i_].net_query_ref_;
     }
+    // queries continuing an unbroken invokeAfter chain are processed by the server strictly
+    // in order and are resent as a whole chain on failure, so much more of them can be kept
+    // in flight than of queries beginning a new chain
+    auto max_wait_cnt = invoke_after.empty() ? MAX_SIMULTANEOUS_WAIT : MAX_SIMULTANEOUS_CHAINED_WAIT;
+    if (wait_cnt_ >= static_cast<uint32>(max_wait_cnt)) {
+      break;
+    }
     data_[next_i_].query_->set_invoke_after(invoke_after);
     data_[next_i_].query_->last_timeout = 0;
 
@@ -54,6 +54,7 @@ class SequenceDispatcher : public NetQueryCallback {
   uint32 session_rand_ = Random::secure_int32();
 
   static constexpr int32 MAX_SIMULTANEOUS_WAIT = 10;
+  static constexpr int32 MAX_SIMULTANEOUS_CHAINED_WAIT = 100;
   uint32 wait_cnt_ = 0;
 
   void check_timeout(Data &data);
@@ -33,6 +33,7 @@
 #include "td/actor/MultiPromise.h"
 #include "td/actor/PromiseFuture.h"
 
+#include "td/db/SqliteKeyValue.h"
 #include "td/db/SqliteKeyValueAsync.h"
 
 #include "td/utils/format.h"
@@ -873,6 +874,26 @@ class StickersManager::StickerListLogEvent {
   }
 };
 
+class StickersManager::StickerSetEmojisLogEvent {
+ public:
+  vector<string> emojis;
+
+  StickerSetEmojisLogEvent() = default;
+
+  explicit StickerSetEmojisLogEvent(vector<string> emojis) : emojis(std::move(emojis)) {
+  }
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(emojis, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(emojis, parser);
+  }
+};
+
 class StickersManager::StickerSetListLogEvent {
  public:
   vector<int64> sticker_set_ids;
@@ -1970,6 +1991,7 @@ vector<FileId> StickersManager::get_stickers(string emoji, int32 limit, bool for
       return {};
     }
     */
+    load_sticker_set_emojis_index();
   }
 
   vector<int64> sets_to_load;
@@ -1980,6 +2002,14 @@ vector<FileId> StickersManager::get_stickers(string emoji, int32 limit, bool for
     CHECK(sticker_set->is_inited);
     CHECK(!sticker_set->is_archived);
     if (!sticker_set->is_loaded) {
+      if (!emoji.empty()) {
+        auto it = sticker_set_emojis_index_.find(sticker_set_id);
+        if (it != sticker_set_emojis_index_.end() &&
+            std::find(it->second.begin(), it->second.end(), emoji) == it->second.end()) {
+          // the sticker set has no stickers for the emoji, so it doesn't need to be loaded
+          continue;
+        }
+      }
       sets_to_load.push_back(sticker_set_id);
       if (!sticker_set->was_loaded) {
         need_load = true;
@@ -2583,6 +2613,59 @@ string StickersManager::get_full_sticker_set_database_key(int64 set_id) {
   return PSTRING() << "ssf" << set_id;
 }
 
+string StickersManager::get_sticker_set_emojis_database_key(int64 set_id) {
+  return PSTRING() << "sse" << set_id;
+}
+
+string StickersManager::get_sticker_set_emojis_database_value(const StickerSet *s) {
+  vector<string> emojis;
+  emojis.reserve(s->emoji_stickers_map_.size());
+  for (auto &it : s->emoji_stickers_map_) {
+    emojis.push_back(it.first);
+  }
+  StickerSetEmojisLogEvent log_event(std::move(emojis));
+  return log_event_store(log_event).as_slice().str();
+}
+
+void StickersManager::load_sticker_set_emojis_index() {
+  if (is_sticker_set_emojis_index_loaded_ || !G()->parameters().use_file_db) {
+    return;
+  }
+  is_sticker_set_emojis_index_loaded_ = true;
+
+  vector<int64> set_ids;
+  vector<string> keys;
+  for (const auto &sticker_set_id : installed_sticker_set_ids_[0]) {
+    const StickerSet *sticker_set = get_sticker_set(sticker_set_id);
+    if (sticker_set == nullptr || sticker_set->is_loaded) {
+      // loaded sticker sets are searched through emoji_stickers_map_
+      continue;
+    }
+    set_ids.push_back(sticker_set_id);
+    keys.push_back(get_sticker_set_emojis_database_key(sticker_set_id));
+  }
+  if (keys.empty()) {
+    return;
+  }
+
+  auto values = G()->td_db()->get_sqlite_sync_pmc()->get_many(
+      transform(keys, [](const string &key) { return Slice(key); }));
+  CHECK(values.size() == set_ids.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    if (values[i].empty()) {
+      continue;
+    }
+    StickerSetEmojisLogEvent log_event;
+    if (log_event_parse(log_event, values[i]).is_error()) {
+      LOG(ERROR) << "Can't load emoji list of sticker set " << set_ids[i] << " from database";
+      G()->td_db()->get_sqlite_pmc()->erase(get_sticker_set_emojis_database_key(set_ids[i]), Auto());
+      continue;
+    }
+    sticker_set_emojis_index_.emplace(set_ids[i], std::move(log_event.emojis));
+  }
+  LOG(INFO) << "Loaded emoji lists of " << sticker_set_emojis_index_.size() << " sticker sets from database";
+}
+
 string StickersManager::get_sticker_set_database_value(const StickerSet *s, bool with_stickers) {
   LogEventStorerCalcLength storer_calc_length;
   store_sticker_set(s, with_stickers, storer_calc_length);
@@ -2611,6 +2694,10 @@ void StickersManager::update_sticker_set(StickerSet *sticker_set) {
       if (sticker_set->was_loaded) {
         G()->td_db()->get_sqlite_pmc()->set(get_full_sticker_set_database_key(sticker_set->id),
                                             get_sticker_set_database_value(sticker_set, true), Auto());
+        if (!td_->auth_manager_->is_bot()) {
+          G()->td_db()->get_sqlite_pmc()->set(get_sticker_set_emojis_database_key(sticker_set->id),
+                                              get_sticker_set_emojis_database_value(sticker_set), Auto());
+        }
       }
     }
     if (sticker_set->is_inited) {
@@ -2741,11 +2828,23 @@ void StickersManager::on_load_sticker_set_from_database(int64 sticker_set_id, bo
 
 void StickersManager::reload_sticker_set(int64 sticker_set_id,
                                          tl_object_ptr<telegram_api::InputStickerSet> &&input_sticker_set,
-                                         Promise<Unit> &&promise) const {
+                                         Promise<Unit> &&promise) {
   if (G()->close_flag()) {
     return promise.set_error(Status::Error(500, "Request aborted"));
   }
-  td_->create_handler<GetStickerSetQuery>(std::move(promise))->send(sticker_set_id, std::move(input_sticker_set));
+  if (sticker_set_id == 0) {
+    // identifier of the sticker set is unknown, so the query can't be combined with other queries
+    td_->create_handler<GetStickerSetQuery>(std::move(promise))->send(sticker_set_id, std::move(input_sticker_set));
+    return;
+  }
+  auto send_query = PromiseCreator::lambda([td = td_, sticker_set_id, input_sticker_set = std::move(
+                                                                          input_sticker_set)](
+                                               Result<Promise<Unit>> &&promise) mutable {
+    if (promise.is_ok()) {
+      td->create_handler<GetStickerSetQuery>(promise.move_as_ok())->send(sticker_set_id, std::move(input_sticker_set));
+    }
+  });
+  get_sticker_set_queries_.add_query(sticker_set_id, std::move(send_query), std::move(promise));
 }
 
 void StickersManager::on_install_sticker_set(int64 set_id, bool is_archived,
@@ -14,6 +14,7 @@
 #include "td/telegram/files/FileId.h"
 #include "td/telegram/files/FileSourceId.h"
 #include "td/telegram/Photo.h"
+#include "td/telegram/QueryCombiner.h"
 #include "td/telegram/SecretInputMedia.h"
 
 #include "td/utils/buffer.h"
@@ -310,6 +311,7 @@ class StickersManager : public Actor {
   };
 
   class StickerListLogEvent;
+  class StickerSetEmojisLogEvent;
   class StickerSetListLogEvent;
 
   class UploadStickerFileCallback;
@@ -347,6 +349,12 @@ class StickersManager : public Actor {
 
   static string get_full_sticker_set_database_key(int64 set_id);
 
+  static string get_sticker_set_emojis_database_key(int64 set_id);
+
+  static string get_sticker_set_emojis_database_value(const StickerSet *s);
+
+  void load_sticker_set_emojis_index();
+
   string get_sticker_set_database_value(const StickerSet *s, bool with_stickers);
 
   void update_sticker_set(StickerSet *sticker_set);
@@ -362,7 +370,7 @@ class StickersManager : public Actor {
   void update_load_request(uint32 load_request_id, const Status &status);
 
   void reload_sticker_set(int64 sticker_set_id, tl_object_ptr<telegram_api::InputStickerSet> &&input_sticker_set,
-                          Promise<Unit> &&promise) const;
+                          Promise<Unit> &&promise);
 
   static void read_featured_sticker_sets(void *td_void);
 
@@ -472,6 +480,13 @@ class StickersManager : public Actor {
   std::unordered_map<int64, unique_ptr<StickerSet>> sticker_sets_;        // id -> StickerSet
   std::unordered_map<string, int64> short_name_to_sticker_set_id_;
 
+  QueryCombiner get_sticker_set_queries_{"GetStickerSetCombiner"};
+
+  // emojis of not yet loaded sticker sets, persisted in the database, so emoji queries don't need
+  // to load every installed sticker set; can be stale until the set is actually loaded
+  std::unordered_map<int64, vector<string>> sticker_set_emojis_index_;
+  bool is_sticker_set_emojis_index_loaded_ = false;
+
   vector<int64> installed_sticker_set_ids_[2];
   vector<int64> featured_sticker_set_ids_;
   vector<FileId> recent_sticker_ids_[2];
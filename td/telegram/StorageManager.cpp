@@ -36,13 +36,15 @@ StorageManager::StorageManager(ActorShared<> parent, int32 scheduler_id)
 }
 
 void StorageManager::start_up() {
+  set_scheduling_class(ActorInfo::SchedulingClass::Background);
   load_last_gc_timestamp();
   schedule_next_gc();
 
   load_fast_stat();
+  load_aggregate_stats();
 }
 
-void StorageManager::on_new_file(int64 size, int32 cnt) {
+void StorageManager::on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt) {
   LOG(INFO) << "Add " << cnt << " file of size " << size << " to fast storage statistics";
   fast_stat_.cnt += cnt;
   fast_stat_.size += size;
@@ -52,6 +54,17 @@ void StorageManager::on_new_file(int64 size, int32 cnt) {
     fast_stat_ = FileTypeStat();
   }
   save_fast_stat();
+
+  if (has_aggregate_stats_) {
+    aggregate_stats_.apply_delta(file_type, owner_dialog_id, size, cnt);
+    auto &stat = aggregate_stats_.stat_by_type[static_cast<size_t>(file_type)];
+    if (stat.cnt < 0 || stat.size < 0) {
+      LOG(ERROR) << "Wrong aggregate stat for " << file_type << " after adding size " << size << " and cnt " << cnt;
+      drop_aggregate_stats();
+    } else if (++aggregate_unsaved_cnt_ >= AGGREGATE_SAVE_EACH) {
+      save_aggregate_stats();
+    }
+  }
 }
 
 void StorageManager::get_storage_stats(int32 dialog_limit, Promise<FileStats> promise) {
@@ -62,6 +75,21 @@ void StorageManager::get_storage_stats(int32 dialog_limit, Promise<FileStats> pr
   stats_dialog_limit_ = dialog_limit;
   pending_storage_stats_.emplace_back(std::move(promise));
 
+  if (has_aggregate_stats_ && (dialog_limit == 0 || aggregate_stats_.split_by_owner_dialog_id ||
+                               !G()->parameters().use_chat_info_db)) {
+    // served from the incrementally maintained counters; the daily gc rescan
+    // remains as an integrity check which repairs the counters on drift
+    FileStats stats;
+    stats.split_by_owner_dialog_id = dialog_limit != 0 && aggregate_stats_.split_by_owner_dialog_id;
+    if (stats.split_by_owner_dialog_id) {
+      stats.stat_by_owner_dialog_id = aggregate_stats_.stat_by_owner_dialog_id;
+    } else {
+      stats.stat_by_type = aggregate_stats_.stat_by_type;
+    }
+    send_stats(std::move(stats), stats_dialog_limit_, std::move(pending_storage_stats_));
+    return;
+  }
+
   create_stats_worker();
   send_closure(stats_worker_, &FileStatsWorker::get_stats, false /*need_all_files*/, stats_dialog_limit_ != 0,
                PromiseCreator::lambda([actor_id = actor_id(this)](Result<FileStats> file_stats) {
@@ -119,7 +147,9 @@ void StorageManager::on_file_stats(Result<FileStats> r_file_stats, bool dummy) {
     return;
   }
 
-  send_stats(r_file_stats.move_as_ok(), stats_dialog_limit_, std::move(pending_storage_stats_));
+  auto file_stats = r_file_stats.move_as_ok();
+  rebuild_aggregate_stats(file_stats);
+  send_stats(std::move(file_stats), stats_dialog_limit_, std::move(pending_storage_stats_));
 }
 
 void StorageManager::create_stats_worker() {
@@ -196,7 +226,9 @@ void StorageManager::on_gc_finished(Result<FileStats> r_file_stats, bool dummy)
     return;
   }
 
-  send_stats(r_file_stats.move_as_ok(), gc_parameters_.dialog_limit, std::move(pending_run_gc_));
+  auto file_stats = r_file_stats.move_as_ok();
+  rebuild_aggregate_stats(file_stats);
+  send_stats(std::move(file_stats), gc_parameters_.dialog_limit, std::move(pending_run_gc_));
 }
 
 void StorageManager::save_fast_stat() {
@@ -211,6 +243,73 @@ void StorageManager::load_fast_stat() {
   LOG(INFO) << "Loaded fast storage statistics with " << fast_stat_.cnt << " files of total size " << fast_stat_.size;
 }
 
+void StorageManager::save_aggregate_stats() {
+  aggregate_unsaved_cnt_ = 0;
+  G()->td_db()->get_binlog_pmc()->set("aggregate_file_stat", log_event_store(aggregate_stats_).as_slice().str());
+}
+
+void StorageManager::load_aggregate_stats() {
+  auto value = G()->td_db()->get_binlog_pmc()->get("aggregate_file_stat");
+  if (value.empty()) {
+    return;
+  }
+  auto status = log_event_parse(aggregate_stats_, value);
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to load aggregate storage statistics: " << status;
+    aggregate_stats_ = FileStats();
+    return;
+  }
+  has_aggregate_stats_ = true;
+  LOG(INFO) << "Loaded aggregate storage statistics for " << aggregate_stats_.stat_by_owner_dialog_id.size()
+            << " owner dialogs";
+}
+
+void StorageManager::drop_aggregate_stats() {
+  aggregate_stats_ = FileStats();
+  has_aggregate_stats_ = false;
+  aggregate_unsaved_cnt_ = 0;
+  G()->td_db()->get_binlog_pmc()->erase("aggregate_file_stat");
+}
+
+void StorageManager::rebuild_aggregate_stats(const FileStats &stats) {
+  FileStats new_stats;
+  new_stats.split_by_owner_dialog_id = stats.split_by_owner_dialog_id;
+  if (stats.split_by_owner_dialog_id) {
+    new_stats.stat_by_owner_dialog_id = stats.stat_by_owner_dialog_id;
+    for (auto &by_dialog : new_stats.stat_by_owner_dialog_id) {
+      for (int32 i = 0; i < file_type_size; i++) {
+        new_stats.stat_by_type[i].size += by_dialog.second[i].size;
+        new_stats.stat_by_type[i].cnt += by_dialog.second[i].cnt;
+      }
+    }
+  } else {
+    new_stats.stat_by_type = stats.stat_by_type;
+  }
+
+  if (has_aggregate_stats_) {
+    // the rescan acts as an integrity check of the incrementally maintained counters
+    bool is_consistent = true;
+    for (int32 i = 0; i < file_type_size; i++) {
+      if (aggregate_stats_.stat_by_type[i].size != new_stats.stat_by_type[i].size ||
+          aggregate_stats_.stat_by_type[i].cnt != new_stats.stat_by_type[i].cnt) {
+        is_consistent = false;
+        break;
+      }
+    }
+    if (!is_consistent) {
+      LOG(WARNING) << "Aggregate storage statistics drifted from the rescan result; rebuilding them";
+    } else if (!new_stats.split_by_owner_dialog_id && aggregate_stats_.split_by_owner_dialog_id) {
+      // a consistent rescan without per-dialog data shouldn't discard the per-dialog counters
+      new_stats.split_by_owner_dialog_id = true;
+      new_stats.stat_by_owner_dialog_id = std::move(aggregate_stats_.stat_by_owner_dialog_id);
+    }
+  }
+
+  aggregate_stats_ = std::move(new_stats);
+  has_aggregate_stats_ = true;
+  save_aggregate_stats();
+}
+
 void StorageManager::send_stats(FileStats &&stats, int32 dialog_limit, std::vector<Promise<FileStats>> promises) {
   fast_stat_ = stats.get_total_nontemp_stat();
   LOG(INFO) << "Recalculate fast storage statistics to " << fast_stat_.cnt << " files of total size "
@@ -237,6 +336,9 @@ ActorShared<> StorageManager::create_reference() {
 void StorageManager::hangup_shared() {
   ref_cnt_--;
   if (ref_cnt_ == 0) {
+    if (has_aggregate_stats_ && aggregate_unsaved_cnt_ > 0) {
+      save_aggregate_stats();
+    }
     stop();
   }
 }
@@ -9,9 +9,11 @@
 #include "td/actor/actor.h"
 #include "td/actor/PromiseFuture.h"
 
+#include "td/telegram/DialogId.h"
 #include "td/telegram/files/FileGcWorker.h"
 #include "td/telegram/files/FileStats.h"
 #include "td/telegram/files/FileStatsWorker.h"
+#include "td/telegram/files/FileType.h"
 #include "td/telegram/td_api.h"
 
 #include "td/utils/common.h"
@@ -37,12 +39,13 @@ class StorageManager : public Actor {
   void run_gc(FileGcParameters parameters, Promise<FileStats> promise);
   void update_use_storage_optimizer();
 
-  void on_new_file(int64 size, int32 cnt);
+  void on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt);
 
  private:
   static constexpr uint32 GC_EACH = 60 * 60 * 24;  // 1 day
   static constexpr uint32 GC_DELAY = 60;
   static constexpr uint32 GC_RAND_DELAY = 60 * 15;
+  static constexpr int32 AGGREGATE_SAVE_EACH = 128;  // number of file changes between aggregate statistics saves
 
   ActorShared<> parent_;
 
@@ -55,12 +58,22 @@ class StorageManager : public Actor {
 
   FileTypeStat fast_stat_;
 
+  // per-(file type, owner dialog) counters maintained incrementally on every file
+  // add and delete, so storage statistics don't need a rescan of all files
+  FileStats aggregate_stats_;
+  bool has_aggregate_stats_ = false;
+  int32 aggregate_unsaved_cnt_ = 0;
+
   void on_file_stats(Result<FileStats> r_file_stats, bool dummy);
   void create_stats_worker();
   void send_stats(FileStats &&stats, int32 dialog_limit, std::vector<Promise<FileStats>> promises);
 
   void save_fast_stat();
   void load_fast_stat();
+  void save_aggregate_stats();
+  void load_aggregate_stats();
+  void drop_aggregate_stats();
+  void rebuild_aggregate_stats(const FileStats &stats);
   static int64 get_database_size();
   static int64 get_language_pack_database_size();
   static int64 get_log_size();
@@ -42,6 +42,7 @@
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCounter.h"
 #include "td/telegram/net/NetQueryDelayer.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/net/NetStatsManager.h"
@@ -96,11 +97,13 @@
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
 #include "td/utils/Timer.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/utf8.h"
 
 #include <limits>
+#include <memory>
 #include <tuple>
 #include <type_traits>
 
@@ -3153,8 +3156,10 @@ bool Td::is_authentication_request(int32 id) {
   }
 }
 
-bool Td::is_synchronous_request(int32 id) {
-  switch (id) {
+bool Td::is_synchronous_request(const td_api::Function *function) {
+  switch (function->get_id()) {
+    case td_api::getOption::ID:
+      return is_synchronous_option(static_cast<const td_api::getOption *>(function)->name_);
     case td_api::getTextEntities::ID:
     case td_api::parseTextEntities::ID:
     case td_api::getFileMimeType::ID:
@@ -3178,6 +3183,12 @@ bool Td::is_synchronous_request(int32 id) {
   }
 }
 
+bool Td::is_synchronous_option(Slice name) {
+  // only options whose value is fixed for the lifetime of the process can be
+  // answered without the instance state
+  return name == "version";
+}
+
 bool Td::is_preinitialization_request(int32 id) {
   switch (id) {
     case td_api::getCurrentState::ID:
@@ -3284,7 +3295,7 @@ void Td::request(uint64 id, tl_object_ptr<td_api::Function> function) {
 
   VLOG(td_requests) << "Receive request " << id << ": " << to_string(function);
   int32 function_id = function->get_id();
-  if (is_synchronous_request(function_id)) {
+  if (is_synchronous_request(function.get())) {
     // send response synchronously
     return send_result(id, static_request(std::move(function)));
   }
@@ -3451,7 +3462,8 @@ void Td::force_get_difference() {
 
 void Td::on_result(NetQueryPtr query) {
   query->debug("Td: received from DcManager");
-  VLOG(net_query) << "Receive result of " << query;
+  query->trace_.delivered = Time::now();
+  VLOG(net_query) << "Receive result of " << query << " " << query->trace_;
   if (close_flag_ > 1) {
     return;
   }
@@ -3470,7 +3482,7 @@ void Td::on_result(NetQueryPtr query) {
       LOG(ERROR) << "Failed to fetch update: " << parser.get_error() << format::as_hex_dump<4>(ok.as_slice());
       updates_manager_->schedule_get_difference("failed to fetch update");
     } else {
-      updates_manager_->on_get_updates(std::move(ptr));
+      updates_manager_->on_get_updates_packet(std::move(ok), std::move(ptr));
       if (auth_manager_->is_bot()) {
         alarm_timeout_.set_timeout_in(PING_SERVER_ALARM_ID,
                                       PING_SERVER_TIMEOUT + Random::fast(0, PING_SERVER_TIMEOUT / 5));
@@ -3552,17 +3564,23 @@ void Td::on_config_option_updated(const string &name) {
     send_closure(top_dialog_manager_, &TopDialogManager::update_is_enabled,
                  !G()->shared_config().get_option_boolean(name));
   } else if (name == "is_emulator") {
-    if (G()->mtproto_header().set_is_emulator(G()->shared_config().get_option_boolean(name))) {
+    auto mtproto_header = std::make_shared<MtprotoHeader>(*G()->mtproto_header());
+    if (mtproto_header->set_is_emulator(G()->shared_config().get_option_boolean(name))) {
+      G()->set_mtproto_header(std::move(mtproto_header));
       G()->net_query_dispatcher().update_mtproto_header();
     }
   } else if (name == "localization_target") {
     send_closure(language_pack_manager_, &LanguagePackManager::on_language_pack_changed);
-    if (G()->mtproto_header().set_language_pack(G()->shared_config().get_option_string(name))) {
+    auto mtproto_header = std::make_shared<MtprotoHeader>(*G()->mtproto_header());
+    if (mtproto_header->set_language_pack(G()->shared_config().get_option_string(name))) {
+      G()->set_mtproto_header(std::move(mtproto_header));
       G()->net_query_dispatcher().update_mtproto_header();
     }
   } else if (name == "language_pack_id") {
     send_closure(language_pack_manager_, &LanguagePackManager::on_language_code_changed);
-    if (G()->mtproto_header().set_language_code(G()->shared_config().get_option_string(name))) {
+    auto mtproto_header = std::make_shared<MtprotoHeader>(*G()->mtproto_header());
+    if (mtproto_header->set_language_code(G()->shared_config().get_option_string(name))) {
+      G()->set_mtproto_header(std::move(mtproto_header));
       G()->net_query_dispatcher().update_mtproto_header();
     }
   } else if (name == "language_pack_version") {
@@ -4013,11 +4031,14 @@ Status Td::init(DbKey key) {
   options_.language_code = G()->shared_config().get_option_string("language_pack_id");
   options_.is_emulator = G()->shared_config().get_option_boolean("is_emulator");
   // options_.proxy = Proxy();
-  G()->set_mtproto_header(make_unique<MtprotoHeader>(options_));
+  G()->set_mtproto_header(std::make_shared<MtprotoHeader>(options_));
 
   VLOG(td_init) << "Create NetQueryDispatcher";
-  auto net_query_dispatcher = make_unique<NetQueryDispatcher>([&] { return create_reference(); });
-  G()->set_net_query_dispatcher(std::move(net_query_dispatcher));
+  if (!G()->have_net_query_dispatcher()) {
+    // a test or benchmark harness may have installed its own dispatcher
+    auto net_query_dispatcher = make_unique<NetQueryDispatcher>([&] { return create_reference(); });
+    G()->set_net_query_dispatcher(std::move(net_query_dispatcher));
+  }
 
   complete_pending_preauthentication_requests([](int32 id) {
     // pingProxy uses NetQueryDispatcher to get main_dc_id, so must be called after NetQueryDispatcher is created
@@ -4097,6 +4118,9 @@ Status Td::init(DbKey key) {
   send_closure_later(notification_manager_actor_, &NotificationManager::on_binlog_events,
                      std::move(events.to_notification_manager));
 
+  send_closure_later(updates_manager_actor_, &UpdatesManager::on_binlog_events,
+                     std::move(events.to_updates_manager));
+
   // NB: be very careful. This notification may be received before all binlog events are.
   G()->on_binlog_replay_finish();
   send_closure(secret_chats_manager_, &SecretChatsManager::binlog_replay_finish);
@@ -4235,8 +4259,8 @@ void Td::init_file_manager() {
     explicit FileManagerContext(Td *td) : td_(td) {
     }
 
-    void on_new_file(int64 size, int32 cnt) final {
-      send_closure(G()->storage_manager(), &StorageManager::on_new_file, size, cnt);
+    void on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt) final {
+      send_closure(G()->storage_manager(), &StorageManager::on_new_file, file_type, owner_dialog_id, size, cnt);
     }
 
     void on_file_updated(FileId file_id) final {
@@ -4279,6 +4303,7 @@ void Td::init_file_manager() {
 
   file_manager_ = make_unique<FileManager>(make_unique<FileManagerContext>(this));
   file_manager_actor_ = register_actor("FileManager", file_manager_.get());
+  file_manager_->set_memory_tag(static_cast<int32>(TdMemoryTag::FileManager));
   file_manager_->init_actor();
   G()->set_file_manager(file_manager_actor_.get());
 
@@ -4301,11 +4326,13 @@ void Td::init_managers() {
   G()->set_animations_manager(animations_manager_actor_.get());
   contacts_manager_ = make_unique<ContactsManager>(this, create_reference());
   contacts_manager_actor_ = register_actor("ContactsManager", contacts_manager_.get());
+  contacts_manager_->set_memory_tag(static_cast<int32>(TdMemoryTag::ContactsManager));
   G()->set_contacts_manager(contacts_manager_actor_.get());
   inline_queries_manager_ = make_unique<InlineQueriesManager>(this, create_reference());
   inline_queries_manager_actor_ = register_actor("InlineQueriesManager", inline_queries_manager_.get());
   messages_manager_ = make_unique<MessagesManager>(this, create_reference());
   messages_manager_actor_ = register_actor("MessagesManager", messages_manager_.get());
+  messages_manager_->set_memory_tag(static_cast<int32>(TdMemoryTag::MessagesManager));
   G()->set_messages_manager(messages_manager_actor_.get());
   notification_manager_ = make_unique<NotificationManager>(this, create_reference());
   notification_manager_actor_ = register_actor("NotificationManager", notification_manager_.get());
@@ -4357,6 +4384,9 @@ void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
     // just in case
     return;
   }
+  if (is_update_suppressed(object_id)) {
+    return;
+  }
 
   switch (object_id) {
     case td_api::updateFavoriteStickers::ID:
@@ -5124,6 +5154,27 @@ void Td::on_request(uint64 id, td_api::setNetworkType &request) {
   promise.set_value(Unit());
 }
 
+void Td::on_request(uint64 id, const td_api::getNetworkQueryStatistics &request) {
+  CREATE_REQUEST_PROMISE();
+  auto result = make_tl_object<td_api::networkQueryStatistics>();
+  auto &stats = NetQueryStats::instance();
+  for (auto &entry : stats.get_type_stats()) {
+    auto &stat = entry.second;
+    result->entries_.push_back(make_tl_object<td_api::networkQueryTypeStatistics>(
+        entry.first, static_cast<int64>(stat.created_count), static_cast<int64>(stat.sent_count),
+        static_cast<int64>(stat.answered_count), static_cast<int64>(stat.failed_count),
+        static_cast<int64>(stat.resent_count), stat.total_latency, stat.max_latency));
+  }
+  for (auto &dc_entry : stats.get_inflight_counts()) {
+    result->dc_entries_.push_back(make_tl_object<td_api::networkQueryDcStatistics>(dc_entry.first, dc_entry.second));
+  }
+  for (auto &session_entry : stats.get_session_pipeline_stats()) {
+    result->session_entries_.push_back(make_tl_object<td_api::networkQuerySessionStatistics>(
+        session_entry.dc_id, session_entry.is_main, session_entry.inflight_count, session_entry.window_size));
+  }
+  promise.set_value(std::move(result));
+}
+
 void Td::on_request(uint64 id, td_api::getTopChats &request) {
   CHECK_IS_USER();
   CREATE_REQUEST_PROMISE();
@@ -6686,6 +6737,19 @@ void Td::on_request(uint64 id, td_api::setOption &request) {
   return send_error_raw(id, 3, "Option can't be set");
 }
 
+void Td::on_request(uint64 id, const td_api::setSuppressedUpdates &request) {
+  CREATE_OK_REQUEST_PROMISE();
+  suppressed_update_ids_.clear();
+  for (auto constructor_id : request.update_constructors_) {
+    if (constructor_id == td_api::updateAuthorizationState::ID) {
+      // the client can't work without knowing the authorization state
+      continue;
+    }
+    suppressed_update_ids_.insert(constructor_id);
+  }
+  promise.set_value(Unit());
+}
+
 void Td::on_request(uint64 id, td_api::setPollAnswer &request) {
   CHECK_IS_USER();
   CREATE_OK_REQUEST_PROMISE();
@@ -7193,6 +7257,16 @@ void Td::on_request(uint64 id, const td_api::addLogMessage &request) {
   UNREACHABLE();
 }
 
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getOption &request) {
+  if (!is_synchronous_option(request.name_)) {
+    return make_error(400, "The option can't be got synchronously");
+  }
+  if (request.name_ == "version") {
+    return td_api::make_object<td_api::optionValueString>(TDLIB_VERSION);
+  }
+  UNREACHABLE();
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getTextEntities &request) {
   if (!check_utf8(request.text_)) {
     return make_error(400, "Text must be encoded in UTF-8");
@@ -75,6 +75,10 @@ namespace td {
 
 extern int VERBOSITY_NAME(td_init);
 
+// memory tags of the biggest managers; the live bytes charged to a tag can be
+// queried with get_memory_tag_size from td/utils/MemoryTag.h
+enum class TdMemoryTag : int32 { Other = 0, MessagesManager = 1, ContactsManager = 2, FileManager = 3 };
+
 // Td may start closing after explicit "close" or "destroy" query.
 // Or it may start closing by itself, because authorization is lost.
 // It any case the parent will be notified via updateAuthorizationState.
@@ -219,6 +223,12 @@ class Td final : public NetQueryCallback {
 
   void send_update(tl_object_ptr<td_api::Update> &&object);
 
+  // true when the client asked not to receive updates of this type; checked in send_update,
+  // and may be checked before an update object is built to skip the construction as well
+  bool is_update_suppressed(int32 update_id) const {
+    return !suppressed_update_ids_.empty() && suppressed_update_ids_.count(update_id) != 0;
+  }
+
   ActorShared<Td> create_reference();
 
   static td_api::object_ptr<td_api::Object> static_request(td_api::object_ptr<td_api::Function> function);
@@ -255,6 +265,7 @@ class Td final : public NetQueryCallback {
   StateManager::State connection_state_;
 
   std::unordered_multiset<uint64> request_set_;
+  std::unordered_set<int32> suppressed_update_ids_;
   int actor_refcnt_ = 0;
   int request_actor_refcnt_ = 0;
   int stop_cnt_ = 2;
@@ -349,7 +360,9 @@ class Td final : public NetQueryCallback {
 
   static bool is_authentication_request(int32 id);
 
-  static bool is_synchronous_request(int32 id);
+  static bool is_synchronous_request(const td_api::Function *function);
+
+  static bool is_synchronous_option(Slice name);
 
   static bool is_preinitialization_request(int32 id);
 
@@ -492,6 +505,8 @@ class Td final : public NetQueryCallback {
 
   void on_request(uint64 id, td_api::setNetworkType &request);
 
+  void on_request(uint64 id, const td_api::getNetworkQueryStatistics &request);
+
   void on_request(uint64 id, td_api::getTopChats &request);
 
   void on_request(uint64 id, const td_api::removeTopChat &request);
@@ -856,6 +871,8 @@ class Td final : public NetQueryCallback {
 
   void on_request(uint64 id, td_api::setOption &request);
 
+  void on_request(uint64 id, const td_api::setSuppressedUpdates &request);
+
   void on_request(uint64 id, td_api::setPollAnswer &request);
 
   void on_request(uint64 id, td_api::stopPoll &request);
@@ -1020,6 +1037,7 @@ class Td final : public NetQueryCallback {
   static td_api::object_ptr<td_api::Object> do_static_request(const T &request) {
     return td_api::make_object<td_api::error>(400, "Function can't be executed synchronously");
   }
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getOption &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getTextEntities &request);
   static td_api::object_ptr<td_api::Object> do_static_request(td_api::parseTextEntities &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getFileMimeType &request);
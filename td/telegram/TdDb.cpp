@@ -29,7 +29,9 @@
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/StringBuilder.h"
 
@@ -113,6 +115,9 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
       case LogEvent::HandlerType::EditMessagePushNotification:
         events.to_notification_manager.push_back(event.clone());
         break;
+      case LogEvent::HandlerType::ReceivedUpdates:
+        events.to_updates_manager.push_back(event.clone());
+        break;
       case LogEvent::HandlerType::BinlogPmcMagic:
         binlog_pmc.external_init_handle(event);
         break;
@@ -131,6 +136,32 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
   return Status::OK();
 }
 
+// Sequentially reads the head of the SQLite database and its WAL, so the pages
+// touched by the schema checks are in the OS page cache by the time the
+// database is opened. The database can be opened only after the binlog is
+// loaded, because its key is stored there, but this read-ahead needs no key
+// and can run in parallel with the binlog loading.
+void read_ahead_sqlite(const string &path) {
+  constexpr int64 MAX_READ_AHEAD_SIZE = 16 << 20;
+  for (auto &file_path : {path, path + "-wal"}) {
+    auto r_fd = FileFd::open(file_path, FileFd::Read);
+    if (r_fd.is_error()) {
+      continue;
+    }
+    auto fd = r_fd.move_as_ok();
+    string buf(1 << 16, '\0');
+    int64 total_size = 0;
+    while (total_size < MAX_READ_AHEAD_SIZE) {
+      auto r_size = fd.read(buf);
+      if (r_size.is_error() || r_size.ok() == 0) {
+        break;
+      }
+      total_size += static_cast<int64>(r_size.ok());
+    }
+    fd.close();
+  }
+}
+
 Status init_db(SqliteDb &db) {
   TRY_STATUS(db.exec("PRAGMA encoding=\"UTF-8\""));
   TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
@@ -352,7 +383,10 @@ Status TdDb::init_sqlite(int32 scheduler_id, const TdParameters &parameters, DbK
   if (user_version == 0) {
     binlog_pmc.erase("next_contacts_sync_date");
   }
-  binlog_pmc.force_sync({});
+  if (dialog_db_was_created || user_version == 0) {
+    // the erased keys must not reappear after a crash once the new database is committed
+    binlog_pmc.force_sync({});
+  }
 
   TRY_STATUS(db.exec("COMMIT TRANSACTION"));
 
@@ -384,11 +418,23 @@ Status TdDb::init(int32 scheduler_id, const TdParameters &parameters, DbKey key,
   binlog_pmc->external_init_begin(static_cast<int32>(LogEvent::HandlerType::BinlogPmcMagic));
   config_pmc->external_init_begin(static_cast<int32>(LogEvent::HandlerType::ConfigPmcMagic));
 
+#if !TD_THREAD_UNSUPPORTED
+  // warm up the SQLite file cache while the binlog is replayed
+  thread read_ahead_thread;
+  if (parameters.use_file_db) {
+    read_ahead_thread = thread(read_ahead_sqlite, get_sqlite_path(parameters));
+  }
+#endif
+
   bool encrypt_binlog = !key.is_empty();
   VLOG(td_init) << "Start binlog loading";
   TRY_STATUS(init_binlog(*binlog, get_binlog_path(parameters), *binlog_pmc, *config_pmc, events, std::move(key)));
   VLOG(td_init) << "Finish binlog loading";
 
+#if !TD_THREAD_UNSUPPORTED
+  read_ahead_thread.join();
+#endif
+
   binlog_pmc->external_init_finish(binlog);
   VLOG(td_init) << "Finish initialization of binlog PMC";
   config_pmc->external_init_finish(binlog);
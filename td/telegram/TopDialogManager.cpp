@@ -55,6 +55,18 @@ static CSlice top_dialog_category_name(TopDialogCategory category) {
   }
 }
 
+static string get_top_dialogs_database_key(TopDialogCategory category) {
+  return PSTRING() << "top_dialogs#" << top_dialog_category_name(category);
+}
+
+static string get_top_dialog_database_key_prefix(TopDialogCategory category) {
+  return PSTRING() << "top_dialogs#" << top_dialog_category_name(category) << '#';
+}
+
+static string get_top_dialog_database_key(TopDialogCategory category, DialogId dialog_id) {
+  return PSTRING() << "top_dialogs#" << top_dialog_category_name(category) << '#' << dialog_id.get();
+}
+
 static TopDialogCategory top_dialog_category_from_telegram_api(const telegram_api::TopPeerCategory &category) {
   switch (category.get_id()) {
     case telegram_api::topPeerCategoryCorrespondents::ID:
@@ -140,15 +152,18 @@ void TopDialogManager::on_dialog_used(TopDialogCategory category, DialogId dialo
   CHECK(pos < by_category_.size());
   auto &top_dialogs = by_category_[pos];
 
-  top_dialogs.is_dirty = true;
-  auto it = std::find_if(top_dialogs.dialogs.begin(), top_dialogs.dialogs.end(),
-                         [&](auto &top_dialog) { return top_dialog.dialog_id == dialog_id; });
-  if (it == top_dialogs.dialogs.end()) {
+  auto position_it = top_dialogs.dialog_positions.find(dialog_id);
+  size_t dialog_pos;
+  if (position_it == top_dialogs.dialog_positions.end()) {
     TopDialog top_dialog;
     top_dialog.dialog_id = dialog_id;
     top_dialogs.dialogs.push_back(top_dialog);
-    it = top_dialogs.dialogs.end() - 1;
+    dialog_pos = top_dialogs.dialogs.size() - 1;
+    top_dialogs.dialog_positions[dialog_id] = dialog_pos;
+  } else {
+    dialog_pos = position_it->second;
   }
+  auto it = top_dialogs.dialogs.begin() + dialog_pos;
 
   auto delta = rating_add(date, top_dialogs.rating_timestamp);
   it->rating += delta;
@@ -157,10 +172,13 @@ void TopDialogManager::on_dialog_used(TopDialogCategory category, DialogId dialo
     if (*next < *it) {
       break;
     }
+    std::swap(top_dialogs.dialog_positions[next->dialog_id], top_dialogs.dialog_positions[it->dialog_id]);
     std::swap(*next, *it);
     it = next;
   }
 
+  top_dialogs.dirty_dialog_ids.insert(dialog_id);
+
   LOG(INFO) << "Update " << top_dialog_category_name(category) << " rating of " << dialog_id << " by " << delta;
 
   if (!first_unsync_change_) {
@@ -188,14 +206,15 @@ void TopDialogManager::remove_dialog(TopDialogCategory category, DialogId dialog
     G()->net_query_dispatcher().dispatch_with_callback(std::move(net_query), actor_shared(this, 1));
   }
 
-  auto it = std::find_if(top_dialogs.dialogs.begin(), top_dialogs.dialogs.end(),
-                         [&](auto &top_dialog) { return top_dialog.dialog_id == dialog_id; });
-  if (it == top_dialogs.dialogs.end()) {
+  auto position_it = top_dialogs.dialog_positions.find(dialog_id);
+  if (position_it == top_dialogs.dialog_positions.end()) {
     return;
   }
 
+  // removals are rare and must also disappear from the saved list, so they force a full rewrite
   top_dialogs.is_dirty = true;
-  top_dialogs.dialogs.erase(it);
+  top_dialogs.dialogs.erase(top_dialogs.dialogs.begin() + position_it->second);
+  rebuild_dialog_positions(top_dialogs);
   if (!first_unsync_change_) {
     first_unsync_change_ = Timestamp::now_cached();
   }
@@ -263,6 +282,13 @@ double TopDialogManager::current_rating_add(double rating_timestamp) const {
   return rating_add(G()->server_time_cached(), rating_timestamp);
 }
 
+void TopDialogManager::rebuild_dialog_positions(TopDialogs &top_dialogs) {
+  top_dialogs.dialog_positions.clear();
+  for (size_t i = 0; i < top_dialogs.dialogs.size(); i++) {
+    top_dialogs.dialog_positions[top_dialogs.dialogs[i].dialog_id] = i;
+  }
+}
+
 void TopDialogManager::normalize_rating() {
   for (auto &top_dialogs : by_category_) {
     auto div_by = current_rating_add(top_dialogs.rating_timestamp);
@@ -441,6 +467,8 @@ void TopDialogManager::on_result(NetQueryPtr net_query) {
           top_dialog.rating = top_peer->rating_;
           top_dialogs.dialogs.push_back(std::move(top_dialog));
         }
+        top_dialogs.dirty_dialog_ids.clear();
+        rebuild_dialog_positions(top_dialogs);
       }
       db_sync_state_ = SyncState::None;
       break;
@@ -454,21 +482,36 @@ void TopDialogManager::do_save_top_dialogs() {
   LOG(INFO) << "Save top chats";
   for (size_t top_dialog_category_i = 0; top_dialog_category_i < by_category_.size(); top_dialog_category_i++) {
     auto top_dialog_category = TopDialogCategory(top_dialog_category_i);
-    auto key = PSTRING() << "top_dialogs#" << top_dialog_category_name(top_dialog_category);
 
     auto &top_dialogs = by_category_[top_dialog_category_i];
-    if (!top_dialogs.is_dirty) {
-      continue;
+    if (top_dialogs.is_dirty) {
+      // full rewrite of the category; drops per-dialog deltas, which are merged into the saved list
+      top_dialogs.is_dirty = false;
+      top_dialogs.dirty_dialog_ids.clear();
+
+      G()->td_db()->get_binlog_pmc()->erase_by_prefix(get_top_dialog_database_key_prefix(top_dialog_category));
+      G()->td_db()->get_binlog_pmc()->set(get_top_dialogs_database_key(top_dialog_category),
+                                          log_event_store(top_dialogs).as_slice().str());
+    } else if (!top_dialogs.dirty_dialog_ids.empty()) {
+      // save only dialogs with changed rating instead of rewriting the whole list
+      for (auto dialog_id : top_dialogs.dirty_dialog_ids) {
+        auto position_it = top_dialogs.dialog_positions.find(dialog_id);
+        if (position_it == top_dialogs.dialog_positions.end()) {
+          continue;
+        }
+        const auto &top_dialog = top_dialogs.dialogs[position_it->second];
+        G()->td_db()->get_binlog_pmc()->set(get_top_dialog_database_key(top_dialog_category, dialog_id),
+                                            log_event_store(top_dialog).as_slice().str());
+      }
+      top_dialogs.dirty_dialog_ids.clear();
     }
-    top_dialogs.is_dirty = false;
-
-    G()->td_db()->get_binlog_pmc()->set(key, log_event_store(top_dialogs).as_slice().str());
   }
   db_sync_state_ = SyncState::Ok;
   first_unsync_change_ = Timestamp();
 }
 
 void TopDialogManager::start_up() {
+  set_scheduling_class(ActorInfo::SchedulingClass::Background);
   do_start_up();
 }
 
@@ -515,15 +558,30 @@ void TopDialogManager::init() {
   if (is_enabled_) {
     for (size_t top_dialog_category_i = 0; top_dialog_category_i < by_category_.size(); top_dialog_category_i++) {
       auto top_dialog_category = TopDialogCategory(top_dialog_category_i);
-      auto key = PSTRING() << "top_dialogs#" << top_dialog_category_name(top_dialog_category);
-      auto value = G()->td_db()->get_binlog_pmc()->get(key);
+      auto value = G()->td_db()->get_binlog_pmc()->get(get_top_dialogs_database_key(top_dialog_category));
 
       auto &top_dialogs = by_category_[top_dialog_category_i];
       top_dialogs.is_dirty = false;
-      if (value.empty()) {
-        continue;
+      top_dialogs.dirty_dialog_ids.clear();
+      if (!value.empty()) {
+        log_event_parse(top_dialogs, value).ensure();
+      }
+
+      // apply per-dialog deltas saved since the last full rewrite of the category
+      for (auto &delta :
+           G()->td_db()->get_binlog_pmc()->prefix_get(get_top_dialog_database_key_prefix(top_dialog_category))) {
+        TopDialog top_dialog;
+        log_event_parse(top_dialog, delta.second).ensure();
+        auto it = std::find_if(top_dialogs.dialogs.begin(), top_dialogs.dialogs.end(),
+                               [&](auto &other) { return other.dialog_id == top_dialog.dialog_id; });
+        if (it == top_dialogs.dialogs.end()) {
+          top_dialogs.dialogs.push_back(top_dialog);
+        } else {
+          it->rating = top_dialog.rating;
+        }
       }
-      log_event_parse(top_dialogs, value).ensure();
+      std::sort(top_dialogs.dialogs.begin(), top_dialogs.dialogs.end());
+      rebuild_dialog_positions(top_dialogs);
     }
     normalize_rating();
   } else {
@@ -532,6 +590,8 @@ void TopDialogManager::init() {
       top_dialogs.is_dirty = false;
       top_dialogs.rating_timestamp = 0;
       top_dialogs.dialogs.clear();
+      top_dialogs.dialog_positions.clear();
+      top_dialogs.dirty_dialog_ids.clear();
     }
   }
   db_sync_state_ = SyncState::Ok;
@@ -19,6 +19,8 @@
 #include "td/utils/Time.h"
 
 #include <array>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace td {
@@ -102,6 +104,12 @@ class TopDialogManager : public NetQueryCallback {
     bool is_dirty = false;
     double rating_timestamp = 0;
     std::vector<TopDialog> dialogs;
+
+    // positions of dialogs in the sorted list, so a rating update doesn't need a linear search
+    std::unordered_map<DialogId, size_t, DialogIdHash> dialog_positions;
+    // dialogs with rating changed since the last save; they are saved one by one,
+    // while is_dirty forces a full rewrite of the category
+    std::unordered_set<DialogId, DialogIdHash> dirty_dialog_ids;
   };
   template <class StorerT>
   friend void store(const TopDialog &top_dialog, StorerT &storer);
@@ -118,6 +126,8 @@ class TopDialogManager : public NetQueryCallback {
   double current_rating_add(double rating_timestamp) const;
   void normalize_rating();
 
+  static void rebuild_dialog_positions(TopDialogs &top_dialogs);
+
   bool set_is_enabled(bool is_enabled);
   void send_toggle_top_peers(bool is_enabled);
 
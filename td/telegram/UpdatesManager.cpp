@@ -18,6 +18,7 @@
 #include "td/telegram/ContactsManager.h"
 #include "td/telegram/DialogId.h"
 #include "td/telegram/Global.h"
+#include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/InlineQueriesManager.h"
 #include "td/telegram/LanguagePackManager.h"
 #include "td/telegram/Location.h"
@@ -38,6 +39,8 @@
 #include "td/telegram/TdDb.h"
 #include "td/telegram/WebPagesManager.h"
 
+#include "td/db/binlog/BinlogHelper.h"
+
 #include "td/utils/buffer.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -45,7 +48,9 @@
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/Storer.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/tl_parsers.h"
 
 #include <limits>
 
@@ -563,34 +568,34 @@ bool UpdatesManager::is_acceptable_update(const telegram_api::Update *update) co
   if (update == nullptr) {
     return true;
   }
-  int32 id = update->get_id();
   const telegram_api::Message *message = nullptr;
-  if (id == telegram_api::updateNewMessage::ID) {
-    message = static_cast<const telegram_api::updateNewMessage *>(update)->message_.get();
-  }
-  if (id == telegram_api::updateNewChannelMessage::ID) {
-    message = static_cast<const telegram_api::updateNewChannelMessage *>(update)->message_.get();
-  }
-  if (id == telegram_api::updateEditMessage::ID) {
-    message = static_cast<const telegram_api::updateEditMessage *>(update)->message_.get();
-  }
-  if (id == telegram_api::updateEditChannelMessage::ID) {
-    message = static_cast<const telegram_api::updateEditChannelMessage *>(update)->message_.get();
-  }
-  if (message != nullptr) {
-    return is_acceptable_message(message);
-  }
-
-  if (id == telegram_api::updateDraftMessage::ID) {
-    auto update_draft_message = static_cast<const telegram_api::updateDraftMessage *>(update);
-    CHECK(update_draft_message->draft_ != nullptr);
-    if (update_draft_message->draft_->get_id() == telegram_api::draftMessage::ID) {
-      auto draft_message = static_cast<const telegram_api::draftMessage *>(update_draft_message->draft_.get());
-      return is_acceptable_message_entities(draft_message->entities_);
+  switch (update->get_id()) {
+    case telegram_api::updateNewChannelMessage::ID:
+      message = static_cast<const telegram_api::updateNewChannelMessage *>(update)->message_.get();
+      break;
+    case telegram_api::updateNewMessage::ID:
+      message = static_cast<const telegram_api::updateNewMessage *>(update)->message_.get();
+      break;
+    case telegram_api::updateEditMessage::ID:
+      message = static_cast<const telegram_api::updateEditMessage *>(update)->message_.get();
+      break;
+    case telegram_api::updateEditChannelMessage::ID:
+      message = static_cast<const telegram_api::updateEditChannelMessage *>(update)->message_.get();
+      break;
+    case telegram_api::updateDraftMessage::ID: {
+      auto update_draft_message = static_cast<const telegram_api::updateDraftMessage *>(update);
+      CHECK(update_draft_message->draft_ != nullptr);
+      if (update_draft_message->draft_->get_id() == telegram_api::draftMessage::ID) {
+        auto draft_message = static_cast<const telegram_api::draftMessage *>(update_draft_message->draft_.get());
+        return is_acceptable_message_entities(draft_message->entities_);
+      }
+      return true;
     }
+    default:
+      return true;
   }
-
-  return true;
+  CHECK(message != nullptr);
+  return is_acceptable_message(message);
 }
 
 void UpdatesManager::on_get_updates(tl_object_ptr<telegram_api::Updates> &&updates_ptr) {
@@ -696,6 +701,62 @@ void UpdatesManager::on_get_updates(tl_object_ptr<telegram_api::Updates> &&updat
   }
 }
 
+void UpdatesManager::on_get_updates_packet(BufferSlice &&packet, tl_object_ptr<telegram_api::Updates> &&updates_ptr) {
+  add_update_journal_event(packet.as_slice());
+  on_get_updates(std::move(updates_ptr));
+  try_flush_update_journal();
+}
+
+void UpdatesManager::add_update_journal_event(Slice packet) {
+  if (!td_->auth_manager_->is_authorized() || G()->ignore_backgrond_updates()) {
+    return;
+  }
+  if (update_journal_event_ids_.size() >= MAX_UPDATE_JOURNAL_SIZE) {
+    // we are too far behind; getDifference after a crash will cover the dropped tail anyway
+    binlog_erase(G()->td_db()->get_binlog(), update_journal_event_ids_.front());
+    update_journal_event_ids_.erase(update_journal_event_ids_.begin());
+  }
+  update_journal_event_ids_.push_back(
+      binlog_add(G()->td_db()->get_binlog(), LogEvent::HandlerType::ReceivedUpdates, create_storer(packet)));
+}
+
+void UpdatesManager::try_flush_update_journal() {
+  if (update_journal_event_ids_.empty()) {
+    return;
+  }
+  if (running_get_difference_ || !postponed_updates_.empty() || !pending_seq_updates_.empty()) {
+    return;
+  }
+  // all received containers were applied; their effects are persisted through
+  // the usual pts/qts/seq saving, so the journal can be dropped
+  for (auto logevent_id : update_journal_event_ids_) {
+    binlog_erase(G()->td_db()->get_binlog(), logevent_id);
+  }
+  update_journal_event_ids_.clear();
+}
+
+void UpdatesManager::on_binlog_events(vector<BinlogEvent> &&events) {
+  for (auto &event : events) {
+    if (!td_->auth_manager_->is_authorized() || G()->ignore_backgrond_updates()) {
+      binlog_erase(G()->td_db()->get_binlog(), event.id_);
+      continue;
+    }
+    auto packet = BufferSlice(event.data_);
+    TlBufferParser parser(&packet);
+    auto updates_ptr = telegram_api::Updates::fetch(parser);
+    if (parser.get_error() != nullptr) {
+      LOG(ERROR) << "Failed to parse journalled updates: " << parser.get_error();
+      binlog_erase(G()->td_db()->get_binlog(), event.id_);
+      schedule_get_difference("broken update journal");
+      continue;
+    }
+    VLOG(get_difference) << "Replay journalled updates received before restart";
+    update_journal_event_ids_.push_back(event.id_);
+    on_get_updates(std::move(updates_ptr));
+  }
+  try_flush_update_journal();
+}
+
 void UpdatesManager::on_failed_get_difference() {
   schedule_get_difference("on_failed_get_difference");
 }
@@ -1068,6 +1129,8 @@ void UpdatesManager::after_get_difference() {
   td_->stickers_manager_->after_get_difference();
   send_closure_later(td_->notification_manager_actor_, &NotificationManager::after_get_difference);
   send_closure(G()->state_manager(), &StateManager::on_synchronized, true);
+
+  try_flush_update_journal();
 }
 
 void UpdatesManager::on_pending_updates(vector<tl_object_ptr<telegram_api::Update>> &&updates, int32 seq_begin,
@@ -1106,18 +1169,23 @@ void UpdatesManager::on_pending_updates(vector<tl_object_ptr<telegram_api::Updat
   for (auto &update : updates) {
     if (!is_acceptable_update(update.get())) {
       CHECK(update != nullptr);
-      int32 id = update->get_id();
       const tl_object_ptr<telegram_api::Message> *message_ptr = nullptr;
       int32 pts = 0;
-      if (id == telegram_api::updateNewChannelMessage::ID) {
-        auto update_new_channel_message = static_cast<const telegram_api::updateNewChannelMessage *>(update.get());
-        message_ptr = &update_new_channel_message->message_;
-        pts = update_new_channel_message->pts_;
-      }
-      if (id == telegram_api::updateEditChannelMessage::ID) {
-        auto update_edit_channel_message = static_cast<const telegram_api::updateEditChannelMessage *>(update.get());
-        message_ptr = &update_edit_channel_message->message_;
-        pts = update_edit_channel_message->pts_;
+      switch (update->get_id()) {
+        case telegram_api::updateNewChannelMessage::ID: {
+          auto update_new_channel_message = static_cast<const telegram_api::updateNewChannelMessage *>(update.get());
+          message_ptr = &update_new_channel_message->message_;
+          pts = update_new_channel_message->pts_;
+          break;
+        }
+        case telegram_api::updateEditChannelMessage::ID: {
+          auto update_edit_channel_message = static_cast<const telegram_api::updateEditChannelMessage *>(update.get());
+          message_ptr = &update_edit_channel_message->message_;
+          pts = update_edit_channel_message->pts_;
+          break;
+        }
+        default:
+          break;
       }
 
       // for channels we can try to replace unacceptable update with updateChannelTooLong
@@ -1175,16 +1243,22 @@ void UpdatesManager::on_pending_updates(vector<tl_object_ptr<telegram_api::Updat
 
   for (auto &update : updates) {
     if (update != nullptr) {
-      int32 id = update->get_id();
-      if (id == telegram_api::updateNewMessage::ID || id == telegram_api::updateReadMessagesContents::ID ||
-          id == telegram_api::updateEditMessage::ID || id == telegram_api::updateDeleteMessages::ID ||
-          id == telegram_api::updateReadHistoryInbox::ID || id == telegram_api::updateReadHistoryOutbox::ID ||
-          id == telegram_api::updateWebPage::ID) {
-        if (!downcast_call(*update, OnUpdate(this, update, false))) {
-          LOG(ERROR) << "Can't call on some update received from " << source;
-        }
-        processed_updates++;
-        update = nullptr;
+      switch (update->get_id()) {
+        case telegram_api::updateNewMessage::ID:
+        case telegram_api::updateReadMessagesContents::ID:
+        case telegram_api::updateEditMessage::ID:
+        case telegram_api::updateDeleteMessages::ID:
+        case telegram_api::updateReadHistoryInbox::ID:
+        case telegram_api::updateReadHistoryOutbox::ID:
+        case telegram_api::updateWebPage::ID:
+          if (!downcast_call(*update, OnUpdate(this, update, false))) {
+            LOG(ERROR) << "Can't call on some update received from " << source;
+          }
+          processed_updates++;
+          update = nullptr;
+          break;
+        default:
+          break;
       }
     }
   }
@@ -1250,15 +1324,17 @@ void UpdatesManager::process_updates(vector<tl_object_ptr<telegram_api::Update>>
   */
   for (auto &update : updates) {
     if (update != nullptr) {
-      // process updateNewChannelMessage first
-      auto constructor_id = update->get_id();
-      if (constructor_id == telegram_api::updateNewChannelMessage::ID) {
-        on_update(move_tl_object_as<telegram_api::updateNewChannelMessage>(update), force_apply);
-      }
-
-      // updatePtsChanged forces get difference, so process it last
-      if (constructor_id == telegram_api::updatePtsChanged::ID) {
-        update_pts_changed = move_tl_object_as<telegram_api::updatePtsChanged>(update);
+      switch (update->get_id()) {
+        case telegram_api::updateNewChannelMessage::ID:
+          // process updateNewChannelMessage first
+          on_update(move_tl_object_as<telegram_api::updateNewChannelMessage>(update), force_apply);
+          break;
+        case telegram_api::updatePtsChanged::ID:
+          // updatePtsChanged forces get difference, so process it last
+          update_pts_changed = move_tl_object_as<telegram_api::updatePtsChanged>(update);
+          break;
+        default:
+          break;
       }
     }
   }
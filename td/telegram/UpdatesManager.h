@@ -16,8 +16,12 @@
 #include "td/actor/PromiseFuture.h"
 #include "td/actor/Timeout.h"
 
+#include "td/db/binlog/BinlogEvent.h"
+
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/Slice.h"
 
 #include <map>
 #include <unordered_set>
@@ -34,6 +38,10 @@ class UpdatesManager : public Actor {
 
   void on_get_updates(tl_object_ptr<telegram_api::Updates> &&updates_ptr);
 
+  void on_get_updates_packet(BufferSlice &&packet, tl_object_ptr<telegram_api::Updates> &&updates_ptr);
+
+  void on_binlog_events(vector<BinlogEvent> &&events);
+
   void on_get_updates_state(tl_object_ptr<telegram_api::updates_state> &&state, const char *source);
 
   void on_get_difference(tl_object_ptr<telegram_api::updates_Difference> &&difference_ptr);
@@ -110,6 +118,12 @@ class UpdatesManager : public Actor {
   std::multimap<int32, PendingUpdates> postponed_updates_;    // updates received during getDifference
   std::multimap<int32, PendingUpdates> pending_seq_updates_;  // updates with too big seq
 
+  // journal of raw update containers which were received, but may be not fully
+  // applied yet; it is replayed at startup, so getDifference after a crash is
+  // requested from a newer state
+  static constexpr size_t MAX_UPDATE_JOURNAL_SIZE = 100;
+  vector<uint64> update_journal_event_ids_;
+
   Timeout seq_gap_timeout_;
 
   int32 retry_time_ = 1;
@@ -120,6 +134,10 @@ class UpdatesManager : public Actor {
 
   void tear_down() override;
 
+  void add_update_journal_event(Slice packet);
+
+  void try_flush_update_journal();
+
   Promise<> add_pts(int32 pts);
   void on_pts_ack(PtsManager::PtsId ack_token);
   void save_pts(int32 pts);
@@ -41,6 +41,10 @@ class UserId {
     return id != other.id;
   }
 
+  bool operator<(const UserId &other) const {
+    return id < other.id;
+  }
+
   template <class StorerT>
   void store(StorerT &storer) const {
     storer.store_int(id);
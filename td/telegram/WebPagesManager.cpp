@@ -353,7 +353,7 @@ class WebPagesManager::WebPage {
 };
 
 WebPagesManager::WebPagesManager(Td *td, ActorShared<> parent) : td_(td), parent_(std::move(parent)) {
-  pending_web_pages_timeout_.set_callback(on_pending_web_page_timeout_callback);
+  pending_web_pages_timeout_.set_bulk_callback(on_pending_web_page_timeout_callback);
   pending_web_pages_timeout_.set_callback_data(static_cast<void *>(this));
 }
 
@@ -390,6 +390,7 @@ WebPageId WebPagesManager::on_get_web_page(tl_object_ptr<telegram_api::WebPage>
         }
         web_pages_.erase(web_page_id);
       }
+      pending_instant_view_pages_.erase(web_page_id);
 
       update_messages_content(web_page_id, false);
       if (!G()->parameters().use_message_db) {
@@ -472,8 +473,13 @@ WebPageId WebPagesManager::on_get_web_page(tl_object_ptr<telegram_api::WebPage>
           page->document = parsed_document;
         }
       }
+      pending_instant_view_pages_.erase(web_page_id);
       if (web_page->flags_ & WEBPAGE_FLAG_HAS_INSTANT_VIEW) {
-        on_get_web_page_instant_view(page.get(), std::move(web_page->cached_page_), web_page->hash_, owner_dialog_id);
+        // don't parse the page block tree eagerly; it is built on the first request for the instant view
+        page->instant_view.is_empty = false;
+        page->instant_view.is_v2 = (web_page->cached_page_->flags_ & telegram_api::page::V2_MASK) != 0;
+        pending_instant_view_pages_[web_page_id] =
+            PendingInstantViewPage{std::move(web_page->cached_page_), web_page->hash_, owner_dialog_id};
       }
 
       update_web_page(std::move(page), web_page_id, false, false);
@@ -751,6 +757,8 @@ WebPageId WebPagesManager::get_web_page_instant_view(const string &url, bool for
 WebPageId WebPagesManager::get_web_page_instant_view(WebPageId web_page_id, bool force_full, Promise<Unit> &&promise) {
   LOG(INFO) << "Trying to get web page instant view for " << web_page_id;
 
+  flush_pending_instant_view_page(web_page_id);
+
   const WebPageInstantView *web_page_instant_view = get_web_page_instant_view(web_page_id);
   if (web_page_instant_view == nullptr) {
     promise.set_value(Unit());
@@ -864,6 +872,7 @@ void WebPagesManager::update_web_page_instant_view_load_requests(WebPageId web_p
                                                                  Result<> result) {
   // TODO [Error : 0 : Lost promise] on closing
   LOG(INFO) << "Update load requests for " << web_page_id;
+  flush_pending_instant_view_page(web_page_id);
   auto it = load_web_page_instant_view_queries_.find(web_page_id);
   if (it == load_web_page_instant_view_queries_.end()) {
     return;
@@ -1026,7 +1035,32 @@ void WebPagesManager::on_load_web_page_by_url_from_database(WebPageId web_page_i
 
 void WebPagesManager::reload_web_page_by_url(const string &url, Promise<Unit> &&promise) {
   LOG(INFO) << "Reload url \"" << url << '"';
-  td_->create_handler<GetWebPageQuery>(std::move(promise))->send(url, 0);
+  auto &queries = reload_web_page_by_url_queries_[url];
+  queries.push_back(std::move(promise));
+  if (queries.size() != 1) {
+    // the URL is already being reloaded
+    return;
+  }
+
+  auto query_promise = PromiseCreator::lambda([url](Result<Unit> result) {
+    send_closure(G()->web_pages_manager(), &WebPagesManager::on_reload_web_page_by_url, url, std::move(result));
+  });
+  td_->create_handler<GetWebPageQuery>(std::move(query_promise))->send(url, 0);
+}
+
+void WebPagesManager::on_reload_web_page_by_url(const string &url, Result<Unit> &&result) {
+  auto it = reload_web_page_by_url_queries_.find(url);
+  CHECK(it != reload_web_page_by_url_queries_.end());
+  auto promises = std::move(it->second);
+  reload_web_page_by_url_queries_.erase(it);
+
+  for (auto &promise : promises) {
+    if (result.is_ok()) {
+      promise.set_value(Unit());
+    } else {
+      promise.set_error(result.error().clone());
+    }
+  }
 }
 
 SecretInputMedia WebPagesManager::get_secret_input_media(WebPageId web_page_id) const {
@@ -1152,34 +1186,41 @@ const WebPagesManager::WebPageInstantView *WebPagesManager::get_web_page_instant
   return &web_page->instant_view;
 }
 
-void WebPagesManager::on_pending_web_page_timeout_callback(void *web_pages_manager_ptr, int64 web_page_id) {
-  static_cast<WebPagesManager *>(web_pages_manager_ptr)->on_pending_web_page_timeout(WebPageId(web_page_id));
+void WebPagesManager::on_pending_web_page_timeout_callback(void *web_pages_manager_ptr, Span<int64> web_page_ids) {
+  static_cast<WebPagesManager *>(web_pages_manager_ptr)->on_pending_web_page_timeout(web_page_ids);
 }
 
-void WebPagesManager::on_pending_web_page_timeout(WebPageId web_page_id) {
-  int32 count = 0;
-  auto it = pending_web_pages_.find(web_page_id);
-  if (it != pending_web_pages_.end()) {
-    vector<FullMessageId> full_message_ids;
-    for (auto full_message_id : it->second) {
-      full_message_ids.push_back(full_message_id);
-      count++;
+void WebPagesManager::on_pending_web_page_timeout(Span<int64> web_page_ids) {
+  // all messages waiting for the expired web pages are requested in one batch
+  vector<FullMessageId> full_message_ids;
+  for (auto web_page_id_int : web_page_ids) {
+    WebPageId web_page_id(web_page_id_int);
+    int32 count = 0;
+    auto it = pending_web_pages_.find(web_page_id);
+    if (it != pending_web_pages_.end()) {
+      for (auto full_message_id : it->second) {
+        full_message_ids.push_back(full_message_id);
+        count++;
+      }
     }
-    send_closure_later(G()->messages_manager(), &MessagesManager::get_messages_from_server, std::move(full_message_ids),
-                       Promise<Unit>(), nullptr);
-  }
-  auto get_it = pending_get_web_pages_.find(web_page_id);
-  if (get_it != pending_get_web_pages_.end()) {
-    auto requests = std::move(get_it->second);
-    pending_get_web_pages_.erase(get_it);
-    for (auto &request : requests) {
-      on_get_web_page_preview_fail(request.first, request.second.first, Status::Error(500, "Request timeout exceeded"),
-                                   std::move(request.second.second));
-      count++;
+    auto get_it = pending_get_web_pages_.find(web_page_id);
+    if (get_it != pending_get_web_pages_.end()) {
+      auto requests = std::move(get_it->second);
+      pending_get_web_pages_.erase(get_it);
+      for (auto &request : requests) {
+        on_get_web_page_preview_fail(request.first, request.second.first,
+                                     Status::Error(500, "Request timeout exceeded"),
+                                     std::move(request.second.second));
+        count++;
+      }
+    }
+    if (count == 0) {
+      LOG(WARNING) << "Have no messages waiting for " << web_page_id;
     }
   }
-  if (count == 0) {
-    LOG(WARNING) << "Have no messages waiting for " << web_page_id;
+  if (!full_message_ids.empty()) {
+    send_closure_later(G()->messages_manager(), &MessagesManager::get_messages_from_server, std::move(full_message_ids),
+                       Promise<Unit>(), nullptr);
   }
 }
 
@@ -1271,6 +1312,35 @@ void WebPagesManager::on_get_web_page_instant_view(WebPage *web_page, tl_object_
              << to_string(get_web_page_instant_view_object(&web_page->instant_view));
 }
 
+void WebPagesManager::flush_pending_instant_view_page(WebPageId web_page_id) {
+  auto it = pending_instant_view_pages_.find(web_page_id);
+  if (it == pending_instant_view_pages_.end()) {
+    return;
+  }
+  auto pending_page = std::move(it->second);
+  pending_instant_view_pages_.erase(it);
+
+  auto web_page_it = web_pages_.find(web_page_id);
+  if (web_page_it == web_pages_.end() || web_page_it->second->instant_view.is_empty) {
+    return;
+  }
+  WebPage *web_page = web_page_it->second.get();
+
+  LOG(INFO) << "Parse postponed instant view page of " << web_page_id;
+  auto old_file_ids = get_web_page_file_ids(web_page);
+  WebPageInstantView old_instant_view = std::move(web_page->instant_view);
+  web_page->instant_view = WebPageInstantView();
+  on_get_web_page_instant_view(web_page, std::move(pending_page.page), pending_page.hash,
+                               pending_page.owner_dialog_id);
+
+  update_web_page_instant_view(web_page_id, web_page->instant_view, std::move(old_instant_view));
+
+  auto new_file_ids = get_web_page_file_ids(web_page);
+  if (old_file_ids != new_file_ids) {
+    td_->file_manager_->change_files_source(get_web_page_file_source_id(web_page), old_file_ids, new_file_ids);
+  }
+}
+
 class WebPagesManager::WebPageLogEvent {
  public:
   WebPageId web_page_id;
@@ -1422,6 +1492,33 @@ void WebPagesManager::on_load_web_page_from_database(WebPageId web_page_id, stri
   }
 }
 
+void WebPagesManager::preload_web_pages_from_database(
+    const std::unordered_set<WebPageId, WebPageIdHash> &web_page_ids) {
+  if (!G()->parameters().use_message_db) {
+    return;
+  }
+
+  vector<WebPageId> to_load;
+  vector<string> keys;
+  for (auto web_page_id : web_page_ids) {
+    if (web_page_id.is_valid() && !have_web_page(web_page_id) &&
+        loaded_from_database_web_pages_.count(web_page_id) == 0) {
+      to_load.push_back(web_page_id);
+      keys.push_back(get_web_page_database_key(web_page_id));
+    }
+  }
+  if (to_load.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Preload " << to_load.size() << " web pages from database";
+  auto values = G()->td_db()->get_sqlite_sync_pmc()->get_many(
+      transform(keys, [](const string &key) { return Slice(key); }));
+  for (size_t i = 0; i < to_load.size(); i++) {
+    on_load_web_page_from_database(to_load[i], std::move(values[i]));
+  }
+}
+
 bool WebPagesManager::have_web_page_force(WebPageId web_page_id) {
   return get_web_page_force(web_page_id) != nullptr;
 }
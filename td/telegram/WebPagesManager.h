@@ -21,6 +21,7 @@
 #include "td/actor/Timeout.h"
 
 #include "td/utils/common.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 #include <unordered_map>
@@ -53,6 +54,10 @@ class WebPagesManager : public Actor {
 
   bool have_web_page_force(WebPageId web_page_id);
 
+  // loads all not yet loaded web pages with one database multi-get, so subsequent
+  // have_web_page_force calls don't need to do a database read per identifier
+  void preload_web_pages_from_database(const std::unordered_set<WebPageId, WebPageIdHash> &web_page_ids);
+
   tl_object_ptr<td_api::webPage> get_web_page_object(WebPageId web_page_id) const;
 
   tl_object_ptr<td_api::webPageInstantView> get_web_page_instant_view_object(WebPageId web_page_id) const;
@@ -69,6 +74,8 @@ class WebPagesManager : public Actor {
 
   void reload_web_page_by_url(const string &url, Promise<Unit> &&promise);
 
+  void on_reload_web_page_by_url(const string &url, Result<Unit> &&result);
+
   void on_get_web_page_preview_success(int64 request_id, const string &url,
                                        tl_object_ptr<telegram_api::MessageMedia> &&message_media_ptr,
                                        Promise<Unit> &&promise);
@@ -121,8 +128,8 @@ class WebPagesManager : public Actor {
   tl_object_ptr<td_api::webPageInstantView> get_web_page_instant_view_object(
       const WebPageInstantView *web_page_instant_view) const;
 
-  static void on_pending_web_page_timeout_callback(void *web_pages_manager_ptr, int64 web_page_id);
-  void on_pending_web_page_timeout(WebPageId web_page_id);
+  static void on_pending_web_page_timeout_callback(void *web_pages_manager_ptr, Span<int64> web_page_ids);
+  void on_pending_web_page_timeout(Span<int64> web_page_ids);
 
   void on_get_web_page_preview_success(int64 request_id, const string &url, WebPageId web_page_id,
                                        Promise<Unit> &&promise);
@@ -130,6 +137,8 @@ class WebPagesManager : public Actor {
   void on_get_web_page_instant_view(WebPage *web_page, tl_object_ptr<telegram_api::page> &&page, int32 hash,
                                     DialogId owner_dialog_id);
 
+  void flush_pending_instant_view_page(WebPageId web_page_id);
+
   void save_web_page(const WebPage *web_page, WebPageId web_page_id, bool from_binlog);
 
   static string get_web_page_database_key(WebPageId web_page_id);
@@ -171,6 +180,15 @@ class WebPagesManager : public Actor {
   ActorShared<> parent_;
   std::unordered_map<WebPageId, unique_ptr<WebPage>, WebPageIdHash> web_pages_;
 
+  struct PendingInstantViewPage {
+    tl_object_ptr<telegram_api::page> page;
+    int32 hash = 0;
+    DialogId owner_dialog_id;
+  };
+  // received, but not yet parsed instant view pages; the page block tree is built
+  // only when the instant view is actually requested
+  std::unordered_map<WebPageId, PendingInstantViewPage, WebPageIdHash> pending_instant_view_pages_;
+
   std::unordered_map<WebPageId, vector<Promise<Unit>>, WebPageIdHash> load_web_page_from_database_queries_;
   std::unordered_set<WebPageId, WebPageIdHash> loaded_from_database_web_pages_;
 
@@ -189,6 +207,9 @@ class WebPagesManager : public Actor {
 
   std::unordered_map<string, WebPageId> url_to_web_page_id_;
 
+  // concurrent reloads of the same URL are merged into one getWebPage query
+  std::unordered_map<string, vector<Promise<Unit>>> reload_web_page_by_url_queries_;
+
   std::unordered_map<string, FileSourceId> url_to_file_source_id_;
 
   MultiTimeout pending_web_pages_timeout_{"PendingWebPagesTimeout"};
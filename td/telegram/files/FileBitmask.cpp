@@ -8,42 +8,64 @@
 
 #include "td/utils/common.h"
 #include "td/utils/misc.h"
-#include "td/utils/ScopeGuard.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace td {
 
-Bitmask::Bitmask(Decode, Slice data) : data_(zero_one_decode(data)) {
+Bitmask::Bitmask(Decode, Slice data) {
+  auto decoded = zero_one_decode(data);
+  auto bit_count = static_cast<int64>(decoded.size()) * 8;
+  int64 run_begin = -1;
+  for (int64 i = 0; i < bit_count; i++) {
+    if (i % 8 == 0) {
+      // skip uniform bytes at once
+      auto byte = static_cast<uint8>(decoded[narrow_cast<size_t>(i / 8)]);
+      if ((run_begin < 0 && byte == 0) || (run_begin >= 0 && byte == 0xff)) {
+        i += 7;
+        continue;
+      }
+    }
+    bool bit = (static_cast<uint8>(decoded[narrow_cast<size_t>(i / 8)]) & (1 << static_cast<int>(i % 8))) != 0;
+    if (bit && run_begin < 0) {
+      run_begin = i;
+    } else if (!bit && run_begin >= 0) {
+      runs_.emplace_back(run_begin, i);
+      run_begin = -1;
+    }
+  }
+  if (run_begin >= 0) {
+    runs_.emplace_back(run_begin, bit_count);
+  }
 }
 
-Bitmask::Bitmask(Ones, int64 count) : data_(narrow_cast<size_t>((count + 7) / 8), '\0') {
-  for (int64 i = 0; i < count; i++) {
-    set(i);
+Bitmask::Bitmask(Ones, int64 count) {
+  if (count > 0) {
+    runs_.emplace_back(0, count);
   }
 }
 
 std::string Bitmask::encode(int32 prefix_count) {
-  // remove zeroes in the end to make encoding deterministic
-  td::Slice data(data_);
-
-  int save_i = -1;
-  char save_c;
-  if (prefix_count != -1) {
-    auto truncated_size = (prefix_count + 7) / 8;
-    data.truncate(truncated_size);
-    if (prefix_count % 8 != 0) {
-      save_i = truncated_size - 1;
-      save_c = data_[save_i];
-      auto mask = 0xff >> (8 - prefix_count % 8);
-      data_[save_i] = static_cast<char>(data_[save_i] & mask);
+  // the encoding must stay deterministic: only bytes up to the last one are
+  // materialized, so trailing zeroes don't change the result
+  auto limit = prefix_count == -1 ? std::numeric_limits<int64>::max() : static_cast<int64>(prefix_count);
+  int64 bit_count = 0;
+  for (auto &run : runs_) {
+    if (run.first >= limit) {
+      break;
     }
+    bit_count = min(run.second, limit);
   }
-  SCOPE_EXIT {
-    if (save_i != -1) {
-      data_[save_i] = save_c;
+  std::string data(narrow_cast<size_t>((bit_count + 7) / 8), '\0');
+  for (auto &run : runs_) {
+    if (run.first >= bit_count) {
+      break;
+    }
+    auto end = min(run.second, bit_count);
+    for (auto i = run.first; i < end; i++) {
+      data[narrow_cast<size_t>(i / 8)] = static_cast<char>(data[narrow_cast<size_t>(i / 8)] | (1 << (i % 8)));
     }
-  };
-  while (!data.empty() && data.back() == '\0') {
-    data.remove_suffix(1);
   }
   return zero_one_encode(data);
 }
@@ -75,46 +97,53 @@ int64 Bitmask::get_ready_prefix_size(int64 offset, int64 part_size, int64 file_s
 
 int64 Bitmask::get_total_size(int64 part_size, int64 file_size) const {
   int64 res = 0;
-  for (int64 i = 0; i < size(); i++) {
-    if (get(i)) {
-      auto from = i * part_size;
-      auto to = from + part_size;
-      if (file_size != 0 && file_size < to) {
-        to = file_size;
-      }
-      if (from < to) {
-        res += to - from;
-      }
+  for (auto &run : runs_) {
+    auto from = run.first * part_size;
+    auto to = run.second * part_size;
+    if (file_size != 0 && file_size < to) {
+      to = file_size;
+    }
+    if (from < to) {
+      res += to - from;
     }
   }
   return res;
 }
 
+std::vector<std::pair<int64, int64>>::const_iterator Bitmask::find_run(int64 offset_part) const {
+  // the last run beginning at or before offset_part, runs_.end() if none
+  auto it = std::upper_bound(runs_.begin(), runs_.end(), offset_part,
+                             [](int64 value, const std::pair<int64, int64> &run) { return value < run.first; });
+  if (it == runs_.begin()) {
+    return runs_.end();
+  }
+  return it - 1;
+}
+
 bool Bitmask::get(int64 offset_part) const {
   if (offset_part < 0) {
-    return 0;
+    return false;
   }
-  auto index = narrow_cast<size_t>(offset_part / 8);
-  if (index >= data_.size()) {
-    return 0;
-  }
-  return (static_cast<uint8>(data_[index]) & (1 << static_cast<int>(offset_part % 8))) != 0;
+  auto it = find_run(offset_part);
+  return it != runs_.end() && offset_part < it->second;
 }
 
 int64 Bitmask::get_ready_parts(int64 offset_part) const {
-  int64 res = 0;
-  while (get(offset_part + res)) {
-    res++;
+  if (offset_part < 0) {
+    return 0;
   }
-  return res;
+  auto it = find_run(offset_part);
+  if (it == runs_.end() || offset_part >= it->second) {
+    return 0;
+  }
+  return it->second - offset_part;
 }
 
 std::vector<int32> Bitmask::as_vector() const {
   std::vector<int32> res;
-  auto size = narrow_cast<int32>(data_.size() * 8);
-  for (int32 i = 0; i < size; i++) {
-    if (get(i)) {
-      res.push_back(i);
+  for (auto &run : runs_) {
+    for (auto i = run.first; i < run.second; i++) {
+      res.push_back(narrow_cast<int32>(i));
     }
   }
   return res;
@@ -122,15 +151,33 @@ std::vector<int32> Bitmask::as_vector() const {
 
 void Bitmask::set(int64 offset_part) {
   CHECK(offset_part >= 0);
-  auto need_size = narrow_cast<size_t>(offset_part / 8 + 1);
-  if (need_size > data_.size()) {
-    data_.resize(need_size, '\0');
+  auto it = runs_.begin() + (find_run(offset_part) - runs_.cbegin());
+  if (it != runs_.end() && offset_part < it->second) {
+    // already set
+    return;
+  }
+  if (it != runs_.end() && offset_part == it->second) {
+    it->second++;
+    auto next = it + 1;
+    if (next != runs_.end() && next->first == it->second) {
+      it->second = next->second;
+      runs_.erase(next);
+    }
+    return;
   }
-  data_[need_size - 1] = static_cast<char>(data_[need_size - 1] | (1 << (offset_part % 8)));
+  auto next = it == runs_.end() ? runs_.begin() : it + 1;
+  if (next != runs_.end() && next->first == offset_part + 1) {
+    next->first = offset_part;
+    return;
+  }
+  runs_.insert(next, {offset_part, offset_part + 1});
 }
 
 int64 Bitmask::size() const {
-  return static_cast<int64>(data_.size()) * 8;
+  if (runs_.empty()) {
+    return 0;
+  }
+  return (runs_.back().second + 7) / 8 * 8;
 }
 
 StringBuilder &operator<<(StringBuilder &sb, const Bitmask &mask) {
@@ -10,6 +10,8 @@
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
 
+#include <utility>
+
 namespace td {
 
 class Bitmask {
@@ -31,7 +33,11 @@ class Bitmask {
   int64 size() const;
 
  private:
-  std::string data_;
+  // sorted non-adjacent [begin, end) runs of ready parts; real download
+  // states are a handful of contiguous runs, so queries are O(log runs)
+  std::vector<std::pair<int64, int64>> runs_;
+
+  std::vector<std::pair<int64, int64>>::const_iterator find_run(int64 offset_part) const;
 };
 
 StringBuilder &operator<<(StringBuilder &sb, const Bitmask &mask);
@@ -30,18 +30,22 @@
 #include "td/utils/Slice.h"
 #include "td/utils/UInt.h"
 
+#include <atomic>
 #include <tuple>
+#include <utility>
 
 namespace td {
 
 FileDownloader::FileDownloader(const FullRemoteFileLocation &remote, const LocalFileLocation &local, int64 size,
                                string name, const FileEncryptionKey &encryption_key, bool is_small, bool search_file,
-                               int64 offset, int64 limit, unique_ptr<Callback> callback)
+                               int64 offset, int64 limit, std::shared_ptr<std::atomic<bool>> cancel_flag,
+                               unique_ptr<Callback> callback)
     : remote_(remote)
     , local_(local)
     , size_(size)
     , name_(std::move(name))
     , encryption_key_(encryption_key)
+    , cancel_flag_(std::move(cancel_flag))
     , callback_(std::move(callback))
     , is_small_(is_small)
     , search_file_(search_file)
@@ -286,6 +290,11 @@ Status FileDownloader::check_net_query(NetQueryPtr &net_query) {
 }
 
 Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
+  if (cancel_flag_ != nullptr && cancel_flag_->load(std::memory_order_relaxed)) {
+    // drop the result before parse and decryption: the download is already
+    // cancelled, its error event just hasn't reached this actor yet
+    return Status::Error(1, "Cancelled");
+  }
   TRY_STATUS(check_net_query(net_query));
 
   BufferSlice bytes;
@@ -354,6 +363,9 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
   }
 
   auto slice = bytes.as_slice().truncate(part.size);
+  if (cancel_flag_ != nullptr && cancel_flag_->load(std::memory_order_relaxed)) {
+    return Status::Error(1, "Cancelled");
+  }
   TRY_STATUS(acquire_fd());
   LOG(INFO) << "Got " << slice.size() << " bytes at offset " << part.offset << " for \"" << path_ << '"';
   TRY_RESULT(written, fd_.pwrite(slice, part.offset));
@@ -361,6 +373,11 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
   if (written != slice.size()) {
     return Status::Error("Failed to save file part to the file");
   }
+  if (!need_check_) {
+    // the part won't be read back; drop it from the page cache, so bulk
+    // downloads don't evict hotter data
+    fd_.advise(FileFd::Advice::DontNeed, part.offset, static_cast<int64>(written)).ignore();
+  }
   return written;
 }
 void FileDownloader::on_progress(Progress progress) {
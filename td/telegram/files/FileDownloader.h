@@ -18,7 +18,9 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/Status.h"
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <set>
 #include <utility>
 
@@ -35,7 +37,7 @@ class FileDownloader : public FileLoader {
 
   FileDownloader(const FullRemoteFileLocation &remote, const LocalFileLocation &local, int64 size, string name,
                  const FileEncryptionKey &encryption_key, bool is_small, bool search_file, int64 offset, int64 limit,
-                 unique_ptr<Callback> callback);
+                 std::shared_ptr<std::atomic<bool>> cancel_flag, unique_ptr<Callback> callback);
 
   // Should just implement all parent pure virtual methods.
   // Must not call any of them...
@@ -47,6 +49,10 @@ class FileDownloader : public FileLoader {
   int64 size_;
   string name_;
   FileEncryptionKey encryption_key_;
+  // shared with FileManager; checked before results are parsed and written to
+  // disk, so a cancelled download stops wasting work before the cancel event
+  // reaches this actor
+  std::shared_ptr<std::atomic<bool>> cancel_flag_;
   unique_ptr<Callback> callback_;
   bool only_check_{false};
 
@@ -25,6 +25,10 @@ namespace td {
 
 int VERBOSITY_NAME(file_gc) = VERBOSITY_NAME(INFO);
 
+void FileGcWorker::start_up() {
+  set_scheduling_class(ActorInfo::SchedulingClass::Background);
+}
+
 void FileGcWorker::do_remove_file(const FullFileInfo &info) {
   // LOG(WARNING) << "Gc remove file: " << tag("path", file) << tag("mtime", stat.mtime_nsec_ / 1000000000)
   // << tag("atime", stat.atime_nsec_ / 1000000000);
@@ -37,11 +41,11 @@ void FileGcWorker::do_remove_file(const FullFileInfo &info) {
 
 void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files,
                           Promise<FileStats> promise) {
-  auto begin_time = Time::now();
+  CHECK(!is_active_);
+  is_active_ = true;
+  begin_time_ = Time::now();
+  promise_ = std::move(promise);
   VLOG(file_gc) << "Start files gc with " << parameters;
-  // quite stupid implementations
-  // needs a lot of memory
-  // may write something more clever, but i will need at least 2 passes over the files
   // TODO update atime for all files in android (?)
 
   std::array<bool, file_type_size> immune_types{{false}};
@@ -65,116 +69,146 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
     immune_types[narrow_cast<size_t>(FileType::EncryptedThumbnail)] = true;
   }
 
-  auto file_cnt = files.size();
-  int32 type_immunity_ignored_cnt = 0;
-  int32 time_immunity_ignored_cnt = 0;
-  int32 exclude_owner_dialog_id_ignored_cnt = 0;
-  int32 owner_dialog_id_ignored_cnt = 0;
-  int32 remove_by_atime_cnt = 0;
-  int32 remove_by_count_cnt = 0;
-  int32 remove_by_size_cnt = 0;
-  int64 total_removed_size = 0;
-  int64 total_size = 0;
+  file_cnt_ = files.size();
+  new_stats_.split_by_owner_dialog_id = parameters.dialog_limit != 0;
+
+  // a single streaming pass over the candidates: each file goes either to the
+  // kept stats, to the removal list, or stays a candidate for the limit checks
+  double now = Clocks::system();
+  std::vector<FullFileInfo> candidates;
   for (auto &info : files) {
     if (info.atime_nsec < info.mtime_nsec) {
       info.atime_nsec = info.mtime_nsec;
     }
-    total_size += info.size;
-  }
+    total_size_ += info.size;
 
-  FileStats new_stats;
-  new_stats.split_by_owner_dialog_id = parameters.dialog_limit != 0;
+    if (immune_types[narrow_cast<size_t>(info.file_type)]) {
+      type_immunity_ignored_cnt_++;
+      new_stats_.add(std::move(info));
+      continue;
+    }
+    if (std::find(parameters.exclude_owner_dialog_ids.begin(), parameters.exclude_owner_dialog_ids.end(),
+                  info.owner_dialog_id) != parameters.exclude_owner_dialog_ids.end()) {
+      exclude_owner_dialog_id_ignored_cnt_++;
+      new_stats_.add(std::move(info));
+      continue;
+    }
+    if (!parameters.owner_dialog_ids.empty() &&
+        std::find(parameters.owner_dialog_ids.begin(), parameters.owner_dialog_ids.end(), info.owner_dialog_id) ==
+            parameters.owner_dialog_ids.end()) {
+      owner_dialog_id_ignored_cnt_++;
+      new_stats_.add(std::move(info));
+      continue;
+    }
+    if (static_cast<double>(info.mtime_nsec / 1000000000) > now - parameters.immunity_delay) {
+      // new files are immune to gc
+      time_immunity_ignored_cnt_++;
+      new_stats_.add(std::move(info));
+      continue;
+    }
 
-  // Remove all files with atime > now - max_time_from_last_access
-  double now = Clocks::system();
-  files.erase(
-      std::remove_if(
-          files.begin(), files.end(),
-          [&](const FullFileInfo &info) {
-            if (immune_types[narrow_cast<size_t>(info.file_type)]) {
-              type_immunity_ignored_cnt++;
-              new_stats.add(FullFileInfo(info));
-              return true;
-            }
-            if (std::find(parameters.exclude_owner_dialog_ids.begin(), parameters.exclude_owner_dialog_ids.end(),
-                          info.owner_dialog_id) != parameters.exclude_owner_dialog_ids.end()) {
-              exclude_owner_dialog_id_ignored_cnt++;
-              new_stats.add(FullFileInfo(info));
-              return true;
-            }
-            if (!parameters.owner_dialog_ids.empty() &&
-                std::find(parameters.owner_dialog_ids.begin(), parameters.owner_dialog_ids.end(),
-                          info.owner_dialog_id) == parameters.owner_dialog_ids.end()) {
-              owner_dialog_id_ignored_cnt++;
-              new_stats.add(FullFileInfo(info));
-              return true;
-            }
-            if (static_cast<double>(info.mtime_nsec / 1000000000) > now - parameters.immunity_delay) {
-              // new files are immune to gc
-              time_immunity_ignored_cnt++;
-              new_stats.add(FullFileInfo(info));
-              return true;
-            }
-
-            if (static_cast<double>(info.atime_nsec / 1000000000) < now - parameters.max_time_from_last_access) {
-              do_remove_file(info);
-              total_removed_size += info.size;
-              remove_by_atime_cnt++;
-              return true;
-            }
-            return false;
-          }),
-      files.end());
+    if (static_cast<double>(info.atime_nsec / 1000000000) < now - parameters.max_time_from_last_access) {
+      remove_by_atime_cnt_++;
+      total_removed_size_ += info.size;
+      to_remove_.push_back(std::move(info));
+      continue;
+    }
+    candidates.push_back(std::move(info));
+  }
+  files.clear();
 
   // sort by max(atime, mtime)
-  std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) { return a.atime_nsec < b.atime_nsec; });
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto &a, const auto &b) { return a.atime_nsec < b.atime_nsec; });
 
   // 1. Total memory must be less than max_memory
   // 2. Total file count must be less than MAX_FILE_COUNT
   size_t remove_count = 0;
-  if (files.size() > parameters.max_file_count) {
-    remove_count = files.size() - parameters.max_file_count;
+  if (candidates.size() > parameters.max_file_count) {
+    remove_count = candidates.size() - parameters.max_file_count;
   }
   int64 remove_size = -parameters.max_files_size;
-  for (auto &file : files) {
+  for (auto &file : candidates) {
     remove_size += file.size;
   }
 
   size_t pos = 0;
-  while (pos < files.size() && (remove_count > 0 || remove_size > 0)) {
+  while (pos < candidates.size() && (remove_count > 0 || remove_size > 0)) {
     if (remove_count > 0) {
-      remove_by_count_cnt++;
+      remove_by_count_cnt_++;
     } else {
-      remove_by_size_cnt++;
+      remove_by_size_cnt_++;
     }
 
     if (remove_count > 0) {
       remove_count--;
     }
-    remove_size -= files[pos].size;
+    remove_size -= candidates[pos].size;
 
-    total_removed_size += files[pos].size;
-    do_remove_file(files[pos]);
+    total_removed_size_ += candidates[pos].size;
+    to_remove_.push_back(std::move(candidates[pos]));
     pos++;
   }
 
-  while (pos < files.size()) {
-    new_stats.add(std::move(files[pos]));
+  while (pos < candidates.size()) {
+    new_stats_.add(std::move(candidates[pos]));
     pos++;
   }
 
+  // the unlinking itself is incremental and happens in loop()
+  loop();
+}
+
+void FileGcWorker::loop() {
+  if (!is_active_) {
+    return;
+  }
+
+  auto slice_begin_time = Time::now();
+  while (remove_pos_ < to_remove_.size()) {
+    auto batch_end = min(remove_pos_ + REMOVE_BATCH_SIZE, to_remove_.size());
+    while (remove_pos_ < batch_end) {
+      do_remove_file(to_remove_[remove_pos_]);
+      remove_pos_++;
+    }
+    if (Time::now() - slice_begin_time >= MAX_SLICE_DURATION) {
+      // let other events on the scheduler run and give the disk a breather
+      yield();
+      return;
+    }
+  }
+
+  on_gc_finished();
+}
+
+void FileGcWorker::on_gc_finished() {
+  is_active_ = false;
+  to_remove_.clear();
+  remove_pos_ = 0;
+
   auto end_time = Time::now();
 
-  VLOG(file_gc) << "Finish files gc: " << tag("time", end_time - begin_time) << tag("total", file_cnt)
-                << tag("removed", remove_by_atime_cnt + remove_by_count_cnt + remove_by_size_cnt)
-                << tag("total_size", format::as_size(total_size))
-                << tag("total_removed_size", format::as_size(total_removed_size))
-                << tag("by_atime", remove_by_atime_cnt) << tag("by_count", remove_by_count_cnt)
-                << tag("by_size", remove_by_size_cnt) << tag("type_immunity", type_immunity_ignored_cnt)
-                << tag("time_immunity", time_immunity_ignored_cnt)
-                << tag("owner_dialog_id_immunity", owner_dialog_id_ignored_cnt)
-                << tag("exclude_owner_dialog_id_immunity", exclude_owner_dialog_id_ignored_cnt);
-
-  promise.set_value(std::move(new_stats));
+  VLOG(file_gc) << "Finish files gc: " << tag("time", end_time - begin_time_) << tag("total", file_cnt_)
+                << tag("removed", remove_by_atime_cnt_ + remove_by_count_cnt_ + remove_by_size_cnt_)
+                << tag("total_size", format::as_size(total_size_))
+                << tag("total_removed_size", format::as_size(total_removed_size_))
+                << tag("by_atime", remove_by_atime_cnt_) << tag("by_count", remove_by_count_cnt_)
+                << tag("by_size", remove_by_size_cnt_) << tag("type_immunity", type_immunity_ignored_cnt_)
+                << tag("time_immunity", time_immunity_ignored_cnt_)
+                << tag("owner_dialog_id_immunity", owner_dialog_id_ignored_cnt_)
+                << tag("exclude_owner_dialog_id_immunity", exclude_owner_dialog_id_ignored_cnt_);
+
+  promise_.set_value(std::move(new_stats_));
+  new_stats_ = FileStats();
+  file_cnt_ = 0;
+  type_immunity_ignored_cnt_ = 0;
+  time_immunity_ignored_cnt_ = 0;
+  exclude_owner_dialog_id_ignored_cnt_ = 0;
+  owner_dialog_id_ignored_cnt_ = 0;
+  remove_by_atime_cnt_ = 0;
+  remove_by_count_cnt_ = 0;
+  remove_by_size_cnt_ = 0;
+  total_removed_size_ = 0;
+  total_size_ = 0;
 }
 }  // namespace td
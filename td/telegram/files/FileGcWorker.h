@@ -25,8 +25,35 @@ class FileGcWorker : public Actor {
   void run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files, Promise<FileStats> promise);
 
  private:
+  // files are unlinked in bounded time slices with a yield in between, so a gc
+  // pass over a huge cache doesn't monopolize the scheduler and the disk
+  static constexpr double MAX_SLICE_DURATION = 0.05;
+  static constexpr size_t REMOVE_BATCH_SIZE = 64;
+
   ActorShared<> parent_;
+
+  bool is_active_ = false;
+  std::vector<FullFileInfo> to_remove_;
+  size_t remove_pos_ = 0;
+  FileStats new_stats_;
+  Promise<FileStats> promise_;
+
+  double begin_time_ = 0;
+  size_t file_cnt_ = 0;
+  int32 type_immunity_ignored_cnt_ = 0;
+  int32 time_immunity_ignored_cnt_ = 0;
+  int32 exclude_owner_dialog_id_ignored_cnt_ = 0;
+  int32 owner_dialog_id_ignored_cnt_ = 0;
+  int32 remove_by_atime_cnt_ = 0;
+  int32 remove_by_count_cnt_ = 0;
+  int32 remove_by_size_cnt_ = 0;
+  int64 total_removed_size_ = 0;
+  int64 total_size_ = 0;
+
   void do_remove_file(const FullFileInfo &info);
+  void start_up() override;
+  void loop() override;
+  void on_gc_finished();
 };
 
 }  // namespace td
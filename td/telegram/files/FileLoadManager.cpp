@@ -14,6 +14,9 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 
+#include <atomic>
+#include <utility>
+
 namespace td {
 
 FileLoadManager::FileLoadManager(ActorShared<Callback> callback, ActorShared<> parent)
@@ -40,7 +43,7 @@ ActorOwn<ResourceManager> &FileLoadManager::get_download_resource_manager(bool i
 void FileLoadManager::download(QueryId id, const FullRemoteFileLocation &remote_location,
                                const LocalFileLocation &local, int64 size, string name,
                                const FileEncryptionKey &encryption_key, bool search_file, int64 offset, int64 limit,
-                               int8 priority) {
+                               std::shared_ptr<std::atomic<bool>> cancel_flag, int8 priority) {
   if (stop_flag_) {
     return;
   }
@@ -49,11 +52,12 @@ void FileLoadManager::download(QueryId id, const FullRemoteFileLocation &remote_
   Node *node = nodes_container_.get(node_id);
   CHECK(node);
   node->query_id_ = id;
+  node->cancel_flag_ = cancel_flag;
   auto callback = make_unique<FileDownloaderCallback>(actor_shared(this, node_id));
   bool is_small = size < 20 * 1024;
   node->loader_ =
       create_actor<FileDownloader>("Downloader", remote_location, local, size, std::move(name), encryption_key,
-                                   is_small, search_file, offset, limit, std::move(callback));
+                                   is_small, search_file, offset, limit, std::move(cancel_flag), std::move(callback));
   DcId dc_id = remote_location.is_web() ? G()->get_webfile_dc_id() : remote_location.get_dc_id();
   auto &resource_manager = get_download_resource_manager(is_small, dc_id);
   send_closure(resource_manager, &ResourceManager::register_worker,
@@ -91,7 +95,10 @@ void FileLoadManager::upload_by_hash(QueryId id, const FullLocalFileLocation &lo
   CHECK(node);
   node->query_id_ = id;
   auto callback = make_unique<FileHashUploaderCallback>(actor_shared(this, node_id));
-  node->loader_ = create_actor<FileHashUploader>("HashUploader", local_location, size, std::move(callback));
+  // the hash uploader only reads and hashes the file, so it is moved off the slow
+  // net scheduler; hashing then overlaps with the network work of other loaders
+  node->loader_ = create_actor_on_scheduler<FileHashUploader>("HashUploader", G()->get_gc_scheduler_id(),
+                                                              local_location, size, std::move(callback));
   send_closure(upload_resource_manager_, &ResourceManager::register_worker,
                ActorShared<FileLoaderActor>(node->loader_.get(), static_cast<uint64>(-1)), priority);
   query_id_to_node_id_[id] = node_id;
@@ -142,6 +149,10 @@ void FileLoadManager::cancel(QueryId id) {
   if (it == query_id_to_node_id_.end()) {
     return;
   }
+  auto node = nodes_container_.get(it->second);
+  if (node != nullptr && node->cancel_flag_ != nullptr) {
+    node->cancel_flag_->store(true, std::memory_order_relaxed);
+  }
   on_error_impl(it->second, Status::Error(1, "Cancelled"));
 }
 void FileLoadManager::update_local_file_location(QueryId id, const LocalFileLocation &local) {
@@ -23,7 +23,9 @@
 #include "td/utils/Container.h"
 #include "td/utils/Status.h"
 
+#include <atomic>
 #include <map>
+#include <memory>
 
 namespace td {
 
@@ -50,7 +52,7 @@ class FileLoadManager final : public Actor {
   explicit FileLoadManager(ActorShared<Callback> callback, ActorShared<> parent);
   void download(QueryId id, const FullRemoteFileLocation &remote_location, const LocalFileLocation &local, int64 size,
                 string name, const FileEncryptionKey &encryption_key, bool search_file, int64 offset, int64 limit,
-                int8 priority);
+                std::shared_ptr<std::atomic<bool>> cancel_flag, int8 priority);
   void upload(QueryId id, const LocalFileLocation &local_location, const RemoteFileLocation &remote_location,
               int64 expected_size, const FileEncryptionKey &encryption_key, int8 priority, vector<int> bad_parts);
   void upload_by_hash(QueryId id, const FullLocalFileLocation &local_location, int64 size, int8 priority);
@@ -67,6 +69,7 @@ class FileLoadManager final : public Actor {
     QueryId query_id_;
     ActorOwn<FileLoaderActor> loader_;
     ResourceState resource_state_;
+    std::shared_ptr<std::atomic<bool>> cancel_flag_;
   };
   using NodeId = uint64;
 
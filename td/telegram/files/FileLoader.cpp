@@ -45,6 +45,11 @@ void FileLoader::hangup() {
   // stop_flag_ = true;
   // on_error(Status::Error("Cancelled"));
   //}
+  if (pending_progress_parts_ != 0) {
+    // persist the latest ready parts bitmask, so a paused download can be
+    // resumed without losing already received parts
+    on_progress_impl();
+  }
   stop();
 }
 
@@ -306,11 +311,30 @@ Status FileLoader::try_on_part_query(Part part, NetQueryPtr query) {
     debug_bad_parts_.push_back(part.id);
     debug_bad_part_order_++;
   }
-  on_progress_impl();
+  on_part_progress();
   return Status::OK();
 }
 
+void FileLoader::on_part_progress() {
+  pending_progress_parts_++;
+  if (parts_manager_.ready() || pending_progress_parts_ >= MAX_PENDING_PROGRESS_PARTS) {
+    return on_progress_impl();
+  }
+  if (!has_progress_timeout_) {
+    has_progress_timeout_ = true;
+    set_timeout_in(PROGRESS_FLUSH_DELAY);
+  }
+}
+
+void FileLoader::timeout_expired() {
+  has_progress_timeout_ = false;
+  if (pending_progress_parts_ != 0) {
+    on_progress_impl();
+  }
+}
+
 void FileLoader::on_progress_impl() {
+  pending_progress_parts_ = 0;
   Progress progress;
   progress.part_count = parts_manager_.get_part_count();
   progress.part_size = static_cast<int32>(parts_manager_.get_part_size());
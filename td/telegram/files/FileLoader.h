@@ -124,7 +124,16 @@ class FileLoader : public FileLoaderActor {
   uint32 debug_bad_part_order_ = 0;
   std::vector<int32> debug_bad_parts_;
 
+  // progress of completed parts is reported in batches: each report rewrites
+  // the ready parts bitmask in the binlog, which is too expensive to do for
+  // every small part
+  static constexpr int32 MAX_PENDING_PROGRESS_PARTS = 64;
+  static constexpr double PROGRESS_FLUSH_DELAY = 0.2;
+  int32 pending_progress_parts_ = 0;
+  bool has_progress_timeout_ = false;
+
   void start_up() override;
+  void timeout_expired() override;
   void loop() override;
   Status do_loop();
   void hangup() override;
@@ -132,6 +141,7 @@ class FileLoader : public FileLoaderActor {
 
   void update_estimated_limit();
   void on_progress_impl();
+  void on_part_progress();
 
   void on_result(NetQueryPtr query) override;
   void on_part_query(Part part, NetQueryPtr query);
@@ -21,6 +21,7 @@
 #include "td/utils/StringBuilder.h"
 #include "td/utils/Variant.h"
 
+#include <cstddef>
 #include <tuple>
 #include <utility>
 
@@ -588,6 +589,30 @@ class FullRemoteFileLocation {
     }
   }
 
+  // hashes exactly the fields compared by operator==
+  std::size_t get_hash() const {
+    const uint64 MUL = 123456789;
+    uint64 hash = static_cast<uint64>(key_type());
+    hash = hash * MUL + static_cast<uint64>(dc_id_.get_value());
+    switch (location_type()) {
+      case LocationType::Photo:
+        hash = hash * MUL + static_cast<uint64>(photo().id_);
+        hash = hash * MUL + static_cast<uint64>(photo().volume_id_);
+        hash = hash * MUL + static_cast<uint64>(photo().local_id_);
+        break;
+      case LocationType::Common:
+        hash = hash * MUL + static_cast<uint64>(common().id_);
+        break;
+      case LocationType::Web:
+        hash = hash * MUL + SliceHash()(web().url_);
+        break;
+      case LocationType::None:
+      default:
+        UNREACHABLE();
+    }
+    return static_cast<std::size_t>(hash);
+  }
+
   static const int32 KEY_MAGIC = 0x64374632;
 };
 
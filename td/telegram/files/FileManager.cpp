@@ -11,15 +11,19 @@
 #include "td/telegram/ConfigShared.h"
 #include "td/telegram/FileReferenceManager.h"
 #include "td/telegram/files/FileData.h"
+#include "td/telegram/files/FileData.hpp"
 #include "td/telegram/files/FileDb.h"
 #include "td/telegram/files/FileLoaderUtils.h"
 #include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileLocation.hpp"
+#include "td/telegram/files/FileSizeIndex.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/SecureStorage.h"
 #include "td/telegram/TdDb.h"
 
+#include "td/db/SqliteKeyValue.h"
+
 #include "td/actor/SleepActor.h"
 
 #include "td/utils/base64.h"
@@ -28,6 +32,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
+#include "td/utils/port/Clocks.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
@@ -35,6 +40,7 @@
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tl_helpers.h"
 
+#include <atomic>
 #include <algorithm>
 #include <cmath>
 #include <limits>
@@ -921,7 +927,32 @@ FileId FileManager::register_empty(FileType type) {
   return register_local(FullLocalFileLocation(type, "", 0), DialogId(), 0, false, true).ok();
 }
 
+void FileManager::add_file_size_index_entry(const FullLocalFileLocation &location, int64 size) {
+  if (!file_db_ || size == 0 || location.path_.empty()) {
+    return;
+  }
+  if (!begins_with(location.path_, get_files_dir(location.file_type_))) {
+    return;
+  }
+  FileSizeIndex::Entry entry;
+  entry.file_type = location.file_type_;
+  entry.path = location.path_;
+  entry.size = size;
+  // entry update time is the best available access time proxy
+  entry.atime_nsec = static_cast<uint64>(Clocks::system() * 1e9);
+  entry.mtime_nsec = location.mtime_nsec_;
+  FileSizeIndex::set_entry(file_db_->pmc(), entry);
+}
+
+void FileManager::erase_file_size_index_entry(Slice path) {
+  if (!file_db_ || path.empty()) {
+    return;
+  }
+  FileSizeIndex::erase_entry(file_db_->pmc(), path);
+}
+
 void FileManager::on_file_unlink(const FullLocalFileLocation &location) {
+  erase_file_size_index_entry(location.path_);
   auto it = local_location_to_file_id_.find(location);
   if (it == local_location_to_file_id_.end()) {
     return;
@@ -936,6 +967,7 @@ void FileManager::on_file_unlink(const FullLocalFileLocation &location) {
 Result<FileId> FileManager::register_local(FullLocalFileLocation location, DialogId owner_dialog_id, int64 size,
                                            bool get_by_hash, bool force) {
   // TODO: use get_by_hash
+  add_file_size_index_entry(location, size);
   FileData data;
   data.local_ = LocalFileLocation(std::move(location));
   data.owner_dialog_id_ = owner_dialog_id;
@@ -1038,6 +1070,11 @@ Result<FileId> FileManager::register_file(FileData &&data, FileLocationSource fi
   node->pmc_id_ = FileDbId(data.pmc_id_);
   get_file_id_info(file_id)->node_id_ = file_node_id;
   node->file_ids_.push_back(file_id);
+  file_node_count_++;
+  if (file_node_count_ > MAX_FILE_NODE_COUNT && !file_node_evict_scheduled_) {
+    file_node_evict_scheduled_ = true;
+    send_closure_later(actor_id(this), &FileManager::evict_file_nodes);
+  }
 
   FileView file_view(get_file_node(file_id));
 
@@ -1234,6 +1271,10 @@ void FileManager::do_cancel_download(FileNodePtr node) {
   if (node->download_id_ == 0) {
     return;
   }
+  if (node->download_cancel_flag_ != nullptr) {
+    node->download_cancel_flag_->store(true, std::memory_order_relaxed);
+    node->download_cancel_flag_ = nullptr;
+  }
   send_closure(file_load_manager_, &FileLoadManager::cancel, node->download_id_);
   node->download_id_ = 0;
   node->is_download_started_ = false;
@@ -1485,6 +1526,7 @@ Result<FileId> FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sy
   }
 
   file_nodes_[node_ids[other_node_i]] = nullptr;
+  file_node_count_--;
 
   run_generate(node);
   run_download(node);
@@ -1676,18 +1718,150 @@ void FileManager::flush_to_pmc(FileNodePtr node, bool new_remote, bool new_local
                           (create_flag || new_generate));
 }
 
+static Result<FileData> load_file_data_by_pmc_id(SqliteKeyValue &pmc, FileDbId pmc_id) {
+  auto id = pmc_id;
+  string data_str;
+  for (int attempt = 0; attempt < 100; attempt++) {
+    data_str = pmc.get(PSTRING() << "file" << id.get());
+    auto data_slice = Slice(data_str);
+    if (data_slice.substr(0, 2) == "@@") {
+      id = FileDbId(to_integer<uint64>(data_slice.substr(2)));
+      continue;
+    }
+    if (data_slice.empty()) {
+      return Status::Error("No file data is found");
+    }
+    TlParser parser(data_slice);
+    FileData data;
+    data.parse(parser, true);
+    parser.fetch_end();
+    TRY_STATUS(parser.get_status());
+    return std::move(data);
+  }
+  return Status::Error("Cycle in file database?");
+}
+
+FileManager::FileNodeId FileManager::rehydrate_file_id(FileId file_id) {
+  auto pmc_id = file_id_info_[file_id.get()].evicted_pmc_id_;
+  if (pmc_id.empty() || !file_db_ || is_closed_) {
+    return 0;
+  }
+  file_id_info_[file_id.get()].evicted_pmc_id_ = FileDbId();
+  auto r_data = load_file_data_by_pmc_id(file_db_->pmc(), pmc_id);
+  if (r_data.is_error()) {
+    LOG(WARNING) << "Failed to load evicted file node " << pmc_id.get() << ": " << r_data.error();
+    return 0;
+  }
+  auto r_file_id = register_file(r_data.move_as_ok(), FileLocationSource::FromDatabase, "rehydrate", false);
+  if (r_file_id.is_error()) {
+    LOG(WARNING) << "Failed to register evicted file node " << pmc_id.get() << ": " << r_file_id.error();
+    return 0;
+  }
+  FileNodeId node_id = 0;
+  auto *node = get_file_node_raw(r_file_id.ok(), &node_id);
+  CHECK(node != nullptr);
+  // file_id_info_ could have been reallocated by register_file
+  file_id_info_[file_id.get()].node_id_ = node_id;
+  if (std::find(node->file_ids_.begin(), node->file_ids_.end(), file_id) == node->file_ids_.end()) {
+    node->file_ids_.push_back(file_id);
+  }
+  LOG(DEBUG) << "Rehydrate evicted file node " << pmc_id.get() << " for " << file_id;
+  return node_id;
+}
+
+bool FileManager::can_evict_file_node(const FileNode &node) {
+  if (node.pmc_id_.empty() || node.need_load_from_pmc_ || node.need_pmc_flush() || node.need_info_flush()) {
+    return false;
+  }
+  if (node.download_id_ != 0 || node.upload_id_ != 0 || node.generate_id_ != 0) {
+    return false;
+  }
+  if (node.download_priority_ != 0 || node.upload_priority_ != 0 || node.generate_priority_ != 0) {
+    return false;
+  }
+  for (auto file_id : node.file_ids_) {
+    auto *info = get_file_id_info(file_id);
+    if (info->send_updates_flag_ || info->sent_file_id_flag_) {
+      return false;
+    }
+    if (info->download_callback_ != nullptr || info->upload_callback_ != nullptr) {
+      return false;
+    }
+    if (info->download_priority_ != 0 || info->upload_priority_ != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FileManager::evict_file_node(FileNodeId node_id) {
+  auto node = std::move(file_nodes_[node_id]);
+  CHECK(node != nullptr);
+  if (node->local_.type() == LocalFileLocation::Type::Full) {
+    auto it = local_location_to_file_id_.find(node->local_.full());
+    if (it != local_location_to_file_id_.end() && file_id_info_[it->second.get()].node_id_ == node_id) {
+      local_location_to_file_id_.erase(it);
+    }
+  }
+  if (node->generate_ != nullptr) {
+    auto it = generate_location_to_file_id_.find(*node->generate_);
+    if (it != generate_location_to_file_id_.end() && file_id_info_[it->second.get()].node_id_ == node_id) {
+      generate_location_to_file_id_.erase(it);
+    }
+  }
+  for (auto file_id : node->file_ids_) {
+    auto &info = file_id_info_[file_id.get()];
+    info.node_id_ = 0;
+    info.evicted_pmc_id_ = node->pmc_id_;
+  }
+  file_node_count_--;
+}
+
+void FileManager::evict_file_nodes() {
+  file_node_evict_scheduled_ = false;
+  if (is_closed_ || !file_db_ || file_node_count_ <= MAX_FILE_NODE_COUNT) {
+    return;
+  }
+  std::vector<std::pair<uint64, FileNodeId>> candidates;
+  for (FileNodeId node_id = 1; node_id < static_cast<FileNodeId>(file_nodes_.size()); node_id++) {
+    auto *node = file_nodes_[node_id].get();
+    if (node != nullptr && can_evict_file_node(*node)) {
+      candidates.emplace_back(node->touch_generation_, node_id);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  auto target_count = MAX_FILE_NODE_COUNT / 10 * 9;
+  size_t evicted_count = 0;
+  for (auto &candidate : candidates) {
+    if (file_node_count_ <= target_count) {
+      break;
+    }
+    evict_file_node(candidate.second);
+    evicted_count++;
+  }
+  LOG(INFO) << "Evicted " << evicted_count << " of " << candidates.size() << " idle file nodes, "
+            << file_node_count_ << " nodes are left";
+}
+
 FileNode *FileManager::get_file_node_raw(FileId file_id, FileNodeId *file_node_id) {
   if (file_id.get() <= 0 || file_id.get() >= static_cast<int32>(file_id_info_.size())) {
     return nullptr;
   }
   FileNodeId node_id = file_id_info_[file_id.get()].node_id_;
   if (node_id == 0) {
-    return nullptr;
+    node_id = rehydrate_file_id(file_id);
+    if (node_id == 0) {
+      return nullptr;
+    }
   }
   if (file_node_id != nullptr) {
     *file_node_id = node_id;
   }
-  return file_nodes_[node_id].get();
+  auto *node = file_nodes_[node_id].get();
+  if (node != nullptr) {
+    node->touch_generation_ = ++file_node_touch_generation_;
+  }
+  return node;
 }
 
 FileNodePtr FileManager::get_sync_file_node(FileId file_id) {
@@ -1837,6 +2011,21 @@ void FileManager::read_file_part(FileId file_id, int32 offset, int32 count, int
 
   auto file_view = FileView(node);
 
+  // sequential reads are typically a media player streaming the file; if the
+  // file is being downloaded with a limited window, keep the window ahead of
+  // the last read, so the reader doesn't stall at the window boundary waiting
+  // for the next explicit download request
+  if (node->download_id_ != 0 && node->download_limit_ != 0 && count > 0 && !file_view.is_encrypted_any()) {
+    constexpr int64 STREAMING_READAHEAD_SIZE = 1 << 20;
+    auto read_end = static_cast<int64>(offset) + count;
+    auto new_limit = read_end + STREAMING_READAHEAD_SIZE - node->download_offset_;
+    if (read_end > node->download_offset_ && new_limit > node->download_limit_) {
+      node->set_download_limit(new_limit);
+      run_download(node);
+      try_flush_node_info(node, "read_file_part");
+    }
+  }
+
   if (count == 0) {
     count = narrow_cast<int32>(file_view.downloaded_prefix(offset));
     if (count == 0) {
@@ -1909,8 +2098,9 @@ void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char
       LOG(INFO) << "Unlink file " << file_id << " at " << file_view.local_location().path_;
       clear_from_pmc(node);
 
+      erase_file_size_index_entry(file_view.local_location().path_);
       unlink(file_view.local_location().path_).ignore();
-      context_->on_new_file(-file_view.size(), -1);
+      context_->on_new_file(file_view.get_type(), file_view.owner_dialog_id(), -file_view.size(), -1);
       node->drop_local_location();
       try_flush_node(node, "delete_file 1");
     }
@@ -1920,6 +2110,7 @@ void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char
     }
     if (node->local_.type() == LocalFileLocation::Type::Partial) {
       LOG(INFO) << "Unlink partial file " << file_id << " at " << node->local_.partial().path_;
+      erase_file_size_index_entry(node->local_.partial().path_);
       unlink(node->local_.partial().path_).ignore();
       node->drop_local_location();
       try_flush_node(node, "delete_file 2");
@@ -2083,9 +2274,10 @@ void FileManager::run_download(FileNodePtr node) {
              << node->encryption_key_;
   auto download_offset = file_view.is_encrypted_any() ? 0 : node->download_offset_;
   auto download_limit = node->download_limit_;
+  node->download_cancel_flag_ = std::make_shared<std::atomic<bool>>(false);
   send_closure(file_load_manager_, &FileLoadManager::download, id, node->remote_.full.value(), node->local_,
                node->size_, node->suggested_name(), node->encryption_key_, node->can_search_locally_, download_offset,
-               download_limit, priority);
+               download_limit, node->download_cancel_flag_, priority);
 }
 
 class ForceUploadActor : public Actor {
@@ -3060,7 +3252,7 @@ void FileManager::on_download_ok(QueryId query_id, const FullLocalFileLocation &
     LOG(ERROR) << "Can't register local file after download: " << r_new_file_id.error();
   } else {
     if (is_new) {
-      context_->on_new_file(size, 1);
+      context_->on_new_file(local.file_type_, get_file_view(file_id).owner_dialog_id(), size, 1);
     }
     LOG_STATUS(merge(r_new_file_id.ok(), file_id));
   }
@@ -3227,7 +3419,7 @@ void FileManager::on_generate_ok(QueryId query_id, const FullLocalFileLocation &
 
   FileView file_view(file_node);
   if (!file_view.has_generate_location() || !begins_with(file_view.generate_location().conversion_, "#file_id#")) {
-    context_->on_new_file(file_view.size(), 1);
+    context_->on_new_file(file_view.get_type(), file_view.owner_dialog_id(), file_view.size(), 1);
   }
 
   run_upload(file_node, {});
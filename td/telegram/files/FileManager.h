@@ -33,6 +33,8 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <atomic>
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <set>
@@ -131,6 +133,9 @@ class FileNode {
   NewRemoteFileLocation remote_;
 
   FileLoadManager::QueryId download_id_ = 0;
+  // flipped before the cancel closure is sent, so the downloader drops
+  // still-queued results without parsing them
+  std::shared_ptr<std::atomic<bool>> download_cancel_flag_;
 
   unique_ptr<FullGenerateFileLocation> generate_;
   FileLoadManager::QueryId generate_id_ = 0;
@@ -167,6 +172,8 @@ class FileNode {
 
   bool need_load_from_pmc_ = false;
 
+  uint64 touch_generation_ = 0;
+
   bool pmc_changed_flag_{false};
   bool info_changed_flag_{false};
 
@@ -340,7 +347,7 @@ class FileManager : public FileLoadManager::Callback {
 
   class Context {
    public:
-    virtual void on_new_file(int64 size, int32 cnt) = 0;
+    virtual void on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt) = 0;
 
     virtual void on_file_updated(FileId size) = 0;
 
@@ -483,6 +490,7 @@ class FileManager : public FileLoadManager::Callback {
   };
   struct FileIdInfo {
     FileNodeId node_id_{0};
+    FileDbId evicted_pmc_id_;
     bool send_updates_flag_{false};
     bool pin_flag_{false};
     bool sent_file_id_flag_{false};
@@ -514,7 +522,12 @@ class FileManager : public FileLoadManager::Callback {
       return this->remote_ < other.remote_;
     }
   };
-  Enumerator<RemoteInfo> remote_location_info_;
+  struct RemoteInfoHash {
+    std::size_t operator()(const RemoteInfo &info) const {
+      return info.remote_.get_hash();
+    }
+  };
+  Enumerator<RemoteInfo, RemoteInfoHash> remote_location_info_;
 
   std::map<FullLocalFileLocation, FileId> local_location_to_file_id_;
   std::map<FullGenerateFileLocation, FileId> generate_location_to_file_id_;
@@ -532,6 +545,19 @@ class FileManager : public FileLoadManager::Callback {
 
   std::set<std::string> bad_paths_;
 
+  // nodes above this count with no active operation and no pinned usages are
+  // evicted to the file database and rehydrated on demand
+  static constexpr size_t MAX_FILE_NODE_COUNT = 100000;
+
+  size_t file_node_count_ = 0;
+  uint64 file_node_touch_generation_ = 0;
+  bool file_node_evict_scheduled_ = false;
+
+  FileNodeId rehydrate_file_id(FileId file_id);
+  bool can_evict_file_node(const FileNode &node);
+  void evict_file_node(FileNodeId node_id);
+  void evict_file_nodes();
+
   FileId next_file_id();
   FileNodeId next_file_node_id();
   int32 next_pmc_file_id();
@@ -553,6 +579,8 @@ class FileManager : public FileLoadManager::Callback {
   void try_flush_node_info(FileNodePtr node, const char *source);
   void try_flush_node_pmc(FileNodePtr node, const char *source);
   void clear_from_pmc(FileNodePtr node);
+  void add_file_size_index_entry(const FullLocalFileLocation &location, int64 size);
+  void erase_file_size_index_entry(Slice path);
   void flush_to_pmc(FileNodePtr node, bool new_remote, bool new_local, bool new_generate, const char *source);
   void load_from_pmc(FileNodePtr node, bool new_remote, bool new_local, bool new_generate);
 
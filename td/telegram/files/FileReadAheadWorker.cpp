@@ -0,0 +1,41 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileReadAheadWorker.h"
+
+#include "td/utils/Status.h"
+
+#include <utility>
+
+namespace td {
+
+FileReadAheadWorker::FileReadAheadWorker(string path) : path_(std::move(path)) {
+}
+
+void FileReadAheadWorker::prefetch(int64 offset, size_t size, Promise<BufferSlice> promise) {
+  if (fd_.empty()) {
+    auto r_fd = FileFd::open(path_, FileFd::Read);
+    if (r_fd.is_error()) {
+      return promise.set_error(r_fd.move_as_error());
+    }
+    fd_ = r_fd.move_as_ok();
+  }
+  BufferSlice bytes(size);
+  auto r_read_size = fd_.pread(bytes.as_slice(), offset);
+  if (r_read_size.is_error()) {
+    return promise.set_error(r_read_size.move_as_error());
+  }
+  if (r_read_size.ok() != size) {
+    return promise.set_error(Status::Error("Failed to read file part ahead of time"));
+  }
+  promise.set_value(std::move(bytes));
+}
+
+void FileReadAheadWorker::release_fd() {
+  fd_.close();
+}
+
+}  // namespace td
@@ -0,0 +1,34 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+#include "td/actor/PromiseFuture.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/port/FileFd.h"
+
+namespace td {
+
+// Reads file parts into memory ahead of the uploader, so that the uploader's
+// scheduler thread never waits for the disk. Must be run on a scheduler where
+// blocking reads are allowed.
+class FileReadAheadWorker : public Actor {
+ public:
+  explicit FileReadAheadWorker(string path);
+
+  void prefetch(int64 offset, size_t size, Promise<BufferSlice> promise);
+
+  void release_fd();
+
+ private:
+  string path_;
+  FileFd fd_;
+};
+
+}  // namespace td
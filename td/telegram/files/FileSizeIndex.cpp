@@ -0,0 +1,86 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileSizeIndex.h"
+
+#include "td/db/SqliteKeyValue.h"
+
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/ScopeGuard.h"
+#include "td/utils/tl_helpers.h"
+
+namespace td {
+
+namespace {
+
+string get_entry_key(Slice path) {
+  return PSTRING() << "fsize" << path;
+}
+
+}  // namespace
+
+template <class StorerT>
+void FileSizeIndex::Entry::store(StorerT &storer) const {
+  using td::store;
+  store(static_cast<int32>(file_type), storer);
+  store(path, storer);
+  store(size, storer);
+  store(atime_nsec, storer);
+  store(mtime_nsec, storer);
+}
+
+template <class ParserT>
+void FileSizeIndex::Entry::parse(ParserT &parser) {
+  using td::parse;
+  int32 raw_file_type;
+  parse(raw_file_type, parser);
+  if (raw_file_type < 0 || raw_file_type >= file_type_size) {
+    return parser.set_error("Invalid file type");
+  }
+  file_type = static_cast<FileType>(raw_file_type);
+  parse(path, parser);
+  parse(size, parser);
+  parse(atime_nsec, parser);
+  parse(mtime_nsec, parser);
+}
+
+bool FileSizeIndex::is_ready(SqliteKeyValue &pmc) {
+  return pmc.get("file_size_index_ready") == "1";
+}
+
+void FileSizeIndex::set_entry(SqliteKeyValue &pmc, const Entry &entry) {
+  pmc.set(get_entry_key(entry.path), serialize(entry));
+}
+
+void FileSizeIndex::erase_entry(SqliteKeyValue &pmc, Slice path) {
+  pmc.erase(get_entry_key(path));
+}
+
+void FileSizeIndex::for_each_entry(SqliteKeyValue &pmc, const std::function<void(Entry)> &callback) {
+  pmc.get_by_prefix("fsize", [&](Slice, Slice value) {
+    Entry entry;
+    if (unserialize(entry, value).is_error()) {
+      LOG(ERROR) << "Invalid file size index entry " << tag("value", format::escaped(value));
+      return;
+    }
+    callback(std::move(entry));
+  });
+}
+
+void FileSizeIndex::rebuild(SqliteKeyValue &pmc, const vector<Entry> &entries) {
+  pmc.begin_transaction().ensure();
+  SCOPE_EXIT {
+    pmc.commit_transaction().ensure();
+  };
+  pmc.erase_by_prefix("fsize");
+  for (auto &entry : entries) {
+    set_entry(pmc, entry);
+  }
+  pmc.set("file_size_index_ready", "1");
+}
+
+}  // namespace td
@@ -0,0 +1,46 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/FileType.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <functional>
+
+namespace td {
+
+class SqliteKeyValue;
+
+// Persistent path -> {size, access time, file type} index stored in the file
+// database. FileManager keeps it up to date as files are created and deleted,
+// so storage statistics and files GC can be served from an index scan instead
+// of a full filesystem walk
+class FileSizeIndex {
+ public:
+  struct Entry {
+    FileType file_type{FileType::None};
+    string path;
+    int64 size{0};
+    uint64 atime_nsec{0};
+    uint64 mtime_nsec{0};
+
+    template <class StorerT>
+    void store(StorerT &storer) const;
+    template <class ParserT>
+    void parse(ParserT &parser);
+  };
+
+  static bool is_ready(SqliteKeyValue &pmc);
+  static void set_entry(SqliteKeyValue &pmc, const Entry &entry);
+  static void erase_entry(SqliteKeyValue &pmc, Slice path);
+  static void for_each_entry(SqliteKeyValue &pmc, const std::function<void(Entry)> &callback);
+  static void rebuild(SqliteKeyValue &pmc, const vector<Entry> &entries);
+};
+
+}  // namespace td
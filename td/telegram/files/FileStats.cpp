@@ -31,6 +31,18 @@ void FileStats::add(StatByType &by_type, FileType file_type, int64 size) {
   by_type[pos].cnt++;
 }
 
+void FileStats::apply_delta(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt) {
+  auto pos = static_cast<size_t>(file_type);
+  CHECK(pos < stat_by_type.size());
+  stat_by_type[pos].size += size;
+  stat_by_type[pos].cnt += cnt;
+  if (split_by_owner_dialog_id) {
+    auto &stat = stat_by_owner_dialog_id[owner_dialog_id][pos];
+    stat.size += size;
+    stat.cnt += cnt;
+  }
+}
+
 void FileStats::add(FullFileInfo &&info) {
   if (split_by_owner_dialog_id) {
     add(stat_by_owner_dialog_id[info.owner_dialog_id], info.file_type, info.size);
@@ -80,6 +80,7 @@ struct FileStats {
   std::vector<FullFileInfo> all_files;
 
   void add(FullFileInfo &&info);
+  void apply_delta(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt);
   void apply_dialog_limit(int32 limit);
 
   tl_object_ptr<td_api::storageStatistics> as_td_api() const;
@@ -90,6 +91,40 @@ struct FileStats {
   void add(StatByType &by_type, FileType file_type, int64 size);
 };
 
+template <class StorerT>
+void store(const FileStats &stats, StorerT &storer) {
+  using ::td::store;
+  store(stats.split_by_owner_dialog_id, storer);
+  for (const auto &stat : stats.stat_by_type) {
+    store(stat, storer);
+  }
+  store(static_cast<int32>(stats.stat_by_owner_dialog_id.size()), storer);
+  for (const auto &by_dialog : stats.stat_by_owner_dialog_id) {
+    store(by_dialog.first, storer);
+    for (const auto &stat : by_dialog.second) {
+      store(stat, storer);
+    }
+  }
+}
+template <class ParserT>
+void parse(FileStats &stats, ParserT &parser) {
+  using ::td::parse;
+  parse(stats.split_by_owner_dialog_id, parser);
+  for (auto &stat : stats.stat_by_type) {
+    parse(stat, parser);
+  }
+  int32 dialog_count;
+  parse(dialog_count, parser);
+  for (int32 i = 0; i < dialog_count; i++) {
+    DialogId dialog_id;
+    parse(dialog_id, parser);
+    auto &by_type = stats.stat_by_owner_dialog_id[dialog_id];
+    for (auto &stat : by_type) {
+      parse(stat, parser);
+    }
+  }
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const FileStats &file_stats);
 
 }  // namespace td
@@ -10,6 +10,7 @@
 #include "td/telegram/files/FileData.h"
 #include "td/telegram/files/FileDb.h"
 #include "td/telegram/files/FileLoaderUtils.h"
+#include "td/telegram/files/FileSizeIndex.h"
 #include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileType.h"
 #include "td/telegram/Global.h"
@@ -130,17 +131,52 @@ void scan_fs(CallbackT &&callback) {
         .ignore();
   }
 }
+
+// uses the persistent file size index instead of walking the filesystem
+template <class CallbackT>
+void scan_file_size_index(SqliteKeyValue &pmc, CallbackT &&callback) {
+  FileSizeIndex::for_each_entry(pmc, [&](FileSizeIndex::Entry entry) {
+    FsFileInfo info;
+    info.file_type = entry.file_type;
+    info.path = std::move(entry.path);
+    info.size = entry.size;
+    info.atime_nsec = entry.atime_nsec;
+    info.mtime_nsec = entry.mtime_nsec;
+    callback(info);
+  });
+}
 }  // namespace
 
 void FileStatsWorker::get_stats(bool need_all_files, bool split_by_owner_dialog_id, Promise<FileStats> promise) {
   if (!G()->parameters().use_chat_info_db) {
     split_by_owner_dialog_id = false;
   }
+  SqliteKeyValue *pmc =
+      G()->parameters().use_file_db ? &G()->td_db()->get_file_db_shared()->pmc() : nullptr;
+  // scan the index when it is ready; otherwise do the slow filesystem walk
+  // once and rebuild the index from its result
+  auto scan_files = [&](auto &&callback) {
+    if (pmc != nullptr && FileSizeIndex::is_ready(*pmc)) {
+      scan_file_size_index(*pmc, callback);
+      return;
+    }
+    if (pmc == nullptr) {
+      scan_fs(callback);
+      return;
+    }
+    std::vector<FileSizeIndex::Entry> entries;
+    scan_fs([&](FsFileInfo &fs_info) {
+      entries.push_back(
+          FileSizeIndex::Entry{fs_info.file_type, fs_info.path, fs_info.size, fs_info.atime_nsec, fs_info.mtime_nsec});
+      callback(fs_info);
+    });
+    FileSizeIndex::rebuild(*pmc, entries);
+  };
   if (!split_by_owner_dialog_id) {
     FileStats file_stats;
     file_stats.need_all_files = need_all_files;
     auto start = Time::now();
-    scan_fs([&](FsFileInfo &fs_info) {
+    scan_files([&](FsFileInfo &fs_info) {
       FullFileInfo info;
       info.file_type = fs_info.file_type;
       info.path = std::move(fs_info.path);
@@ -156,7 +192,7 @@ void FileStatsWorker::get_stats(bool need_all_files, bool split_by_owner_dialog_
     auto start = Time::now();
 
     std::vector<FullFileInfo> full_infos;
-    scan_fs([&](FsFileInfo &fs_info) {
+    scan_files([&](FsFileInfo &fs_info) {
       FullFileInfo info;
       info.file_type = fs_info.file_type;
       info.path = std::move(fs_info.path);
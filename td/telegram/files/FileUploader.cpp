@@ -9,6 +9,7 @@
 #include "td/telegram/telegram_api.h"
 
 #include "td/telegram/files/FileLoaderUtils.h"
+#include "td/telegram/files/FileReadAheadWorker.h"
 
 #include "td/telegram/Global.h"
 #include "td/telegram/net/DcId.h"
@@ -160,6 +161,7 @@ Result<FileLoader::PrefixInfo> FileUploader::on_update_local_location(const Loca
     fd_ = res_fd.move_as_ok();
     fd_path_ = path;
     is_temp_ = is_temp;
+    drop_read_ahead();
   }
 
   if (local_is_ready) {
@@ -248,8 +250,19 @@ Result<std::pair<NetQueryPtr, bool>> FileUploader::start_part(Part part, int32 p
   if (encryption_key_.is_secret()) {
     padded_size = (padded_size + 15) & ~15;
   }
-  BufferSlice bytes(padded_size);
-  TRY_RESULT(size, fd_.pread(bytes.as_slice().truncate(part.size), part.offset));
+  BufferSlice bytes;
+  auto it = read_ahead_parts_.find(part.offset);
+  if (it != read_ahead_parts_.end() && it->second.size() == padded_size && padded_size == part.size) {
+    bytes = std::move(it->second);
+    read_ahead_parts_.erase(it);
+  } else {
+    bytes = BufferSlice(padded_size);
+    TRY_RESULT(size, fd_.pread(bytes.as_slice().truncate(part.size), part.offset));
+    if (size != part.size) {
+      return Status::Error("Failed to read file part");
+    }
+  }
+  schedule_read_ahead(part.offset + static_cast<int64>(part.size), part.size);
   if (encryption_key_.is_secret()) {
     Random::secure_bytes(bytes.as_slice().substr(part.size));
     if (next_offset_ == part.offset) {
@@ -265,10 +278,6 @@ Result<std::pair<NetQueryPtr, bool>> FileUploader::start_part(Part part, int32 p
     }
   }
 
-  if (size != part.size) {
-    return Status::Error("Failed to read file part");
-  }
-
   NetQueryPtr net_query;
   if (big_flag_) {
     auto query =
@@ -329,6 +338,53 @@ void FileUploader::try_release_fd() {
   if (!keep_fd_ && !fd_.empty()) {
     fd_.close();
   }
+  if (!keep_fd_ && !read_ahead_worker_.empty()) {
+    send_closure(read_ahead_worker_, &FileReadAheadWorker::release_fd);
+  }
+}
+
+void FileUploader::schedule_read_ahead(int64 offset, size_t part_size) {
+  if (part_size == 0 || encryption_key_.is_secret() || fd_path_.empty()) {
+    return;
+  }
+  if (read_ahead_until_ < offset) {
+    read_ahead_until_ = offset;
+  }
+  auto end_offset = min(offset + static_cast<int64>(part_size) * READ_AHEAD_PART_COUNT, local_size_);
+  if (read_ahead_until_ >= end_offset) {
+    return;
+  }
+  if (read_ahead_worker_.empty()) {
+    read_ahead_worker_ = create_actor_on_scheduler<FileReadAheadWorker>("ReadAheadWorker",
+                                                                        G()->get_gc_scheduler_id(), fd_path_);
+  }
+  while (read_ahead_until_ < end_offset) {
+    auto size = static_cast<size_t>(min(static_cast<int64>(part_size), end_offset - read_ahead_until_));
+    auto promise = PromiseCreator::lambda(
+        [actor_id = actor_id(this), offset = read_ahead_until_](Result<BufferSlice> r_bytes) {
+          send_closure(actor_id, &FileUploader::on_read_ahead_part, offset, std::move(r_bytes));
+        });
+    send_closure(read_ahead_worker_, &FileReadAheadWorker::prefetch, read_ahead_until_, size, std::move(promise));
+    read_ahead_until_ += static_cast<int64>(size);
+  }
+}
+
+void FileUploader::on_read_ahead_part(int64 offset, Result<BufferSlice> r_bytes) {
+  if (r_bytes.is_error()) {
+    LOG(INFO) << "Read ahead at offset " << offset << " has failed: " << r_bytes.error();
+    return;
+  }
+  if (read_ahead_parts_.size() >= 2 * READ_AHEAD_PART_COUNT) {
+    // parts are requested out of order; don't let stale entries pile up
+    read_ahead_parts_.clear();
+  }
+  read_ahead_parts_[offset] = r_bytes.move_as_ok();
+}
+
+void FileUploader::drop_read_ahead() {
+  read_ahead_parts_.clear();
+  read_ahead_worker_.reset();
+  read_ahead_until_ = 0;
 }
 
 Status FileUploader::acquire_fd() {
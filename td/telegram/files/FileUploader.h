@@ -11,14 +11,18 @@
 #include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileType.h"
 
+#include "td/utils/buffer.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/Status.h"
 #include "td/utils/UInt.h"
 
+#include <map>
 #include <utility>
 
 namespace td {
 
+class FileReadAheadWorker;
+
 class FileUploader : public FileLoader {
  public:
   class Callback : public FileLoader::Callback {
@@ -72,6 +76,14 @@ class FileUploader : public FileLoader {
 
   Status generate_iv_map();
 
+  static constexpr int READ_AHEAD_PART_COUNT = 4;
+  ActorOwn<FileReadAheadWorker> read_ahead_worker_;
+  std::map<int64, BufferSlice> read_ahead_parts_;
+  int64 read_ahead_until_ = 0;
+  void schedule_read_ahead(int64 offset, size_t part_size);
+  void on_read_ahead_part(int64 offset, Result<BufferSlice> r_bytes);
+  void drop_read_ahead();
+
   bool keep_fd_ = false;
   void keep_fd_flag(bool keep_fd) override;
   void try_release_fd();
@@ -120,8 +120,13 @@ Status PartsManager::init(int64 size, int64 expected_size, bool is_size_final, s
       return Status::Error("FILE_UPLOAD_RESTART");
     }
   } else {
-    // TODO choose part_size_ depending on size
+    // grow part_size_ with the expected size, so that big files are
+    // transferred in fewer, bigger queries and each round trip moves more data
     part_size_ = 64 * (1 << 10);
+    while (part_size_ < MAX_PART_SIZE &&
+           static_cast<int64>(part_size_) * ADAPTIVE_PART_COUNT < expected_size_) {
+      part_size_ *= 2;
+    }
     while (use_part_count_limit && calc_part_count(expected_size_, part_size_) > MAX_PART_COUNT) {
       part_size_ *= 2;
       CHECK(part_size_ <= MAX_PART_SIZE);
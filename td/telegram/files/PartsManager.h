@@ -55,6 +55,9 @@ class PartsManager {
  private:
   static constexpr int MAX_PART_COUNT = 3000;
   static constexpr int MAX_PART_SIZE = 512 * (1 << 10);
+  // with a known size the part size is doubled until the file fits in
+  // roughly this number of parts
+  static constexpr int ADAPTIVE_PART_COUNT = 64;
   static constexpr int64 MAX_FILE_SIZE = MAX_PART_SIZE * MAX_PART_COUNT;
 
   enum class PartStatus : int32 { Empty, Pending, Ready };
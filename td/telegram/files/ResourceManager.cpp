@@ -13,9 +13,14 @@
 #include "td/utils/ScopeGuard.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace td {
 
+// files which need at most this much extra budget are considered
+// latency-sensitive and are allowed to preempt bulk transfers
+static constexpr int64 SMALL_FILE_MAX_RESOURCE = 512 * (1 << 10);
+
 void ResourceManager::register_worker(ActorShared<FileLoaderActor> callback, int8 priority) {
   auto node_id = nodes_container_.create();
   auto *node_ptr = nodes_container_.get(node_id);
@@ -98,11 +103,20 @@ void ResourceManager::add_to_heap(Node *node) {
   }
 }
 
+ResourceManager::Node *ResourceManager::get_node(NodeId node_id) {
+  auto node_ptr = nodes_container_.get(node_id);
+  CHECK(node_ptr);
+  auto node = (*node_ptr).get();
+  CHECK(node);
+  return node;
+}
+
+int32 ResourceManager::get_weight(int8 priority) {
+  return max(static_cast<int32>(priority), 1);
+}
+
 bool ResourceManager::satisfy_node(NodeId file_node_id) {
-  auto file_node_ptr = nodes_container_.get(file_node_id);
-  CHECK(file_node_ptr);
-  auto file_node = (*file_node_ptr).get();
-  CHECK(file_node);
+  auto file_node = get_node(file_node_id);
   auto part_size = narrow_cast<int64>(file_node->resource_state_.unit_size());
   auto need = file_node->resource_state_.estimated_extra();
   VLOG(files) << tag("need", need) << tag("part_size", part_size);
@@ -120,6 +134,9 @@ bool ResourceManager::satisfy_node(NodeId file_node_id) {
   }
   resource_state_.start_use(give);
   file_node->resource_state_.update_limit(give);
+  // charge given bytes against the node's weight, so that long-term
+  // throughput stays proportional to priority
+  file_node->fair_share_debt_ += give / get_weight(file_node->priority_);
   send_closure(file_node->callback_, &FileLoaderActor::update_resources, file_node->resource_state_);
   return true;
 }
@@ -132,8 +149,8 @@ void ResourceManager::loop() {
     return;
   }
   auto active_limit = resource_state_.active_limit();
-  resource_state_.update_limit(2 * 1024 * (1 << 10) - active_limit);
-  LOG(INFO) << tag("unused", resource_state_.unused());
+  resource_state_.update_limit(window_limit_ - active_limit);
+  LOG(INFO) << tag("unused", resource_state_.unused()) << tag("window", window_limit_);
 
   if (mode_ == Mode::Greedy) {
     std::vector<Node *> to_add;
@@ -150,16 +167,56 @@ void ResourceManager::loop() {
       add_to_heap(node);
     }
   } else if (mode_ == Mode::Baseline) {
-    // plain
+    // satisfy latency-sensitive small files first, then hand out the
+    // remaining budget by weighted fair queuing
+    std::vector<Node *> bulk_nodes;
+    bool is_exhausted = false;
     for (auto &it : to_xload_) {
-      auto file_node_id = it.second;
-      if (!satisfy_node(file_node_id)) {
-        break;
+      auto file_node = get_node(it.second);
+      if (file_node->resource_state_.estimated_extra() > SMALL_FILE_MAX_RESOURCE) {
+        bulk_nodes.push_back(file_node);
+      } else if (!is_exhausted) {
+        is_exhausted = !satisfy_node(it.second);
+      }
+    }
+    if (!is_exhausted) {
+      // the node with the smallest weighted debt was given the least bandwidth
+      // relative to its priority and goes first
+      std::sort(bulk_nodes.begin(), bulk_nodes.end(), [](const Node *a, const Node *b) {
+        if (a->fair_share_debt_ != b->fair_share_debt_) {
+          return a->fair_share_debt_ < b->fair_share_debt_;
+        }
+        return a->priority_ > b->priority_;
+      });
+      for (auto *file_node : bulk_nodes) {
+        if (!satisfy_node(file_node->node_id)) {
+          break;
+        }
       }
     }
   }
+
+  // adapt the pipelining window to demand: while loaders consume the whole
+  // budget the pipe isn't full yet and the window is doubled, so that
+  // high-bandwidth-delay links are able to keep enough parts in flight
+  auto unused = resource_state_.unused();
+  if (unused == 0) {
+    window_limit_ = min(window_limit_ * 2, MAX_WINDOW_LIMIT);
+  } else if (unused > window_limit_ / 2 && window_limit_ > MIN_WINDOW_LIMIT) {
+    window_limit_ = max(window_limit_ - window_limit_ / 8, MIN_WINDOW_LIMIT);
+  }
 }
 void ResourceManager::add_node(NodeId node_id, int8 priority) {
+  auto node = get_node(node_id);
+  node->priority_ = narrow_cast<int8>(priority >= 0 ? priority : -priority);
+  if (!to_xload_.empty()) {
+    // a node must not be owed the bandwidth it has never waited for
+    auto min_debt = std::numeric_limits<int64>::max();
+    for (auto &it : to_xload_) {
+      min_debt = min(min_debt, get_node(it.second)->fair_share_debt_);
+    }
+    node->fair_share_debt_ = max(node->fair_share_debt_, min_debt);
+  }
   if (priority >= 0) {
     auto it = std::find_if(to_xload_.begin(), to_xload_.end(), [&](auto &x) { return x.first <= priority; });
     to_xload_.insert(it, std::make_pair(priority, node_id));
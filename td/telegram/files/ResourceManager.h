@@ -36,6 +36,8 @@ class ResourceManager : public Actor {
 
     ResourceState resource_state_;
     ActorShared<FileLoaderActor> callback_;
+    int8 priority_ = 1;
+    int64 fair_share_debt_ = 0;
 
     HeapNode *as_heap_node() {
       return static_cast<HeapNode *>(this);
@@ -45,10 +47,14 @@ class ResourceManager : public Actor {
     }
   };
 
+  static constexpr int64 MIN_WINDOW_LIMIT = 2 * 1024 * (1 << 10);
+  static constexpr int64 MAX_WINDOW_LIMIT = 16 * 1024 * (1 << 10);
+
   Container<unique_ptr<Node>> nodes_container_;
   vector<std::pair<int8, NodeId>> to_xload_;
   KHeap<int64> by_estimated_extra_;
   ResourceState resource_state_;
+  int64 window_limit_ = MIN_WINDOW_LIMIT;
 
   ActorShared<> parent_;
   bool stop_flag_ = false;
@@ -61,5 +67,7 @@ class ResourceManager : public Actor {
   bool satisfy_node(NodeId file_node_id);
   void add_node(NodeId node_id, int8 priority);
   bool remove_node(NodeId node_id);
+  Node *get_node(NodeId node_id);
+  static int32 get_weight(int8 priority);
 };
 }  // namespace td
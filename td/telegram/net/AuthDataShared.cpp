@@ -15,6 +15,8 @@
 #include "td/utils/tl_helpers.h"
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 
 namespace td {
 
@@ -34,17 +36,24 @@ class AuthDataSharedImpl : public AuthDataShared {
   }
 
   mtproto::AuthKey get_auth_key() override {
+    auto generation = key_generation_.load(std::memory_order_acquire);
+    auto snapshot = std::atomic_load_explicit(&key_snapshot_, std::memory_order_acquire);
+    if (snapshot != nullptr && snapshot->generation == generation) {
+      return snapshot->auth_key;
+    }
+
     string dc_key = G()->td_db()->get_binlog_pmc()->get(auth_key_key());
 
     mtproto::AuthKey res;
     if (!dc_key.empty()) {
       unserialize(res, dc_key).ensure();
     }
+    auto new_snapshot = std::make_shared<const KeySnapshot>(KeySnapshot{generation, res});
+    std::atomic_store_explicit(&key_snapshot_, new_snapshot, std::memory_order_release);
     return res;
   }
   using AuthDataShared::get_auth_state;
   std::pair<AuthState, bool> get_auth_state() override {
-    // TODO (perf):
     auto auth_key = get_auth_key();
     AuthState state = get_auth_state(auth_key);
     return std::make_pair(state, auth_key.was_auth_flag());
@@ -52,6 +61,10 @@ class AuthDataSharedImpl : public AuthDataShared {
 
   void set_auth_key(const mtproto::AuthKey &auth_key) override {
     G()->td_db()->get_binlog_pmc()->set(auth_key_key(), serialize(auth_key));
+    // the generation is advanced only after the new key is stored, so a
+    // concurrent slow-path reader cannot cache the old key under the new
+    // generation
+    key_generation_.fetch_add(1, std::memory_order_release);
     log_auth_key(auth_key);
 
     notify();
@@ -93,6 +106,19 @@ class AuthDataSharedImpl : public AuthDataShared {
   std::shared_ptr<Guard> guard_;
   RwMutex rw_mutex_;
 
+  // Cached parsed copy of the auth key. The key changes extremely rarely,
+  // while get_auth_key and get_auth_state are called from several session
+  // actors, so reads shouldn't take the key-value storage mutex and
+  // deserialize the key every time. A reader revalidates the snapshot with
+  // one generation load and goes to the storage only when the key was
+  // actually changed.
+  struct KeySnapshot {
+    uint64 generation;
+    mtproto::AuthKey auth_key;
+  };
+  std::atomic<uint64> key_generation_{1};
+  std::shared_ptr<const KeySnapshot> key_snapshot_;
+
   string auth_key_key() {
     return PSTRING() << "auth" << dc_id_.get_raw_id();
   }
@@ -37,6 +37,7 @@
 #include "td/utils/tl_helpers.h"
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 
 namespace td {
@@ -869,14 +870,17 @@ Result<mtproto::TransportType> ConnectionCreator::get_transport_type(const Proxy
 }
 
 Result<SocketFd> ConnectionCreator::find_connection(const ProxyInfo &proxy, DcId dc_id, bool allow_media_only,
-                                                    FindConnectionExtra &extra) {
+                                                    FindConnectionExtra &extra,
+                                                    const std::vector<IPAddress> &skip_ip_addresses) {
   extra.debug_str = PSTRING() << "Failed to find valid IP for " << dc_id;
   bool prefer_ipv6 =
       G()->shared_config().get_option_boolean("prefer_ipv6") || (proxy.use_proxy() && proxy.ip_address().is_ipv6());
   bool only_http = proxy.use_http_caching_proxy();
-  TRY_RESULT(info, dc_options_set_.find_connection(
-                       dc_id, allow_media_only, proxy.use_proxy() && proxy.use_socks5_proxy(), prefer_ipv6, only_http));
+  TRY_RESULT(info,
+             dc_options_set_.find_connection(dc_id, allow_media_only, proxy.use_proxy() && proxy.use_socks5_proxy(),
+                                             prefer_ipv6, only_http, skip_ip_addresses));
   extra.stat = info.stat;
+  extra.ip_address = info.option->get_ip_address();
   TRY_RESULT(transport_type, get_transport_type(proxy, info));
   extra.transport_type = std::move(transport_type);
 
@@ -965,7 +969,15 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
       }
     } else {
       if (client.pending_connections >= client.queries.size()) {
-        return;
+        // race a few staggered attempts over distinct addresses, so one
+        // blackholed endpoint doesn't stall the connect for a whole timeout
+        if (client.pending_connections >= client.queries.size() + ClientInfo::MAX_RACING_CONNECTIONS - 1) {
+          return;
+        }
+        auto stagger_at = client.last_attempt_at + ClientInfo::RACING_STAGGER_DELAY;
+        if (Time::now() < stagger_at) {
+          return client_set_timeout_at(client, stagger_at);
+        }
       }
     }
 
@@ -975,18 +987,19 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
     if (!online_flag_) {
       wakeup_at = max(wakeup_at, client.backoff.get_wakeup_at());
     }
-    if (wakeup_at > Time::now()) {
+    auto now = Time::now();
+    if (wakeup_at > now) {
       return client_set_timeout_at(client, wakeup_at);
     }
-    flood_control.add_event(static_cast<int32>(Time::now()));
+    flood_control.add_event(static_cast<int32>(now));
     if (!online_flag_) {
-      client.backoff.add_event(static_cast<int32>(Time::now()));
+      client.backoff.add_event(static_cast<int32>(now));
     }
 
     // Create new RawConnection
     // sync part
     FindConnectionExtra extra;
-    auto r_socket_fd = find_connection(proxy, client.dc_id, client.allow_media_only, extra);
+    auto r_socket_fd = find_connection(proxy, client.dc_id, client.allow_media_only, extra, client.pending_ips);
     check_mode |= extra.check_mode;
     if (r_socket_fd.is_error()) {
       LOG(WARNING) << extra.debug_str << ": " << r_socket_fd.error();
@@ -1006,6 +1019,8 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
     }
 
     client.pending_connections++;
+    client.pending_ips.push_back(extra.ip_address);
+    client.last_attempt_at = Time::now();
     if (check_mode) {
       if (extra.stat) {
         extra.stat->on_check();
@@ -1015,10 +1030,11 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
     auto promise = PromiseCreator::lambda(
         [actor_id = actor_id(this), check_mode, transport_type = extra.transport_type, hash = client.hash,
-         debug_str = extra.debug_str,
-         network_generation = network_generation_](Result<ConnectionData> r_connection_data) mutable {
+         debug_str = extra.debug_str, network_generation = network_generation_, ip_address = extra.ip_address,
+         option_stat = extra.stat, start_time = Time::now()](Result<ConnectionData> r_connection_data) mutable {
           send_closure(std::move(actor_id), &ConnectionCreator::client_create_raw_connection,
-                       std::move(r_connection_data), check_mode, transport_type, hash, debug_str, network_generation);
+                       std::move(r_connection_data), check_mode, transport_type, hash, debug_str, network_generation,
+                       ip_address, option_stat, start_time);
         });
 
     auto stats_callback =
@@ -1083,9 +1099,11 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
 void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                                      mtproto::TransportType transport_type, size_t hash,
-                                                     string debug_str, uint32 network_generation) {
-  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash, check_mode,
-                                         debug_str](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+                                                     string debug_str, uint32 network_generation, IPAddress ip_address,
+                                                     DcOptionsSet::Stat *option_stat, double start_time) {
+  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash, check_mode, debug_str, ip_address,
+                                         option_stat,
+                                         start_time](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
     if (result.is_ok()) {
       VLOG(connections) << "Ready connection (" << (check_mode ? "" : "un") << "checked) " << result.ok().get() << ' '
                         << debug_str;
@@ -1093,7 +1111,8 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
       VLOG(connections) << "Failed connection (" << (check_mode ? "" : "un") << "checked) " << result.error() << ' '
                         << debug_str;
     }
-    send_closure(std::move(actor_id), &ConnectionCreator::client_add_connection, hash, std::move(result), check_mode);
+    send_closure(std::move(actor_id), &ConnectionCreator::client_add_connection, hash, std::move(result), check_mode,
+                 ip_address, option_stat, start_time);
   });
 
   if (r_connection_data.is_error()) {
@@ -1129,14 +1148,28 @@ void ConnectionCreator::client_set_timeout_at(ClientInfo &client, double wakeup_
 }
 
 void ConnectionCreator::client_add_connection(size_t hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
-                                              bool check_flag) {
+                                              bool check_flag, IPAddress ip_address,
+                                              DcOptionsSet::Stat *option_stat, double start_time) {
   auto &client = clients_[hash];
   CHECK(client.pending_connections > 0);
   client.pending_connections--;
+  auto ip_it = std::find(client.pending_ips.begin(), client.pending_ips.end(), ip_address);
+  if (ip_it != client.pending_ips.end()) {
+    client.pending_ips.erase(ip_it);
+  }
   if (check_flag) {
     CHECK(client.checking_connections > 0);
     client.checking_connections--;
   }
+  if (r_raw_connection.is_ok() && option_stat != nullptr) {
+    option_stat->on_connect_time(Time::now() - start_time);
+  }
+  if (Time::now() > dc_option_stats_save_at_) {
+    // persist endpoint scores at most once per minute, so the learning
+    // survives a restart
+    dc_option_stats_save_at_ = Time::now() + 60;
+    G()->td_db()->get_binlog_pmc()->set("dc_option_stats", dc_options_set_.serialize_stats());
+  }
   if (r_raw_connection.is_ok()) {
     VLOG(connections) << "Add ready connection " << r_raw_connection.ok().get() << " for "
                       << tag("client", format::as_hex(hash));
@@ -1177,7 +1210,9 @@ void ConnectionCreator::on_dc_update(DcId dc_id, string ip_port, Promise<> promi
 
 void ConnectionCreator::update_mtproto_header(const Proxy &proxy) {
   if (G()->have_mtproto_header()) {
-    G()->mtproto_header().set_proxy(proxy);
+    auto mtproto_header = std::make_shared<MtprotoHeader>(*G()->mtproto_header());
+    mtproto_header->set_proxy(proxy);
+    G()->set_mtproto_header(std::move(mtproto_header));
   }
   if (G()->have_net_query_dispatcher()) {
     G()->net_query_dispatcher().update_mtproto_header();
@@ -1204,6 +1239,9 @@ void ConnectionCreator::start_up() {
   };
   send_closure(G()->state_manager(), &StateManager::add_callback, make_unique<StateCallback>(actor_id(this)));
 
+  // endpoint scores must be loaded before any DC option is registered
+  dc_options_set_.load_stats(G()->td_db()->get_binlog_pmc()->get("dc_option_stats"));
+
   auto serialized_dc_options = G()->td_db()->get_binlog_pmc()->get("dc_options");
   DcOptions dc_options;
   auto status = unserialize(dc_options, serialized_dc_options);
@@ -174,6 +174,7 @@ class ConnectionCreator : public NetQueryCallback {
  private:
   ActorShared<> parent_;
   DcOptionsSet dc_options_set_;
+  double dc_option_stats_save_at_ = 0;
   bool network_flag_ = false;
   uint32 network_generation_ = 0;
   bool online_flag_ = false;
@@ -231,6 +232,11 @@ class ConnectionCreator : public NetQueryCallback {
     std::vector<Promise<unique_ptr<mtproto::RawConnection>>> queries;
 
     static constexpr double READY_CONNECTIONS_TIMEOUT = 10;
+    static constexpr size_t MAX_RACING_CONNECTIONS = 3;
+    static constexpr double RACING_STAGGER_DELAY = 0.5;
+
+    std::vector<IPAddress> pending_ips;
+    double last_attempt_at{0};
 
     bool inited{false};
     size_t hash{0};
@@ -297,8 +303,10 @@ class ConnectionCreator : public NetQueryCallback {
   };
   void client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                     mtproto::TransportType transport_type, size_t hash, string debug_str,
-                                    uint32 network_generation);
-  void client_add_connection(size_t hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag);
+                                    uint32 network_generation, IPAddress ip_address, DcOptionsSet::Stat *option_stat,
+                                    double start_time);
+  void client_add_connection(size_t hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag,
+                             IPAddress ip_address, DcOptionsSet::Stat *option_stat, double start_time);
   void client_set_timeout_at(ClientInfo &client, double wakeup_at);
 
   void on_get_proxy_info(telegram_api::object_ptr<telegram_api::help_ProxyData> proxy_data_ptr);
@@ -314,6 +322,7 @@ class ConnectionCreator : public NetQueryCallback {
     mtproto::TransportType transport_type;
     string debug_str;
     IPAddress mtproto_ip;
+    IPAddress ip_address;
     bool check_mode{false};
   };
   class ProxyInfo;
@@ -322,7 +331,7 @@ class ConnectionCreator : public NetQueryCallback {
                                                            const DcOptionsSet::ConnectionInfo &info);
 
   Result<SocketFd> find_connection(const ProxyInfo &proxy, DcId dc_id, bool allow_media_only,
-                                   FindConnectionExtra &extra);
+                                   FindConnectionExtra &extra, const std::vector<IPAddress> &skip_ip_addresses = {});
 
   ActorId<GetHostByNameActor> get_dns_resolver();
 
@@ -8,8 +8,11 @@
 
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/tl_helpers.h"
 
 #include <algorithm>
+#include <cmath>
 #include <set>
 #include <utility>
 
@@ -122,13 +125,150 @@ vector<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_all_connections(DcId dc_
                   options.end());
   }
 
+  // previously learned endpoint quality orders the candidates, so the first
+  // connect after a restart goes to a known good address
+  std::stable_sort(options.begin(), options.end(),
+                   [](const auto &a, const auto &b) { return a.stat->is_ok() > b.stat->is_ok(); });
+
   return options;
 }
 
+namespace {
+constexpr int32 OPTION_STATS_MAGIC = 0x5e1ec7ed;
+constexpr double OPTION_STATS_DECAY_HALF_LIFE = 7 * 86400;  // seconds
+constexpr int32 OPTION_STATS_MAX_AGE = 30 * 86400;          // seconds
+
+struct OptionStatEvent {
+  string host;
+  int32 port = 0;
+  double tcp_connect_time_ema = -1;
+  double http_connect_time_ema = -1;
+  bool is_ok = true;
+  int32 last_seen = 0;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(host, storer);
+    td::store(port, storer);
+    td::store(tcp_connect_time_ema, storer);
+    td::store(http_connect_time_ema, storer);
+    td::store(static_cast<int32>(is_ok), storer);
+    td::store(last_seen, storer);
+  }
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(host, parser);
+    td::parse(port, parser);
+    td::parse(tcp_connect_time_ema, parser);
+    td::parse(http_connect_time_ema, parser);
+    int32 is_ok_int32;
+    td::parse(is_ok_int32, parser);
+    is_ok = is_ok_int32 != 0;
+    td::parse(last_seen, parser);
+  }
+};
+
+struct OptionStatsEvent {
+  int32 magic = OPTION_STATS_MAGIC;
+  std::vector<OptionStatEvent> stats;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(magic, storer);
+    td::store(stats, storer);
+  }
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(magic, parser);
+    td::parse(stats, parser);
+  }
+};
+}  // namespace
+
+void DcOptionsSet::load_stats(Slice serialized_stats) {
+  if (serialized_stats.empty()) {
+    return;
+  }
+  OptionStatsEvent event;
+  auto status = unserialize(event, serialized_stats);
+  if (status.is_error() || event.magic != OPTION_STATS_MAGIC) {
+    LOG(WARNING) << "Failed to load DC option stats: " << status;
+    return;
+  }
+
+  auto now = static_cast<int32>(Clocks::system());
+  for (auto &stat : event.stats) {
+    auto age = static_cast<double>(now - stat.last_seen);
+    if (age < 0 || age > OPTION_STATS_MAX_AGE) {
+      continue;
+    }
+    IPAddress ip_address;
+    if (ip_address.init_host_port(stat.host, stat.port).is_error()) {
+      continue;
+    }
+    // stale measurements decay towards "unmeasured", which is explored first
+    auto decay = std::exp2(-age / OPTION_STATS_DECAY_HALF_LIFE);
+    LoadedOptionStat loaded;
+    loaded.tcp_connect_time_ema = stat.tcp_connect_time_ema < 0 ? -1 : stat.tcp_connect_time_ema * decay;
+    loaded.http_connect_time_ema = stat.http_connect_time_ema < 0 ? -1 : stat.http_connect_time_ema * decay;
+    loaded.is_ok = stat.is_ok;
+    loaded.last_seen = stat.last_seen;
+    loaded_option_stats_[ip_address] = loaded;
+  }
+  LOG(INFO) << "Loaded " << loaded_option_stats_.size() << " DC option stats";
+}
+
+string DcOptionsSet::serialize_stats() {
+  OptionStatsEvent event;
+  auto now = static_cast<int32>(Clocks::system());
+  auto now_mono = Time::now();
+  for (auto &it : option_to_stat_id_) {
+    auto &ip_address = it.first;
+    auto &option_stat = *option_stats_.get(it.second)->get();
+
+    OptionStatEvent stat;
+    stat.host = ip_address.get_ip_str().str();
+    stat.port = ip_address.get_port();
+    stat.tcp_connect_time_ema = option_stat.tcp_stat.connect_time_ema;
+    stat.http_connect_time_ema = option_stat.http_stat.connect_time_ema;
+    stat.is_ok = option_stat.tcp_stat.is_ok() || option_stat.http_stat.is_ok();
+    auto ok_at = max(option_stat.tcp_stat.ok_at, option_stat.http_stat.ok_at);
+    if (ok_at > 0) {
+      stat.last_seen = now - static_cast<int32>(now_mono - ok_at);
+    } else {
+      // not seen working this session; keep what was loaded, if anything
+      auto loaded_it = loaded_option_stats_.find(ip_address);
+      if (loaded_it == loaded_option_stats_.end()) {
+        continue;
+      }
+      stat.last_seen = loaded_it->second.last_seen;
+    }
+    event.stats.push_back(std::move(stat));
+  }
+  return serialize(event);
+}
+
 Result<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_connection(DcId dc_id, bool allow_media_only, bool use_static,
-                                                                   bool prefer_ipv6, bool only_http) {
+                                                                   bool prefer_ipv6, bool only_http,
+                                                                   const std::vector<IPAddress> &skip_ip_addresses) {
   auto options = find_all_connections(dc_id, allow_media_only, use_static, prefer_ipv6, only_http);
 
+  if (!skip_ip_addresses.empty()) {
+    // used to race attempts over distinct addresses; ignored when it would
+    // leave no options at all
+    auto filtered_options = options;
+    filtered_options.erase(std::remove_if(filtered_options.begin(), filtered_options.end(),
+                                          [&](const auto &option) {
+                                            return std::find(skip_ip_addresses.begin(), skip_ip_addresses.end(),
+                                                             option.option->get_ip_address()) !=
+                                                   skip_ip_addresses.end();
+                                          }),
+                           filtered_options.end());
+    if (!filtered_options.empty()) {
+      options = std::move(filtered_options);
+    }
+  }
+
   if (options.empty()) {
     return Status::Error(PSLICE() << "No such connection: " << tag("dc_id", dc_id)
                                   << tag("allow_media_only", allow_media_only) << tag("use_static", use_static)
@@ -151,7 +291,13 @@ Result<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_connection(DcId dc_id, b
     }
     if (a_state == Stat::State::Ok) {
       if (a_option.order == b_option.order) {
-        return a_option.use_http < b_option.use_http;
+        if (a_option.use_http != b_option.use_http) {
+          return a_option.use_http < b_option.use_http;
+        }
+        // historically fastest endpoint first; an unmeasured one is explored
+        auto a_connect_time = a.connect_time_ema < 0 ? 0.0 : a.connect_time_ema;
+        auto b_connect_time = b.connect_time_ema < 0 ? 0.0 : b.connect_time_ema;
+        return a_connect_time < b_connect_time;
       }
       return a_option.order < b_option.order;
     } else if (a_state == Stat::State::Error) {
@@ -180,7 +326,19 @@ void DcOptionsSet::init_option_stat(DcOptionInfo *option_info) {
   const auto &ip_address = option_info->option.get_ip_address();
   auto it_ok = option_to_stat_id_.insert(std::make_pair(ip_address, 0));
   if (it_ok.second) {
-    it_ok.first->second = option_stats_.create(make_unique<OptionStat>());
+    auto option_stat = make_unique<OptionStat>();
+    auto loaded_it = loaded_option_stats_.find(ip_address);
+    if (loaded_it != loaded_option_stats_.end()) {
+      const auto &loaded = loaded_it->second;
+      option_stat->tcp_stat.connect_time_ema = loaded.tcp_connect_time_ema;
+      option_stat->http_stat.connect_time_ema = loaded.http_connect_time_ema;
+      if (!loaded.is_ok) {
+        // remembered as broken; it still may be retried, but after the others
+        option_stat->tcp_stat.error_at = -999;
+        option_stat->http_stat.error_at = -999;
+      }
+    }
+    it_ok.first->second = option_stats_.create(std::move(option_stat));
   }
   option_info->stat_id = it_ok.first->second;
 }
@@ -28,11 +28,19 @@ class DcOptionsSet {
     double ok_at{-1000};
     double error_at{-1001};
     double check_at{-1002};
+    double connect_time_ema{-1};
     enum class State : int32 { Ok, Error, Checking };
 
     void on_ok() {
       ok_at = Time::now_cached();
     }
+    void on_connect_time(double connect_time) {
+      if (connect_time_ema < 0) {
+        connect_time_ema = connect_time;
+      } else {
+        connect_time_ema = 0.7 * connect_time_ema + 0.3 * connect_time;
+      }
+    }
     void on_error() {
       error_at = Time::now_cached();
     }
@@ -65,9 +73,14 @@ class DcOptionsSet {
                                               bool only_http);
 
   Result<ConnectionInfo> find_connection(DcId dc_id, bool allow_media_only, bool use_static, bool prefer_ipv6,
-                                         bool only_http);
+                                         bool only_http, const std::vector<IPAddress> &skip_ip_addresses = {});
   void reset();
 
+  // per-endpoint learning survives restarts: load_stats seeds the stats of
+  // later registered options, serialize_stats dumps the current knowledge
+  void load_stats(Slice serialized_stats);
+  string serialize_stats();
+
  private:
   enum class State : int32 { Error, Ok, Checking };
 
@@ -99,9 +112,17 @@ class DcOptionsSet {
     }
   };
 
+  struct LoadedOptionStat {
+    double tcp_connect_time_ema{-1};
+    double http_connect_time_ema{-1};
+    bool is_ok{true};
+    int32 last_seen{0};  // unix time
+  };
+
   std::vector<unique_ptr<DcOptionInfo>> options_;
   std::vector<DcOptionId> ordered_options_;
   std::map<IPAddress, int64> option_to_stat_id_;
+  std::map<IPAddress, LoadedOptionStat> loaded_option_stats_;
   Container<unique_ptr<OptionStat>> option_stats_;
 
   DcOptionInfo *register_dc_option(DcOption &&option);
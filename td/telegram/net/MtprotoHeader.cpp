@@ -8,6 +8,7 @@
 
 #include "td/telegram/LanguagePackManager.h"
 
+#include "td/utils/Slice.h"
 #include "td/utils/tl_helpers.h"
 
 namespace td {
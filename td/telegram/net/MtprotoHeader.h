@@ -9,7 +9,8 @@
 #include "td/telegram/net/ConnectionCreator.h"
 
 #include "td/utils/common.h"
-#include "td/utils/Slice.h"
+
+#include <memory>
 
 namespace td {
 
@@ -33,7 +34,7 @@ class MtprotoHeader {
 
   void set_proxy(Proxy proxy) {
     options_.proxy = proxy;
-    default_header_ = gen_header(options_, false);
+    gen_default_header();
   }
 
   bool set_is_emulator(bool is_emulator) {
@@ -42,7 +43,7 @@ class MtprotoHeader {
     }
 
     options_.is_emulator = is_emulator;
-    default_header_ = gen_header(options_, false);
+    gen_default_header();
     return true;
   }
 
@@ -52,7 +53,7 @@ class MtprotoHeader {
     }
 
     options_.language_pack = std::move(language_pack);
-    default_header_ = gen_header(options_, false);
+    gen_default_header();
     return true;
   }
 
@@ -62,25 +63,31 @@ class MtprotoHeader {
     }
 
     options_.language_code = std::move(language_code);
-    default_header_ = gen_header(options_, false);
+    gen_default_header();
     return true;
   }
 
-  Slice get_default_header() const {
+  // headers are immutable refcounted blobs, regenerated on option changes, so every
+  // session can attach them without making its own copy
+  std::shared_ptr<const string> get_default_header() const {
     return default_header_;
   }
-  Slice get_anonymous_header() const {
+  std::shared_ptr<const string> get_anonymous_header() const {
     return anonymous_header_;
   }
 
  private:
   Options options_;
-  string default_header_;
-  string anonymous_header_;
+  std::shared_ptr<const string> default_header_;
+  std::shared_ptr<const string> anonymous_header_;
+
+  void gen_default_header() {
+    default_header_ = std::make_shared<const string>(gen_header(options_, false));
+  }
 
   void gen_headers() {
-    default_header_ = gen_header(options_, false);
-    anonymous_header_ = gen_header(options_, true);
+    gen_default_header();
+    anonymous_header_ = std::make_shared<const string>(gen_header(options_, true));
   }
 
   static string gen_header(const Options &options, bool is_anonymous);
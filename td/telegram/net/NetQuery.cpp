@@ -10,6 +10,7 @@
 #include "td/telegram/telegram_api.h"
 
 #include "td/utils/as.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/misc.h"
 #include "td/utils/Slice.h"
 
@@ -35,6 +36,14 @@ void NetQuery::on_net_read(size_t size) {
   G()->get_net_stats_file_callbacks().at(file_type_)->on_read(size);
 }
 
+void NetQuery::decompress_answer() const {
+  if (!answer_is_gzipped_) {
+    return;
+  }
+  answer_is_gzipped_ = false;
+  answer_ = gzdecode(answer_.as_slice());
+}
+
 int32 NetQuery::tl_magic(const BufferSlice &buffer_slice) {
   auto slice = buffer_slice.as_slice();
   if (slice.size() < 4) {
@@ -61,6 +70,7 @@ void NetQuery::set_error(Status status, string source) {
   if (status.message() == "MSG_WAIT_FAILED" && status.code() != 400) {
     status = Status::Error(400, "MSG_WAIT_FAILED");
   }
+  NetQueryStats::instance().on_failed(tl_constructor());
   set_error_impl(std::move(status), std::move(source));
 }
 
@@ -82,7 +92,7 @@ void dump_pending_network_queries() {
                    << tag("state", nq->debug_str_)
                    << tag("since state", td::format::as_time(td::Time::now_cached() - nq->debug_timestamp_))
                    << tag("resend_cnt", nq->debug_resend_cnt_) << tag("fail_cnt", nq->debug_send_failed_cnt_)
-                   << tag("ack", nq->debug_ack) << tag("unknown", nq->debug_unknown);
+                   << tag("ack", nq->debug_ack) << tag("unknown", nq->debug_unknown) << " " << nq->trace_;
     } else {
       was_gap = true;
     }
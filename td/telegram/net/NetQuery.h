@@ -20,7 +20,7 @@
 #include "td/utils/format.h"
 #include "td/utils/List.h"
 #include "td/utils/logging.h"
-#include "td/utils/ObjectPool.h"
+#include "td/utils/ShardedObjectPool.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/Time.h"
@@ -31,8 +31,10 @@
 namespace td {
 
 class NetQuery;
-using NetQueryPtr = ObjectPool<NetQuery>::OwnerPtr;
-using NetQueryRef = ObjectPool<NetQuery>::WeakPtr;
+// NetQuery objects are created by NetQueryCreator on one scheduler, but are released all over
+// the place, so the pool with a sharded freelist is used instead of the plain ObjectPool
+using NetQueryPtr = ShardedObjectPool<NetQuery>::OwnerPtr;
+using NetQueryRef = ShardedObjectPool<NetQuery>::WeakPtr;
 
 class NetQueryCallback : public Actor {
  public:
@@ -82,6 +84,7 @@ class NetQuery : public ListNode {
     dc_id_ = new_dc_id;
     status_ = Status::OK();
     state_ = State::Query;
+    NetQueryStats::instance().on_resent(tl_constructor_, dc_id_.get_value());
   }
 
   void resend() {
@@ -94,11 +97,13 @@ class NetQuery : public ListNode {
 
   BufferSlice &ok() {
     CHECK(state_ == State::OK);
+    decompress_answer();
     return answer_;
   }
 
   const BufferSlice &ok() const {
     CHECK(state_ == State::OK);
+    decompress_answer();
     return answer_;
   }
 
@@ -112,7 +117,14 @@ class NetQuery : public ListNode {
     return status_;
   }
 
+  // size of the answer as received, without materializing a gzip-packed one
+  size_t answer_size() const {
+    CHECK(state_ == State::OK);
+    return answer_.size();
+  }
+
   BufferSlice move_as_ok() {
+    decompress_answer();
     auto ok = std::move(answer_);
     clear();
     return ok;
@@ -128,6 +140,15 @@ class NetQuery : public ListNode {
     CHECK(state_ == State::Query);
     answer_ = std::move(slice);
     state_ = State::OK;
+    NetQueryStats::instance().on_answered(tl_constructor_, dc_id_.get_value(),
+                                          trace_.sent == 0 ? 0 : Time::now() - trace_.sent);
+  }
+
+  // the answer is still gzip-packed; it is inflated lazily on first access, i.e. on the
+  // thread of the query's consumer instead of the session thread
+  void set_gzipped_ok(BufferSlice slice) {
+    answer_is_gzipped_ = true;
+    set_ok(std::move(slice));
   }
 
   void on_net_write(size_t size);
@@ -171,6 +192,7 @@ class NetQuery : public ListNode {
   }
 
   int32 ok_tl_constructor() const {
+    decompress_answer();
     return tl_magic(answer_);
   }
 
@@ -205,6 +227,14 @@ class NetQuery : public ListNode {
     return session_rand_;
   }
 
+  // high-priority queries are sent ahead of already pending queries in Session
+  bool is_high_priority() const {
+    return is_high_priority_;
+  }
+  void set_high_priority() {
+    is_high_priority_ = true;
+  }
+
   void cancel(int32 cancellation_token) {
     cancellation_token_.compare_exchange_strong(cancellation_token, 0, std::memory_order_relaxed);
   }
@@ -214,6 +244,10 @@ class NetQuery : public ListNode {
 
   void clear() {
     LOG_IF(ERROR, !is_ready()) << "Destroy not ready query " << *this << " " << tag("debug", debug_str_);
+    if (state_ == State::Query) {
+      // the query is dropped without an answer; release its in-flight slot
+      NetQueryStats::instance().on_dropped(dc_id_.get_value());
+    }
     // TODO: CHECK if net_query is lost here
     cancel_slot_.close();
     *this = NetQuery();
@@ -234,7 +268,7 @@ class NetQuery : public ListNode {
   void debug(string str, bool may_be_lost = false) {
     may_be_lost_ = may_be_lost;
     debug_str_ = std::move(str);
-    debug_timestamp_ = Time::now();
+    debug_timestamp_ = Time::now_cached();
     debug_cnt_++;
     VLOG(net_query) << *this << " " << tag("debug", debug_str_);
   }
@@ -259,16 +293,22 @@ class NetQuery : public ListNode {
   static int32 tl_magic(const BufferSlice &buffer_slice);
 
  private:
+  void decompress_answer() const;
+
   State state_ = State::Empty;
   Type type_ = Type::Common;
   AuthFlag auth_flag_ = AuthFlag::Off;
   GzipFlag gzip_flag_ = GzipFlag::Off;
+  bool is_high_priority_ = false;
   DcId dc_id_;
 
   Status status_;
   uint64 id_ = 0;
   BufferSlice query_;
-  BufferSlice answer_;
+  // mutable: a gzip-packed answer is materialized on first access; queries are owned by
+  // a single consumer at a time, so there is no concurrent access to the answer
+  mutable BufferSlice answer_;
+  mutable bool answer_is_gzipped_ = false;
   int32 tl_constructor_ = 0;
 
   NetQueryRef invoke_after_;
@@ -300,6 +340,9 @@ class NetQuery : public ListNode {
 
   void set_error_impl(Status status, string source = "") {
     VLOG(net_query) << "Got error " << *this << " " << status;
+    if (state_ == State::Query) {
+      NetQueryStats::instance().on_error(dc_id_.get_value());
+    }
     status_ = std::move(status);
     state_ = State::Error;
     source_ = std::move(source);
@@ -329,6 +372,17 @@ class NetQuery : public ListNode {
   int32 my_id_ = 0;
   NetQueryCounter nq_counter_;
 
+  // end-to-end latency trace; stages are stamped as the query moves through
+  // the pipeline and are reported through the net_query log tag on delivery
+  struct Trace {
+    double created = 0;     // serialized by NetQueryCreator
+    double dispatched = 0;  // NetQueryDispatcher routed the query to a DC
+    double sent = 0;        // last write into an mtproto connection
+    double received = 0;    // result or error returned by the Session
+    double delivered = 0;   // result handed to the result handler
+  };
+  Trace trace_;
+
   NetQuery(State state, uint64 id, BufferSlice &&query, BufferSlice &&answer, DcId dc_id, Type type, AuthFlag auth_flag,
            GzipFlag gzip_flag, int32 tl_constructor)
       : state_(state)
@@ -343,7 +397,11 @@ class NetQuery : public ListNode {
       , tl_constructor_(tl_constructor)
       , nq_counter_(true) {
     my_id_ = get_my_id();
-    start_timestamp_ = Time::now();
+    start_timestamp_ = Time::now_cached();
+    trace_.created = start_timestamp_;
+    if (state_ == State::Query) {
+      NetQueryStats::instance().on_created(tl_constructor_, dc_id_.get_value());
+    }
     LOG(INFO) << *this;
     // net_query_list_.put(this);
   }
@@ -369,6 +427,23 @@ inline StringBuilder &operator<<(StringBuilder &stream, const NetQueryPtr &net_q
   return stream << *net_query_ptr;
 }
 
+inline StringBuilder &operator<<(StringBuilder &stream, const NetQuery::Trace &trace) {
+  stream << "[Trace: created";
+  double prev = trace.created;
+  struct Stage {
+    const char *name;
+    double at;
+  };
+  for (auto &stage : {Stage{"dispatched", trace.dispatched}, Stage{"sent", trace.sent},
+                      Stage{"received", trace.received}, Stage{"delivered", trace.delivered}}) {
+    if (stage.at != 0) {
+      stream << " +" << format::as_time(stage.at - prev) << " " << stage.name;
+      prev = stage.at;
+    }
+  }
+  return stream << "]";
+}
+
 void dump_pending_network_queries();
 
 inline void cancel_query(NetQueryRef &ref) {
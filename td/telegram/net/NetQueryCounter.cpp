@@ -6,8 +6,122 @@
 //
 #include "td/telegram/net/NetQueryCounter.h"
 
+#include "td/utils/port/thread_local.h"
+
+#include <map>
+
 namespace td {
 
 std::atomic<uint64> NetQueryCounter::net_query_cnt_{0};
 
+NetQueryStats &NetQueryStats::instance() {
+  static NetQueryStats stats;
+  return stats;
+}
+
+NetQueryStats::Shard &NetQueryStats::shard() {
+  return shards_[static_cast<size_t>(get_thread_id()) & (SHARD_COUNT - 1)];
+}
+
+void NetQueryStats::on_created(int32 tl_constructor, int32 dc_value) {
+  auto &s = shard();
+  auto guard = s.lock_.lock();
+  s.by_type_[tl_constructor].created_count++;
+  inflight(dc_value).fetch_add(1, std::memory_order_relaxed);
+}
+
+void NetQueryStats::on_sent(int32 tl_constructor) {
+  auto &s = shard();
+  auto guard = s.lock_.lock();
+  s.by_type_[tl_constructor].sent_count++;
+}
+
+void NetQueryStats::on_answered(int32 tl_constructor, int32 dc_value, double latency) {
+  auto &s = shard();
+  auto guard = s.lock_.lock();
+  auto &stat = s.by_type_[tl_constructor];
+  stat.answered_count++;
+  if (latency > 0) {
+    stat.total_latency += latency;
+    if (latency > stat.max_latency) {
+      stat.max_latency = latency;
+    }
+  }
+  inflight(dc_value).fetch_sub(1, std::memory_order_relaxed);
+}
+
+void NetQueryStats::on_failed(int32 tl_constructor) {
+  auto &s = shard();
+  auto guard = s.lock_.lock();
+  s.by_type_[tl_constructor].failed_count++;
+}
+
+void NetQueryStats::on_resent(int32 tl_constructor, int32 dc_value) {
+  auto &s = shard();
+  auto guard = s.lock_.lock();
+  s.by_type_[tl_constructor].resent_count++;
+  inflight(dc_value).fetch_add(1, std::memory_order_relaxed);
+}
+
+void NetQueryStats::on_error(int32 dc_value) {
+  inflight(dc_value).fetch_sub(1, std::memory_order_relaxed);
+}
+
+void NetQueryStats::on_dropped(int32 dc_value) {
+  inflight(dc_value).fetch_sub(1, std::memory_order_relaxed);
+}
+
+vector<std::pair<int32, NetQueryStats::TypeStat>> NetQueryStats::get_type_stats() {
+  // an ordered map, so the snapshot is stable between calls
+  std::map<int32, TypeStat> merged;
+  for (auto &s : shards_) {
+    auto guard = s.lock_.lock();
+    for (auto &it : s.by_type_) {
+      auto &stat = merged[it.first];
+      stat.created_count += it.second.created_count;
+      stat.sent_count += it.second.sent_count;
+      stat.answered_count += it.second.answered_count;
+      stat.failed_count += it.second.failed_count;
+      stat.resent_count += it.second.resent_count;
+      stat.total_latency += it.second.total_latency;
+      if (it.second.max_latency > stat.max_latency) {
+        stat.max_latency = it.second.max_latency;
+      }
+    }
+  }
+  return {merged.begin(), merged.end()};
+}
+
+void NetQueryStats::set_session_pipeline(int32 dc_value, bool is_main, int64 inflight_count, int64 window_size) {
+  auto pos = static_cast<size_t>(dc_value + 2) % inflight_.size();
+  auto kind = is_main ? 0 : 1;
+  pipeline_inflight_[kind][pos].store(inflight_count, std::memory_order_relaxed);
+  pipeline_window_[kind][pos].store(window_size, std::memory_order_relaxed);
+}
+
+vector<NetQueryStats::SessionPipelineStat> NetQueryStats::get_session_pipeline_stats() const {
+  vector<SessionPipelineStat> result;
+  for (int kind = 0; kind < 2; kind++) {
+    for (size_t i = 0; i < pipeline_window_[kind].size(); i++) {
+      auto window_size = pipeline_window_[kind][i].load(std::memory_order_relaxed);
+      if (window_size != 0) {
+        result.push_back({static_cast<int32>(i) - 2, kind == 0,
+                          pipeline_inflight_[kind][i].load(std::memory_order_relaxed), window_size});
+      }
+    }
+  }
+  return result;
+}
+
+vector<std::pair<int32, int64>> NetQueryStats::get_inflight_counts() const {
+  vector<std::pair<int32, int64>> result;
+  for (size_t i = 0; i < inflight_.size(); i++) {
+    auto count = inflight_[i].load(std::memory_order_relaxed);
+    if (count != 0) {
+      result.emplace_back(static_cast<int32>(i) - 2, count);
+    }
+  }
+  return result;
+}
+
 }  // namespace td
@@ -7,8 +7,12 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/SpinLock.h"
 
+#include <array>
 #include <atomic>
+#include <unordered_map>
+#include <utility>
 
 namespace td {
 
@@ -52,4 +56,72 @@ class NetQueryCounter {
  private:
   bool is_alive_;
 };
+
+// Process-wide per-query-type statistics: counters for every TL-function,
+// in-flight gauges for every DC and send-to-answer latency aggregates.
+// The counters are updated from hot paths on several threads, so they are
+// sharded by thread id and merged only when a snapshot is requested.
+class NetQueryStats {
+ public:
+  struct TypeStat {
+    uint64 created_count = 0;
+    uint64 sent_count = 0;
+    uint64 answered_count = 0;
+    uint64 failed_count = 0;
+    uint64 resent_count = 0;
+    double total_latency = 0;  // sum over answered queries of (answer - last send), in seconds
+    double max_latency = 0;
+  };
+
+  static NetQueryStats &instance();
+
+  void on_created(int32 tl_constructor, int32 dc_value);
+  void on_sent(int32 tl_constructor);
+  void on_answered(int32 tl_constructor, int32 dc_value, double latency);
+  void on_failed(int32 tl_constructor);
+  void on_resent(int32 tl_constructor, int32 dc_value);
+  void on_error(int32 dc_value);
+  void on_dropped(int32 dc_value);
+
+  vector<std::pair<int32, TypeStat>> get_type_stats();
+  vector<std::pair<int32, int64>> get_inflight_counts() const;
+
+  // Pipelining state of a session to a data center: the number of queries
+  // sent over the session's connection and not answered yet, and the current
+  // adaptive limit on it. Main and file sessions are tracked separately; when
+  // there are several file sessions to a DC, the gauge holds the state of the
+  // most recently reporting one.
+  struct SessionPipelineStat {
+    int32 dc_id;
+    bool is_main;
+    int64 inflight_count;
+    int64 window_size;
+  };
+  void set_session_pipeline(int32 dc_value, bool is_main, int64 inflight_count, int64 window_size);
+  vector<SessionPipelineStat> get_session_pipeline_stats() const;
+
+ private:
+  static constexpr size_t SHARD_COUNT = 16;  // must be a power of two
+  struct Shard {
+    SpinLock lock_;
+    std::unordered_map<int32, TypeStat> by_type_;
+    char pad[64];
+  };
+  std::array<Shard, SHARD_COUNT> shards_;
+
+  // DcId values are -2..1000, see DcId; negative and zero values denote
+  // queries which are not bound to a specific DC yet
+  static constexpr size_t MAX_DC_COUNT = 1000;
+  std::array<std::atomic<int64>, MAX_DC_COUNT + 3> inflight_{};
+
+  // [0] — main sessions, [1] — file sessions; window == 0 means "no session
+  // to this DC has reported yet"
+  std::array<std::array<std::atomic<int64>, MAX_DC_COUNT + 3>, 2> pipeline_inflight_{};
+  std::array<std::array<std::atomic<int64>, MAX_DC_COUNT + 3>, 2> pipeline_window_{};
+
+  Shard &shard();
+  std::atomic<int64> &inflight(int32 dc_value) {
+    return inflight_[static_cast<size_t>(dc_value + 2) % inflight_.size()];
+  }
+};
 }  // namespace td
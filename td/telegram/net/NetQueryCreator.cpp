@@ -6,7 +6,8 @@
 //
 #include "td/telegram/net/NetQueryCreator.h"
 
-#include "td/utils/format.h"
+#include "td/utils/AllocationWatcher.h"
+#include "td/utils/buffer.h"
 #include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
 #include "td/utils/Slice.h"
@@ -16,10 +17,17 @@ namespace td {
 NetQueryCreator::Ptr NetQueryCreator::create(uint64 id, const Storer &storer, DcId dc_id, NetQuery::Type type,
                                              NetQuery::AuthFlag auth_flag, NetQuery::GzipFlag gzip_flag,
                                              double total_timeout_limit) {
-  BufferSlice slice(storer.size());
-  auto real_size = storer.store(slice.as_slice().ubegin());
-  LOG_CHECK(real_size == slice.size()) << real_size << " " << slice.size() << " "
-                                       << format::as_hex_dump<4>(Slice(slice.as_slice()));
+  // the steady state is a buffer chain node, the gzip state and the output slice;
+  // anything noticeably above that is an accidental copy of the query payload
+  TD_ASSERT_MAX_ALLOCATIONS(16);
+
+  // serialize the query in a single pass; most queries fit into the first buffer
+  // node, so the result is extracted without copying
+  ChainBufferWriter writer;
+  storer.store_chain(writer);
+  auto reader = writer.extract_reader();
+  auto size = reader.size();
+  BufferSlice slice = reader.cut_head(size).move_as_buffer_slice();
 
   // TODO: magic constant
   if (slice.size() < (1 << 8)) {
@@ -11,7 +11,7 @@
 #include "td/telegram/UniqueId.h"
 
 #include "td/utils/buffer.h"
-#include "td/utils/ObjectPool.h"
+#include "td/utils/ShardedObjectPool.h"
 #include "td/utils/StorerBase.h"
 
 namespace td {
@@ -51,7 +51,7 @@ class NetQueryCreator {
              NetQuery::GzipFlag gzip_flag = NetQuery::GzipFlag::On, double total_timeout_limit = 60);
 
  private:
-  ObjectPool<NetQuery> object_pool_;
+  ShardedObjectPool<NetQuery> object_pool_;
 };
 
 }  // namespace td
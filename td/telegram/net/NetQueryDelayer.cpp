@@ -15,6 +15,9 @@
 #include "td/utils/misc.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
+
+#include <cmath>
 
 namespace td {
 
@@ -81,42 +84,50 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
   LOG(WARNING) << "Delay: " << query << " " << tag("timeout", timeout) << tag("total_timeout", query->total_timeout)
                << " because of " << error << " from " << query->source_;
   query->debug(PSTRING() << "delay for " << format::as_time(timeout));
-  auto id = container_.create(QuerySlot());
-  auto *query_slot = container_.get(id);
-  query_slot->query_ = std::move(query);
-  query_slot->timeout_.set_event(EventCreator::yield(actor_shared(this, id)));
-  query_slot->timeout_.set_timeout_in(timeout);
-}
-
-void NetQueryDelayer::wakeup() {
-  auto link_token = get_link_token();
-  if (link_token) {
-    on_slot_event(link_token);
+  // the release time is rounded up, so a query is never released before its
+  // timeout has expired
+  auto release_at = static_cast<int32>(std::ceil(Time::now() + timeout));
+  auto &bucket = buckets_[release_at];
+  bucket.push_back(std::move(query));
+  if (bucket.size() == 1 && buckets_.begin()->first == release_at) {
+    set_timeout_at(release_at);
   }
-  loop();
 }
 
-void NetQueryDelayer::on_slot_event(uint64 id) {
-  auto *slot = container_.get(id);
-  if (slot == nullptr) {
-    return;
+void NetQueryDelayer::timeout_expired() {
+  auto now = Time::now();
+  vector<NetQueryPtr> ready;
+  while (!buckets_.empty() && buckets_.begin()->first <= now) {
+    auto &bucket = buckets_.begin()->second;
+    if (ready.empty()) {
+      ready = std::move(bucket);
+    } else {
+      append(ready, std::move(bucket));
+    }
+    buckets_.erase(buckets_.begin());
   }
-  auto query = std::move(slot->query_);
-  if (!query->invoke_after().empty()) {
-    // Fail query after timeout expired if it is a part of an invokeAfter chain.
-    // It is not necessary but helps to avoid server problems, when previous query was lost.
-    query->set_error_resend_invoke_after();
+  if (!buckets_.empty()) {
+    set_timeout_at(buckets_.begin()->first);
+  }
+
+  for (auto &query : ready) {
+    if (!query->invoke_after().empty()) {
+      // Fail query after timeout expired if it is a part of an invokeAfter chain.
+      // It is not necessary but helps to avoid server problems, when previous query was lost.
+      query->set_error_resend_invoke_after();
+    }
+    G()->net_query_dispatcher().dispatch(std::move(query));
   }
-  slot->timeout_.close();
-  container_.erase(id);
-  G()->net_query_dispatcher().dispatch(std::move(query));
 }
 
 void NetQueryDelayer::tear_down() {
-  container_.for_each([](auto id, auto &query_slot) {
-    query_slot.query_->set_error(Status::Error(500, "Request aborted"));
-    G()->net_query_dispatcher().dispatch(std::move(query_slot.query_));
-  });
+  for (auto &bucket : buckets_) {
+    for (auto &query : bucket.second) {
+      query->set_error(Status::Error(500, "Request aborted"));
+      G()->net_query_dispatcher().dispatch(std::move(query));
+    }
+  }
+  buckets_.clear();
 }
 
 }  // namespace td
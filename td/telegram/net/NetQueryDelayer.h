@@ -9,9 +9,10 @@
 #include "td/telegram/net/NetQuery.h"
 
 #include "td/actor/actor.h"
-#include "td/actor/SignalSlot.h"
 
-#include "td/utils/Container.h"
+#include "td/utils/common.h"
+
+#include <map>
 
 namespace td {
 
@@ -22,15 +23,13 @@ class NetQueryDelayer : public Actor {
   void delay(NetQueryPtr query);
 
  private:
-  struct QuerySlot {
-    NetQueryPtr query_;
-    Slot timeout_;
-  };
-  Container<QuerySlot> container_;
+  // delayed queries are grouped into one-second buckets keyed by their
+  // quantized release time; one timer fire releases a whole bucket, so a
+  // flood wait storm arms one heap timer per second instead of one per query
+  std::map<int32, vector<NetQueryPtr>> buckets_;
   ActorShared<> parent_;
-  void wakeup() override;
 
-  void on_slot_event(uint64 id);
+  void timeout_expired() override;
 
   void tear_down() override;
 };
@@ -32,6 +32,8 @@ class PublicRsaKeyWatchdog;
 class SessionMultiProxy;
 
 // Not just dispatcher.
+// The dispatch methods are virtual, so tests and benchmarks may install a fake
+// network by overriding them; see Td::init.
 class NetQueryDispatcher {
  public:
   explicit NetQueryDispatcher(std::function<ActorShared<>()> create_reference);
@@ -40,11 +42,11 @@ class NetQueryDispatcher {
   NetQueryDispatcher &operator=(const NetQueryDispatcher &) = delete;
   NetQueryDispatcher(NetQueryDispatcher &&) = delete;
   NetQueryDispatcher &operator=(NetQueryDispatcher &&) = delete;
-  ~NetQueryDispatcher();
+  virtual ~NetQueryDispatcher();
 
-  void dispatch(NetQueryPtr net_query);
+  virtual void dispatch(NetQueryPtr net_query);
   void dispatch_with_callback(NetQueryPtr net_query, ActorShared<NetQueryCallback> callback);
-  void stop();
+  virtual void stop();
 
   void update_session_count();
   void destroy_auth_keys(Promise<> promise);
@@ -57,6 +59,10 @@ class NetQueryDispatcher {
     return DcId::internal(main_dc_id_.load());
   }
 
+ protected:
+  // sends the finished query to its callback, or to Td if there is none
+  static void complete_net_query(NetQueryPtr net_query);
+
  private:
   std::atomic<bool> stop_flag_{false};
   bool need_destroy_auth_key_{false};
@@ -90,8 +96,6 @@ class NetQueryDispatcher {
   static int32 get_session_count();
   static bool get_use_pfs();
 
-  static void complete_net_query(NetQueryPtr net_query);
-
   void try_fix_migrate(NetQueryPtr &net_query);
 };
 
@@ -12,6 +12,7 @@
 #include "td/telegram/Global.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCounter.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/net/NetType.h"
 #include "td/telegram/StateManager.h"
@@ -148,9 +149,9 @@ Session::Session(unique_ptr<Callback> callback, std::shared_ptr<AuthDataShared>
   long_poll_connection_.connection_id = 1;
 
   if (is_cdn) {
-    auth_data_.set_header(G()->mtproto_header().get_anonymous_header().str());
+    auth_data_.set_header(G()->mtproto_header()->get_anonymous_header());
   } else {
-    auth_data_.set_header(G()->mtproto_header().get_default_header().str());
+    auth_data_.set_header(G()->mtproto_header()->get_default_header());
   }
   last_activity_timestamp_ = Time::now();
 }
@@ -303,11 +304,10 @@ void Session::close() {
 
   flush_pending_invoke_after_queries();
   CHECK(sent_queries_.empty());
-  while (!pending_queries_.empty()) {
-    auto &query = pending_queries_.front();
+  while (has_pending_queries()) {
+    auto query = pop_pending_query();
     query->set_error_resend();
     return_query(std::move(query));
-    pending_queries_.pop_front();
   }
 
   callback_->on_closed();
@@ -367,6 +367,7 @@ Status Session::on_pong() {
           if (status.is_ok()) {
             status = Status::Error(PSLICE() << "No answer for " << query->query << " for "
                                             << format::as_time(Time::now_cached() - query->sent_at_));
+            on_query_timeout();
           }
           query->ack = false;
         } else {
@@ -525,6 +526,29 @@ void Session::on_container_sent(uint64 container_id, vector<uint64> msg_ids) {
   sent_containers_.emplace(container_id, ContainerInfo{size, std::move(msg_ids)});
 }
 
+void Session::on_query_answered(double sent_at) {
+  auto service_time = Time::now_cached() - sent_at;
+  if (query_service_time_ == 0) {
+    query_service_time_ = service_time;
+  } else {
+    query_service_time_ = 0.875 * query_service_time_ + 0.125 * service_time;
+  }
+  if (sent_queries_.size() >= max_inflight_queries_ && max_inflight_queries_ < MAX_INFLIGHT_QUERIES) {
+    // the window was full and a query still was answered in time, so the link
+    // can sustain a deeper pipeline; probe additively
+    max_inflight_queries_++;
+  }
+}
+
+void Session::on_query_timeout() {
+  auto new_window = max(max_inflight_queries_ / 2, MIN_INFLIGHT_QUERIES);
+  if (new_window != max_inflight_queries_) {
+    LOG(INFO) << "Shrink inflight window from " << max_inflight_queries_ << " to " << new_window
+              << tag("service_time", query_service_time_);
+    max_inflight_queries_ = new_window;
+  }
+}
+
 void Session::on_message_ack(uint64 id) {
   on_message_ack_impl(id, 1);
 }
@@ -619,7 +643,18 @@ Status Session::on_message_result_ok(uint64 id, BufferSlice packet, size_t origi
     }
   }
 
+  return on_message_result_ok_impl(id, std::move(packet), original_size, false);
+}
+
+Status Session::on_message_result_gzip_ok(uint64 id, BufferSlice packet, size_t original_size) {
+  // the answer is still gzip-packed and will be inflated by its receiver; answers the
+  // session must inspect itself (auth.authorization) are far below the offload threshold
+  return on_message_result_ok_impl(id, std::move(packet), original_size, true);
+}
+
+Status Session::on_message_result_ok_impl(uint64 id, BufferSlice packet, size_t original_size, bool is_gzipped) {
   if (id == 0) {
+    CHECK(!is_gzipped);  // updates are always inflated by the connection
     if (is_cdn_) {
       return Status::Error("Got update from CDN connection");
     }
@@ -628,7 +663,7 @@ Status Session::on_message_result_ok(uint64 id, BufferSlice packet, size_t origi
   }
   auto it = sent_queries_.find(id);
   if (it == sent_queries_.end()) {
-    LOG(DEBUG) << "DROP result to " << tag("request_id", format::as_hex(id)) << tag("tl", format::as_hex(ID));
+    LOG(DEBUG) << "DROP result to " << tag("request_id", format::as_hex(id));
 
     if (packet.size() > 16 * 1024) {
       dropped_size_ += packet.size();
@@ -645,10 +680,16 @@ Status Session::on_message_result_ok(uint64 id, BufferSlice packet, size_t origi
   Query *query_ptr = &it->second;
   VLOG(net_query) << "Return query result " << query_ptr->query;
 
+  on_query_answered(query_ptr->sent_at_);
   cleanup_container(id, query_ptr);
   mark_as_known(id, query_ptr);
+  query_ptr->query->trace_.received = Time::now_cached();
   query_ptr->query->on_net_read(original_size);
-  query_ptr->query->set_ok(std::move(packet));
+  if (is_gzipped) {
+    query_ptr->query->set_gzipped_ok(std::move(packet));
+  } else {
+    query_ptr->query->set_ok(std::move(packet));
+  }
   query_ptr->query->set_message_id(0);
   query_ptr->query->cancel_slot_.clear_event();
   return_query(std::move(query_ptr->query));
@@ -690,8 +731,10 @@ void Session::on_message_result_error(uint64 id, int error_code, BufferSlice mes
   Query *query_ptr = &it->second;
   VLOG(net_query) << "Return query error " << query_ptr->query;
 
+  on_query_answered(query_ptr->sent_at_);
   cleanup_container(id, query_ptr);
   mark_as_known(id, query_ptr);
+  query_ptr->query->trace_.received = Time::now_cached();
   query_ptr->query->set_error(Status::Error(error_code, message.as_slice()),
                               current_info_->connection->get_name().str());
   query_ptr->query->set_message_id(0);
@@ -795,7 +838,7 @@ Status Session::on_destroy_auth_key() {
 }
 
 bool Session::has_queries() const {
-  return !pending_invoke_after_queries_.empty() || !pending_queries_.empty() || !sent_queries_.empty();
+  return !pending_invoke_after_queries_.empty() || has_pending_queries() || !sent_queries_.empty();
 }
 
 void Session::resend_query(NetQueryPtr query) {
@@ -811,7 +854,25 @@ void Session::add_query(NetQueryPtr &&net_query) {
   net_query->debug("Session: pending");
   LOG_IF(FATAL, UniqueId::extract_type(net_query->id()) == UniqueId::BindKey)
       << "Add BindKey query inpo pending_queries_";
-  pending_queries_.emplace_back(std::move(net_query));
+  if (net_query->is_high_priority()) {
+    pending_high_priority_queries_.emplace_back(std::move(net_query));
+  } else {
+    pending_queries_.emplace_back(std::move(net_query));
+  }
+}
+
+bool Session::has_pending_queries() const {
+  return !pending_queries_.empty() || !pending_high_priority_queries_.empty();
+}
+
+NetQueryPtr Session::pop_pending_query() {
+  bool take_high_priority = !pending_high_priority_queries_.empty() &&
+                            (pending_queries_.empty() || high_priority_burst_ < MAX_HIGH_PRIORITY_BURST);
+  auto &queue = take_high_priority ? pending_high_priority_queries_ : pending_queries_;
+  high_priority_burst_ = take_high_priority ? high_priority_burst_ + 1 : 0;
+  auto query = std::move(queue.front());
+  queue.pop_front();
+  return query;
 }
 
 void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_query, uint64 message_id) {
@@ -838,6 +899,8 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
   }
 
   net_query->debug("Session: send to mtproto::connection");
+  net_query->trace_.sent = Time::now_cached();
+  NetQueryStats::instance().on_sent(net_query->tl_constructor());
   auto r_message_id =
       info->connection->send_query(net_query->query().clone(), net_query->gzip_flag() == NetQuery::GzipFlag::On,
                                    message_id, invoke_after_id, static_cast<bool>(net_query->quick_ack_promise_));
@@ -1010,7 +1073,7 @@ bool Session::need_send_bind_key() const {
   return auth_data_.use_pfs() && !auth_data_.get_bind_flag() && auth_data_.get_tmp_auth_key().id() != tmp_auth_key_id_;
 }
 bool Session::need_send_query() const {
-  return !close_flag_ && (!auth_data_.use_pfs() || auth_data_.get_bind_flag()) && !pending_queries_.empty() &&
+  return !close_flag_ && (!auth_data_.use_pfs() || auth_data_.get_bind_flag()) && has_pending_queries() &&
          !can_destroy_auth_key();
 }
 bool Session::connection_send_bind_key(ConnectionInfo *info) {
@@ -1188,12 +1251,10 @@ void Session::loop() {
     while (main_connection_.state == ConnectionInfo::State::Ready) {
       if (auth_data_.is_ready(Time::now_cached())) {
         if (need_send_query()) {
-          while (!pending_queries_.empty()) {
-            auto &query = pending_queries_.front();
-            connection_send_query(&main_connection_, std::move(query));
-            pending_queries_.pop_front();
+          while (has_pending_queries() && sent_queries_.size() < max_inflight_queries_) {
+            connection_send_query(&main_connection_, pop_pending_query());
+            need_flush = true;
           }
-          need_flush = true;
         }
         if (need_send_bind_key()) {
           // send auth.bindTempAuthKey
@@ -1220,6 +1281,16 @@ void Session::loop() {
 
   relax_timeout_at(&wakeup_at, main_connection_.wakeup_at);
 
+  NetQueryStats::instance().set_session_pipeline(dc_id_, is_main_, static_cast<int64>(sent_queries_.size()),
+                                                 static_cast<int64>(max_inflight_queries_));
+
+  // wake up for proactive temp key renewal even if the session is idle,
+  // so the key is ready before the next query needs it
+  auto tmp_key_renew_at = auth_data_.get_tmp_auth_key_renew_at();
+  if (tmp_key_renew_at > Time::now_cached()) {
+    relax_timeout_at(&wakeup_at, tmp_key_renew_at);
+  }
+
   double wakeup_in = 0;
   if (wakeup_at != 0) {
     wakeup_in = wakeup_at - Time::now_cached();
@@ -124,6 +124,13 @@ class Session final
   std::deque<NetQueryPtr> pending_invoke_after_queries_;
   ListNode sent_queries_list_;
 
+  // high-priority queries are packed into containers ahead of the FIFO lane;
+  // after MAX_HIGH_PRIORITY_BURST consecutive preemptions one FIFO query is
+  // sent anyway, so bulk queries can't be starved
+  static constexpr size_t MAX_HIGH_PRIORITY_BURST = 8;
+  std::deque<NetQueryPtr> pending_high_priority_queries_;
+  size_t high_priority_burst_ = 0;
+
   struct ConnectionInfo {
     int8 connection_id;
     Mode mode;
@@ -151,6 +158,16 @@ class Session final
 
   static constexpr double ACTIVITY_TIMEOUT = 60 * 5;
 
+  // Adaptive limit on the number of queries in flight over the session.
+  // The window is increased additively while a full pipeline keeps being
+  // drained and is halved when a sent query hits the no-answer timeout, so
+  // long-RTT links end up with a deep pipeline, while slow proxies are not
+  // overfilled with queries which will time out anyway.
+  static constexpr size_t MIN_INFLIGHT_QUERIES = 8;
+  static constexpr size_t MAX_INFLIGHT_QUERIES = 1024;
+  size_t max_inflight_queries_ = 64;
+  double query_service_time_ = 0;  // smoothed send-to-answer time of a query
+
   struct ContainerInfo {
     size_t ref_cnt;
     std::vector<uint64> message_ids;
@@ -190,6 +207,8 @@ class Session final
 
   void on_message_ack(uint64 id) override;
   Status on_message_result_ok(uint64 id, BufferSlice packet, size_t original_size) override;
+  Status on_message_result_gzip_ok(uint64 id, BufferSlice packet, size_t original_size) override;
+  Status on_message_result_ok_impl(uint64 id, BufferSlice packet, size_t original_size, bool is_gzipped);
   void on_message_result_error(uint64 id, int error_code, BufferSlice message) override;
   void on_message_failed(uint64 id, Status status) override;
 
@@ -205,6 +224,9 @@ class Session final
   void mark_as_known(uint64 id, Query *query);
   void mark_as_unknown(uint64 id, Query *query);
 
+  void on_query_answered(double sent_at);
+  void on_query_timeout();
+
   void on_message_ack_impl(uint64 id, int32 type);
   void on_message_ack_impl_inner(uint64 id, int32 type, bool in_container);
   void on_message_failed_inner(uint64 id, bool in_container);
@@ -213,6 +235,8 @@ class Session final
   void return_query(NetQueryPtr &&query);
   void add_query(NetQueryPtr &&net_query);
   void resend_query(NetQueryPtr query);
+  bool has_pending_queries() const;
+  NetQueryPtr pop_pending_query();
 
   void connection_open(ConnectionInfo *info, bool ask_info = false);
   void connection_add(unique_ptr<mtproto::RawConnection> raw_connection);
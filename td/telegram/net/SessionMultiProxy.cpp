@@ -12,8 +12,10 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Time.h"
 
 #include <algorithm>
+#include <tuple>
 
 namespace td {
 
@@ -44,12 +46,18 @@ void SessionMultiProxy::send(NetQueryPtr query) {
       pos = query->session_rand() % sessions_.size();
     } else {
       pos = std::min_element(sessions_.begin(), sessions_.end(),
-                             [](const auto &a, const auto &b) { return a.queries_count < b.queries_count; }) -
+                             [](const auto &a, const auto &b) {
+                               // the least loaded session by bytes in flight, so one slow
+                               // session doesn't hold a proportional share of the queries
+                               return std::tie(a.flying_bytes, a.queries_count) <
+                                      std::tie(b.flying_bytes, b.queries_count);
+                             }) -
             sessions_.begin();
     }
   }
   query->debug(PSTRING() << get_name() << ": send to proxy #" << pos);
   sessions_[pos].queries_count++;
+  sessions_[pos].flying_bytes += static_cast<int64>(query->query().size());
   send_closure(sessions_[pos].proxy, &SessionProxy::send, std::move(query));
 }
 
@@ -117,41 +125,109 @@ bool SessionMultiProxy::get_pfs_flag() const {
 void SessionMultiProxy::init() {
   sessions_generation_++;
   sessions_.clear();
+  target_session_count_ = session_count_;
+  window_started_at_ = 0;
+  window_bytes_ = 0;
+  last_throughput_ = 0;
   if (is_main_) {
     LOG(WARNING) << tag("session_count", session_count_);
   }
-  for (int32 i = 0; i < session_count_; i++) {
-    string name = PSTRING() << "Session" << get_name().substr(Slice("SessionMulti").size())
-                            << format::cond(session_count_ > 1, format::concat("#", i));
-
-    SessionInfo info;
-    class Callback : public SessionProxy::Callback {
-     public:
-      Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
-          : parent_(parent), generation_(generation), session_id_(session_id) {
-      }
-      void on_query_finished() override {
-        send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_);
-      }
-
-     private:
-      ActorId<SessionMultiProxy> parent_;
-      uint32 generation_;
-      int32 session_id_;
-    };
-    info.proxy = create_actor<SessionProxy>(name, make_unique<Callback>(actor_id(this), sessions_generation_, i),
-                                            auth_data_, is_main_, allow_media_only_, is_media_, get_pfs_flag(), is_cdn_,
-                                            need_destroy_auth_key_ && i == 0);
-    sessions_.push_back(std::move(info));
+  while (static_cast<int32>(sessions_.size()) < target_session_count_) {
+    create_session();
   }
 }
 
-void SessionMultiProxy::on_query_finished(uint32 generation, int session_id) {
+void SessionMultiProxy::create_session() {
+  auto i = static_cast<int32>(sessions_.size());
+  string name = PSTRING() << "Session" << get_name().substr(Slice("SessionMulti").size())
+                          << format::cond(session_count_ > 1 || i > 0, format::concat("#", i));
+
+  SessionInfo info;
+  class Callback : public SessionProxy::Callback {
+   public:
+    Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
+        : parent_(parent), generation_(generation), session_id_(session_id) {
+    }
+    void on_query_finished(size_t query_size, size_t answer_size) override {
+      send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_, query_size, answer_size);
+    }
+
+   private:
+    ActorId<SessionMultiProxy> parent_;
+    uint32 generation_;
+    int32 session_id_;
+  };
+  info.proxy = create_actor<SessionProxy>(name, make_unique<Callback>(actor_id(this), sessions_generation_, i),
+                                          auth_data_, is_main_, allow_media_only_, is_media_, get_pfs_flag(), is_cdn_,
+                                          need_destroy_auth_key_ && i == 0);
+  sessions_.push_back(std::move(info));
+}
+
+int32 SessionMultiProxy::max_session_count() const {
+  return max(session_count_, MAX_AUTO_SESSION_COUNT);
+}
+
+void SessionMultiProxy::autoscale_sessions() {
+  auto now = Time::now();
+  if (window_started_at_ == 0) {
+    window_started_at_ = now;
+    window_bytes_ = 0;
+    return;
+  }
+  auto passed = now - window_started_at_;
+  if (passed < THROUGHPUT_WINDOW) {
+    return;
+  }
+  auto throughput = static_cast<double>(window_bytes_) / passed;
+
+  int queries_count = 0;
+  for (auto &session : sessions_) {
+    queries_count += session.queries_count;
+  }
+  if (queries_count > target_session_count_) {
+    // saturated; grow while every added session still pays off
+    if (target_session_count_ < max_session_count() && throughput > last_throughput_ * 1.1) {
+      target_session_count_++;
+      create_session();
+      LOG(INFO) << "Grow " << get_name() << " to " << target_session_count_ << " sessions at "
+                << static_cast<int64>(throughput) << "B/s";
+    } else if (target_session_count_ > session_count_ && throughput < last_throughput_ &&
+               sessions_.back().queries_count == 0) {
+      // diminishing returns; drop the extra session once it is drained
+      target_session_count_--;
+      sessions_.pop_back();
+      LOG(INFO) << "Shrink " << get_name() << " to " << target_session_count_ << " sessions";
+    }
+  } else if (target_session_count_ > session_count_ && sessions_.back().queries_count == 0) {
+    target_session_count_--;
+    sessions_.pop_back();
+  }
+
+  last_throughput_ = throughput;
+  window_started_at_ = now;
+  window_bytes_ = 0;
+}
+
+void SessionMultiProxy::on_query_finished(uint32 generation, int session_id, size_t query_size, size_t answer_size) {
   if (generation != sessions_generation_) {
     return;
   }
-  sessions_.at(session_id).queries_count--;
-  CHECK(sessions_.at(session_id).queries_count >= 0);
+  if (static_cast<size_t>(session_id) >= sessions_.size()) {
+    // the session was scaled away after its last query had finished
+    return;
+  }
+  auto &session = sessions_[session_id];
+  session.queries_count--;
+  CHECK(session.queries_count >= 0);
+  session.flying_bytes -= static_cast<int64>(query_size);
+  if (session.flying_bytes < 0) {
+    session.flying_bytes = 0;
+  }
+
+  if (is_media_ && !is_main_) {
+    window_bytes_ += static_cast<int64>(answer_size);
+    autoscale_sessions();
+  }
 }
 
 }  // namespace td
@@ -49,18 +49,29 @@ class SessionMultiProxy : public Actor {
   struct SessionInfo {
     ActorOwn<SessionProxy> proxy;
     int queries_count{0};
+    int64 flying_bytes{0};
   };
   uint32 sessions_generation_{0};
   std::vector<SessionInfo> sessions_;
 
+  static constexpr int32 MAX_AUTO_SESSION_COUNT = 8;
+  static constexpr double THROUGHPUT_WINDOW = 5.0;  // 5s
+  int32 target_session_count_ = 0;
+  double window_started_at_ = 0;
+  int64 window_bytes_ = 0;
+  double last_throughput_ = 0;
+
   void start_up() override;
   void init();
+  void create_session();
+  void autoscale_sessions();
+  int32 max_session_count() const;
 
   bool get_pfs_flag() const;
 
   void update_auth_state();
 
-  void on_query_finished(uint32 generation, int session_id);
+  void on_query_finished(uint32 generation, int session_id, size_t query_size, size_t answer_size);
 };
 
 }  // namespace td
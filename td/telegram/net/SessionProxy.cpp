@@ -59,7 +59,8 @@ class SessionCallback : public Session::Callback {
   void on_result(NetQueryPtr query) override {
     if (UniqueId::extract_type(query->id()) != UniqueId::BindKey &&
         query->id() != 0) {  // not bind key query and not an update
-      send_closure(parent_, &SessionProxy::on_query_finished);
+      send_closure(parent_, &SessionProxy::on_query_finished, query->query().size(),
+                   query->is_ok() ? query->answer_size() : 0);
     }
     G()->net_query_dispatcher().dispatch(std::move(query));
   }
@@ -109,7 +110,7 @@ void SessionProxy::start_up() {
 void SessionProxy::tear_down() {
   for (auto &query : pending_queries_) {
     query->resend();
-    callback_->on_query_finished();
+    callback_->on_query_finished(query->query().size(), 0);
     G()->net_query_dispatcher().dispatch(std::move(query));
   }
   pending_queries_.clear();
@@ -237,8 +238,8 @@ void SessionProxy::on_server_salt_updated(std::vector<mtproto::ServerSalt> serve
   server_salts_ = std::move(server_salts);
 }
 
-void SessionProxy::on_query_finished() {
-  callback_->on_query_finished();
+void SessionProxy::on_query_finished(size_t query_size, size_t answer_size) {
+  callback_->on_query_finished(query_size, answer_size);
 }
 
 }  // namespace td
@@ -26,7 +26,7 @@ class SessionProxy : public Actor {
   class Callback {
    public:
     virtual ~Callback() = default;
-    virtual void on_query_finished() = 0;
+    virtual void on_query_finished(size_t query_size, size_t answer_size) = 0;
   };
 
   SessionProxy(unique_ptr<Callback> callback, std::shared_ptr<AuthDataShared> shared_auth_data, bool is_main,
@@ -62,7 +62,7 @@ class SessionProxy : public Actor {
   void on_tmp_auth_key_updated(mtproto::AuthKey auth_key);
   void on_server_salt_updated(std::vector<mtproto::ServerSalt> server_salts);
 
-  void on_query_finished();
+  void on_query_finished(size_t query_size, size_t answer_size);
 
   void start_up() override;
   void tear_down() override;
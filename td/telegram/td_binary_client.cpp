@@ -0,0 +1,47 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_binary_client.h"
+
+#include "td/telegram/ClientBinary.h"
+
+#include "td/utils/Slice.h"
+
+#include <cstddef>
+
+void *td_binary_client_create() {
+  return new td::ClientBinary();
+}
+
+void td_binary_client_destroy(void *client) {
+  delete static_cast<td::ClientBinary *>(client);
+}
+
+void td_binary_client_send(void *client, const char *request, size_t request_size) {
+  static_cast<td::ClientBinary *>(client)->send(request == nullptr ? td::Slice() : td::Slice(request, request_size));
+}
+
+const char *td_binary_client_receive(void *client, double timeout, size_t *response_size) {
+  auto slice = static_cast<td::ClientBinary *>(client)->receive(timeout);
+  if (response_size != nullptr) {
+    *response_size = slice.size();
+  }
+  if (slice.empty()) {
+    return nullptr;
+  }
+  return slice.data();
+}
+
+const char *td_binary_client_execute(void *client, const char *request, size_t request_size, size_t *response_size) {
+  auto slice = td::ClientBinary::execute(request == nullptr ? td::Slice() : td::Slice(request, request_size));
+  if (response_size != nullptr) {
+    *response_size = slice.size();
+  }
+  if (slice.empty()) {
+    return nullptr;
+  }
+  return slice.data();
+}
@@ -0,0 +1,81 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+/**
+ * \file
+ * C interface for interaction with TDLib via TL-serialized binary objects.
+ *
+ * A binary sibling of td_json_client for consumers which parse responses
+ * straight into native structures and don't need JSON text in between.
+ *
+ * A request is an 8-byte little-endian extra chosen by the client, followed by
+ * a boxed TL-serialized td_api function. A response or an update is an 8-byte
+ * extra (the one from the corresponding request, or 0 for updates), followed
+ * by a boxed TL-serialized td_api object. Message boundaries are carried by
+ * the explicit sizes of this interface, so no additional length prefix is
+ * stored inside a message.
+ *
+ * The threading requirements are the same as for td_json_client: requests can
+ * be sent from any thread, td_binary_client_receive must not be called from
+ * two threads at once, and a received buffer stays valid until the next call
+ * to td_binary_client_receive or td_binary_client_execute in the same thread.
+ */
+
+#include "td/telegram/tdjson_export.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a new instance of TDLib with a binary interface.
+ * \return Pointer to the created instance of TDLib.
+ */
+TDJSON_EXPORT void *td_binary_client_create();
+
+/**
+ * Sends a TL-serialized request to the TDLib client. May be called from any thread.
+ * \param[in] client The client.
+ * \param[in] request TL-serialized request.
+ * \param[in] request_size Size of the request in bytes.
+ */
+TDJSON_EXPORT void td_binary_client_send(void *client, const char *request, size_t request_size);
+
+/**
+ * Receives an incoming update or a request response from the TDLib client.
+ * May be called from any thread, but shouldn't be called simultaneously from two different threads.
+ * \param[in] client The client.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] response_size Size of the response in bytes.
+ * \return TL-serialized incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_binary_client_receive(void *client, double timeout, size_t *response_size);
+
+/**
+ * Synchronously executes a TDLib request. May be called from any thread.
+ * Only a few requests can be executed synchronously.
+ * \param[in] client The client. Currently ignored for all requests, so NULL can be passed.
+ * \param[in] request TL-serialized request.
+ * \param[in] request_size Size of the request in bytes.
+ * \param[out] response_size Size of the response in bytes.
+ * \return TL-serialized request response. May be NULL if the request can't be parsed.
+ */
+TDJSON_EXPORT const char *td_binary_client_execute(void *client, const char *request, size_t request_size,
+                                                   size_t *response_size);
+
+/**
+ * Destroys the TDLib client instance. After this is called the client instance shouldn't be used anymore.
+ * \param[in] client The client.
+ */
+TDJSON_EXPORT void td_binary_client_destroy(void *client);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -10,6 +10,8 @@
 
 #include "td/utils/Slice.h"
 
+#include <cstddef>
+
 extern "C" int td_json_client_square(int x, const char *str) {
   return x * x;
 }
@@ -35,6 +37,19 @@ const char *td_json_client_receive(void *client, double timeout) {
   }
 }
 
+const char *td_json_client_receive_batch(void *client, double timeout, int max_count) {
+  if (max_count <= 0) {
+    return nullptr;
+  }
+  auto slice =
+      static_cast<td::ClientJson *>(client)->receive_batch(timeout, static_cast<std::size_t>(max_count));
+  if (slice.empty()) {
+    return nullptr;
+  } else {
+    return slice.c_str();
+  }
+}
+
 const char *td_json_client_execute(void *client, const char *request) {
   auto slice = td::ClientJson::execute(td::Slice(request == nullptr ? "" : request));
   if (slice.empty()) {
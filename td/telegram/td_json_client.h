@@ -77,6 +77,21 @@ TDJSON_EXPORT void td_json_client_send(void *client, const char *request);
  */
 TDJSON_EXPORT const char *td_json_client_receive(void *client, double timeout);
 
+/**
+ * Receives incoming updates and request responses from the TDLib client as a single JSON array.
+ * Draining all queued responses in one call avoids per-response synchronization overhead.
+ * May be called from any thread, but shouldn't be called simultaneously with itself or
+ * td_json_client_receive from two different threads.
+ * Returned pointer will be deallocated by TDLib during next call to td_json_client_receive_batch
+ * in the same thread, so it can't be used after that.
+ * \param[in] client The client.
+ * \param[in] timeout Maximum number of seconds allowed for this function to wait for the first response.
+ * \param[in] max_count Maximum number of updates and request responses to return in one array.
+ * \return JSON-serialized null-terminated array of incoming updates and request responses.
+ *         May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_json_client_receive_batch(void *client, double timeout, int max_count);
+
 /**
  * Synchronously executes TDLib request. May be called from any thread.
  * Only a few requests can be executed synchronously.
@@ -24,8 +24,99 @@ class TlStorerCalcLength;
 
 class TlStorerUnsafe;
 
+class TlStorerToChainBuffer;
+
 class TlStorerToString;
 
+namespace tl {
+namespace detail {
+
+/**
+ * A thread-local recycler of small memory blocks used for TL-objects.
+ *
+ * Parsing a single server response creates and soon destroys thousands of small nodes, so blocks
+ * are kept in per-size free lists instead of being returned to the heap after every response.
+ * Blocks are obtained from and eventually returned to the global operator new, therefore objects
+ * may be destroyed on a different thread or after the creating thread has finished.
+ */
+class SmallObjectRecycler {
+ public:
+  static void *allocate(std::size_t size) {
+    size = round_up(size);
+    if (size > MAX_BLOCK_SIZE) {
+      return ::operator new(size);
+    }
+    auto &bucket = instance().buckets_[size / BLOCK_ALIGN - 1];
+    if (bucket.head == nullptr) {
+      return ::operator new(size);
+    }
+    auto *block = bucket.head;
+    bucket.head = block->next;
+    bucket.size--;
+    return block;
+  }
+
+  static void deallocate(void *ptr, std::size_t size) {
+    size = round_up(size);
+    if (size > MAX_BLOCK_SIZE) {
+      ::operator delete(ptr);
+      return;
+    }
+    auto &bucket = instance().buckets_[size / BLOCK_ALIGN - 1];
+    if (bucket.size >= MAX_BUCKET_BLOCK_COUNT) {
+      ::operator delete(ptr);
+      return;
+    }
+    auto *block = static_cast<FreeBlock *>(ptr);
+    block->next = bucket.head;
+    bucket.head = block;
+    bucket.size++;
+  }
+
+  SmallObjectRecycler(const SmallObjectRecycler &) = delete;
+  SmallObjectRecycler &operator=(const SmallObjectRecycler &) = delete;
+
+ private:
+  static constexpr std::size_t BLOCK_ALIGN = 16;
+  static constexpr std::size_t MAX_BLOCK_SIZE = 256;
+  static constexpr std::size_t MAX_BUCKET_BLOCK_COUNT = 1024;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct Bucket {
+    FreeBlock *head{nullptr};
+    std::size_t size{0};
+  };
+
+  Bucket buckets_[MAX_BLOCK_SIZE / BLOCK_ALIGN];
+
+  SmallObjectRecycler() = default;
+
+  ~SmallObjectRecycler() {
+    for (auto &bucket : buckets_) {
+      while (bucket.head != nullptr) {
+        auto *block = bucket.head;
+        bucket.head = block->next;
+        ::operator delete(block);
+      }
+    }
+  }
+
+  static std::size_t round_up(std::size_t size) {
+    return (size + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+  }
+
+  static SmallObjectRecycler &instance() {
+    static thread_local SmallObjectRecycler recycler;
+    return recycler;
+  }
+};
+
+}  // namespace detail
+}  // namespace tl
+
 /**
  * This class is a base class for all TDLib TL-objects.
  */
@@ -50,6 +141,13 @@ class TlObject {
   virtual void store(TlStorerCalcLength &s) const {
   }
 
+  /**
+   * Appends the object to the storer serializing object, a chain of buffers.
+   * \param[in] s Storer to which the object will be appended.
+   */
+  virtual void store(TlStorerToChainBuffer &s) const {
+  }
+
   /**
    * Helper function for the to_string method. Appends a string representation of the object to the storer.
    * \param[in] s Storer to which the object string representation will be appended.
@@ -86,6 +184,39 @@ class TlObject {
    * Virtual destructor.
    */
   virtual ~TlObject() = default;
+
+  /**
+   * Allocates memory for the object from a thread-local pool of recycled blocks.
+   * \param[in] size Size of the allocation.
+   */
+  static void *operator new(std::size_t size) {
+    return tl::detail::SmallObjectRecycler::allocate(size);
+  }
+
+  /**
+   * Returns the object memory to the thread-local pool of recycled blocks.
+   * \param[in] ptr Pointer to the memory to be freed.
+   * \param[in] size Size of the allocation.
+   */
+  static void operator delete(void *ptr, std::size_t size) {
+    tl::detail::SmallObjectRecycler::deallocate(ptr, size);
+  }
+
+  /**
+   * Placement new, forwarding to the global one; the allocating operator new above would hide it otherwise.
+   * \param[in] size Size of the allocation.
+   * \param[in] ptr Pointer to the already allocated memory.
+   */
+  static void *operator new(std::size_t size, void *ptr) noexcept {
+    return ptr;
+  }
+
+  /**
+   * Placement delete, called only if a constructor throws during placement new.
+   * \param[in] ptr Pointer to the constructed object.
+   */
+  static void operator delete(void *ptr, void *) noexcept {
+  }
 };
 
 /**
@@ -8,9 +8,12 @@
 
 #include "td/tl/TlObject.h"
 
+#include "td/utils/Slice.h"
 #include "td/utils/UInt.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -41,10 +44,20 @@ class TlFetchBool {
  public:
   template <class ParserT>
   static bool parse(ParserT &parser) {
+    return check_value(parser, parser.fetch_int());
+  }
+
+  template <class ParserT>
+  static bool parse_unsafe(ParserT &parser) {
+    return check_value(parser, parser.fetch_int_unsafe());
+  }
+
+ private:
+  template <class ParserT>
+  static bool check_value(ParserT &parser, std::int32_t c) {
     constexpr std::int32_t ID_BOOL_FALSE = 0xbc799737;
     constexpr std::int32_t ID_BOOL_TRUE = 0x997275b5;
 
-    std::int32_t c = parser.fetch_int();
     if (c == ID_BOOL_TRUE) {
       return true;
     }
@@ -61,6 +74,11 @@ class TlFetchInt {
   static std::int32_t parse(ParserT &parser) {
     return parser.fetch_int();
   }
+
+  template <class ParserT>
+  static std::int32_t parse_unsafe(ParserT &parser) {
+    return parser.fetch_int_unsafe();
+  }
 };
 
 class TlFetchLong {
@@ -69,6 +87,11 @@ class TlFetchLong {
   static std::int64_t parse(ParserT &parser) {
     return parser.fetch_long();
   }
+
+  template <class ParserT>
+  static std::int64_t parse_unsafe(ParserT &parser) {
+    return parser.fetch_long_unsafe();
+  }
 };
 
 class TlFetchDouble {
@@ -77,6 +100,11 @@ class TlFetchDouble {
   static double parse(ParserT &parser) {
     return parser.fetch_double();
   }
+
+  template <class ParserT>
+  static double parse_unsafe(ParserT &parser) {
+    return parser.fetch_double_unsafe();
+  }
 };
 
 class TlFetchInt128 {
@@ -85,6 +113,11 @@ class TlFetchInt128 {
   static UInt128 parse(ParserT &parser) {
     return parser.template fetch_binary<UInt128>();
   }
+
+  template <class ParserT>
+  static UInt128 parse_unsafe(ParserT &parser) {
+    return parser.template fetch_binary_unsafe<UInt128>();
+  }
 };
 
 class TlFetchInt256 {
@@ -93,6 +126,26 @@ class TlFetchInt256 {
   static UInt256 parse(ParserT &parser) {
     return parser.template fetch_binary<UInt256>();
   }
+
+  template <class ParserT>
+  static UInt256 parse_unsafe(ParserT &parser) {
+    return parser.template fetch_binary_unsafe<UInt256>();
+  }
+};
+
+// Checks the length of a run of fixed-size fields once, then reads the first of them;
+// the rest of the run is read with parse_unsafe. The run size may not exceed the
+// parser's zero-filled replacement buffer, which reads are redirected to after an error
+template <std::size_t check_size, class Func>
+class TlFetchChecked {
+  static_assert(check_size <= sizeof(UInt256), "Too long run of fixed-size fields");
+
+ public:
+  template <class ParserT>
+  static auto parse(ParserT &parser) -> decltype(Func::parse_unsafe(parser)) {
+    parser.check_len(check_size);
+    return Func::parse_unsafe(parser);
+  }
 };
 
 template <class T>
@@ -132,6 +185,39 @@ class TlFetchVector {
   }
 };
 
+// a vector of fixed-size scalars has exactly the layout of its serialized form,
+// so it is copied out of the buffer as one block instead of element by element.
+// The whole length is checked before anything is read, because after an error
+// the parser serves reads from a small zero-filled replacement buffer
+template <class T>
+class TlFetchVectorBinary {
+ public:
+  template <class ParserT>
+  static std::vector<T> parse(ParserT &parser) {
+    const std::uint32_t multiplicity = parser.fetch_int();
+    std::vector<T> v;
+    if (parser.get_left_len() / sizeof(T) < multiplicity) {
+      parser.set_error("Wrong vector length");
+    } else {
+      v.resize(multiplicity);
+      auto slice = parser.template fetch_string_raw<Slice>(multiplicity * sizeof(T));
+      if (!slice.empty()) {
+        std::memcpy(v.data(), slice.data(), slice.size());
+      }
+    }
+    return v;
+  }
+};
+
+template <>
+class TlFetchVector<TlFetchInt> : public TlFetchVectorBinary<std::int32_t> {};
+
+template <>
+class TlFetchVector<TlFetchLong> : public TlFetchVectorBinary<std::int64_t> {};
+
+template <>
+class TlFetchVector<TlFetchDouble> : public TlFetchVectorBinary<double> {};
+
 template <class T>
 class TlFetchObject {
  public:
@@ -9,9 +9,11 @@
 #include "td/tl/TlObject.h"
 
 #include "td/utils/misc.h"
+#include "td/utils/Slice.h"
 
 #include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace td {
@@ -83,6 +85,22 @@ class TlStoreVector {
   }
 };
 
+// a vector of fixed-size scalars has exactly the layout of its serialized form,
+// so it is stored as one block instead of element by element
+template <>
+class TlStoreVector<TlStoreBinary> {
+ public:
+  template <class T, class StorerT>
+  static void store(const T &vec, StorerT &storer) {
+    using value_type = typename T::value_type;
+    static_assert(std::is_trivially_copyable<value_type>::value, "wrong vector element type");
+    storer.store_binary(narrow_cast<int32>(vec.size()));
+    if (!vec.empty()) {
+      storer.store_slice(Slice(reinterpret_cast<const char *>(vec.data()), vec.size() * sizeof(value_type)));
+    }
+  }
+};
+
 class TlStoreObject {
  public:
   template <class T, class StorerT>
@@ -21,18 +21,12 @@ void MultiTimeout::set_timeout_at(int64 key, double timeout) {
   auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
   if (heap_node->in_heap()) {
     CHECK(!item.second);
-    bool need_update_timeout = heap_node->is_top();
     timeout_queue_.fix(timeout, heap_node);
-    if (need_update_timeout || heap_node->is_top()) {
-      update_timeout();
-    }
   } else {
     CHECK(item.second);
     timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout();
-    }
   }
+  update_timeout();
 }
 
 void MultiTimeout::add_timeout_at(int64 key, double timeout) {
@@ -44,9 +38,7 @@ void MultiTimeout::add_timeout_at(int64 key, double timeout) {
   } else {
     CHECK(item.second);
     timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout();
-    }
+    update_timeout();
   }
 }
 
@@ -56,46 +48,60 @@ void MultiTimeout::cancel_timeout(int64 key) {
   if (item != items_.end()) {
     auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item));
     CHECK(heap_node->in_heap());
-    bool need_update_timeout = heap_node->is_top();
     timeout_queue_.erase(heap_node);
     items_.erase(item);
 
-    if (need_update_timeout) {
-      update_timeout();
-    }
+    update_timeout();
   }
 }
 
 void MultiTimeout::update_timeout() {
   if (items_.empty()) {
-    LOG(DEBUG) << "Cancel timeout";
     CHECK(timeout_queue_.empty());
-    CHECK(Actor::has_timeout());
-    Actor::cancel_timeout();
+    next_timeout_ = -1;
+    if (Actor::has_timeout()) {
+      LOG(DEBUG) << "Cancel timeout";
+      Actor::cancel_timeout();
+    }
   } else {
-    LOG(DEBUG) << "Set timeout in " << timeout_queue_.top_key() - Time::now_cached();
-    Actor::set_timeout_at(timeout_queue_.top_key());
+    double next_timeout = timeout_queue_.next_timeout();
+    if (next_timeout != next_timeout_ || !Actor::has_timeout()) {
+      LOG(DEBUG) << "Set timeout in " << next_timeout - Time::now_cached();
+      next_timeout_ = next_timeout;
+      Actor::set_timeout_at(next_timeout);
+    }
   }
 }
 
 vector<int64> MultiTimeout::get_expired_keys(double now) {
   vector<int64> expired_keys;
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    int64 key = static_cast<Item *>(timeout_queue_.pop())->key;
+  HeapNode *heap_node;
+  while ((heap_node = timeout_queue_.pop_expired(now)) != nullptr) {
+    int64 key = static_cast<Item *>(heap_node)->key;
     items_.erase(Item(key));
     expired_keys.push_back(key);
   }
   return expired_keys;
 }
 
+void MultiTimeout::deliver_expired_keys(vector<int64> &expired_keys) {
+  if (bulk_callback_ != nullptr) {
+    if (!expired_keys.empty()) {
+      bulk_callback_(data_, expired_keys);
+    }
+    return;
+  }
+  for (auto key : expired_keys) {
+    callback_(data_, key);
+  }
+}
+
 void MultiTimeout::timeout_expired() {
   vector<int64> expired_keys = get_expired_keys(Time::now_cached());
   if (!items_.empty()) {
     update_timeout();
   }
-  for (auto key : expired_keys) {
-    callback_(data_, key);
-  }
+  deliver_expired_keys(expired_keys);
 }
 
 void MultiTimeout::run_all() {
@@ -103,9 +109,7 @@ void MultiTimeout::run_all() {
   if (!expired_keys.empty()) {
     update_timeout();
   }
-  for (auto key : expired_keys) {
-    callback_(data_, key);
-  }
+  deliver_expired_keys(expired_keys);
 }
 
 }  // namespace td
@@ -11,7 +11,9 @@
 #include "td/utils/common.h"
 #include "td/utils/Heap.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 
 #include <set>
 
@@ -68,7 +70,6 @@ class Timeout final : public Actor {
   }
 };
 
-// TODO optimize
 class MultiTimeout final : public Actor {
   struct Item : public HeapNode {
     int64 key;
@@ -84,6 +85,7 @@ class MultiTimeout final : public Actor {
  public:
   using Data = void *;
   using Callback = void (*)(Data, int64);
+  using BulkCallback = void (*)(Data, Span<int64>);
   explicit MultiTimeout(Slice name) {
     register_actor(name, this).release();
   }
@@ -91,6 +93,11 @@ class MultiTimeout final : public Actor {
   void set_callback(Callback callback) {
     callback_ = callback;
   }
+  // if set, all keys expiring in one tick are delivered as a single callback
+  // invocation instead of one invocation per key
+  void set_bulk_callback(BulkCallback bulk_callback) {
+    bulk_callback_ = bulk_callback;
+  }
   void set_callback_data(Data data) {
     data_ = data;
   }
@@ -116,17 +123,21 @@ class MultiTimeout final : public Actor {
  private:
   friend class Scheduler;
 
-  Callback callback_;
+  Callback callback_ = nullptr;
+  BulkCallback bulk_callback_ = nullptr;
   Data data_;
 
-  KHeap<double> timeout_queue_;
+  TimerWheel timeout_queue_;
   std::set<Item> items_;
+  double next_timeout_ = -1;
 
   void update_timeout();
 
   void timeout_expired() override;
 
   vector<int64> get_expired_keys(double now);
+
+  void deliver_expired_keys(vector<int64> &expired_keys);
 };
 
 }  // namespace td
@@ -76,6 +76,8 @@ class Actor : public ObserverBase {
   uint64 get_link_token();
   std::shared_ptr<ActorContext> set_context(std::shared_ptr<ActorContext> context);
   CSlice set_tag(CSlice tag);
+  void set_memory_tag(int32 memory_tag);
+  void set_scheduling_class(ActorInfo::SchedulingClass scheduling_class);
 
   void always_wait_for_mailbox();
 
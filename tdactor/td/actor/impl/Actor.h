@@ -98,6 +98,12 @@ inline CSlice Actor::set_tag(CSlice tag) {
   Scheduler::on_context_updated();
   return old_tag;
 }
+inline void Actor::set_memory_tag(int32 memory_tag) {
+  info_->set_memory_tag(memory_tag);
+}
+inline void Actor::set_scheduling_class(ActorInfo::SchedulingClass scheduling_class) {
+  info_->set_scheduling_class(scheduling_class);
+}
 
 inline void Actor::init(ObjectPool<ActorInfo>::OwnerPtr &&info) {
   info_ = std::move(info);
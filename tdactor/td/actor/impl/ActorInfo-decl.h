@@ -42,6 +42,10 @@ class ActorInfo
  public:
   enum class Deleter : uint8 { Destroy, None };
 
+  // Background actors run only while no interactive actor is ready, subject to
+  // a starvation deadline; see Scheduler::run_mailbox
+  enum class SchedulingClass : uint8 { Interactive, Background };
+
   ActorInfo() = default;
   ~ActorInfo() = default;
 
@@ -99,12 +103,28 @@ class ActorInfo
   bool must_wait(uint32 wait_generation) const;
   void always_wait_for_mailbox();
 
+  // time when the first event was added to the empty mailbox; used only while
+  // run-loop instrumentation is enabled
+  void set_mailbox_ready_at(double ready_at);
+  double get_mailbox_ready_at() const;
+
+  // memory tag the actor's allocations are charged to while its events run;
+  // see td/utils/MemoryTag.h
+  void set_memory_tag(int32 memory_tag);
+  int32 get_memory_tag() const;
+
+  void set_scheduling_class(SchedulingClass scheduling_class);
+  SchedulingClass get_scheduling_class() const;
+
  private:
   Deleter deleter_ = Deleter::None;
   bool is_lite_ = false;
   bool is_running_ = false;
   bool always_wait_for_mailbox_{false};
   uint32 wait_generation_{0};
+  double mailbox_ready_at_{0};
+  int32 memory_tag_{0};
+  SchedulingClass scheduling_class_{SchedulingClass::Interactive};
 
   std::atomic<int32> sched_id_{0};
   Actor *actor_ = nullptr;
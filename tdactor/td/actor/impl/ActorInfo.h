@@ -50,6 +50,8 @@ inline void ActorInfo::init(int32 sched_id, Slice name, ObjectPool<ActorInfo>::O
   is_lite_ = is_lite;
   is_running_ = false;
   wait_generation_ = 0;
+  memory_tag_ = 0;
+  scheduling_class_ = SchedulingClass::Interactive;
 }
 inline bool ActorInfo::is_lite() const {
   return is_lite_;
@@ -63,6 +65,24 @@ inline bool ActorInfo::must_wait(uint32 wait_generation) const {
 inline void ActorInfo::always_wait_for_mailbox() {
   always_wait_for_mailbox_ = true;
 }
+inline void ActorInfo::set_mailbox_ready_at(double ready_at) {
+  mailbox_ready_at_ = ready_at;
+}
+inline double ActorInfo::get_mailbox_ready_at() const {
+  return mailbox_ready_at_;
+}
+inline void ActorInfo::set_memory_tag(int32 memory_tag) {
+  memory_tag_ = memory_tag;
+}
+inline int32 ActorInfo::get_memory_tag() const {
+  return memory_tag_;
+}
+inline void ActorInfo::set_scheduling_class(SchedulingClass scheduling_class) {
+  scheduling_class_ = scheduling_class;
+}
+inline ActorInfo::SchedulingClass ActorInfo::get_scheduling_class() const {
+  return scheduling_class_;
+}
 inline void ActorInfo::on_actor_moved(Actor *actor_new_ptr) {
   actor_ = actor_new_ptr;
 }
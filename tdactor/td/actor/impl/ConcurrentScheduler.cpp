@@ -11,16 +11,23 @@
 #include "td/actor/impl/ActorInfo.h"
 #include "td/actor/impl/Scheduler.h"
 
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/port/thread_local.h"
 
+#include <algorithm>
+#include <map>
 #include <memory>
 
 namespace td {
 
-void ConcurrentScheduler::init(int32 threads_n) {
+constexpr double ConcurrentScheduler::SCALING_PERIOD;
+
+void ConcurrentScheduler::init(int32 threads_n, bool enable_work_stealing) {
 #if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
   threads_n = 0;
+  enable_work_stealing = false;
 #endif
   threads_n++;
   std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound(threads_n);
@@ -56,6 +63,20 @@ void ConcurrentScheduler::init(int32 threads_n) {
     sched->init(i, outbound, static_cast<Scheduler::Callback *>(this));
   }
 
+  if (enable_work_stealing && threads_n > 1) {
+    // the extra scheduler has no thread of its own and must not take part in load balancing
+    load_balancer_ = std::make_shared<SchedulerLoadBalancer>(threads_n);
+    for (int32 i = 0; i < threads_n; i++) {
+      schedulers_[i]->set_load_balancer(load_balancer_);
+    }
+  }
+
+  worker_states_.clear();
+  for (int32 i = 0; i < threads_n; i++) {
+    worker_states_.push_back(make_unique<WorkerState>());
+  }
+  active_workers_ = threads_n - 1;
+
 #if TD_PORT_WINDOWS
   iocp_ = make_unique<detail::Iocp>();
   iocp_->init();
@@ -77,15 +98,16 @@ void ConcurrentScheduler::start() {
   is_finished_.store(false, std::memory_order_relaxed);
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   for (size_t i = 1; i + extra_scheduler_ < schedulers_.size(); i++) {
-    auto &sched = schedulers_[i];
-    threads_.push_back(td::thread([&]() {
+    threads_.push_back(td::thread([this, i]() {
 #if TD_PORT_WINDOWS
       td::detail::Iocp::Guard iocp_guard(iocp_.get());
 #endif
-      while (!is_finished()) {
-        sched->run(Timestamp::in(10));
-      }
+      run_worker(i);
     }));
+    if (i - 1 < worker_cpu_masks_.size() && worker_cpu_masks_[i - 1] != 0) {
+      auto status = threads_.back().set_affinity_mask(worker_cpu_masks_[i - 1]);
+      LOG_IF(WARNING, status.is_error()) << "Failed to pin scheduler thread: " << status;
+    }
   }
 #if TD_PORT_WINDOWS
   iocp_thread_ = td::thread([this] {
@@ -97,6 +119,93 @@ void ConcurrentScheduler::start() {
 
   state_ = State::Run;
 }
+void ConcurrentScheduler::run_worker(size_t sched_id) {
+  auto &sched = schedulers_[sched_id];
+  auto &state = *worker_states_[sched_id];
+  while (!is_finished()) {
+    if (!state.active.load(std::memory_order_relaxed)) {
+      int32 left_n;
+      {
+        auto guard = sched->get_guard();
+        left_n = sched->retire_actors(0);
+      }
+      if (left_n != 0) {
+        // some actors can't leave this scheduler, so its thread must keep running
+        std::lock_guard<std::mutex> lock(scaling_mutex_);
+        state.active.store(true, std::memory_order_relaxed);
+        active_workers_++;
+        continue;
+      }
+      // process events which were already in flight to this scheduler before parking
+      sched->run(Timestamp::now_cached());
+      std::unique_lock<std::mutex> lock(scaling_mutex_);
+      scaling_cv_.wait(lock, [&] { return is_finished() || state.active.load(std::memory_order_relaxed); });
+      lock.unlock();
+      if (!is_finished()) {
+        sched->on_thread_resumed();
+      }
+      continue;
+    }
+    sched->run(Timestamp::in(10));
+  }
+}
+
+void ConcurrentScheduler::set_thread_scaling_limits(int32 min_active_workers, int32 max_active_workers) {
+  CHECK(state_ == State::Start);
+  auto workers_n = active_workers_;
+  min_active_workers_ = clamp(min_active_workers, 1, workers_n);
+  max_active_workers_ = clamp(max_active_workers, min_active_workers_, workers_n);
+}
+
+void ConcurrentScheduler::pin_worker_threads(vector<uint64> cpu_masks) {
+  CHECK(state_ == State::Start);
+  worker_cpu_masks_ = std::move(cpu_masks);
+}
+
+void ConcurrentScheduler::tune_thread_count() {
+  if (max_active_workers_ == 0 || load_balancer_ == nullptr) {
+    return;
+  }
+  auto now = Time::now();
+  if (now < next_scaling_at_) {
+    return;
+  }
+  next_scaling_at_ = now + SCALING_PERIOD;
+  auto backlog = load_balancer_->total_load();
+  std::lock_guard<std::mutex> lock(scaling_mutex_);
+  if (backlog > 2 * active_workers_ && active_workers_ < max_active_workers_) {
+    shrink_streak_ = 0;
+    if (++grow_streak_ >= GROW_STREAK) {
+      grow_streak_ = 0;
+      for (size_t i = 1; i < worker_states_.size(); i++) {
+        if (!worker_states_[i]->active.load(std::memory_order_relaxed)) {
+          worker_states_[i]->active.store(true, std::memory_order_relaxed);
+          active_workers_++;
+          scaling_cv_.notify_all();
+          break;
+        }
+      }
+    }
+  } else if (backlog == 0 && active_workers_ > min_active_workers_) {
+    grow_streak_ = 0;
+    if (++shrink_streak_ >= SHRINK_STREAK) {
+      shrink_streak_ = 0;
+      for (size_t i = worker_states_.size(); i-- > 1;) {
+        if (worker_states_[i]->active.load(std::memory_order_relaxed)) {
+          worker_states_[i]->active.store(false, std::memory_order_relaxed);
+          active_workers_--;
+          // wake the thread up, so that it sees the flag and drains its scheduler
+          schedulers_[i]->wakeup();
+          break;
+        }
+      }
+    }
+  } else {
+    grow_streak_ = 0;
+    shrink_streak_ = 0;
+  }
+}
+
 static TD_THREAD_LOCAL double emscripten_timeout;
 
 bool ConcurrentScheduler::run_main(Timestamp timeout) {
@@ -108,6 +217,7 @@ bool ConcurrentScheduler::run_main(Timestamp timeout) {
     td::detail::Iocp::Guard iocp_guard(iocp_.get());
 #endif
     main_sched->run(timeout);
+    tune_thread_count();
   }
 
   // hack for emscripten
@@ -128,6 +238,38 @@ void ConcurrentScheduler::emscripten_clear_main_timeout() {
   emscripten_timeout = 0;
 }
 
+void ConcurrentScheduler::set_instrumentation_enabled(bool enabled) {
+  for (auto &sched : schedulers_) {
+    sched->set_instrumentation_enabled(enabled);
+  }
+}
+
+std::vector<Scheduler::ActorDispatchStats> ConcurrentScheduler::get_dispatch_stats() {
+  std::map<string, Scheduler::ActorDispatchStats> merged;
+  for (auto &sched : schedulers_) {
+    for (auto &stats : sched->get_dispatch_stats()) {
+      auto &to = merged[stats.actor_name];
+      to.actor_name = stats.actor_name;
+      to.dispatch_count += stats.dispatch_count;
+      to.total_run_time += stats.total_run_time;
+      if (stats.max_run_time > to.max_run_time) {
+        to.max_run_time = stats.max_run_time;
+      }
+      for (size_t i = 0; i < stats.wait_time_histogram.size(); i++) {
+        to.wait_time_histogram[i] += stats.wait_time_histogram[i];
+      }
+    }
+  }
+  std::vector<Scheduler::ActorDispatchStats> result;
+  result.reserve(merged.size());
+  for (auto &it : merged) {
+    result.push_back(std::move(it.second));
+  }
+  std::sort(result.begin(), result.end(),
+            [](const auto &a, const auto &b) { return a.total_run_time > b.total_run_time; });
+  return result;
+}
+
 void ConcurrentScheduler::finish() {
   CHECK(state_ == State::Run);
   if (!is_finished()) {
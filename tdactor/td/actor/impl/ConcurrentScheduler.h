@@ -18,6 +18,7 @@
 #endif
 
 #include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <utility>
@@ -26,7 +27,9 @@ namespace td {
 
 class ConcurrentScheduler : private Scheduler::Callback {
  public:
-  void init(int32 threads_n);
+  // If enable_work_stealing is set, an overloaded scheduler thread will migrate pending ready
+  // actors to idle peer schedulers through the usual actor migration machinery
+  void init(int32 threads_n, bool enable_work_stealing = false);
 
   void finish_async() {
     schedulers_[0]->finish();
@@ -59,6 +62,31 @@ class ConcurrentScheduler : private Scheduler::Callback {
   static double emscripten_get_main_timeout();
   static void emscripten_clear_main_timeout();
 
+  // Enables dynamic scaling of the worker thread set between min_active_workers and
+  // max_active_workers threads, driven by the total ready-actors backlog observed through
+  // the load balancer: a sustained backlog resumes a parked worker, a sustained idle
+  // period drains one worker by migrating its actors to the main scheduler and parks its
+  // thread. Requires init(threads_n, true) and must be called before start()
+  void set_thread_scaling_limits(int32 min_active_workers, int32 max_active_workers);
+
+  // Pins the thread of each worker scheduler to the CPUs of the corresponding affinity
+  // mask; cpu_masks[i] applies to the thread of scheduler i + 1, a zero mask leaves the
+  // thread unpinned. On NUMA machines with a first-touch allocation policy pinning also
+  // keeps the scheduler-local state the worker allocates on its own node, so actors of
+  // one scheduler stop bouncing cache lines across sockets. Must be called after init()
+  // and before start()
+  void pin_worker_threads(vector<uint64> cpu_masks);
+
+  // Enables or disables collection of per-actor dispatch statistics on all schedulers.
+  // While enabled, every flush of an actor mailbox records its run time and the time the
+  // events had been waiting in the mailbox
+  void set_instrumentation_enabled(bool enabled);
+
+  // Returns per-actor dispatch statistics merged over all schedulers, sorted by cumulative
+  // run time in descending order, so CPU-hogging actors of a live process come first.
+  // Actor names are non-empty in TD_DEBUG builds only
+  std::vector<Scheduler::ActorDispatchStats> get_dispatch_stats();
+
   void finish();
 
   template <class ActorT, class... Args>
@@ -88,6 +116,30 @@ class ConcurrentScheduler : private Scheduler::Callback {
   std::atomic<bool> is_finished_{false};
   std::mutex at_finish_mutex_;
   std::vector<std::function<void()>> at_finish_;
+  std::shared_ptr<SchedulerLoadBalancer> load_balancer_;
+
+  // thread scaling decisions are made at most once per SCALING_PERIOD seconds and only
+  // after the same decision has been suggested for a few periods in a row
+  static constexpr double SCALING_PERIOD = 1.0;
+  enum : int32 { GROW_STREAK = 2, SHRINK_STREAK = 5 };
+
+  struct WorkerState {
+    std::atomic<bool> active{true};
+  };
+  std::vector<unique_ptr<WorkerState>> worker_states_;
+  std::mutex scaling_mutex_;
+  std::condition_variable scaling_cv_;
+  int32 min_active_workers_ = 0;
+  int32 max_active_workers_ = 0;  // 0 means thread scaling is disabled
+  int32 active_workers_ = 0;
+  double next_scaling_at_ = 0;
+  int32 grow_streak_ = 0;
+  int32 shrink_streak_ = 0;
+
+  vector<uint64> worker_cpu_masks_;
+
+  void run_worker(size_t sched_id);
+  void tune_thread_count();
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   std::vector<thread> threads_;
 #endif
@@ -102,6 +154,7 @@ class ConcurrentScheduler : private Scheduler::Callback {
     for (auto &it : schedulers_) {
       it->wakeup();
     }
+    scaling_cv_.notify_all();
   }
 
   void register_at_finish(std::function<void()> f) override {
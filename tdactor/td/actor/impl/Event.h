@@ -10,8 +10,10 @@
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/SlabAllocator.h"
 #include "td/utils/StringBuilder.h"
 
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
@@ -49,6 +51,15 @@ class CustomEvent {
   CustomEvent &operator=(CustomEvent &&) = delete;
   virtual ~CustomEvent() = default;
 
+  // events are the hottest allocation site of the actor framework, so closure payloads
+  // are allocated from thread-local slabs instead of the global allocator
+  static void *operator new(std::size_t size) {
+    return SlabAllocator::alloc(size);
+  }
+  static void operator delete(void *ptr) {
+    SlabAllocator::free_ptr(ptr);
+  }
+
   virtual void run(Actor *actor) = 0;
   virtual CustomEvent *clone() const = 0;
   virtual void start_migrate(int32 sched_id) {
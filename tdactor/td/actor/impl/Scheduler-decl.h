@@ -13,6 +13,7 @@
 #include "td/utils/Closure.h"
 #include "td/utils/Heap.h"
 #include "td/utils/List.h"
+#include "td/utils/TimerWheel.h"
 #include "td/utils/MovableValue.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/ObjectPool.h"
@@ -24,11 +25,15 @@
 #include "td/utils/Time.h"
 #include "td/utils/type_traits.h"
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace td {
 
@@ -37,6 +42,27 @@ class ActorInfo;
 enum class ActorSendType { Immediate, Later, LaterWeak };
 
 class Scheduler;
+
+// Shared between all schedulers of one ConcurrentScheduler. Each scheduler publishes the size of
+// its ready-actors backlog, so that an overloaded scheduler can migrate pending actors to an idle
+// peer through the usual ActorInfo migration machinery.
+class SchedulerLoadBalancer {
+ public:
+  explicit SchedulerLoadBalancer(int32 sched_n);
+
+  void update_load(int32 sched_id, int32 load);
+  void add_load(int32 sched_id, int32 diff);
+
+  // returns identifier of an idle scheduler other than self_sched_id, or -1 if there is none
+  int32 choose_idle_scheduler(int32 self_sched_id) const;
+
+  // total ready-actors backlog over all schedulers; parked schedulers are ignored
+  int32 total_load() const;
+
+ private:
+  std::vector<std::atomic<int32>> loads_;
+};
+
 class SchedulerGuard {
  public:
   explicit SchedulerGuard(Scheduler *scheduler, bool lock = true);
@@ -95,6 +121,12 @@ class Scheduler {
   void send_to_scheduler(int32 sched_id, const ActorId<> &actor_id, Event &&event);
   void send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_id, Event &&event);
 
+  // enqueues a run of events for one actor as a single batch, taking the destination queue
+  // lock and waking up the destination scheduler at most once
+  void send_batch_to_other_scheduler(int32 sched_id, const ActorId<> &actor_id, std::vector<Event> &&events);
+
+  void set_load_balancer(std::shared_ptr<SchedulerLoadBalancer> load_balancer);
+
   template <ActorSendType send_type, class EventT>
   void send_lambda(ActorRef actor_ref, EventT &&lambda);
 
@@ -143,6 +175,29 @@ class Scheduler {
 
   Timestamp get_timeout();
 
+  // Per-actor dispatch statistics, collected in flush_mailbox while instrumentation is
+  // enabled. Actors are keyed by name, which is non-empty in TD_DEBUG builds only.
+  struct ActorDispatchStats {
+    string actor_name;
+    uint64 dispatch_count{0};
+    double total_run_time{0};
+    double max_run_time{0};
+    // mailbox wait times bucketed as < 1ms, < 10ms, < 100ms, < 1s and >= 1s
+    std::array<uint64, 5> wait_time_histogram{{0, 0, 0, 0, 0}};
+  };
+
+  // may be called from another thread; disabling drops the collected statistics
+  void set_instrumentation_enabled(bool enabled);
+  std::vector<ActorDispatchStats> get_dispatch_stats();
+
+  // Migrates all actors of this scheduler to dest_sched_id, so that its thread can be
+  // parked. Must be called from the scheduler's own thread under its guard. Running
+  // actors, actors with an active timeout and the service actor are not migrated;
+  // the number of such actors is returned and the caller must not park if it is non-zero
+  int32 retire_actors(int32 dest_sched_id);
+  // must be called after the parked thread of the scheduler is resumed
+  void on_thread_resumed();
+
  private:
   static void set_scheduler(Scheduler *scheduler);
   /*** ServiceActor ***/
@@ -179,6 +234,7 @@ class Scheduler {
   void cancel_actor_timeout(ActorInfo *actor_info);
 
   void register_migrated_actor(ActorInfo *actor_info);
+  void add_ready_actor(ActorInfo *actor_info);
   void add_to_mailbox(ActorInfo *actor_info, Event &&event);
   void clear_mailbox(ActorInfo *actor_info);
 
@@ -190,8 +246,11 @@ class Scheduler {
 
   void inc_wait_generation();
 
+  void record_dispatch(const string &actor_name, double run_time, double wait_time);
+
   Timestamp run_timeout();
   void run_mailbox();
+  void offload_ready_actors(ListNode &actors_list, int32 ready_n);
   Timestamp run_events();
   void run_poll(Timestamp timeout);
 
@@ -208,7 +267,9 @@ class Scheduler {
   int32 actor_count_ = 0;
   ListNode pending_actors_list_;
   ListNode ready_actors_list_;
-  KHeap<double> timeout_queue_;
+  ListNode background_actors_list_;
+  double background_ready_since_ = 0;
+  TimerWheel timeout_queue_;
 
   std::map<ActorInfo *, std::vector<Event>> pending_events_;
 
@@ -225,6 +286,12 @@ class Scheduler {
   std::shared_ptr<MpscPollableQueue<EventFull>> inbound_queue_;
   std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound_queues_;
 
+  std::shared_ptr<SchedulerLoadBalancer> load_balancer_;
+
+  std::atomic<bool> instrumentation_enabled_{false};
+  std::mutex dispatch_stats_mutex_;
+  std::map<string, ActorDispatchStats> dispatch_stats_;
+
   std::shared_ptr<ActorContext> save_context_;
 
   struct EventContext {
@@ -22,6 +22,7 @@
 #include "td/utils/Time.h"
 
 #include <functional>
+#include <limits>
 #include <utility>
 
 namespace td {
@@ -29,6 +30,41 @@ namespace td {
 TD_THREAD_LOCAL Scheduler *Scheduler::scheduler_;   // static zero-initialized
 TD_THREAD_LOCAL ActorContext *Scheduler::context_;  // static zero-initialized
 
+/*** SchedulerLoadBalancer ***/
+SchedulerLoadBalancer::SchedulerLoadBalancer(int32 sched_n) : loads_(sched_n) {
+  for (auto &load : loads_) {
+    load.store(0, std::memory_order_relaxed);
+  }
+}
+
+void SchedulerLoadBalancer::update_load(int32 sched_id, int32 load) {
+  loads_[sched_id].store(load, std::memory_order_relaxed);
+}
+
+void SchedulerLoadBalancer::add_load(int32 sched_id, int32 diff) {
+  loads_[sched_id].fetch_add(diff, std::memory_order_relaxed);
+}
+
+int32 SchedulerLoadBalancer::total_load() const {
+  int32 res = 0;
+  for (auto &load : loads_) {
+    auto value = load.load(std::memory_order_relaxed);
+    if (value != std::numeric_limits<int32>::max()) {
+      res += value;
+    }
+  }
+  return res;
+}
+
+int32 SchedulerLoadBalancer::choose_idle_scheduler(int32 self_sched_id) const {
+  for (int32 sched_id = 0; sched_id < static_cast<int32>(loads_.size()); sched_id++) {
+    if (sched_id != self_sched_id && loads_[sched_id].load(std::memory_order_relaxed) == 0) {
+      return sched_id;
+    }
+  }
+  return -1;
+}
+
 Scheduler::~Scheduler() {
   clear();
 }
@@ -71,6 +107,7 @@ void Scheduler::ServiceActor::loop() {
   if (ready_n == 0) {
     return;
   }
+  EventFull pending_event;
   while (ready_n-- > 0) {
     EventFull event = queue->reader_get_unsafe();
     if (event.actor_id().empty()) {
@@ -79,12 +116,22 @@ void Scheduler::ServiceActor::loop() {
       } else {
         Scheduler::instance()->register_migrated_actor(static_cast<ActorInfo *>(event.data().data.ptr));
       }
-    } else {
-      VLOG(actor) << "Receive " << event.data();
-      finish_migrate(event.data());
-      event.try_emit();
+      continue;
+    }
+    VLOG(actor) << "Receive " << event.data();
+    finish_migrate(event.data());
+    if (!pending_event.empty()) {
+      if (pending_event.actor_id().get_actor_info() == event.actor_id().get_actor_info()) {
+        // a run of events for one actor: add them to its mailbox and execute all of them
+        // in a single actor activation
+        pending_event.try_emit_later();
+      } else {
+        pending_event.try_emit();
+      }
     }
+    pending_event = std::move(event);
   }
+  pending_event.try_emit();
   queue->reader_flush();
   yield();
 }
@@ -135,7 +182,8 @@ SchedulerGuard::~SchedulerGuard() {
 }
 
 /*** EventGuard ***/
-EventGuard::EventGuard(Scheduler *scheduler, ActorInfo *actor_info) : scheduler_(scheduler) {
+EventGuard::EventGuard(Scheduler *scheduler, ActorInfo *actor_info)
+    : scheduler_(scheduler), memory_tag_scope_(actor_info->get_memory_tag()) {
   actor_info->start_run();
   event_context_.actor_info = actor_info;
   event_context_ptr_ = &event_context_;
@@ -154,7 +202,7 @@ EventGuard::~EventGuard() {
   if (info->mailbox_.empty()) {
     scheduler_->pending_actors_list_.put(node);
   } else {
-    scheduler_->ready_actors_list_.put(node);
+    scheduler_->add_ready_actor(info);
   }
   info->finish_run();
   swap_context(info);
@@ -223,6 +271,10 @@ void Scheduler::clear() {
     return;
   }
   close_flag_ = true;
+  if (load_balancer_ != nullptr) {
+    // the scheduler is being closed and must not receive offloaded actors any more
+    load_balancer_->update_load(sched_id_, std::numeric_limits<int32>::max());
+  }
   auto guard = get_guard();
 
   // Stop all actors
@@ -237,8 +289,13 @@ void Scheduler::clear() {
     auto actor_info = ActorInfo::from_list_node(ready_actors_list_.get());
     do_stop_actor(actor_info);
   }
+  while (!background_actors_list_.empty()) {
+    auto actor_info = ActorInfo::from_list_node(background_actors_list_.get());
+    do_stop_actor(actor_info);
+  }
   LOG_IF(FATAL, !ready_actors_list_.empty()) << ActorInfo::from_list_node(ready_actors_list_.next)->get_name();
   CHECK(ready_actors_list_.empty());
+  CHECK(background_actors_list_.empty());
   poll_.clear();
 
   if (callback_) {
@@ -324,7 +381,7 @@ void Scheduler::register_migrated_actor(ActorInfo *actor_info) {
   if (actor_info->mailbox_.empty()) {
     pending_actors_list_.put(actor_info->get_list_node());
   } else {
-    ready_actors_list_.put(actor_info->get_list_node());
+    add_ready_actor(actor_info);
   }
   actor_info->get_actor_unsafe()->on_finish_migrate();
 }
@@ -343,11 +400,119 @@ void Scheduler::send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_i
   }
 }
 
+void Scheduler::send_batch_to_other_scheduler(int32 sched_id, const ActorId<> &actor_id, std::vector<Event> &&events) {
+  if (sched_id >= sched_count()) {
+    return;
+  }
+  auto actor_info = actor_id.get_actor_info();
+  if (actor_info) {
+    VLOG(actor) << "Send batch of " << events.size() << " events to " << *actor_info << " on scheduler " << sched_id;
+  }
+  std::vector<EventFull> full_events;
+  full_events.reserve(events.size());
+  for (auto &event : events) {
+    start_migrate(event, sched_id);
+    full_events.push_back(EventCreator::event_unsafe(actor_id, std::move(event)));
+  }
+  outbound_queues_[sched_id]->writer_put_batch(std::move(full_events));
+  outbound_queues_[sched_id]->writer_flush();
+}
+
+void Scheduler::set_load_balancer(std::shared_ptr<SchedulerLoadBalancer> load_balancer) {
+  load_balancer_ = std::move(load_balancer);
+}
+
+int32 Scheduler::retire_actors(int32 dest_sched_id) {
+  CHECK(has_guard_);
+  CHECK(dest_sched_id != sched_id_);
+  int32 left_n = 0;
+  auto process = [&](ListNode &list) {
+    ListNode *it = list.next;
+    while (it != &list) {
+      auto actor_info = ActorInfo::from_list_node(it);
+      it = it->next;
+      if (actor_info->get_actor_unsafe() == &service_actor_) {
+        continue;
+      }
+      if (actor_info->is_running() || actor_info->is_migrating() || has_actor_timeout(actor_info)) {
+        left_n++;
+        continue;
+      }
+      VLOG(actor) << "Retire " << *actor_info << " to scheduler " << dest_sched_id;
+      do_migrate_actor(actor_info, dest_sched_id);
+    }
+  };
+  process(pending_actors_list_);
+  process(ready_actors_list_);
+  process(background_actors_list_);
+  if (left_n == 0 && load_balancer_ != nullptr) {
+    // a parked scheduler must not receive offloaded actors
+    load_balancer_->update_load(sched_id_, std::numeric_limits<int32>::max());
+  }
+  return left_n;
+}
+
+void Scheduler::on_thread_resumed() {
+  if (load_balancer_ != nullptr) {
+    load_balancer_->update_load(sched_id_, 0);
+  }
+}
+
+void Scheduler::set_instrumentation_enabled(bool enabled) {
+  instrumentation_enabled_.store(enabled, std::memory_order_relaxed);
+  if (!enabled) {
+    std::lock_guard<std::mutex> lock(dispatch_stats_mutex_);
+    dispatch_stats_.clear();
+  }
+}
+
+std::vector<Scheduler::ActorDispatchStats> Scheduler::get_dispatch_stats() {
+  std::vector<ActorDispatchStats> result;
+  std::lock_guard<std::mutex> lock(dispatch_stats_mutex_);
+  result.reserve(dispatch_stats_.size());
+  for (auto &it : dispatch_stats_) {
+    result.push_back(it.second);
+  }
+  return result;
+}
+
+void Scheduler::record_dispatch(const string &actor_name, double run_time, double wait_time) {
+  std::lock_guard<std::mutex> lock(dispatch_stats_mutex_);
+  auto &stats = dispatch_stats_[actor_name];
+  if (stats.dispatch_count == 0) {
+    stats.actor_name = actor_name;
+  }
+  stats.dispatch_count++;
+  stats.total_run_time += run_time;
+  if (run_time > stats.max_run_time) {
+    stats.max_run_time = run_time;
+  }
+  static constexpr double BUCKET_BOUNDS[] = {0.001, 0.01, 0.1, 1.0};
+  size_t bucket = 0;
+  while (bucket < 4 && wait_time >= BUCKET_BOUNDS[bucket]) {
+    bucket++;
+  }
+  stats.wait_time_histogram[bucket]++;
+}
+
+void Scheduler::add_ready_actor(ActorInfo *actor_info) {
+  if (actor_info->get_scheduling_class() == ActorInfo::SchedulingClass::Background) {
+    if (background_actors_list_.empty()) {
+      background_ready_since_ = Time::now_cached();
+    }
+    background_actors_list_.put(actor_info->get_list_node());
+  } else {
+    ready_actors_list_.put(actor_info->get_list_node());
+  }
+}
+
 void Scheduler::add_to_mailbox(ActorInfo *actor_info, Event &&event) {
   if (!actor_info->is_running()) {
-    auto node = actor_info->get_list_node();
-    node->remove();
-    ready_actors_list_.put(node);
+    actor_info->get_list_node()->remove();
+    add_ready_actor(actor_info);
+  }
+  if (unlikely(instrumentation_enabled_.load(std::memory_order_relaxed)) && actor_info->mailbox_.empty()) {
+    actor_info->set_mailbox_ready_at(Time::now_cached());
   }
   VLOG(actor) << "Add to mailbox: " << *actor_info << " " << event;
   actor_info->mailbox_.push_back(std::move(event));
@@ -423,7 +588,7 @@ void Scheduler::set_actor_timeout_in(ActorInfo *actor_info, double timeout) {
   if (timeout < 0) {
     timeout = 0;
   }
-  double expires_at = Time::now() + timeout;
+  double expires_at = Time::now_cached() + timeout;
   set_actor_timeout_at(actor_info, expires_at);
 }
 
@@ -449,9 +614,52 @@ void Scheduler::run_poll(Timestamp timeout) {
 #endif
 }
 
+void Scheduler::offload_ready_actors(ListNode &actors_list, int32 ready_n) {
+  // migrate at most half of the pending ready actors away, keeping the rest for this scheduler
+  auto to_offload = ready_n / 2;
+  ListNode *it = actors_list.next;
+  while (to_offload-- > 0 && it != &actors_list) {
+    auto dest_sched_id = load_balancer_->choose_idle_scheduler(sched_id_);
+    if (dest_sched_id < 0) {
+      return;
+    }
+    auto actor_info = ActorInfo::from_list_node(it);
+    it = it->next;
+    if (actor_info->is_running() || actor_info->is_migrating() || has_actor_timeout(actor_info) ||
+        actor_info->get_actor_unsafe() == &service_actor_) {
+      continue;
+    }
+    VLOG(actor) << "Offload " << *actor_info << " to idle scheduler " << dest_sched_id;
+    load_balancer_->add_load(dest_sched_id, 1);
+    do_migrate_actor(actor_info, dest_sched_id);
+  }
+}
+
 void Scheduler::run_mailbox() {
   VLOG(actor) << "Run mailbox : begin";
+  if (!background_actors_list_.empty()) {
+    // background actors run only while no interactive actor is ready, but are
+    // promoted after a deadline so that a busy period can't starve them forever
+    constexpr double BACKGROUND_STARVATION_DELAY = 0.1;
+    if (ready_actors_list_.empty() ||
+        Time::now_cached() >= background_ready_since_ + BACKGROUND_STARVATION_DELAY) {
+      while (!background_actors_list_.empty()) {
+        ready_actors_list_.put(background_actors_list_.get());
+      }
+    }
+  }
   ListNode actors_list = std::move(ready_actors_list_);
+  if (load_balancer_ != nullptr) {
+    constexpr int32 MIN_OFFLOAD_QUEUE_SIZE = 8;
+    int32 ready_n = 0;
+    for (ListNode *it = actors_list.next; it != &actors_list; it = it->next) {
+      ready_n++;
+    }
+    load_balancer_->update_load(sched_id_, ready_n);
+    if (ready_n >= MIN_OFFLOAD_QUEUE_SIZE) {
+      offload_ready_actors(actors_list, ready_n);
+    }
+  }
   while (!actors_list.empty()) {
     ListNode *node = actors_list.get();
     CHECK(node);
@@ -459,6 +667,9 @@ void Scheduler::run_mailbox() {
     inc_wait_generation();
     flush_mailbox(actor_info, static_cast<void (*)(ActorInfo *)>(nullptr), static_cast<Event (*)()>(nullptr));
   }
+  if (load_balancer_ != nullptr) {
+    load_balancer_->update_load(sched_id_, 0);
+  }
   VLOG(actor) << "Run mailbox : finish " << actor_count_;
 
   //Useful for debug, but O(ActorsCount) check
@@ -482,8 +693,8 @@ void Scheduler::run_mailbox() {
 Timestamp Scheduler::run_timeout() {
   double now = Time::now();
   //TODO: use Timestamp().is_in_past()
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    HeapNode *node = timeout_queue_.pop();
+  HeapNode *node;
+  while ((node = timeout_queue_.pop_expired(now)) != nullptr) {
     ActorInfo *actor_info = ActorInfo::from_heap_node(node);
     inc_wait_generation();
     send<ActorSendType::Immediate>(actor_info->actor_id(), Event::timeout());
@@ -509,7 +720,7 @@ Timestamp Scheduler::get_timeout() {
   if (timeout_queue_.empty()) {
     return Timestamp::in(10000);
   }
-  return Timestamp::at(timeout_queue_.top_key());
+  return Timestamp::at(timeout_queue_.next_timeout());
 }
 
 }  // namespace td
@@ -13,6 +13,7 @@
 #include "td/utils/format.h"
 #include "td/utils/Heap.h"
 #include "td/utils/logging.h"
+#include "td/utils/MemoryTag.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/port/detail/PollableFd.h"
@@ -51,6 +52,7 @@ class EventGuard {
   Scheduler::EventContext event_context_;
   Scheduler::EventContext *event_context_ptr_;
   Scheduler *scheduler_;
+  MemoryTagScope memory_tag_scope_;
   ActorContext *save_context_;
   const char *save_log_tag2_;
 
@@ -161,19 +163,36 @@ void Scheduler::flush_mailbox(ActorInfo *actor_info, const RunFuncT &run_func, c
   auto &mailbox = actor_info->mailbox_;
   size_t mailbox_size = mailbox.size();
   CHECK(mailbox_size != 0);
-  EventGuard guard(this, actor_info);
-  size_t i = 0;
-  for (; i < mailbox_size && guard.can_run(); i++) {
-    do_event(actor_info, std::move(mailbox[i]));
+  bool instrumented = instrumentation_enabled_.load(std::memory_order_relaxed);
+  double start_time = 0;
+  double wait_time = 0;
+  string actor_name;
+  if (unlikely(instrumented)) {
+    start_time = Time::now();
+    if (actor_info->get_mailbox_ready_at() > 0) {
+      wait_time = start_time - actor_info->get_mailbox_ready_at();
+    }
+    // the actor may be stopped and destroyed by one of the events
+    actor_name = actor_info->get_name().str();
   }
-  if (run_func) {
-    if (guard.can_run()) {
-      (*run_func)(actor_info);
-    } else {
-      mailbox.insert(begin(mailbox) + i, (*event_func)());
+  {
+    EventGuard guard(this, actor_info);
+    size_t i = 0;
+    for (; i < mailbox_size && guard.can_run(); i++) {
+      do_event(actor_info, std::move(mailbox[i]));
     }
+    if (run_func) {
+      if (guard.can_run()) {
+        (*run_func)(actor_info);
+      } else {
+        mailbox.insert(begin(mailbox) + i, (*event_func)());
+      }
+    }
+    mailbox.erase(begin(mailbox), begin(mailbox) + i);
+  }
+  if (unlikely(instrumented)) {
+    record_dispatch(actor_name, Time::now() - start_time, wait_time);
   }
-  mailbox.erase(begin(mailbox), begin(mailbox) + i);
 }
 
 inline void Scheduler::send_to_scheduler(int32 sched_id, const ActorId<> &actor_id, Event &&event) {
@@ -346,12 +365,15 @@ inline void Scheduler::wakeup() {
 
 inline Timestamp Scheduler::run_events() {
   Timestamp res;
+  // refresh the coarse clock, which may be stale after a long poll; event handlers
+  // can use Time::now_cached() instead of hitting the monotonic clock per call
+  Time::now();
   VLOG(actor) << "Run events " << sched_id_ << " " << tag("pending", pending_events_.size())
               << tag("actors", actor_count_);
   do {
     run_mailbox();
     res = run_timeout();
-  } while (!ready_actors_list_.empty());
+  } while (!ready_actors_list_.empty() || !background_actors_list_.empty());
   return res;
 }
 
@@ -459,6 +459,67 @@ TEST(Actors, promise) {
   ASSERT_EQ(1, value);
 }
 
+class DispatchStatsWorker : public Actor {
+ public:
+  void start_up() override {
+    for (int i = 0; i < 10; i++) {
+      send_closure_later(actor_id(this), &DispatchStatsWorker::step);
+    }
+  }
+  void step() {
+    if (++count_ == 10) {
+      Scheduler::instance()->finish();
+    }
+  }
+
+ private:
+  int count_ = 0;
+};
+
+TEST(Actors, dispatch_stats) {
+  ConcurrentScheduler scheduler;
+  scheduler.init(0);
+  scheduler.set_instrumentation_enabled(true);
+  scheduler.create_actor_unsafe<DispatchStatsWorker>(0, "DispatchStatsWorker").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  auto stats = scheduler.get_dispatch_stats();
+  uint64 dispatch_count = 0;
+  for (auto &stat : stats) {
+    dispatch_count += stat.dispatch_count;
+  }
+  CHECK(dispatch_count > 0);
+  scheduler.finish();
+}
+
+TEST(Actors, chain_promise) {
+  int value = -1;
+  auto make_chain = [&] {
+    return PromiseCreator::chain(
+        PromiseCreator::lambda([&](Result<int> x) { value = x.is_ok() ? x.ok() : -100; }),
+        [](int x) { return x + 1; },
+        [](int x) -> Result<int> {
+          if (x == 0) {
+            return Status::Error("Zero");
+          }
+          return x * 10;
+        });
+  };
+  auto p1 = make_chain();
+  p1.set_value(4);
+  ASSERT_EQ(50, value);
+
+  auto p2 = make_chain();
+  p2.set_value(-1);  // second step fails
+  ASSERT_EQ(-100, value);
+
+  value = -1;
+  auto p3 = make_chain();
+  p3.set_error(Status::Error("Test error"));
+  ASSERT_EQ(-100, value);
+}
+
 class LaterSlave : public Actor {
  public:
   explicit LaterSlave(ActorShared<> parent) : parent_(std::move(parent)) {
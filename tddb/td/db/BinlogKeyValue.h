@@ -10,13 +10,17 @@
 
 #include "td/db/binlog/Binlog.h"
 #include "td/db/binlog/BinlogEvent.h"
+#include "td/db/detail/KeyValueSnapshot.h"
 #include "td/db/KeyValueSyncInterface.h"
 
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/CompactString.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/RwMutex.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 #include "td/utils/StorerBase.h"
@@ -76,14 +80,53 @@ class BinlogKeyValue : public KeyValueSyncInterface {
       magic_ = override_magic;
     }
 
+    // a snapshot of an encrypted database would store its content as plain text
+    bool use_snapshot = db_key.is_empty();
+    auto snapshot_path = detail::KeyValueSnapshot::get_path(name);
+    std::vector<detail::KeyValueSnapshot::Entry> snapshot_entries;
+    std::unordered_map<uint64, size_t> snapshot_entry_by_id;
+    if (use_snapshot) {
+      auto r_entries = detail::KeyValueSnapshot::read(snapshot_path);
+      if (r_entries.is_ok()) {
+        snapshot_entries = r_entries.move_as_ok();
+        for (size_t i = 0; i < snapshot_entries.size(); i++) {
+          snapshot_entry_by_id.emplace(snapshot_entries[i].event_id, i);
+        }
+      }
+    } else {
+      detail::KeyValueSnapshot::destroy(snapshot_path);
+    }
+
+    std::unordered_map<uint64, std::pair<uint32, uint32>> event_info;
+    size_t replayed_events = 0;
+    size_t accepted_entries = 0;
     binlog_ = std::make_shared<BinlogT>();
-    TRY_STATUS(binlog_->init(name,
-                             [&](const BinlogEvent &binlog_event) {
-                               Event event;
-                               event.parse(TlParser(binlog_event.data_));
-                               map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
-                             },
-                             std::move(db_key), DbKey::empty(), scheduler_id));
+    TRY_STATUS(binlog_->init(
+        name,
+        [&](const BinlogEvent &binlog_event) {
+          if (use_snapshot) {
+            event_info.emplace(binlog_event.id_, std::make_pair(binlog_event.crc32_, binlog_event.size_));
+            auto it = snapshot_entry_by_id.find(binlog_event.id_);
+            if (it != snapshot_entry_by_id.end()) {
+              auto &entry = snapshot_entries[it->second];
+              if (entry.event_crc32 == binlog_event.crc32_ && entry.event_size == binlog_event.size_) {
+                // the event is unchanged since the snapshot was taken, so its parsing can be skipped
+                map_.emplace(CompactString(entry.key), std::make_pair(std::move(entry.value), binlog_event.id_));
+                accepted_entries++;
+                return;
+              }
+            }
+            replayed_events++;
+          }
+          Event event;
+          event.parse(TlParser(binlog_event.data_));
+          map_.emplace(CompactString(event.key), std::make_pair(event.value.str(), binlog_event.id_));
+        },
+        std::move(db_key), DbKey::empty(), scheduler_id));
+
+    if (use_snapshot && replayed_events + (snapshot_entries.size() - accepted_entries) >= SNAPSHOT_REWRITE_MIN_CHANGES) {
+      write_snapshot(std::move(snapshot_path), event_info);
+    }
     return Status::OK();
   }
 
@@ -102,7 +145,7 @@ class BinlogKeyValue : public KeyValueSyncInterface {
   void external_init_handle(const BinlogEvent &binlog_event) {
     Event event;
     event.parse(TlParser(binlog_event.data_));
-    map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
+    map_.emplace(CompactString(event.key), std::make_pair(event.value.str(), binlog_event.id_));
   }
 
   void external_init_finish(std::shared_ptr<BinlogT> binlog) {
@@ -116,7 +159,7 @@ class BinlogKeyValue : public KeyValueSyncInterface {
   SeqNo set(string key, string value) override {
     auto lock = rw_mutex_.lock_write().move_as_ok();
     uint64 old_id = 0;
-    auto it_ok = map_.insert({key, {value, 0}});
+    auto it_ok = map_.emplace(CompactString(key), {value, 0});
     if (!it_ok.second) {
       if (it_ok.first->second.first == value) {
         return 0;
@@ -189,7 +232,7 @@ class BinlogKeyValue : public KeyValueSyncInterface {
     std::unordered_map<string, string> res;
     for (const auto &kv : map_) {
       if (begins_with(kv.first, prefix)) {
-        res[kv.first] = kv.second.first;
+        res[kv.first.str()] = kv.second.first;
       }
     }
     return res;
@@ -199,7 +242,7 @@ class BinlogKeyValue : public KeyValueSyncInterface {
     auto lock = rw_mutex_.lock_write().move_as_ok();
     std::unordered_map<string, string> res;
     for (const auto &kv : map_) {
-      res[kv.first] = kv.second.first;
+      res[kv.first.str()] = kv.second.first;
     }
     return res;
   }
@@ -207,14 +250,13 @@ class BinlogKeyValue : public KeyValueSyncInterface {
   void erase_by_prefix(Slice prefix) override {
     auto lock = rw_mutex_.lock_write().move_as_ok();
     std::vector<uint64> ids;
-    for (auto it = map_.begin(); it != map_.end();) {
-      if (begins_with(it->first, prefix)) {
-        ids.push_back(it->second.second);
-        it = map_.erase(it);
-      } else {
-        ++it;
+    map_.remove_if([&](const auto &kv) {
+      if (begins_with(kv.first, prefix)) {
+        ids.push_back(kv.second.second);
+        return true;
       }
-    }
+      return false;
+    });
     auto seq_no = binlog_->next_id(narrow_cast<int32>(ids.size()));
     lock.reset();
     for (auto id : ids) {
@@ -227,14 +269,50 @@ class BinlogKeyValue : public KeyValueSyncInterface {
   friend class BinlogKeyValue;
 
   static Status destroy(Slice name) {
+    detail::KeyValueSnapshot::destroy(detail::KeyValueSnapshot::get_path(name));
     return Binlog::destroy(name);
   }
 
  private:
-  std::unordered_map<string, std::pair<string, uint64>> map_;
+  // short keys are stored inline in CompactString; lookups hash the Slice directly
+  FlatHashMap<CompactString, std::pair<string, uint64>, SliceHash, std::equal_to<Slice>> map_;
   std::shared_ptr<BinlogT> binlog_;
   RwMutex rw_mutex_;
   int32 magic_ = magic;
+
+  // the snapshot is rewritten on startup after this many events had to be replayed
+  static constexpr size_t SNAPSHOT_REWRITE_MIN_CHANGES = 1000;
+
+  void write_snapshot(string snapshot_path, const std::unordered_map<uint64, std::pair<uint32, uint32>> &event_info) {
+    std::vector<detail::KeyValueSnapshot::Entry> entries;
+    entries.reserve(map_.size());
+    for (const auto &kv : map_) {
+      auto it = event_info.find(kv.second.second);
+      if (it == event_info.end()) {
+        continue;
+      }
+      detail::KeyValueSnapshot::Entry entry;
+      entry.key = kv.first.str();
+      entry.value = kv.second.first;
+      entry.event_id = kv.second.second;
+      entry.event_crc32 = it->second.first;
+      entry.event_size = it->second.second;
+      entries.push_back(std::move(entry));
+    }
+#if TD_THREAD_UNSUPPORTED
+    do_write_snapshot(std::move(snapshot_path), std::move(entries));
+#else
+    // the writer works on copies of the data, so it may outlive the key-value store
+    thread(do_write_snapshot, std::move(snapshot_path), std::move(entries)).detach();
+#endif
+  }
+
+  static void do_write_snapshot(string path, std::vector<detail::KeyValueSnapshot::Entry> entries) {
+    auto status = detail::KeyValueSnapshot::write(path, std::move(entries));
+    if (status.is_error()) {
+      LOG(WARNING) << "Failed to write key-value snapshot: " << status;
+    }
+  }
 };
 
 template <>
@@ -6,8 +6,11 @@
 //
 #pragma once
 
+#include "td/utils/CompactString.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Slice.h"
 
+#include <functional>
 #include <unordered_map>
 
 namespace td {
@@ -23,7 +26,7 @@ class SeqKeyValue {
   ~SeqKeyValue() = default;
 
   SeqNo set(Slice key, Slice value) {
-    auto it_ok = map_.insert({key.str(), value.str()});
+    auto it_ok = map_.emplace(CompactString(key), value.str());
     if (!it_ok.second) {
       if (it_ok.first->second == value) {
         return 0;
@@ -33,11 +36,9 @@ class SeqKeyValue {
     return next_seq_no();
   }
   SeqNo erase(const string &key) {
-    auto it = map_.find(key);
-    if (it == map_.end()) {
+    if (map_.erase(key) == 0) {
       return 0;
     }
-    map_.erase(it);
     return next_seq_no();
   }
   SeqNo seq_no() const {
@@ -66,11 +67,17 @@ class SeqKeyValue {
     current_id_ = 0;
   }
   std::unordered_map<string, string> get_all() const {
-    return map_;
+    std::unordered_map<string, string> res;
+    for (const auto &it : map_) {
+      res[it.first.str()] = it.second;
+    }
+    return res;
   }
 
  private:
-  std::unordered_map<string, string> map_;
+  // short keys are stored inline in CompactString; get looks the key up as a
+  // Slice without constructing a temporary string
+  FlatHashMap<CompactString, string, SliceHash, std::equal_to<Slice>> map_;
   SeqNo current_id_ = 0;
   SeqNo next_seq_no() {
     return ++current_id_;
@@ -0,0 +1,120 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/db/SeqKeyValue.h"
+
+#include "td/utils/port/RwMutex.h"
+#include "td/utils/Slice.h"
+
+#include <array>
+#include <unordered_map>
+#include <utility>
+
+namespace td {
+
+// TsSeqKeyValue with the key space split over SHARD_COUNT independent
+// SeqKeyValue instances, each behind its own RwMutex, so accesses to
+// unrelated keys never touch the same lock. The shard is picked from the key
+// hash, therefore all operations on one key always hit the same shard.
+//
+// Seq numbers are per-shard: the returned SeqNo is the per-shard number
+// shifted left by SHARD_BITS with the shard index in the low bits. Numbers
+// from one shard stay strictly increasing, so a ChangesProcessor consumer
+// keeps one processor per shard, selected by seq_no_shard(), and feeds it
+// the per-shard number seq_no_value(); there is no meaningful order between
+// numbers of different shards.
+class ShardedTsSeqKeyValue {
+ public:
+  using SeqNo = SeqKeyValue::SeqNo;
+
+  static constexpr size_t SHARD_BITS = 4;
+  static constexpr size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+
+  ShardedTsSeqKeyValue() = default;
+  ShardedTsSeqKeyValue(ShardedTsSeqKeyValue &&) = delete;
+  ShardedTsSeqKeyValue &operator=(ShardedTsSeqKeyValue &&) = delete;
+  ShardedTsSeqKeyValue(const ShardedTsSeqKeyValue &) = delete;
+  ShardedTsSeqKeyValue &operator=(const ShardedTsSeqKeyValue &) = delete;
+  ~ShardedTsSeqKeyValue() = default;
+
+  static size_t seq_no_shard(SeqNo seq_no) {
+    return static_cast<size_t>(seq_no & (SHARD_COUNT - 1));
+  }
+  static SeqNo seq_no_value(SeqNo seq_no) {
+    return seq_no >> SHARD_BITS;
+  }
+
+  SeqNo set(Slice key, Slice value) {
+    auto shard_i = get_shard(key);
+    auto &shard = shards_[shard_i];
+    auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+    return merge_seq_no(shard_i, shard.kv_.set(key, value));
+  }
+  std::pair<SeqNo, RwMutex::WriteLock> set_and_lock(Slice key, Slice value) {
+    auto shard_i = get_shard(key);
+    auto &shard = shards_[shard_i];
+    auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+    return std::make_pair(merge_seq_no(shard_i, shard.kv_.set(key, value)), std::move(lock));
+  }
+  SeqNo erase(const string &key) {
+    auto shard_i = get_shard(key);
+    auto &shard = shards_[shard_i];
+    auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+    return merge_seq_no(shard_i, shard.kv_.erase(key));
+  }
+  std::pair<SeqNo, RwMutex::WriteLock> erase_and_lock(const string &key) {
+    auto shard_i = get_shard(key);
+    auto &shard = shards_[shard_i];
+    auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+    return std::make_pair(merge_seq_no(shard_i, shard.kv_.erase(key)), std::move(lock));
+  }
+  string get(const string &key) {
+    auto &shard = shards_[get_shard(key)];
+    auto lock = shard.rw_mutex_.lock_read().move_as_ok();
+    return shard.kv_.get(key);
+  }
+  size_t size() const {
+    size_t res = 0;
+    for (auto &shard : shards_) {
+      res += shard.kv_.size();
+    }
+    return res;
+  }
+  std::unordered_map<string, string> get_all() {
+    std::unordered_map<string, string> res;
+    for (auto &shard : shards_) {
+      auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+      for (auto &it : shard.kv_.get_all()) {
+        res.emplace(std::move(it.first), std::move(it.second));
+      }
+    }
+    return res;
+  }
+
+ private:
+  struct Shard {
+    RwMutex rw_mutex_;
+    SeqKeyValue kv_;
+  };
+  std::array<Shard, SHARD_COUNT> shards_;
+
+  static size_t get_shard(Slice key) {
+    // take the high bits: FlatHashMap picks its bucket from the low bits of
+    // the same hash, and the shard index must not correlate with them
+    auto hash = SliceHash()(key);
+    return (hash >> (sizeof(hash) * 8 - SHARD_BITS)) & (SHARD_COUNT - 1);
+  }
+  static SeqNo merge_seq_no(size_t shard_i, SeqNo seq_no) {
+    if (seq_no == 0) {
+      return 0;
+    }
+    return (seq_no << SHARD_BITS) | static_cast<SeqNo>(shard_i);
+  }
+};
+
+}  // namespace td
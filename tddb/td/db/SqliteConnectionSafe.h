@@ -20,7 +20,7 @@ class SqliteConnectionSafe {
  public:
   SqliteConnectionSafe() = default;
   explicit SqliteConnectionSafe(string name, DbKey key = DbKey::empty())
-      : lsls_connection_([name = name, key = std::move(key)] {
+      : lsls_connection_([name = name, key = key] {
         auto r_db = SqliteDb::open_with_key(name, key);
         if (r_db.is_error()) {
           LOG(FATAL) << "Can't open database " << name << ": " << r_db.error();
@@ -32,6 +32,21 @@ class SqliteConnectionSafe {
         db.exec("PRAGMA recursive_triggers=1").ensure();
         return db;
       })
+      , lsls_readonly_connection_([name = name, key = std::move(key)] {
+        SqliteDb::OpenOptions options;
+        options.readonly = true;
+        // all readers share the mapped pages through the OS page cache instead
+        // of each warming its own private page cache
+        options.mmap_size = READONLY_MMAP_SIZE;
+        auto r_db = SqliteDb::open_with_key(name, key, options);
+        if (r_db.is_error()) {
+          LOG(FATAL) << "Can't open database " << name << ": " << r_db.error();
+        }
+        auto db = r_db.move_as_ok();
+        db.exec("PRAGMA synchronous=NORMAL").ensure();
+        db.exec("PRAGMA temp_store=MEMORY").ensure();
+        return db;
+      })
       , name_(std::move(name)) {
   }
 
@@ -39,8 +54,15 @@ class SqliteConnectionSafe {
     return lsls_connection_.get();
   }
 
+  // a read-only connection for the current scheduler; in WAL mode it can serve
+  // queries concurrently with the serialized writer connection
+  SqliteDb &get_readonly() {
+    return lsls_readonly_connection_.get();
+  }
+
   void close() {
     LOG(INFO) << "Close SQLite database " << tag("path", name_);
+    lsls_readonly_connection_.clear_values();
     lsls_connection_.clear_values();
   }
   void close_and_destroy() {
@@ -50,7 +72,10 @@ class SqliteConnectionSafe {
   }
 
  private:
+  static constexpr int64 READONLY_MMAP_SIZE = 64 << 20;
+
   LazySchedulerLocalStorage<SqliteDb> lsls_connection_;
+  LazySchedulerLocalStorage<SqliteDb> lsls_readonly_connection_;
   string name_;
 };
 
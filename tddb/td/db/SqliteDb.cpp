@@ -147,6 +147,10 @@ bool SqliteDb::is_encrypted() {
 }
 
 Result<SqliteDb> SqliteDb::open_with_key(CSlice path, const DbKey &db_key) {
+  return open_with_key(path, db_key, OpenOptions());
+}
+
+Result<SqliteDb> SqliteDb::open_with_key(CSlice path, const DbKey &db_key, const OpenOptions &options) {
   SqliteDb db;
   TRY_STATUS(db.init(path));
   if (!db_key.is_empty()) {
@@ -159,6 +163,16 @@ Result<SqliteDb> SqliteDb::open_with_key(CSlice path, const DbKey &db_key) {
   if (db.is_encrypted()) {
     return Status::Error("Wrong key or database is corrupted");
   }
+  if (options.readonly) {
+    TRY_STATUS(db.exec("PRAGMA query_only=1"));
+  }
+  if (options.mmap_size > 0) {
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA mmap_size = " << options.mmap_size));
+  }
+  if (options.cache_size_kib > 0) {
+    // negative cache_size is in KiB instead of pages
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA cache_size = -" << options.cache_size_kib));
+  }
   return std::move(db);
 }
 
@@ -59,8 +59,21 @@ class SqliteDb {
 
   static Status destroy(Slice path) TD_WARN_UNUSED_RESULT;
 
+  struct OpenOptions {
+    // reject all writes at the SQL layer via PRAGMA query_only; the file itself
+    // is still opened read-write, so a hot journal can be recovered
+    bool readonly = false;
+    // PRAGMA mmap_size in bytes; 0 keeps the default. Mapped reads come straight
+    // from the OS page cache, which is shared between all connections to the
+    // database, unlike the per-connection sqlite page cache
+    int64 mmap_size = 0;
+    // PRAGMA cache_size in KiB; 0 keeps the default
+    int32 cache_size_kib = 0;
+  };
+
   // Anyway we can't change the key on the fly, so having static functions is more than enough
   static Result<SqliteDb> open_with_key(CSlice path, const DbKey &db_key);
+  static Result<SqliteDb> open_with_key(CSlice path, const DbKey &db_key, const OpenOptions &options);
   static Status change_key(CSlice path, const DbKey &new_db_key, const DbKey &old_db_key);
 
   Status last_error();
@@ -7,6 +7,7 @@
 #include "td/db/SqliteKeyValue.h"
 
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Zstd.h"
 
 namespace td {
 
@@ -54,6 +55,14 @@ Status SqliteKeyValue::init_with_connection(SqliteDb connection, string table_na
              db_.get_statement(PSLICE() << "SELECT k, v FROM " << table_name_ << " WHERE ?1 <= k"));
   get_by_prefix_rare_stmt_ = std::move(get_by_prefix_rare_stmt);
 
+  string get_many_sql = PSTRING() << "SELECT k, v FROM " << table_name_ << " WHERE k IN (?1";
+  for (size_t i = 2; i <= GET_MANY_BATCH_SIZE; i++) {
+    get_many_sql += PSTRING() << ", ?" << i;
+  }
+  get_many_sql += ')';
+  TRY_RESULT(get_many_stmt, db_.get_statement(get_many_sql));
+  get_many_stmt_ = std::move(get_many_stmt);
+
   init_guard.dismiss();
   return Status::OK();
 }
@@ -68,7 +77,55 @@ Status SqliteKeyValue::drop() {
   return result;
 }
 
+void SqliteKeyValue::enable_compression(size_t min_size, string dictionary) {
+#if TD_HAVE_ZSTD
+  compression_min_size_ = min_size;
+  compression_dictionary_ = std::move(dictionary);
+#else
+  LOG(WARNING) << "Can't enable compression: built without zstd";
+#endif
+}
+
+bool SqliteKeyValue::is_compressed_value(Slice value) const {
+#if TD_HAVE_ZSTD
+  return compression_min_size_ != 0 && is_zstd_frame(value);
+#else
+  return false;
+#endif
+}
+
+string SqliteKeyValue::compress_value(Slice value) const {
+#if TD_HAVE_ZSTD
+  auto compressed = zstd_encode(value, 3, compression_dictionary_);
+  if (!compressed.empty() && compressed.size() < value.size()) {
+    return compressed.as_slice().str();
+  }
+#endif
+  return string();
+}
+
+string SqliteKeyValue::decompress_value(Slice value) const {
+#if TD_HAVE_ZSTD
+  auto r_decompressed = zstd_decode(value, compression_dictionary_);
+  if (r_decompressed.is_ok()) {
+    return r_decompressed.ok().as_slice().str();
+  }
+  // a raw value which happens to begin with the zstd magic
+  LOG(WARNING) << "Failed to decompress value: " << r_decompressed.error();
+#endif
+  return value.str();
+}
+
 SqliteKeyValue::SeqNo SqliteKeyValue::set(Slice key, Slice value) {
+  string compressed;
+#if TD_HAVE_ZSTD
+  if (compression_min_size_ != 0 && value.size() >= compression_min_size_ && !is_zstd_frame(value)) {
+    compressed = compress_value(value);
+    if (!compressed.empty()) {
+      value = compressed;
+    }
+  }
+#endif
   set_stmt_.bind_blob(1, key).ensure();
   set_stmt_.bind_blob(2, value).ensure();
   set_stmt_.step().ensure();
@@ -76,6 +133,17 @@ SqliteKeyValue::SeqNo SqliteKeyValue::set(Slice key, Slice value) {
   return 0;
 }
 
+void SqliteKeyValue::set_many(Span<std::pair<Slice, Slice>> key_values) {
+  if (key_values.size() == 0) {
+    return;
+  }
+  begin_transaction().ensure();
+  for (auto &key_value : key_values) {
+    set(key_value.first, key_value.second);
+  }
+  commit_transaction().ensure();
+}
+
 string SqliteKeyValue::get(Slice key) {
   SCOPE_EXIT {
     get_stmt_.reset();
@@ -85,11 +153,42 @@ string SqliteKeyValue::get(Slice key) {
   if (!get_stmt_.has_row()) {
     return "";
   }
-  auto data = get_stmt_.view_blob(0).str();
+  auto value = get_stmt_.view_blob(0);
+  auto data = is_compressed_value(value) ? decompress_value(value) : value.str();
   get_stmt_.step().ignore();
   return data;
 }
 
+std::vector<string> SqliteKeyValue::get_many(Span<Slice> keys) {
+  std::unordered_map<string, string> values;
+  for (size_t begin = 0; begin < keys.size(); begin += GET_MANY_BATCH_SIZE) {
+    SCOPE_EXIT {
+      get_many_stmt_.reset();
+    };
+    for (size_t i = 0; i < GET_MANY_BATCH_SIZE; i++) {
+      // the last batch is padded with its first key; duplicates inside IN are harmless
+      auto key = keys[begin + i < keys.size() ? begin + i : begin];
+      get_many_stmt_.bind_blob(static_cast<int>(i + 1), key).ensure();
+    }
+    get_many_stmt_.step().ensure();
+    while (get_many_stmt_.has_row()) {
+      auto value = get_many_stmt_.view_blob(1);
+      values.emplace(get_many_stmt_.view_blob(0).str(),
+                     is_compressed_value(value) ? decompress_value(value) : value.str());
+      get_many_stmt_.step().ensure();
+    }
+  }
+
+  std::vector<string> res(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto it = values.find(keys[i].str());
+    if (it != values.end()) {
+      res[i] = it->second;
+    }
+  }
+  return res;
+}
+
 SqliteKeyValue::SeqNo SqliteKeyValue::erase(Slice key) {
   erase_stmt_.bind_blob(1, key).ensure();
   erase_stmt_.step().ensure();
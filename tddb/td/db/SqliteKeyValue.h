@@ -11,9 +11,12 @@
 
 #include "td/utils/logging.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace td {
 
@@ -47,10 +50,22 @@ class SqliteKeyValue {
 
   Status drop();
 
+  // Enables transparent zstd compression of values not shorter than min_size.
+  // Compressed values are recognized on read by the zstd frame magic, so the
+  // option may be enabled for a table with existing uncompressed data. Has no
+  // effect when the library is built without zstd.
+  void enable_compression(size_t min_size, string dictionary = string());
+
   SeqNo set(Slice key, Slice value);
 
+  // sets all key-value pairs within one transaction
+  void set_many(Span<std::pair<Slice, Slice>> key_values);
+
   string get(Slice key);
 
+  // returns values in the order of the keys; a missing key yields an empty value
+  std::vector<string> get_many(Span<Slice> keys);
+
   SeqNo erase(Slice key);
 
   Status begin_transaction() TD_WARN_UNUSED_RESULT {
@@ -95,7 +110,12 @@ class SqliteKeyValue {
     auto guard = stmt->guard();
     stmt->step().ensure();
     while (stmt->has_row()) {
-      callback(stmt->view_blob(0), stmt->view_blob(1));
+      auto value = stmt->view_blob(1);
+      if (is_compressed_value(value)) {
+        callback(stmt->view_blob(0), Slice(decompress_value(value)));
+      } else {
+        callback(stmt->view_blob(0), value);
+      }
       stmt->step().ensure();
     }
   }
@@ -112,6 +132,16 @@ class SqliteKeyValue {
   SqliteStatement erase_by_prefix_rare_stmt_;
   SqliteStatement get_by_prefix_stmt_;
   SqliteStatement get_by_prefix_rare_stmt_;
+  SqliteStatement get_many_stmt_;
+
+  static constexpr size_t GET_MANY_BATCH_SIZE = 16;
+
+  size_t compression_min_size_ = 0;
+  string compression_dictionary_;
+
+  bool is_compressed_value(Slice value) const;
+  string compress_value(Slice value) const;
+  string decompress_value(Slice value) const;
 
   string next_prefix(Slice prefix);
 };
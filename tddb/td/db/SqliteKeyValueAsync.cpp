@@ -12,9 +12,12 @@
 
 #include "td/utils/common.h"
 #include "td/utils/optional.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Time.h"
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace td {
 
@@ -26,12 +29,18 @@ class SqliteKeyValueAsync : public SqliteKeyValueAsyncInterface {
   void set(string key, string value, Promise<> promise) override {
     send_closure_later(impl_, &Impl::set, std::move(key), std::move(value), std::move(promise));
   }
+  void set_many(std::vector<std::pair<string, string>> key_values, Promise<> promise) override {
+    send_closure_later(impl_, &Impl::set_many, std::move(key_values), std::move(promise));
+  }
   void erase(string key, Promise<> promise) override {
     send_closure_later(impl_, &Impl::erase, std::move(key), std::move(promise));
   }
   void get(string key, Promise<string> promise) override {
     send_closure_later(impl_, &Impl::get, std::move(key), std::move(promise));
   }
+  void get_many(std::vector<string> keys, Promise<std::vector<string>> promise) override {
+    send_closure_later(impl_, &Impl::get_many, std::move(keys), std::move(promise));
+  }
   void close(Promise<> promise) override {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -51,7 +60,20 @@ class SqliteKeyValueAsync : public SqliteKeyValueAsyncInterface {
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
+      do_flush(false /*force*/);
+    }
+    void set_many(std::vector<std::pair<string, string>> key_values, Promise<> promise) {
+      for (auto &key_value : key_values) {
+        auto it = buffer_.find(key_value.first);
+        if (it != buffer_.end()) {
+          it->second = std::move(key_value.second);
+        } else {
+          buffer_.emplace(std::move(key_value.first), std::move(key_value.second));
+        }
+      }
+      if (promise) {
+        buffer_promises_.push_back(std::move(promise));
+      }
       do_flush(false /*force*/);
     }
     void erase(string key, Promise<> promise) {
@@ -64,7 +86,6 @@ class SqliteKeyValueAsync : public SqliteKeyValueAsyncInterface {
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
@@ -75,6 +96,31 @@ class SqliteKeyValueAsync : public SqliteKeyValueAsyncInterface {
       }
       promise.set_value(kv_->get(key));
     }
+
+    void get_many(const std::vector<string> &keys, Promise<std::vector<string>> promise) {
+      std::vector<string> res(keys.size());
+      std::vector<size_t> db_positions;
+      for (size_t i = 0; i < keys.size(); i++) {
+        auto it = buffer_.find(keys[i]);
+        if (it != buffer_.end()) {
+          res[i] = it->second ? it->second.value() : "";
+        } else {
+          db_positions.push_back(i);
+        }
+      }
+      if (!db_positions.empty()) {
+        std::vector<Slice> db_keys;
+        db_keys.reserve(db_positions.size());
+        for (auto pos : db_positions) {
+          db_keys.push_back(keys[pos]);
+        }
+        auto db_values = kv_->get_many(db_keys);
+        for (size_t i = 0; i < db_positions.size(); i++) {
+          res[db_positions[i]] = std::move(db_values[i]);
+        }
+      }
+      promise.set_value(std::move(res));
+    }
     void close(Promise<> promise) {
       do_flush(true /*force*/);
       kv_safe_.reset();
@@ -87,11 +133,13 @@ class SqliteKeyValueAsync : public SqliteKeyValueAsyncInterface {
     std::shared_ptr<SqliteKeyValueSafe> kv_safe_;
     SqliteKeyValue *kv_ = nullptr;
 
+    // writes are buffered for up to MAX_PENDING_QUERIES_DELAY seconds or MAX_PENDING_QUERIES_COUNT
+    // distinct keys, and are committed as one transaction; repeated writes to the same key are
+    // deduplicated while they are buffered, so a hot key doesn't shorten the window
     static constexpr double MAX_PENDING_QUERIES_DELAY = 0.01;
     static constexpr size_t MAX_PENDING_QUERIES_COUNT = 100;
     std::unordered_map<string, optional<string>> buffer_;
     std::vector<Promise<>> buffer_promises_;
-    size_t cnt_ = 0;
 
     double wakeup_at_ = 0;
     void do_flush(bool force) {
@@ -103,15 +151,14 @@ class SqliteKeyValueAsync : public SqliteKeyValueAsyncInterface {
         auto now = Time::now_cached();
         if (wakeup_at_ == 0) {
           wakeup_at_ = now + MAX_PENDING_QUERIES_DELAY;
-        }
-        if (now < wakeup_at_ && cnt_ < MAX_PENDING_QUERIES_COUNT) {
           set_timeout_at(wakeup_at_);
+        }
+        if (now < wakeup_at_ && buffer_.size() < MAX_PENDING_QUERIES_COUNT) {
           return;
         }
       }
 
       wakeup_at_ = 0;
-      cnt_ = 0;
 
       kv_->begin_transaction().ensure();
       for (auto &it : buffer_) {
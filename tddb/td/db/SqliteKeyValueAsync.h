@@ -11,6 +11,8 @@
 #include "td/actor/PromiseFuture.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace td {
 
@@ -19,9 +21,12 @@ class SqliteKeyValueAsyncInterface {
   virtual ~SqliteKeyValueAsyncInterface() = default;
 
   virtual void set(string key, string value, Promise<> promise) = 0;
+  virtual void set_many(std::vector<std::pair<string, string>> key_values, Promise<> promise) = 0;
   virtual void erase(string key, Promise<> promise) = 0;
 
   virtual void get(string key, Promise<string> promise) = 0;
+  // returns values in the order of the keys; a missing key yields an empty value
+  virtual void get_many(std::vector<string> keys, Promise<std::vector<string>> promise) = 0;
   virtual void close(Promise<> promise) = 0;
 };
 
@@ -0,0 +1,67 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/db/SqliteReaderPool.h"
+
+#include "td/utils/logging.h"
+
+#include <limits>
+
+namespace td {
+
+class SqliteReaderPool::Reader : public Actor {
+ public:
+  Reader(std::shared_ptr<SqliteConnectionSafe> connection, std::shared_ptr<std::atomic<uint32>> pending_query_count)
+      : connection_(std::move(connection)), pending_query_count_(std::move(pending_query_count)) {
+  }
+
+  void execute(ReadQuery query) {
+    query(connection_->get_readonly());
+    pending_query_count_->fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  std::shared_ptr<SqliteConnectionSafe> connection_;
+  std::shared_ptr<std::atomic<uint32>> pending_query_count_;
+};
+
+SqliteReaderPool::SqliteReaderPool(std::shared_ptr<SqliteConnectionSafe> connection,
+                                   std::vector<int32> scheduler_ids) {
+  CHECK(!scheduler_ids.empty());
+  readers_.reserve(scheduler_ids.size());
+  for (size_t i = 0; i < scheduler_ids.size(); i++) {
+    ReaderInfo info;
+    info.pending_query_count_ = std::make_shared<std::atomic<uint32>>(0);
+    info.actor_ = create_actor_on_scheduler<Reader>(PSLICE() << "SqliteReader" << i, scheduler_ids[i], connection,
+                                                    info.pending_query_count_);
+    readers_.push_back(std::move(info));
+  }
+}
+
+void SqliteReaderPool::execute(ReadQuery query) {
+  size_t best_pos = 0;
+  auto best_count = std::numeric_limits<uint32>::max();
+  for (size_t i = 0; i < readers_.size(); i++) {
+    auto count = readers_[i].pending_query_count_->load(std::memory_order_relaxed);
+    if (count == 0) {
+      best_pos = i;
+      break;
+    }
+    if (count < best_count) {
+      best_count = count;
+      best_pos = i;
+    }
+  }
+  auto &reader = readers_[best_pos];
+  reader.pending_query_count_->fetch_add(1, std::memory_order_relaxed);
+  send_closure_later(reader.actor_, &Reader::execute, std::move(query));
+}
+
+void SqliteReaderPool::close() {
+  readers_.clear();
+}
+
+}  // namespace td
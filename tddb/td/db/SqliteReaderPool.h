@@ -0,0 +1,45 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/db/SqliteConnectionSafe.h"
+#include "td/db/SqliteDb.h"
+
+#include "td/utils/common.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace td {
+
+// Routes read-only queries to a pool of query_only connections, so slow reads
+// don't queue behind each other or behind writes on the main database actor.
+// Writes must keep going through the usual serialized connection.
+class SqliteReaderPool {
+ public:
+  using ReadQuery = std::function<void(SqliteDb &)>;
+
+  SqliteReaderPool(std::shared_ptr<SqliteConnectionSafe> connection, std::vector<int32> scheduler_ids);
+
+  // runs the query on the reader with the smallest number of pending queries
+  void execute(ReadQuery query);
+
+  void close();
+
+ private:
+  class Reader;
+  struct ReaderInfo {
+    ActorOwn<Reader> actor_;
+    std::shared_ptr<std::atomic<uint32>> pending_query_count_;
+  };
+  std::vector<ReaderInfo> readers_;
+};
+
+}  // namespace td
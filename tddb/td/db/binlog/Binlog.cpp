@@ -18,6 +18,7 @@
 #include "td/utils/port/path.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Status.h"
@@ -153,6 +154,46 @@ class BinlogReader {
   bool is_encrypted_{false};
 };
 
+// CTR mode is random access, so a large chunk can be cut into stripes which
+// are decrypted concurrently; stripes share only the read-only key and iv
+static void aes_ctr_decrypt_chunk(const UInt256 &key, const UInt128 &iv, uint64 offset, MutableSlice data) {
+  size_t thread_count = 1;
+#if !TD_THREAD_UNSUPPORTED
+  constexpr size_t MIN_STRIPE_SIZE = 1 << 18;
+  thread_count = min(max(static_cast<size_t>(thread::hardware_concurrency()), static_cast<size_t>(1)),
+                     data.size() / MIN_STRIPE_SIZE);
+#endif
+  if (thread_count <= 1) {
+    AesCtrState state;
+    state.init(key, iv, offset);
+    state.decrypt(data, data);
+    return;
+  }
+#if !TD_THREAD_UNSUPPORTED
+  std::vector<thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i = 0; i < thread_count; i++) {
+    auto begin = data.size() * i / thread_count;
+    auto end = data.size() * (i + 1) / thread_count;
+    auto stripe = MutableSlice(data.begin() + begin, data.begin() + end);
+    auto stripe_offset = offset + begin;
+    auto decrypt_stripe = [key, iv, stripe, stripe_offset] {
+      AesCtrState state;
+      state.init(key, iv, stripe_offset);
+      state.decrypt(stripe, stripe);
+    };
+    if (i + 1 == thread_count) {
+      decrypt_stripe();
+    } else {
+      threads.emplace_back(std::move(decrypt_stripe));
+    }
+  }
+  for (auto &worker : threads) {
+    worker.join();
+  }
+#endif
+}
+
 static int64 file_size(CSlice path) {
   auto r_stat = stat(path);
   if (r_stat.is_error()) {
@@ -194,10 +235,15 @@ Status Binlog::init(string path, const Callback &callback, DbKey db_key, DbKey o
 
   info_ = BinlogInfo();
   info_.was_created = stat(path).is_error();
+  chain_head_ = BinlogEvent::CHAIN_SEED;
 
   TRY_RESULT(fd, open_binlog(path, FileFd::Flags::Read | FileFd::Flags::Write | FileFd::Flags::Create));
+  // the whole file is about to be replayed sequentially
+  fd.advise(FileFd::Advice::Sequential, 0, 0).ignore();
   fd_ = BufferedFdBase<FileFd>(std::move(fd));
   fd_size_ = 0;
+  fd_allocated_size_ = 0;
+  fd_allocate_failed_ = false;
   path_ = std::move(path);
 
   auto status = load_binlog(callback, debug_callback);
@@ -205,6 +251,8 @@ Status Binlog::init(string path, const Callback &callback, DbKey db_key, DbKey o
     close().ignore();
     return status;
   }
+  // everything up to fd_size_ is on disk already
+  fd_allocated_size_ = fd_size_;
   info_.last_id = processor_->last_id();
   last_id_ = processor_->last_id();
   if (info_.wrong_password) {
@@ -217,6 +265,7 @@ Status Binlog::init(string path, const Callback &callback, DbKey db_key, DbKey o
     do_reindex();
   }
 
+  info_.chain_head = chain_head_;
   info_.is_opened = true;
   return Status::OK();
 }
@@ -234,6 +283,10 @@ void Binlog::add_event(BinlogEvent &&event) {
   lazy_flush();
 
   if (state_ == State::Run) {
+    if (reindex_ != nullptr) {
+      step_reindex();
+      return;
+    }
     auto fd_size = fd_size_;
     if (events_buffer_) {
       fd_size += events_buffer_->size();
@@ -244,7 +297,7 @@ void Binlog::add_event(BinlogEvent &&event) {
     if (need_reindex(100000, 5) || need_reindex(500000, 2)) {
       LOG(INFO) << tag("fd_size", format::as_size(fd_size))
                 << tag("total events size", format::as_size(processor_->total_raw_events_size()));
-      do_reindex();
+      start_reindex();
     }
   }
 }
@@ -280,6 +333,8 @@ Status Binlog::close(bool need_sync) {
   if (fd_.empty()) {
     return Status::OK();
   }
+  abort_reindex();
+  load_ = nullptr;
   if (need_sync) {
     sync();
   } else {
@@ -316,8 +371,21 @@ Status Binlog::destroy(Slice path) {
 void Binlog::do_event(BinlogEvent &&event) {
   auto event_size = event.raw_event_.size();
 
-  if (state_ == State::Run || state_ == State::Reindex) {
-    VLOG(binlog) << "Write binlog event: " << format::cond(state_ == State::Reindex, "[reindex] ");
+  if (state_ == State::Run) {
+    // stamp the chained checksum before the event is written or copied anywhere
+    event.set_chain(chain_head_);
+    chain_head_ = event.chain_after();
+  }
+
+  // a rewrite of an event which was already copied to the new file must be replayed there too
+  BufferSlice reindex_raw_event;
+  if (reindex_ != nullptr && state_ == State::Run && (event.flags_ & BinlogEvent::Flags::Rewrite) != 0 &&
+      event.id_ < reindex_->next_event_id) {
+    reindex_raw_event = event.raw_event_.clone();
+  }
+
+  if (state_ == State::Run) {
+    VLOG(binlog) << "Write binlog event: ";
     auto validate_status = event.validate();
     if (validate_status.is_error()) {
       LOG(FATAL) << "Failed to validate binlog event " << validate_status << " "
@@ -366,19 +434,13 @@ void Binlog::do_event(BinlogEvent &&event) {
       aes_ctr_key_salt_ = encryption_event.key_salt_.copy();
       update_encryption(key.as_slice(), encryption_event.iv_.as_slice());
 
-      if (state_ == State::Load) {
-        update_read_encryption();
-        LOG(INFO) << "Load: init encryption";
-      } else {
-        CHECK(state_ == State::Reindex);
-        flush();
-        update_write_encryption();
-        //LOG(INFO) << format::cond(state_ == State::Run, "Run", "Reindex") << ": init encryption";
-      }
+      CHECK(state_ == State::Load);
+      update_read_encryption();
+      LOG(INFO) << "Load: init encryption";
     }
   }
 
-  if (state_ != State::Reindex) {
+  {
     auto status = processor_->add_event(std::move(event));
     if (status.is_error()) {
       auto old_size = detail::file_size(path_);
@@ -398,8 +460,28 @@ void Binlog::do_event(BinlogEvent &&event) {
     }
   }
 
+  if (!reindex_raw_event.empty()) {
+    reindex_append(std::move(reindex_raw_event));
+  }
+
   fd_events_++;
   fd_size_ += event_size;
+
+  if (state_ == State::Run && !fd_allocate_failed_ && fd_size_ > fd_allocated_size_) {
+    // reserve extents ahead of the append, so the binlog file doesn't
+    // fragment while growing event by event
+    int64 chunk = FD_ALLOCATE_CHUNK;
+    if (fd_size_ - fd_allocated_size_ > chunk) {
+      chunk = fd_size_ - fd_allocated_size_;
+    }
+    auto status = fd_.allocate(fd_allocated_size_, chunk);
+    if (status.is_error()) {
+      // the filesystem doesn't support preallocation; don't try again
+      fd_allocate_failed_ = true;
+    } else {
+      fd_allocated_size_ += chunk;
+    }
+  }
 }
 
 void Binlog::sync() {
@@ -428,6 +510,10 @@ void Binlog::flush() {
   }
   need_flush_since_ = 0;
   LOG_IF(FATAL, fd_.need_flush_write()) << "Failed to flush binlog";
+
+  if (reindex_ != nullptr) {
+    step_reindex();
+  }
 }
 
 void Binlog::lazy_flush() {
@@ -450,13 +536,12 @@ void Binlog::update_read_encryption() {
       break;
     }
     case EncryptionType::AesCtr: {
-      byte_flow_source_ = ByteFlowSource(&buffer_reader_);
-      aes_xcode_byte_flow_ = AesCtrByteFlow();
-      aes_xcode_byte_flow_.init(std::move(aes_ctr_state_));
-      byte_flow_sink_ = ByteFlowSink();
-      byte_flow_source_ >> aes_xcode_byte_flow_ >> byte_flow_sink_;
-      byte_flow_flag_ = true;
-      binlog_reader_ptr_->set_input(byte_flow_sink_.get_output(), true, fd_.get_size());
+      // the encrypted tail of the file is decrypted chunk by chunk on all
+      // cores instead of being streamed through the single-threaded byte flow
+      load_ = make_unique<LoadState>();
+      load_->plain_reader = load_->plain_writer.extract_reader();
+      byte_flow_flag_ = false;
+      binlog_reader_ptr_->set_input(&load_->plain_reader, true, fd_.get_size());
       break;
     }
   }
@@ -517,6 +602,16 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
     auto need_size = r_need_size.move_as_ok();
     // LOG(ERROR) << "Need size = " << need_size;
     if (need_size == 0) {
+      if (event.extra_ != 0) {
+        // events written before checksum chaining have zero extra_ and don't
+        // participate in the chain
+        if (event.extra_ != chain_head_) {
+          LOG(ERROR) << "Chained checksum mismatch " << tag("expected", format::as_hex(chain_head_))
+                     << tag("actual", format::as_hex(event.extra_)) << " in " << event.public_to_string();
+          break;
+        }
+        chain_head_ = event.chain_after();
+      }
       if (IGNORE_ERASE_HACK && event.type_ == BinlogEvent::ServiceTypes::Empty &&
           (event.flags_ & BinlogEvent::Flags::Rewrite) != 0) {
         // skip erase
@@ -530,10 +625,11 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
         }
       }
     } else {
-      TRY_STATUS(fd_.flush_read(max(need_size, static_cast<size_t>(4096))));
-      buffer_reader_.sync_with_writer();
-      if (byte_flow_flag_) {
-        byte_flow_source_.wakeup();
+      if (load_ != nullptr) {
+        TRY_STATUS(load_decrypt(need_size));
+      } else {
+        TRY_STATUS(fd_.flush_read(max(need_size, LOAD_CHUNK_SIZE)));
+        buffer_reader_.sync_with_writer();
       }
       if (reader.input()->size() < need_size) {
         break;
@@ -563,9 +659,11 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
   buffer_writer_ = ChainBufferWriter();
   buffer_reader_ = buffer_writer_.extract_reader();
 
-  // reuse aes_ctr_state_
-  if (encryption_type_ == EncryptionType::AesCtr) {
-    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+  // position the write state where decryption has stopped
+  if (load_ != nullptr) {
+    CHECK(encryption_type_ == EncryptionType::AesCtr);
+    aes_ctr_state_.init(aes_ctr_key_, aes_ctr_iv_, static_cast<uint64>(load_->ctr_offset));
+    load_ = nullptr;
   }
   update_write_encryption();
 
@@ -574,108 +672,209 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
 void Binlog::update_encryption(Slice key, Slice iv) {
   as_slice(aes_ctr_key_).copy_from(key);
-  UInt128 aes_ctr_iv;
-  as_slice(aes_ctr_iv).copy_from(iv);
-  aes_ctr_state_.init(aes_ctr_key_, aes_ctr_iv);
+  as_slice(aes_ctr_iv_).copy_from(iv);
+  aes_ctr_state_.init(aes_ctr_key_, aes_ctr_iv_);
 }
 
-void Binlog::reset_encryption() {
-  if (db_key_.is_empty()) {
-    encryption_type_ = EncryptionType::None;
-    return;
+Status Binlog::load_decrypt(size_t need_size) {
+  CHECK(load_ != nullptr);
+  TRY_STATUS(fd_.flush_read(max(need_size, static_cast<size_t>(LOAD_CHUNK_SIZE))));
+  buffer_reader_.sync_with_writer();
+  auto size = buffer_reader_.size();
+  if (size == 0) {
+    return Status::OK();
   }
+  BufferSlice chunk(size);
+  buffer_reader_.advance(size, chunk.as_slice());
+  detail::aes_ctr_decrypt_chunk(aes_ctr_key_, aes_ctr_iv_, static_cast<uint64>(load_->ctr_offset),
+                                chunk.as_slice());
+  load_->ctr_offset += static_cast<int64>(size);
+  load_->plain_writer.append(std::move(chunk));
+  load_->plain_reader.sync_with_writer();
+  return Status::OK();
+}
 
-  using EncryptionEvent = detail::AesCtrEncryptionEvent;
-  EncryptionEvent event;
-
-  if (aes_ctr_key_salt_.empty()) {
-    event.key_salt_ = BufferSlice(EncryptionEvent::default_salt_size());
-    Random::secure_bytes(event.key_salt_.as_slice());
-  } else {
-    event.key_salt_ = aes_ctr_key_salt_.clone();
+void Binlog::do_reindex() {
+  // the synchronous version used at init and for key changes: an already
+  // running incremental reindex may target outdated encryption parameters,
+  // so it is restarted from scratch
+  abort_reindex();
+  start_reindex();
+  while (reindex_ != nullptr) {
+    step_reindex();
   }
-  event.iv_ = BufferSlice(EncryptionEvent::iv_size());
-  Random::secure_bytes(event.iv_.as_slice());
+}
 
-  BufferSlice key;
-  if (aes_ctr_key_salt_.as_slice() == event.key_salt_.as_slice()) {
-    key = BufferSlice(as_slice(aes_ctr_key_));
-  } else {
-    key = event.generate_key(db_key_);
+void Binlog::start_reindex() {
+  if (reindex_ != nullptr) {
+    return;
   }
+  CHECK(state_ == State::Run);
+  flush_events_buffer(true);
 
-  event.key_hash_ = event.generate_hash(key.as_slice());
+  auto r_opened_file = open_binlog(path_ + ".new", FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
+  if (r_opened_file.is_error()) {
+    LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
+    return;
+  }
 
-  do_event(BinlogEvent(
-      BinlogEvent::create_raw(0, BinlogEvent::ServiceTypes::AesCtrEncryption, 0, create_default_storer(event)),
-      BinlogDebugInfo{__FILE__, __LINE__}));
-}
+  reindex_ = make_unique<ReindexState>();
+  reindex_->fd = BufferedFdBase<FileFd>(r_opened_file.move_as_ok());
+  reindex_->buffer_reader = reindex_->buffer_writer.extract_reader();
+  reindex_->fd.set_output_reader(&reindex_->buffer_reader);
+  reindex_->start_time = Clocks::monotonic();
+  reindex_->start_size = detail::file_size(path_);
+  reindex_->start_events = fd_events_;
 
-void Binlog::do_reindex() {
-  flush_events_buffer(true);
-  // start reindex
-  CHECK(state_ == State::Run);
-  state_ = State::Reindex;
-  SCOPE_EXIT {
-    state_ = State::Run;
-  };
+  if (!db_key_.is_empty()) {
+    using EncryptionEvent = detail::AesCtrEncryptionEvent;
+    EncryptionEvent event;
 
-  auto start_time = Clocks::monotonic();
-  auto start_size = detail::file_size(path_);
-  auto start_events = fd_events_;
+    if (aes_ctr_key_salt_.empty()) {
+      event.key_salt_ = BufferSlice(EncryptionEvent::default_salt_size());
+      Random::secure_bytes(event.key_salt_.as_slice());
+    } else {
+      event.key_salt_ = aes_ctr_key_salt_.clone();
+    }
+    event.iv_ = BufferSlice(EncryptionEvent::iv_size());
+    Random::secure_bytes(event.iv_.as_slice());
 
-  string new_path = path_ + ".new";
+    BufferSlice key;
+    if (aes_ctr_key_salt_.as_slice() == event.key_salt_.as_slice()) {
+      key = BufferSlice(as_slice(aes_ctr_key_));
+    } else {
+      key = event.generate_key(db_key_);
+    }
+    event.key_hash_ = event.generate_hash(key.as_slice());
+
+    // the encryption event itself is stored in plain text, like in the old file
+    reindex_append(
+        BinlogEvent::create_raw(0, BinlogEvent::ServiceTypes::AesCtrEncryption, 0, create_default_storer(event)));
+    reindex_flush();
+
+    reindex_->aes_ctr_key_salt = event.key_salt_.copy();
+    as_slice(reindex_->aes_ctr_key).copy_from(key.as_slice());
+    UInt128 aes_ctr_iv;
+    as_slice(aes_ctr_iv).copy_from(event.iv_.as_slice());
+    AesCtrState aes_ctr_state;
+    aes_ctr_state.init(reindex_->aes_ctr_key, aes_ctr_iv);
+
+    reindex_->byte_flow_source = ByteFlowSource(&reindex_->buffer_reader);
+    reindex_->aes_xcode_byte_flow = AesCtrByteFlow();
+    reindex_->aes_xcode_byte_flow.init(std::move(aes_ctr_state));
+    reindex_->byte_flow_sink = ByteFlowSink();
+    reindex_->byte_flow_source >> reindex_->aes_xcode_byte_flow >> reindex_->byte_flow_sink;
+    reindex_->byte_flow_flag = true;
+    reindex_->fd.set_output_reader(reindex_->byte_flow_sink.get_output());
+    reindex_->encryption_type = EncryptionType::AesCtr;
+  }
+}
 
-  auto r_opened_file = open_binlog(new_path, FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
-  if (r_opened_file.is_error()) {
-    LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
+void Binlog::step_reindex() {
+  if (reindex_ == nullptr) {
     return;
   }
-  auto old_fd = std::move(fd_);  // can't close fd_ now, because it will release file lock
-  fd_ = BufferedFdBase<FileFd>(r_opened_file.move_as_ok());
-
-  buffer_writer_ = ChainBufferWriter();
-  buffer_reader_ = buffer_writer_.extract_reader();
-  encryption_type_ = EncryptionType::None;
-  update_write_encryption();
+  auto next_event_id = processor_->for_each_chunk(
+      reindex_->next_event_id, REINDEX_CHUNK_SIZE,
+      [&](const BinlogEvent &event) { reindex_append(event.raw_event_.clone()); });
+  reindex_flush();
+  if (next_event_id == 0) {
+    finish_reindex();
+  } else {
+    reindex_->next_event_id = next_event_id;
+  }
+}
 
-  // reindex
-  fd_size_ = 0;
-  fd_events_ = 0;
-  reset_encryption();
-  processor_->for_each([&](BinlogEvent &event) {
-    do_event(std::move(event));  // NB: no move is actually happens
-  });
-  need_sync_ = true;  // must sync creation of the file
-  sync();
+void Binlog::finish_reindex() {
+  CHECK(reindex_ != nullptr);
+  reindex_flush();
+  auto sync_status = reindex_->fd.sync();  // must sync creation of the file
+  LOG_IF(FATAL, sync_status.is_error()) << "Failed to sync binlog: " << sync_status;
 
-  // finish_reindex
+  string new_path = path_ + ".new";
   auto status = unlink(path_);
   LOG_IF(FATAL, status.is_error()) << "Failed to unlink old binlog: " << status;
-  old_fd.close();  // now we can close old file and release the system lock
+  auto old_fd = std::move(fd_);  // can't close fd_ earlier, because it holds the file lock
+  old_fd.close();                // now we can close old file and release the system lock
   status = rename(new_path, path_);
   FileFd::remove_local_lock(new_path);  // now we can release local lock for temporary file
   LOG_IF(FATAL, status.is_error()) << "Failed to rename binlog: " << status;
 
-  auto finish_time = Clocks::monotonic();
-  auto finish_size = fd_size_;
-  auto finish_events = fd_events_;
-  LOG_CHECK(fd_size_ == detail::file_size(path_))
-      << fd_size_ << ' ' << detail::file_size(path_) << ' ' << fd_events_ << ' ' << path_;
-
-  double ratio = static_cast<double>(start_size) / static_cast<double>(finish_size + 1);
-  LOG(INFO) << "Regenerate index " << tag("name", path_) << tag("time", format::as_time(finish_time - start_time))
-            << tag("before_size", format::as_size(start_size)) << tag("after_size", format::as_size(finish_size))
-            << tag("ratio", ratio) << tag("before_events", start_events) << tag("after_events", finish_events);
+  fd_ = std::move(reindex_->fd);
+  fd_size_ = reindex_->fd_size;
+  fd_allocated_size_ = fd_size_;
+  fd_events_ = reindex_->fd_events;
+  chain_head_ = reindex_->chain_head;
+  info_.chain_head = chain_head_;
+  encryption_type_ = reindex_->encryption_type;
+  aes_ctr_key_salt_ = std::move(reindex_->aes_ctr_key_salt);
+  aes_ctr_key_ = reindex_->aes_ctr_key;
+  need_sync_ = false;
 
   buffer_writer_ = ChainBufferWriter();
   buffer_reader_ = buffer_writer_.extract_reader();
 
   // reuse aes_ctr_state_
   if (encryption_type_ == EncryptionType::AesCtr) {
-    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+    aes_ctr_state_ = reindex_->aes_xcode_byte_flow.move_aes_ctr_state();
   }
   update_write_encryption();
+
+  auto finish_time = Clocks::monotonic();
+  LOG_CHECK(fd_size_ == detail::file_size(path_))
+      << fd_size_ << ' ' << detail::file_size(path_) << ' ' << fd_events_ << ' ' << path_;
+
+  double ratio = static_cast<double>(reindex_->start_size) / static_cast<double>(fd_size_ + 1);
+  LOG(INFO) << "Regenerate index " << tag("name", path_)
+            << tag("time", format::as_time(finish_time - reindex_->start_time))
+            << tag("before_size", format::as_size(reindex_->start_size)) << tag("after_size", format::as_size(fd_size_))
+            << tag("ratio", ratio) << tag("before_events", reindex_->start_events) << tag("after_events", fd_events_);
+
+  reindex_ = nullptr;
+}
+
+void Binlog::abort_reindex() {
+  if (reindex_ == nullptr) {
+    return;
+  }
+  string new_path = path_ + ".new";
+  reindex_->fd.close();
+  FileFd::remove_local_lock(new_path);
+  unlink(new_path).ignore();
+  reindex_ = nullptr;
+}
+
+void Binlog::reindex_append(BufferSlice &&raw_event) {
+  CHECK(reindex_ != nullptr);
+
+  // events are copied in a different order and erased events are dropped, so
+  // the chain of the new file is computed from scratch
+  BinlogEvent event(std::move(raw_event), BinlogDebugInfo{__FILE__, __LINE__});
+  event.set_chain(reindex_->chain_head);
+  reindex_->chain_head = event.chain_after();
+  raw_event = std::move(event.raw_event_);
+
+  reindex_->fd_size += static_cast<int64>(raw_event.size());
+  reindex_->fd_events++;
+  switch (reindex_->encryption_type) {
+    case EncryptionType::None:
+      reindex_->buffer_writer.append(std::move(raw_event));
+      break;
+    case EncryptionType::AesCtr:
+      // encryption happens in place, so the event must not share its buffer with the writer
+      reindex_->buffer_writer.append(raw_event.as_slice());
+      break;
+  }
+}
+
+void Binlog::reindex_flush() {
+  // NB: encryption happens during flush
+  if (reindex_->byte_flow_flag) {
+    reindex_->byte_flow_source.wakeup();
+  }
+  auto r_written = reindex_->fd.flush_write();
+  r_written.ensure();
+  LOG_IF(FATAL, reindex_->fd.need_flush_write()) << "Failed to flush binlog";
 }
 
 string Binlog::debug_get_binlog_data(int64 begin_offset, int64 end_offset) {
@@ -10,6 +10,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
+#include "td/utils/Zstd.h"
 
 namespace td {
 
@@ -35,6 +36,15 @@ Status BinlogEvent::init(BufferSlice &&raw_event, bool check_crc) {
                                     << tag("expected", format::as_hex(crc32_)) << public_to_string());
     }
   }
+  if ((flags_ & Flags::Compressed) != 0) {
+#if TD_HAVE_ZSTD
+    TRY_RESULT(decompressed_data, zstd_decode(data_));
+    decompressed_data_ = std::move(decompressed_data);
+    data_ = decompressed_data_.as_slice();
+#else
+    return Status::Error("Event is compressed, but the library is built without zstd");
+#endif
+  }
   raw_event_ = std::move(raw_event);
   return Status::OK();
 }
@@ -51,7 +61,65 @@ Status BinlogEvent::validate() const {
   return event.init(raw_event_.clone(), true);
 }
 
+uint64 BinlogEvent::next_chain(uint64 prev_chain, uint32 event_crc32) {
+  uint8 buf[12];
+  TlStorerUnsafe storer(buf);
+  storer.store_long(static_cast<int64>(prev_chain));
+  storer.store_int(static_cast<int32>(event_crc32));
+  auto result = crc64(Slice(buf, sizeof(buf)));
+  // 0 is reserved for events written before chaining was introduced
+  return result == 0 ? CHAIN_SEED : result;
+}
+
+void BinlogEvent::set_chain(uint64 chain) {
+  CHECK(!raw_event_.empty());
+  auto slice = raw_event_.as_slice();
+  TlStorerUnsafe extra_storer(slice.ubegin() + EVENT_HEADER_SIZE - 8);
+  extra_storer.store_long(static_cast<int64>(chain));
+  extra_ = chain;
+  crc32_ = ::td::crc32(slice.truncate(size_ - EVENT_TAIL_SIZE));
+  TlStorerUnsafe tail_storer(slice.ubegin() + size_ - EVENT_TAIL_SIZE);
+  tail_storer.store_int(static_cast<int32>(crc32_));
+}
+
+#if TD_HAVE_ZSTD
+static BufferSlice create_raw_from_slice(uint64 id, int32 type, int32 flags, Slice data) {
+  auto raw_event = BufferSlice{data.size() + MIN_EVENT_SIZE};
+
+  TlStorerUnsafe tl_storer(raw_event.as_slice().ubegin());
+  tl_storer.store_int(narrow_cast<int32>(raw_event.size()));
+  tl_storer.store_long(id);
+  tl_storer.store_int(type);
+  tl_storer.store_int(flags);
+  tl_storer.store_long(0);
+
+  CHECK(tl_storer.get_buf() == raw_event.as_slice().ubegin() + EVENT_HEADER_SIZE);
+  tl_storer.store_slice(data);
+
+  CHECK(tl_storer.get_buf() == raw_event.as_slice().uend() - EVENT_TAIL_SIZE);
+  tl_storer.store_int(::td::crc32(raw_event.as_slice().truncate(raw_event.size() - EVENT_TAIL_SIZE)));
+
+  return raw_event;
+}
+#endif
+
 BufferSlice BinlogEvent::create_raw(uint64 id, int32 type, int32 flags, const Storer &storer) {
+  if ((flags & Flags::Compressed) != 0) {
+#if TD_HAVE_ZSTD
+    BufferSlice data(storer.size());
+    storer.store(data.as_slice().ubegin());
+    auto compressed = zstd_encode(data.as_slice());
+    if (compressed.empty() || compressed.size() >= data.size()) {
+      // compression isn't worth it; store the event as usual
+      compressed = std::move(data);
+      flags &= ~Flags::Compressed;
+    }
+    return create_raw_from_slice(id, type, flags, compressed.as_slice());
+#else
+    flags &= ~Flags::Compressed;
+#endif
+  }
+
   auto raw_event = BufferSlice{storer.size() + MIN_EVENT_SIZE};
 
   TlStorerUnsafe tl_storer(raw_event.as_slice().ubegin());
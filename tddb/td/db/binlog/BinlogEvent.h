@@ -60,19 +60,24 @@ struct BinlogEvent {
   uint64 id_;
   int32 type_;  // type can be merged with flags
   int32 flags_;
-  uint64 extra_;
+  uint64 extra_;  // chained checksum of all preceding events; 0 in events written before chaining was introduced
   MutableSlice data_;
   uint32 crc32_;
 
   BufferSlice raw_event_;
+  BufferSlice decompressed_data_;  // storage for data_ of a compressed event
 
   BinlogDebugInfo debug_info_;
 
   enum ServiceTypes { Header = -1, Empty = -2, AesCtrEncryption = -3, NoEncryption = -4 };
-  enum Flags { Rewrite = 1, Partial = 2 };
+  // Compressed events store a zstd frame as payload; create_raw compresses the
+  // payload when the flag is passed, and init transparently decompresses it,
+  // so the flag never leaks to event handlers
+  enum Flags { Rewrite = 1, Partial = 2, Compressed = 4 };
 
   void clear() {
     raw_event_ = BufferSlice();
+    decompressed_data_ = BufferSlice();
   }
   bool empty() const {
     return raw_event_.empty();
@@ -85,6 +90,9 @@ struct BinlogEvent {
   }
 
   BufferSlice data_as_buffer_slice() const {
+    if ((flags_ & Flags::Compressed) != 0) {
+      return decompressed_data_.clone();
+    }
     return raw_event_.from_slice(data_);
   }
 
@@ -101,6 +109,21 @@ struct BinlogEvent {
 
   static BufferSlice create_raw(uint64 id, int32 type, int32 flags, const Storer &storer);
 
+  // The chained checksum makes every event carry a digest of the whole event
+  // sequence before it: extra_ holds the chain value before the event, and the
+  // per-event CRC32 covers it, so a spliced, reordered or refilled tail is
+  // detected even when every event is valid on its own. The value before the
+  // first event of a file is CHAIN_SEED; 0 is reserved for events written
+  // before chaining was introduced.
+  static constexpr uint64 CHAIN_SEED = 1;
+  static uint64 next_chain(uint64 prev_chain, uint32 event_crc32);
+  // chain value after this event
+  uint64 chain_after() const {
+    return next_chain(extra_, crc32_);
+  }
+  // writes the chain value into extra_ of raw_event_ and refreshes the CRC32
+  void set_chain(uint64 chain);
+
   std::string public_to_string() const {
     return PSTRING() << "LogEvent[" << tag("id", format::as_hex(id_)) << tag("type", type_) << tag("flags", flags_)
                      << tag("data", data_.size()) << "]" << debug_info_;
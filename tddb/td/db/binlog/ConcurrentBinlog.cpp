@@ -80,6 +80,9 @@ class BinlogActor : public Actor {
   double wakeup_at_ = 0;
 
   static constexpr double FLUSH_TIMEOUT = 0.001;  // 1ms
+  // group commit window: syncs requested within it are served by one fsync,
+  // and requests arriving while a sync is running join the next window
+  static constexpr double SYNC_TIMEOUT = 0.003;  // 3ms
 
   void wakeup_after(double after) {
     auto now = Time::now_cached();
@@ -124,7 +127,7 @@ class BinlogActor : public Actor {
     }
     if (!force_sync_flag_) {
       force_sync_flag_ = true;
-      wakeup_after(0.003);
+      wakeup_after(SYNC_TIMEOUT);
     }
   }
 
@@ -5,27 +5,191 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/db/binlog/Binlog.h"
+#include "td/db/binlog/BinlogEvent.h"
 
 #include "td/utils/common.h"
 #include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tl_parsers.h"
 
 #include <cstdio>
+#include <cstring>
 #include <map>
+#include <utility>
+
+namespace {
+
+struct EventStat {
+  td::uint64 count = 0;
+  td::uint64 bytes = 0;
+  td::uint64 live_count = 0;
+  td::uint64 live_bytes = 0;
+};
+
+// event types whose payload is BinlogKeyValue<BinlogT>::Event: the default
+// BinlogKeyValue magic and the PMC magics from LogEvent::HandlerType
+static bool is_key_value_type(td::int32 type) {
+  return type == 0x2a280000 || type == 0x4327 || type == 0x1f18;
+}
+
+// group keys by their non-digit prefix, so "user12345" and "user54321" fall
+// into the same key space
+static td::Slice get_key_space(td::Slice key) {
+  auto prefix_size = key.size();
+  while (prefix_size > 0 && td::is_digit(key[prefix_size - 1])) {
+    prefix_size--;
+  }
+  return key.substr(0, prefix_size);
+}
+
+static td::Slice get_key_value_key(const td::BinlogEvent &event) {
+  td::TlParser parser(event.data_);
+  auto key = parser.fetch_string<td::Slice>();
+  parser.fetch_string<td::Slice>();
+  if (parser.get_error() != nullptr) {
+    return td::Slice("<broken>");
+  }
+  return key;
+}
+
+static int dump_stats(const char *path) {
+  std::map<td::int32, EventStat> by_type;
+  std::map<std::pair<td::int32, std::string>, EventStat> by_key_space;
+  EventStat total;
+  td::int64 end_offset = 0;
+  std::vector<std::pair<td::int64, td::uint32>> scanned_events;
+  std::vector<std::pair<td::int64, td::uint32>> live_events;
+
+  td::Binlog binlog;
+  auto status = binlog.init(
+      path,
+      [&](const td::BinlogEvent &event) {
+        auto size = event.raw_event_.size();
+        total.live_count++;
+        total.live_bytes += size;
+        auto &stat = by_type[event.type_];
+        stat.live_count++;
+        stat.live_bytes += size;
+        live_events.emplace_back(event.offset_, td::narrow_cast<td::uint32>(size));
+        if (is_key_value_type(event.type_)) {
+          auto &key_stat = by_key_space[{event.type_, get_key_space(get_key_value_key(event)).str()}];
+          key_stat.live_count++;
+          key_stat.live_bytes += size;
+        }
+      },
+      td::DbKey::empty(), td::DbKey::empty(), -1,
+      [&](const td::BinlogEvent &event) {
+        auto size = event.raw_event_.size();
+        total.count++;
+        total.bytes += size;
+        auto &stat = by_type[event.type_];
+        stat.count++;
+        stat.bytes += size;
+        scanned_events.emplace_back(event.offset_, td::narrow_cast<td::uint32>(size));
+        if (event.offset_ + static_cast<td::int64>(size) > end_offset) {
+          end_offset = event.offset_ + static_cast<td::int64>(size);
+        }
+        if (is_key_value_type(event.type_)) {
+          auto &key_stat = by_key_space[{event.type_, get_key_space(get_key_value_key(event)).str()}];
+          key_stat.count++;
+          key_stat.bytes += size;
+        }
+      });
+  if (status.is_error()) {
+    std::fprintf(stderr, "Failed to load binlog: %s\n", status.error().message().c_str());
+    return 1;
+  }
+
+  // binlog events carry no wall-clock timestamps, so growth is bucketed by
+  // file offset: events are appended in order, which gives the same shape
+  constexpr size_t BUCKET_COUNT = 10;
+  struct Bucket {
+    td::uint64 count = 0;
+    td::uint64 bytes = 0;
+    td::uint64 live_bytes = 0;
+  };
+  std::vector<Bucket> buckets(BUCKET_COUNT);
+  auto bucket_size = end_offset / static_cast<td::int64>(BUCKET_COUNT) + 1;
+  for (auto &it : scanned_events) {
+    auto &bucket = buckets[static_cast<size_t>(it.first / bucket_size)];
+    bucket.count++;
+    bucket.bytes += it.second;
+  }
+  for (auto &it : live_events) {
+    buckets[static_cast<size_t>(it.first / bucket_size)].live_bytes += it.second;
+  }
+
+  auto json = td::json_encode<std::string>(td::json_object([&](auto &o) {
+    o("path", td::Slice(path));
+    o("size", td::JsonLong(end_offset));
+    o("event_count", td::JsonLong(static_cast<td::int64>(total.count)));
+    o("event_bytes", td::JsonLong(static_cast<td::int64>(total.bytes)));
+    o("live_event_count", td::JsonLong(static_cast<td::int64>(total.live_count)));
+    o("live_event_bytes", td::JsonLong(static_cast<td::int64>(total.live_bytes)));
+    o("dead_event_count", td::JsonLong(static_cast<td::int64>(total.count - total.live_count)));
+    o("dead_event_bytes", td::JsonLong(static_cast<td::int64>(total.bytes - total.live_bytes)));
+    o("types", td::json_array([&](auto &a) {
+        for (auto &it : by_type) {
+          a(td::json_object([&](auto &t) {
+            t("type", td::JsonInt(it.first));
+            t("count", td::JsonLong(static_cast<td::int64>(it.second.count)));
+            t("bytes", td::JsonLong(static_cast<td::int64>(it.second.bytes)));
+            t("live_count", td::JsonLong(static_cast<td::int64>(it.second.live_count)));
+            t("live_bytes", td::JsonLong(static_cast<td::int64>(it.second.live_bytes)));
+          }));
+        }
+      }));
+    o("key_spaces", td::json_array([&](auto &a) {
+        for (auto &it : by_key_space) {
+          a(td::json_object([&](auto &k) {
+            k("type", td::JsonInt(it.first.first));
+            k("prefix", td::Slice(it.first.second));
+            k("count", td::JsonLong(static_cast<td::int64>(it.second.count)));
+            k("bytes", td::JsonLong(static_cast<td::int64>(it.second.bytes)));
+            k("live_count", td::JsonLong(static_cast<td::int64>(it.second.live_count)));
+            k("live_bytes", td::JsonLong(static_cast<td::int64>(it.second.live_bytes)));
+          }));
+        }
+      }));
+    o("offset_buckets", td::json_array([&](auto &a) {
+        for (size_t i = 0; i < buckets.size(); i++) {
+          a(td::json_object([&](auto &b) {
+            b("begin", td::JsonLong(static_cast<td::int64>(i) * bucket_size));
+            b("end", td::JsonLong(td::min((static_cast<td::int64>(i) + 1) * bucket_size, end_offset)));
+            b("count", td::JsonLong(static_cast<td::int64>(buckets[i].count)));
+            b("bytes", td::JsonLong(static_cast<td::int64>(buckets[i].bytes)));
+            b("live_bytes", td::JsonLong(static_cast<td::int64>(buckets[i].live_bytes)));
+          }));
+        }
+      }));
+  }));
+  std::printf("%s\n", json.c_str());
+  return 0;
+}
+
+}  // namespace
 
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    std::fprintf(stderr, "Usage: binlog_dump <binlog_file_name>\n");
+  if (argc < 2 || (std::strcmp(argv[1], "--stats") == 0 && argc < 3)) {
+    std::fprintf(stderr, "Usage: binlog_dump [--stats] <binlog_file_name>\n");
     return 1;
   }
 
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+
+  if (std::strcmp(argv[1], "--stats") == 0) {
+    return dump_stats(argv[2]);
+  }
+
   struct Info {
     std::size_t full_size = 0;
     std::size_t compressed_size = 0;
   };
   std::map<td::uint64, Info> info;
 
-  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   td::Binlog binlog;
   binlog
       .init(argv[1],
@@ -12,6 +12,8 @@
 #include "td/utils/logging.h"
 #include "td/utils/Status.h"
 
+#include <algorithm>
+
 namespace td {
 namespace detail {
 class BinlogEventsProcessor {
@@ -31,6 +33,26 @@ class BinlogEventsProcessor {
     }
   }
 
+  // calls callback for live events with id >= from_id until about max_size bytes are processed;
+  // returns the id to continue from, or 0 after the last event
+  template <class CallbackT>
+  uint64 for_each_chunk(uint64 from_id, int64 max_size, CallbackT &&callback) {
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), from_id * 2);
+    int64 size = 0;
+    for (; it != ids_.end(); ++it) {
+      if ((*it & 1) != 0) {
+        continue;
+      }
+      if (size >= max_size) {
+        return *it / 2;
+      }
+      auto &event = events_[it - ids_.begin()];
+      size += static_cast<int64>(event.raw_event_.size());
+      callback(event);
+    }
+    return 0;
+  }
+
   uint64 last_id() const {
     return last_id_;
   }
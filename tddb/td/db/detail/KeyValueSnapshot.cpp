@@ -0,0 +1,119 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/db/detail/KeyValueSnapshot.h"
+
+#include "td/utils/as.h"
+#include "td/utils/buffer.h"
+#include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+#include <algorithm>
+
+namespace td {
+namespace detail {
+
+namespace {
+
+constexpr int32 SNAPSHOT_MAGIC = 0x7e0b553c;
+constexpr int32 SNAPSHOT_VERSION = 1;
+
+// key(4+), value(4+), event_id(8), event_crc32(4), event_size(4)
+constexpr size_t MIN_ENTRY_SIZE = 24;
+
+template <class StorerT>
+void store_snapshot(StorerT &storer, const std::vector<KeyValueSnapshot::Entry> &entries) {
+  storer.store_int(SNAPSHOT_MAGIC);
+  storer.store_int(SNAPSHOT_VERSION);
+  storer.store_long(static_cast<int64>(entries.size()));
+  for (auto &entry : entries) {
+    storer.store_string(entry.key);
+    storer.store_string(entry.value);
+    storer.store_long(static_cast<int64>(entry.event_id));
+    storer.store_int(static_cast<int32>(entry.event_crc32));
+    storer.store_int(static_cast<int32>(entry.event_size));
+  }
+}
+
+}  // namespace
+
+string KeyValueSnapshot::get_path(Slice kv_path) {
+  return PSTRING() << kv_path << ".snapshot";
+}
+
+Status KeyValueSnapshot::write(CSlice path, std::vector<Entry> &&entries) {
+  std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+
+  TlStorerCalcLength calc_length;
+  store_snapshot(calc_length, entries);
+  auto size = calc_length.get_length();
+
+  BufferSlice buffer(size + 4);
+  TlStorerUnsafe storer(buffer.as_slice().ubegin());
+  store_snapshot(storer, entries);
+  CHECK(static_cast<size_t>(storer.get_buf() - buffer.as_slice().ubegin()) == size);
+  as<uint32>(buffer.as_slice().begin() + size) = crc32(buffer.as_slice().substr(0, size));
+
+  auto new_path = PSTRING() << path << ".new";
+  TRY_RESULT(fd, FileFd::open(new_path, FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate));
+  auto data = buffer.as_slice();
+  while (!data.empty()) {
+    TRY_RESULT(written, fd.write(data));
+    data.remove_prefix(written);
+  }
+  TRY_STATUS(fd.sync());
+  fd.close();
+  return rename(new_path, path);
+}
+
+Result<std::vector<KeyValueSnapshot::Entry>> KeyValueSnapshot::read(CSlice path) {
+  TRY_RESULT(buffer, read_file(path));
+  auto data = buffer.as_slice();
+  if (data.size() < 4 + 4 + 8 + 4) {
+    return Status::Error("Snapshot is too small");
+  }
+  auto stored = data.substr(0, data.size() - 4);
+  if (crc32(stored) != as<uint32>(data.end() - 4)) {
+    return Status::Error("Snapshot checksum mismatch");
+  }
+
+  TlParser parser(stored);
+  if (parser.fetch_int() != SNAPSHOT_MAGIC) {
+    return Status::Error("Snapshot magic mismatch");
+  }
+  if (parser.fetch_int() != SNAPSHOT_VERSION) {
+    return Status::Error("Snapshot version mismatch");
+  }
+  auto count = parser.fetch_long();
+  if (count < 0 || static_cast<uint64>(count) > stored.size() / MIN_ENTRY_SIZE) {
+    return Status::Error("Snapshot entry count is invalid");
+  }
+
+  std::vector<Entry> entries(narrow_cast<size_t>(count));
+  for (auto &entry : entries) {
+    entry.key = parser.fetch_string<string>();
+    entry.value = parser.fetch_string<string>();
+    entry.event_id = static_cast<uint64>(parser.fetch_long());
+    entry.event_crc32 = static_cast<uint32>(parser.fetch_int());
+    entry.event_size = static_cast<uint32>(parser.fetch_int());
+  }
+  parser.fetch_end();
+  TRY_STATUS(parser.get_status());
+  return entries;
+}
+
+void KeyValueSnapshot::destroy(CSlice path) {
+  unlink(path).ignore();
+  unlink(PSLICE() << path << ".new").ignore();
+}
+
+}  // namespace detail
+}  // namespace td
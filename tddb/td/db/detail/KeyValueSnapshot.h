@@ -0,0 +1,41 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+namespace detail {
+
+// Compact checksummed image of a BinlogKeyValue map, stored next to the binlog.
+// Each entry remembers the identifier, size and checksum of the log event it was
+// built from, so on startup events still matching the snapshot can be accepted
+// without parsing, and everything else is replayed as usual
+class KeyValueSnapshot {
+ public:
+  struct Entry {
+    string key;
+    string value;
+    uint64 event_id = 0;
+    uint32 event_crc32 = 0;
+    uint32 event_size = 0;
+  };
+
+  static string get_path(Slice kv_path);
+
+  // sorts entries by key and atomically replaces the snapshot at path
+  static Status write(CSlice path, std::vector<Entry> &&entries) TD_WARN_UNUSED_RESULT;
+
+  static Result<std::vector<Entry>> read(CSlice path) TD_WARN_UNUSED_RESULT;
+
+  static void destroy(CSlice path);
+};
+
+}  // namespace detail
+}  // namespace td
@@ -17,31 +17,34 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace td {
 namespace detail {
 
 class GoogleDnsResolver : public Actor {
  public:
-  GoogleDnsResolver(std::string host, bool prefer_ipv6, Promise<IPAddress> promise)
+  GoogleDnsResolver(std::string host, bool prefer_ipv6, Promise<GetHostByNameActor::ResolvedHost> promise)
       : host_(std::move(host)), prefer_ipv6_(prefer_ipv6), promise_(std::move(promise)) {
   }
 
  private:
   std::string host_;
   bool prefer_ipv6_;
-  Promise<IPAddress> promise_;
+  Promise<GetHostByNameActor::ResolvedHost> promise_;
   ActorOwn<Wget> wget_;
   double begin_time_ = 0;
 
   void start_up() override {
     auto r_address = IPAddress::get_ipv4_address(host_);
     if (r_address.is_ok()) {
-      promise_.set_value(r_address.move_as_ok());
+      promise_.set_value({r_address.move_as_ok(), 0});
       return stop();
     }
     r_address = IPAddress::get_ipv6_address(host_);
     if (r_address.is_ok()) {
-      promise_.set_value(r_address.move_as_ok());
+      promise_.set_value({r_address.move_as_ok(), 0});
       return stop();
     }
 
@@ -58,7 +61,7 @@ class GoogleDnsResolver : public Actor {
         SslStream::VerifyPeer::Off);
   }
 
-  static Result<IPAddress> get_ip_address(Result<HttpQueryPtr> r_http_query) {
+  static Result<GetHostByNameActor::ResolvedHost> get_ip_address(Result<HttpQueryPtr> r_http_query) {
     TRY_RESULT(http_query, std::move(r_http_query));
     TRY_RESULT(json_value, json_decode(http_query->content_));
     if (json_value.type() != JsonValue::Type::Object) {
@@ -74,9 +77,10 @@ class GoogleDnsResolver : public Actor {
     }
     auto &answer_0 = array[0].get_object();
     TRY_RESULT(ip_str, get_json_object_string_field(answer_0, "data", false));
+    TRY_RESULT(ttl, get_json_object_int_field(answer_0, "TTL"));
     IPAddress ip;
     TRY_STATUS(ip.init_host_port(ip_str, 0));
-    return ip;
+    return GetHostByNameActor::ResolvedHost{ip, ttl};
   }
 
   void on_result(Result<HttpQueryPtr> r_http_query) {
@@ -84,7 +88,7 @@ class GoogleDnsResolver : public Actor {
     auto result = get_ip_address(std::move(r_http_query));
     VLOG(dns_resolver) << "Init IPv" << (prefer_ipv6_ ? "6" : "4") << " host = " << host_ << " in "
                        << end_time - begin_time_ << " seconds to "
-                       << (result.is_ok() ? (PSLICE() << result.ok()) : CSlice("[invalid]"));
+                       << (result.is_ok() ? (PSLICE() << result.ok().ip) : CSlice("[invalid]"));
     promise_.set_result(std::move(result));
     stop();
   }
@@ -92,14 +96,14 @@ class GoogleDnsResolver : public Actor {
 
 class NativeDnsResolver : public Actor {
  public:
-  NativeDnsResolver(std::string host, bool prefer_ipv6, Promise<IPAddress> promise)
+  NativeDnsResolver(std::string host, bool prefer_ipv6, Promise<GetHostByNameActor::ResolvedHost> promise)
       : host_(std::move(host)), prefer_ipv6_(prefer_ipv6), promise_(std::move(promise)) {
   }
 
  private:
   std::string host_;
   bool prefer_ipv6_;
-  Promise<IPAddress> promise_;
+  Promise<GetHostByNameActor::ResolvedHost> promise_;
 
   void start_up() override {
     IPAddress ip;
@@ -110,7 +114,7 @@ class NativeDnsResolver : public Actor {
     if (status.is_error()) {
       promise_.set_error(std::move(status));
     } else {
-      promise_.set_value(std::move(ip));
+      promise_.set_value({std::move(ip), 0});
     }
     stop();
   }
@@ -141,24 +145,79 @@ void GetHostByNameActor::run(string host, int port, bool prefer_ipv6, Promise<IP
     return promise.set_result(value.get_ip_port(port));
   }
 
+  bool return_stale = value.ip.is_ok() && value.stale_expires_at > begin_time;
+  if (return_stale) {
+    // serve the expired address immediately and revalidate in the background
+    promise.set_result(value.get_ip_port(port));
+  }
+
+  // resolve the other address family in parallel, so a later request for it
+  // doesn't have to wait for DNS
+  prefetch(ascii_host, host, !prefer_ipv6);
+
   auto &query = active_queries_[prefer_ipv6][ascii_host];
-  query.promises.emplace_back(port, std::move(promise));
+  if (!return_stale) {
+    query.promises.emplace_back(port, std::move(promise));
+  }
   if (query.query.empty()) {
-    CHECK(query.promises.size() == 1);
     query.real_host = std::move(host);
     query.begin_time = Time::now();
     run_query(std::move(ascii_host), prefer_ipv6, query);
   }
 }
 
+void GetHostByNameActor::prefetch(const string &ascii_host, const string &real_host, bool prefer_ipv6) {
+  auto &value = cache_[prefer_ipv6].emplace(ascii_host, Value{{}, 0}).first->second;
+  if (value.expires_at > Time::now()) {
+    return;
+  }
+  auto &query = active_queries_[prefer_ipv6][ascii_host];
+  if (!query.query.empty()) {
+    return;
+  }
+  query.real_host = real_host;
+  query.begin_time = Time::now();
+  run_query(ascii_host, prefer_ipv6, query);
+}
+
+vector<GetHostByNameActor::ResolverType> GetHostByNameActor::get_resolver_types() const {
+  auto result = options_.resolver_types;
+  if (result.size() > 1) {
+    auto now = Time::now();
+    auto get_key = [&](ResolverType resolver_type) {
+      auto &stats = resolver_stats_[static_cast<size_t>(resolver_type)];
+      // a resolver with unknown latency is tried first to learn its latency
+      return std::make_pair(stats.failed_until > now, stats.avg_latency);
+    };
+    std::stable_sort(result.begin(), result.end(),
+                     [&](ResolverType lhs, ResolverType rhs) { return get_key(lhs) < get_key(rhs); });
+  }
+  return result;
+}
+
+void GetHostByNameActor::on_resolver_result(ResolverType resolver_type, double latency, bool is_ok) {
+  const double FAILURE_BACKOFF_TIME = 60.0;
+  auto &stats = resolver_stats_[static_cast<size_t>(resolver_type)];
+  if (is_ok) {
+    stats.avg_latency = stats.avg_latency == 0 ? latency : 0.875 * stats.avg_latency + 0.125 * latency;
+    stats.failed_until = 0;
+  } else {
+    stats.failed_until = Time::now() + FAILURE_BACKOFF_TIME;
+  }
+}
+
 void GetHostByNameActor::run_query(std::string host, bool prefer_ipv6, Query &query) {
-  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), host, prefer_ipv6](Result<IPAddress> res) mutable {
+  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), host, prefer_ipv6](Result<ResolvedHost> res) mutable {
     send_closure(actor_id, &GetHostByNameActor::on_query_result, std::move(host), prefer_ipv6, std::move(res));
   });
 
   CHECK(query.query.empty());
-  CHECK(query.pos < options_.resolver_types.size());
-  auto resolver_type = options_.resolver_types[query.pos++];
+  if (query.pos == 0) {
+    query.resolver_types = get_resolver_types();
+  }
+  CHECK(query.pos < query.resolver_types.size());
+  auto resolver_type = query.resolver_types[query.pos++];
+  query.attempt_begin_time = Time::now();
   query.query = [&] {
     switch (resolver_type) {
       case ResolverType::Native:
@@ -174,27 +233,42 @@ void GetHostByNameActor::run_query(std::string host, bool prefer_ipv6, Query &qu
   }();
 }
 
-void GetHostByNameActor::on_query_result(std::string host, bool prefer_ipv6, Result<IPAddress> result) {
+void GetHostByNameActor::on_query_result(std::string host, bool prefer_ipv6, Result<ResolvedHost> result) {
   auto query_it = active_queries_[prefer_ipv6].find(host);
   CHECK(query_it != active_queries_[prefer_ipv6].end());
   auto &query = query_it->second;
-  CHECK(!query.promises.empty());
   CHECK(!query.query.empty());
 
-  if (result.is_error() && query.pos < options_.resolver_types.size()) {
+  CHECK(query.pos >= 1);
+  on_resolver_result(query.resolver_types[query.pos - 1], Time::now() - query.attempt_begin_time, result.is_ok());
+
+  if (result.is_error() && query.pos < query.resolver_types.size()) {
     query.query.reset();
     return run_query(std::move(host), prefer_ipv6, query);
   }
 
   auto end_time = Time::now();
   VLOG(dns_resolver) << "Init host = " << query.real_host << " in total of " << end_time - query.begin_time
-                     << " seconds to " << (result.is_ok() ? (PSLICE() << result.ok()) : CSlice("[invalid]"));
+                     << " seconds to " << (result.is_ok() ? (PSLICE() << result.ok().ip) : CSlice("[invalid]"));
 
   auto promises = std::move(query.promises);
   auto value_it = cache_[prefer_ipv6].find(host);
   CHECK(value_it != cache_[prefer_ipv6].end());
-  auto cache_timeout = result.is_ok() ? options_.ok_timeout : options_.error_timeout;
-  value_it->second = Value{std::move(result), end_time + cache_timeout};
+  if (result.is_ok()) {
+    auto resolved = result.move_as_ok();
+    auto cache_timeout = options_.ok_timeout;
+    if (resolved.ttl > 0 && resolved.ttl < cache_timeout) {
+      cache_timeout = resolved.ttl;
+    }
+    value_it->second =
+        Value{std::move(resolved.ip), end_time + cache_timeout, end_time + cache_timeout + options_.max_stale_timeout};
+  } else if (value_it->second.ip.is_ok() && value_it->second.stale_expires_at > end_time) {
+    // keep serving the previous address while it may still be used;
+    // just delay the next revalidation attempt
+    value_it->second.expires_at = end_time + options_.error_timeout;
+  } else {
+    value_it->second = Value{result.move_as_error(), end_time + options_.error_timeout};
+  }
   active_queries_[prefer_ipv6].erase(query_it);
 
   for (auto &promise : promises) {
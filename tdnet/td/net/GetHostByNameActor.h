@@ -25,13 +25,22 @@ class GetHostByNameActor final : public Actor {
   enum class ResolverType { Native, Google };
 
   struct Options {
-    static constexpr int32 DEFAULT_CACHE_TIME = 60 * 29;       // 29 minutes
-    static constexpr int32 DEFAULT_ERROR_CACHE_TIME = 60 * 5;  // 5 minutes
+    static constexpr int32 DEFAULT_CACHE_TIME = 60 * 29;          // 29 minutes
+    static constexpr int32 DEFAULT_ERROR_CACHE_TIME = 60 * 5;     // 5 minutes
+    static constexpr int32 DEFAULT_MAX_STALE_TIME = 60 * 60 * 24;  // 1 day
 
     vector<ResolverType> resolver_types{ResolverType::Native};
     int32 scheduler_id{-1};
     int32 ok_timeout{DEFAULT_CACHE_TIME};
     int32 error_timeout{DEFAULT_ERROR_CACHE_TIME};
+    // an expired address may still be returned for this long after ok_timeout
+    // while it is revalidated in the background; 0 disables stale results
+    int32 max_stale_timeout{DEFAULT_MAX_STALE_TIME};
+  };
+
+  struct ResolvedHost {
+    IPAddress ip;
+    int32 ttl{0};  // 0 when the resolver doesn't report one
   };
 
   explicit GetHostByNameActor(Options options);
@@ -39,13 +48,15 @@ class GetHostByNameActor final : public Actor {
   void run(std::string host, int port, bool prefer_ipv6, Promise<IPAddress> promise);
 
  private:
-  void on_query_result(std::string host, bool prefer_ipv6, Result<IPAddress> result);
+  void on_query_result(std::string host, bool prefer_ipv6, Result<ResolvedHost> result);
 
   struct Value {
     Result<IPAddress> ip;
     double expires_at;
+    double stale_expires_at;
 
-    Value(Result<IPAddress> ip, double expires_at) : ip(std::move(ip)), expires_at(expires_at) {
+    Value(Result<IPAddress> ip, double expires_at, double stale_expires_at = 0)
+        : ip(std::move(ip)), expires_at(expires_at), stale_expires_at(stale_expires_at) {
     }
 
     Result<IPAddress> get_ip_port(int port) const {
@@ -60,16 +71,30 @@ class GetHostByNameActor final : public Actor {
 
   struct Query {
     ActorOwn<> query;
+    vector<ResolverType> resolver_types;
     size_t pos = 0;
     string real_host;
     double begin_time;
+    double attempt_begin_time;
     std::vector<std::pair<int, Promise<IPAddress>>> promises;
   };
   std::unordered_map<string, Query> active_queries_[2];
 
+  // when several resolver types are configured, they are tried in the order of
+  // observed success latency, so the fastest working resolver is tried first
+  // in networks where plain DNS is blocked or poisoned
+  struct ResolverStats {
+    double avg_latency{0};  // exponentially smoothed latency of successful resolutions; 0 if unknown
+    double failed_until{0};  // the resolver is deprioritized until this time after a failure
+  };
+  ResolverStats resolver_stats_[2];
+
   Options options_;
 
+  vector<ResolverType> get_resolver_types() const;
+  void on_resolver_result(ResolverType resolver_type, double latency, bool is_ok);
   void run_query(std::string host, bool prefer_ipv6, Query &query);
+  void prefetch(const string &ascii_host, const string &real_host, bool prefer_ipv6);
 };
 
 }  // namespace td
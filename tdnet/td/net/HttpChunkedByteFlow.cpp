@@ -17,6 +17,15 @@ namespace td {
 void HttpChunkedByteFlow::loop() {
   bool was_updated = false;
   size_t need_size;
+  // consecutive pieces of the same buffer are merged back into one slice, so
+  // that small chunks don't produce an output node per chunk
+  BufferSlice pending;
+  auto flush_pending = [&] {
+    if (!pending.empty()) {
+      output_.append(std::move(pending));
+      pending = BufferSlice();
+    }
+  };
   while (true) {
     if (state_ == ReadChunkLength) {
       bool ok = find_boundary(input_->clone(), "\r\n", len_);
@@ -50,7 +59,14 @@ void HttpChunkedByteFlow::loop() {
       return finish(Status::Error(PSLICE() << "Too big query " << tag("size", input_->size())));
     }
 
-    output_.append(input_->cut_head(ready));
+    auto chunk = input_->cut_head(ready);
+    while (!chunk.empty()) {
+      auto piece = chunk.read_as_buffer_slice();
+      if (!pending.try_merge_with(piece)) {
+        flush_pending();
+        pending = std::move(piece);
+      }
+    }
     len_ -= ready;
     if (uncommited_size_ >= MIN_UPDATE_SIZE) {
       uncommited_size_ = 0;
@@ -65,12 +81,14 @@ void HttpChunkedByteFlow::loop() {
       input_->advance(2);
       total_size_ += 2;
       if (save_len_ == 0) {
+        flush_pending();
         return finish(Status::OK());
       }
       state_ = ReadChunkLength;
       len_ = 0;
     }
   }
+  flush_pending();
   if (was_updated) {
     on_output_updated();
   }
@@ -20,7 +20,16 @@ void HttpContentLengthByteFlow::loop() {
     set_need_size(need_size);
     return;
   }
-  output_.append(input_->cut_head(ready_size));
+  if (reserve_output_) {
+    // the first prepare_append allocates a chunk for the whole remaining body;
+    // later iterations continue to fill the same chunk in place
+    auto dest = output_.prepare_append(len_);
+    CHECK(dest.size() >= ready_size);
+    input_->advance(ready_size, MutableSlice(dest.data(), ready_size));
+    output_.confirm_append(ready_size);
+  } else {
+    output_.append(input_->cut_head(ready_size));
+  }
   len_ -= ready_size;
   if (len_ == 0) {
     return finish(Status::OK());
@@ -13,13 +13,17 @@ namespace td {
 class HttpContentLengthByteFlow final : public ByteFlowBase {
  public:
   HttpContentLengthByteFlow() = default;
-  explicit HttpContentLengthByteFlow(size_t len) : len_(len) {
+  explicit HttpContentLengthByteFlow(size_t len, bool reserve_output = false)
+      : len_(len), reserve_output_(reserve_output) {
   }
   void loop() override;
 
  private:
   static constexpr size_t MIN_UPDATE_SIZE = 1 << 14;
   size_t len_ = 0;
+  // write the whole body into a single chunk reserved upfront, so the sink can take
+  // the content as one contiguous buffer without a final gathering copy
+  bool reserve_output_ = false;
 };
 
 }  // namespace td
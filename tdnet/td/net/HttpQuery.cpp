@@ -13,8 +13,9 @@
 namespace td {
 
 Slice HttpQuery::get_header(Slice key) const {
-  auto it = std::find_if(headers_.begin(), headers_.end(),
-                         [&key](const std::pair<MutableSlice, MutableSlice> &s) { return s.first == key; });
+  auto it = std::find_if(headers_.begin(), headers_.end(), [&key](const std::pair<MutableSlice, MutableSlice> &s) {
+    return equals_lowercased(s.first, key);
+  });
   return it == headers_.end() ? Slice() : it->second;
 }
 
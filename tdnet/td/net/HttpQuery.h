@@ -33,6 +33,7 @@ class HttpQuery {
   std::vector<HttpFile> files_;
   MutableSlice content_;
 
+  // key must be given in lower case; stored header names keep their original case
   Slice get_header(Slice key) const;
 
   MutableSlice get_arg(Slice key) const;
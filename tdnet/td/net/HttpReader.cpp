@@ -93,7 +93,11 @@ Result<size_t> HttpReader::read_next(HttpQuery *query) {
         flow_source_ = ByteFlowSource(input_);
         ByteFlowInterface *source = &flow_source_;
         if (transfer_encoding_.empty()) {
-          content_length_flow_ = HttpContentLengthByteFlow(content_length_);
+          // when the body is received unmodified and will be kept in memory, reserve space
+          // for all of it upfront; the sink then takes it as a single contiguous buffer
+          bool reserve_output = content_encoding_.empty() && content_length_ <= max_post_size_ &&
+                                content_length_ <= MAX_CONTENT_SIZE;
+          content_length_flow_ = HttpContentLengthByteFlow(content_length_, reserve_output);
           *source >> content_length_flow_;
           source = &content_length_flow_;
         } else if (transfer_encoding_ == "chunked") {
@@ -312,9 +316,8 @@ Result<bool> HttpReader::parse_multipart_form_data() {
 
             header_name = trim(header_name);
             header_value = trim(header_value);
-            to_lower_inplace(header_name);
 
-            if (header_name == "content-disposition") {
+            if (equals_lowercased(header_name, "content-disposition")) {
               if (header_value.substr(0, 10) != "form-data;") {
                 return Status::Error(400, "Bad Request: expected form-data content disposition");
               }
@@ -355,7 +358,7 @@ Result<bool> HttpReader::parse_multipart_form_data() {
                   // ignore unknown parts of header
                 }
               }
-            } else if (header_name == "content-type") {
+            } else if (equals_lowercased(header_name, "content-type")) {
               field_content_type_ = header_value.str();
             } else {
               // ignore unknown header
@@ -516,26 +519,27 @@ Result<size_t> HttpReader::split_header() {
 void HttpReader::process_header(MutableSlice header_name, MutableSlice header_value) {
   header_name = trim(header_name);
   header_value = trim(header_value);  // TODO need to remove "\r\n" from value
-  to_lower_inplace(header_name);
+  // header names are compared case-insensitively in place and stay borrowed
+  // from the connection buffer without being rewritten
   LOG(DEBUG) << "Process header [" << header_name << "=>" << header_value << "]";
   query_->headers_.emplace_back(header_name, header_value);
   // TODO: check if protocol is HTTP/1.1
   query_->keep_alive_ = true;
-  if (header_name == "content-length") {
+  if (equals_lowercased(header_name, "content-length")) {
     content_length_ = to_integer<size_t>(header_value);
-  } else if (header_name == "connection") {
+  } else if (equals_lowercased(header_name, "connection")) {
     to_lower_inplace(header_value);
     if (header_value == "close") {
       query_->keep_alive_ = false;
     }
-  } else if (header_name == "content-type") {
+  } else if (equals_lowercased(header_name, "content-type")) {
     content_type_ = header_value;
     content_type_lowercased_ = header_value.str();
     to_lower_inplace(content_type_lowercased_);
-  } else if (header_name == "content-encoding") {
+  } else if (equals_lowercased(header_name, "content-encoding")) {
     to_lower_inplace(header_value);
     content_encoding_ = header_value;
-  } else if (header_name == "transfer-encoding") {
+  } else if (equals_lowercased(header_name, "transfer-encoding")) {
     to_lower_inplace(header_value);
     transfer_encoding_ = header_value;
   }
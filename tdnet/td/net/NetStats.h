@@ -106,24 +106,33 @@ class NetStats {
     }
 
    private:
+    // each cell is written only by its own scheduler and padded to a separate cache
+    // line, so byte accounting on the socket hot path is an uncontended increment
     struct LocalNetStats {
       double last_update = 0;
       uint64 unsync_size = 0;
       std::atomic<uint64> read_size{0};
       std::atomic<uint64> write_size{0};
+      char pad[TD_CONCURRENCY_PAD - sizeof(double) - sizeof(uint64) - 2 * sizeof(std::atomic<uint64>)];
     };
     SchedulerLocalStorage<LocalNetStats> local_net_stats_;
     unique_ptr<Callback> callback_;
 
+    // single-writer cells need no atomic read-modify-write, only atomic stores
+    // visible to the aggregating reader
+    static void add(std::atomic<uint64> &counter, uint64 size) {
+      counter.store(counter.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+    }
+
     void on_read(uint64 size) final {
       auto &stats = local_net_stats_.get();
-      stats.read_size.fetch_add(size, std::memory_order_relaxed);
+      add(stats.read_size, size);
 
       on_change(stats, size);
     }
     void on_write(uint64 size) final {
       auto &stats = local_net_stats_.get();
-      stats.write_size.fetch_add(size, std::memory_order_relaxed);
+      add(stats.write_size, size);
 
       on_change(stats, size);
     }
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <map>
 #include <mutex>
+#include <utility>
 
 #if TD_PORT_WINDOWS
 #include <wincrypt.h>
@@ -178,6 +179,45 @@ void do_ssl_shutdown(SSL *ssl_handle) {
   openssl_clear_errors("After SSL_shutdown");
 }
 
+std::mutex &get_ssl_session_cache_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<string, SSL_SESSION *> &get_ssl_session_cache() {
+  static auto *cache = new std::map<string, SSL_SESSION *>();
+  return *cache;
+}
+
+constexpr size_t MAX_SSL_SESSION_CACHE_SIZE = 100;
+
+// takes ownership of the session reference
+void store_ssl_session(const string &host, SSL_SESSION *session) {
+  std::lock_guard<std::mutex> lock(get_ssl_session_cache_mutex());
+  auto &cache = get_ssl_session_cache();
+  auto it = cache.find(host);
+  if (it != cache.end()) {
+    SSL_SESSION_free(it->second);
+    it->second = session;
+    return;
+  }
+  if (cache.size() >= MAX_SSL_SESSION_CACHE_SIZE) {
+    SSL_SESSION_free(cache.begin()->second);
+    cache.erase(cache.begin());
+  }
+  cache.emplace(host, session);
+}
+
+void try_resume_ssl_session(const string &host, SSL *ssl_handle) {
+  std::lock_guard<std::mutex> lock(get_ssl_session_cache_mutex());
+  auto &cache = get_ssl_session_cache();
+  auto it = cache.find(host);
+  if (it != cache.end()) {
+    // SSL_set_session takes its own reference; the cached one is kept
+    SSL_set_session(ssl_handle, it->second);
+  }
+}
+
 }  // namespace
 
 class SslStreamImpl {
@@ -189,26 +229,20 @@ class SslStreamImpl {
       return;
     }
     CHECK(ssl_handle_ && ssl_ctx_ && bio_);
+    if (SSL_is_init_finished(ssl_handle_)) {
+      auto *session = SSL_get1_session(ssl_handle_);
+      if (session != nullptr) {
+        store_ssl_session(host_, session);
+      }
+    }
     do_ssl_shutdown(ssl_handle_);
     SSL_free(ssl_handle_);
     ssl_handle_ = nullptr;
-    SSL_CTX_free(ssl_ctx_);
+    // ssl_ctx_ is shared through the process-wide cache and is never freed
     ssl_ctx_ = nullptr;
   }
-  Status init(CSlice host, CSlice cert_file, VerifyPeer verify_peer) {
-    static bool init_openssl = [] {
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-      return OPENSSL_init_ssl(0, nullptr) != 0;
-#else
-      OpenSSL_add_all_algorithms();
-      SSL_load_error_strings();
-      return OpenSSL_add_ssl_algorithms() != 0;
-#endif
-    }();
-    CHECK(init_openssl);
-
-    openssl_clear_errors("Before SslFd::init");
 
+  static Result<SSL_CTX *> create_ssl_ctx(CSlice cert_file, VerifyPeer verify_peer) {
     auto ssl_method =
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
         TLS_client_method();
@@ -236,7 +270,6 @@ class SslStreamImpl {
 
     if (cert_file.empty()) {
 #if TD_PORT_WINDOWS
-      // TODO thread-local SSL_CTX cache
       LOG(DEBUG) << "Begin to load system store";
       auto flags = CERT_STORE_OPEN_EXISTING_FLAG | CERT_STORE_READONLY_FLAG | CERT_SYSTEM_STORE_CURRENT_USER;
       HCERTSTORE system_store =
@@ -306,6 +339,43 @@ class SslStreamImpl {
       return create_openssl_error(-9, PSLICE() << "Failed to set cipher list \"" << cipher_list << '"');
     }
 
+    ssl_ctx_guard.dismiss();
+    return ssl_ctx;
+  }
+
+  static Result<SSL_CTX *> get_ssl_ctx(CSlice cert_file, VerifyPeer verify_peer) {
+    // contexts are shared by all streams with the same settings and are never
+    // freed, so reconnects don't rebuild the certificate store every time
+    static std::mutex ssl_ctx_cache_mutex;
+    static auto *ssl_ctx_cache = new std::map<std::pair<string, bool>, SSL_CTX *>();
+
+    auto key = std::make_pair(cert_file.str(), verify_peer == VerifyPeer::On);
+    std::lock_guard<std::mutex> lock(ssl_ctx_cache_mutex);
+    auto it = ssl_ctx_cache->find(key);
+    if (it != ssl_ctx_cache->end()) {
+      return it->second;
+    }
+    TRY_RESULT(ssl_ctx, create_ssl_ctx(cert_file, verify_peer));
+    ssl_ctx_cache->emplace(std::move(key), ssl_ctx);
+    return ssl_ctx;
+  }
+
+  Status init(CSlice host, CSlice cert_file, VerifyPeer verify_peer) {
+    static bool init_openssl = [] {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+      return OPENSSL_init_ssl(0, nullptr) != 0;
+#else
+      OpenSSL_add_all_algorithms();
+      SSL_load_error_strings();
+      return OpenSSL_add_ssl_algorithms() != 0;
+#endif
+    }();
+    CHECK(init_openssl);
+
+    openssl_clear_errors("Before SslFd::init");
+
+    TRY_RESULT(ssl_ctx, get_ssl_ctx(cert_file, verify_peer));
+
     auto ssl_handle = SSL_new(ssl_ctx);
     if (ssl_handle == nullptr) {
       return create_openssl_error(-13, "Failed to create an SSL handle");
@@ -333,9 +403,10 @@ class SslStreamImpl {
     auto host_str = host.str();
     SSL_set_tlsext_host_name(ssl_handle, MutableCSlice(host_str).begin());
 #endif
+    host_ = host.str();
+    try_resume_ssl_session(host_, ssl_handle);
     SSL_set_connect_state(ssl_handle);
 
-    ssl_ctx_guard.dismiss();
     ssl_handle_guard.dismiss();
 
     ssl_handle_ = ssl_handle;
@@ -364,6 +435,7 @@ class SslStreamImpl {
   SSL *ssl_handle_ = nullptr;
   SSL_CTX *ssl_ctx_ = nullptr;
   BIO *bio_ = nullptr;
+  string host_;
 
   friend class SslReadByteFlow;
   friend class SslWriteByteFlow;
@@ -393,7 +465,10 @@ class SslStreamImpl {
     void loop() override {
       bool was_append = false;
       while (true) {
-        auto to_read = output_.prepare_append();
+        // reserve space for everything that may be decrypted from the already
+        // buffered ciphertext, so a burst of records is written into one large
+        // reservation instead of one default-sized chunk per record
+        auto to_read = output_.prepare_append(input_->size());
         auto r_size = stream_->read(to_read);
         if (r_size.is_error()) {
           return finish(r_size.move_as_error());
@@ -94,6 +94,7 @@ static void write_function_fetch(tl_outputer &out, const std::string &parser_nam
 
   out.append(w.gen_fetch_function_begin(parser_name, class_name, class_name, 0, vars, parser_type));
   out.append(w.gen_vars(t, NULL, vars));
+  out.append(w.gen_fetch_fields_begin(t, parser_type));
   int field_num = 0;
   for (std::size_t i = 0; i < t->args.size(); i++) {
     std::string field_fetch = w.gen_field_fetch(field_num, t->args[i], vars, false, parser_type);
@@ -179,6 +180,7 @@ static void write_constructor_fetch(tl_outputer &out, const std::string &parser_
                                         static_cast<int>(result_type->children.size()), vars, parser_type));
   out.append(w.gen_vars(t, result_type, vars));
   out.append(w.gen_uni(result_type, vars, true));
+  out.append(w.gen_fetch_fields_begin(t, parser_type));
   int field_num = 0;
   for (std::size_t i = 0; i < t->args.size(); i++) {
     std::string field_fetch = w.gen_field_fetch(field_num, t->args[i], vars, is_flat, parser_type);
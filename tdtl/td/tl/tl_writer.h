@@ -104,6 +104,9 @@ class TL_writer {
   virtual std::string gen_uni(const tl_tree_type *result_type, std::vector<var_description> &vars,
                               bool check_negative) const = 0;
   virtual std::string gen_constructor_id_store(std::int32_t id, int storer_type) const = 0;
+  virtual std::string gen_fetch_fields_begin(const tl_combinator *t, int parser_type) const {
+    return "";
+  }
   virtual std::string gen_field_fetch(int field_num, const arg &a, std::vector<var_description> &vars, bool flat,
                                       int parser_type) const = 0;
   virtual std::string gen_field_store(const arg &a, std::vector<var_description> &vars, bool flat,
@@ -0,0 +1,49 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/AllocationWatcher.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <atomic>
+
+namespace td {
+
+namespace {
+std::atomic<bool> counter_is_active{false};
+TD_THREAD_LOCAL uint64 thread_alloc_count;
+}  // namespace
+
+void on_thread_alloc() {
+  if (!counter_is_active.load(std::memory_order_relaxed)) {
+    counter_is_active.store(true, std::memory_order_relaxed);
+  }
+  thread_alloc_count++;
+}
+
+bool AllocationWatcher::is_active() {
+  return counter_is_active.load(std::memory_order_relaxed);
+}
+
+AllocationWatcher::AllocationWatcher() : start_count_(thread_alloc_count), max_count_(NO_LIMIT) {
+}
+
+AllocationWatcher::AllocationWatcher(uint64 max_count) : start_count_(thread_alloc_count), max_count_(max_count) {
+}
+
+AllocationWatcher::~AllocationWatcher() {
+  if (max_count_ != NO_LIMIT && is_active()) {
+    auto allocation_count = count();
+    LOG_DCHECK(allocation_count <= max_count_)
+        << "Performed " << allocation_count << " heap allocations, expected at most " << max_count_;
+  }
+}
+
+uint64 AllocationWatcher::count() const {
+  return thread_alloc_count - start_count_;
+}
+
+}  // namespace td
@@ -0,0 +1,57 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+#include <limits>
+
+namespace td {
+
+// Counts heap allocations made by the current thread, so hot paths can assert that
+// their steady state doesn't allocate more than expected and accidental copies of
+// payloads become check failures instead of silent slowdowns.
+//
+// The counter is fed by the allocator instrumentation (the memprof malloc override);
+// in builds without it the counter stays at zero, is_active() returns false, and all
+// watchers and assertions are no-ops.
+class AllocationWatcher {
+ public:
+  AllocationWatcher();
+
+  // asserts in debug builds that at most max_count allocations happen on the current
+  // thread before the watcher is destroyed
+  explicit AllocationWatcher(uint64 max_count);
+
+  AllocationWatcher(const AllocationWatcher &) = delete;
+  AllocationWatcher &operator=(const AllocationWatcher &) = delete;
+
+  ~AllocationWatcher();
+
+  // the number of heap allocations made by the current thread since construction
+  uint64 count() const;
+
+  // true when an allocator instrumentation is feeding the counter
+  static bool is_active();
+
+ private:
+  static constexpr uint64 NO_LIMIT = std::numeric_limits<uint64>::max();
+
+  uint64 start_count_;
+  uint64 max_count_;
+};
+
+// called by the allocator instrumentation on every allocation; must not allocate
+void on_thread_alloc();
+
+// Asserts in debug builds that the enclosing scope performs at most max_count heap
+// allocations on the current thread. Does nothing without allocator instrumentation.
+#define TD_ASSERT_MAX_ALLOCATIONS(max_count) \
+  ::td::AllocationWatcher TD_CONCAT(allocation_watcher_, __LINE__)(max_count)
+
+}  // namespace td
@@ -0,0 +1,142 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/AsyncFileLog.h"
+
+#include "td/utils/StringBuilder.h"
+
+#include <utility>
+
+namespace td {
+
+Status AsyncFileLog::init(string path, int64 rotate_threshold, size_t buffer_size) {
+#if TD_THREAD_UNSUPPORTED
+  return file_log_.init(std::move(path), rotate_threshold);
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (is_running_) {
+    // the flusher is guaranteed to not touch file_log_ while the buffer is empty
+    // and the lock is held
+    do_flush(lock);
+  }
+  TRY_STATUS(file_log_.init(std::move(path), rotate_threshold));
+  buffer_size_ = buffer_size;
+  pending_.reserve(buffer_size_);
+  if (!is_running_) {
+    is_running_ = true;
+    flush_thread_ = thread([this] { run_flusher(); });
+  }
+  return Status::OK();
+#endif
+}
+
+AsyncFileLog::~AsyncFileLog() {
+#if !TD_THREAD_UNSUPPORTED
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!is_running_) {
+      return;
+    }
+    is_closing_ = true;
+    cond_.notify_all();
+  }
+  flush_thread_.join();
+#endif
+}
+
+vector<string> AsyncFileLog::get_file_paths() {
+  return file_log_.get_file_paths();
+}
+
+void AsyncFileLog::append(CSlice cslice, int log_level) {
+#if TD_THREAD_UNSUPPORTED
+  file_log_.append(cslice, log_level);
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!is_running_) {
+    // not initialized yet; write synchronously as a plain FileLog would
+    lock.unlock();
+    return file_log_.append(cslice, log_level);
+  }
+  if (pending_.size() + cslice.size() > buffer_size_) {
+    dropped_count_++;
+  } else {
+    pending_.append(cslice.data(), cslice.size());
+  }
+  cond_.notify_all();
+  if (log_level == VERBOSITY_NAME(FATAL)) {
+    // make sure the message reaches the disk before the process dies
+    do_flush(lock);
+    lock.unlock();
+    process_fatal_error(cslice);
+  }
+#endif
+}
+
+void AsyncFileLog::rotate() {
+#if TD_THREAD_UNSUPPORTED
+  file_log_.rotate();
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!is_running_) {
+    lock.unlock();
+    return file_log_.rotate();
+  }
+  need_rotate_ = true;
+  cond_.notify_all();
+#endif
+}
+
+#if !TD_THREAD_UNSUPPORTED
+void AsyncFileLog::run_flusher() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [&] { return is_closing_ || need_rotate_ || !pending_.empty(); });
+    do_flush(lock);
+    if (is_closing_) {
+      return;
+    }
+  }
+}
+
+// must be called with lock held; the lock is released for the duration of disk writes
+// and is held again on return
+void AsyncFileLog::do_flush(std::unique_lock<std::mutex> &lock) {
+  while (true) {
+    // if some other thread is writing, wait for it to finish; it may have
+    // already picked up our messages
+    cond_.wait(lock, [&] { return !is_flushing_; });
+    if (!need_rotate_ && pending_.empty()) {
+      return;
+    }
+    string batch;
+    batch.reserve(buffer_size_);
+    std::swap(batch, pending_);
+    auto dropped_count = dropped_count_;
+    dropped_count_ = 0;
+    auto need_rotate = need_rotate_;
+    need_rotate_ = false;
+    is_flushing_ = true;
+
+    lock.unlock();
+    if (need_rotate) {
+      file_log_.rotate();
+    }
+    if (!batch.empty()) {
+      file_log_.append(batch, -1);
+    }
+    if (dropped_count != 0) {
+      file_log_.append(PSLICE() << "Dropped " << dropped_count << " log messages on buffer overflow\n", -1);
+    }
+    lock.lock();
+
+    is_flushing_ = false;
+    cond_.notify_all();
+  }
+}
+#endif
+
+}  // namespace td
@@ -0,0 +1,66 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FileLog.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace td {
+
+// Writes logs to a file from a dedicated thread. append only copies the message into an
+// in-memory buffer, so a slow disk never stalls the logging thread; the flusher thread
+// swaps the buffer for an empty one and writes the whole batch through an ordinary
+// FileLog without holding the lock. If producers outrun the disk, messages are dropped
+// and the number of dropped messages is logged instead
+class AsyncFileLog : public LogInterface {
+  static constexpr int64 DEFAULT_ROTATE_THRESHOLD = 10 * (1 << 20);
+  static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+ public:
+  AsyncFileLog() = default;
+  AsyncFileLog(const AsyncFileLog &) = delete;
+  AsyncFileLog &operator=(const AsyncFileLog &) = delete;
+  ~AsyncFileLog();
+
+  Status init(string path, int64 rotate_threshold = DEFAULT_ROTATE_THRESHOLD,
+              size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+  vector<string> get_file_paths() override;
+
+  void append(CSlice cslice, int log_level) override;
+
+  void rotate() override;
+
+ private:
+  FileLog file_log_;
+#if !TD_THREAD_UNSUPPORTED
+  // all fields below are protected by mutex_; pending_ is swapped out by the flusher,
+  // which then writes the batch without the lock
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  string pending_;
+  size_t buffer_size_ = 0;
+  uint64 dropped_count_ = 0;
+  bool need_rotate_ = false;
+  bool is_flushing_ = false;
+  bool is_closing_ = false;
+  bool is_running_ = false;
+  thread flush_thread_;
+
+  void run_flusher();
+  void do_flush(std::unique_lock<std::mutex> &lock);
+#endif
+};
+
+}  // namespace td
@@ -42,6 +42,29 @@ BigNumContext &BigNumContext::operator=(BigNumContext &&other) = default;
 
 BigNumContext::~BigNumContext() = default;
 
+class BigNumModContext::Impl {
+ public:
+  BN_MONT_CTX *mont_ctx;
+
+  Impl() : mont_ctx(BN_MONT_CTX_new()) {
+    LOG_IF(FATAL, mont_ctx == nullptr);
+  }
+  Impl(const Impl &other) = delete;
+  Impl &operator=(const Impl &other) = delete;
+  Impl(Impl &&other) = delete;
+  Impl &operator=(Impl &&other) = delete;
+  ~Impl() {
+    BN_MONT_CTX_free(mont_ctx);
+  }
+};
+
+BigNumModContext::BigNumModContext() = default;
+
+BigNumModContext::BigNumModContext(BigNumModContext &&other) = default;
+BigNumModContext &BigNumModContext::operator=(BigNumModContext &&other) = default;
+
+BigNumModContext::~BigNumModContext() = default;
+
 class BigNum::Impl {
  public:
   BIGNUM *big_num;
@@ -60,6 +83,14 @@ class BigNum::Impl {
   }
 };
 
+BigNumModContext BigNumModContext::create(const BigNum &m, BigNumContext &context) {
+  BigNumModContext result;
+  result.impl_ = make_unique<Impl>();
+  int res = BN_MONT_CTX_set(result.impl_->mont_ctx, m.impl_->big_num, context.impl_->big_num_context);
+  LOG_IF(FATAL, res != 1);
+  return result;
+}
+
 BigNum::BigNum() : impl_(make_unique<Impl>()) {
 }
 
@@ -292,6 +323,14 @@ void BigNum::mod_exp(BigNum &r, const BigNum &a, const BigNum &p, const BigNum &
   LOG_IF(FATAL, result != 1);
 }
 
+void BigNum::mod_exp(BigNum &r, const BigNum &a, const BigNum &p, const BigNum &m, BigNumContext &context,
+                     BigNumModContext &mod_context) {
+  CHECK(mod_context.is_inited());
+  int result = BN_mod_exp_mont(r.impl_->big_num, a.impl_->big_num, p.impl_->big_num, m.impl_->big_num,
+                               context.impl_->big_num_context, mod_context.impl_->mont_ctx);
+  LOG_IF(FATAL, result != 1);
+}
+
 void BigNum::gcd(BigNum &r, BigNum &a, BigNum &b, BigNumContext &context) {
   int result = BN_gcd(r.impl_->big_num, a.impl_->big_num, b.impl_->big_num, context.impl_->big_num_context);
   LOG_IF(FATAL, result != 1);
@@ -16,6 +16,8 @@
 
 namespace td {
 
+class BigNum;
+
 class BigNumContext {
  public:
   BigNumContext();
@@ -25,6 +27,31 @@ class BigNumContext {
   BigNumContext &operator=(BigNumContext &&other);
   ~BigNumContext();
 
+ private:
+  class Impl;
+  unique_ptr<Impl> impl_;
+
+  friend class BigNum;
+  friend class BigNumModContext;
+};
+
+// Caches the Montgomery exponentiation setup for a fixed odd modulus, so repeated
+// mod_exp calls with the same modulus skip the per-call precomputation
+class BigNumModContext {
+ public:
+  BigNumModContext();
+  BigNumModContext(const BigNumModContext &other) = delete;
+  BigNumModContext &operator=(const BigNumModContext &other) = delete;
+  BigNumModContext(BigNumModContext &&other);
+  BigNumModContext &operator=(BigNumModContext &&other);
+  ~BigNumModContext();
+
+  static BigNumModContext create(const BigNum &m, BigNumContext &context);
+
+  bool is_inited() const {
+    return impl_ != nullptr;
+  }
+
  private:
   class Impl;
   unique_ptr<Impl> impl_;
@@ -108,6 +135,10 @@ class BigNum {
 
   static void mod_exp(BigNum &r, const BigNum &a, const BigNum &p, const BigNum &m, BigNumContext &context);
 
+  // m must be the modulus mod_context was created for
+  static void mod_exp(BigNum &r, const BigNum &a, const BigNum &p, const BigNum &m, BigNumContext &context,
+                      BigNumModContext &mod_context);
+
   static void gcd(BigNum &r, BigNum &a, BigNum &b, BigNumContext &context);
 
   static int compare(const BigNum &a, const BigNum &b);
@@ -117,6 +148,8 @@ class BigNum {
   unique_ptr<Impl> impl_;
 
   explicit BigNum(unique_ptr<Impl> &&impl);
+
+  friend class BigNumModContext;
 };
 
 StringBuilder &operator<<(StringBuilder &sb, const BigNum &bn);
@@ -11,7 +11,9 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/IoSlice.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 #include <limits>
@@ -44,10 +46,16 @@ class BufferedFdBase : public FdT {
   void set_output_reader(ChainBufferReader *write) {
     write_ = write;
   }
+  // hint for the size of the next allocated input buffer node; lets a reader
+  // expecting a big message receive it into one contiguous node
+  void set_read_alloc_hint(size_t hint) {
+    read_alloc_hint_ = hint;
+  }
 
  private:
   ChainBufferWriter *read_ = nullptr;
   ChainBufferReader *write_ = nullptr;
+  size_t read_alloc_hint_ = 0;
 };
 
 template <class FdT>
@@ -91,7 +99,7 @@ Result<size_t> BufferedFdBase<FdT>::flush_read(size_t max_read) {
   CHECK(read_);
   size_t result = 0;
   while (::td::can_read(*this) && max_read) {
-    MutableSlice slice = read_->prepare_append().truncate(max_read);
+    MutableSlice slice = read_->prepare_append(read_alloc_hint_).truncate(max_read);
     TRY_RESULT(x, FdT::read(slice));
     slice.truncate(x);
     read_->confirm_append(x);
@@ -107,9 +115,24 @@ Result<size_t> BufferedFdBase<FdT>::flush_write() {
   // TODO: sync on demand
   write_->sync_with_writer();
   while (!write_->empty() && ::td::can_write(*this)) {
-    Slice slice = write_->prepare_read();
-    TRY_RESULT(x, FdT::write(slice));
-    write_->confirm_read(x);
+    // gather pending chain nodes into one vectored write
+    constexpr size_t MAX_WRITE_IO_SLICE_COUNT = 16;
+    IoSlice io_slices[MAX_WRITE_IO_SLICE_COUNT];
+    size_t io_slice_count = 0;
+    auto it = write_->clone();
+    while (io_slice_count < MAX_WRITE_IO_SLICE_COUNT) {
+      Slice slice = it.prepare_read();
+      if (slice.empty()) {
+        break;
+      }
+      io_slices[io_slice_count++] = as_io_slice(slice);
+      it.confirm_read(slice.size());
+    }
+    if (io_slice_count == 0) {
+      break;
+    }
+    TRY_RESULT(x, FdT::writev(Span<IoSlice>(io_slices, io_slice_count)));
+    write_->advance(x);
     result += x;
   }
   return result;
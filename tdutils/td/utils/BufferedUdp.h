@@ -123,6 +123,18 @@ class BufferedUdp : public UdpSocketFd {
     return input_.pop();
   }
 
+  // appends all datagrams currently available, draining the socket with
+  // batched recvmmsg calls into the preallocated reader buffers
+  Status receive_batch(std::vector<UdpMessage> &messages) {
+    while (can_read(*this)) {
+      TRY_STATUS(flush_read_once());
+    }
+    while (!input_.empty()) {
+      messages.push_back(input_.pop());
+    }
+    return Status::OK();
+  }
+
   void send(UdpMessage message) {
     output_.push(std::move(message));
   }
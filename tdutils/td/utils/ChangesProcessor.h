@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/VectorQueue.h"
 
 #include <utility>
 
@@ -19,43 +20,34 @@ class ChangesProcessor {
   using Id = uint64;
 
   void clear() {
-    offset_ += data_array_.size();
-    ready_i_ = 0;
-    data_array_.clear();
+    offset_ += data_queue_.size();
+    data_queue_ = {};
   }
 
   template <class FromDataT>
   Id add(FromDataT &&data) {
-    auto res = offset_ + data_array_.size();
-    data_array_.emplace_back(std::forward<DataT>(data), false);
+    auto res = offset_ + data_queue_.size();
+    data_queue_.push(std::make_pair(std::forward<FromDataT>(data), false));
     return static_cast<Id>(res);
   }
 
   template <class F>
   void finish(Id token, F &&func) {
     size_t pos = static_cast<size_t>(token) - offset_;
-    if (pos >= data_array_.size()) {
+    if (pos >= data_queue_.size()) {
       return;
     }
-    data_array_[pos].second = true;
-    while (ready_i_ < data_array_.size() && data_array_[ready_i_].second == true) {
-      func(std::move(data_array_[ready_i_].first));
-      ready_i_++;
+    data_queue_.data()[pos].second = true;
+    while (!data_queue_.empty() && data_queue_.front().second) {
+      func(std::move(data_queue_.front().first));
+      data_queue_.pop();
+      offset_++;
     }
-    try_compactify();
   }
 
  private:
   size_t offset_ = 1;
-  size_t ready_i_ = 0;
-  std::vector<std::pair<DataT, bool>> data_array_;
-  void try_compactify() {
-    if (ready_i_ > 5 && ready_i_ * 2 > data_array_.size()) {
-      data_array_.erase(data_array_.begin(), data_array_.begin() + ready_i_);
-      offset_ += ready_i_;
-      ready_i_ = 0;
-    }
-  }
+  VectorQueue<std::pair<DataT, bool>> data_queue_;
 };
 
 }  // namespace td
@@ -0,0 +1,159 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace td {
+
+// In-memory log for debugging under full load. Unlike MemoryLog, every thread
+// appends to its own chunk, which is registered in a global table on the first
+// append, so the fast path touches no shared cache lines and verbosity can be
+// raised in production without making threads contend. dump() stitches the
+// chunks back together by the timestamp stored in each record header.
+//
+// Records never wrap around a chunk boundary, and dump() may run concurrently
+// with appends, in which case records being overwritten can come out garbled.
+template <int chunk_size = 64 * (1 << 10), int max_thread_count = 256>
+class ChunkedMemoryLog : public LogInterface {
+  static constexpr size_t MAX_OUTPUT_SIZE = chunk_size / 16 < (8 << 10) ? chunk_size / 16 : (8 << 10);
+  static constexpr size_t MAGIC_SIZE = 32;
+
+ public:
+  ChunkedMemoryLog() = default;
+  ChunkedMemoryLog(const ChunkedMemoryLog &) = delete;
+  ChunkedMemoryLog &operator=(const ChunkedMemoryLog &) = delete;
+  ~ChunkedMemoryLog() override {
+    for (auto &chunk : chunks_) {
+      delete chunk.load(std::memory_order_acquire);
+    }
+  }
+
+  void append(CSlice new_slice, int log_level) override {
+    auto *chunk = get_thread_chunk();
+
+    Slice slice = new_slice;
+    slice.truncate(MAX_OUTPUT_SIZE);
+    while (!slice.empty() && slice.back() == '\n') {
+      slice.remove_suffix(1);
+    }
+    size_t slice_size = slice.size();
+    CHECK(slice_size * 3 < chunk_size);
+    size_t pad_size = ((slice_size + 15) & ~15) - slice_size;
+    uint32 total_size = static_cast<uint32>(MAGIC_SIZE + slice_size + pad_size);
+
+    // the chunk is written only by the owning thread; the atomic is needed
+    // for visibility of the position in dump() and costs no read-modify-write
+    uint32 start_pos = chunk->pos.load(std::memory_order_relaxed);
+    if (start_pos + total_size > chunk_size) {
+      // erase stale records in the tail, so dump() doesn't see them twice
+      std::memset(&chunk->buffer[start_pos], ' ', chunk_size - start_pos);
+      start_pos = 0;
+    }
+
+    char *ptr = &chunk->buffer[start_pos];
+    std::memcpy(ptr + MAGIC_SIZE, slice.data(), slice_size);
+    std::memset(ptr + MAGIC_SIZE + slice_size, ' ', pad_size);
+    size_t printed = std::snprintf(ptr + 1, MAGIC_SIZE - 1, "LOG:%018.6f %4d: ", Time::now(), get_thread_id());
+    CHECK(printed == MAGIC_SIZE - 3);
+    ptr[MAGIC_SIZE - 2] = ' ';
+    ptr[MAGIC_SIZE - 1] = ' ';
+    // terminate the record, so a partially overwritten successor can't
+    // attach its tail to this one; the byte is the next record's header
+    if (start_pos + total_size < chunk_size) {
+      chunk->buffer[start_pos + total_size] = '\n';
+    }
+    ptr[0] = '\n';
+    chunk->pos.store(start_pos + total_size, std::memory_order_release);
+
+    if (log_level == VERBOSITY_NAME(FATAL)) {
+      process_fatal_error(new_slice);
+    }
+  }
+
+  void rotate() override {
+  }
+
+  // merges records from all registered chunks in timestamp order
+  string dump() const {
+    vector<std::pair<double, string>> records;
+    for (auto &chunk_ptr : chunks_) {
+      auto *chunk = chunk_ptr.load(std::memory_order_acquire);
+      if (chunk == nullptr) {
+        continue;
+      }
+      Slice buffer(chunk->buffer, chunk_size);
+      for (size_t pos = 0; pos + 1 + MAGIC_SIZE <= buffer.size(); pos++) {
+        if (buffer[pos] != '\n') {
+          continue;
+        }
+        auto record = buffer.substr(pos + 1);
+        if (record.substr(0, 4) != "LOG:") {
+          continue;
+        }
+        auto timestamp = to_double(record.substr(4, 18));
+        auto end = record.find('\n');
+        if (end != static_cast<size_t>(-1)) {
+          record.truncate(end);
+        }
+        if (record.size() < MAGIC_SIZE - 1) {
+          // the record is being overwritten concurrently
+          continue;
+        }
+        record.remove_prefix(MAGIC_SIZE - 1);
+        while (!record.empty() && record.back() == ' ') {
+          record.remove_suffix(1);
+        }
+        records.emplace_back(timestamp, record.str());
+      }
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    string result;
+    for (auto &record : records) {
+      result += record.second;
+      result += '\n';
+    }
+    return result;
+  }
+
+ private:
+  struct Chunk {
+    std::atomic<uint32> pos{0};
+    char buffer[chunk_size];
+    Chunk() {
+      std::memset(buffer, ' ', sizeof(buffer));
+    }
+  };
+
+  std::atomic<Chunk *> chunks_[max_thread_count] = {};
+
+  Chunk *get_thread_chunk() {
+    auto thread_id = get_thread_id();
+    CHECK(0 <= thread_id && thread_id < max_thread_count);
+    // the slot is written only by this thread
+    auto *chunk = chunks_[thread_id].load(std::memory_order_relaxed);
+    if (unlikely(chunk == nullptr)) {
+      chunk = new Chunk();
+      chunks_[thread_id].store(chunk, std::memory_order_release);
+    }
+    return chunk;
+  }
+};
+
+}  // namespace td
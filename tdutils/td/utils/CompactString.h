@@ -0,0 +1,116 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <cstring>
+
+namespace td {
+
+// An immutable string of 24 bytes with guaranteed small-string optimization:
+// up to 23 bytes are stored inline, longer strings are a pointer and a size on
+// the heap with no capacity field. Made for tables with millions of short
+// keys, where the allocation and the capacity bookkeeping of a std::string
+// per key are pure overhead. The string can only be assigned as a whole;
+// for reading convert it to a Slice.
+class CompactString {
+ public:
+  CompactString() {
+    small_[INLINE_CAPACITY] = 0;
+  }
+  explicit CompactString(Slice slice) {
+    init(slice);
+  }
+  CompactString(const CompactString &other) {
+    init(other.as_slice());
+  }
+  CompactString &operator=(const CompactString &other) {
+    if (this != &other) {
+      destroy();
+      init(other.as_slice());
+    }
+    return *this;
+  }
+  CompactString(CompactString &&other) noexcept {
+    std::memcpy(small_, other.small_, sizeof(small_));
+    other.small_[INLINE_CAPACITY] = 0;
+  }
+  CompactString &operator=(CompactString &&other) noexcept {
+    if (this != &other) {
+      destroy();
+      std::memcpy(small_, other.small_, sizeof(small_));
+      other.small_[INLINE_CAPACITY] = 0;
+    }
+    return *this;
+  }
+  ~CompactString() {
+    destroy();
+  }
+
+  Slice as_slice() const {
+    auto tag = static_cast<unsigned char>(small_[INLINE_CAPACITY]);
+    if (tag == BIG_TAG) {
+      return Slice(big_.data_, big_.size_);
+    }
+    return Slice(small_, tag);
+  }
+  operator Slice() const {
+    return as_slice();
+  }
+
+  size_t size() const {
+    return as_slice().size();
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+  string str() const {
+    return as_slice().str();
+  }
+
+ private:
+  static constexpr size_t INLINE_CAPACITY = 23;
+  static constexpr unsigned char BIG_TAG = 0xFF;
+
+  struct BigString {
+    char *data_;
+    size_t size_;
+  };
+  union {
+    BigString big_;
+    // the last byte holds the inline size, or BIG_TAG for heap strings
+    char small_[INLINE_CAPACITY + 1];
+  };
+
+  void init(Slice slice) {
+    if (slice.size() <= INLINE_CAPACITY) {
+      std::memcpy(small_, slice.data(), slice.size());
+      small_[INLINE_CAPACITY] = static_cast<char>(slice.size());
+    } else {
+      big_.data_ = new char[slice.size()];
+      std::memcpy(big_.data_, slice.data(), slice.size());
+      big_.size_ = slice.size();
+      small_[INLINE_CAPACITY] = static_cast<char>(BIG_TAG);
+    }
+  }
+  void destroy() {
+    if (static_cast<unsigned char>(small_[INLINE_CAPACITY]) == BIG_TAG) {
+      delete[] big_.data_;
+    }
+  }
+};
+
+inline bool operator==(const CompactString &a, const CompactString &b) {
+  return a.as_slice() == b.as_slice();
+}
+inline bool operator!=(const CompactString &a, const CompactString &b) {
+  return !(a == b);
+}
+
+}  // namespace td
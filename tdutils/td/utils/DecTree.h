@@ -134,6 +134,40 @@ class DecTree {
     }
   }
 
+  static size_t get_rank(const unique_ptr<Node> &Tree, const KeyType &key) {
+    if (Tree == nullptr) {
+      return 0;
+    }
+    auto s = (Tree->left_ != nullptr) ? Tree->left_->size_ : 0;
+    if (Compare()(key, Tree->key_)) {
+      return get_rank(Tree->left_, key);
+    } else if (Compare()(Tree->key_, key)) {
+      return s + 1 + get_rank(Tree->right_, key);
+    } else {
+      return s;
+    }
+  }
+
+  static unique_ptr<Node> build_node(std::pair<KeyType, ValueType> *nodes, size_t size) {
+    if (size == 0) {
+      return nullptr;
+    }
+    auto mid = size / 2;
+    auto T = create_node(std::move(nodes[mid].first), std::move(nodes[mid].second), td::Random::fast_uint32());
+    T->left_ = build_node(nodes, mid);
+    T->right_ = build_node(nodes + mid + 1, size - mid - 1);
+    // restore the heap property on priorities, so later inserts and merges
+    // still rebalance correctly
+    if (T->left_ != nullptr && T->left_->y_ > T->y_) {
+      T->y_ = T->left_->y_;
+    }
+    if (T->right_ != nullptr && T->right_->y_ > T->y_) {
+      T->y_ = T->right_->y_;
+    }
+    T->relax();
+    return T;
+  }
+
   static std::pair<unique_ptr<Node>, unique_ptr<Node>> split_node(unique_ptr<Node> Tree, const KeyType &key) {
     if (Tree == nullptr) {
       return {nullptr, nullptr};
@@ -208,6 +242,32 @@ class DecTree {
   bool exists(const KeyType &key) const {
     return get_node(root_, key) != nullptr;
   }
+  // idx-th value in key order, 0-based
+  ValueType *get_by_idx(size_t idx) {
+    CHECK(idx < size());
+    return get_node_by_idx(root_, idx);
+  }
+  const ValueType *get_by_idx(size_t idx) const {
+    CHECK(idx < size());
+    return get_node_by_idx(root_, idx);
+  }
+  // number of keys smaller than the given one; the key itself needn't be in the tree
+  size_t get_rank(const KeyType &key) const {
+    return get_rank(root_, key);
+  }
+  // number of keys in [from, to)
+  size_t count_in_range(const KeyType &from, const KeyType &to) const {
+    auto l = get_rank(from);
+    auto r = get_rank(to);
+    return r > l ? r - l : 0;
+  }
+  // nodes must be sorted by key and contain no duplicates; O(size) instead of
+  // inserting the elements one by one
+  static DecTree build_from_sorted(vector<std::pair<KeyType, ValueType>> nodes) {
+    DecTree res;
+    res.root_ = build_node(nodes.data(), nodes.size());
+    return res;
+  }
 };
 
 }  // namespace td
@@ -9,36 +9,74 @@
 #include "td/utils/common.h"
 #include "td/utils/misc.h"
 
-#include <map>
-#include <tuple>
+#include <deque>
+#include <functional>
 
 namespace td {
 
-template <class ValueT>
+// Interns values: add returns the same dense int32 key for equal values, and
+// get resolves a key back in O(1). Lookups go through an open-addressing hash
+// index with cached hashes, so re-registering an already known value costs one
+// hash and a short probe sequence instead of a tree walk with full value
+// comparisons. Values are stored in a deque, therefore references returned by
+// get stay valid after any number of later adds.
+template <class ValueT, class HashT = std::hash<ValueT>>
 class Enumerator {
  public:
   using Key = int32;
 
   Key add(ValueT v) {
-    int32 next_id = narrow_cast<int32>(arr_.size() + 1);
-    bool was_inserted;
-    decltype(map_.begin()) it;
-    std::tie(it, was_inserted) = map_.emplace(std::move(v), next_id);
-    if (was_inserted) {
-      arr_.push_back(&it->first);
+    try_grow();
+    auto hash = HashT()(v);
+    auto bucket = calc_bucket(hash);
+    while (true) {
+      auto &key = buckets_[bucket];
+      if (key == 0) {
+        key = narrow_cast<Key>(values_.size() + 1);
+        hashes_.push_back(hash);
+        values_.push_back(std::move(v));
+        return key;
+      }
+      auto pos = static_cast<size_t>(key - 1);
+      if (hashes_[pos] == hash && values_[pos] == v) {
+        return key;
+      }
+      bucket = next_bucket(bucket);
     }
-    return it->second;
   }
 
   const ValueT &get(Key key) const {
     auto pos = static_cast<size_t>(key - 1);
-    CHECK(pos < arr_.size());
-    return *arr_[pos];
+    CHECK(pos < values_.size());
+    return values_[pos];
   }
 
  private:
-  std::map<ValueT, int32> map_;
-  std::vector<const ValueT *> arr_;
+  std::deque<ValueT> values_;
+  vector<std::size_t> hashes_;  // cached hashes of values_, reused on probes and rehashes
+  vector<Key> buckets_;         // keys into values_; 0 means an empty bucket
+
+  size_t calc_bucket(std::size_t hash) const {
+    return hash & (buckets_.size() - 1);
+  }
+  size_t next_bucket(size_t bucket) const {
+    return (bucket + 1) & (buckets_.size() - 1);
+  }
+
+  void try_grow() {
+    // keep the load factor below 60%, so probe sequences stay short
+    if ((values_.size() + 1) * 5 < buckets_.size() * 3) {
+      return;
+    }
+    buckets_.assign(max(static_cast<size_t>(8), buckets_.size() * 2), 0);
+    for (size_t pos = 0; pos < values_.size(); pos++) {
+      auto bucket = calc_bucket(hashes_[pos]);
+      while (buckets_[bucket] != 0) {
+        bucket = next_bucket(bucket);
+      }
+      buckets_[bucket] = narrow_cast<Key>(pos + 1);
+    }
+  }
 };
 
 }  // namespace td
@@ -0,0 +1,159 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <array>
+#include <atomic>
+
+namespace td {
+
+// Epoch-based reclamation with the same interface as HazardPointers, so lock-free
+// structures can choose the scheme per instantiation.
+//
+// Unlike a hazard pointer, protect() doesn't publish the protected pointer; it only pins
+// the thread at the current global epoch. While a thread stays pinned, further protect()
+// calls are plain loads, so read-heavy workloads skip the store-load fence per access.
+// The cost is coarser reclamation: a single pinned thread delays deletion of everything
+// retired since its epoch, so critical sections must be kept short.
+template <class T, int MaxPointersN = 1>
+class EpochBasedReclamation {
+ public:
+  explicit EpochBasedReclamation(size_t threads_n) : threads_(threads_n) {
+  }
+  EpochBasedReclamation(const EpochBasedReclamation &other) = delete;
+  EpochBasedReclamation &operator=(const EpochBasedReclamation &other) = delete;
+  EpochBasedReclamation(EpochBasedReclamation &&other) = delete;
+  EpochBasedReclamation &operator=(EpochBasedReclamation &&other) = delete;
+
+  class Holder {
+   public:
+    T *protect(std::atomic<T *> &to_protect) {
+      return parent_->protect(thread_id_, pos_, to_protect);
+    }
+    Holder(const Holder &other) = delete;
+    Holder &operator=(const Holder &other) = delete;
+    Holder(Holder &&other) = default;  // TODO
+    Holder &operator=(Holder &&other) = delete;
+    ~Holder() {
+      clear();
+    }
+    void clear() {
+      parent_->clear(thread_id_, pos_);
+    }
+
+   private:
+    friend class EpochBasedReclamation;
+    Holder(EpochBasedReclamation *parent, size_t thread_id, size_t pos)
+        : parent_(parent), thread_id_(thread_id), pos_(pos) {
+    }
+    EpochBasedReclamation *parent_;
+    size_t thread_id_;
+    size_t pos_;
+  };
+
+  Holder get_holder(size_t thread_id, size_t pos) {
+    return Holder(this, thread_id, pos);
+  }
+
+  void retire(size_t thread_id, T *ptr = nullptr) {
+    CHECK(thread_id < threads_.size());
+    auto &data = threads_[thread_id];
+    if (ptr) {
+      data.to_delete.push_back(RetiredPtr{global_epoch_.load(std::memory_order_relaxed), unique_ptr<T>(ptr)});
+    }
+    try_advance_global_epoch();
+    auto epoch = global_epoch_.load(std::memory_order_acquire);
+    for (auto it = data.to_delete.begin(); it != data.to_delete.end();) {
+      // threads may be pinned at epoch - 1, but nothing retired before epoch - 1 is reachable
+      if (it->epoch + 2 <= epoch) {
+        it->ptr.reset();
+        it = data.to_delete.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  T *protect(size_t thread_id, size_t pos, std::atomic<T *> &ptr) {
+    auto &data = get_thread_data(thread_id);
+    if (data.pinned_n == 0) {
+      auto epoch = global_epoch_.load(std::memory_order_relaxed);
+      while (true) {
+        // the sequentially consistent store-load pair is paid only on the first protect
+        data.epoch.store(epoch * 2 + 1);
+        auto new_epoch = global_epoch_.load();
+        if (new_epoch == epoch) {
+          break;
+        }
+        epoch = new_epoch;
+      }
+    }
+    if (!data.is_pinned[pos]) {
+      data.is_pinned[pos] = true;
+      data.pinned_n++;
+    }
+    return ptr.load(std::memory_order_acquire);
+  }
+  void clear(size_t thread_id, size_t pos) {
+    auto &data = get_thread_data(thread_id);
+    if (data.is_pinned[pos]) {
+      data.is_pinned[pos] = false;
+      if (--data.pinned_n == 0) {
+        data.epoch.store(data.epoch.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+      }
+    }
+  }
+
+  size_t to_delete_size_unsafe() const {
+    size_t res = 0;
+    for (auto &thread : threads_) {
+      res += thread.to_delete.size();
+    }
+    return res;
+  }
+
+ private:
+  struct RetiredPtr {
+    uint64 epoch;
+    unique_ptr<T> ptr;
+  };
+  struct ThreadData {
+    // epoch * 2 + 1 while the thread is pinned, an even value otherwise
+    std::atomic<uint64> epoch{0};
+    char pad[TD_CONCURRENCY_PAD - sizeof(std::atomic<uint64>)];
+
+    std::array<bool, MaxPointersN> is_pinned{};
+    int pinned_n = 0;
+    std::vector<RetiredPtr> to_delete;
+    char pad2[TD_CONCURRENCY_PAD - sizeof(std::array<bool, MaxPointersN>) - sizeof(int) -
+              sizeof(std::vector<RetiredPtr>)];
+  };
+  std::atomic<uint64> global_epoch_{0};
+  char pad[TD_CONCURRENCY_PAD - sizeof(std::atomic<uint64>)];
+  std::vector<ThreadData> threads_;
+  char pad2[TD_CONCURRENCY_PAD - sizeof(std::vector<ThreadData>)];
+
+  void try_advance_global_epoch() {
+    auto epoch = global_epoch_.load();
+    for (auto &data : threads_) {
+      auto thread_epoch = data.epoch.load();
+      if ((thread_epoch & 1) != 0 && thread_epoch / 2 != epoch) {
+        return;
+      }
+    }
+    global_epoch_.compare_exchange_strong(epoch, epoch + 1);
+  }
+
+  ThreadData &get_thread_data(size_t thread_id) {
+    CHECK(thread_id < threads_.size());
+    return threads_[thread_id];
+  }
+};
+
+}  // namespace td
@@ -0,0 +1,312 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+#include <functional>
+#include <utility>
+
+namespace td {
+
+// An open-addressing hash map with linear probing, a drop-in replacement for std::unordered_map
+// in hot lookup tables. All nodes are stored in one contiguous array, so a lookup touches one
+// cache line instead of chasing a bucket list, and there is no per-node allocation overhead.
+//
+// Restrictions compared to std::unordered_map:
+// - the default-constructed key is reserved as the empty marker and can't be inserted;
+// - any insert may rehash the table, invalidating all iterators and references;
+// - erase invalidates all iterators; to erase while iterating use remove_if.
+template <class KeyT, class ValueT, class HashT = std::hash<KeyT>, class EqT = std::equal_to<KeyT>>
+class FlatHashMap {
+ public:
+  using key_type = KeyT;
+  using mapped_type = ValueT;
+  using value_type = std::pair<KeyT, ValueT>;
+
+  class iterator {
+   public:
+    iterator() = default;
+    value_type &operator*() const {
+      return *it_;
+    }
+    value_type *operator->() const {
+      return it_;
+    }
+    iterator &operator++() {
+      ++it_;
+      skip_empty();
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return it_ == other.it_;
+    }
+    bool operator!=(const iterator &other) const {
+      return it_ != other.it_;
+    }
+
+   private:
+    friend class FlatHashMap;
+    iterator(value_type *it, value_type *end) : it_(it), end_(end) {
+      skip_empty();
+    }
+    void skip_empty() {
+      while (it_ != end_ && is_key_empty(it_->first)) {
+        ++it_;
+      }
+    }
+    value_type *it_ = nullptr;
+    value_type *end_ = nullptr;
+  };
+
+  class const_iterator {
+   public:
+    const_iterator() = default;
+    const value_type &operator*() const {
+      return *it_;
+    }
+    const value_type *operator->() const {
+      return it_;
+    }
+    const_iterator &operator++() {
+      ++it_;
+      skip_empty();
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const {
+      return it_ == other.it_;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return it_ != other.it_;
+    }
+
+   private:
+    friend class FlatHashMap;
+    const_iterator(const value_type *it, const value_type *end) : it_(it), end_(end) {
+      skip_empty();
+    }
+    void skip_empty() {
+      while (it_ != end_ && is_key_empty(it_->first)) {
+        ++it_;
+      }
+    }
+    const value_type *it_ = nullptr;
+    const value_type *end_ = nullptr;
+  };
+
+  iterator begin() {
+    return iterator(nodes_begin(), nodes_end());
+  }
+  iterator end() {
+    return iterator(nodes_end(), nodes_end());
+  }
+  const_iterator begin() const {
+    return const_iterator(nodes_begin(), nodes_end());
+  }
+  const_iterator end() const {
+    return const_iterator(nodes_end(), nodes_end());
+  }
+
+  size_t size() const {
+    return used_;
+  }
+  bool empty() const {
+    return used_ == 0;
+  }
+
+  void clear() {
+    nodes_.clear();
+    used_ = 0;
+  }
+
+  // lookups are templated, so keys stored as owning strings can be searched
+  // by a Slice without constructing a temporary, provided HashT and EqT
+  // accept both types
+  template <class KeyU>
+  iterator find(const KeyU &key) {
+    auto *node = find_node(key);
+    return node == nullptr ? end() : iterator(node, nodes_end());
+  }
+  template <class KeyU>
+  const_iterator find(const KeyU &key) const {
+    const auto *node = find_node(key);
+    return node == nullptr ? end() : const_iterator(node, nodes_end());
+  }
+
+  template <class KeyU>
+  size_t count(const KeyU &key) const {
+    return find_node(key) == nullptr ? 0 : 1;
+  }
+
+  std::pair<iterator, bool> emplace(KeyT key, ValueT value) {
+    CHECK(!is_key_empty(key));
+    try_grow();
+    auto bucket = calc_bucket(key);
+    while (true) {
+      auto &node = nodes_[bucket];
+      if (is_key_empty(node.first)) {
+        node.first = std::move(key);
+        node.second = std::move(value);
+        used_++;
+        return {iterator(&node, nodes_end()), true};
+      }
+      if (EqT()(node.first, key)) {
+        return {iterator(&node, nodes_end()), false};
+      }
+      bucket = next_bucket(bucket);
+    }
+  }
+
+  std::pair<iterator, bool> insert(value_type node) {
+    return emplace(std::move(node.first), std::move(node.second));
+  }
+
+  ValueT &operator[](const KeyT &key) {
+    CHECK(!is_key_empty(key));
+    try_grow();
+    auto bucket = calc_bucket(key);
+    while (true) {
+      auto &node = nodes_[bucket];
+      if (is_key_empty(node.first)) {
+        node.first = key;
+        used_++;
+        return node.second;
+      }
+      if (EqT()(node.first, key)) {
+        return node.second;
+      }
+      bucket = next_bucket(bucket);
+    }
+  }
+
+  template <class KeyU>
+  size_t erase(const KeyU &key) {
+    auto *node = find_node(key);
+    if (node == nullptr) {
+      return 0;
+    }
+    erase_at(static_cast<size_t>(node - nodes_begin()));
+    return 1;
+  }
+
+  void erase(iterator it) {
+    CHECK(it != end());
+    erase_at(static_cast<size_t>(it.it_ - nodes_begin()));
+  }
+
+  // erases all entries for which func returns true; unlike erase, it may be safely
+  // used to filter the map, because shifted nodes are rechecked in their new slots
+  template <class FuncT>
+  void remove_if(FuncT &&func) {
+    size_t i = 0;
+    while (i < nodes_.size()) {
+      if (!is_key_empty(nodes_[i].first) && func(nodes_[i])) {
+        erase_at(i);
+      } else {
+        i++;
+      }
+    }
+  }
+
+ private:
+  vector<value_type> nodes_;
+  size_t used_ = 0;
+
+  template <class KeyU>
+  static bool is_key_empty(const KeyU &key) {
+    return key == KeyU();
+  }
+
+  value_type *nodes_begin() {
+    return nodes_.data();
+  }
+  value_type *nodes_end() {
+    return nodes_.data() + nodes_.size();
+  }
+  const value_type *nodes_begin() const {
+    return nodes_.data();
+  }
+  const value_type *nodes_end() const {
+    return nodes_.data() + nodes_.size();
+  }
+
+  size_t bucket_mask() const {
+    return nodes_.size() - 1;
+  }
+  template <class KeyU>
+  size_t calc_bucket(const KeyU &key) const {
+    return HashT()(key) & bucket_mask();
+  }
+  size_t next_bucket(size_t bucket) const {
+    return (bucket + 1) & bucket_mask();
+  }
+
+  template <class KeyU>
+  const value_type *find_node(const KeyU &key) const {
+    if (used_ == 0 || is_key_empty(key)) {
+      return nullptr;
+    }
+    auto bucket = calc_bucket(key);
+    while (true) {
+      auto &node = nodes_[bucket];
+      if (is_key_empty(node.first)) {
+        return nullptr;
+      }
+      if (EqT()(node.first, key)) {
+        return &node;
+      }
+      bucket = next_bucket(bucket);
+    }
+  }
+  template <class KeyU>
+  value_type *find_node(const KeyU &key) {
+    return const_cast<value_type *>(static_cast<const FlatHashMap *>(this)->find_node(key));
+  }
+
+  void try_grow() {
+    // keep the load factor below 60%, so probe sequences stay short
+    if ((used_ + 1) * 5 < nodes_.size() * 3) {
+      return;
+    }
+    vector<value_type> old_nodes(max(static_cast<size_t>(8), nodes_.size() * 2));
+    std::swap(nodes_, old_nodes);
+    for (auto &node : old_nodes) {
+      if (is_key_empty(node.first)) {
+        continue;
+      }
+      auto bucket = calc_bucket(node.first);
+      while (!is_key_empty(nodes_[bucket].first)) {
+        bucket = next_bucket(bucket);
+      }
+      nodes_[bucket] = std::move(node);
+    }
+  }
+
+  void erase_at(size_t empty_i) {
+    nodes_[empty_i] = value_type();
+    used_--;
+
+    // backward-shift deletion: move nodes whose probe sequence passes through
+    // the freed slot, so lookups never meet a premature empty slot
+    auto i = empty_i;
+    while (true) {
+      i = next_bucket(i);
+      if (is_key_empty(nodes_[i].first)) {
+        break;
+      }
+      auto ideal_i = calc_bucket(nodes_[i].first);
+      if (((i - ideal_i) & bucket_mask()) >= ((i - empty_i) & bucket_mask())) {
+        nodes_[empty_i] = std::move(nodes_[i]);
+        nodes_[i] = value_type();
+        empty_i = i;
+      }
+    }
+  }
+};
+
+}  // namespace td
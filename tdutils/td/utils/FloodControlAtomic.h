@@ -0,0 +1,80 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <atomic>
+
+namespace td {
+
+// Token bucket shared between threads: a limit global to all sessions, for
+// example per-datacenter connection attempts, can be enforced with a single
+// fetch_sub on the consuming path instead of routing every decision through a
+// coordinating actor. Counts like FloodControlBucket: no more than count
+// events per duration as a sustained rate, with bursts up to count events.
+//
+// The fast path is lock-free; refills clamp the bucket with a CAS loop that
+// only runs when the bucket is already full, so contention on it is rare.
+class FloodControlAtomic {
+ public:
+  FloodControlAtomic(int32 duration, int32 count) : duration_(duration), count_(count) {
+    tokens_.store(max_tokens(), std::memory_order_relaxed);
+  }
+  FloodControlAtomic(const FloodControlAtomic &) = delete;
+  FloodControlAtomic &operator=(const FloodControlAtomic &) = delete;
+
+  // consumes the event unconditionally, like the other flood controls, and
+  // returns the time when the next event will be within the limit; callers
+  // check get_wakeup_at() against now before producing an event
+  int32 add_event(int32 now) {
+    refill(now);
+    auto tokens = tokens_.fetch_sub(duration_, std::memory_order_relaxed) - duration_;
+    if (tokens < duration_) {
+      auto needed = duration_ - tokens;
+      relax_wakeup_at(now + static_cast<int32>((needed + count_ - 1) / count_));
+    }
+    return get_wakeup_at();
+  }
+
+  int32 get_wakeup_at() const {
+    return wakeup_at_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const int32 duration_;
+  const int32 count_;
+  std::atomic<int64> tokens_{0};  // scaled by duration_, may go negative as debt
+  std::atomic<int32> updated_at_{0};
+  std::atomic<int32> wakeup_at_{0};
+
+  int64 max_tokens() const {
+    return static_cast<int64>(duration_) * count_;
+  }
+
+  void refill(int32 now) {
+    auto prev = updated_at_.load(std::memory_order_relaxed);
+    while (now > prev) {
+      if (updated_at_.compare_exchange_weak(prev, now, std::memory_order_relaxed)) {
+        tokens_.fetch_add(static_cast<int64>(now - prev) * count_, std::memory_order_relaxed);
+        auto tokens = tokens_.load(std::memory_order_relaxed);
+        while (tokens > max_tokens() &&
+               !tokens_.compare_exchange_weak(tokens, max_tokens(), std::memory_order_relaxed)) {
+        }
+        return;
+      }
+    }
+  }
+
+  void relax_wakeup_at(int32 wakeup_at) {
+    auto prev = wakeup_at_.load(std::memory_order_relaxed);
+    while (wakeup_at > prev && !wakeup_at_.compare_exchange_weak(prev, wakeup_at, std::memory_order_relaxed)) {
+    }
+  }
+};
+
+}  // namespace td
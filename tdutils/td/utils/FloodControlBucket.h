@@ -0,0 +1,77 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// Token-bucket flood control with the interface of FloodControlStrict, but
+// O(1) add_event and fixed-size state per limit, so thousands of instances
+// can be kept without per-event timestamp vectors. A limit of count events
+// per duration becomes a bucket of count tokens refilled at count/duration
+// tokens per second; the sustained rate and the burst size match
+// FloodControlStrict, but after a full burst the next event is allowed as
+// soon as one token is refilled instead of when the oldest event leaves the
+// window.
+class FloodControlBucket {
+ public:
+  int32 add_event(int32 now) {
+    for (auto &limit : limits_) {
+      limit.refill(now);
+      // the event is consumed even when the bucket is empty: like
+      // FloodControlStrict, the limiter only reports the wakeup time and
+      // lets forced events accumulate as debt
+      limit.tokens_ -= limit.duration_;
+      if (limit.tokens_ < limit.duration_) {
+        auto needed = limit.duration_ - limit.tokens_;
+        auto delay = static_cast<int32>((needed + limit.count_ - 1) / limit.count_);
+        wakeup_at_ = max(wakeup_at_, now + delay);
+      }
+    }
+    return wakeup_at_;
+  }
+
+  // no more than count events in each duration
+  void add_limit(int32 duration, int32 count) {
+    limits_.push_back(Limit{duration, count, static_cast<int64>(duration) * count, 0});
+  }
+
+  int32 get_wakeup_at() const {
+    return wakeup_at_;
+  }
+
+  void clear_events() {
+    for (auto &limit : limits_) {
+      limit.tokens_ = static_cast<int64>(limit.duration_) * limit.count_;
+      limit.updated_at_ = 0;
+    }
+    wakeup_at_ = 0;
+  }
+
+ private:
+  struct Limit {
+    int32 duration_;
+    int32 count_;
+    int64 tokens_;  // scaled by duration_, so refills need no fractions
+    int32 updated_at_;
+
+    void refill(int32 now) {
+      if (now <= updated_at_) {
+        return;
+      }
+      auto max_tokens = static_cast<int64>(duration_) * count_;
+      tokens_ = min(tokens_ + static_cast<int64>(now - updated_at_) * count_, max_tokens);
+      updated_at_ = now;
+    }
+  };
+
+  int32 wakeup_at_ = 0;
+  vector<Limit> limits_;
+};
+
+}  // namespace td
@@ -8,6 +8,8 @@
 
 #include "td/utils/common.h"
 
+#include <utility>
+
 namespace td {
 
 struct HeapNode {
@@ -27,19 +29,19 @@ template <class KeyT, int K = 4>
 class KHeap {
  public:
   bool empty() const {
-    return array_.empty();
+    return keys_.empty();
   }
   size_t size() const {
-    return array_.size();
+    return keys_.size();
   }
 
   KeyT top_key() const {
-    return array_[0].key_;
+    return keys_[0];
   }
 
   HeapNode *pop() {
     CHECK(!empty());
-    HeapNode *result = array_[0].node_;
+    HeapNode *result = nodes_[0];
     result->remove();
     erase(0);
     return result;
@@ -47,15 +49,16 @@ class KHeap {
 
   void insert(KeyT key, HeapNode *node) {
     CHECK(!node->in_heap());
-    array_.push_back({key, node});
-    fix_up(static_cast<int>(array_.size()) - 1);
+    keys_.push_back(key);
+    nodes_.push_back(node);
+    fix_up(static_cast<int>(keys_.size()) - 1);
   }
 
   void fix(KeyT key, HeapNode *node) {
     CHECK(node->in_heap());
     int pos = node->pos_;
-    KeyT old_key = array_[pos].key_;
-    array_[pos].key_ = key;
+    KeyT old_key = keys_[pos];
+    keys_[pos] = key;
     if (key < old_key) {
       fix_up(pos);
     } else {
@@ -70,57 +73,105 @@ class KHeap {
     erase(pos);
   }
 
+  // inserts a whole batch of nodes at once; when the batch is comparable with the heap
+  // size, it is cheaper to append everything and restore the heap property in one
+  // bottom-up pass than to fix every insertion up separately
+  void insert_bulk(const vector<std::pair<KeyT, HeapNode *>> &items) {
+    if (items.size() < size() / K) {
+      for (auto &item : items) {
+        insert(item.first, item.second);
+      }
+      return;
+    }
+    for (auto &item : items) {
+      CHECK(!item.second->in_heap());
+      item.second->pos_ = static_cast<int>(keys_.size());
+      keys_.push_back(item.first);
+      nodes_.push_back(item.second);
+    }
+    heapify();
+  }
+
+  // erases a whole batch of nodes at once by compacting the arrays and rebuilding
+  void erase_bulk(const vector<HeapNode *> &nodes) {
+    if (nodes.size() < size() / K) {
+      for (auto *node : nodes) {
+        erase(node);
+      }
+      return;
+    }
+    for (auto *node : nodes) {
+      CHECK(node->in_heap());
+      nodes_[node->pos_] = nullptr;
+      node->remove();
+    }
+    size_t new_size = 0;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      if (nodes_[i] != nullptr) {
+        keys_[new_size] = keys_[i];
+        nodes_[new_size] = nodes_[i];
+        nodes_[new_size]->pos_ = static_cast<int>(new_size);
+        new_size++;
+      }
+    }
+    keys_.resize(new_size);
+    nodes_.resize(new_size);
+    heapify();
+  }
+
   template <class F>
   void for_each(F &f) const {
-    for (auto &it : array_) {
-      f(it.key_, it.node_);
+    for (size_t i = 0; i < keys_.size(); i++) {
+      f(keys_[i], nodes_[i]);
     }
   }
 
   void check() const {
-    for (size_t i = 0; i < array_.size(); i++) {
-      for (size_t j = i * K + 1; j < i * K + 1 + K && j < array_.size(); j++) {
-        CHECK(array_[i].key_ <= array_[j].key_);
+    for (size_t i = 0; i < keys_.size(); i++) {
+      for (size_t j = i * K + 1; j < i * K + 1 + K && j < keys_.size(); j++) {
+        CHECK(keys_[i] <= keys_[j]);
       }
     }
   }
 
  private:
-  struct Item {
-    KeyT key_;
-    HeapNode *node_;
-  };
-  vector<Item> array_;
+  // keys are stored separately from the node pointers, so the sift-down comparison of
+  // the K keys of a family reads one contiguous chunk of memory
+  vector<KeyT> keys_;
+  vector<HeapNode *> nodes_;
 
   void fix_up(int pos) {
-    auto item = array_[pos];
+    auto key = keys_[pos];
+    auto *node = nodes_[pos];
 
     while (pos) {
       int parent_pos = (pos - 1) / K;
-      auto parent_item = array_[parent_pos];
 
-      if (parent_item.key_ < item.key_) {
+      if (keys_[parent_pos] < key) {
         break;
       }
 
-      parent_item.node_->pos_ = pos;
-      array_[pos] = parent_item;
+      nodes_[parent_pos]->pos_ = pos;
+      keys_[pos] = keys_[parent_pos];
+      nodes_[pos] = nodes_[parent_pos];
       pos = parent_pos;
     }
 
-    item.node_->pos_ = pos;
-    array_[pos] = item;
+    node->pos_ = pos;
+    keys_[pos] = key;
+    nodes_[pos] = node;
   }
 
   void fix_down(int pos) {
-    auto item = array_[pos];
+    auto key = keys_[pos];
+    auto *node = nodes_[pos];
     while (true) {
       int left_pos = pos * K + 1;
-      int right_pos = min(left_pos + K, static_cast<int>(array_.size()));
+      int right_pos = min(left_pos + K, static_cast<int>(keys_.size()));
       int next_pos = pos;
-      KeyT next_key = item.key_;
+      KeyT next_key = key;
       for (int i = left_pos; i < right_pos; i++) {
-        KeyT i_key = array_[i].key_;
+        KeyT i_key = keys_[i];
         if (i_key < next_key) {
           next_key = i_key;
           next_pos = i;
@@ -129,19 +180,30 @@ class KHeap {
       if (next_pos == pos) {
         break;
       }
-      array_[pos] = array_[next_pos];
-      array_[pos].node_->pos_ = pos;
+      keys_[pos] = keys_[next_pos];
+      nodes_[pos] = nodes_[next_pos];
+      nodes_[pos]->pos_ = pos;
       pos = next_pos;
     }
 
-    item.node_->pos_ = pos;
-    array_[pos] = item;
+    node->pos_ = pos;
+    keys_[pos] = key;
+    nodes_[pos] = node;
+  }
+
+  void heapify() {
+    auto n = static_cast<int>(keys_.size());
+    for (int pos = n >= 2 ? (n - 2) / K : -1; pos >= 0; pos--) {
+      fix_down(pos);
+    }
   }
 
   void erase(int pos) {
-    array_[pos] = array_.back();
-    array_.pop_back();
-    if (pos < static_cast<int>(array_.size())) {
+    keys_[pos] = keys_.back();
+    nodes_[pos] = nodes_.back();
+    keys_.pop_back();
+    nodes_.pop_back();
+    if (pos < static_cast<int>(keys_.size())) {
       fix_down(pos);
       fix_up(pos);
     }
@@ -67,21 +67,22 @@ vector<string> Hints::get_words(Slice name) {
 }
 
 void Hints::add_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
+  // posting lists are kept sorted, so words shared by many keys are updated
+  // through a binary search instead of a linear scan
   vector<KeyT> &keys = word_to_keys[word];
-  CHECK(std::find(keys.begin(), keys.end(), key) == keys.end());
-  keys.push_back(key);
+  auto key_it = std::lower_bound(keys.begin(), keys.end(), key);
+  CHECK(key_it == keys.end() || *key_it != key);
+  keys.insert(key_it, key);
 }
 
 void Hints::delete_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
   vector<KeyT> &keys = word_to_keys[word];
-  auto key_it = std::find(keys.begin(), keys.end(), key);
-  CHECK(key_it != keys.end());
+  auto key_it = std::lower_bound(keys.begin(), keys.end(), key);
+  CHECK(key_it != keys.end() && *key_it == key);
   if (keys.size() == 1) {
     word_to_keys.erase(word);
   } else {
-    CHECK(keys.size() > 1);
-    *key_it = keys.back();
-    keys.pop_back();
+    keys.erase(key_it);
   }
 }
 
@@ -136,8 +137,8 @@ void Hints::set_rating(KeyT key, RatingT rating) {
   key_to_rating_[key] = rating;
 }
 
-void Hints::add_search_results(vector<KeyT> &results, const string &word,
-                               const std::map<string, vector<KeyT>> &word_to_keys) {
+void Hints::append_search_results(vector<KeyT> &results, const string &word,
+                                  const std::map<string, vector<KeyT>> &word_to_keys) {
   LOG(DEBUG) << "Search for word " << word;
   auto it = word_to_keys.lower_bound(word);
   while (it != word_to_keys.end() && begins_with(it->first, word)) {
@@ -147,10 +148,23 @@ void Hints::add_search_results(vector<KeyT> &results, const string &word,
 }
 
 vector<Hints::KeyT> Hints::search_word(const string &word) const {
+  // the word and its transliteration variants form one batch of prefix
+  // queries: a variant extending another one is dropped, because its matches
+  // are a subset of the shorter variant's matches, and the union of the
+  // remaining disjoint index ranges is built with a single sort instead of
+  // an independent search and merge per variant
+  auto variants = get_word_transliterations(word, true);
+  std::sort(variants.begin(), variants.end());
+
   vector<KeyT> results;
-  add_search_results(results, word, translit_word_to_keys_);
-  for (auto w : get_word_transliterations(word, true)) {
-    add_search_results(results, w, word_to_keys_);
+  append_search_results(results, word, translit_word_to_keys_);
+  const string *last_variant = nullptr;
+  for (auto &w : variants) {
+    if (last_variant != nullptr && begins_with(w, *last_variant)) {
+      continue;
+    }
+    append_search_results(results, w, word_to_keys_);
+    last_variant = &w;
   }
 
   std::sort(results.begin(), results.end());
@@ -200,11 +214,18 @@ std::pair<size_t, vector<Hints::KeyT>> Hints::search(Slice query, int32 limit, b
   }
 
   auto total_size = results.size();
-  if (total_size < static_cast<size_t>(limit)) {
-    std::sort(results.begin(), results.end(), CompareByRating(key_to_rating_));
-  } else {
-    std::partial_sort(results.begin(), results.begin() + limit, results.end(), CompareByRating(key_to_rating_));
-    results.resize(limit);
+  auto result_size = total_size < static_cast<size_t>(limit) ? total_size : static_cast<size_t>(limit);
+
+  // look every rating up once instead of on each comparison
+  vector<std::pair<RatingT, KeyT>> rated_results;
+  rated_results.reserve(total_size);
+  for (auto key : results) {
+    rated_results.emplace_back(get_rating(key), key);
+  }
+  std::partial_sort(rated_results.begin(), rated_results.begin() + result_size, rated_results.end());
+  results.resize(result_size);
+  for (size_t i = 0; i < result_size; i++) {
+    results[i] = rated_results[i].second;
   }
 
   return {total_size, std::move(results)};
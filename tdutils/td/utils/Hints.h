@@ -54,32 +54,18 @@ class Hints {
 
   static vector<string> get_words(Slice name);
 
-  static void add_search_results(vector<KeyT> &results, const string &word,
-                                 const std::map<string, vector<KeyT>> &word_to_keys);
+  static void append_search_results(vector<KeyT> &results, const string &word,
+                                    const std::map<string, vector<KeyT>> &word_to_keys);
 
   vector<KeyT> search_word(const string &word) const;
 
-  class CompareByRating {
-    const std::unordered_map<KeyT, RatingT> &key_to_rating_;
-
-    RatingT get_rating(const KeyT &key) const {
-      auto it = key_to_rating_.find(key);
-      if (it == key_to_rating_.end()) {
-        return RatingT();
-      }
-      return it->second;
-    }
-
-   public:
-    explicit CompareByRating(const std::unordered_map<KeyT, RatingT> &key_to_rating) : key_to_rating_(key_to_rating) {
+  RatingT get_rating(KeyT key) const {
+    auto it = key_to_rating_.find(key);
+    if (it == key_to_rating_.end()) {
+      return RatingT();
     }
-
-    bool operator()(const KeyT &lhs, const KeyT &rhs) const {
-      auto lhs_rating = get_rating(lhs);
-      auto rhs_rating = get_rating(rhs);
-      return lhs_rating < rhs_rating || (lhs_rating == rhs_rating && lhs < rhs);
-    }
-  };
+    return it->second;
+  }
 };
 
 }  // namespace td
@@ -0,0 +1,84 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/Histogram.h"
+
+#include "td/utils/format.h"
+#include "td/utils/Time.h"
+
+#include <limits>
+
+namespace td {
+
+Histogram::Snapshot Histogram::get_snapshot() const {
+  Snapshot result;
+  for (auto &shard : shards_) {
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+      auto count = shard.buckets_[i].load(std::memory_order_relaxed);
+      result.buckets[i] += count;
+      result.total_count += count;
+    }
+  }
+  return result;
+}
+
+void Histogram::clear() {
+  for (auto &shard : shards_) {
+    for (auto &bucket : shard.buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+uint64 Histogram::Snapshot::get_quantile(double q) const {
+  if (total_count == 0) {
+    return 0;
+  }
+  auto need = static_cast<uint64>(q * static_cast<double>(total_count));
+  if (need < 1) {
+    need = 1;
+  }
+  if (need > total_count) {
+    need = total_count;
+  }
+  uint64 sum = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; i++) {
+    sum += buckets[i];
+    if (sum >= need) {
+      if (i == BUCKET_COUNT - 1) {
+        return std::numeric_limits<uint64>::max();
+      }
+      return (static_cast<uint64>(1) << (i + 1)) - 1;
+    }
+  }
+  UNREACHABLE();
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const Histogram::Snapshot &snapshot) {
+  return string_builder << "[" << tag("count", snapshot.total_count) << tag("p50", snapshot.get_quantile(0.5))
+                        << tag("p95", snapshot.get_quantile(0.95)) << tag("p99", snapshot.get_quantile(0.99)) << "]";
+}
+
+HistogramTimer::HistogramTimer(Histogram &histogram) : histogram_(&histogram), start_at_(Time::now()) {
+}
+
+HistogramTimer::HistogramTimer(HistogramTimer &&other) : histogram_(other.histogram_), start_at_(other.start_at_) {
+  other.histogram_ = nullptr;
+}
+
+HistogramTimer::~HistogramTimer() {
+  reset();
+}
+
+void HistogramTimer::reset() {
+  if (histogram_ == nullptr) {
+    return;
+  }
+  histogram_->add_duration(Time::now() - start_at_);
+  histogram_ = nullptr;
+}
+
+}  // namespace td
@@ -0,0 +1,83 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/StringBuilder.h"
+
+#include <array>
+#include <atomic>
+
+namespace td {
+
+// Fixed-size logarithmic histogram for hot-path metrology.
+// A value is mapped to the power-of-two bucket containing it, so add() is one
+// relaxed atomic increment and never allocates. The buckets are sharded by
+// thread id to keep threads from bouncing each other's cache lines;
+// get_snapshot() merges the shards. The histogram is cheap enough to stay
+// enabled in production.
+class Histogram {
+ public:
+  static constexpr size_t BUCKET_COUNT = 64;
+
+  // bucket 0 holds values 0 and 1, bucket i > 0 holds [2**i, 2**(i + 1))
+  static size_t get_bucket(uint64 value) {
+    return static_cast<size_t>(63 - count_leading_zeroes64(value | 1));
+  }
+
+  void add(uint64 value) {
+    auto &shard = shards_[get_thread_id() & (SHARD_COUNT - 1)];
+    shard.buckets_[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // for durations measured with Time::now(); recorded in whole microseconds
+  void add_duration(double duration) {
+    add(duration <= 0 ? 0 : static_cast<uint64>(duration * 1e6));
+  }
+
+  struct Snapshot {
+    std::array<uint64, BUCKET_COUNT> buckets{};
+    uint64 total_count = 0;
+
+    // upper bound of the bucket holding the q-th quantile, 0 <= q <= 1;
+    // returns 0 for an empty histogram
+    uint64 get_quantile(double q) const;
+  };
+  Snapshot get_snapshot() const;
+
+  void clear();
+
+ private:
+  static constexpr size_t SHARD_COUNT = 16;  // must be a power of two
+  struct Shard {
+    std::array<std::atomic<uint64>, BUCKET_COUNT> buckets_{};
+    char pad[64];
+  };
+  std::array<Shard, SHARD_COUNT> shards_{};
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const Histogram::Snapshot &snapshot);
+
+// Records the lifetime of a scope into a histogram in microseconds
+class HistogramTimer {
+ public:
+  explicit HistogramTimer(Histogram &histogram);
+  HistogramTimer(const HistogramTimer &) = delete;
+  HistogramTimer &operator=(const HistogramTimer &) = delete;
+  HistogramTimer(HistogramTimer &&other);
+  HistogramTimer &operator=(HistogramTimer &&) = delete;
+  ~HistogramTimer();
+  void reset();
+
+ private:
+  Histogram *histogram_{nullptr};
+  double start_at_{0};
+};
+
+}  // namespace td
@@ -7,6 +7,7 @@
 #include "td/utils/JsonBuilder.h"
 
 #include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/ScopeGuard.h"
 
 #include <cstring>
@@ -564,6 +565,125 @@ Status do_json_skip(Parser &parser, int32 max_depth) {
   return Status::Error("Can't parse");
 }
 
+Status do_json_parse(Parser &parser, JsonCallback &callback, int32 max_depth) {
+  if (max_depth < 0) {
+    return Status::Error("Too big object depth");
+  }
+
+  parser.skip_whitespaces();
+  switch (parser.peek_char()) {
+    case 'f':
+      if (parser.skip_start_with("false")) {
+        return callback.on_boolean(false);
+      }
+      return Status::Error("Token starts with 'f' -- false expected");
+    case 't':
+      if (parser.skip_start_with("true")) {
+        return callback.on_boolean(true);
+      }
+      return Status::Error("Token starts with 't' -- true expected");
+    case 'n':
+      if (parser.skip_start_with("null")) {
+        return callback.on_null();
+      }
+      return Status::Error("Token starts with 'n' -- null expected");
+    case '"': {
+      TRY_RESULT(slice, json_string_decode(parser));
+      return callback.on_string(slice);
+    }
+    case '[': {
+      parser.skip('[');
+      TRY_STATUS(callback.on_begin_array());
+      parser.skip_whitespaces();
+      if (parser.try_skip(']')) {
+        return callback.on_end_array();
+      }
+      while (true) {
+        if (parser.empty()) {
+          return Status::Error("Unexpected string end");
+        }
+        TRY_STATUS(do_json_parse(parser, callback, max_depth - 1));
+
+        parser.skip_whitespaces();
+        if (parser.try_skip(']')) {
+          break;
+        }
+        if (parser.try_skip(',')) {
+          parser.skip_whitespaces();
+          continue;
+        }
+        if (parser.empty()) {
+          return Status::Error("Unexpected string end");
+        }
+        return Status::Error("Unexpected symbol while parsing JSON Array");
+      }
+      return callback.on_end_array();
+    }
+    case '{': {
+      parser.skip('{');
+      TRY_STATUS(callback.on_begin_object());
+      parser.skip_whitespaces();
+      if (parser.try_skip('}')) {
+        return callback.on_end_object();
+      }
+      while (true) {
+        if (parser.empty()) {
+          return Status::Error("Unexpected string end");
+        }
+        TRY_RESULT(key, json_string_decode(parser));
+        TRY_STATUS(callback.on_object_key(key));
+        parser.skip_whitespaces();
+        if (!parser.try_skip(':')) {
+          return Status::Error("':' expected");
+        }
+        TRY_STATUS(do_json_parse(parser, callback, max_depth - 1));
+
+        parser.skip_whitespaces();
+        if (parser.try_skip('}')) {
+          break;
+        }
+        if (parser.try_skip(',')) {
+          parser.skip_whitespaces();
+          continue;
+        }
+        if (parser.empty()) {
+          return Status::Error("Unexpected string end");
+        }
+        return Status::Error("Unexpected symbol while parsing JSON Object");
+      }
+      return callback.on_end_object();
+    }
+    case '-':
+    case '+':
+    case '.':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+      auto num = parser.read_while(
+          [](char c) { return c == '-' || ('0' <= c && c <= '9') || c == 'e' || c == 'E' || c == '+' || c == '.'; });
+      return callback.on_number(num);
+    }
+    case 0:
+      return Status::Error("Unexpected string end");
+    default: {
+      char next = parser.peek_char();
+      if (0 < next && next < 127) {
+        return Status::Error(PSLICE() << "Unexpected symbol '" << parser.peek_char() << "'");
+      } else {
+        return Status::Error("Unexpected symbol");
+      }
+    }
+  }
+  UNREACHABLE();
+}
+
 Slice JsonValue::get_type_name(Type type) {
   switch (type) {
     case Type::Null:
@@ -683,4 +803,15 @@ Result<string> get_json_object_string_field(JsonObject &object, Slice name, bool
   return Status::Error(400, PSLICE() << "Can't find field \"" << name << "\"");
 }
 
+namespace detail {
+
+static TD_THREAD_LOCAL string *json_encode_buf;
+
+string &get_json_encode_buf() {
+  init_thread_local<string>(json_encode_buf);
+  return *json_encode_buf;
+}
+
+}  // namespace detail
+
 }  // namespace td
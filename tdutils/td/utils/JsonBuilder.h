@@ -723,6 +723,29 @@ Status json_string_skip(Parser &parser) TD_WARN_UNUSED_RESULT;
 Result<JsonValue> do_json_decode(Parser &parser, int32 max_depth) TD_WARN_UNUSED_RESULT;
 Status do_json_skip(Parser &parser, int32 max_depth) TD_WARN_UNUSED_RESULT;
 
+// Receives parsing events from json_parse without materialization of a JsonValue tree.
+// Strings and numbers are decoded in situ, so the passed slices point into the parsed
+// buffer and are valid as long as it is. Any returned error aborts the parsing
+class JsonCallback {
+ public:
+  JsonCallback() = default;
+  JsonCallback(const JsonCallback &) = delete;
+  JsonCallback &operator=(const JsonCallback &) = delete;
+  virtual ~JsonCallback() = default;
+
+  virtual Status on_null() = 0;
+  virtual Status on_boolean(bool value) = 0;
+  virtual Status on_number(MutableSlice number) = 0;
+  virtual Status on_string(MutableSlice str) = 0;
+  virtual Status on_begin_array() = 0;
+  virtual Status on_end_array() = 0;
+  virtual Status on_begin_object() = 0;
+  virtual Status on_object_key(MutableSlice key) = 0;
+  virtual Status on_end_object() = 0;
+};
+
+Status do_json_parse(Parser &parser, JsonCallback &callback, int32 max_depth) TD_WARN_UNUSED_RESULT;
+
 inline Result<JsonValue> json_decode(MutableSlice json) {
   Parser parser(json);
   const int32 DEFAULT_MAX_DEPTH = 100;
@@ -736,6 +759,17 @@ inline Result<JsonValue> json_decode(MutableSlice json) {
   return result;
 }
 
+inline Status json_parse(MutableSlice json, JsonCallback &callback) {
+  Parser parser(json);
+  const int32 DEFAULT_MAX_DEPTH = 100;
+  TRY_STATUS(do_json_parse(parser, callback, DEFAULT_MAX_DEPTH));
+  parser.skip_whitespaces();
+  if (!parser.empty()) {
+    return Status::Error("Expected string end");
+  }
+  return Status::OK();
+}
+
 template <class StrT, class ValT>
 StrT json_encode(const ValT &val) {
   auto buf_len = 1 << 18;
@@ -747,6 +781,30 @@ StrT json_encode(const ValT &val) {
   return StrT(slice.begin(), slice.size());
 }
 
+namespace detail {
+string &get_json_encode_buf();
+}  // namespace detail
+
+// same as json_encode, but reuses the capacity of the destination string and of
+// a per-thread scratch buffer, which is retained at the high-watermark size of
+// produced documents, so steady-state encoding doesn't allocate at all
+template <class StrT, class ValT>
+void json_encode_to(StrT &dest, const ValT &val) {
+  auto &buf = detail::get_json_encode_buf();
+  if (buf.size() < (1 << 18)) {
+    buf.resize(1 << 18);
+  }
+  JsonBuilder jb(StringBuilder(MutableSlice(buf), true));
+  jb.enter_value() << val;
+  LOG_IF(ERROR, jb.string_builder().is_error()) << "JSON buffer overflow";
+  auto slice = jb.string_builder().as_cslice();
+  auto slice_size = slice.size();
+  dest.assign(slice.begin(), slice_size);
+  if (slice_size > buf.size()) {
+    buf.resize(slice_size);
+  }
+}
+
 template <class T>
 class ToJsonImpl : public Jsonable {
  public:
@@ -0,0 +1,47 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/MemoryTag.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <atomic>
+
+namespace td {
+
+namespace {
+TD_THREAD_LOCAL int32 thread_memory_tag;  // static zero-initialized
+std::atomic<int64> memory_tag_sizes[MEMORY_TAG_COUNT];
+}  // namespace
+
+int32 get_thread_memory_tag() {
+  return thread_memory_tag;
+}
+
+MemoryTagScope::MemoryTagScope(int32 tag) : save_tag_(thread_memory_tag) {
+  if (tag >= 0 && tag < MEMORY_TAG_COUNT) {
+    thread_memory_tag = tag;
+  }
+}
+
+MemoryTagScope::~MemoryTagScope() {
+  thread_memory_tag = save_tag_;
+}
+
+void on_memory_tag_alloc(int32 tag, int64 size) {
+  if (tag > 0 && tag < MEMORY_TAG_COUNT) {
+    memory_tag_sizes[tag].fetch_add(size, std::memory_order_relaxed);
+  }
+}
+
+int64 get_memory_tag_size(int32 tag) {
+  if (tag <= 0 || tag >= MEMORY_TAG_COUNT) {
+    return 0;
+  }
+  return memory_tag_sizes[tag].load(std::memory_order_relaxed);
+}
+
+}  // namespace td
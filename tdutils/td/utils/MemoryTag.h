@@ -0,0 +1,46 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// Scoped per-subsystem memory accounting. Allocations made while a MemoryTagScope
+// is active are charged to its tag, and frees are subtracted from the tag that was
+// active when the memory was allocated, so each counter holds the live bytes of
+// its subsystem. Tag numbers and their meanings are assigned by the application;
+// tag 0 is the untagged default and isn't counted.
+//
+// The counters are fed by the allocator instrumentation (the memprof malloc
+// override); in builds without it the scopes only cost a thread-local store and
+// all counters stay at zero.
+constexpr int32 MEMORY_TAG_COUNT = 16;
+
+// the tag allocations of the current thread are charged to; 0 by default
+int32 get_thread_memory_tag();
+
+class MemoryTagScope {
+ public:
+  explicit MemoryTagScope(int32 tag);
+
+  MemoryTagScope(const MemoryTagScope &) = delete;
+  MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+
+  ~MemoryTagScope();
+
+ private:
+  int32 save_tag_;
+};
+
+// called by the allocator instrumentation on every allocation and free; must not allocate
+void on_memory_tag_alloc(int32 tag, int64 size);
+
+// the live bytes currently charged to the tag
+int64 get_memory_tag_size(int32 tag);
+
+}  // namespace td
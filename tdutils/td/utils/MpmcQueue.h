@@ -16,6 +16,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Span.h"
 
 #include <array>
 #include <atomic>
@@ -383,6 +384,88 @@ class MpmcQueue {
     }
   }
 
+  // Pushes a run of values, reserving a contiguous range of slots inside the current block
+  // with a single fetch_add instead of one per value
+  void push_n(MutableSpan<T> values, size_t thread_id) {
+    SCOPE_EXIT {
+      hazard_pointers_.clear(thread_id, 0);
+    };
+    size_t i = 0;
+    while (i < values.size()) {
+      auto node = hazard_pointers_.protect(thread_id, 0, write_pos_);
+      auto &block = node->block;
+      auto want = static_cast<uint64>(values.size() - i);
+      auto pos = block.write_pos.fetch_add(want);
+      if (pos >= block.data.size()) {
+        auto next = node->next.load();
+        if (next == nullptr) {
+          auto new_node = new Node{};
+          new_node->block.write_pos++;
+          new_node->block.data[0].set_value(values[i]);
+          Node *null = nullptr;
+          if (node->next.compare_exchange_strong(null, new_node)) {
+            write_pos_.compare_exchange_strong(node, new_node);
+            i++;
+          } else {
+            new_node->block.data[0].get_value(values[i]);
+            delete new_node;
+          }
+        } else {
+          write_pos_.compare_exchange_strong(node, next);
+        }
+        continue;
+      }
+      auto end = td::min(pos + want, static_cast<uint64>(block.data.size()));
+      for (; pos < end && i < values.size(); pos++) {
+        // slots stolen by racing consumers are simply skipped
+        if (block.data[static_cast<size_t>(pos)].set_value(values[i])) {
+          i++;
+        }
+      }
+    }
+  }
+
+  // Pops up to values.size() values, reserving a contiguous range of slots with one fetch_add.
+  // Returns the number of popped values; they occupy a prefix of the destination span.
+  size_t pop_n(MutableSpan<T> values, size_t thread_id) {
+    SCOPE_EXIT {
+      hazard_pointers_.clear(thread_id, 0);
+    };
+    size_t result = 0;
+    while (result < values.size()) {
+      auto node = hazard_pointers_.protect(thread_id, 0, read_pos_);
+      auto &block = node->block;
+      auto write_pos = block.write_pos.load();
+      auto read_pos = block.read_pos.load();
+      if (write_pos <= read_pos && node->next.load(std::memory_order_relaxed) == nullptr) {
+        break;
+      }
+      if (read_pos >= block.data.size()) {
+        auto next = node->next.load();
+        if (!next) {
+          break;
+        }
+        if (read_pos_.compare_exchange_strong(node, next)) {
+          hazard_pointers_.clear(thread_id, 0);
+          hazard_pointers_.retire(thread_id, node);
+        }
+        continue;
+      }
+      auto want = static_cast<uint64>(values.size() - result);
+      if (write_pos > read_pos) {
+        want = td::min(want, write_pos - read_pos);
+      }
+      auto pos = block.read_pos.fetch_add(want);
+      auto end = td::min(pos + want, static_cast<uint64>(block.data.size()));
+      for (; pos < end && result < values.size(); pos++) {
+        if (block.data[static_cast<size_t>(pos)].get_value(values[result])) {
+          result++;
+        }
+      }
+    }
+    return result;
+  }
+
   bool try_pop(T &value, size_t thread_id) {
     SCOPE_EXIT {
       hazard_pointers_.clear(thread_id, 0);
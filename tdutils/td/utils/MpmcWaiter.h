@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/thread.h"
 
 #include <atomic>
@@ -103,4 +104,63 @@ class MpmcWaiter {
   }
 };
 
+// Same interface as MpmcWaiter, but a worker first spins with exponential backoff for an
+// adaptive number of rounds before entering the sleepy/asleep protocol. The spin budget is
+// tuned per waiter from a rolling average of the number of rounds a wait needed until work
+// arrived, so queues that are almost never idle stop paying a futex round trip per item,
+// while mostly idle queues fall asleep as quickly as before.
+class AdaptiveMpmcWaiter {
+ public:
+  int wait(int yields, uint32 worker_id) {
+    auto spin_limit = get_spin_limit();
+    if (yields < spin_limit) {
+      backoff_pause(yields);
+      return yields + 1;
+    }
+    auto res = waiter_.wait(yields - spin_limit, worker_id);
+    return res == 0 ? 0 : spin_limit + res;
+  }
+
+  int stop_wait(int yields, uint32 worker_id) {
+    auto spin_limit = get_spin_limit();
+    if (yields > spin_limit) {
+      waiter_.stop_wait(yields - spin_limit, worker_id);
+    }
+    update_spin_limit(yields);
+    return 0;
+  }
+
+  void notify() {
+    waiter_.notify();
+  }
+
+ private:
+  enum : int32 { MinSpinRounds = 4, MaxSpinRounds = 1024 };
+
+  MpmcWaiter waiter_;
+  std::atomic<int32> avg_rounds_{MinSpinRounds};
+
+  int get_spin_limit() const {
+    auto avg_rounds = avg_rounds_.load(std::memory_order_relaxed);
+    return static_cast<int>(clamp(2 * avg_rounds, static_cast<int32>(MinSpinRounds), static_cast<int32>(MaxSpinRounds)));
+  }
+
+  void update_spin_limit(int rounds) {
+    auto avg_rounds = avg_rounds_.load(std::memory_order_relaxed);
+    avg_rounds_.store((3 * avg_rounds + static_cast<int32>(rounds)) / 4, std::memory_order_relaxed);
+  }
+
+  static void backoff_pause(int yields) {
+    auto pause_n = 1 << td::min(yields, 6);
+    for (int i = 0; i < pause_n; i++) {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+    }
+    if (yields >= 6) {
+      td::this_thread::yield();
+    }
+  }
+};
+
 }  // namespace td
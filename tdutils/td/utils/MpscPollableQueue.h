@@ -14,6 +14,7 @@
 
 #include "td/utils/SpinLock.h"
 
+#include <iterator>
 #include <utility>
 
 namespace td {
@@ -55,6 +56,23 @@ class MpscPollableQueue {
       event_fd_.release();
     }
   }
+  // puts a run of values under one lock with at most one reader wakeup
+  void writer_put_batch(std::vector<ValueType> &&values) {
+    if (values.empty()) {
+      return;
+    }
+    auto guard = lock_.lock();
+    if (writer_vector_.empty()) {
+      writer_vector_ = std::move(values);
+    } else {
+      writer_vector_.insert(writer_vector_.end(), std::make_move_iterator(values.begin()),
+                            std::make_move_iterator(values.end()));
+    }
+    if (wait_event_fd_) {
+      wait_event_fd_ = false;
+      event_fd_.release();
+    }
+  }
   EventFd &reader_get_event_fd() {
     return event_fd_;
   }
@@ -115,6 +133,10 @@ class MpscPollableQueue {
     UNREACHABLE();
   }
 
+  void writer_put_batch(std::vector<ValueType> &&values) {
+    UNREACHABLE();
+  }
+
   void writer_flush() {
     UNREACHABLE();
   }
@@ -0,0 +1,266 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace td {
+// Variant of ObjectPool for objects which are created on one thread, but released from many.
+//
+// A single atomic freelist head bounces between caches when objects are released from several
+// threads at once, so the freelist is sharded by the releasing thread id, and the creating
+// thread keeps a private magazine which is refilled by grabbing a whole shard with one
+// exchange. create() must still be called from one thread at a time, like in ObjectPool.
+template <class DataT>
+class ShardedObjectPool {
+  struct Storage;
+
+ public:
+  class WeakPtr {
+   public:
+    WeakPtr() : generation_(-1), storage_(nullptr) {
+    }
+    WeakPtr(int32 generation, Storage *storage) : generation_(generation), storage_(storage) {
+    }
+
+    DataT &operator*() const {
+      return storage_->data;
+    }
+
+    DataT *operator->() const {
+      return &**this;
+    }
+
+    // see ObjectPool::WeakPtr::is_alive for explanation of the memory order
+    bool is_alive() const {
+      if (!storage_) {
+        return false;
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return generation_ == storage_->generation.load(std::memory_order_relaxed);
+    }
+
+    // Used for ActorId
+    bool is_alive_unsafe() const {
+      if (!storage_) {
+        return false;
+      }
+      return generation_ == storage_->generation.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+      return storage_ == nullptr;
+    }
+    void clear() {
+      generation_ = -1;
+      storage_ = nullptr;
+    }
+    int32 generation() {
+      return generation_;
+    }
+
+   private:
+    int32 generation_;
+    Storage *storage_;
+  };
+
+  class OwnerPtr {
+   public:
+    OwnerPtr() = default;
+    OwnerPtr(const OwnerPtr &) = delete;
+    OwnerPtr &operator=(const OwnerPtr &) = delete;
+    OwnerPtr(OwnerPtr &&other) : storage_(other.storage_), parent_(other.parent_) {
+      other.storage_ = nullptr;
+      other.parent_ = nullptr;
+    }
+    OwnerPtr &operator=(OwnerPtr &&other) {
+      if (this != &other) {
+        storage_ = other.storage_;
+        parent_ = other.parent_;
+        other.storage_ = nullptr;
+        other.parent_ = nullptr;
+      }
+      return *this;
+    }
+    ~OwnerPtr() {
+      reset();
+    }
+
+    DataT *get() {
+      return &storage_->data;
+    }
+    DataT &operator*() {
+      return *get();
+    }
+    DataT *operator->() {
+      return get();
+    }
+
+    const DataT *get() const {
+      return &storage_->data;
+    }
+    const DataT &operator*() const {
+      return *get();
+    }
+    const DataT *operator->() const {
+      return get();
+    }
+
+    WeakPtr get_weak() {
+      return WeakPtr(storage_->generation.load(std::memory_order_relaxed), storage_);
+    }
+    int32 generation() {
+      return storage_->generation.load(std::memory_order_relaxed);
+    }
+
+    Storage *release() {
+      auto result = storage_;
+      storage_ = nullptr;
+      return result;
+    }
+
+    bool empty() const {
+      return storage_ == nullptr;
+    }
+
+    void reset() {
+      if (storage_ != nullptr) {
+        // for crazy cases when data owns owner pointer to itself.
+        auto tmp = storage_;
+        storage_ = nullptr;
+        parent_->release(OwnerPtr(tmp, parent_));
+      }
+    }
+
+   private:
+    friend class ShardedObjectPool;
+    OwnerPtr(Storage *storage, ShardedObjectPool<DataT> *parent) : storage_(storage), parent_(parent) {
+    }
+    Storage *storage_ = nullptr;
+    ShardedObjectPool<DataT> *parent_ = nullptr;
+  };
+
+  template <class... ArgsT>
+  OwnerPtr create(ArgsT &&... args) {
+    Storage *storage = get_storage();
+    storage->init_data(std::forward<ArgsT>(args)...);
+    return OwnerPtr(storage, this);
+  }
+
+  OwnerPtr create_empty() {
+    Storage *storage = get_storage();
+    return OwnerPtr(storage, this);
+  }
+
+  void set_check_empty(bool flag) {
+    check_empty_flag_ = flag;
+  }
+
+  void release(OwnerPtr &&owner_ptr) {
+    Storage *storage = owner_ptr.release();
+    storage->destroy_data();
+    release_storage(storage);
+  }
+
+  ShardedObjectPool() = default;
+  ShardedObjectPool(const ShardedObjectPool &) = delete;
+  ShardedObjectPool &operator=(const ShardedObjectPool &) = delete;
+  ShardedObjectPool(ShardedObjectPool &&other) = delete;
+  ShardedObjectPool &operator=(ShardedObjectPool &&other) = delete;
+  ~ShardedObjectPool() {
+    delete_list(local_head_);
+    local_head_ = nullptr;
+    for (auto &shard : shards_) {
+      delete_list(shard.head.exchange(nullptr));
+    }
+    LOG_CHECK(storage_count_.load() == 0) << storage_count_.load();
+  }
+
+ private:
+  struct Storage {
+    DataT data;
+    Storage *next = nullptr;
+    std::atomic<int32> generation{1};
+
+    template <class... ArgsT>
+    void init_data(ArgsT &&... args) {
+      data = DataT(std::forward<ArgsT>(args)...);
+    }
+    void destroy_data() {
+      generation.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      data.clear();
+    }
+  };
+
+  static constexpr size_t SHARDS_N = 8;  // must be a power of two
+  struct Shard {
+    std::atomic<Storage *> head{nullptr};
+    char pad[TD_CONCURRENCY_PAD - sizeof(std::atomic<Storage *>)];
+  };
+
+  std::atomic<int32> storage_count_{0};
+  std::array<Shard, SHARDS_N> shards_;
+  // private magazine of the creating thread
+  Storage *local_head_ = nullptr;
+  bool check_empty_flag_ = false;
+
+  // only one thread, so no aba problem
+  Storage *get_storage() {
+    if (local_head_ == nullptr) {
+      refill_magazine();
+    }
+    if (local_head_ == nullptr) {
+      storage_count_++;
+      return new Storage();
+    }
+    Storage *res = local_head_;
+    local_head_ = res->next;
+    return res;
+  }
+
+  // one exchange takes a whole shard, so a refill pays at most SHARDS_N atomic operations
+  // for an arbitrary number of released objects
+  void refill_magazine() {
+    auto first_shard = static_cast<size_t>(get_thread_id()) & (SHARDS_N - 1);
+    for (size_t i = 0; i < SHARDS_N && local_head_ == nullptr; i++) {
+      auto &shard = shards_[(first_shard + i) & (SHARDS_N - 1)];
+      if (shard.head.load(std::memory_order_relaxed) != nullptr) {
+        local_head_ = shard.head.exchange(nullptr);
+      }
+    }
+  }
+
+  // release can be called from other thread
+  void release_storage(Storage *storage) {
+    auto &shard = shards_[static_cast<size_t>(get_thread_id()) & (SHARDS_N - 1)];
+    while (true) {
+      auto *save_head = shard.head.load();
+      storage->next = save_head;
+      if (shard.head.compare_exchange_weak(save_head, storage)) {
+        break;
+      }
+    }
+  }
+
+  void delete_list(Storage *head) {
+    while (head != nullptr) {
+      auto *to_delete = head;
+      head = to_delete->next;
+      delete to_delete;
+      storage_count_--;
+    }
+  }
+};
+}  // namespace td
@@ -0,0 +1,86 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/SlabAllocator.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+namespace td {
+
+namespace {
+
+constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+constexpr std::size_t SIZE_CLASS_COUNT = 4;
+constexpr std::array<std::size_t, SIZE_CLASS_COUNT> SIZE_CLASSES{{64, 128, 256, 512}};
+constexpr std::size_t MAX_FREE_BLOCKS = 1024;  // per size class and thread
+
+std::size_t get_size_class(std::size_t size) {
+  std::size_t size_class = 0;
+  while (size_class < SIZE_CLASS_COUNT && SIZE_CLASSES[size_class] < HEADER_SIZE + size) {
+    size_class++;
+  }
+  return size_class;
+}
+
+}  // namespace
+
+struct SlabAllocator::Impl {
+  std::array<vector<char *>, SIZE_CLASS_COUNT> free_lists;
+
+  ~Impl() {
+    for (auto &free_list : free_lists) {
+      for (auto *block : free_list) {
+        ::operator delete(block);
+      }
+    }
+  }
+};
+
+SlabAllocator::Impl &SlabAllocator::impl() {
+  static TD_THREAD_LOCAL Impl *impl;  // static zero-initialized
+  init_thread_local<Impl>(impl);
+  return *impl;
+}
+
+void *SlabAllocator::alloc(std::size_t size) {
+  auto size_class = get_size_class(size);
+  char *block;
+  if (size_class < SIZE_CLASS_COUNT) {
+    auto &free_list = impl().free_lists[size_class];
+    if (!free_list.empty()) {
+      block = free_list.back();
+      free_list.pop_back();
+    } else {
+      block = static_cast<char *>(::operator new(SIZE_CLASSES[size_class]));
+    }
+  } else {
+    block = static_cast<char *>(::operator new(HEADER_SIZE + size));
+  }
+  *reinterpret_cast<std::size_t *>(block) = size_class;
+  return block + HEADER_SIZE;
+}
+
+void SlabAllocator::free_ptr(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  char *block = static_cast<char *>(ptr) - HEADER_SIZE;
+  auto size_class = *reinterpret_cast<std::size_t *>(block);
+  if (size_class < SIZE_CLASS_COUNT) {
+    auto &free_list = impl().free_lists[size_class];
+    if (free_list.size() < MAX_FREE_BLOCKS) {
+      free_list.push_back(block);
+      return;
+    }
+  }
+  ::operator delete(block);
+}
+
+}  // namespace td
@@ -0,0 +1,30 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <cstddef>
+
+namespace td {
+
+// Thread-local slab allocator for small short-lived objects, primarily closure payloads of actor
+// events. Freed blocks are kept in per-thread size-class bins and reused without touching the
+// global allocator. Blocks of one size class are interchangeable, so a block allocated on one
+// scheduler thread may be freed and reused on another one. Big allocations and bin overflow
+// fall back to the global allocator.
+class SlabAllocator {
+ public:
+  static void *alloc(std::size_t size);
+  static void free_ptr(void *ptr);
+
+ private:
+  struct Impl;
+  static Impl &impl();
+};
+
+}  // namespace td
@@ -51,19 +51,33 @@ class StackAllocator {
     std::array<char, MEM_SIZE> mem;
 
     size_t pos{0};
+    // allocations that don't fit into the arena get their own heap page,
+    // released by free_ptr in the same LIFO order as the arena itself
+    vector<char *> spilled_;
+
     char *alloc(size_t size) {
       if (size == 0) {
         size = 1;
       }
-      char *res = mem.data() + pos;
       size = (size + 7) & -8;
-      pos += size;
-      if (pos > MEM_SIZE) {
-        std::abort();  // memory is over
+      if (size >= MEM_SIZE || pos + size > MEM_SIZE) {
+        char *res = new char[size];
+        spilled_.push_back(res);
+        return res;
       }
+      char *res = mem.data() + pos;
+      pos += size;
       return res;
     }
     void free_ptr(char *ptr) {
+      if (ptr < mem.data() || ptr >= mem.data() + MEM_SIZE) {
+        if (spilled_.empty() || spilled_.back() != ptr) {
+          std::abort();  // out-of-order free
+        }
+        spilled_.pop_back();
+        delete[] ptr;
+        return;
+      }
       size_t new_pos = ptr - mem.data();
       if (new_pos >= pos) {
         std::abort();  // shouldn't happen
@@ -14,9 +14,9 @@
 #include "td/utils/port/thread_local.h"
 
 #include <string.h>
+#endif
 
 #include <cstring>
-#endif
 
 namespace td {
 
@@ -51,4 +51,105 @@ string winerror_to_string(int code) {
 }
 #endif
 
+Status Status::clone() const {
+  if (is_ok()) {
+    return Status();
+  }
+  auto info = get_info();
+  if (info.static_flag) {
+    return clone_static();
+  }
+  return Status(false, info.error_type, info.error_code, message());
+}
+
+StringBuilder &Status::print(StringBuilder &sb) const {
+  if (is_ok()) {
+    return sb << "OK";
+  }
+  Info info = get_info();
+  switch (info.error_type) {
+    case ErrorType::general:
+      sb << "[Error";
+      break;
+    case ErrorType::os:
+#if TD_PORT_POSIX
+      sb << "[PosixError : " << strerror_safe(info.error_code);
+#elif TD_PORT_WINDOWS
+      sb << "[WindowsError : " << winerror_to_string(info.error_code);
+#endif
+      break;
+    default:
+      UNREACHABLE();
+      break;
+  }
+  sb << " : " << code() << " : " << message() << "]";
+  return sb;
+}
+
+string Status::to_string() const {
+  auto buf = StackAllocator::alloc(4096);
+  StringBuilder sb(buf.as_slice());
+  print(sb);
+  return sb.as_cslice().str();
+}
+
+string Status::public_message() const {
+  if (is_ok()) {
+    return "OK";
+  }
+  Info info = get_info();
+  switch (info.error_type) {
+    case ErrorType::general:
+      return message().str();
+    case ErrorType::os:
+#if TD_PORT_POSIX
+      return strerror_safe(info.error_code).str();
+#elif TD_PORT_WINDOWS
+      return winerror_to_string(info.error_code);
+#endif
+    default:
+      UNREACHABLE();
+      return "";
+  }
+}
+
+Status::Status(Info info, Slice message) {
+  size_t size = sizeof(Info) + message.size() + 1;
+  ptr_ = std::unique_ptr<char[], Deleter>(new char[size]);
+  char *ptr = ptr_.get();
+  reinterpret_cast<Info *>(ptr)[0] = info;
+  ptr += sizeof(Info);
+  std::memcpy(ptr, message.begin(), message.size());
+  ptr += message.size();
+  *ptr = 0;
+}
+
+Status::Info Status::to_info(bool static_flag, ErrorType error_type, int error_code) {
+  const int MIN_ERROR_CODE = -(1 << 22) + 1;
+  const int MAX_ERROR_CODE = (1 << 22) - 1;
+  Info tmp;
+  tmp.static_flag = static_flag;
+  tmp.error_type = error_type;
+
+  if (error_code < MIN_ERROR_CODE) {
+    LOG(ERROR) << "Error code value is altered from " << error_code;
+    error_code = MIN_ERROR_CODE;
+  }
+  if (error_code > MAX_ERROR_CODE) {
+    LOG(ERROR) << "Error code value is altered from " << error_code;
+    error_code = MAX_ERROR_CODE;
+  }
+
+#if TD_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#endif
+  tmp.error_code = error_code;
+#if TD_GCC
+#pragma GCC diagnostic pop
+#endif
+  CHECK(error_code == tmp.error_code);
+  return tmp;
+}
+
 }  // namespace td
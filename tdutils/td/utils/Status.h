@@ -89,16 +89,7 @@ class Status {
     return ptr_ == other.ptr_;
   }
 
-  Status clone() const TD_WARN_UNUSED_RESULT {
-    if (is_ok()) {
-      return Status();
-    }
-    auto info = get_info();
-    if (info.static_flag) {
-      return clone_static();
-    }
-    return Status(false, info.error_type, info.error_code, message());
-  }
+  Status clone() const TD_COLD TD_WARN_UNUSED_RESULT;
 
   static Status OK() TD_WARN_UNUSED_RESULT {
     return Status();
@@ -134,36 +125,9 @@ class Status {
     return status.clone_static();
   }
 
-  StringBuilder &print(StringBuilder &sb) const {
-    if (is_ok()) {
-      return sb << "OK";
-    }
-    Info info = get_info();
-    switch (info.error_type) {
-      case ErrorType::general:
-        sb << "[Error";
-        break;
-      case ErrorType::os:
-#if TD_PORT_POSIX
-        sb << "[PosixError : " << strerror_safe(info.error_code);
-#elif TD_PORT_WINDOWS
-        sb << "[WindowsError : " << winerror_to_string(info.error_code);
-#endif
-        break;
-      default:
-        UNREACHABLE();
-        break;
-    }
-    sb << " : " << code() << " : " << message() << "]";
-    return sb;
-  }
+  StringBuilder &print(StringBuilder &sb) const TD_COLD;
 
-  string to_string() const {
-    auto buf = StackAllocator::alloc(4096);
-    StringBuilder sb(buf.as_slice());
-    print(sb);
-    return sb.as_cslice().str();
-  }
+  string to_string() const TD_COLD;
 
   // Default interface
   bool is_ok() const TD_WARN_UNUSED_RESULT {
@@ -216,25 +180,7 @@ class Status {
     return CSlice(ptr_.get() + sizeof(Info));
   }
 
-  string public_message() const {
-    if (is_ok()) {
-      return "OK";
-    }
-    Info info = get_info();
-    switch (info.error_type) {
-      case ErrorType::general:
-        return message().str();
-      case ErrorType::os:
-#if TD_PORT_POSIX
-        return strerror_safe(info.error_code).str();
-#elif TD_PORT_WINDOWS
-        return winerror_to_string(info.error_code);
-#endif
-      default:
-        UNREACHABLE();
-        return "";
-    }
-  }
+  string public_message() const TD_COLD;
 
   const Status &error() const {
     return *this;
@@ -264,16 +210,9 @@ class Status {
   };
   std::unique_ptr<char[], Deleter> ptr_;
 
-  Status(Info info, Slice message) {
-    size_t size = sizeof(Info) + message.size() + 1;
-    ptr_ = std::unique_ptr<char[], Deleter>(new char[size]);
-    char *ptr = ptr_.get();
-    reinterpret_cast<Info *>(ptr)[0] = info;
-    ptr += sizeof(Info);
-    std::memcpy(ptr, message.begin(), message.size());
-    ptr += message.size();
-    *ptr = 0;
-  }
+  // out of line and cold: error construction shouldn't be inlined into the
+  // happy path of every caller
+  Status(Info info, Slice message) TD_COLD;
 
   Status(bool static_flag, ErrorType error_type, int error_code, Slice message)
       : Status(to_info(static_flag, error_type, error_code), message) {
@@ -286,33 +225,7 @@ class Status {
     return result;
   }
 
-  static Info to_info(bool static_flag, ErrorType error_type, int error_code) {
-    const int MIN_ERROR_CODE = -(1 << 22) + 1;
-    const int MAX_ERROR_CODE = (1 << 22) - 1;
-    Info tmp;
-    tmp.static_flag = static_flag;
-    tmp.error_type = error_type;
-
-    if (error_code < MIN_ERROR_CODE) {
-      LOG(ERROR) << "Error code value is altered from " << error_code;
-      error_code = MIN_ERROR_CODE;
-    }
-    if (error_code > MAX_ERROR_CODE) {
-      LOG(ERROR) << "Error code value is altered from " << error_code;
-      error_code = MAX_ERROR_CODE;
-    }
-
-#if TD_GCC
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wconversion"
-#endif
-    tmp.error_code = error_code;
-#if TD_GCC
-#pragma GCC diagnostic pop
-#endif
-    CHECK(error_code == tmp.error_code);
-    return tmp;
-  }
+  static Info to_info(bool static_flag, ErrorType error_type, int error_code) TD_COLD;
 
   Info get_info() const {
     return get_info(ptr_.get());
@@ -8,6 +8,7 @@
 
 #include "td/utils/StorerBase.h"
 
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/Slice.h"
 #include "td/utils/tl_storers.h"
@@ -30,6 +31,9 @@ class SliceStorer : public Storer {
     std::memcpy(ptr, slice.ubegin(), slice.size());
     return slice.size();
   }
+  void store_chain(ChainBufferWriter &writer) const override {
+    writer.append(slice);
+  }
 };
 
 inline SliceStorer create_storer(Slice slice) {
@@ -54,6 +58,11 @@ class ConcatStorer : public Storer {
     ptr += b_.store(ptr);
     return ptr - ptr_save;
   }
+
+  void store_chain(ChainBufferWriter &writer) const override {
+    a_.store_chain(writer);
+    b_.store_chain(writer);
+  }
 };
 
 inline ConcatStorer create_storer(const Storer &a, const Storer &b) {
@@ -74,6 +83,10 @@ class DefaultStorer : public Storer {
   size_t store(uint8 *ptr) const override {
     return tl_store_unsafe(object_, ptr);
   }
+  void store_chain(ChainBufferWriter &writer) const override {
+    TlStorerToChainBuffer storer(writer);
+    object_.store(storer);
+  }
 
  private:
   mutable size_t size_ = std::numeric_limits<size_t>::max();
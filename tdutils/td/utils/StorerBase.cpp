@@ -0,0 +1,20 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/StorerBase.h"
+
+#include "td/utils/buffer.h"
+
+namespace td {
+
+void Storer::store_chain(ChainBufferWriter &writer) const {
+  BufferSlice slice(size());
+  auto real_size = store(slice.as_slice().ubegin());
+  CHECK(real_size == slice.size());
+  writer.append(std::move(slice));
+}
+
+}  // namespace td
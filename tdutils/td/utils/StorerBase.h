@@ -10,6 +10,8 @@
 
 namespace td {
 
+class ChainBufferWriter;
+
 class Storer {
  public:
   Storer() = default;
@@ -20,6 +22,10 @@ class Storer {
   virtual ~Storer() = default;
   virtual size_t size() const = 0;
   virtual size_t store(uint8 *ptr) const TD_WARN_UNUSED_RESULT = 0;
+
+  // appends the serialized data to writer in a single pass. The default implementation
+  // falls back to the two-pass size() + store() into a contiguous buffer
+  virtual void store_chain(ChainBufferWriter &writer) const;
 };
 
 }  // namespace td
@@ -16,6 +16,7 @@
 #include <locale>
 #include <memory>
 #include <sstream>
+#include <type_traits>
 #include <utility>
 
 namespace td {
@@ -51,48 +52,64 @@ StringBuilder &StringBuilder::operator<<(Slice slice) {
   return *this;
 }
 
+static const char two_digits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 template <class T>
 static char *print_uint(char *current_ptr, T x) {
   if (x < 100) {
     if (x < 10) {
       *current_ptr++ = static_cast<char>('0' + x);
     } else {
-      *current_ptr++ = static_cast<char>('0' + x / 10);
-      *current_ptr++ = static_cast<char>('0' + x % 10);
+      const char *p = two_digits + static_cast<int>(x) * 2;
+      *current_ptr++ = p[0];
+      *current_ptr++ = p[1];
     }
     return current_ptr;
   }
 
-  auto begin_ptr = current_ptr;
-  do {
-    *current_ptr++ = static_cast<char>('0' + x % 10);
-    x /= 10;
-  } while (x > 0);
-
-  auto end_ptr = current_ptr - 1;
-  while (begin_ptr < end_ptr) {
-    std::swap(*begin_ptr++, *end_ptr--);
+  // digits are produced backward in pairs, each pair costing one division
+  // and one table lookup
+  char buf[20];  // enough for 2^64 - 1
+  char *ptr = buf + sizeof(buf);
+  while (x >= 100) {
+    const char *p = two_digits + static_cast<int>(x % 100) * 2;
+    x /= 100;
+    *--ptr = p[1];
+    *--ptr = p[0];
+  }
+  if (x < 10) {
+    *--ptr = static_cast<char>('0' + x);
+  } else {
+    const char *p = two_digits + static_cast<int>(x) * 2;
+    *--ptr = p[1];
+    *--ptr = p[0];
   }
 
-  return current_ptr;
+  auto len = static_cast<size_t>(buf + sizeof(buf) - ptr);
+  std::memcpy(current_ptr, ptr, len);
+  return current_ptr + len;
 }
 
 template <class T>
 static char *print_int(char *current_ptr, T x) {
+  auto ux = static_cast<typename std::make_unsigned<T>::type>(x);
   if (x < 0) {
-    if (x == std::numeric_limits<T>::min()) {
-      std::stringstream ss;
-      ss << x;
-      auto len = narrow_cast<int>(static_cast<std::streamoff>(ss.tellp()));
-      ss.read(current_ptr, len);
-      return current_ptr + len;
-    }
-
+    // negating the unsigned value is well-defined even for the minimum
     *current_ptr++ = '-';
-    x = -x;
+    ux = 0 - ux;
   }
 
-  return print_uint(current_ptr, x);
+  return print_uint(current_ptr, ux);
 }
 
 bool StringBuilder::reserve_inner(size_t size) {
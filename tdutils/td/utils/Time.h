@@ -15,11 +15,14 @@ namespace td {
 
 class Time {
  public:
+  // reads the precise monotonic clock and refreshes the coarse cached time
   static double now() {
     double now = Clocks::monotonic();
     now_.store(now, std::memory_order_relaxed);
     return now;
   }
+  // coarse time, refreshed at least once per scheduler event-loop iteration;
+  // prefer it on hot paths, where submillisecond precision isn't needed
   static double now_cached() {
     return now_.load(std::memory_order_relaxed);
   }
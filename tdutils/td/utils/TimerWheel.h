@@ -0,0 +1,167 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+
+namespace td {
+
+// Hashed timer wheel with O(1) insert and cancel for near-future timers.
+// Timers are kept in an array of slots of tick_ seconds each; timers beyond the wheel
+// horizon are kept in a KHeap and are promoted into the wheel as time advances.
+//
+// It reuses HeapNode as the intrusive node type, so existing KHeap users can switch
+// to TimerWheel without changing their node layout. While a node is inside a wheel slot,
+// its pos_ holds SLOT_BASE + slot index; smaller values mean that the node is inside
+// the fallback heap, which manages pos_ itself.
+class TimerWheel {
+ public:
+  TimerWheel() : TimerWheel(0.05, 12) {
+  }
+  TimerWheel(double tick, int32 slot_count_log) : tick_(tick), slots_(static_cast<size_t>(1) << slot_count_log) {
+    mask_ = slots_.size() - 1;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+  void insert(double key, HeapNode *node) {
+    CHECK(!node->in_heap());
+    if (get_tick(key) >= current_tick_ + static_cast<int64>(slots_.size())) {
+      far_heap_.insert(key, node);
+      CHECK(node->pos_ < SLOT_BASE);
+    } else {
+      auto slot = get_slot(key);
+      slots_[slot].push_back(Item{key, node});
+      node->pos_ = SLOT_BASE + static_cast<int>(slot);
+      wheel_size_++;
+    }
+    size_++;
+  }
+
+  void erase(HeapNode *node) {
+    CHECK(node->in_heap());
+    if (node->pos_ >= SLOT_BASE) {
+      auto &slot = slots_[node->pos_ - SLOT_BASE];
+      for (size_t i = 0; i < slot.size(); i++) {
+        if (slot[i].node_ == node) {
+          slot[i] = slot.back();
+          slot.pop_back();
+          break;
+        }
+      }
+      node->remove();
+      wheel_size_--;
+    } else {
+      far_heap_.erase(node);
+    }
+    size_--;
+  }
+
+  void fix(double key, HeapNode *node) {
+    erase(node);
+    insert(key, node);
+  }
+
+  // Returns some timer with key less than now, or nullptr if there is no such timer.
+  // Timers inside one slot are returned in unspecified order.
+  HeapNode *pop_expired(double now) {
+    auto end_tick = get_tick(now);
+    while (size_ != 0 && current_tick_ <= end_tick) {
+      if (wheel_size_ == 0) {
+        // jump over the empty stretch to the first timer in the fallback heap
+        auto top_tick = get_tick(far_heap_.top_key());
+        if (top_tick > current_tick_) {
+          current_tick_ = min(top_tick, end_tick);
+        }
+      }
+      promote();
+      auto &slot = slots_[current_tick_ & mask_];
+      for (size_t i = 0; i < slot.size(); i++) {
+        if (slot[i].key_ < now) {
+          HeapNode *node = slot[i].node_;
+          slot[i] = slot.back();
+          slot.pop_back();
+          node->remove();
+          size_--;
+          wheel_size_--;
+          return node;
+        }
+      }
+      if (current_tick_ == end_tick) {
+        break;
+      }
+      CHECK(slot.empty());
+      current_tick_++;
+    }
+    return nullptr;
+  }
+
+  // Returns the key of the earliest timer. All timers inside one slot are
+  // reported as the minimum key of the slot, so the result is never too late.
+  double next_timeout() const {
+    CHECK(!empty());
+    for (int64 tick = current_tick_; tick < current_tick_ + static_cast<int64>(slots_.size()); tick++) {
+      auto &slot = slots_[tick & mask_];
+      if (!slot.empty()) {
+        double result = slot[0].key_;
+        for (size_t i = 1; i < slot.size(); i++) {
+          result = min(result, slot[i].key_);
+        }
+        return result;
+      }
+    }
+    CHECK(!far_heap_.empty());
+    return far_heap_.top_key();
+  }
+
+ private:
+  static constexpr int SLOT_BASE = 1 << 29;
+
+  struct Item {
+    double key_;
+    HeapNode *node_;
+  };
+
+  double tick_;
+  vector<vector<Item>> slots_;
+  size_t mask_{0};
+  size_t size_{0};
+  size_t wheel_size_{0};
+  int64 current_tick_{0};
+  KHeap<double> far_heap_;
+
+  int64 get_tick(double key) const {
+    return static_cast<int64>(max(key, 0.0) / tick_);
+  }
+  size_t get_slot(double key) const {
+    auto tick = get_tick(key);
+    if (tick < current_tick_) {
+      tick = current_tick_;
+    }
+    return static_cast<size_t>(tick) & mask_;
+  }
+
+  void promote() {
+    while (!far_heap_.empty() &&
+           get_tick(far_heap_.top_key()) < current_tick_ + static_cast<int64>(slots_.size())) {
+      double key = far_heap_.top_key();
+      HeapNode *node = far_heap_.pop();
+      auto slot = get_slot(key);
+      slots_[slot].push_back(Item{key, node});
+      node->pos_ = SLOT_BASE + static_cast<int>(slot);
+      wheel_size_++;
+    }
+  }
+};
+
+}  // namespace td
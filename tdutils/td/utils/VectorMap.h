@@ -0,0 +1,163 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+#include <array>
+#include <functional>
+#include <utility>
+
+namespace td {
+
+// A map backed by a vector of key-value pairs kept sorted by key, for maps which are
+// overwhelmingly tiny and looked up much more often than they are changed. Lookups are
+// a binary search over one contiguous array, and the first inline_capacity entries live
+// inside the map itself, so small maps don't allocate at all.
+//
+// Restrictions compared to std::map:
+// - KeyT and ValueT must be default-constructible and movable;
+// - insert and erase are linear in the map size and invalidate all iterators;
+// - iteration visits entries in key order, not in insertion order.
+template <class KeyT, class ValueT, size_t inline_capacity = 8, class CmpT = std::less<KeyT>>
+class VectorMap {
+ public:
+  using key_type = KeyT;
+  using mapped_type = ValueT;
+  using value_type = std::pair<KeyT, ValueT>;
+  using iterator = value_type *;
+  using const_iterator = const value_type *;
+
+  iterator begin() {
+    return data();
+  }
+  iterator end() {
+    return data() + size_;
+  }
+  const_iterator begin() const {
+    return data();
+  }
+  const_iterator end() const {
+    return data() + size_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    for (size_t i = 0; i < min(size_, inline_capacity); i++) {
+      inline_nodes_[i] = value_type();
+    }
+    heap_nodes_.clear();
+    is_big_ = false;
+    size_ = 0;
+  }
+
+  iterator find(const KeyT &key) {
+    auto *node = lower_bound(key);
+    return node != end() && !CmpT()(key, node->first) ? node : end();
+  }
+  const_iterator find(const KeyT &key) const {
+    return const_cast<VectorMap *>(this)->find(key);
+  }
+
+  size_t count(const KeyT &key) const {
+    return find(key) == end() ? 0 : 1;
+  }
+
+  std::pair<iterator, bool> emplace(KeyT key, ValueT value) {
+    auto *node = lower_bound(key);
+    if (node != end() && !CmpT()(key, node->first)) {
+      return {node, false};
+    }
+    auto pos = static_cast<size_t>(node - data());
+    if (!is_big_ && size_ == inline_capacity) {
+      spill_to_heap();
+    }
+    if (is_big_) {
+      heap_nodes_.insert(heap_nodes_.begin() + pos, value_type(std::move(key), std::move(value)));
+    } else {
+      for (size_t i = size_; i > pos; i--) {
+        inline_nodes_[i] = std::move(inline_nodes_[i - 1]);
+      }
+      inline_nodes_[pos] = value_type(std::move(key), std::move(value));
+    }
+    size_++;
+    return {data() + pos, true};
+  }
+
+  ValueT &operator[](const KeyT &key) {
+    return emplace(key, ValueT()).first->second;
+  }
+
+  size_t erase(const KeyT &key) {
+    auto *node = find(key);
+    if (node == end()) {
+      return 0;
+    }
+    erase(node);
+    return 1;
+  }
+
+  void erase(iterator it) {
+    CHECK(it != end());
+    auto pos = static_cast<size_t>(it - data());
+    if (is_big_) {
+      heap_nodes_.erase(heap_nodes_.begin() + pos);
+    } else {
+      for (size_t i = pos + 1; i < size_; i++) {
+        inline_nodes_[i - 1] = std::move(inline_nodes_[i]);
+      }
+      inline_nodes_[size_ - 1] = value_type();
+    }
+    size_--;
+  }
+
+ private:
+  std::array<value_type, inline_capacity> inline_nodes_;
+  vector<value_type> heap_nodes_;
+  size_t size_ = 0;
+  bool is_big_ = false;
+
+  value_type *data() {
+    return is_big_ ? heap_nodes_.data() : inline_nodes_.data();
+  }
+  const value_type *data() const {
+    return is_big_ ? heap_nodes_.data() : inline_nodes_.data();
+  }
+
+  value_type *lower_bound(const KeyT &key) {
+    auto *l = data();
+    auto n = size_;
+    while (n > 0) {
+      auto half = n / 2;
+      if (CmpT()(l[half].first, key)) {
+        l += half + 1;
+        n -= half + 1;
+      } else {
+        n = half;
+      }
+    }
+    return l;
+  }
+
+  void spill_to_heap() {
+    heap_nodes_.reserve(inline_capacity * 2);
+    for (auto &node : inline_nodes_) {
+      heap_nodes_.push_back(std::move(node));
+      node = value_type();
+    }
+    is_big_ = true;
+  }
+};
+
+}  // namespace td
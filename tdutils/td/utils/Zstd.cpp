@@ -0,0 +1,103 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/Zstd.h"
+
+char disable_linker_warning_about_empty_file_zstd_cpp TD_UNUSED;
+
+#if TD_HAVE_ZSTD
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <cstring>
+
+#include <zdict.h>
+#include <zstd.h>
+
+namespace td {
+
+static constexpr size_t ZSTD_MAX_DECODED_SIZE = 1 << 30;
+
+BufferSlice zstd_encode(Slice data, int compression_level, Slice dictionary) {
+  auto max_size = ZSTD_compressBound(data.size());
+  BufferSlice result(max_size);
+  size_t size;
+  if (dictionary.empty()) {
+    size = ZSTD_compress(result.as_slice().begin(), max_size, data.begin(), data.size(), compression_level);
+  } else {
+    auto *context = ZSTD_createCCtx();
+    if (context == nullptr) {
+      return BufferSlice();
+    }
+    size = ZSTD_compress_usingDict(context, result.as_slice().begin(), max_size, data.begin(), data.size(),
+                                   dictionary.begin(), dictionary.size(), compression_level);
+    ZSTD_freeCCtx(context);
+  }
+  if (ZSTD_isError(size)) {
+    LOG(ERROR) << "Zstd compression failed: " << ZSTD_getErrorName(size);
+    return BufferSlice();
+  }
+  result.truncate(size);
+  return result;
+}
+
+Result<BufferSlice> zstd_decode(Slice data, Slice dictionary) {
+  auto content_size = ZSTD_getFrameContentSize(data.begin(), data.size());
+  if (content_size == ZSTD_CONTENTSIZE_ERROR || content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+    return Status::Error("Not a valid zstd frame");
+  }
+  if (content_size > ZSTD_MAX_DECODED_SIZE) {
+    return Status::Error(PSLICE() << "Zstd frame is too big: " << content_size);
+  }
+  BufferSlice result(narrow_cast<size_t>(content_size));
+  size_t size;
+  if (dictionary.empty()) {
+    size = ZSTD_decompress(result.as_slice().begin(), result.size(), data.begin(), data.size());
+  } else {
+    auto *context = ZSTD_createDCtx();
+    if (context == nullptr) {
+      return Status::Error("Failed to create zstd decompression context");
+    }
+    size = ZSTD_decompress_usingDict(context, result.as_slice().begin(), result.size(), data.begin(), data.size(),
+                                     dictionary.begin(), dictionary.size());
+    ZSTD_freeDCtx(context);
+  }
+  if (ZSTD_isError(size)) {
+    return Status::Error(PSLICE() << "Zstd decompression failed: " << ZSTD_getErrorName(size));
+  }
+  if (size != content_size) {
+    return Status::Error("Zstd frame content size mismatch");
+  }
+  return std::move(result);
+}
+
+bool is_zstd_frame(Slice data) {
+  // unlike ZSTD_isFrame, works with any zstd version and without skippable frames
+  static const unsigned char MAGIC[4] = {0x28, 0xB5, 0x2F, 0xFD};
+  return data.size() >= 4 && std::memcmp(data.begin(), MAGIC, 4) == 0;
+}
+
+Result<BufferSlice> zstd_train_dictionary(Span<BufferSlice> samples, size_t max_size) {
+  string data;
+  vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (auto &sample : samples) {
+    data.append(sample.as_slice().data(), sample.size());
+    sizes.push_back(sample.size());
+  }
+  BufferSlice dictionary(max_size);
+  auto size = ZDICT_trainFromBuffer(dictionary.as_slice().begin(), max_size, data.c_str(), sizes.data(),
+                                    narrow_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(size)) {
+    return Status::Error(PSLICE() << "Zstd dictionary training failed: " << ZDICT_getErrorName(size));
+  }
+  dictionary.truncate(size);
+  return std::move(dictionary);
+}
+
+}  // namespace td
+
+#endif
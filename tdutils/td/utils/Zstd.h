@@ -0,0 +1,36 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#if TD_HAVE_ZSTD
+#include "td/utils/buffer.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Span.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// One-shot zstd codec. An empty dictionary means no dictionary is used;
+// a dictionary trained with zstd_train_dictionary over samples of the stored
+// data noticeably improves the ratio on small repetitive blobs.
+
+// returns an empty BufferSlice on failure
+BufferSlice zstd_encode(Slice data, int compression_level = 3, Slice dictionary = Slice());
+
+Result<BufferSlice> zstd_decode(Slice data, Slice dictionary = Slice());
+
+// checks for the zstd frame magic number, i.e. whether the data could have
+// been produced by zstd_encode
+bool is_zstd_frame(Slice data);
+
+Result<BufferSlice> zstd_train_dictionary(Span<BufferSlice> samples, size_t max_size);
+
+}  // namespace td
+
+#endif
@@ -18,34 +18,48 @@ namespace td {
 
 static const char *const symbols64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-string base64_encode(Slice input) {
-  string base64;
-  base64.reserve((input.size() + 2) / 3 * 4);
-  for (size_t i = 0; i < input.size();) {
-    size_t left = min(input.size() - i, static_cast<size_t>(3));
-    int c = input.ubegin()[i++] << 16;
-    base64 += symbols64[c >> 18];
-    if (left != 1) {
-      c |= input.ubegin()[i++] << 8;
-    }
-    base64 += symbols64[(c >> 12) & 63];
-    if (left == 3) {
-      c |= input.ubegin()[i++];
-    }
-    if (left != 1) {
-      base64 += symbols64[(c >> 6) & 63];
-    } else {
-      base64 += '=';
-    }
-    if (left == 3) {
-      base64 += symbols64[c & 63];
-    } else {
-      base64 += '=';
+static string base64_encode_impl(Slice input, const char *symbols, bool with_padding) {
+  auto tail_size = input.size() % 3;
+  auto result_size = input.size() / 3 * 4;
+  if (tail_size != 0) {
+    result_size += with_padding ? 4 : tail_size + 1;
+  }
+  string base64(result_size, '\0');
+  char *dest = &base64[0];
+  auto *src = input.ubegin();
+  auto *src_end = src + (input.size() - tail_size);
+  while (src != src_end) {
+    uint32 c = (static_cast<uint32>(src[0]) << 16) | (static_cast<uint32>(src[1]) << 8) | src[2];
+    src += 3;
+    dest[0] = symbols[c >> 18];
+    dest[1] = symbols[(c >> 12) & 63];
+    dest[2] = symbols[(c >> 6) & 63];
+    dest[3] = symbols[c & 63];
+    dest += 4;
+  }
+  if (tail_size != 0) {
+    uint32 c = static_cast<uint32>(src[0]) << 16;
+    if (tail_size == 2) {
+      c |= static_cast<uint32>(src[1]) << 8;
+    }
+    *dest++ = symbols[c >> 18];
+    *dest++ = symbols[(c >> 12) & 63];
+    if (tail_size == 2) {
+      *dest++ = symbols[(c >> 6) & 63];
+    } else if (with_padding) {
+      *dest++ = '=';
+    }
+    if (with_padding) {
+      *dest++ = '=';
     }
   }
   return base64;
 }
 
+string base64_encode(Slice input) {
+  return base64_encode_impl(input, symbols64, true);
+}
+
 static unsigned char char_to_value[256];
 static void init_base64_table() {
   static bool is_inited = []() {
@@ -58,6 +72,54 @@ static void init_base64_table() {
   CHECK(is_inited);
 }
 
+static Result<string> base64_decode_impl(Slice base64, const unsigned char *table) {
+  auto tail_size = base64.size() % 4;
+  // the callers have already checked the length, so the tail is never a single character
+  CHECK(tail_size != 1);
+
+  string output(base64.size() / 4 * 3 + (tail_size == 0 ? 0 : tail_size - 1), '\0');
+  char *dest = &output[0];
+  auto *src = base64.ubegin();
+  auto *src_end = src + (base64.size() - tail_size);
+  while (src != src_end) {
+    uint32 v0 = table[src[0]];
+    uint32 v1 = table[src[1]];
+    uint32 v2 = table[src[2]];
+    uint32 v3 = table[src[3]];
+    if (((v0 | v1 | v2 | v3) & 64) != 0) {
+      return Status::Error("Wrong character in the string");
+    }
+    uint32 c = (v0 << 18) | (v1 << 12) | (v2 << 6) | v3;
+    dest[0] = static_cast<char>(static_cast<unsigned char>(c >> 16));  // implementation-defined
+    dest[1] = static_cast<char>(static_cast<unsigned char>(c >> 8));   // implementation-defined
+    dest[2] = static_cast<char>(static_cast<unsigned char>(c));        // implementation-defined
+    src += 4;
+    dest += 3;
+  }
+  if (tail_size != 0) {
+    uint32 c = 0;
+    for (size_t t = 0; t < tail_size; t++) {
+      auto value = table[src[t]];
+      if (value == 64) {
+        return Status::Error("Wrong character in the string");
+      }
+      c |= static_cast<uint32>(value) << ((3 - t) * 6);
+    }
+    *dest++ = static_cast<char>(static_cast<unsigned char>(c >> 16));  // implementation-defined
+    if (tail_size == 2) {
+      if ((c & ((1 << 16) - 1)) != 0) {
+        return Status::Error("Wrong padding in the string");
+      }
+    } else {
+      *dest++ = static_cast<char>(static_cast<unsigned char>(c >> 8));  // implementation-defined
+      if ((c & ((1 << 8) - 1)) != 0) {
+        return Status::Error("Wrong padding in the string");
+      }
+    }
+  }
+  return std::move(output);
+}
+
 Result<string> base64_decode(Slice base64) {
   init_base64_table();
 
@@ -74,61 +136,13 @@ Result<string> base64_decode(Slice base64) {
     return Status::Error("Wrong string padding");
   }
 
-  string output;
-  output.reserve(((base64.size() + 3) >> 2) * 3);
-  for (size_t i = 0; i < base64.size();) {
-    size_t left = min(base64.size() - i, static_cast<size_t>(4));
-    int c = 0;
-    for (size_t t = 0; t < left; t++) {
-      auto value = char_to_value[base64.ubegin()[i++]];
-      if (value == 64) {
-        return Status::Error("Wrong character in the string");
-      }
-      c |= value << ((3 - t) * 6);
-    }
-    output += static_cast<char>(static_cast<unsigned char>(c >> 16));  // implementation-defined
-    if (left == 2) {
-      if ((c & ((1 << 16) - 1)) != 0) {
-        return Status::Error("Wrong padding in the string");
-      }
-    } else {
-      output += static_cast<char>(static_cast<unsigned char>(c >> 8));  // implementation-defined
-      if (left == 3) {
-        if ((c & ((1 << 8) - 1)) != 0) {
-          return Status::Error("Wrong padding in the string");
-        }
-      } else {
-        output += static_cast<char>(static_cast<unsigned char>(c));  // implementation-defined
-      }
-    }
-  }
-  return output;
+  return base64_decode_impl(base64, char_to_value);
 }
 
 static const char *const url_symbols64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
 
 string base64url_encode(Slice input) {
-  string base64;
-  base64.reserve((input.size() + 2) / 3 * 4);
-  for (size_t i = 0; i < input.size();) {
-    size_t left = min(input.size() - i, static_cast<size_t>(3));
-    int c = input.ubegin()[i++] << 16;
-    base64 += url_symbols64[c >> 18];
-    if (left != 1) {
-      c |= input.ubegin()[i++] << 8;
-    }
-    base64 += url_symbols64[(c >> 12) & 63];
-    if (left == 3) {
-      c |= input.ubegin()[i++];
-    }
-    if (left != 1) {
-      base64 += url_symbols64[(c >> 6) & 63];
-    }
-    if (left == 3) {
-      base64 += url_symbols64[c & 63];
-    }
-  }
-  return base64;
+  return base64_encode_impl(input, url_symbols64, false);
 }
 
 static unsigned char url_char_to_value[256];
@@ -159,35 +173,7 @@ Result<string> base64url_decode(Slice base64) {
     return Status::Error("Wrong string length");
   }
 
-  string output;
-  output.reserve(((base64.size() + 3) >> 2) * 3);
-  for (size_t i = 0; i < base64.size();) {
-    size_t left = min(base64.size() - i, static_cast<size_t>(4));
-    int c = 0;
-    for (size_t t = 0; t < left; t++) {
-      auto value = url_char_to_value[base64.ubegin()[i++]];
-      if (value == 64) {
-        return Status::Error("Wrong character in the string");
-      }
-      c |= value << ((3 - t) * 6);
-    }
-    output += static_cast<char>(static_cast<unsigned char>(c >> 16));  // implementation-defined
-    if (left == 2) {
-      if ((c & ((1 << 16) - 1)) != 0) {
-        return Status::Error("Wrong padding in the string");
-      }
-    } else {
-      output += static_cast<char>(static_cast<unsigned char>(c >> 8));  // implementation-defined
-      if (left == 3) {
-        if ((c & ((1 << 8) - 1)) != 0) {
-          return Status::Error("Wrong padding in the string");
-        }
-      } else {
-        output += static_cast<char>(static_cast<unsigned char>(c));  // implementation-defined
-      }
-    }
-  }
-  return output;
+  return base64_decode_impl(base64, url_char_to_value);
 }
 
 template <bool is_url>
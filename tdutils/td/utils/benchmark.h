@@ -6,15 +6,35 @@
 //
 #pragma once
 
+#include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/Clocks.h"
+#include "td/utils/port/platform.h"
 #include "td/utils/StringBuilder.h"
 
 #include <cmath>
+#include <cstddef>
 #include <tuple>
 #include <utility>
 
+#if TD_LINUX
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if TD_LINUX && (TD_GCC || TD_CLANG)
+#define TD_BENCHMARK_MEMPROF 1
+// provided by memprof and resolved only when the benchmark is linked against it;
+// otherwise the weak references stay null and allocation counting is disabled
+bool is_memprof_on() __attribute__((weak));
+std::size_t get_alloc_count() __attribute__((weak));
+#endif
+
 #define BENCH(name, desc)                          \
   class name##Bench : public ::td::Benchmark {     \
    public:                                         \
@@ -68,12 +88,129 @@ class Benchmark {
   virtual void run(int n) = 0;
 };
 
-inline std::pair<double, double> bench_n(Benchmark &b, int n) {
+struct BenchStat {
+  uint64 instructions = 0;
+  uint64 cycles = 0;
+  uint64 cache_misses = 0;
+  uint64 branch_misses = 0;
+  uint64 alloc_count = 0;
+  bool has_hardware_counters = false;
+  bool has_alloc_count = false;
+};
+
+namespace detail {
+
+class BenchPerfCounters {
+ public:
+#if TD_LINUX
+  BenchPerfCounters() {
+    static const uint32 configs[COUNTER_COUNT] = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+                                                  PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds_[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+      if (fds_[i] < 0) {
+        // no PMU or no permissions; hardware counters are silently disabled
+        close_all();
+        return;
+      }
+    }
+    is_valid_ = true;
+  }
+  BenchPerfCounters(const BenchPerfCounters &) = delete;
+  BenchPerfCounters &operator=(const BenchPerfCounters &) = delete;
+  ~BenchPerfCounters() {
+    close_all();
+  }
+
+  void start() {
+    for (std::size_t i = 0; i < COUNTER_COUNT && is_valid_; i++) {
+      ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  void stop() {
+    for (std::size_t i = 0; i < COUNTER_COUNT && is_valid_; i++) {
+      ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  bool read_into(BenchStat &stat) {
+    if (!is_valid_) {
+      return false;
+    }
+    uint64 values[COUNTER_COUNT];
+    for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+      if (read(fds_[i], &values[i], sizeof(uint64)) != static_cast<ssize_t>(sizeof(uint64))) {
+        return false;
+      }
+    }
+    stat.instructions = values[0];
+    stat.cycles = values[1];
+    stat.cache_misses = values[2];
+    stat.branch_misses = values[3];
+    return true;
+  }
+
+ private:
+  static constexpr std::size_t COUNTER_COUNT = 4;
+  int fds_[COUNTER_COUNT] = {-1, -1, -1, -1};
+  bool is_valid_ = false;
+
+  void close_all() {
+    for (auto &fd : fds_) {
+      if (fd >= 0) {
+        close(fd);
+        fd = -1;
+      }
+    }
+    is_valid_ = false;
+  }
+#else
+  void start() {
+  }
+  void stop() {
+  }
+  bool read_into(BenchStat &) {
+    return false;
+  }
+#endif
+};
+
+}  // namespace detail
+
+inline std::pair<double, double> bench_n(Benchmark &b, int n, BenchStat *stat = nullptr) {
   double total = -Clocks::monotonic();
   b.start_up_n(n);
+  detail::BenchPerfCounters counters;
+#if TD_BENCHMARK_MEMPROF
+  uint64 start_alloc_count = 0;
+  bool has_alloc_count = &::is_memprof_on != nullptr && &::get_alloc_count != nullptr && ::is_memprof_on();
+  if (has_alloc_count) {
+    start_alloc_count = ::get_alloc_count();
+  }
+#endif
+  counters.start();
   double t = -Clocks::monotonic();
   b.run(n);
   t += Clocks::monotonic();
+  counters.stop();
+  if (stat != nullptr) {
+    *stat = BenchStat();
+    stat->has_hardware_counters = counters.read_into(*stat);
+#if TD_BENCHMARK_MEMPROF
+    if (has_alloc_count) {
+      stat->alloc_count = ::get_alloc_count() - start_alloc_count;
+      stat->has_alloc_count = true;
+    }
+#endif
+  }
   b.tear_down();
   total += Clocks::monotonic();
 
@@ -88,9 +225,10 @@ inline void bench(Benchmark &b, double max_time = 1.0) {
   int n = 1;
   double pass_time = 0;
   double total_pass_time = 0;
+  BenchStat stat;
   while (pass_time < max_time && total_pass_time < max_time * 3 && n < (1 << 30)) {
     n *= 2;
-    std::tie(pass_time, total_pass_time) = bench_n(b, n);
+    std::tie(pass_time, total_pass_time) = bench_n(b, n, &stat);
   }
   pass_time = n / pass_time;
 
@@ -101,7 +239,7 @@ inline void bench(Benchmark &b, double max_time = 1.0) {
   double max_pass_time = pass_time;
 
   for (int i = 1; i < pass_cnt; i++) {
-    pass_time = n / bench_n(b, n).first;
+    pass_time = n / bench_n(b, n, &stat).first;
     sum += pass_time;
     square_sum += pass_time * pass_time;
     if (pass_time < min_pass_time) {
@@ -123,6 +261,19 @@ inline void bench(Benchmark &b, double max_time = 1.0) {
   LOG(ERROR) << "Bench [" << pad << description << "]: " << StringBuilder::FixedDouble(average, 3) << '['
              << StringBuilder::FixedDouble(min_pass_time, 3) << '-' << StringBuilder::FixedDouble(max_pass_time, 3)
              << "] ops/sec,\t" << format::as_time(1 / average) << " [d = " << StringBuilder::FixedDouble(d, 6) << ']';
+  if (stat.has_hardware_counters || stat.has_alloc_count) {
+    auto per_op = [n](uint64 count) {
+      return StringBuilder::FixedDouble(static_cast<double>(count) / n, 1);
+    };
+    if (stat.has_hardware_counters) {
+      LOG(ERROR) << "      per op: " << per_op(stat.instructions) << " instructions, " << per_op(stat.cycles)
+                 << " cycles, " << per_op(stat.cache_misses) << " cache misses, " << per_op(stat.branch_misses)
+                 << " branch misses";
+    }
+    if (stat.has_alloc_count) {
+      LOG(ERROR) << "      per op: " << per_op(stat.alloc_count) << " allocations";
+    }
+  }
 }
 
 inline void bench(Benchmark &&b, double max_time = 1.0) {
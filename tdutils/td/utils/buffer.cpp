@@ -20,6 +20,13 @@
 
 namespace td {
 
+// Readers below MAX_FAST_READER_SIZE are carved out of a shared thread-local slab with
+// per-slab reference counting instead of getting a BufferRaw of their own. MTProto packets
+// are mostly sub-1KB, so with these limits the read path of a connection allocates about
+// once per 64KB of traffic instead of once per packet
+static constexpr size_t MAX_FAST_READER_SIZE = 1 << 10;
+static constexpr size_t READER_SLAB_SIZE = 1 << 16;
+
 TD_THREAD_LOCAL BufferAllocator::BufferRawTls *BufferAllocator::buffer_raw_tls;  // static zero-initialized
 
 std::atomic<size_t> BufferAllocator::buffer_mem;
@@ -47,7 +54,7 @@ BufferAllocator::WriterPtr BufferAllocator::create_writer(size_t size, size_t pr
 }
 
 BufferAllocator::ReaderPtr BufferAllocator::create_reader(size_t size) {
-  if (size < 512) {
+  if (size < MAX_FAST_READER_SIZE) {
     return create_reader_fast(size);
   }
   auto ptr = create_writer_exact(size);
@@ -62,7 +69,7 @@ BufferAllocator::ReaderPtr BufferAllocator::create_reader_fast(size_t size) {
 
   auto buffer_raw = buffer_raw_tls->buffer_raw.get();
   if (buffer_raw == nullptr || buffer_raw->data_size_ - buffer_raw->end_.load(std::memory_order_relaxed) < size) {
-    buffer_raw = create_buffer_raw(4096 * 4);
+    buffer_raw = create_buffer_raw(READER_SLAB_SIZE);
     buffer_raw_tls->buffer_raw = std::unique_ptr<BufferRaw, BufferAllocator::BufferRawDeleter>(buffer_raw);
   }
   buffer_raw->end_.fetch_add(size, std::memory_order_relaxed);
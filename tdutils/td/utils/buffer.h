@@ -180,6 +180,16 @@ class BufferSlice {
     }
   }
 
+  // if other immediately follows this slice in the same buffer, extends this
+  // slice to cover both and returns true
+  bool try_merge_with(const BufferSlice &other) {
+    if (is_null() || other.is_null() || buffer_.get() != other.buffer_.get() || end_ != other.begin_) {
+      return false;
+    }
+    end_ = other.end_;
+    return true;
+  }
+
   BufferSlice from_slice(Slice slice) const {
     auto res = BufferSlice(BufferAllocator::create_reader(buffer_));
     res.begin_ = static_cast<size_t>(slice.ubegin() - buffer_->data_);
@@ -686,10 +696,9 @@ class ChainBufferWriter {
   }
 
   void append(BufferSlice slice) {
-    auto ready = prepare_append_inplace();
-    // TODO(perf): we have to store some stats in ChainBufferWriter
-    // for better append logic
-    if (slice.size() < (1 << 8) || ready.size() >= slice.size()) {
+    // only small slices are copied; larger ones are linked by reference and
+    // flushed together with their neighbours in one vectored write
+    if (slice.size() < (1 << 8)) {
       return append(slice.as_slice());
     }
 
@@ -73,10 +73,95 @@ static uint64 gcd(uint64 a, uint64 b) {
   }
 }
 
-uint64 pq_factorize(uint64 pq) {
-  if (pq < 2 || pq > (static_cast<uint64>(1) << 63)) {
-    return 1;
+#ifdef __SIZEOF_INT128__
+namespace {
+
+using uint128 = unsigned __int128;
+
+// modular arithmetic in Montgomery form with R = 2^64; the modulus must be odd
+class MontgomeryU64 {
+ public:
+  explicit MontgomeryU64(uint64 n) : n_(n) {
+    uint64 inv = n;  // n^(-1) mod 2^64 by Newton iterations
+    for (int i = 0; i < 5; i++) {
+      inv *= 2 - n * inv;
+    }
+    n_inv_neg_ = 0 - inv;
+    one_ = (0 - n) % n;  // R mod n
+  }
+
+  uint64 one() const {
+    return one_;
   }
+
+  uint64 mul(uint64 a, uint64 b) const {
+    uint128 t = static_cast<uint128>(a) * b;
+    uint64 m = static_cast<uint64>(t) * n_inv_neg_;
+    // the low 64 bits of the sum are zero by the choice of m
+    uint64 r = static_cast<uint64>((t + static_cast<uint128>(m) * n_) >> 64);
+    return r >= n_ ? r - n_ : r;
+  }
+
+  uint64 next(uint64 y, uint64 c) const {
+    uint64 t = mul(y, y) + c;
+    if (t < c || t >= n_) {
+      t -= n_;
+    }
+    return t;
+  }
+
+ private:
+  uint64 n_;
+  uint64 n_inv_neg_;
+  uint64 one_;
+};
+
+uint64 pq_factorize_impl(uint64 pq) {
+  // Brent's cycle detection with batched gcds; all multiplications are done
+  // in Montgomery form, so an iteration costs two multiplications and no
+  // divisions. The gcd is unaffected by the extra 2^64 factor
+  auto sub_mod = [pq](uint64 a, uint64 b) { return a >= b ? a - b : a + pq - b; };
+  MontgomeryU64 mont(pq);
+  for (int attempt = 0; attempt < 10; attempt++) {
+    uint64 y = Random::fast_uint64() % (pq - 1) + 1;
+    uint64 c = Random::fast_uint64() % (pq - 1) + 1;
+    uint64 x = 0;
+    uint64 ys = 0;
+    uint64 q = mont.one();
+    uint64 g = 1;
+    const uint64 batch = 128;
+    for (uint64 r = 1; g == 1 && r < (1 << 22); r *= 2) {
+      x = y;
+      for (uint64 i = 0; i < r; i++) {
+        y = mont.next(y, c);
+      }
+      for (uint64 k = 0; k < r && g == 1; k += batch) {
+        ys = y;
+        auto lim = min(batch, r - k);
+        for (uint64 i = 0; i < lim; i++) {
+          y = mont.next(y, c);
+          q = mont.mul(q, sub_mod(x, y));
+        }
+        g = gcd(q, pq);
+      }
+    }
+    if (g == pq) {
+      // the batch has overshot a factor; redo it one gcd at a time
+      do {
+        ys = mont.next(ys, c);
+        g = gcd(sub_mod(x, ys), pq);
+      } while (g == 1);
+    }
+    if (g != 1 && g != pq) {
+      return g;
+    }
+  }
+  return 1;
+}
+
+}  // namespace
+#else
+static uint64 pq_factorize_impl(uint64 pq) {
   uint64 g = 0;
   for (int i = 0, iter = 0; i < 3 || iter < 1000; i++) {
     uint64 q = Random::fast(17, 32) % (pq - 1);
@@ -119,6 +204,31 @@ uint64 pq_factorize(uint64 pq) {
       break;
     }
   }
+  if (g == 0) {
+    return 0;
+  }
+  return g;
+}
+#endif
+
+uint64 pq_factorize(uint64 pq) {
+  if (pq < 2 || pq > (static_cast<uint64>(1) << 63)) {
+    return 1;
+  }
+
+  // trial division front end; it also guarantees an odd pq below
+  for (uint64 prime : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97}) {
+    if (pq % prime == 0) {
+      uint64 other = pq / prime;
+      return other < prime ? other : prime;
+    }
+  }
+  if (pq < 101 * 101) {
+    // pq is prime
+    return 1;
+  }
+
+  uint64 g = pq_factorize_impl(pq);
   if (g != 0) {
     uint64 other = pq / g;
     if (other < g) {
@@ -245,17 +355,73 @@ int pq_factorize(Slice pq_str, string *p_str, string *q_str) {
   return 0;
 }
 
-static void aes_ige_xcrypt(const UInt256 &aes_key, UInt256 *aes_iv, Slice from, MutableSlice to, bool encrypt_flag) {
-  AES_KEY key;
-  int err;
-  if (encrypt_flag) {
-    err = AES_set_encrypt_key(aes_key.raw, 256, &key);
-  } else {
-    err = AES_set_decrypt_key(aes_key.raw, 256, &key);
+struct AesBlock {
+  uint64 hi;
+  uint64 lo;
+
+  void load(const uint8 *ptr) {
+    std::memcpy(this, ptr, AES_BLOCK_SIZE);
   }
-  LOG_IF(FATAL, err != 0);
+  void store(uint8 *ptr) const {
+    std::memcpy(ptr, this, AES_BLOCK_SIZE);
+  }
+};
+
+static AesBlock operator^(const AesBlock &a, const AesBlock &b) {
+  AesBlock res;
+  res.hi = a.hi ^ b.hi;
+  res.lo = a.lo ^ b.lo;
+  return res;
+}
+
+// IGE is implemented over the EVP ECB cipher instead of the low-level AES_ige_encrypt,
+// because only the EVP layer dispatches to the hardware AES instructions OpenSSL
+// detects at run time. The chaining itself is inherently serial: each block is
+// encrypted only after the previous plaintext and ciphertext are known
+static void aes_ige_xcrypt(const UInt256 &aes_key, UInt256 *aes_iv, Slice from, MutableSlice to, bool encrypt_flag) {
   CHECK(from.size() <= to.size());
-  AES_ige_encrypt(from.ubegin(), to.ubegin(), from.size(), &key, aes_iv->raw, encrypt_flag);
+  CHECK(from.size() % AES_BLOCK_SIZE == 0);
+
+  EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+  LOG_IF(FATAL, ctx == nullptr);
+  int res = EVP_CipherInit_ex(ctx, EVP_aes_256_ecb(), nullptr, aes_key.raw, nullptr, encrypt_flag ? 1 : 0);
+  LOG_IF(FATAL, res != 1);
+  EVP_CIPHER_CTX_set_padding(ctx, 0);
+
+  AesBlock iv1;
+  AesBlock iv2;
+  iv1.load(aes_iv->raw);
+  iv2.load(aes_iv->raw + AES_BLOCK_SIZE);
+
+  auto in = from.ubegin();
+  auto out = to.ubegin();
+  uint8 buf[AES_BLOCK_SIZE];
+  int out_len = 0;
+  for (auto count = from.size() / AES_BLOCK_SIZE; count > 0; count--) {
+    AesBlock input;
+    input.load(in);
+    (input ^ (encrypt_flag ? iv1 : iv2)).store(buf);
+    res = EVP_CipherUpdate(ctx, buf, &out_len, buf, AES_BLOCK_SIZE);
+    LOG_IF(FATAL, res != 1);
+    CHECK(out_len == AES_BLOCK_SIZE);
+    AesBlock crypted;
+    crypted.load(buf);
+    AesBlock output = crypted ^ (encrypt_flag ? iv2 : iv1);
+    output.store(out);
+    if (encrypt_flag) {
+      iv1 = output;
+      iv2 = input;
+    } else {
+      iv1 = input;
+      iv2 = output;
+    }
+    in += AES_BLOCK_SIZE;
+    out += AES_BLOCK_SIZE;
+  }
+  iv1.store(aes_iv->raw);
+  iv2.store(aes_iv->raw + AES_BLOCK_SIZE);
+
+  EVP_CIPHER_CTX_free(ctx);
 }
 
 void aes_ige_encrypt(const UInt256 &aes_key, UInt256 *aes_iv, Slice from, MutableSlice to) {
@@ -297,38 +463,40 @@ void AesCbcState::decrypt(Slice from, MutableSlice to) {
   ::td::aes_cbc_decrypt(key_, &iv_, from, to);
 }
 
+// the EVP CTR cipher keeps the counter state itself and pipelines several blocks
+// per call on CPUs with hardware AES support
 class AesCtrState::Impl {
  public:
   Impl(const UInt256 &key, const UInt128 &iv) {
     static_assert(AES_BLOCK_SIZE == 16, "");
-    if (AES_set_encrypt_key(key.raw, 256, &aes_key) < 0) {
-      LOG(FATAL) << "Failed to set encrypt key";
-    }
-    MutableSlice(counter, AES_BLOCK_SIZE).copy_from(as_slice(iv));
-    current_pos = 0;
+    ctx_ = EVP_CIPHER_CTX_new();
+    LOG_IF(FATAL, ctx_ == nullptr);
+    int res = EVP_EncryptInit_ex(ctx_, EVP_aes_256_ctr(), nullptr, key.raw, iv.raw);
+    LOG_IF(FATAL, res != 1);
+  }
+  Impl(const Impl &other) = delete;
+  Impl &operator=(const Impl &other) = delete;
+  Impl(Impl &&other) = delete;
+  Impl &operator=(Impl &&other) = delete;
+  ~Impl() {
+    EVP_CIPHER_CTX_free(ctx_);
   }
 
   void encrypt(Slice from, MutableSlice to) {
     CHECK(to.size() >= from.size());
-    for (size_t i = 0; i < from.size(); i++) {
-      if (current_pos == 0) {
-        AES_encrypt(counter, encrypted_counter, &aes_key);
-        for (int j = 15; j >= 0; j--) {
-          if (++counter[j] != 0) {
-            break;
-          }
-        }
-      }
-      to[i] = static_cast<char>(from[i] ^ encrypted_counter[current_pos]);
-      current_pos = (current_pos + 1) & 15;
+    while (!from.empty()) {
+      auto block_size = narrow_cast<int>(min(from.size(), static_cast<size_t>(1 << 30)));
+      int out_len = 0;
+      int res = EVP_EncryptUpdate(ctx_, to.ubegin(), &out_len, from.ubegin(), block_size);
+      LOG_IF(FATAL, res != 1);
+      CHECK(out_len == block_size);
+      from.remove_prefix(block_size);
+      to.remove_prefix(block_size);
     }
   }
 
  private:
-  AES_KEY aes_key;
-  uint8 counter[AES_BLOCK_SIZE];
-  uint8 encrypted_counter[AES_BLOCK_SIZE];
-  uint8 current_pos;
+  EVP_CIPHER_CTX *ctx_;
 };
 
 AesCtrState::AesCtrState() = default;
@@ -336,8 +504,20 @@ AesCtrState::AesCtrState(AesCtrState &&from) = default;
 AesCtrState &AesCtrState::operator=(AesCtrState &&from) = default;
 AesCtrState::~AesCtrState() = default;
 
-void AesCtrState::init(const UInt256 &key, const UInt128 &iv) {
-  ctx_ = make_unique<AesCtrState::Impl>(key, iv);
+void AesCtrState::init(const UInt256 &key, const UInt128 &iv, uint64 offset) {
+  UInt128 counter = iv;
+  auto carry = offset / 16;
+  for (int i = static_cast<int>(sizeof(counter.raw)) - 1; i >= 0 && carry != 0; i--) {
+    carry += counter.raw[i];
+    counter.raw[i] = static_cast<uint8>(carry);
+    carry >>= 8;
+  }
+  ctx_ = make_unique<AesCtrState::Impl>(key, counter);
+
+  // consume the already used part of the current key stream block
+  uint8 skip[16] = {};
+  auto prefix = static_cast<size_t>(offset % 16);
+  ctx_->encrypt(Slice(skip, prefix), MutableSlice(skip, prefix));
 }
 
 void AesCtrState::encrypt(Slice from, MutableSlice to) {
@@ -36,7 +36,9 @@ class AesCtrState {
   AesCtrState &operator=(AesCtrState &&from);
   ~AesCtrState();
 
-  void init(const UInt256 &key, const UInt128 &iv);
+  // positions the state at an arbitrary byte offset of the key stream; CTR mode
+  // is random access, so several states may process disjoint parts of one stream
+  void init(const UInt256 &key, const UInt128 &iv, uint64 offset = 0);
 
   void encrypt(Slice from, MutableSlice to);
 
@@ -17,32 +17,52 @@ bool find_boundary(ChainBufferReader range, Slice boundary, size_t &already_read
   CHECK(boundary.size() <= MAX_BOUNDARY_LENGTH + 4);
   while (!range.empty()) {
     Slice ready = range.prepare_read();
-    if (ready[0] == boundary[0]) {
-      if (range.size() < boundary.size()) {
-        return false;
+
+    // all candidates lying fully inside the contiguous chunk are checked with
+    // memchr/memcmp without touching the chain iterators; in the common case
+    // the whole header arrives in one chunk and this is the only loop taken
+    size_t pos = 0;
+    while (pos < ready.size()) {
+      const char *ptr = static_cast<const char *>(std::memchr(ready.data() + pos, boundary[0], ready.size() - pos));
+      if (ptr == nullptr) {
+        pos = ready.size();
+        break;
+      }
+      pos = static_cast<size_t>(ptr - ready.data());
+      if (ready.size() - pos < boundary.size()) {
+        // the candidate may continue in the next chunk
+        break;
       }
-      auto save_range = range.clone();
-      char x[MAX_BOUNDARY_LENGTH + 4];
-      range.advance(boundary.size(), {x, sizeof(x)});
-      if (std::memcmp(x, boundary.data(), boundary.size()) == 0) {
+      if (std::memcmp(ready.data() + pos, boundary.data(), boundary.size()) == 0) {
+        already_read += pos;
         return true;
       }
+      pos++;
+    }
+    already_read += pos;
+    range.advance(pos);
+    if (range.empty()) {
+      break;
+    }
+    if (range.prepare_read()[0] != boundary[0]) {
+      continue;
+    }
 
-      // not a boundary, restoring previous state and skip one symbol
-      range = std::move(save_range);
-      range.advance(1);
-      already_read++;
-    } else {
-      const char *ptr = static_cast<const char *>(std::memchr(ready.data(), boundary[0], ready.size()));
-      size_t shift;
-      if (ptr == nullptr) {
-        shift = ready.size();
-      } else {
-        shift = ptr - ready.data();
-      }
-      already_read += shift;
-      range.advance(shift);
+    // candidate crossing a chunk boundary: compare through the chain
+    if (range.size() < boundary.size()) {
+      return false;
     }
+    auto save_range = range.clone();
+    char x[MAX_BOUNDARY_LENGTH + 4];
+    range.advance(boundary.size(), {x, sizeof(x)});
+    if (std::memcmp(x, boundary.data(), boundary.size()) == 0) {
+      return true;
+    }
+
+    // not a boundary, restoring previous state and skip one symbol
+    range = std::move(save_range);
+    range.advance(1);
+    already_read++;
   }
 
   return false;
@@ -153,6 +153,19 @@ inline string to_lower(Slice slice) {
   return result;
 }
 
+// checks str == lowercased ignoring the case of str; lowercased must be already in lower case
+inline bool equals_lowercased(Slice str, Slice lowercased) {
+  if (str.size() != lowercased.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < str.size(); i++) {
+    if (to_lower(str[i]) != lowercased[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 inline char to_upper(char c) {
   if ('a' <= c && c <= 'z') {
     return static_cast<char>(c - 'a' + 'A');
@@ -41,8 +41,8 @@ struct PrintFlags {
 
 StringBuilder &operator<<(StringBuilder &sb, const PrintFlags &print_flags) {
   auto flags = print_flags.flags;
-  if (flags &
-      ~(FileFd::Write | FileFd::Read | FileFd::Truncate | FileFd::Create | FileFd::Append | FileFd::CreateNew)) {
+  if (flags & ~(FileFd::Write | FileFd::Read | FileFd::Truncate | FileFd::Create | FileFd::Append |
+                FileFd::CreateNew | FileFd::Direct)) {
     return sb << "opened with invalid flags " << flags;
   }
 
@@ -75,6 +75,9 @@ StringBuilder &operator<<(StringBuilder &sb, const PrintFlags &print_flags) {
   if (flags & FileFd::Truncate) {
     sb << " with truncation";
   }
+  if (flags & FileFd::Direct) {
+    sb << " bypassing the page cache";
+  }
   return sb;
 }
 
@@ -96,7 +99,7 @@ FileFd::FileFd(unique_ptr<detail::FileFdImpl> impl) : impl_(std::move(impl)) {
 }
 
 Result<FileFd> FileFd::open(CSlice filepath, int32 flags, int32 mode) {
-  if (flags & ~(Write | Read | Truncate | Create | Append | CreateNew)) {
+  if (flags & ~(Write | Read | Truncate | Create | Append | CreateNew | Direct)) {
     return Status::Error(PSLICE() << "File \"" << filepath << "\" has failed to be " << PrintFlags{flags});
   }
 
@@ -131,10 +134,21 @@ Result<FileFd> FileFd::open(CSlice filepath, int32 flags, int32 mode) {
     native_flags |= O_APPEND;
   }
 
+#if TD_LINUX
+  if (flags & Direct) {
+    native_flags |= O_DIRECT;
+  }
+#endif
+
   int native_fd = detail::skip_eintr([&] { return ::open(filepath.c_str(), native_flags, static_cast<mode_t>(mode)); });
   if (native_fd < 0) {
     return OS_ERROR(PSLICE() << "File \"" << filepath << "\" can't be " << PrintFlags{flags});
   }
+#if TD_DARWIN
+  if (flags & Direct) {
+    fcntl(native_fd, F_NOCACHE, 1);
+  }
+#endif
   return from_native_fd(NativeFd(native_fd));
 #elif TD_PORT_WINDOWS
   // TODO: support modes
@@ -216,6 +230,29 @@ Result<size_t> FileFd::write(Slice slice) {
   return OS_ERROR(PSLICE() << "Write to " << get_native_fd() << " has failed");
 }
 
+Result<size_t> FileFd::writev(Span<IoSlice> slices) {
+  auto native_fd = get_native_fd().fd();
+#if TD_PORT_POSIX
+  TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
+  auto bytes_written = detail::skip_eintr([&] { return ::writev(native_fd, slices.begin(), slices_size); });
+  if (bytes_written >= 0) {
+    return narrow_cast<size_t>(bytes_written);
+  }
+  return OS_ERROR(PSLICE() << "Writev to " << get_native_fd() << " has failed");
+#elif TD_PORT_WINDOWS
+  size_t total_size = 0;
+  for (auto io_slice : slices) {
+    auto slice = as_slice(io_slice);
+    TRY_RESULT(bytes_written, write(slice));
+    total_size += bytes_written;
+    if (bytes_written != slice.size()) {
+      break;
+    }
+  }
+  return total_size;
+#endif
+}
+
 Result<size_t> FileFd::read(MutableSlice slice) {
   auto native_fd = get_native_fd().fd();
 #if TD_PORT_POSIX
@@ -481,6 +518,50 @@ Status FileFd::sync() {
   return Status::OK();
 }
 
+Status FileFd::allocate(int64 offset, int64 size) {
+  CHECK(!empty());
+#if TD_LINUX
+  TRY_RESULT(offset_off_t, narrow_cast_safe<off_t>(offset));
+  TRY_RESULT(size_off_t, narrow_cast_safe<off_t>(size));
+  // FALLOC_FL_KEEP_SIZE: reserve extents without changing the visible file size
+  if (detail::skip_eintr([&] { return fallocate(get_native_fd().fd(), FALLOC_FL_KEEP_SIZE, offset_off_t, size_off_t); }) <
+      0) {
+    return OS_ERROR("Allocate failed");
+  }
+#else
+  (void)offset;
+  (void)size;
+#endif
+  return Status::OK();
+}
+
+Status FileFd::advise(Advice advice, int64 offset, int64 size) {
+  CHECK(!empty());
+#if TD_LINUX
+  int native_advice = POSIX_FADV_NORMAL;
+  switch (advice) {
+    case Advice::Sequential:
+      native_advice = POSIX_FADV_SEQUENTIAL;
+      break;
+    case Advice::WillNeed:
+      native_advice = POSIX_FADV_WILLNEED;
+      break;
+    case Advice::DontNeed:
+      native_advice = POSIX_FADV_DONTNEED;
+      break;
+  }
+  auto err = posix_fadvise(get_native_fd().fd(), offset, size, native_advice);
+  if (err != 0) {
+    return Status::PosixError(err, "Advise failed");
+  }
+#else
+  (void)advice;
+  (void)offset;
+  (void)size;
+#endif
+  return Status::OK();
+}
+
 Status FileFd::seek(int64 position) {
   CHECK(!empty());
 #if TD_PORT_POSIX
@@ -11,8 +11,10 @@
 #include "td/utils/common.h"
 #include "td/utils/port/detail/NativeFd.h"
 #include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/IoSlice.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 namespace td {
@@ -29,12 +31,15 @@ class FileFd {
   FileFd(const FileFd &) = delete;
   FileFd &operator=(const FileFd &) = delete;
 
-  enum Flags : int32 { Write = 1, Read = 2, Truncate = 4, Create = 8, Append = 16, CreateNew = 32 };
+  // Direct bypasses the page cache where the platform supports it; the caller
+  // must keep offsets and buffer sizes aligned to the filesystem block size
+  enum Flags : int32 { Write = 1, Read = 2, Truncate = 4, Create = 8, Append = 16, CreateNew = 32, Direct = 64 };
 
   static Result<FileFd> open(CSlice filepath, int32 flags, int32 mode = 0600) TD_WARN_UNUSED_RESULT;
   static FileFd from_native_fd(NativeFd fd) TD_WARN_UNUSED_RESULT;
 
   Result<size_t> write(Slice slice) TD_WARN_UNUSED_RESULT;
+  Result<size_t> writev(Span<IoSlice> slices) TD_WARN_UNUSED_RESULT;
   Result<size_t> read(MutableSlice slice) TD_WARN_UNUSED_RESULT;
 
   Result<size_t> pwrite(Slice slice, int64 offset) TD_WARN_UNUSED_RESULT;
@@ -55,6 +60,15 @@ class FileFd {
 
   Status sync() TD_WARN_UNUSED_RESULT;
 
+  // preallocates disk space for [offset, offset + size) without changing the
+  // visible file size; a no-op where the platform has no such primitive
+  Status allocate(int64 offset, int64 size) TD_WARN_UNUSED_RESULT;
+
+  enum class Advice { Sequential, WillNeed, DontNeed };
+  // advises the kernel about the expected access pattern of [offset, offset + size);
+  // zero size means up to the end of the file. Only a hint, a no-op on some platforms
+  Status advise(Advice advice, int64 offset, int64 size) TD_WARN_UNUSED_RESULT;
+
   Status seek(int64 position) TD_WARN_UNUSED_RESULT;
 
   Status truncate_to_current_position(int64 current_position) TD_WARN_UNUSED_RESULT;
@@ -95,6 +95,21 @@ class SocketFdImpl : private Iocp::Callback {
     return data.size();
   }
 
+  Result<size_t> writev(Span<IoSlice> slices) {
+    size_t total_size = 0;
+    for (auto io_slice : slices) {
+      auto slice = as_slice(io_slice);
+      output_writer_.append(slice);
+      total_size += slice.size();
+    }
+    if (is_write_waiting_) {
+      auto lock = lock_.lock();
+      is_write_waiting_ = false;
+      notify_iocp_write();
+    }
+    return total_size;
+  }
+
   Result<size_t> read(MutableSlice slice) {
     if (get_poll_info().get_flags().has_pending_error()) {
       TRY_STATUS(get_pending_error());
@@ -348,6 +363,15 @@ class SocketFdImpl {
   Result<size_t> write(Slice slice) {
     int native_fd = get_native_fd().socket();
     auto write_res = detail::skip_eintr([&] { return ::write(native_fd, slice.begin(), slice.size()); });
+    return write_finish(write_res);
+  }
+  Result<size_t> writev(Span<IoSlice> slices) {
+    int native_fd = get_native_fd().socket();
+    TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
+    auto write_res = detail::skip_eintr([&] { return ::writev(native_fd, slices.begin(), slices_size); });
+    return write_finish(write_res);
+  }
+  Result<size_t> write_finish(ssize_t write_res) {
     auto write_errno = errno;
     if (write_res >= 0) {
       return narrow_cast<size_t>(write_res);
@@ -564,6 +588,10 @@ Result<size_t> SocketFd::write(Slice slice) {
   return impl_->write(slice);
 }
 
+Result<size_t> SocketFd::writev(Span<IoSlice> slices) {
+  return impl_->writev(slices);
+}
+
 Result<size_t> SocketFd::read(MutableSlice slice) {
   return impl_->read(slice);
 }
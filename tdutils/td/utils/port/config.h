@@ -17,7 +17,11 @@
 #endif
 
 #if TD_LINUX || TD_ANDROID || TD_TIZEN
-  #define TD_POLL_EPOLL 1
+  #ifdef TD_WITH_IOURING
+    #define TD_POLL_IOURING 1
+  #else
+    #define TD_POLL_EPOLL 1
+  #endif
   #define TD_EVENTFD_LINUX 1
 #elif TD_FREEBSD
   #define TD_POLL_KQUEUE 1
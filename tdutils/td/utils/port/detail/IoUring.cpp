@@ -0,0 +1,288 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/detail/IoUring.h"
+
+char disable_linker_warning_about_empty_file_io_uring_cpp TD_UNUSED;
+
+#ifdef TD_POLL_IOURING
+
+#include "td/utils/logging.h"
+#include "td/utils/Status.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace td {
+namespace detail {
+
+namespace {
+
+// user_data values of management requests, which carry no FdInfo pointer.
+// FdInfo pointers are at least word-aligned and can never collide with them
+constexpr uint64 TIMEOUT_USER_DATA = 1;
+constexpr uint64 POLL_REMOVE_USER_DATA = 2;
+
+int sys_io_uring_setup(uint32 entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int ring_fd, uint32 to_submit, uint32 min_complete, uint32 flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+IoUring::~IoUring() {
+  clear();
+}
+
+void IoUring::init() {
+  CHECK(ring_fd_ == -1);
+
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd_ = sys_io_uring_setup(256, &params);
+  auto io_uring_setup_errno = errno;
+  LOG_IF(FATAL, ring_fd_ == -1) << Status::PosixError(io_uring_setup_errno, "io_uring_setup failed");
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = sq_ring_size_;
+  }
+  sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQ_RING);
+  LOG_IF(FATAL, sq_ring_ptr_ == MAP_FAILED) << Status::PosixError(errno, "mmap of submission queue ring failed");
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ptr_ = sq_ring_ptr_;
+  } else {
+    cq_ring_ptr_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+    LOG_IF(FATAL, cq_ring_ptr_ == MAP_FAILED) << Status::PosixError(errno, "mmap of completion queue ring failed");
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe *>(
+      mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+  LOG_IF(FATAL, sqes_ == MAP_FAILED) << Status::PosixError(errno, "mmap of submission queue entries failed");
+
+  auto sq_ring = static_cast<char *>(sq_ring_ptr_);
+  sq_head_ = reinterpret_cast<std::atomic<uint32> *>(sq_ring + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<std::atomic<uint32> *>(sq_ring + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32 *>(sq_ring + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.array);
+
+  auto cq_ring = static_cast<char *>(cq_ring_ptr_);
+  cq_head_ = reinterpret_cast<std::atomic<uint32> *>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<std::atomic<uint32> *>(cq_ring + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32 *>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+}
+
+void IoUring::clear() {
+  if (ring_fd_ == -1) {
+    return;
+  }
+
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ptr_ != sq_ring_ptr_) {
+    munmap(cq_ring_ptr_, cq_ring_size_);
+  }
+  munmap(sq_ring_ptr_, sq_ring_size_);
+  sq_ring_ptr_ = nullptr;
+  cq_ring_ptr_ = nullptr;
+  sqes_ = nullptr;
+
+  close(ring_fd_);
+  ring_fd_ = -1;
+
+  fd_infos_.clear();
+  removed_infos_.clear();
+  fd_to_info_.clear();
+  to_submit_ = 0;
+
+  for (auto *list_node = list_root_.next; list_node != &list_root_;) {
+    auto pollable_fd = PollableFd::from_list_node(list_node);
+    list_node = list_node->next;
+  }
+}
+
+io_uring_sqe *IoUring::get_sqe() {
+  auto head = sq_head_->load(std::memory_order_acquire);
+  auto tail = sq_tail_->load(std::memory_order_relaxed);
+  if (tail - head == sq_mask_ + 1) {
+    submit(0, false);
+    head = sq_head_->load(std::memory_order_acquire);
+    CHECK(tail - head != sq_mask_ + 1);
+  }
+  auto index = tail & sq_mask_;
+  auto *sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  sq_tail_->store(tail + 1, std::memory_order_release);
+  to_submit_++;
+  return sqe;
+}
+
+void IoUring::submit(uint32 min_complete, bool need_wait) {
+  auto result =
+      sys_io_uring_enter(ring_fd_, to_submit_, min_complete, need_wait ? IORING_ENTER_GETEVENTS : 0);
+  auto io_uring_enter_errno = errno;
+  if (result < 0) {
+    LOG_IF(FATAL, io_uring_enter_errno != EINTR)
+        << Status::PosixError(io_uring_enter_errno, "io_uring_enter failed");
+    return;
+  }
+  CHECK(static_cast<uint32>(result) <= to_submit_);
+  to_submit_ -= static_cast<uint32>(result);
+}
+
+void IoUring::arm_poll(FdInfo *info) {
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = info->native_fd;
+  sqe->poll_events = info->poll_events;
+  sqe->user_data = reinterpret_cast<uint64>(info);
+  info->is_armed = true;
+}
+
+void IoUring::subscribe(PollableFd fd, PollFlags flags) {
+  uint16 poll_events = POLLERR | POLLHUP;
+#ifdef POLLRDHUP
+  poll_events |= POLLRDHUP;
+#endif
+  if (flags.can_read()) {
+    poll_events |= POLLIN;
+  }
+  if (flags.can_write()) {
+    poll_events |= POLLOUT;
+  }
+
+  auto native_fd = fd.native_fd().fd();
+  auto *list_node = fd.release_as_list_node();
+  list_root_.put(list_node);
+
+  fd_infos_.emplace_back();
+  auto &info = fd_infos_.back();
+  info.list_node = list_node;
+  info.native_fd = native_fd;
+  info.poll_events = poll_events;
+  auto it = fd_infos_.end();
+  --it;
+  auto is_inserted = fd_to_info_.emplace(native_fd, it).second;
+  CHECK(is_inserted);
+
+  arm_poll(&info);
+}
+
+void IoUring::unsubscribe(PollableFdRef fd_ref) {
+  auto fd = fd_ref.lock();
+  auto native_fd = fd.native_fd().fd();
+  auto it = fd_to_info_.find(native_fd);
+  CHECK(it != fd_to_info_.end());
+  auto info_it = it->second;
+  fd_to_info_.erase(it);
+
+  if (info_it->is_armed) {
+    // the in-flight poll request is cancelled; the entry is freed when its
+    // completion (usually -ECANCELED) is consumed
+    info_it->is_removed = true;
+    auto *sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64>(&*info_it);
+    sqe->user_data = POLL_REMOVE_USER_DATA;
+    removed_infos_.splice(removed_infos_.end(), fd_infos_, info_it);
+  } else {
+    fd_infos_.erase(info_it);
+  }
+}
+
+void IoUring::unsubscribe_before_close(PollableFdRef fd) {
+  unsubscribe(fd);
+}
+
+void IoUring::run(int timeout_ms) {
+  if (timeout_ms == 0) {
+    submit(0, false);
+  } else {
+    if (timeout_ms > 0) {
+      timeout_ts_.tv_sec = timeout_ms / 1000;
+      timeout_ts_.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+      auto *sqe = get_sqe();
+      sqe->opcode = IORING_OP_TIMEOUT;
+      sqe->fd = -1;
+      sqe->addr = reinterpret_cast<uint64>(&timeout_ts_);
+      sqe->len = 1;
+      sqe->off = 1;
+      sqe->user_data = TIMEOUT_USER_DATA;
+    }
+    submit(1, true);
+  }
+
+  auto head = cq_head_->load(std::memory_order_relaxed);
+  auto tail = cq_tail_->load(std::memory_order_acquire);
+  while (head != tail) {
+    auto &cqe = cqes_[head & cq_mask_];
+    head++;
+    if (cqe.user_data == TIMEOUT_USER_DATA || cqe.user_data == POLL_REMOVE_USER_DATA) {
+      continue;
+    }
+
+    auto *info = reinterpret_cast<FdInfo *>(static_cast<uintptr_t>(cqe.user_data));
+    info->is_armed = false;
+    if (info->is_removed) {
+      for (auto info_it = removed_infos_.begin(); info_it != removed_infos_.end(); ++info_it) {
+        if (&*info_it == info) {
+          removed_infos_.erase(info_it);
+          break;
+        }
+      }
+      continue;
+    }
+
+    PollFlags flags;
+    if (cqe.res > 0) {
+      auto events = static_cast<uint32>(cqe.res);
+      if (events & POLLIN) {
+        flags = flags | PollFlags::Read();
+      }
+      if (events & POLLOUT) {
+        flags = flags | PollFlags::Write();
+      }
+      if (events & POLLHUP) {
+        flags = flags | PollFlags::Close();
+      }
+#ifdef POLLRDHUP
+      if (events & POLLRDHUP) {
+        flags = flags | PollFlags::Close();
+      }
+#endif
+      if (events & POLLERR) {
+        flags = flags | PollFlags::Error();
+      }
+      auto pollable_fd = PollableFd::from_list_node(info->list_node);
+      pollable_fd.add_flags(flags);
+      pollable_fd.release_as_list_node();
+    } else if (cqe.res != -ECANCELED) {
+      LOG(FATAL) << Status::PosixError(-cqe.res, "poll request failed");
+    }
+
+    arm_poll(info);
+  }
+  cq_head_->store(head, std::memory_order_release);
+}
+
+}  // namespace detail
+}  // namespace td
+
+#endif
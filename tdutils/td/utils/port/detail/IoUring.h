@@ -0,0 +1,104 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/port/config.h"
+
+#ifdef TD_POLL_IOURING
+
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/PollBase.h"
+#include "td/utils/port/PollFlags.h"
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+
+namespace td {
+namespace detail {
+
+// PollBase backend over io_uring, built directly on the io_uring_setup/io_uring_enter
+// system calls. Readiness is tracked with one-shot IORING_OP_POLL_ADD requests that are
+// re-armed after every completion, which gives the same level-triggered semantics as
+// the poll and select backends
+class IoUring final : public PollBase {
+ public:
+  IoUring() = default;
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+  IoUring(IoUring &&) = delete;
+  IoUring &operator=(IoUring &&) = delete;
+  ~IoUring() override;
+
+  void init() override;
+
+  void clear() override;
+
+  void subscribe(PollableFd fd, PollFlags flags) override;
+
+  void unsubscribe(PollableFdRef fd) override;
+
+  void unsubscribe_before_close(PollableFdRef fd) override;
+
+  void run(int timeout_ms) override;
+
+  static bool is_edge_triggered() {
+    return false;
+  }
+
+ private:
+  struct FdInfo {
+    ListNode *list_node = nullptr;
+    int native_fd = -1;
+    uint16 poll_events = 0;
+    bool is_armed = false;
+    bool is_removed = false;
+  };
+
+  int ring_fd_ = -1;
+
+  void *sq_ring_ptr_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void *cq_ring_ptr_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  std::atomic<uint32> *sq_head_ = nullptr;
+  std::atomic<uint32> *sq_tail_ = nullptr;
+  uint32 sq_mask_ = 0;
+  uint32 *sq_array_ = nullptr;
+
+  std::atomic<uint32> *cq_head_ = nullptr;
+  std::atomic<uint32> *cq_tail_ = nullptr;
+  uint32 cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+
+  uint32 to_submit_ = 0;
+  __kernel_timespec timeout_ts_;
+
+  std::list<FdInfo> fd_infos_;
+  // unsubscribed entries with a poll request still in flight
+  std::list<FdInfo> removed_infos_;
+  std::unordered_map<int, std::list<FdInfo>::iterator> fd_to_info_;
+
+  ListNode list_root_;
+
+  io_uring_sqe *get_sqe();
+  void submit(uint32 min_complete, bool need_wait);
+  void arm_poll(FdInfo *info);
+};
+
+}  // namespace detail
+}  // namespace td
+
+#endif
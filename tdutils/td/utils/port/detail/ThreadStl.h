@@ -14,6 +14,7 @@
 #include "td/utils/invoke.h"
 #include "td/utils/port/detail/ThreadIdGuard.h"
 #include "td/utils/port/thread_local.h"
+#include "td/utils/Status.h"
 
 #include <thread>
 #include <tuple>
@@ -51,6 +52,19 @@ class ThreadStl {
     return std::thread::hardware_concurrency();
   }
 
+  // restricts the thread to the CPUs of the mask; bit i of cpu_mask stands for CPU i
+  Status set_affinity_mask(uint64 cpu_mask) {
+#if TD_PORT_WINDOWS
+    if (SetThreadAffinityMask(thread_.native_handle(), static_cast<DWORD_PTR>(cpu_mask)) == 0) {
+      return OS_ERROR("Failed to set thread affinity mask");
+    }
+    return Status::OK();
+#else
+    (void)cpu_mask;
+    return Status::Error("Thread affinity is not supported on the platform");
+#endif
+  }
+
   using id = std::thread::id;
 
  private:
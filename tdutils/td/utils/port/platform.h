@@ -71,9 +71,11 @@
 #if TD_GCC || TD_CLANG || TD_INTEL
   #define TD_WARN_UNUSED_RESULT __attribute__((warn_unused_result))
   #define TD_ATTRIBUTE_FORMAT_PRINTF(from, to) __attribute__((format(printf, from, to)))
+  #define TD_COLD __attribute__((cold, noinline))
 #else
   #define TD_WARN_UNUSED_RESULT
   #define TD_ATTRIBUTE_FORMAT_PRINTF(from, to)
+  #define TD_COLD
 #endif
 
 #if TD_MSVC
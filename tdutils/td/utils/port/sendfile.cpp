@@ -0,0 +1,95 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/sendfile.h"
+
+#include "td/utils/port/config.h"
+
+#include "td/utils/misc.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/PollFlags.h"
+
+#if TD_LINUX || TD_ANDROID
+#include <sys/sendfile.h>
+#elif TD_DARWIN || TD_FREEBSD
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+
+#include <cerrno>
+
+namespace td {
+
+#if TD_PORT_POSIX
+namespace {
+
+bool is_would_block_errno(int code) {
+  return code == EAGAIN
+#if EAGAIN != EWOULDBLOCK
+         || code == EWOULDBLOCK
+#endif
+      ;
+}
+
+}  // namespace
+#endif
+
+Result<size_t> sendfile(SocketFd &to, FileFd &from, int64 offset, size_t count) {
+#if TD_LINUX || TD_ANDROID
+  auto socket = to.get_native_fd().socket();
+  auto fd = from.get_native_fd().fd();
+  auto off = static_cast<off_t>(offset);
+  auto sent = detail::skip_eintr([&] { return ::sendfile(socket, fd, &off, count); });
+  if (sent >= 0) {
+    return narrow_cast<size_t>(sent);
+  }
+  auto sendfile_errno = errno;
+  if (is_would_block_errno(sendfile_errno)) {
+    to.get_poll_info().clear_flags(PollFlags::Write());
+    return 0;
+  }
+  if (sendfile_errno != EINVAL && sendfile_errno != ENOSYS) {
+    return Status::PosixError(sendfile_errno, PSLICE() << "Sendfile to " << to.get_native_fd() << " has failed");
+  }
+  // in-kernel transfer is unsupported for this file; fall through to the copy
+#elif TD_DARWIN || TD_FREEBSD
+  auto socket = to.get_native_fd().socket();
+  auto fd = from.get_native_fd().fd();
+  auto len = static_cast<off_t>(count);
+  auto res = detail::skip_eintr([&] { return ::sendfile(fd, socket, static_cast<off_t>(offset), &len, nullptr, 0); });
+  auto sendfile_errno = errno;
+  if (res >= 0) {
+    return narrow_cast<size_t>(len);
+  }
+  if (is_would_block_errno(sendfile_errno)) {
+    to.get_poll_info().clear_flags(PollFlags::Write());
+    return narrow_cast<size_t>(len);
+  }
+  if (sendfile_errno != EINVAL && sendfile_errno != ENOSYS && sendfile_errno != ENOTSUP) {
+    return Status::PosixError(sendfile_errno, PSLICE() << "Sendfile to " << to.get_native_fd() << " has failed");
+  }
+  // in-kernel transfer is unsupported for this file; fall through to the copy
+#endif
+
+  char buf[64 * 1024];
+  size_t total_sent = 0;
+  while (total_sent < count) {
+    auto chunk_size = min(count - total_sent, sizeof(buf));
+    TRY_RESULT(read_size, from.pread(MutableSlice(buf, chunk_size), offset + static_cast<int64>(total_sent)));
+    if (read_size == 0) {
+      break;
+    }
+    TRY_RESULT(written_size, to.write(Slice(buf, read_size)));
+    total_sent += written_size;
+    if (written_size != read_size) {
+      break;
+    }
+  }
+  return total_sent;
+}
+
+}  // namespace td
@@ -0,0 +1,22 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/SocketFd.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Sends up to count bytes of the file beginning at the given offset to the
+// socket. On Linux and Darwin the transfer is done in the kernel with
+// sendfile(2) and never passes through userspace; elsewhere it falls back to
+// a pread+write loop. Returns the number of bytes sent, which can be less
+// than count if the socket can't accept more data.
+Result<size_t> sendfile(SocketFd &to, FileFd &from, int64 offset, size_t count) TD_WARN_UNUSED_RESULT;
+
+}  // namespace td
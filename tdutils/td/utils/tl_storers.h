@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
@@ -85,6 +86,95 @@ class TlStorerUnsafe {
   }
 };
 
+// Single-pass storer appending into a ChainBufferWriter. The writer grows by segments,
+// so serialization needs no precalculated length and walks the object tree only once
+class TlStorerToChainBuffer {
+  ChainBufferWriter &writer_;
+  MutableSlice dest_;
+  size_t used_ = 0;
+
+ public:
+  explicit TlStorerToChainBuffer(ChainBufferWriter &writer) : writer_(writer) {
+  }
+
+  TlStorerToChainBuffer(const TlStorerToChainBuffer &other) = delete;
+  TlStorerToChainBuffer &operator=(const TlStorerToChainBuffer &other) = delete;
+
+  ~TlStorerToChainBuffer() {
+    flush();
+  }
+
+  void flush() {
+    if (used_ != 0) {
+      writer_.confirm_append(used_);
+      used_ = 0;
+    }
+    dest_ = MutableSlice();
+  }
+
+  template <class T>
+  void store_binary(const T &x) {
+    store_slice(Slice(reinterpret_cast<const char *>(&x), sizeof(T)));
+  }
+
+  void store_int(int32 x) {
+    store_binary<int32>(x);
+  }
+
+  void store_long(int64 x) {
+    store_binary<int64>(x);
+  }
+
+  void store_slice(Slice slice) {
+    while (true) {
+      auto available = dest_.size() - used_;
+      if (slice.size() <= available) {
+        std::memcpy(dest_.data() + used_, slice.data(), slice.size());
+        used_ += slice.size();
+        return;
+      }
+      std::memcpy(dest_.data() + used_, slice.data(), available);
+      used_ += available;
+      slice.remove_prefix(available);
+      writer_.confirm_append(used_);
+      used_ = 0;
+      dest_ = writer_.prepare_append(slice.size());
+    }
+  }
+
+  void store_storer(const Storer &storer) {
+    flush();
+    storer.store_chain(writer_);
+  }
+
+  template <class T>
+  void store_string(const T &str) {
+    size_t len = str.size();
+    unsigned char header[4];
+    size_t header_size;
+    if (len < 254) {
+      header[0] = static_cast<unsigned char>(len);
+      header_size = 1;
+      len++;
+    } else if (len < (1 << 24)) {
+      header[0] = static_cast<unsigned char>(254);
+      header[1] = static_cast<unsigned char>(len & 255);
+      header[2] = static_cast<unsigned char>((len >> 8) & 255);
+      header[3] = static_cast<unsigned char>(len >> 16);
+      header_size = 4;
+      len += 4;
+    } else {
+      LOG(FATAL) << "String size " << len << " is too big to be stored";
+      return;
+    }
+    store_slice(Slice(header, header_size));
+    store_slice(Slice(str.data(), str.size()));
+
+    static const char zeros[4] = {0, 0, 0, 0};
+    store_slice(Slice(zeros, (4 - (len & 3)) & 3));
+  }
+};
+
 class TlStorerCalcLength {
   size_t length = 0;
 
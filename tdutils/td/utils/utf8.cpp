@@ -6,15 +6,37 @@
 //
 #include "td/utils/utf8.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/logging.h"  // for UNREACHABLE
 #include "td/utils/unicode.h"
 
+#include <cstring>
+
 namespace td {
 
+namespace {
+
+// all bytes of a word with their most significant bit set
+constexpr uint64 HIGH_BITS = 0x8080808080808080;
+
+uint64 load_word(const unsigned char *ptr) {
+  uint64 word;
+  std::memcpy(&word, ptr, sizeof(word));
+  return word;
+}
+
+}  // namespace
+
 bool check_utf8(CSlice str) {
   const char *data = str.data();
   const char *data_end = data + str.size();
   do {
+    // fast path: skip whole words of ASCII at once
+    while (data_end - data >= 8 &&
+           (load_word(reinterpret_cast<const unsigned char *>(data)) & HIGH_BITS) == 0) {
+      data += 8;
+    }
+
     unsigned int a = static_cast<unsigned char>(*data++);
     if ((a & 0x80) == 0) {
       if (data == data_end + 1) {
@@ -61,6 +83,44 @@ bool check_utf8(CSlice str) {
   return false;
 }
 
+size_t utf8_length(Slice str) {
+  // a continuation byte has the form 10xxxxxx, i.e. its most significant bit is set
+  // and the next one is clear; every other byte starts a character
+  size_t result = str.size();
+  auto ptr = str.ubegin();
+  auto end = str.uend();
+  while (end - ptr >= 8) {
+    auto word = load_word(ptr);
+    result -= count_bits64(word & ~(word << 1) & HIGH_BITS);
+    ptr += 8;
+  }
+  while (ptr != end) {
+    result -= !is_utf8_character_first_code_unit(*ptr++);
+  }
+  return result;
+}
+
+size_t utf8_utf16_length(Slice str) {
+  // every character is one UTF-16 code unit, except characters from supplementary
+  // planes, which are encoded in four bytes beginning with 0b11110xxx and become
+  // surrogate pairs
+  size_t result = str.size();
+  auto ptr = str.ubegin();
+  auto end = str.uend();
+  while (end - ptr >= 8) {
+    auto word = load_word(ptr);
+    result -= count_bits64(word & ~(word << 1) & HIGH_BITS);
+    result += count_bits64(word & (word << 1) & (word << 2) & (word << 3) & HIGH_BITS);
+    ptr += 8;
+  }
+  while (ptr != end) {
+    auto c = *ptr++;
+    result -= !is_utf8_character_first_code_unit(c);
+    result += c >= 0xf0;
+  }
+  return result;
+}
+
 void append_utf8_character(string &str, uint32 ch) {
   if (ch <= 0x7f) {
     str.push_back(static_cast<char>(ch));
@@ -111,9 +171,30 @@ const unsigned char *next_utf8_unsafe(const unsigned char *ptr, uint32 *code, co
 
 string utf8_to_lower(Slice str) {
   string result;
+  result.reserve(str.size());
   auto pos = str.ubegin();
   auto end = str.uend();
   while (pos != end) {
+    // fast path: lowercase whole words of ASCII without decoding them.
+    // A byte b < 0x80 is an uppercase letter iff b + 0x3f overflows into the
+    // high bit while b + 0x25 does not, i.e. 'A' <= b <= 'Z'; such bytes are
+    // lowercased by setting their 0x20 bit
+    while (end - pos >= 8) {
+      auto word = load_word(pos);
+      if ((word & HIGH_BITS) != 0) {
+        break;
+      }
+      auto is_upper = (word + 0x3f3f3f3f3f3f3f3f) & ~(word + 0x2525252525252525) & HIGH_BITS;
+      word |= is_upper >> 2;
+      char buf[8];
+      std::memcpy(buf, &word, sizeof(word));
+      result.append(buf, sizeof(buf));
+      pos += 8;
+    }
+    if (pos == end) {
+      break;
+    }
+
     uint32 code;
     pos = next_utf8_unsafe(pos, &code, "utf8_to_lower");
     append_utf8_character(result, unicode_to_lower(code));
@@ -20,13 +20,10 @@ inline bool is_utf8_character_first_code_unit(unsigned char c) {
 }
 
 /// returns length of UTF-8 string in characters
-inline size_t utf8_length(Slice str) {
-  size_t result = 0;
-  for (auto c : str) {
-    result += is_utf8_character_first_code_unit(c);
-  }
-  return result;
-}
+size_t utf8_length(Slice str);
+
+/// returns length of UTF-8 string in UTF-16 code units
+size_t utf8_utf16_length(Slice str);
 
 /// appends a Unicode character using UTF-8 encoding
 void append_utf8_character(string &str, uint32 ch);
@@ -0,0 +1,82 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/tests.h"
+
+#include "td/utils/common.h"
+#include "td/utils/DecTree.h"
+#include "td/utils/Random.h"
+
+#include <set>
+#include <utility>
+
+using namespace td;
+
+TEST(DecTree, order_statistics) {
+  Random::Xorshift128plus rnd(123);
+
+  DecTree<int, int> tree;
+  std::set<int> reference;
+  for (int i = 0; i < 10000; i++) {
+    int key = static_cast<int>(rnd() % 30000);
+    if (rnd() % 3 == 0) {
+      tree.remove(key);
+      reference.erase(key);
+    } else {
+      if (reference.count(key) == 0) {
+        tree.insert(key, key * 2);
+        reference.insert(key);
+      }
+    }
+  }
+
+  ASSERT_EQ(reference.size(), tree.size());
+  size_t rank = 0;
+  for (auto key : reference) {
+    ASSERT_EQ(rank, tree.get_rank(key));
+    ASSERT_EQ(key * 2, *tree.get_by_idx(rank));
+    rank++;
+  }
+  for (int i = 0; i < 1000; i++) {
+    int from = static_cast<int>(rnd() % 30000);
+    int to = static_cast<int>(rnd() % 30000);
+    size_t expected = 0;
+    for (auto it = reference.lower_bound(from); it != reference.end() && *it < to; ++it) {
+      expected++;
+    }
+    ASSERT_EQ(expected, tree.count_in_range(from, to));
+  }
+}
+
+TEST(DecTree, build_from_sorted) {
+  Random::Xorshift128plus rnd(123);
+
+  vector<std::pair<int, int>> nodes;
+  for (int i = 0; i < 10000; i++) {
+    nodes.emplace_back(i * 3, i);
+  }
+  auto tree = DecTree<int, int>::build_from_sorted(std::move(nodes));
+
+  ASSERT_EQ(10000u, tree.size());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i, *tree.get(i * 3));
+    ASSERT_EQ(i, *tree.get_by_idx(i));
+    ASSERT_EQ(static_cast<size_t>(i), tree.get_rank(i * 3));
+  }
+
+  // the built tree must stay a valid treap under further updates
+  for (int i = 0; i < 10000; i++) {
+    int key = static_cast<int>(rnd() % 40000);
+    if (rnd() % 2 == 0) {
+      tree.remove(key);
+    } else if (!tree.exists(key)) {
+      tree.insert(key, key);
+    }
+  }
+  for (size_t i = 0; i + 1 < tree.size(); i++) {
+    ASSERT_TRUE(tree.get_by_idx(i) != nullptr);
+  }
+}
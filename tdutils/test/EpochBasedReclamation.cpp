@@ -0,0 +1,61 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/EpochBasedReclamation.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <atomic>
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(EpochBasedReclamation, stress) {
+  struct Node {
+    std::atomic<std::string *> name_{nullptr};
+    char pad[64];
+  };
+  int threads_n = 10;
+  std::vector<Node> nodes(threads_n);
+  td::EpochBasedReclamation<std::string> ebr(threads_n);
+  std::vector<td::thread> threads(threads_n);
+  int thread_id = 0;
+  for (auto &thread : threads) {
+    thread = td::thread([&, thread_id] {
+      auto holder = ebr.get_holder(thread_id, 0);
+      for (int i = 0; i < 1000000; i++) {
+        auto &node = nodes[td::Random::fast(0, threads_n - 1)];
+        auto *str = holder.protect(node.name_);
+        if (str) {
+          CHECK(*str == "one" || *str == "twotwo");
+        }
+        holder.clear();
+        if (td::Random::fast(0, 5) == 0) {
+          std::string *new_str = new std::string(td::Random::fast(0, 1) == 0 ? "one" : "twotwo");
+          if (node.name_.compare_exchange_strong(str, new_str, std::memory_order_acq_rel)) {
+            ebr.retire(thread_id, str);
+          } else {
+            delete new_str;
+          }
+        }
+      }
+    });
+    thread_id++;
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  LOG(ERROR) << "Undeleted pointers: " << ebr.to_delete_size_unsafe();
+  // every thread is unpinned now, but the epoch must advance twice past the newest retirement
+  for (int j = 0; j < 3; j++) {
+    for (int i = 0; i < threads_n; i++) {
+      ebr.retire(i);
+    }
+  }
+  CHECK(ebr.to_delete_size_unsafe() == 0);
+}
+#endif  //!TD_THREAD_UNSUPPORTED
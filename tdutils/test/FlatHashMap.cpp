@@ -0,0 +1,107 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+TEST(FlatHashMap, basic) {
+  td::FlatHashMap<td::uint64, td::uint64> map;
+  ASSERT_TRUE(map.empty());
+
+  map[1] = 2;
+  ASSERT_EQ(1u, map.size());
+  ASSERT_EQ(2ull, map[1]);
+  ASSERT_EQ(1u, map.count(1));
+  ASSERT_EQ(0u, map.count(2));
+
+  auto it = map.find(1);
+  ASSERT_TRUE(it != map.end());
+  ASSERT_EQ(2ull, it->second);
+  ASSERT_TRUE(map.find(2) == map.end());
+
+  ASSERT_EQ(1u, map.erase(1));
+  ASSERT_EQ(0u, map.erase(1));
+  ASSERT_TRUE(map.empty());
+
+  for (td::uint64 i = 1; i <= 100; i++) {
+    map.emplace(i, i * i);
+  }
+  map.remove_if([](const std::pair<td::uint64, td::uint64> &node) { return node.first % 2 == 0; });
+  ASSERT_EQ(50u, map.size());
+  for (td::uint64 i = 1; i <= 100; i++) {
+    ASSERT_EQ(i % 2, map.count(i));
+  }
+}
+
+static void check_equal(const td::FlatHashMap<td::uint64, td::uint64> &map,
+                        const std::unordered_map<td::uint64, td::uint64> &reference) {
+  std::vector<std::pair<td::uint64, td::uint64>> a;
+  for (auto &node : map) {
+    a.push_back(node);
+  }
+  std::vector<std::pair<td::uint64, td::uint64>> b(reference.begin(), reference.end());
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  ASSERT_TRUE(a == b);
+}
+
+TEST(FlatHashMap, stress) {
+  td::Random::Xorshift128plus rnd(123);
+  td::FlatHashMap<td::uint64, td::uint64> map;
+  std::unordered_map<td::uint64, td::uint64> reference;
+
+  // the default-constructed key is reserved as the empty marker, so keys are positive;
+  // a small key domain forces collisions, probe shifts and rehashes
+  auto gen_key = [&] {
+    return rnd() % 5000 + 1;
+  };
+
+  for (int step = 0; step < 2000000; step++) {
+    auto op = rnd() % 10;
+    auto key = gen_key();
+    if (op < 4) {
+      auto value = rnd();
+      map[key] = value;
+      reference[key] = value;
+    } else if (op < 6) {
+      auto result = map.emplace(key, step);
+      auto reference_result = reference.emplace(key, step);
+      ASSERT_EQ(reference_result.second, result.second);
+    } else if (op < 8) {
+      ASSERT_EQ(reference.erase(key), map.erase(key));
+    } else if (op < 9) {
+      auto it = map.find(key);
+      auto reference_it = reference.find(key);
+      ASSERT_EQ(reference_it != reference.end(), it != map.end());
+      if (it != map.end()) {
+        ASSERT_EQ(reference_it->second, it->second);
+      }
+    } else {
+      auto bit = rnd() % 2;
+      map.remove_if(
+          [&](const std::pair<td::uint64, td::uint64> &node) { return node.first % 100 == 0 && node.second % 2 == bit; });
+      for (auto it = reference.begin(); it != reference.end();) {
+        if (it->first % 100 == 0 && it->second % 2 == bit) {
+          it = reference.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    ASSERT_EQ(reference.size(), map.size());
+    if (step % 100000 == 0) {
+      check_equal(map, reference);
+    }
+  }
+  check_equal(map, reference);
+}
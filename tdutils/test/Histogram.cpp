@@ -0,0 +1,70 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/Histogram.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/tests.h"
+
+#include <limits>
+
+TEST(Histogram, bucket) {
+  ASSERT_EQ(0u, td::Histogram::get_bucket(0));
+  ASSERT_EQ(0u, td::Histogram::get_bucket(1));
+  ASSERT_EQ(1u, td::Histogram::get_bucket(2));
+  ASSERT_EQ(1u, td::Histogram::get_bucket(3));
+  ASSERT_EQ(2u, td::Histogram::get_bucket(4));
+  ASSERT_EQ(10u, td::Histogram::get_bucket(1024));
+  ASSERT_EQ(10u, td::Histogram::get_bucket(2047));
+  ASSERT_EQ(63u, td::Histogram::get_bucket(std::numeric_limits<td::uint64>::max()));
+}
+
+TEST(Histogram, quantile) {
+  td::Histogram histogram;
+  ASSERT_EQ(0ull, histogram.get_snapshot().get_quantile(0.5));
+
+  for (td::uint64 i = 0; i < 1000; i++) {
+    histogram.add(i);
+  }
+  auto snapshot = histogram.get_snapshot();
+  ASSERT_EQ(1000ull, snapshot.total_count);
+  ASSERT_EQ(511ull, snapshot.get_quantile(0.5));
+  ASSERT_EQ(1023ull, snapshot.get_quantile(0.99));
+  ASSERT_TRUE(snapshot.get_quantile(1.0) >= snapshot.get_quantile(0.5));
+
+  histogram.clear();
+  ASSERT_EQ(0ull, histogram.get_snapshot().total_count);
+}
+
+TEST(Histogram, concurrent) {
+  td::Histogram histogram;
+  std::vector<td::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.push_back(td::thread([&] {
+      for (int j = 0; j < 10000; j++) {
+        histogram.add(5);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto snapshot = histogram.get_snapshot();
+  ASSERT_EQ(40000ull, snapshot.total_count);
+  ASSERT_EQ(40000ull, snapshot.buckets[td::Histogram::get_bucket(5)]);
+}
+
+TEST(Histogram, timer) {
+  td::Histogram histogram;
+  { td::HistogramTimer timer(histogram); }
+  ASSERT_EQ(1ull, histogram.get_snapshot().total_count);
+
+  td::HistogramTimer timer(histogram);
+  td::HistogramTimer moved_timer(std::move(timer));
+  moved_timer.reset();
+  moved_timer.reset();
+  ASSERT_EQ(2ull, histogram.get_snapshot().total_count);
+}
@@ -204,4 +204,79 @@ TEST(MpmcQueue, multi_thread) {
   }
   LOG_CHECK(q.hazard_pointers_to_delele_size_unsafe() == 0) << q.hazard_pointers_to_delele_size_unsafe();
 }
+
+TEST(MpmcQueue, multi_thread_bulk) {
+  size_t n = 4;
+  size_t m = 4;
+  struct Data {
+    size_t from{0};
+    size_t value{0};
+  };
+  struct ThreadData {
+    std::vector<Data> v;
+    char pad[64];
+  };
+  td::MpmcQueue<Data> q(1024, n + m + 1);
+  std::vector<td::thread> n_threads(n);
+  std::vector<td::thread> m_threads(m);
+  std::vector<ThreadData> thread_data(m);
+  std::atomic<size_t> left{n * 100000};
+  size_t thread_id = 0;
+  for (auto &thread : m_threads) {
+    thread = td::thread([&, thread_id] {
+      std::array<Data, 97> buf;
+      while (left.load(std::memory_order_relaxed) != 0) {
+        auto got = q.pop_n(td::MutableSpan<Data>(buf.data(), buf.size()), thread_id);
+        for (size_t i = 0; i < got; i++) {
+          thread_data[thread_id].v.push_back(buf[i]);
+        }
+        if (got != 0) {
+          left.fetch_sub(got, std::memory_order_relaxed);
+        } else {
+          td::this_thread::yield();
+        }
+      }
+    });
+    thread_id++;
+  }
+  size_t qn = 100000;
+  for (auto &thread : n_threads) {
+    thread = td::thread([&, thread_id] {
+      std::array<Data, 101> buf;
+      size_t i = 0;
+      while (i < qn) {
+        size_t k = td::min(buf.size(), qn - i);
+        for (size_t j = 0; j < k; j++) {
+          buf[j].from = thread_id - m;
+          buf[j].value = i + j + 1;
+        }
+        q.push_n(td::MutableSpan<Data>(buf.data(), k), thread_id);
+        i += k;
+      }
+    });
+    thread_id++;
+  }
+  for (auto &thread : n_threads) {
+    thread.join();
+  }
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+  std::vector<Data> all;
+  for (size_t i = 0; i < m; i++) {
+    for (auto &data : thread_data[i].v) {
+      all.push_back(data);
+    }
+  }
+  LOG_CHECK(all.size() == n * qn) << all.size();
+  std::sort(all.begin(), all.end(),
+            [](const auto &a, const auto &b) { return std::tie(a.from, a.value) < std::tie(b.from, b.value); });
+  for (size_t i = 0; i < n * qn; i++) {
+    CHECK(all[i].from == i / qn);
+    CHECK(all[i].value == i % qn + 1);
+  }
+  for (size_t id = 0; id < n + m + 1; id++) {
+    q.gc(id);
+  }
+}
 #endif  //!TD_THREAD_UNSUPPORTED
@@ -13,21 +13,22 @@
 #include <atomic>
 
 #if !TD_THREAD_UNSUPPORTED
-TEST(MpmcWaiter, stress_one_one) {
+template <class WaiterT>
+static void test_waiter_stress_one_one() {
   td::Stage run;
   td::Stage check;
 
   std::vector<td::thread> threads;
   std::atomic<size_t> value{0};
   size_t write_cnt = 10;
-  td::unique_ptr<td::MpmcWaiter> waiter;
+  td::unique_ptr<WaiterT> waiter;
   size_t threads_n = 2;
   for (size_t i = 0; i < threads_n; i++) {
     threads.push_back(td::thread([&, id = static_cast<td::uint32>(i)] {
       for (td::uint64 round = 1; round < 100000; round++) {
         if (id == 0) {
           value = 0;
-          waiter = td::make_unique<td::MpmcWaiter>();
+          waiter = td::make_unique<WaiterT>();
           write_cnt = td::Random::fast(1, 10);
         }
         run.wait(round * threads_n);
@@ -57,7 +58,14 @@ TEST(MpmcWaiter, stress_one_one) {
     thread.join();
   }
 }
-TEST(MpmcWaiter, stress) {
+TEST(MpmcWaiter, stress_one_one) {
+  test_waiter_stress_one_one<td::MpmcWaiter>();
+}
+TEST(MpmcWaiter, stress_one_one_adaptive) {
+  test_waiter_stress_one_one<td::AdaptiveMpmcWaiter>();
+}
+template <class WaiterT>
+static void test_waiter_stress() {
   td::Stage run;
   td::Stage check;
 
@@ -69,7 +77,7 @@ TEST(MpmcWaiter, stress) {
   size_t end_pos;
   size_t write_cnt;
   size_t threads_n = 20;
-  td::unique_ptr<td::MpmcWaiter> waiter;
+  td::unique_ptr<WaiterT> waiter;
   for (size_t i = 0; i < threads_n; i++) {
     threads.push_back(td::thread([&, id = static_cast<td::uint32>(i)] {
       for (td::uint64 round = 1; round < 1000; round++) {
@@ -80,7 +88,7 @@ TEST(MpmcWaiter, stress) {
           end_pos = write_n * write_cnt;
           write_pos = 0;
           read_pos = 0;
-          waiter = td::make_unique<td::MpmcWaiter>();
+          waiter = td::make_unique<WaiterT>();
         }
         run.wait(round * threads_n);
         if (id <= write_n) {
@@ -114,4 +122,10 @@ TEST(MpmcWaiter, stress) {
     thread.join();
   }
 }
+TEST(MpmcWaiter, stress) {
+  test_waiter_stress<td::MpmcWaiter>();
+}
+TEST(MpmcWaiter, stress_adaptive) {
+  test_waiter_stress<td::AdaptiveMpmcWaiter>();
+}
 #endif  // !TD_THREAD_UNSUPPORTED
@@ -0,0 +1,84 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/MpmcQueue.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/ShardedObjectPool.h"
+#include "td/utils/tests.h"
+
+#include <atomic>
+
+TEST(ShardedObjectPool, simple) {
+  struct Data {
+    int value = 0;
+    Data() = default;
+    explicit Data(int value) : value(value) {
+    }
+    void clear() {
+      value = 0;
+    }
+  };
+  td::ShardedObjectPool<Data> pool;
+  auto ptr = pool.create(17);
+  auto weak = ptr.get_weak();
+  CHECK(weak.is_alive());
+  CHECK(weak->value == 17);
+  pool.release(std::move(ptr));
+  CHECK(!weak.is_alive());
+  auto other = pool.create(5);
+  CHECK(other->value == 5);
+  pool.release(std::move(other));
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(ShardedObjectPool, stress) {
+  struct Data {
+    td::uint64 value = 0;
+    Data() = default;
+    explicit Data(td::uint64 value) : value(value) {
+    }
+    void clear() {
+      value = 0;
+    }
+  };
+  using Pool = td::ShardedObjectPool<Data>;
+  Pool pool;
+  size_t consumers_n = 4;
+  td::MpmcQueue<Pool::OwnerPtr *> queue(1024, consumers_n + 1);
+  std::vector<td::thread> consumers(consumers_n);
+  size_t thread_id = 0;
+  for (auto &consumer : consumers) {
+    consumer = td::thread([&, thread_id] {
+      while (true) {
+        auto *ptr = queue.pop(thread_id);
+        if (ptr->empty()) {
+          delete ptr;
+          return;
+        }
+        CHECK((*ptr)->value != 0);
+        auto weak = ptr->get_weak();
+        pool.release(std::move(*ptr));
+        CHECK(!weak.is_alive());
+        delete ptr;
+      }
+    });
+    thread_id++;
+  }
+  for (td::uint64 i = 1; i <= 100000; i++) {
+    queue.push(new Pool::OwnerPtr(pool.create(i)), consumers_n);
+  }
+  for (size_t i = 0; i < consumers_n; i++) {
+    queue.push(new Pool::OwnerPtr(), consumers_n);
+  }
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+  for (size_t id = 0; id < consumers_n + 1; id++) {
+    queue.gc(id);
+  }
+}
+#endif  //!TD_THREAD_UNSUPPORTED
@@ -0,0 +1,78 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/tests.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/TimerWheel.h"
+
+#include <set>
+
+using namespace td;
+
+TEST(TimerWheel, random_ops) {
+  Random::Xorshift128plus rnd(123);
+
+  struct Node : public HeapNode {
+    int id;
+  };
+
+  int n = 1000;
+  std::vector<Node> nodes(n);
+  std::vector<double> keys(n, -1);
+  for (int i = 0; i < n; i++) {
+    nodes[i].id = i;
+  }
+
+  TimerWheel wheel;
+  std::multiset<std::pair<double, int>> reference;
+
+  double now = 0;
+  for (int step = 0; step < 100000; step++) {
+    int i = rnd.fast(0, n - 1);
+    int op = rnd.fast(0, 9);
+    if (op < 5) {
+      // set timeout: near future with high probability, sometimes far future
+      double key = now + (rnd.fast(0, 9) == 0 ? rnd.fast(0, 100000) * 0.01 : rnd.fast(0, 1000) * 0.001);
+      if (nodes[i].in_heap()) {
+        reference.erase(reference.find({keys[i], i}));
+        wheel.fix(key, &nodes[i]);
+      } else {
+        wheel.insert(key, &nodes[i]);
+      }
+      keys[i] = key;
+      reference.emplace(key, i);
+    } else if (op < 7) {
+      // cancel timeout
+      if (nodes[i].in_heap()) {
+        reference.erase(reference.find({keys[i], i}));
+        wheel.erase(&nodes[i]);
+      }
+    } else {
+      // advance time and pop all expired timers
+      now += rnd.fast(0, 1000) * 0.001;
+      while (true) {
+        HeapNode *heap_node = wheel.pop_expired(now);
+        if (heap_node == nullptr) {
+          break;
+        }
+        auto *node = static_cast<Node *>(heap_node);
+        ASSERT_TRUE(keys[node->id] < now);
+        reference.erase(reference.find({keys[node->id], node->id}));
+      }
+      // no expired timers may be left behind
+      if (!reference.empty()) {
+        ASSERT_TRUE(!(reference.begin()->first < now));
+        double next = wheel.next_timeout();
+        // next_timeout may be conservative, but must never be later than the real minimum
+        ASSERT_TRUE(!(reference.begin()->first < next));
+      }
+      ASSERT_EQ(reference.size(), wheel.size());
+      ASSERT_EQ(reference.empty(), wheel.empty());
+    }
+  }
+}
@@ -0,0 +1,70 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2019
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/tl/TlObject.h"
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/tests.h"
+
+#include <vector>
+
+namespace {
+
+class TestObject : public td::TlObject {
+ public:
+  explicit TestObject(td::int32 value) : value_(value) {
+  }
+  td::int32 get_id() const final {
+    return value_;
+  }
+  void store(td::TlStorerToString &s, const char *field_name) const final {
+  }
+
+ private:
+  td::int32 value_;
+};
+
+}  // namespace
+
+TEST(TlObject, recycler_reuse) {
+  auto *first = new TestObject(1);
+  auto *first_ptr = static_cast<void *>(first);
+  delete first;
+
+  // the recycler keeps freed blocks in per-size LIFO free lists
+  auto *second = new TestObject(2);
+  ASSERT_EQ(first_ptr, static_cast<void *>(second));
+  delete second;
+}
+
+TEST(TlObject, recycler_cross_thread) {
+  std::vector<TestObject *> objects;
+  for (td::int32 i = 0; i < 10000; i++) {
+    objects.push_back(new TestObject(i));
+  }
+
+  // objects may be destroyed on a thread other than the one which created them,
+  // and after a thread has already returned its own free lists to the heap
+  td::thread worker([&objects] {
+    for (auto *object : objects) {
+      delete object;
+    }
+    for (td::int32 i = 0; i < 10000; i++) {
+      delete new TestObject(i);
+    }
+  });
+  worker.join();
+}
+
+TEST(TlObject, placement_new) {
+  // the allocating operator new must not hide global placement new,
+  // which Result<T> uses to construct TL-objects in place
+  alignas(TestObject) char storage[sizeof(TestObject)];
+  auto *object = new (storage) TestObject(7);
+  ASSERT_EQ(7, object->get_id());
+  object->~TestObject();
+}
@@ -62,6 +62,48 @@ TEST(Crypto, AesCtrState) {
   }
 }
 
+TEST(Crypto, AesIge) {
+  td::vector<td::uint32> encrypt_answers{2045698207u, 2423540300u, 525522475u, 1545267325u};
+  td::vector<td::uint32> decrypt_answers{790845780u, 1912224503u, 979811493u, 1468748661u};
+
+  std::size_t i = 0;
+  for (auto length : {16, 32, 256, 1024}) {
+    td::uint32 seed = length;
+    td::string s(length, '\0');
+    for (auto &c : s) {
+      seed = seed * 123457567u + 987651241u;
+      c = static_cast<char>((seed >> 23) & 255);
+    }
+
+    td::UInt256 key;
+    for (auto &c : key.raw) {
+      seed = seed * 123457567u + 987651241u;
+      c = (seed >> 23) & 255;
+    }
+    td::UInt256 iv;
+    for (auto &c : iv.raw) {
+      seed = seed * 123457567u + 987651241u;
+      c = (seed >> 23) & 255;
+    }
+
+    td::string t(length, '\0');
+    auto iv_copy = iv;
+    td::aes_ige_encrypt(key, &iv_copy, s, t);
+    ASSERT_EQ(encrypt_answers[i], td::crc32(t));
+
+    td::string u(length, '\0');
+    iv_copy = iv;
+    td::aes_ige_decrypt(key, &iv_copy, t, u);
+    ASSERT_STREQ(s, u);
+
+    iv_copy = iv;
+    td::aes_ige_decrypt(key, &iv_copy, s, t);
+    ASSERT_EQ(decrypt_answers[i], td::crc32(t));
+
+    i++;
+  }
+}
+
 TEST(Crypto, Sha256State) {
   for (auto length : {0, 1, 31, 32, 33, 9999, 10000, 10001, 999999, 1000001}) {
     auto s = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), length);
@@ -39,6 +39,63 @@ TEST(Heap, sort_random_perm) {
   }
 };
 
+TEST(Heap, bulk_operations) {
+  int n = 100000;
+  std::vector<HeapNode> nodes(n);
+  std::vector<int> keys(n);
+  KHeap<int> kheap;
+  for (int i = 0; i < n / 2; i++) {
+    keys[i] = i * 2;
+    kheap.insert(keys[i], &nodes[i]);
+  }
+
+  // large batch, comparable with the heap size, takes the heapify path
+  std::vector<std::pair<int, HeapNode *>> batch;
+  for (int i = n / 2; i < n - 10; i++) {
+    keys[i] = (i - n / 2) * 2 + 1;
+    batch.emplace_back(keys[i], &nodes[i]);
+  }
+  kheap.insert_bulk(batch);
+  kheap.check();
+
+  // small batch takes the per-element path
+  batch.clear();
+  for (int i = n - 10; i < n; i++) {
+    keys[i] = i;
+    batch.emplace_back(keys[i], &nodes[i]);
+  }
+  kheap.insert_bulk(batch);
+  kheap.check();
+  ASSERT_EQ(static_cast<size_t>(n), kheap.size());
+
+  // bulk erase of every second node rebuilds the heap; a tiny batch erases one by one
+  std::vector<HeapNode *> to_erase;
+  std::multiset<int> expected;
+  for (int i = 0; i < n; i++) {
+    if (i % 2 == 0 && i >= 6) {
+      to_erase.push_back(&nodes[i]);
+    } else {
+      expected.insert(keys[i]);
+    }
+  }
+  kheap.erase_bulk(to_erase);
+  kheap.check();
+  to_erase.clear();
+  for (int i = 0; i < 6; i += 2) {
+    to_erase.push_back(&nodes[i]);
+    expected.erase(expected.find(keys[i]));
+  }
+  kheap.erase_bulk(to_erase);
+  kheap.check();
+
+  ASSERT_EQ(expected.size(), kheap.size());
+  for (auto expected_key : expected) {
+    ASSERT_EQ(expected_key, kheap.top_key());
+    kheap.pop();
+  }
+  ASSERT_TRUE(kheap.empty());
+}
+
 class CheckedHeap {
  public:
   void set_max_size(int max_size) {
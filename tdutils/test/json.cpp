@@ -93,3 +93,68 @@ TEST(JSON, kphp) {
       "{\"keyboard\":[[\"\\u2022 abcdefg\"],[\"\\u2022 hijklmnop\"],[\"\\u2022 "
       "qrstuvwxyz\"]],\"one_time_keyboard\":true}");
 }
+
+class EventLogCallback : public JsonCallback {
+ public:
+  Status on_null() override {
+    events_ += "null;";
+    return Status::OK();
+  }
+  Status on_boolean(bool value) override {
+    events_ += value ? "true;" : "false;";
+    return Status::OK();
+  }
+  Status on_number(MutableSlice number) override {
+    events_ += "num(" + number.str() + ");";
+    return Status::OK();
+  }
+  Status on_string(MutableSlice str) override {
+    events_ += "str(" + str.str() + ");";
+    return Status::OK();
+  }
+  Status on_begin_array() override {
+    events_ += "[;";
+    return Status::OK();
+  }
+  Status on_end_array() override {
+    events_ += "];";
+    return Status::OK();
+  }
+  Status on_begin_object() override {
+    events_ += "{;";
+    return Status::OK();
+  }
+  Status on_object_key(MutableSlice key) override {
+    events_ += "key(" + key.str() + ");";
+    return Status::OK();
+  }
+  Status on_end_object() override {
+    events_ += "};";
+    return Status::OK();
+  }
+
+  string events_;
+};
+
+static void check_parse_events(string str, Slice expected_events) {
+  EventLogCallback callback;
+  auto status = json_parse(str, callback);
+  ASSERT_TRUE(status.is_ok());
+  ASSERT_EQ(expected_events, callback.events_);
+}
+
+TEST(JSON, parse_events) {
+  check_parse_events("[]", "[;];");
+  check_parse_events("{}", "{;};");
+  check_parse_events("null", "null;");
+  check_parse_events("-12.5e3", "num(-12.5e3);");
+  check_parse_events("\"a\\nb\\u2022\"", "str(a\nb\xe2\x80\xa2);");
+  check_parse_events(" { \"key\" : [ 1 , true , { } ] , \"o\" : null } ",
+                     "{;key(key);[;num(1);true;{;};];key(o);null;};");
+
+  EventLogCallback callback;
+  string bad = "[1,";
+  ASSERT_TRUE(json_parse(bad, callback).is_error());
+  string trailing = "null null";
+  ASSERT_TRUE(json_parse(trailing, callback).is_error());
+}
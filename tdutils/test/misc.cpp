@@ -428,6 +428,34 @@ TEST(Misc, unicode) {
   test_unicode(remove_diacritics);
 }
 
+TEST(Misc, utf8_length) {
+  string str;
+  for (uint32 i = 0; i <= 0x10ffff; i = i * 2 + 1) {
+    if (0xd800 <= i && i <= 0xdfff) {
+      continue;
+    }
+    append_utf8_character(str, i);
+  }
+  str += str + str;
+  // check all prefix lengths, so both the word-at-a-time and the tail paths are exercised
+  for (size_t char_length = 0; char_length <= utf8_length(str); char_length++) {
+    auto prefix = utf8_truncate(Slice(str), char_length).str();
+    size_t length = 0;
+    size_t utf16_length = 0;
+    for (auto c : prefix) {
+      auto uc = static_cast<unsigned char>(c);
+      if (is_utf8_character_first_code_unit(uc)) {
+        length++;
+        utf16_length += 1 + (uc >= 0xf0);
+      }
+    }
+    ASSERT_EQ(char_length, length);
+    ASSERT_EQ(length, utf8_length(prefix));
+    ASSERT_EQ(utf16_length, utf8_utf16_length(prefix));
+    ASSERT_TRUE(check_utf8(prefix));
+  }
+}
+
 TEST(BigNum, from_decimal) {
   ASSERT_TRUE(BigNum::from_decimal("").is_error());
   ASSERT_TRUE(BigNum::from_decimal("a").is_error());
@@ -241,6 +241,14 @@ class messages_dhConfig final {
     TlStoreBinary::store(version_, s);
     TlStoreString::store(random_, s);
   }
+
+  void store(TlStorerToChainBuffer &s) const {
+    (void)sizeof(s);
+    TlStoreBinary::store(g_, s);
+    TlStoreString::store(p_, s);
+    TlStoreBinary::store(version_, s);
+    TlStoreString::store(random_, s);
+  }
 };
 
 class encryptedChat final {
@@ -292,6 +300,17 @@ class encryptedChat final {
     TlStoreString::store(g_a_or_b_, s);
     TlStoreBinary::store(key_fingerprint_, s);
   }
+
+  void store(TlStorerToChainBuffer &s) const {
+    (void)sizeof(s);
+    TlStoreBinary::store(id_, s);
+    TlStoreBinary::store(access_hash_, s);
+    TlStoreBinary::store(date_, s);
+    TlStoreBinary::store(admin_id_, s);
+    TlStoreBinary::store(participant_id_, s);
+    TlStoreString::store(g_a_or_b_, s);
+    TlStoreBinary::store(key_fingerprint_, s);
+  }
 };
 
 class messages_sentEncryptedMessage final {
@@ -317,6 +336,11 @@ class messages_sentEncryptedMessage final {
     (void)sizeof(s);
     TlStoreBinary::store(date_, s);
   }
+
+  void store(TlStorerToChainBuffer &s) const {
+    (void)sizeof(s);
+    TlStoreBinary::store(date_, s);
+  }
 };
 
 }  // namespace my_api